@@ -26,6 +26,7 @@
 #    include "win32-socket.h"
 typedef int gid_t;
 typedef int uid_t;
+#    define ftruncate(fd,length) _chsize(fd, (long)(length))
 #  else // !_WIN32
 #    include <time.h>
 #    include <sys/time.h>
@@ -33,6 +34,7 @@ typedef int uid_t;
 #    include <poll.h>
 #    include <pthread.h>
 #    include <sys/fcntl.h>
+#    include <sys/uio.h>
 #    include <sys/wait.h>
 
 extern char **environ;
@@ -44,6 +46,8 @@ extern char **environ;
 // Macros...
 //
 
+#  define _PAPPL_MAX_ATTR_NAMES	1024	// Maximum number of interned attribute names
+
 #  ifdef DEBUG
 #    define _PAPPL_DEBUG(...) fprintf(stderr, __VA_ARGS__)
 #  else
@@ -53,6 +57,22 @@ extern char **environ;
 #  define _PAPPL_LOOKUP_STRING(bit,strings) _papplLookupString(bit, sizeof(strings) / sizeof(strings[0]), strings)
 #  define _PAPPL_LOOKUP_VALUE(keyword,strings) _papplLookupValue(keyword, sizeof(strings) / sizeof(strings[0]), strings)
 
+#  if _WIN32
+#    define _PAPPL_ATOMIC_ADD(p,v) InterlockedExchangeAdd((volatile LONG *)(p), (LONG)(v))
+#    define _PAPPL_ATOMIC_CAS(p,o,n) (InterlockedCompareExchange((volatile LONG *)(p), (LONG)(n), (LONG)(o)) == (LONG)(o))
+#    define _PAPPL_ATOMIC_GET(p) InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#    define _PAPPL_ATOMIC_GETPTR(p) InterlockedCompareExchangePointer((PVOID volatile *)(p), NULL, NULL)
+#    define _PAPPL_ATOMIC_SET(p,v) InterlockedExchange((volatile LONG *)(p), (LONG)(v))
+#    define _PAPPL_ATOMIC_SETPTR(p,v) InterlockedExchangePointer((PVOID volatile *)(p), (PVOID)(v))
+#  else
+#    define _PAPPL_ATOMIC_ADD(p,v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+#    define _PAPPL_ATOMIC_CAS(p,o,n) __sync_bool_compare_and_swap(p, o, n)
+#    define _PAPPL_ATOMIC_GET(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#    define _PAPPL_ATOMIC_GETPTR(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#    define _PAPPL_ATOMIC_SET(p,v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#    define _PAPPL_ATOMIC_SETPTR(p,v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+#  endif // _WIN32
+
 #  ifndef HAVE_STRLCPY
 #    define strlcpy(dst,src,dstsize) _pappl_strlcpy(dst,src,dstsize)
 #  endif // !HAVE_STRLCPY
@@ -62,9 +82,19 @@ extern char **environ;
 // Types and structures...
 //
 
+typedef struct _pappl_raset_s		// Compiled "requested-attributes" set
+{
+  char			*key;			// Cache key
+  bool			cached;			// Shared by the set cache?
+  bool			overflow;		// Some names not interned?
+  cups_array_t		*ra;			// Requested attribute names
+  unsigned char		bits[_PAPPL_MAX_ATTR_NAMES / 8];
+						// Bitset of interned names
+} _pappl_raset_t;
+
 typedef struct _pappl_ipp_filter_s	// Attribute filter
 {
-  cups_array_t		*ra;			// Requested attributes
+  _pappl_raset_t	*ra;			// Requested attributes
   ipp_tag_t		group_tag;		// Group to copy
 } _pappl_ipp_filter_t;
 
@@ -85,11 +115,15 @@ extern size_t		_pappl_strlcpy(char *dst, const char *src, size_t dstsize) _PAPPL
 #  endif // !HAVE_STRLCPY
 extern ipp_t		*_papplContactExport(pappl_contact_t *contact) _PAPPL_PRIVATE;
 extern void		_papplContactImport(ipp_t *col, pappl_contact_t *contact) _PAPPL_PRIVATE;
-extern void		_papplCopyAttributes(ipp_t *to, ipp_t *from, cups_array_t *ra, ipp_tag_t group_tag, int quickcopy) _PAPPL_PRIVATE;
+extern void		_papplCopyAttributes(ipp_t *to, ipp_t *from, _pappl_raset_t *ra, ipp_tag_t group_tag, int quickcopy) _PAPPL_PRIVATE;
 extern unsigned		_papplGetRand(void) _PAPPL_PRIVATE;
 extern const char	*_papplGetTempDir(void) _PAPPL_PRIVATE;
 extern const char	*_papplLookupString(unsigned bit, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
 extern unsigned		_papplLookupValue(const char *keyword, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
+extern bool		_papplRASetContains(_pappl_raset_t *ra, const char *name) _PAPPL_PRIVATE;
+extern _pappl_raset_t	*_papplRASetCreate(ipp_t *request) _PAPPL_PRIVATE;
+extern _pappl_raset_t	*_papplRASetCreateNames(int num_names, const char * const *names) _PAPPL_PRIVATE;
+extern void		_papplRASetDelete(_pappl_raset_t *ra) _PAPPL_PRIVATE;
 
 
 #endif // !_PAPPL_BASE_PRIVATE_H_
@@ -99,6 +99,7 @@ typedef unsigned char pappl_dither_t[16][16];
 typedef struct pappl_pr_driver_data_s pappl_pr_driver_data_t;
 					// Print driver data
 typedef struct _pappl_job_s pappl_job_t;// Job object
+typedef struct _pappl_loc_s pappl_loc_t;// Localization catalog
 typedef struct pappl_pr_options_s pappl_pr_options_t;
 					// Combined print job options
 typedef unsigned int pappl_preason_t;	// Bitfield for IPP "printer-state-reasons" values
@@ -1,7 +1,7 @@
 //
 // Authentication support for the Printer Application Framework
 //
-// Copyright © 2017-2020 by Michael R Sweet.
+// Copyright © 2017-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -29,6 +29,23 @@
 // Types...
 //
 
+typedef struct _pappl_authcache_s	// Authentication cache entry
+{
+  char		username[256];		// Username
+  unsigned char	salt[16],		// Random salt for password hash
+		hash[32];		// SHA-256 hash of salt + password
+  time_t	expires;		// Expiration time
+#if !_WIN32
+  gid_t		gid;			// Primary group ID
+  int		num_groups;		// Number of groups
+#  ifdef __APPLE__
+  int		groups[32];		// Groups from getgrouplist()
+#  else
+  gid_t		groups[32];		// Groups from getgrouplist()
+#  endif // __APPLE__
+#endif // !_WIN32
+} _pappl_authcache_t;
+
 typedef struct _pappl_authdata_s	// PAM authentication data
 {
   const char	*username,			// Username string
@@ -36,11 +53,22 @@ typedef struct _pappl_authdata_s	// PAM authentication data
 } _pappl_authdata_t;
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_AUTH_CACHE_MAX	64	// Maximum number of cached users
+
+
 //
 // Local functions...
 //
 
 static int	pappl_authenticate_user(pappl_client_t *client, const char *username, const char *password);
+static void	pappl_cache_add(pappl_client_t *client, const char *username, const char *password, _pappl_authcache_t *entry);
+static bool	pappl_cache_find(pappl_client_t *client, const char *username, const char *password, _pappl_authcache_t *entry);
+static int	pappl_compare_cache(_pappl_authcache_t *a, _pappl_authcache_t *b);
+static void	pappl_hash_password(const unsigned char *salt, const char *password, unsigned char *hash);
 #ifdef HAVE_LIBPAM
 static int	pappl_pam_func(int num_msg, const struct pam_message **msg, struct pam_response **resp, _pappl_authdata_t *data);
 #endif // HAVE_LIBPAM
@@ -94,14 +122,9 @@ papplClientIsAuthorized(
 		*password;		// Password value
       int	userlen = sizeof(username);
 					// Length of username:password
+      _pappl_authcache_t entry;		// Cached credentials and groups
 #if !_WIN32
       struct passwd *user;		// User information
-      int	num_groups;		// Number of autbenticated groups, if any
-#  ifdef __APPLE__
-      int	groups[32];		// Authenticated groups, if any
-#  else
-      gid_t	groups[32];		// Authenticated groups, if any
-#  endif // __APPLE__
 #endif // !_WIN32
 
       for (authorization += 6; *authorization && isspace(*authorization & 255); authorization ++)
@@ -112,67 +135,70 @@ papplClientIsAuthorized(
       {
 	*password++ = '\0';
 
-        // Authenticate the username and password...
-	if (pappl_authenticate_user(client, username, password))
+        // Use cached credentials or authenticate the username and password...
+        if (pappl_cache_find(client, username, password, &entry))
+        {
+          papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Using cached credentials for '%s'.", username);
+        }
+	else if (pappl_authenticate_user(client, username, password))
 	{
-#if _WIN32
-          // TODO: Implement group support on Windows
-          return (HTTP_STATUS_CONTINUE);
+	  memset(&entry, 0, sizeof(entry));
 
-#else
+#if !_WIN32
 	  // Get the user information (groups, etc.)
-	  if ((user = getpwnam(username)) != NULL)
+	  if ((user = getpwnam(username)) == NULL)
 	  {
-	    papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Authenticated as \"%s\" using Basic.", username);
-	    strlcpy(client->username, username, sizeof(client->username));
+	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup user '%s'.", username);
+	    return (HTTP_STATUS_SERVER_ERROR);
+	  }
 
-	    num_groups = (int)(sizeof(groups) / sizeof(groups[0]));
+	  entry.gid        = user->pw_gid;
+	  entry.num_groups = (int)(sizeof(entry.groups) / sizeof(entry.groups[0]));
 
 #  ifdef __APPLE__
-	    if (getgrouplist(username, (int)user->pw_gid, groups, &num_groups))
+	  if (getgrouplist(username, (int)user->pw_gid, entry.groups, &entry.num_groups))
 #  else
-	    if (getgrouplist(username, user->pw_gid, groups, &num_groups))
+	  if (getgrouplist(username, user->pw_gid, entry.groups, &entry.num_groups))
 #  endif // __APPLE__
-	    {
-	      papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup groups for user '%s': %s", username, strerror(errno));
-	      num_groups = 0;
-	    }
-
-            // Check group membership...
-            if (client->system->admin_gid != (gid_t)-1)
-            {
-              if (user->pw_gid != client->system->admin_gid)
-              {
-                int i;			// Looping var
-
-                for (i = 0; i < num_groups; i ++)
-		{
-		  if ((gid_t)groups[i] == client->system->admin_gid)
-		    break;
-		}
-
-                if (i >= num_groups)
-                {
-                  // Not in the admin group, access is forbidden...
-                  return (HTTP_STATUS_FORBIDDEN);
-		}
-              }
-            }
-
-            // If we get this far, authentication and authorization are good...
-            return (HTTP_STATUS_CONTINUE);
-	  }
-	  else
 	  {
-	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup user '%s'.", username);
-	    return (HTTP_STATUS_SERVER_ERROR);
+	    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to lookup groups for user '%s': %s", username, strerror(errno));
+	    entry.num_groups = 0;
 	  }
-#endif // _WIN32
+#endif // !_WIN32
+
+          pappl_cache_add(client, username, password, &entry);
 	}
 	else
 	{
 	  papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Basic authentication of '%s' failed.", username);
+	  return (HTTP_STATUS_UNAUTHORIZED);
 	}
+
+	papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Authenticated as \"%s\" using Basic.", username);
+	strlcpy(client->username, username, sizeof(client->username));
+
+#if !_WIN32 // TODO: Implement group support on Windows
+	// Check group membership...
+	if (client->system->admin_gid != (gid_t)-1 && entry.gid != client->system->admin_gid)
+	{
+	  int i;			// Looping var
+
+	  for (i = 0; i < entry.num_groups; i ++)
+	  {
+	    if ((gid_t)entry.groups[i] == client->system->admin_gid)
+	      break;
+	  }
+
+	  if (i >= entry.num_groups)
+	  {
+	    // Not in the admin group, access is forbidden...
+	    return (HTTP_STATUS_FORBIDDEN);
+	  }
+	}
+#endif // !_WIN32
+
+	// If we get this far, authentication and authorization are good...
+	return (HTTP_STATUS_CONTINUE);
       }
       else
       {
@@ -192,6 +218,24 @@ papplClientIsAuthorized(
 }
 
 
+//
+// '_papplSystemClearAuthCache()' - Clear cached credentials and groups.
+//
+// This function is called when the authentication cache lifetime or the
+// administrative group changes, and when the system is deleted.
+//
+
+void
+_papplSystemClearAuthCache(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->auth_mutex);
+  cupsArrayDelete(system->auth_cache);
+  system->auth_cache = NULL;
+  pthread_mutex_unlock(&system->auth_mutex);
+}
+
+
 //
 // 'pappl_authenticate_user()' - Validate a username + password combination.
 //
@@ -260,6 +304,170 @@ pappl_authenticate_user(
 }
 
 
+//
+// 'pappl_cache_add()' - Add or update cached credentials for a user.
+//
+// Only a salted SHA-256 hash of the password is kept.  Expired entries are
+// purged first, and the cache is limited to @code _PAPPL_AUTH_CACHE_MAX@
+// users.
+//
+
+static void
+pappl_cache_add(
+    pappl_client_t     *client,		// I - Client
+    const char         *username,	// I - Username
+    const char         *password,	// I - Password
+    _pappl_authcache_t *entry)		// I - Groups for user
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_authcache_t	*current,	// Current entry
+			key;		// Search key
+  time_t		curtime = time(NULL);
+					// Current time
+  int			i;		// Looping var
+
+
+  if (strlen(username) >= sizeof(entry->username))
+    return;
+
+  pthread_mutex_lock(&system->auth_mutex);
+
+  if (system->auth_cache_time > 0)
+  {
+    if (!system->auth_cache)
+      system->auth_cache = cupsArrayNew3((cups_array_func_t)pappl_compare_cache, NULL, NULL, 0, NULL, (cups_afree_func_t)free);
+
+    strlcpy(key.username, username, sizeof(key.username));
+
+    if ((current = (_pappl_authcache_t *)cupsArrayFind(system->auth_cache, &key)) != NULL)
+    {
+      cupsArrayRemove(system->auth_cache, current);
+    }
+    else
+    {
+      // Purge expired entries, then the first one if the cache is still full...
+      for (current = (_pappl_authcache_t *)cupsArrayFirst(system->auth_cache); current; current = (_pappl_authcache_t *)cupsArrayNext(system->auth_cache))
+      {
+        if (current->expires <= curtime)
+          cupsArrayRemove(system->auth_cache, current);
+      }
+
+      if (cupsArrayCount(system->auth_cache) >= _PAPPL_AUTH_CACHE_MAX)
+        cupsArrayRemove(system->auth_cache, cupsArrayFirst(system->auth_cache));
+    }
+
+    if ((current = (_pappl_authcache_t *)malloc(sizeof(_pappl_authcache_t))) != NULL)
+    {
+      memcpy(current, entry, sizeof(_pappl_authcache_t));
+      strlcpy(current->username, username, sizeof(current->username));
+
+      for (i = 0; i < (int)sizeof(current->salt); i += 4)
+      {
+        unsigned r = _papplGetRand();	// Random bits
+
+        memcpy(current->salt + i, &r, 4);
+      }
+
+      pappl_hash_password(current->salt, password, current->hash);
+      current->expires = curtime + system->auth_cache_time;
+
+      cupsArrayAdd(system->auth_cache, current);
+    }
+  }
+
+  pthread_mutex_unlock(&system->auth_mutex);
+}
+
+
+//
+// 'pappl_cache_find()' - Find unexpired cached credentials for a user.
+//
+
+static bool				// O - `true` if found and the password matches, `false` otherwise
+pappl_cache_find(
+    pappl_client_t     *client,		// I - Client
+    const char         *username,	// I - Username
+    const char         *password,	// I - Password
+    _pappl_authcache_t *entry)		// O - Cached credentials and groups
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_authcache_t	*current,	// Current entry
+			key;		// Search key
+  unsigned char		hash[32],	// Hash of supplied password
+			diff = 0;	// Differences in hash
+  size_t		i;		// Looping var
+  bool			ret = false;	// Return value
+
+
+  if (strlen(username) >= sizeof(key.username))
+    return (false);
+
+  strlcpy(key.username, username, sizeof(key.username));
+
+  pthread_mutex_lock(&system->auth_mutex);
+
+  if ((current = (_pappl_authcache_t *)cupsArrayFind(system->auth_cache, &key)) != NULL && current->expires > time(NULL))
+  {
+    pappl_hash_password(current->salt, password, hash);
+
+    // Compare every byte so the time taken does not depend on the password...
+    for (i = 0; i < sizeof(hash); i ++)
+      diff |= hash[i] ^ current->hash[i];
+
+    if (!diff)
+    {
+      memcpy(entry, current, sizeof(_pappl_authcache_t));
+      ret = true;
+    }
+  }
+
+  pthread_mutex_unlock(&system->auth_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'pappl_compare_cache()' - Compare two authentication cache entries.
+//
+
+static int				// O - Result of comparison
+pappl_compare_cache(
+    _pappl_authcache_t *a,		// I - First entry
+    _pappl_authcache_t *b)		// I - Second entry
+{
+  return (strcmp(a->username, b->username));
+}
+
+
+//
+// 'pappl_hash_password()' - Compute the SHA-256 hash of a salt and password.
+//
+
+static void
+pappl_hash_password(
+    const unsigned char *salt,		// I - 16-byte salt
+    const char          *password,	// I - Password
+    unsigned char       *hash)		// O - 32-byte hash
+{
+  unsigned char	data[1024];		// Salt + password
+  size_t	datalen;		// Length of data
+
+
+  if ((datalen = strlen(password)) > (sizeof(data) - 16))
+    datalen = sizeof(data) - 16;
+
+  memcpy(data, salt, 16);
+  memcpy(data + 16, password, datalen);
+
+  cupsHashData("sha2-256", data, datalen + 16, hash, 32);
+
+  memset(data, 0, sizeof(data));
+}
+
+
 #ifdef HAVE_LIBPAM
 //
 // 'pappl_pam_func()' - PAM conversation function.
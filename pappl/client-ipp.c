@@ -70,8 +70,13 @@ _papplClientProcessIPP(
   const char		*name;		// Name of attribute
   bool			printer_op = true;
 					// Printer operation?
+  struct timeval	starttime,	// Start time
+			endtime;	// End time
+  bool			ret;		// Return value
 
 
+  gettimeofday(&starttime, NULL);
+
   // First build an empty response message for this request...
   client->operation_id = ippGetOperation(client->request);
   client->response     = ippNewResponse(client->request);
@@ -242,7 +247,13 @@ _papplClientProcessIPP(
   if (httpGetState(client->http) != HTTP_STATE_POST_SEND)
     _papplClientFlushDocumentData(client);	// Flush trailing (junk) data
 
-  return (papplClientRespond(client, HTTP_STATUS_OK, NULL, "application/ipp", 0, ippLength(client->response)));
+  ret = papplClientRespond(client, HTTP_STATUS_OK, NULL, "application/ipp", 0, ippLength(client->response));
+
+  // Record the time it took to process the request...
+  gettimeofday(&endtime, NULL);
+  _papplSystemAddIPPMetrics(client->system, op, (size_t)(1000000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec)));
+
+  return (ret);
 }
 
 
@@ -0,0 +1,708 @@
+//
+// Client event loop for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#if defined(__linux__)
+#  include <sys/epoll.h>
+#  define _PAPPL_CLOOP_EPOLL	1	// Use epoll(7)
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#  include <sys/event.h>
+#  define _PAPPL_CLOOP_KQUEUE	1	// Use kqueue(2)
+#endif // __linux__
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_CLOOP_MAX_EVENTS	64	// Maximum number of events per wakeup
+#define _PAPPL_CLOOP_MAX_WORKERS 16	// Maximum number of worker threads
+#define _PAPPL_CLOOP_MAX_WAITING 64	// Maximum number of requests waiting for events
+#define _PAPPL_CLOOP_TIMEOUT	30	// Keep-alive timeout in seconds
+
+
+//
+// Types...
+//
+
+struct _pappl_cloop_s			// Client event loop
+{
+  pappl_system_t	*system;		// Containing system
+  pthread_mutex_t	mutex;			// Mutex for loop data
+  pthread_cond_t	cond;			// Condition for worker threads
+  bool			is_running;		// Is the event loop running?
+  pthread_t		thread_id;		// Event loop thread
+  int			fd;			// epoll/kqueue descriptor
+  int			wakefds[2];		// Wakeup pipe for poll()
+  cups_array_t		*idle,			// Idle (keep-alive) clients
+			*ready;			// Clients with a pending request
+  int			num_workers,		// Number of worker threads
+			idle_workers,		// Number of waiting worker threads
+			num_waiting;		// Number of workers waiting for events
+};
+
+
+//
+// Local functions...
+//
+
+static void	cloop_ready(_pappl_cloop_t *loop, pappl_client_t *client);
+static void	*cloop_run(_pappl_cloop_t *loop);
+static void	cloop_start_worker(_pappl_cloop_t *loop);
+static void	cloop_unwatch(_pappl_cloop_t *loop, pappl_client_t *client);
+static bool	cloop_watch(_pappl_cloop_t *loop, pappl_client_t *client);
+static void	*cloop_worker(_pappl_cloop_t *loop);
+
+
+//
+// '_papplClientLoopAdd()' - Add an idle client connection to the event loop.
+//
+// The client is watched until a new request arrives or the keep-alive timeout
+// expires.  If the event loop is not running, the client is deleted.
+//
+
+void
+_papplClientLoopAdd(
+    pappl_client_t *client)		// I - Client
+{
+  _pappl_cloop_t	*loop = client->system->client_loop;
+					// Event loop
+
+
+  pthread_mutex_lock(&loop->mutex);
+
+  if (!loop->is_running)
+  {
+    pthread_mutex_unlock(&loop->mutex);
+    _papplClientDelete(client);
+    return;
+  }
+
+  client->idle_time = time(NULL);
+
+  cupsArrayAdd(loop->idle, client);
+
+  if (!cloop_watch(loop, client))
+  {
+    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to watch connection: %s", strerror(errno));
+    cupsArrayRemove(loop->idle, client);
+    pthread_mutex_unlock(&loop->mutex);
+    _papplClientDelete(client);
+    return;
+  }
+
+  pthread_mutex_unlock(&loop->mutex);
+}
+
+
+//
+// '_papplClientLoopBeginWait()' - Start waiting for events in a request.
+//
+// Requests that wait a long time for events, such as event streams and
+// Get-Notifications with "notify-wait", call this function so that their worker
+// does not count against the worker thread limit.  If too many requests are
+// already waiting, `false` is returned and the request should not wait.
+//
+
+bool					// O - `true` if the request can wait, `false` otherwise
+_papplClientLoopBeginWait(
+    pappl_client_t *client)		// I - Client
+{
+  _pappl_cloop_t	*loop = client->system->client_loop;
+					// Event loop
+  bool			ret = true;	// Return value
+
+
+  if (!loop)
+    return (true);			// One thread per client, always OK to wait
+
+  pthread_mutex_lock(&loop->mutex);
+
+  if (loop->num_waiting >= _PAPPL_CLOOP_MAX_WAITING)
+  {
+    ret = false;
+  }
+  else
+  {
+    loop->num_waiting ++;
+
+    // Start another worker for any clients that are waiting for one...
+    if (cupsArrayCount(loop->ready) > 0 && loop->idle_workers == 0)
+      cloop_start_worker(loop);
+  }
+
+  pthread_mutex_unlock(&loop->mutex);
+
+  return (ret);
+}
+
+
+//
+// '_papplClientLoopEndWait()' - Stop waiting for events in a request.
+//
+
+void
+_papplClientLoopEndWait(
+    pappl_client_t *client)		// I - Client
+{
+  _pappl_cloop_t	*loop = client->system->client_loop;
+					// Event loop
+
+
+  if (!loop)
+    return;
+
+  pthread_mutex_lock(&loop->mutex);
+  loop->num_waiting --;
+  pthread_mutex_unlock(&loop->mutex);
+}
+
+
+//
+// '_papplClientLoopStart()' - Start the client event loop.
+//
+// The event loop multiplexes idle keep-alive connections in a single thread
+// and hands connections with a pending request to a bounded pool of worker
+// threads.
+//
+// > Note: This function is normally only called from @link papplSystemRun@.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplClientLoopStart(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_cloop_t	*loop;		// Event loop
+
+
+  if ((loop = calloc(1, sizeof(_pappl_cloop_t))) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for client event loop: %s", strerror(errno));
+    return (false);
+  }
+
+  loop->system     = system;
+  loop->is_running = true;
+  loop->fd         = -1;
+  loop->wakefds[0] = -1;
+  loop->wakefds[1] = -1;
+  loop->idle       = cupsArrayNew(NULL, NULL);
+  loop->ready      = cupsArrayNew(NULL, NULL);
+
+  pthread_mutex_init(&loop->mutex, NULL);
+  pthread_cond_init(&loop->cond, NULL);
+
+#if _PAPPL_CLOOP_EPOLL
+  if ((loop->fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create epoll descriptor: %s", strerror(errno));
+    goto error;
+  }
+
+#elif _PAPPL_CLOOP_KQUEUE
+  if ((loop->fd = kqueue()) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create kqueue descriptor: %s", strerror(errno));
+    goto error;
+  }
+
+#elif !_WIN32
+  if (pipe(loop->wakefds))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create wakeup pipe: %s", strerror(errno));
+    goto error;
+  }
+
+  fcntl(loop->wakefds[0], F_SETFL, fcntl(loop->wakefds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(loop->wakefds[1], F_SETFL, fcntl(loop->wakefds[1], F_GETFL) | O_NONBLOCK);
+#endif // _PAPPL_CLOOP_EPOLL
+
+  if (!loop->idle || !loop->ready)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for client event loop: %s", strerror(errno));
+    goto error;
+  }
+
+  system->client_loop = loop;
+
+  if (pthread_create(&loop->thread_id, NULL, (void *(*)(void *))cloop_run, loop))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create client event loop thread: %s", strerror(errno));
+    system->client_loop = NULL;
+    goto error;
+  }
+
+#if _PAPPL_CLOOP_EPOLL
+  papplLog(system, PAPPL_LOGLEVEL_INFO, "Using epoll for idle client connections.");
+#elif _PAPPL_CLOOP_KQUEUE
+  papplLog(system, PAPPL_LOGLEVEL_INFO, "Using kqueue for idle client connections.");
+#else
+  papplLog(system, PAPPL_LOGLEVEL_INFO, "Using poll for idle client connections.");
+#endif // _PAPPL_CLOOP_EPOLL
+
+  return (true);
+
+  // If we get here something went wrong...
+  error:
+
+  if (loop->fd >= 0)
+    close(loop->fd);
+  if (loop->wakefds[0] >= 0)
+    close(loop->wakefds[0]);
+  if (loop->wakefds[1] >= 0)
+    close(loop->wakefds[1]);
+
+  cupsArrayDelete(loop->idle);
+  cupsArrayDelete(loop->ready);
+
+  pthread_cond_destroy(&loop->cond);
+  pthread_mutex_destroy(&loop->mutex);
+
+  free(loop);
+
+  return (false);
+}
+
+
+//
+// '_papplClientLoopStop()' - Stop the client event loop.
+//
+// This function waits for the worker threads to finish their current request
+// and then closes all remaining client connections.
+//
+// > Note: This function is normally only called from @link papplSystemRun@.
+//
+
+void
+_papplClientLoopStop(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_cloop_t	*loop;		// Event loop
+
+
+  if ((loop = system->client_loop) == NULL)
+    return;
+
+  // Tell the event loop and worker threads to stop...
+  pthread_mutex_lock(&loop->mutex);
+  loop->is_running = false;
+  pthread_cond_broadcast(&loop->cond);
+  pthread_mutex_unlock(&loop->mutex);
+
+  if (loop->wakefds[1] >= 0 && write(loop->wakefds[1], "", 1) < 0 && errno != EAGAIN)
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to wake up client event loop: %s", strerror(errno));
+
+  pthread_join(loop->thread_id, NULL);
+
+  // Wait for any active requests to complete...
+  pthread_mutex_lock(&loop->mutex);
+  while (loop->num_workers > 0)
+    pthread_cond_wait(&loop->cond, &loop->mutex);
+  pthread_mutex_unlock(&loop->mutex);
+
+  // Free memory...
+  system->client_loop = NULL;
+
+  if (loop->fd >= 0)
+    close(loop->fd);
+  if (loop->wakefds[0] >= 0)
+    close(loop->wakefds[0]);
+  if (loop->wakefds[1] >= 0)
+    close(loop->wakefds[1]);
+
+  cupsArrayDelete(loop->idle);
+  cupsArrayDelete(loop->ready);
+
+  pthread_cond_destroy(&loop->cond);
+  pthread_mutex_destroy(&loop->mutex);
+
+  free(loop);
+}
+
+
+//
+// 'cloop_ready()' - Queue a client with a pending request.
+//
+// The loop mutex must be held when calling this function.
+//
+
+static void
+cloop_ready(_pappl_cloop_t *loop,	// I - Event loop
+            pappl_client_t *client)	// I - Client
+{
+  cupsArrayRemove(loop->idle, client);
+  cupsArrayAdd(loop->ready, client);
+
+  if (loop->idle_workers > 0)
+  {
+    // Wake up a waiting worker...
+    pthread_cond_signal(&loop->cond);
+  }
+  else
+  {
+    // Start a new worker, if allowed.  Otherwise the client waits for the next
+    // free worker...
+    cloop_start_worker(loop);
+  }
+}
+
+
+//
+// 'cloop_run()' - Watch idle client connections.
+//
+
+static void *				// O - Thread exit status
+cloop_run(_pappl_cloop_t *loop)		// I - Event loop
+{
+  int			i,		// Looping var
+			nevents;	// Number of events
+  pappl_client_t	*client;	// Current client
+  time_t		curtime;	// Current time
+  cups_array_t		*expired;	// Expired clients
+#if _PAPPL_CLOOP_EPOLL
+  struct epoll_event	events[_PAPPL_CLOOP_MAX_EVENTS];
+					// Events
+#elif _PAPPL_CLOOP_KQUEUE
+  struct kevent		events[_PAPPL_CLOOP_MAX_EVENTS];
+					// Events
+  struct timespec	timeout = { 1, 0 };
+					// Timeout
+#else
+  int			num_pollfds = 0,// Number of poll entries
+			alloc_pollfds = 0;
+					// Allocated poll entries
+  struct pollfd		*pollfds = NULL;// Poll entries
+  pappl_client_t	**pollclients = NULL;
+					// Clients for each poll entry
+#endif // _PAPPL_CLOOP_EPOLL
+
+
+  expired = cupsArrayNew(NULL, NULL);
+
+  while (loop->is_running)
+  {
+#if _PAPPL_CLOOP_EPOLL
+    if ((nevents = epoll_wait(loop->fd, events, _PAPPL_CLOOP_MAX_EVENTS, 1000)) < 0 && errno != EINTR)
+    {
+      papplLog(loop->system, PAPPL_LOGLEVEL_ERROR, "Unable to wait for client connections: %s", strerror(errno));
+      break;
+    }
+
+    pthread_mutex_lock(&loop->mutex);
+
+    for (i = 0; i < nevents; i ++)
+      cloop_ready(loop, (pappl_client_t *)events[i].data.ptr);
+
+#elif _PAPPL_CLOOP_KQUEUE
+    if ((nevents = kevent(loop->fd, NULL, 0, events, _PAPPL_CLOOP_MAX_EVENTS, &timeout)) < 0 && errno != EINTR)
+    {
+      papplLog(loop->system, PAPPL_LOGLEVEL_ERROR, "Unable to wait for client connections: %s", strerror(errno));
+      break;
+    }
+
+    pthread_mutex_lock(&loop->mutex);
+
+    for (i = 0; i < nevents; i ++)
+      cloop_ready(loop, (pappl_client_t *)events[i].udata);
+
+#else
+    // Build the list of descriptors to poll...
+    pthread_mutex_lock(&loop->mutex);
+
+    if ((cupsArrayCount(loop->idle) + 1) > alloc_pollfds)
+    {
+      int		count = cupsArrayCount(loop->idle) + 32;
+					// New allocation
+      struct pollfd	*newfds;	// New poll entries
+      pappl_client_t	**newclients;	// New clients
+
+      if ((newfds = realloc(pollfds, (size_t)count * sizeof(struct pollfd))) != NULL)
+        pollfds = newfds;
+      if ((newclients = realloc(pollclients, (size_t)count * sizeof(pappl_client_t *))) != NULL)
+        pollclients = newclients;
+
+      if (!newfds || !newclients)
+      {
+        papplLog(loop->system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for client connections: %s", strerror(errno));
+        pthread_mutex_unlock(&loop->mutex);
+        break;
+      }
+
+      alloc_pollfds = count;
+    }
+
+    num_pollfds = 0;
+
+    if (loop->wakefds[0] >= 0)
+    {
+      pollfds[0].fd      = loop->wakefds[0];
+      pollfds[0].events  = POLLIN;
+      pollfds[0].revents = 0;
+      pollclients[0]     = NULL;
+      num_pollfds ++;
+    }
+
+    for (client = (pappl_client_t *)cupsArrayFirst(loop->idle); client; client = (pappl_client_t *)cupsArrayNext(loop->idle), num_pollfds ++)
+    {
+      pollfds[num_pollfds].fd      = httpGetFd(client->http);
+      pollfds[num_pollfds].events  = POLLIN;
+      pollfds[num_pollfds].revents = 0;
+      pollclients[num_pollfds]     = client;
+    }
+
+    pthread_mutex_unlock(&loop->mutex);
+
+    // Without a wakeup pipe we need to poll more often for new clients...
+    if ((nevents = poll(pollfds, (nfds_t)num_pollfds, loop->wakefds[0] >= 0 ? 1000 : 100)) < 0 && errno != EINTR && errno != EAGAIN)
+    {
+      papplLog(loop->system, PAPPL_LOGLEVEL_ERROR, "Unable to wait for client connections: %s", strerror(errno));
+      break;
+    }
+
+    pthread_mutex_lock(&loop->mutex);
+
+    for (i = 0; nevents > 0 && i < num_pollfds; i ++)
+    {
+      if (!pollfds[i].revents)
+        continue;
+
+      nevents --;
+
+      if (pollclients[i])
+      {
+        cloop_ready(loop, pollclients[i]);
+      }
+      else
+      {
+        char	buffer[256];		// Wakeup data
+
+        while (read(loop->wakefds[0], buffer, sizeof(buffer)) > 0);
+      }
+    }
+#endif // _PAPPL_CLOOP_EPOLL
+
+    // Close connections that have been idle too long...
+    curtime = time(NULL);
+
+    for (client = (pappl_client_t *)cupsArrayFirst(loop->idle); client; client = (pappl_client_t *)cupsArrayNext(loop->idle))
+    {
+      if ((curtime - client->idle_time) >= _PAPPL_CLOOP_TIMEOUT)
+      {
+        cupsArrayRemove(loop->idle, client);
+        cloop_unwatch(loop, client);
+        cupsArrayAdd(expired, client);
+      }
+    }
+
+    pthread_mutex_unlock(&loop->mutex);
+
+    for (client = (pappl_client_t *)cupsArrayFirst(expired); client; client = (pappl_client_t *)cupsArrayNext(expired))
+      _papplClientDelete(client);
+
+    cupsArrayClear(expired);
+  }
+
+  // Close all remaining connections...
+  pthread_mutex_lock(&loop->mutex);
+
+  loop->is_running = false;
+  pthread_cond_broadcast(&loop->cond);
+
+  for (client = (pappl_client_t *)cupsArrayFirst(loop->idle); client; client = (pappl_client_t *)cupsArrayNext(loop->idle))
+  {
+    cloop_unwatch(loop, client);
+    cupsArrayAdd(expired, client);
+  }
+
+  for (client = (pappl_client_t *)cupsArrayFirst(loop->ready); client; client = (pappl_client_t *)cupsArrayNext(loop->ready))
+    cupsArrayAdd(expired, client);
+
+  cupsArrayClear(loop->idle);
+  cupsArrayClear(loop->ready);
+
+  pthread_mutex_unlock(&loop->mutex);
+
+  for (client = (pappl_client_t *)cupsArrayFirst(expired); client; client = (pappl_client_t *)cupsArrayNext(expired))
+    _papplClientDelete(client);
+
+  cupsArrayDelete(expired);
+
+#if !_PAPPL_CLOOP_EPOLL && !_PAPPL_CLOOP_KQUEUE
+  free(pollfds);
+  free(pollclients);
+#endif // !_PAPPL_CLOOP_EPOLL && !_PAPPL_CLOOP_KQUEUE
+
+  return (NULL);
+}
+
+
+//
+// 'cloop_start_worker()' - Start a new worker thread.
+//
+// Workers that are waiting for events are not counted against the limit.  The
+// loop mutex must be held when calling this function.
+//
+
+static void
+cloop_start_worker(
+    _pappl_cloop_t *loop)		// I - Event loop
+{
+  pthread_t	tid;			// Worker thread
+
+
+  if ((loop->num_workers - loop->num_waiting) >= _PAPPL_CLOOP_MAX_WORKERS)
+    return;
+
+  if (pthread_create(&tid, NULL, (void *(*)(void *))cloop_worker, loop))
+  {
+    papplLog(loop->system, PAPPL_LOGLEVEL_ERROR, "Unable to create client worker thread: %s", strerror(errno));
+  }
+  else
+  {
+    pthread_detach(tid);
+    loop->num_workers ++;
+  }
+}
+
+
+//
+// 'cloop_unwatch()' - Stop watching a client connection.
+//
+// The loop mutex must be held when calling this function.
+//
+
+static void
+cloop_unwatch(_pappl_cloop_t *loop,	// I - Event loop
+              pappl_client_t *client)	// I - Client
+{
+#if _PAPPL_CLOOP_EPOLL
+  epoll_ctl(loop->fd, EPOLL_CTL_DEL, httpGetFd(client->http), NULL);
+
+#elif _PAPPL_CLOOP_KQUEUE
+  struct kevent	event;			// Event
+
+
+  EV_SET(&event, httpGetFd(client->http), EVFILT_READ, EV_DELETE, 0, 0, client);
+  kevent(loop->fd, &event, 1, NULL, 0, NULL);
+
+#else
+  // poll() entries are rebuilt every time...
+  (void)loop;
+  (void)client;
+#endif // _PAPPL_CLOOP_EPOLL
+}
+
+
+//
+// 'cloop_watch()' - Watch a client connection for a new request.
+//
+// The loop mutex must be held when calling this function.
+//
+
+static bool				// O - `true` on success, `false` on error
+cloop_watch(_pappl_cloop_t *loop,	// I - Event loop
+            pappl_client_t *client)	// I - Client
+{
+#if _PAPPL_CLOOP_EPOLL
+  struct epoll_event	event;		// Event
+
+
+  // Use one-shot events so only one worker sees each request...
+  event.events   = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  event.data.ptr = client;
+
+  if (!epoll_ctl(loop->fd, EPOLL_CTL_MOD, httpGetFd(client->http), &event))
+    return (true);
+  else if (errno == ENOENT)
+    return (!epoll_ctl(loop->fd, EPOLL_CTL_ADD, httpGetFd(client->http), &event));
+  else
+    return (false);
+
+#elif _PAPPL_CLOOP_KQUEUE
+  struct kevent	event;			// Event
+
+
+  EV_SET(&event, httpGetFd(client->http), EVFILT_READ, EV_ADD | EV_ONESHOT, 0, 0, client);
+
+  return (!kevent(loop->fd, &event, 1, NULL, 0, NULL));
+
+#else
+  // Wake up the event loop so it rebuilds the list of descriptors...
+  if (loop->wakefds[1] >= 0 && write(loop->wakefds[1], "", 1) < 0 && errno != EAGAIN)
+  {
+    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to wake up client event loop: %s", strerror(errno));
+    return (false);
+  }
+
+  return (true);
+#endif // _PAPPL_CLOOP_EPOLL
+}
+
+
+//
+// 'cloop_worker()' - Process requests from clients.
+//
+
+static void *				// O - Thread exit status
+cloop_worker(_pappl_cloop_t *loop)	// I - Event loop
+{
+  pappl_client_t	*client;	// Current client
+  bool			keep_alive;	// Keep the connection open?
+
+
+  pthread_mutex_lock(&loop->mutex);
+
+  while (loop->is_running)
+  {
+    if ((client = (pappl_client_t *)cupsArrayFirst(loop->ready)) == NULL)
+    {
+      // Exit extra workers that were started while others waited for events...
+      if ((loop->num_workers - loop->num_waiting) > _PAPPL_CLOOP_MAX_WORKERS)
+        break;
+
+      // Wait for a client with a pending request...
+      loop->idle_workers ++;
+      pthread_cond_wait(&loop->cond, &loop->mutex);
+      loop->idle_workers --;
+      continue;
+    }
+
+    cupsArrayRemove(loop->ready, client);
+
+    pthread_mutex_unlock(&loop->mutex);
+
+    // Process requests until the client has nothing more to send, then return
+    // the connection to the event loop...
+    client->thread_id = pthread_self();
+
+    do
+    {
+      keep_alive = _papplClientProcessRequest(client);
+    }
+    while (keep_alive && httpWait(client->http, 0));
+
+    if (keep_alive)
+      _papplClientLoopAdd(client);
+    else
+      _papplClientDelete(client);
+
+    pthread_mutex_lock(&loop->mutex);
+  }
+
+  loop->num_workers --;
+  pthread_cond_broadcast(&loop->cond);
+
+  pthread_mutex_unlock(&loop->mutex);
+
+  return (NULL);
+}
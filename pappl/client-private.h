@@ -1,7 +1,7 @@
 //
 // Private client header file for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -20,6 +20,13 @@
 #  include "log.h"
 
 
+//
+// Constants...
+//
+
+#  define _PAPPL_CLIENT_WBUFFER	16384	// Size of write buffer (one TLS record)
+
+
 //
 // Client structure...
 //
@@ -32,7 +39,13 @@ struct _pappl_client_s			// Client data
   http_t		*http;			// HTTP connection
   ipp_t			*request,		// IPP request
 			*response;		// IPP response
-  time_t		start;			// Request start time
+  time_t		start,			// Request start time
+			idle_time;		// Time connection became idle
+  bool			tls_checked;		// Checked for a TLS handshake?
+  bool			host_counted;		// Counted in the client host connections?
+  bool			loc_checked;		// Looked up the localization for the request?
+  bool			vary_encoding;		// Response depends on Accept-Encoding?
+  pappl_loc_t		*loc;			// Localization for the request, if any
   http_state_t		operation;		// Request operation
   ipp_op_t		operation_id;		// IPP operation-id
   char			uri[1024],		// Request URI
@@ -47,6 +60,9 @@ struct _pappl_client_s			// Client data
   pappl_job_t		*job;			// Job, if any
   int			num_files;		// Number of temporary files
   char			*files[10];		// Temporary files
+  size_t		wused;			// Bytes used in write buffer
+  char			wbuffer[_PAPPL_CLIENT_WBUFFER];
+						// Write buffer for HTML content
 };
 
 
@@ -59,10 +75,18 @@ extern pappl_client_t	*_papplClientCreate(pappl_system_t *system, int sock) _PAP
 extern char		*_papplClientCreateTempFile(pappl_client_t *client, const void *data, size_t datasize) _PAPPL_PRIVATE;
 extern void		_papplClientDelete(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplClientFlushDocumentData(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientFlushWrite(pappl_client_t *client) _PAPPL_PRIVATE;
 extern bool		_papplClientHaveDocumentData(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplClientLoopAdd(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientLoopBeginWait(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplClientLoopEndWait(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientLoopStart(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplClientLoopStop(pappl_system_t *system) _PAPPL_PRIVATE;
 extern bool		_papplClientProcessHTTP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern bool		_papplClientProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientProcessRequest(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		*_papplClientRun(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplClientWrite(pappl_client_t *client, const char *data, size_t datalen) _PAPPL_PRIVATE;
 extern void		_papplClientHTMLInfo(pappl_client_t *client, bool is_form, const char *dns_sd_name, const char *location, const char *geo_location, const char *organization, const char *org_unit, pappl_contact_t *contact);
 extern void		_papplClientHTMLPutLinks(pappl_client_t *client, cups_array_t *links, pappl_loptions_t which);
 
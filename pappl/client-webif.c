@@ -16,6 +16,72 @@
 #include <math.h>
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_HTML_CACHE	512	// Number of compiled format slots (power of 2)
+#define _PAPPL_HTML_ONES	0x0101010101010101ULL
+					// Each byte set to 1
+#define _PAPPL_HTML_HIGHS	0x8080808080808080ULL
+					// High bit of each byte
+#define _PAPPL_HTML_HASZERO(v)	(((v) - _PAPPL_HTML_ONES) & ~(v) & _PAPPL_HTML_HIGHS)
+					// Does any byte in "v" equal 0?
+#define _PAPPL_HTML_HASBYTE(v,b) _PAPPL_HTML_HASZERO((v) ^ (_PAPPL_HTML_ONES * (unsigned char)(b)))
+					// Does any byte in "v" equal "b"?
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_htmlop_s		// Compiled format operation
+{
+  char		type,			// Format type character or `0` for literal text
+		size;			// Size character (h, l, L) or `0`
+  bool		width_arg,		// Width comes from an argument?
+		prec_arg,		// Precision comes from an argument?
+		plain;			// Plain "%d" without flags or width?
+  int		width;			// Field width
+  const char	*text;			// Literal text or `snprintf` format for the field
+  size_t	textlen;		// Length of literal text
+} _pappl_htmlop_t;
+
+typedef struct _pappl_htmlfmt_s		// Compiled format string
+{
+  const char		*key;		// Format string pointer used as cache key
+  char			*format;	// Copy of format string
+  size_t		num_ops;	// Number of operations
+  _pappl_htmlop_t	*ops;		// Operations
+} _pappl_htmlfmt_t;
+
+
+//
+// Local globals...
+//
+
+static _pappl_htmlfmt_t	*html_cache[_PAPPL_HTML_CACHE];
+					// Compiled format strings
+static pthread_mutex_t	html_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for adding compiled formats
+static const char	html_special[256] =
+{					// Characters that end a run of unescaped text
+  ['\0'] = 1,
+  ['\"'] = 1,
+  ['&']  = 1,
+  ['<']  = 1
+};
+
+
+//
+// Local functions...
+//
+
+static _pappl_htmlfmt_t	*html_compile(const char *format);
+static void		html_delete(_pappl_htmlfmt_t *fmt);
+static _pappl_htmlfmt_t	*html_get_format(const char *format, bool *cached);
+
+
 //
 // 'papplClientGetCookie()' - Get a cookie from the client.
 //
@@ -574,35 +640,43 @@ papplClientHTMLEscape(
     const char     *s,			// I - String to write
     size_t         slen)		// I - Number of characters to write (`0` for nul-terminated)
 {
-  const char	*start,			// Start of segment
-		*end;			// End of string
+  const char		*start,		// Start of segment
+			*end;		// End of string
+  unsigned long long	v;		// Eight characters
 
 
-  start = s;
-  end   = s + (slen > 0 ? slen : strlen(s));
+  end = s + (slen > 0 ? slen : strlen(s));
 
-  while (*s && s < end)
+  while (s < end)
   {
-    if (*s == '&' || *s == '<' || *s == '\"')
+    // Skip eight characters at a time while none of them need escaping, then
+    // finish the run using the lookup table...
+    for (start = s; (end - s) >= 8; s += 8)
     {
-      if (s > start)
-        httpWrite2(client->http, start, (size_t)(s - start));
+      memcpy(&v, s, sizeof(v));
 
-      if (*s == '&')
-        httpWrite2(client->http, "&amp;", 5);
-      else if (*s == '<')
-        httpWrite2(client->http, "&lt;", 4);
-      else
-        httpWrite2(client->http, "&quot;", 6);
-
-      start = s + 1;
+      if (_PAPPL_HTML_HASZERO(v) || _PAPPL_HTML_HASBYTE(v, '&') || _PAPPL_HTML_HASBYTE(v, '<') || _PAPPL_HTML_HASBYTE(v, '\"'))
+        break;
     }
 
+    while (s < end && !html_special[*s & 255])
+      s ++;
+
+    if (s > start)
+      _papplClientWrite(client, start, (size_t)(s - start));
+
+    if (s >= end || !*s)
+      break;
+
+    if (*s == '&')
+      _papplClientWrite(client, "&amp;", 5);
+    else if (*s == '<')
+      _papplClientWrite(client, "&lt;", 4);
+    else
+      _papplClientWrite(client, "&quot;", 6);
+
     s ++;
   }
-
-  if (s > start)
-    httpWrite2(client->http, start, (size_t)(s - start));
 }
 
 
@@ -638,6 +712,7 @@ papplClientHTMLFooter(
   papplClientHTMLPuts(client,
 		      "  </body>\n"
 		      "</html>\n");
+  _papplClientFlushWrite(client);
   httpWrite2(client->http, "", 0);
 }
 
@@ -668,9 +743,9 @@ papplClientHTMLHeader(
   const char		*name;		// Name for title/header
 
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  pthread_rwlock_rdlock(&system->printers_rwlock);
   printer = (pappl_printer_t *)cupsArrayFirst(system->printers);
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
   if ((system->options & PAPPL_SOPTIONS_MULTI_QUEUE) || !printer)
     name = system->name;
@@ -696,11 +771,11 @@ papplClientHTMLHeader(
 		      "        <div class=\"col-12 nav\">\n"
 		      "          <a class=\"btn\" href=\"/\"><img src=\"/navicon.png\"></a>\n");
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  pthread_rwlock_rdlock(&system->resource_rwlock);
 
   _papplClientHTMLPutLinks(client, system->links, PAPPL_LOPTIONS_NAVIGATION);
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->resource_rwlock);
 
   if (!(system->options & PAPPL_SOPTIONS_MULTI_QUEUE) && printer)
   {
@@ -989,204 +1064,184 @@ papplClientHTMLPrintf(
     const char     *format,		// I - Printf-style format string
     ...)				// I - Additional arguments as needed
 {
-  va_list	ap;			// Pointer to arguments
-  const char	*start;			// Start of string
-  char		size,			// Size character (h, l, L)
-		type;			// Format type character
-  int		width,			// Width of field
-		prec;			// Number of characters of precision
-  char		tformat[100],		// Temporary format string for snprintf()
-		*tptr,			// Pointer into temporary format
-		temp[1024];		// Buffer for formatted numbers
-  const char	*s;			// Pointer to string
-
-
-  // Loop through the format string, formatting as needed...
+  va_list		ap;		// Pointer to arguments
+  _pappl_htmlfmt_t	*fmt;		// Compiled format
+  bool			cached;		// Is the compiled format cached?
+  _pappl_htmlop_t	*op;		// Current operation
+  size_t		i;		// Looping var
+  int			width,		// Width of field
+			prec;		// Precision of field
+  char			temp[1024],	// Buffer for formatted numbers
+			*tptr;		// Pointer into buffer
+  const char		*s;		// Pointer to string
+
+
+  if ((fmt = html_get_format(format, &cached)) == NULL)
+    return;
+
   va_start(ap, format);
-  start = format;
 
-  while (*format)
+  for (i = fmt->num_ops, op = fmt->ops; i > 0; i --, op ++)
   {
-    if (*format == '%')
+    if (!op->type)
     {
-      if (format > start)
-        httpWrite2(client->http, start, (size_t)(format - start));
-
-      tptr    = tformat;
-      *tptr++ = *format++;
-
-      if (*format == '%')
-      {
-        httpWrite2(client->http, "%", 1);
-        format ++;
-	start = format;
-	continue;
-      }
-      else if (strchr(" -+#\'", *format))
-        *tptr++ = *format++;
-
-      if (*format == '*')
-      {
-        // Get width from argument...
-	format ++;
-	width = va_arg(ap, int);
-
-	snprintf(tptr, sizeof(tformat) - (size_t)(tptr - tformat), "%d", width);
-	tptr += strlen(tptr);
-      }
-      else
-      {
-	width = 0;
-
-	while (isdigit(*format & 255))
-	{
-	  if (tptr < (tformat + sizeof(tformat) - 1))
-	    *tptr++ = *format;
-
-	  width = width * 10 + *format++ - '0';
-	}
-      }
-
-      if (*format == '.')
-      {
-	if (tptr < (tformat + sizeof(tformat) - 1))
-	  *tptr++ = *format;
+      _papplClientWrite(client, op->text, op->textlen);
+      continue;
+    }
 
-        format ++;
+    width = op->width_arg ? va_arg(ap, int) : op->width;
+    prec  = op->prec_arg ? va_arg(ap, int) : 0;
 
-        if (*format == '*')
-	{
-          // Get precision from argument...
-	  format ++;
-	  prec = va_arg(ap, int);
+    switch (op->type)
+    {
+      case 'E' : // Floating point formats
+      case 'G' :
+      case 'e' :
+      case 'f' :
+      case 'g' :
+          {
+	    double value = va_arg(ap, double);
+					// Value
 
-	  snprintf(tptr, sizeof(tformat) - (size_t)(tptr - tformat), "%d", prec);
-	  tptr += strlen(tptr);
-	}
-	else
-	{
-	  prec = 0;
+	    if ((size_t)(width + 2) > sizeof(temp))
+	      break;
 
-	  while (isdigit(*format & 255))
-	  {
-	    if (tptr < (tformat + sizeof(tformat) - 1))
-	      *tptr++ = *format;
+	    if (op->width_arg && op->prec_arg)
+	      snprintf(temp, sizeof(temp), op->text, width, prec, value);
+	    else if (op->width_arg)
+	      snprintf(temp, sizeof(temp), op->text, width, value);
+	    else if (op->prec_arg)
+	      snprintf(temp, sizeof(temp), op->text, prec, value);
+	    else
+	      snprintf(temp, sizeof(temp), op->text, value);
 
-	    prec = prec * 10 + *format++ - '0';
+	    _papplClientWrite(client, temp, strlen(temp));
 	  }
-	}
-      }
-
-      if (*format == 'l' && format[1] == 'l')
-      {
-        size = 'L';
-
-	if (tptr < (tformat + sizeof(tformat) - 2))
-	{
-	  *tptr++ = 'l';
-	  *tptr++ = 'l';
-	}
+	  break;
 
-	format += 2;
-      }
-      else if (*format == 'h' || *format == 'l' || *format == 'L')
-      {
-	if (tptr < (tformat + sizeof(tformat) - 1))
-	  *tptr++ = *format;
+      case 'B' : // Integer formats
+      case 'X' :
+      case 'b' :
+      case 'd' :
+      case 'i' :
+      case 'o' :
+      case 'u' :
+      case 'x' :
+          {
+	    long long value;		// Value
+
+	    if (op->size == 'L')
+	      value = va_arg(ap, long long);
+	    else if (op->size == 'l')
+	      value = op->type == 'd' || op->type == 'i' ? va_arg(ap, long) : (long long)va_arg(ap, unsigned long);
+	    else
+	      value = op->type == 'd' || op->type == 'i' ? va_arg(ap, int) : (long long)va_arg(ap, unsigned);
 
-        size = *format++;
-      }
-      else
-        size = 0;
+	    if (op->plain)
+	    {
+	      // Format plain decimal integers directly...
+	      unsigned long long uvalue = value < 0 ? (unsigned long long)(-(value + 1)) + 1 : (unsigned long long)value;
+					// Absolute value
 
-      if (!*format)
-      {
-        start = format;
-        break;
-      }
+	      tptr  = temp + sizeof(temp);
+	      *(--tptr) = '\0';
 
-      if (tptr < (tformat + sizeof(tformat) - 1))
-        *tptr++ = *format;
+	      do
+	      {
+		*(--tptr) = (char)('0' + uvalue % 10);
+		uvalue /= 10;
+	      }
+	      while (uvalue > 0);
 
-      type  = *format++;
-      *tptr = '\0';
-      start = format;
+	      if (value < 0)
+		*(--tptr) = '-';
 
-      switch (type)
-      {
-	case 'E' : // Floating point formats
-	case 'G' :
-	case 'e' :
-	case 'f' :
-	case 'g' :
-	    if ((size_t)(width + 2) > sizeof(temp))
+	      _papplClientWrite(client, tptr, (size_t)(temp + sizeof(temp) - 1 - tptr));
 	      break;
+	    }
 
-	    snprintf(temp, sizeof(temp), tformat, va_arg(ap, double));
-
-            httpWrite2(client->http, temp, strlen(temp));
-	    break;
-
-        case 'B' : // Integer formats
-	case 'X' :
-	case 'b' :
-        case 'd' :
-	case 'i' :
-	case 'o' :
-	case 'u' :
-	case 'x' :
 	    if ((size_t)(width + 2) > sizeof(temp))
 	      break;
 
-#  ifdef HAVE_LONG_LONG
-            if (size == 'L')
-	      snprintf(temp, sizeof(temp), tformat, va_arg(ap, long long));
-	    else
-#  endif // HAVE_LONG_LONG
-            if (size == 'l')
-	      snprintf(temp, sizeof(temp), tformat, va_arg(ap, long));
+	    if (op->size == 'L')
+	    {
+	      if (op->width_arg && op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, width, prec, value);
+	      else if (op->width_arg)
+		snprintf(temp, sizeof(temp), op->text, width, value);
+	      else if (op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, prec, value);
+	      else
+		snprintf(temp, sizeof(temp), op->text, value);
+	    }
+	    else if (op->size == 'l')
+	    {
+	      if (op->width_arg && op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, width, prec, (long)value);
+	      else if (op->width_arg)
+		snprintf(temp, sizeof(temp), op->text, width, (long)value);
+	      else if (op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, prec, (long)value);
+	      else
+		snprintf(temp, sizeof(temp), op->text, (long)value);
+	    }
 	    else
-	      snprintf(temp, sizeof(temp), tformat, va_arg(ap, int));
+	    {
+	      if (op->width_arg && op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, width, prec, (int)value);
+	      else if (op->width_arg)
+		snprintf(temp, sizeof(temp), op->text, width, (int)value);
+	      else if (op->prec_arg)
+		snprintf(temp, sizeof(temp), op->text, prec, (int)value);
+	      else
+		snprintf(temp, sizeof(temp), op->text, (int)value);
+	    }
+
+	    _papplClientWrite(client, temp, strlen(temp));
+	  }
+	  break;
 
-            httpWrite2(client->http, temp, strlen(temp));
-	    break;
+      case 'p' : // Pointer value
+          {
+	    void *value = va_arg(ap, void *);
+					// Value
 
-	case 'p' : // Pointer value
 	    if ((size_t)(width + 2) > sizeof(temp))
 	      break;
 
-	    snprintf(temp, sizeof(temp), tformat, va_arg(ap, void *));
+	    if (op->width_arg)
+	      snprintf(temp, sizeof(temp), op->text, width, value);
+	    else
+	      snprintf(temp, sizeof(temp), op->text, value);
 
-            httpWrite2(client->http, temp, strlen(temp));
-	    break;
+	    _papplClientWrite(client, temp, strlen(temp));
+	  }
+	  break;
 
-        case 'c' : // Character or character array
-            if (width <= 1)
-            {
-              temp[0] = (char)va_arg(ap, int);
-              temp[1] = '\0';
-              papplClientHTMLEscape(client, temp, 1);
-            }
-            else
-              papplClientHTMLEscape(client, va_arg(ap, char *), (size_t)width);
-	    break;
+      case 'c' : // Character or character array
+	  if (width <= 1)
+	  {
+	    temp[0] = (char)va_arg(ap, int);
+	    temp[1] = '\0';
+	    papplClientHTMLEscape(client, temp, 1);
+	  }
+	  else
+	    papplClientHTMLEscape(client, va_arg(ap, char *), (size_t)width);
+	  break;
 
-	case 's' : // String
-	    if ((s = va_arg(ap, const char *)) == NULL)
-	      s = "(null)";
+      case 's' : // String
+	  if ((s = va_arg(ap, const char *)) == NULL)
+	    s = "(null)";
 
-            papplClientHTMLEscape(client, s, strlen(s));
-	    break;
-      }
+	  papplClientHTMLEscape(client, s, 0);
+	  break;
     }
-    else
-      format ++;
   }
 
-  if (format > start)
-    httpWrite2(client->http, start, (size_t)(format - start));
-
   va_end(ap);
+
+  if (!cached)
+    html_delete(fmt);
 }
 
 
@@ -1245,7 +1300,7 @@ papplClientHTMLPuts(
     const char     *s)			// I - String
 {
   if (client && s && *s)
-    httpWrite2(client->http, s, strlen(s));
+    _papplClientWrite(client, s, strlen(s));
 }
 
 
@@ -1361,3 +1416,222 @@ papplClientSetCookie(
     httpSetCookie(client->http, buffer);
   }
 }
+
+
+//
+// 'html_compile()' - Compile a format string for papplClientHTMLPrintf.
+//
+// Literal text is referenced from a copy of the format string and each field
+// gets its own nul-terminated `snprintf` format, with any "*" width and
+// precision left for `snprintf` to get from the arguments.
+//
+
+static _pappl_htmlfmt_t *		// O - Compiled format or `NULL` on error
+html_compile(const char *format)	// I - Printf-style format string
+{
+  _pappl_htmlfmt_t	*fmt;		// Compiled format
+  _pappl_htmlop_t	*op;		// Current operation
+  size_t		alloc_ops,	// Allocated operations
+			num_fields = 0,	// Number of fields
+			len;		// Length of format string
+  char			*fptr,		// Pointer into format copy
+			*start,		// Start of literal text
+			*tptr;		// Pointer into field format
+  bool			flags;		// Field has flags?
+
+
+  if ((fmt = (_pappl_htmlfmt_t *)calloc(1, sizeof(_pappl_htmlfmt_t))) == NULL)
+    return (NULL);
+
+  // Each "%" starts at most one field and ends at most one run of literal
+  // text...
+  for (fptr = (char *)format; *fptr; fptr ++)
+  {
+    if (*fptr == '%')
+      num_fields ++;
+  }
+
+  // The format string is copied for the literal text, followed by a copy of
+  // each field's "%..." text plus a nul.  The field copies need at most the
+  // length of the format string plus one byte per field...
+  len         = strlen(format);
+  alloc_ops   = 2 * num_fields + 1;
+  fmt->key    = format;
+  fmt->format = malloc(2 * len + 2 + num_fields);
+  fmt->ops    = (_pappl_htmlop_t *)calloc(alloc_ops, sizeof(_pappl_htmlop_t));
+
+  if (!fmt->format || !fmt->ops)
+  {
+    html_delete(fmt);
+    return (NULL);
+  }
+
+  memcpy(fmt->format, format, len + 1);
+
+  tptr  = fmt->format + len + 1;
+  start = fmt->format;
+
+  for (fptr = fmt->format; *fptr;)
+  {
+    if (*fptr != '%')
+    {
+      fptr ++;
+      continue;
+    }
+
+    if (fptr > start)
+    {
+      op          = fmt->ops + fmt->num_ops ++;
+      op->text    = start;
+      op->textlen = (size_t)(fptr - start);
+    }
+
+    if (fptr[1] == '%')
+    {
+      // "%%" is a literal "%"...
+      op          = fmt->ops + fmt->num_ops ++;
+      op->text    = fptr;
+      op->textlen = 1;
+
+      fptr += 2;
+      start = fptr;
+      continue;
+    }
+
+    op       = fmt->ops + fmt->num_ops;
+    op->text = tptr;
+    *tptr++  = *fptr++;
+    flags    = false;
+
+    if (*fptr && strchr(" -+#\'", *fptr))
+    {
+      *tptr++ = *fptr++;
+      flags   = true;
+    }
+
+    if (*fptr == '*')
+    {
+      *tptr++       = *fptr++;
+      op->width_arg = true;
+    }
+    else
+    {
+      while (isdigit(*fptr & 255))
+      {
+        op->width = op->width * 10 + *fptr - '0';
+        *tptr++   = *fptr++;
+      }
+    }
+
+    if (*fptr == '.')
+    {
+      *tptr++ = *fptr++;
+      flags   = true;
+
+      if (*fptr == '*')
+      {
+	*tptr++      = *fptr++;
+	op->prec_arg = true;
+      }
+      else
+      {
+	while (isdigit(*fptr & 255))
+	  *tptr++ = *fptr++;
+      }
+    }
+
+    if (*fptr == 'l' && fptr[1] == 'l')
+    {
+      op->size = 'L';
+      *tptr++  = *fptr++;
+      *tptr++  = *fptr++;
+    }
+    else if (*fptr == 'h' || *fptr == 'l' || *fptr == 'L')
+    {
+      op->size = *fptr;
+      *tptr++  = *fptr++;
+    }
+
+    if (!*fptr)
+    {
+      // Incomplete field at the end of the string is ignored...
+      start = fptr;
+      break;
+    }
+
+    op->type  = *fptr;
+    op->plain = op->type == 'd' && !flags && !op->width && !op->width_arg;
+    *tptr++   = *fptr++;
+    *tptr++   = '\0';
+    start     = fptr;
+
+    fmt->num_ops ++;
+  }
+
+  if (fptr > start)
+  {
+    op          = fmt->ops + fmt->num_ops ++;
+    op->text    = start;
+    op->textlen = (size_t)(fptr - start);
+  }
+
+  return (fmt);
+}
+
+
+//
+// 'html_delete()' - Free a compiled format.
+//
+
+static void
+html_delete(_pappl_htmlfmt_t *fmt)	// I - Compiled format
+{
+  free(fmt->format);
+  free(fmt->ops);
+  free(fmt);
+}
+
+
+//
+// 'html_get_format()' - Get the compiled form of a format string.
+//
+// Format strings are almost always literals, so compiled formats are cached
+// by the address of the format string for the life of the process.  The
+// cached copy of the string is compared to make sure a reused address still
+// has the same format.  Formats that don't fit in the cache are compiled for
+// each call and must be freed by the caller.
+//
+
+static _pappl_htmlfmt_t *		// O - Compiled format or `NULL` on error
+html_get_format(const char *format,	// I - Printf-style format string
+                bool       *cached)	// O - `true` if cached, `false` if the caller must free it
+{
+  size_t		slot;		// Cache slot
+  _pappl_htmlfmt_t	*fmt;		// Compiled format
+
+
+  slot = (size_t)(((uintptr_t)format * 2654435761U) >> 8) & (_PAPPL_HTML_CACHE - 1);
+
+  if ((fmt = (_pappl_htmlfmt_t *)_PAPPL_ATOMIC_GETPTR(&html_cache[slot])) != NULL && fmt->key == format && !strcmp(fmt->format, format))
+  {
+    *cached = true;
+    return (fmt);
+  }
+
+  *cached = false;
+
+  if ((fmt = html_compile(format)) == NULL)
+    return (NULL);
+
+  pthread_mutex_lock(&html_mutex);
+
+  if (!html_cache[slot])
+  {
+    _PAPPL_ATOMIC_SETPTR(&html_cache[slot], fmt);
+    *cached = true;
+  }
+
+  pthread_mutex_unlock(&html_mutex);
+
+  return (fmt);
+}
@@ -15,11 +15,41 @@
 #include "pappl-private.h"
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_CLIENT_BIG_FILE	65536	// Minimum size of large resource files
+#define _PAPPL_CLIENT_BIG_CHUNK	65536	// Size of large resource file reads
+#define _PAPPL_CLIENT_MAX_HOSTS	256	// Maximum number of client hosts tracked
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_chost_s		// Client host tracking data
+{
+  char		hostname[256];		// Client hostname/address
+  int		count;			// Number of connections
+  double	tokens;			// Requests that can be made now
+  long long	tokens_time;		// Time of last token update
+} _pappl_chost_t;
+
+
 //
 // Local functions...
 //
 
+static bool	admit_client(pappl_client_t *client);
+static bool	check_rate(pappl_client_t *client);
+static int	compare_hosts(_pappl_chost_t *a, _pappl_chost_t *b);
 static bool	eval_if_modified(pappl_client_t *client, _pappl_resource_t *r);
+static const char *get_content_encoding(pappl_client_t *client, _pappl_resource_t *r);
+static void	reject_client(pappl_client_t *client, const char *reason);
+static void	remove_host(pappl_client_t *client);
+static bool	send_file(pappl_client_t *client, _pappl_resource_t *r, int fd);
+static bool	start_tls(pappl_client_t *client, http_encryption_t e);
 
 
 //
@@ -70,14 +100,16 @@ _papplClientCreate(
 
   client->system = system;
 
-  pthread_rwlock_wrlock(&system->rwlock);
-  client->number = system->next_client ++;
-  pthread_rwlock_unlock(&system->rwlock);
+  client->number = _PAPPL_ATOMIC_ADD(&system->next_client, 1);
+  _PAPPL_ATOMIC_ADD(&system->num_clients, 1);
 
   // Accept the client and get the remote address...
   if ((client->http = httpAcceptConnection(sock, 1)) == NULL)
   {
     papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept client connection: %s", strerror(errno));
+
+    _PAPPL_ATOMIC_ADD(&system->num_clients, -1);
+
     free(client);
     return (NULL);
   }
@@ -86,6 +118,10 @@ _papplClientCreate(
 
   papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Accepted connection from '%s'.", client->hostname);
 
+  // Shed the connection if the system or client host is at its limit...
+  if (!admit_client(client))
+    return (NULL);
+
   return (client);
 }
 
@@ -154,20 +190,51 @@ _papplClientDelete(
   papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Closing connection from '%s'.", client->hostname);
 
   // Flush pending writes before closing...
+  _papplClientFlushWrite(client);
   httpFlushWrite(client->http);
 
   _papplClientCleanTempFiles(client);
 
+  remove_host(client);
+
   // Free memory...
   httpClose(client->http);
 
   ippDelete(client->request);
   ippDelete(client->response);
 
+  _papplLocRelease(client->system, client->loc);
+
+  _PAPPL_ATOMIC_ADD(&client->system->num_clients, -1);
+
   free(client);
 }
 
 
+//
+// '_papplClientFlushWrite()' - Send any buffered response data.
+//
+// This function must be called before anything is written to the HTTP
+// connection directly, including the trailing 0-length chunk of a response.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplClientFlushWrite(
+    pappl_client_t *client)		// I - Client
+{
+  bool	ret = true;			// Return value
+
+
+  if (client->wused > 0)
+  {
+    ret = httpWrite2(client->http, client->wbuffer, client->wused) >= 0;
+    client->wused = 0;
+  }
+
+  return (ret);
+}
+
+
 //
 // '_papplClientProcessHTTP()' - Process a HTTP request.
 //
@@ -213,9 +280,15 @@ _papplClientProcessHTTP(
   ippDelete(client->request);
   ippDelete(client->response);
 
-  client->request   = NULL;
-  client->response  = NULL;
-  client->operation = HTTP_STATE_WAITING;
+  _papplLocRelease(client->system, client->loc);
+
+  client->request     = NULL;
+  client->response    = NULL;
+  client->operation   = HTTP_STATE_WAITING;
+  client->loc         = NULL;
+  client->loc_checked = false;
+
+  client->vary_encoding = false;
 
   // Read a request from the connection...
   while ((http_state = httpReadRequest(client->http, uri, sizeof(uri))) == HTTP_STATE_WAITING)
@@ -271,6 +344,16 @@ _papplClientProcessHTTP(
 
   papplLogClient(client, PAPPL_LOGLEVEL_INFO, "%s %s://%s%s HTTP/%d.%d", http_states[http_state], httpIsEncrypted(client->http) ? "https" : "http", httpGetField(client->http, HTTP_FIELD_HOST), uri, http_version / 100, http_version % 100);
 
+  // Reject requests over the client host's request rate before reading any
+  // request data...
+  if (!check_rate(client))
+  {
+    papplLogClient(client, PAPPL_LOGLEVEL_WARN, "Too many requests from '%s'.", client->hostname);
+    _PAPPL_ATOMIC_ADD(&client->system->num_rejected, 1);
+    papplClientRespond(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    return (false);
+  }
+
   // Validate the host header...
   if (!httpGetField(client->http, HTTP_FIELD_HOST)[0] &&
       httpGetVersion(client->http) >= HTTP_VERSION_1_1)
@@ -317,13 +400,8 @@ _papplClientProcessHTTP(
 
       papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Upgrading to encrypted connection.");
 
-      if (httpEncryption(client->http, HTTP_ENCRYPTION_REQUIRED))
-      {
-	papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to encrypt connection: %s", cupsLastErrorString());
+      if (!start_tls(client, HTTP_ENCRYPTION_REQUIRED))
 	return (false);
-      }
-
-      papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Connection now encrypted.");
     }
     else if (!papplClientRespond(client, HTTP_STATUS_NOT_IMPLEMENTED, NULL, NULL, 0, 0))
       return (false);
@@ -357,8 +435,10 @@ _papplClientProcessHTTP(
         // See if we have a matching resource to serve...
         if ((resource = _papplSystemFindResource(client->system, client->uri)) != NULL)
         {
+          client->vary_encoding = resource->compress;
+
           if (eval_if_modified(client, resource))
-	    return (papplClientRespond(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, 0));
+	    return (papplClientRespond(client, HTTP_STATUS_OK, get_content_encoding(client, resource), resource->format, resource->last_modified, 0));
           else
             return (papplClientRespond(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
 	}
@@ -370,6 +450,8 @@ _papplClientProcessHTTP(
         // See if we have a matching resource to serve...
         if ((resource = _papplSystemFindResource(client->system, client->uri)) != NULL)
         {
+          client->vary_encoding = resource->compress;
+
           if (!eval_if_modified(client, resource))
           {
             return (papplClientRespond(client, HTTP_STATUS_NOT_MODIFIED, NULL, NULL, resource->last_modified, 0));
@@ -383,35 +465,31 @@ _papplClientProcessHTTP(
 	  {
 	    // Send an external file...
 	    int		fd;		// Resource file descriptor
-	    char	buffer[8192];	// Copy buffer
-	    ssize_t	bytes;		// Bytes read/written
+	    bool	ret;		// Return value
 
             if ((fd = open(resource->filename, O_RDONLY)) >= 0)
 	    {
-	      if (!papplClientRespond(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, 0))
-	      {
-	        close(fd);
-		return (false);
-	      }
-
-              while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-                httpWrite2(client->http, buffer, (size_t)bytes);
-
-	      httpWrite2(client->http, "", 0);
+	      ret = send_file(client, resource, fd);
 
 	      close(fd);
 
-	      return (true);
+	      return (ret);
 	    }
 	  }
 	  else
 	  {
 	    // Send a static resource file...
-	    if (!papplClientRespond(client, HTTP_STATUS_OK, NULL, resource->format, resource->last_modified, resource->length))
+	    const char	*coding = get_content_encoding(client, resource);
+					// Content coding, if any
+
+            if (!papplClientRespond(client, HTTP_STATUS_OK, coding, resource->format, resource->last_modified, coding ? 0 : resource->length))
 	      return (false);
 
 	    httpWrite2(client->http, (const char *)resource->data, resource->length);
-	    httpFlushWrite(client->http);
+	    if (coding)
+	      httpWrite2(client->http, "", 0);
+	    else
+	      httpFlushWrite(client->http);
 	    return (true);
 	  }
 	}
@@ -466,6 +544,48 @@ _papplClientProcessHTTP(
 }
 
 
+//
+// '_papplClientProcessRequest()' - Process a single request on a connection.
+//
+// This function negotiates TLS as needed before the first request and then
+// processes the next HTTP request.
+//
+
+bool					// O - `true` to keep the connection open, `false` to close it
+_papplClientProcessRequest(
+    pappl_client_t *client)		// I - Client
+{
+  bool	ret;				// Return value
+
+
+  if (!client->tls_checked && !(client->system->options & PAPPL_SOPTIONS_NO_TLS))
+  {
+    // See if we need to negotiate a TLS connection...
+    char buf[1];			// First byte from client
+
+    if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
+    {
+      papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Starting HTTPS session.");
+
+      if (!start_tls(client, HTTP_ENCRYPTION_ALWAYS))
+        return (false);
+    }
+  }
+
+  client->tls_checked = true;
+
+  ret = _papplClientProcessHTTP(client);
+
+  // Send anything a resource callback left in the write buffer...
+  if (!_papplClientFlushWrite(client))
+    ret = false;
+
+  _papplClientCleanTempFiles(client);
+
+  return (ret);
+}
+
+
 //
 // 'papplClientRespond()' - Send a regular HTTP response.
 //
@@ -520,9 +640,25 @@ papplClientRespond(
   else
     message[0] = '\0';
 
+  // Discard any content buffered for an earlier response...
+  client->wused = 0;
+
   // Send the HTTP response header...
   httpClearFields(client->http);
-  httpSetField(client->http, HTTP_FIELD_SERVER, papplSystemGetServerHeader(client->system));
+
+  if (client->vary_encoding)
+  {
+    // Caches need to know that compressible resources depend on the
+    // Accept-Encoding header, but libcups has no Vary field, so append it to
+    // the Server header...
+    char	server[1024];		// Server and Vary header values
+
+    snprintf(server, sizeof(server), "%s\r\nVary: Accept-Encoding", papplSystemGetServerHeader(client->system));
+    httpSetField(client->http, HTTP_FIELD_SERVER, server);
+  }
+  else
+    httpSetField(client->http, HTTP_FIELD_SERVER, papplSystemGetServerHeader(client->system));
+
   if (last_modified)
     httpSetField(client->http, HTTP_FIELD_LAST_MODIFIED, httpGetDateString(last_modified));
 
@@ -641,43 +777,207 @@ void *					// O - Exit status
 _papplClientRun(
     pappl_client_t *client)		// I - Client
 {
-  int first_time = 1;			// First time request?
-
-
   // Loop until we are out of requests or timeout (30 seconds)...
   while (httpWait(client->http, 30000))
   {
-    if (first_time && !(client->system->options & PAPPL_SOPTIONS_NO_TLS))
-    {
-      // See if we need to negotiate a TLS connection...
-      char buf[1];			// First byte from client
+    if (!_papplClientProcessRequest(client))
+      break;
+  }
 
-      if (recv(httpGetFd(client->http), buf, 1, MSG_PEEK) == 1 && (!buf[0] || !strchr("DGHOPT", buf[0])))
-      {
-        papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Starting HTTPS session.");
+  // Close the conection to the client and return...
+  _papplClientDelete(client);
+
+  return (NULL);
+}
 
-	if (httpEncryption(client->http, HTTP_ENCRYPTION_ALWAYS))
-	{
-          papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to encrypt connection: %s", cupsLastErrorString());
-	  break;
-        }
 
-        papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Connection now encrypted.");
+//
+// '_papplClientWrite()' - Buffer response data for a client.
+//
+// Small writes are collected in the client's write buffer and sent in
+// segments of up to @code _PAPPL_CLIENT_WBUFFER@ bytes.  Writes that do not
+// fit are sent directly after flushing the buffer.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplClientWrite(
+    pappl_client_t *client,		// I - Client
+    const char     *data,		// I - Data to write
+    size_t         datalen)		// I - Length of data
+{
+  if (datalen > (sizeof(client->wbuffer) - client->wused))
+  {
+    if (!_papplClientFlushWrite(client))
+      return (false);
+
+    if (datalen >= sizeof(client->wbuffer))
+      return (httpWrite2(client->http, data, datalen) >= 0);
+  }
+
+  memcpy(client->wbuffer + client->wused, data, datalen);
+  client->wused += datalen;
+
+  return (true);
+}
+
+
+//
+// 'admit_client()' - Check the connection limits for a new client.
+//
+// Clients over the limits are rejected and deleted.
+//
+
+static bool				// O - `true` if admitted, `false` if rejected
+admit_client(pappl_client_t *client)	// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  int			max_clients,	// Maximum number of connections
+			max_host_clients,
+					// Maximum connections per host
+			max_rate;	// Maximum requests per second
+  _pappl_chost_t	key,		// Search key
+			*host;		// Client host
+  bool			ret = true;	// Return value
+  const char		*reason = NULL;	// Reason for rejection
+
+
+  pthread_rwlock_rdlock(&system->rwlock);
+  max_clients      = system->max_clients;
+  max_host_clients = system->max_host_clients;
+  max_rate         = system->max_request_rate;
+  pthread_rwlock_unlock(&system->rwlock);
+
+  if (max_clients > 0 && _PAPPL_ATOMIC_GET(&system->num_clients) > max_clients)
+  {
+    reject_client(client, "server is busy");
+    return (false);
+  }
+
+  if (max_host_clients <= 0 && max_rate <= 0)
+    return (true);
+
+  pthread_mutex_lock(&system->client_hosts_mutex);
+
+  if (!system->client_hosts)
+    system->client_hosts = cupsArrayNew3((cups_array_func_t)compare_hosts, NULL, NULL, 0, NULL, (cups_afree_func_t)free);
+
+  strlcpy(key.hostname, client->hostname, sizeof(key.hostname));
+
+  if ((host = (_pappl_chost_t *)cupsArrayFind(system->client_hosts, &key)) == NULL)
+  {
+    // Forget idle hosts when the table is full...
+    if (cupsArrayCount(system->client_hosts) >= _PAPPL_CLIENT_MAX_HOSTS)
+    {
+      _pappl_chost_t	*current;	// Current host
+
+      for (current = (_pappl_chost_t *)cupsArrayFirst(system->client_hosts); current; current = (_pappl_chost_t *)cupsArrayNext(system->client_hosts))
+      {
+        if (current->count == 0)
+          cupsArrayRemove(system->client_hosts, current);
       }
+    }
 
-      first_time = 0;
+    if (cupsArrayCount(system->client_hosts) < _PAPPL_CLIENT_MAX_HOSTS && (host = (_pappl_chost_t *)calloc(1, sizeof(_pappl_chost_t))) != NULL)
+    {
+      strlcpy(host->hostname, client->hostname, sizeof(host->hostname));
+      host->tokens      = max_rate;
+      host->tokens_time = _papplTraceTime();
+
+      cupsArrayAdd(system->client_hosts, host);
     }
+  }
 
-    if (!_papplClientProcessHTTP(client))
-      break;
+  if (!host)
+  {
+    // No room to track the host, so it cannot be held to the limits...
+    reason = "too many client hosts";
+    ret    = false;
+  }
+  else if (max_host_clients > 0 && host->count >= max_host_clients)
+  {
+    reason = "too many connections from host";
+    ret    = false;
+  }
+  else
+  {
+    host->count ++;
+    client->host_counted = true;
+  }
+
+  pthread_mutex_unlock(&system->client_hosts_mutex);
+
+  if (!ret)
+    reject_client(client, reason);
+
+  return (ret);
+}
+
+
+//
+// 'check_rate()' - Take a request token for the client's host.
+//
+// Each host gets "max_request_rate" tokens per second, up to one second's
+// worth of tokens.
+//
+
+static bool				// O - `true` if the request can be processed, `false` otherwise
+check_rate(pappl_client_t *client)	// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  int			max_rate;	// Maximum requests per second
+  long long		curtime;	// Current time
+  _pappl_chost_t	key,		// Search key
+			*host;		// Client host
+  bool			ret = true;	// Return value
+
+
+  if (!client->host_counted)
+    return (true);
+
+  pthread_rwlock_rdlock(&system->rwlock);
+  max_rate = system->max_request_rate;
+  pthread_rwlock_unlock(&system->rwlock);
+
+  if (max_rate <= 0)
+    return (true);
+
+  curtime = _papplTraceTime();
 
-    _papplClientCleanTempFiles(client);
+  pthread_mutex_lock(&system->client_hosts_mutex);
+
+  strlcpy(key.hostname, client->hostname, sizeof(key.hostname));
+
+  if ((host = (_pappl_chost_t *)cupsArrayFind(system->client_hosts, &key)) != NULL)
+  {
+    host->tokens += 0.000001 * (curtime - host->tokens_time) * max_rate;
+    if (host->tokens > max_rate)
+      host->tokens = max_rate;
+
+    host->tokens_time = curtime;
+
+    if (host->tokens >= 1.0)
+      host->tokens -= 1.0;
+    else
+      ret = false;
   }
 
-  // Close the conection to the client and return...
-  _papplClientDelete(client);
+  pthread_mutex_unlock(&system->client_hosts_mutex);
 
-  return (NULL);
+  return (ret);
+}
+
+
+//
+// 'compare_hosts()' - Compare two client hosts.
+//
+
+static int				// O - Result of comparison
+compare_hosts(_pappl_chost_t *a,	// I - First host
+              _pappl_chost_t *b)	// I - Second host
+{
+  return (strcmp(a->hostname, b->hostname));
 }
 
 
@@ -737,3 +1037,199 @@ eval_if_modified(
   // Return the evaluation based on the last modified date, time, and size...
   return ((size != 0 && size != (off_t)r->length) || (date != 0 && date < r->last_modified) || (size == 0 && date == 0));
 }
+
+
+//
+// 'get_content_encoding()' - Get the content coding to use for a resource.
+//
+// Only resources flagged as compressible at registration are encoded, and only
+// when the client's Accept-Encoding allows gzip or deflate.  The returned
+// value is passed to @link papplClientRespond@, which lets libcups encode the
+// message body.
+//
+// The body is compressed again for every response.  PAPPL has no zlib
+// dependency of its own, so libcups does the encoding as the body is
+// written.  The flagged resources are small text files, so the cost is
+// small, and clients revalidate with "If-Modified-Since".  Unchanged
+// resources therefore get a "304 Not Modified" response that is never
+// compressed.
+//
+
+static const char *			// O - Content coding or `NULL` for identity
+get_content_encoding(
+    pappl_client_t    *client,		// I - Client
+    _pappl_resource_t *r)		// I - Resource
+{
+  const char	*coding;		// Content coding
+
+
+  if (!r->compress || (coding = httpGetContentEncoding(client->http)) == NULL)
+    return (NULL);
+
+  if (!strcmp(coding, "gzip") || !strcmp(coding, "x-gzip") || !strcmp(coding, "deflate") || !strcmp(coding, "x-deflate"))
+    return (coding);
+  else
+    return (NULL);
+}
+
+
+//
+// 'reject_client()' - Reject a new client connection.
+//
+// A canned "503 Service Unavailable" response is written directly to the
+// socket so that a rejected client costs no request parsing or TLS handshake.
+// The response is only sent when the client has started a plain HTTP request,
+// since a TLS client cannot read it - other connections are just closed.
+//
+
+static void
+reject_client(pappl_client_t *client,	// I - Client
+              const char     *reason)	// I - Reason for rejection
+{
+  static const char response[] =	// Canned response
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n"
+    "Retry-After: 1\r\n"
+    "\r\n";
+  char		buf[1];			// First byte from client
+
+
+  papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Rejecting connection from '%s': %s", client->hostname, reason);
+
+  _PAPPL_ATOMIC_ADD(&client->system->num_rejected, 1);
+
+  if ((client->system->options & PAPPL_SOPTIONS_NO_TLS) || (recv(httpGetFd(client->http), buf, 1, MSG_PEEK | MSG_DONTWAIT) == 1 && buf[0] && strchr("DGHOPT", buf[0])))
+  {
+#ifdef MSG_NOSIGNAL
+    send(httpGetFd(client->http), response, sizeof(response) - 1, MSG_NOSIGNAL);
+#else
+    send(httpGetFd(client->http), response, sizeof(response) - 1, 0);
+#endif // MSG_NOSIGNAL
+  }
+
+  _papplClientDelete(client);
+}
+
+
+//
+// 'remove_host()' - Remove a client connection from its host's count.
+//
+// Idle hosts are kept so that their request rate carries over to the next
+// connection.
+//
+
+static void
+remove_host(pappl_client_t *client)	// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_chost_t	key,		// Search key
+			*host;		// Client host
+
+
+  if (!client->host_counted)
+    return;
+
+  pthread_mutex_lock(&system->client_hosts_mutex);
+
+  strlcpy(key.hostname, client->hostname, sizeof(key.hostname));
+
+  if ((host = (_pappl_chost_t *)cupsArrayFind(system->client_hosts, &key)) != NULL && host->count > 0)
+    host->count --;
+
+  pthread_mutex_unlock(&system->client_hosts_mutex);
+
+  client->host_counted = false;
+}
+
+
+//
+// 'send_file()' - Send the contents of a resource file.
+//
+// Large files sent without content coding are read in 64k pieces, which
+// `httpWrite2` writes directly to the connection without copying them through
+// the HTTP write buffer.  Everything else is copied through a small read
+// buffer.  Files are read rather than mapped into memory, since a mapped file
+// that is truncated while it is being sent raises `SIGBUS`.
+//
+
+static bool				// O - `true` on success, `false` on error
+send_file(pappl_client_t    *client,	// I - Client
+          _pappl_resource_t *r,		// I - Resource
+          int               fd)		// I - Resource file descriptor
+{
+  const char	*coding;		// Content coding, if any
+  char		buffer[8192];		// Copy buffer
+  ssize_t	bytes;			// Bytes read/written
+  struct stat	fileinfo;		// File information
+  char		*large;			// Large copy buffer
+
+
+  if ((coding = get_content_encoding(client, r)) == NULL && !fstat(fd, &fileinfo) && fileinfo.st_size >= _PAPPL_CLIENT_BIG_FILE && (large = malloc(_PAPPL_CLIENT_BIG_CHUNK)) != NULL)
+  {
+    size_t	length;			// Remaining length
+    bool	ret;			// Return value
+
+    // Send the current size of the file rather than the size at registration.
+    // If the file gets shorter, the response is cut short and the connection
+    // is closed...
+    ret = papplClientRespond(client, HTTP_STATUS_OK, NULL, r->format, r->last_modified, (size_t)fileinfo.st_size);
+
+    for (length = (size_t)fileinfo.st_size; ret && length > 0; length -= (size_t)bytes)
+    {
+      if ((bytes = read(fd, large, length > _PAPPL_CLIENT_BIG_CHUNK ? _PAPPL_CLIENT_BIG_CHUNK : length)) <= 0)
+      {
+        papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to read '%s': %s", r->filename, bytes < 0 ? strerror(errno) : "File truncated.");
+        ret = false;
+      }
+      else if (httpWrite2(client->http, large, (size_t)bytes) < bytes)
+      {
+        ret = false;
+      }
+    }
+
+    free(large);
+
+    return (ret);
+  }
+
+  if (!papplClientRespond(client, HTTP_STATUS_OK, coding, r->format, r->last_modified, 0))
+    return (false);
+
+  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+  {
+    if (httpWrite2(client->http, buffer, (size_t)bytes) < 0)
+      return (false);
+  }
+
+  return (httpWrite2(client->http, "", 0) >= 0);
+}
+
+
+//
+// 'start_tls()' - Negotiate a TLS session and record the handshake time.
+//
+
+static bool				// O - `true` on success, `false` on error
+start_tls(pappl_client_t    *client,	// I - Client
+          http_encryption_t e)		// I - Encryption mode
+{
+  long long	start = _papplTraceTime(),
+					// Start of handshake
+		usecs;			// Duration of handshake
+  bool		ret;			// Return value
+
+
+  ret   = !httpEncryption(client->http, e);
+  usecs = _papplTraceTime() - start;
+
+  _papplSystemAddTLSMetrics(client->system, ret, usecs > 0 ? (size_t)usecs : 0);
+
+  if (ret)
+    papplLogClient(client, PAPPL_LOGLEVEL_INFO, "Connection now encrypted (%.3fs handshake).", usecs * 0.000001);
+  else
+    papplLogClient(client, PAPPL_LOGLEVEL_ERROR, "Unable to encrypt connection: %s", cupsLastErrorString());
+
+  return (ret);
+}
@@ -0,0 +1,406 @@
+//
+// Line compression functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "device-private.h"
+#include <stdint.h>
+
+
+//
+// Local macros...
+//
+
+#define PAPPL_ONES	0x0101010101010101ULL
+					// Each byte set to 1
+#define PAPPL_HIGHS	0x8080808080808080ULL
+					// High bit of each byte
+#define PAPPL_HASZERO(v) (((v) - PAPPL_ONES) & ~(v) & PAPPL_HIGHS)
+					// Does any byte in "v" equal 0?
+
+
+//
+// Local functions...
+//
+
+static size_t	pappl_deltarow(unsigned char *buffer, const unsigned char *line, const unsigned char *prev, size_t bytes);
+static inline uint64_t pappl_load(const unsigned char *p);
+static size_t	pappl_packbits(unsigned char *buffer, const unsigned char *line, size_t bytes);
+static size_t	pappl_zpl(unsigned char *buffer, const unsigned char *line, const unsigned char *prev, size_t bytes);
+static inline unsigned char *pappl_zpl_run(unsigned char *bufptr, char digit, size_t count);
+
+
+//
+// 'papplDeviceCompressLine()' - Compress a line of raster data.
+//
+// This function compresses "bytes" bytes of raster data using the specified
+// compression method and stores the result in "buffer", which must hold at
+// least `PAPPL_DEVCOMP_BUFSIZE(bytes)` bytes.
+//
+// `PAPPL_DEVCOMP_PACKBITS` uses the PackBits run-length encoding of TIFF and
+// PCL compression mode 2.
+//
+// `PAPPL_DEVCOMP_DELTAROW` uses PCL compression mode 3, which only encodes the
+// bytes that differ from the previous line "prev" (`NULL` for a line of zero
+// bytes).  A line that is identical to the previous line produces no data.
+//
+// `PAPPL_DEVCOMP_ZPL` produces ZPL compressed ASCII hexadecimal data for the
+// "^GF" and "~DG" commands.  Lines ending with zero bytes are terminated by a
+// ",", and a line that is identical to the previous line "prev" is encoded as
+// ":".
+//
+// @since PAPPL 1.1@
+//
+
+size_t					// O - Number of bytes in compressed line
+papplDeviceCompressLine(
+    pappl_devcomp_t     comp,		// I - Compression method
+    const unsigned char *line,		// I - Line to compress
+    const unsigned char *prev,		// I - Previous line or `NULL` for none
+    size_t              bytes,		// I - Number of bytes in line
+    unsigned char       *buffer)	// I - Output buffer
+{
+  if (!line || !buffer || bytes == 0)
+    return (0);
+
+  switch (comp)
+  {
+    case PAPPL_DEVCOMP_PACKBITS :
+        return (pappl_packbits(buffer, line, bytes));
+
+    case PAPPL_DEVCOMP_DELTAROW :
+        return (pappl_deltarow(buffer, line, prev, bytes));
+
+    case PAPPL_DEVCOMP_ZPL :
+        return (pappl_zpl(buffer, line, prev, bytes));
+
+    default :
+        memcpy(buffer, line, bytes);
+        return (bytes);
+  }
+}
+
+
+//
+// 'papplDeviceIsBlankLine()' - Determine whether a line of raster data is blank.
+//
+// This function returns `true` when every byte in the line is equal to
+// "blank", typically `0` for bitmaps and black and `255` for grayscale and RGB.
+// Drivers can use this to skip blank lines with a printer command instead of
+// sending them.
+//
+// @since PAPPL 1.1@
+//
+
+bool					// O - `true` if blank, `false` otherwise
+papplDeviceIsBlankLine(
+    const unsigned char *line,		// I - Line
+    size_t              bytes,		// I - Number of bytes in line
+    unsigned char       blank)		// I - Blank byte value
+{
+  // Comparing the line with itself offset by one byte lets memcmp use its
+  // vectorized loop...
+  if (!line || bytes == 0)
+    return (true);
+  else
+    return (line[0] == blank && (bytes == 1 || !memcmp(line, line + 1, bytes - 1)));
+}
+
+
+//
+// 'pappl_deltarow()' - Compress a line using PCL delta row compression.
+//
+
+static size_t				// O - Number of bytes in compressed line
+pappl_deltarow(
+    unsigned char       *buffer,	// I - Output buffer
+    const unsigned char *line,		// I - Line to compress
+    const unsigned char *prev,		// I - Previous line or `NULL`
+    size_t              bytes)		// I - Number of bytes in line
+{
+  unsigned char	*bufptr = buffer;	// Pointer into buffer
+  size_t	i,			// Current byte
+		last = 0,		// End of last replacement
+		start,			// Start of replacement
+		count,			// Number of bytes to replace
+		offset;			// Offset from last replacement
+
+
+  for (i = 0; i < bytes;)
+  {
+    // Skip unchanged bytes, eight at a time when possible...
+    if (prev)
+    {
+      while ((i + 8) <= bytes && pappl_load(line + i) == pappl_load(prev + i))
+        i += 8;
+
+      while (i < bytes && line[i] == prev[i])
+        i ++;
+    }
+    else
+    {
+      while ((i + 8) <= bytes && !pappl_load(line + i))
+        i += 8;
+
+      while (i < bytes && !line[i])
+        i ++;
+    }
+
+    if (i >= bytes)
+      break;
+
+    // Replace up to 8 changed bytes...
+    for (start = i, count = 1, i ++; count < 8 && i < bytes && line[i] != (prev ? prev[i] : 0); count ++, i ++);
+
+    offset  = start - last;
+    last    = i;
+
+    if (offset < 31)
+      *bufptr++ = (unsigned char)(((count - 1) << 5) | offset);
+    else
+    {
+      *bufptr++ = (unsigned char)(((count - 1) << 5) | 31);
+
+      for (offset -= 31; offset >= 255; offset -= 255)
+        *bufptr++ = 255;
+
+      *bufptr++ = (unsigned char)offset;
+    }
+
+    memcpy(bufptr, line + start, count);
+    bufptr += count;
+  }
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'pappl_load()' - Load 8 bytes from any address.
+//
+
+static inline uint64_t			// O - Bytes
+pappl_load(const unsigned char *p)	// I - Pointer to bytes
+{
+  uint64_t	v;			// Bytes
+
+
+  memcpy(&v, p, sizeof(v));
+
+  return (v);
+}
+
+
+//
+// 'pappl_packbits()' - Compress a line using PackBits.
+//
+// Runs of two or more bytes are repeated, while literal runs are only broken
+// by runs of three or more bytes since a shorter run saves nothing.  Both
+// scans look at eight bytes at a time.
+//
+
+static size_t				// O - Number of bytes in compressed line
+pappl_packbits(
+    unsigned char       *buffer,	// I - Output buffer
+    const unsigned char *line,		// I - Line to compress
+    size_t              bytes)		// I - Number of bytes in line
+{
+  unsigned char		*bufptr = buffer;
+					// Pointer into buffer
+  const unsigned char	*start,		// Start of current run
+			*ptr,		// Pointer into line
+			*max,		// Maximum end of run
+			*end = line + bytes;
+					// End of line
+  uint64_t		v;		// Repeated byte
+  size_t		count;		// Bytes in run
+
+
+  for (start = line; start < end; start = ptr)
+  {
+    max = (end - start) > 128 ? start + 128 : end;
+
+    if ((start + 1) < end && start[0] == start[1])
+    {
+      // Repeated run...
+      v = PAPPL_ONES * start[0];
+
+      for (ptr = start + 2; (ptr + 8) <= max && pappl_load(ptr) == v; ptr += 8);
+
+      while (ptr < max && *ptr == *start)
+        ptr ++;
+
+      count     = (size_t)(ptr - start);
+      *bufptr++ = (unsigned char)(257 - count);
+      *bufptr++ = *start;
+    }
+    else
+    {
+      // Literal run, ending before three repeated bytes...
+      for (ptr = start + 1; (ptr + 10) <= end && (ptr + 8) <= max; ptr += 8)
+      {
+        uint64_t a = pappl_load(ptr),	// Bytes at ptr
+		 b = pappl_load(ptr + 1),
+					// Bytes at ptr + 1
+		 c = pappl_load(ptr + 2);
+					// Bytes at ptr + 2
+
+        if (PAPPL_HASZERO((a ^ b) | (b ^ c)))
+          break;
+      }
+
+      while (ptr < max && ((ptr + 2) >= end || ptr[0] != ptr[1] || ptr[1] != ptr[2]))
+        ptr ++;
+
+      count     = (size_t)(ptr - start);
+      *bufptr++ = (unsigned char)(count - 1);
+
+      memcpy(bufptr, start, count);
+      bufptr += count;
+    }
+  }
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'pappl_zpl()' - Compress a line using ZPL compressed ASCII hex.
+//
+
+static size_t				// O - Number of bytes in compressed line
+pappl_zpl(
+    unsigned char       *buffer,	// I - Output buffer
+    const unsigned char *line,		// I - Line to compress
+    const unsigned char *prev,		// I - Previous line or `NULL`
+    size_t              bytes)		// I - Number of bytes in line
+{
+  unsigned char	*bufptr = buffer;	// Pointer into buffer
+  size_t	i,			// Current byte
+		last,			// End of non-zero bytes
+		count;			// Number of digits in run
+  char		digit;			// Current digit
+  static const char hex[] = "0123456789ABCDEF";
+					// Hex digits
+
+
+  if (prev && !memcmp(line, prev, bytes))
+  {
+    // Repeat the previous line...
+    *bufptr++ = ':';
+    return (1);
+  }
+
+  // Find the end of the non-zero bytes...
+  for (last = bytes; last >= 8 && !pappl_load(line + last - 8); last -= 8);
+
+  while (last > 0 && !line[last - 1])
+    last --;
+
+  // Encode runs of hex digits...
+  for (i = 0, count = 0, digit = 0; i < last; i ++)
+  {
+    if (line[i] == 0x00 || line[i] == 0xff)
+    {
+      // Two identical digits, skip ahead through a run of these bytes...
+      size_t	j;			// End of run
+      uint64_t	v = PAPPL_ONES * line[i];
+					// Repeated byte
+
+      for (j = i + 1; (j + 8) <= last && pappl_load(line + j) == v; j += 8);
+
+      while (j < last && line[j] == line[i])
+        j ++;
+
+      if (digit != hex[line[i] & 15])
+      {
+        bufptr = pappl_zpl_run(bufptr, digit, count);
+        digit  = hex[line[i] & 15];
+        count  = 0;
+      }
+
+      count += 2 * (j - i);
+      i     = j - 1;
+    }
+    else
+    {
+      if (digit != hex[line[i] >> 4])
+      {
+        bufptr = pappl_zpl_run(bufptr, digit, count);
+        digit  = hex[line[i] >> 4];
+        count  = 0;
+      }
+
+      count ++;
+
+      if (digit != hex[line[i] & 15])
+      {
+        bufptr = pappl_zpl_run(bufptr, digit, count);
+        digit  = hex[line[i] & 15];
+        count  = 0;
+      }
+
+      count ++;
+    }
+  }
+
+  bufptr = pappl_zpl_run(bufptr, digit, count);
+
+  if (last < bytes)
+    *bufptr++ = ',';
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'pappl_zpl_run()' - Add a run of hex digits to a ZPL line.
+//
+// Repeat counts are the sum of "g" to "z" (20 to 400) and "G" to "Y" (1 to 19)
+// characters preceding the digit.
+//
+
+static inline unsigned char *		// O - Next byte in buffer
+pappl_zpl_run(unsigned char *bufptr,	// I - Pointer into buffer
+              char          digit,	// I - Hex digit
+              size_t        count)	// I - Number of digits
+{
+  if (count == 0)
+    return (bufptr);
+
+  if (count < 3)
+  {
+    // Short runs are smaller without a repeat count...
+    while (count > 0)
+    {
+      *bufptr++ = (unsigned char)digit;
+      count --;
+    }
+
+    return (bufptr);
+  }
+
+  for (; count >= 400; count -= 400)
+    *bufptr++ = 'z';
+
+  if (count >= 20)
+  {
+    *bufptr++ = (unsigned char)('f' + count / 20);
+    count %= 20;
+  }
+
+  if (count > 0)
+    *bufptr++ = (unsigned char)('F' + count);
+
+  *bufptr++ = (unsigned char)digit;
+
+  return (bufptr);
+}
@@ -1,7 +1,7 @@
 //
 // File device support code for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2007-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -22,6 +22,7 @@
 static void	pappl_file_close(pappl_device_t *device);
 static bool	pappl_file_open(pappl_device_t *device, const char *device_uri, const char *name);
 static ssize_t	pappl_file_write(pappl_device_t *device, const void *buffer, size_t bytes);
+static ssize_t	pappl_file_writev(pappl_device_t *device, const pappl_iovec_t *iov, int iovcnt);
 
 
 //
@@ -31,7 +32,7 @@ static ssize_t	pappl_file_write(pappl_device_t *device, const void *buffer, size
 void
 _papplDeviceAddFileScheme(void)
 {
-  papplDeviceAddScheme("file", PAPPL_DEVTYPE_FILE, NULL, pappl_file_open, pappl_file_close, NULL, pappl_file_write, NULL, NULL);
+  papplDeviceAddScheme2("file", PAPPL_DEVTYPE_FILE, NULL, pappl_file_open, pappl_file_close, NULL, pappl_file_write, pappl_file_writev, NULL, NULL);
 }
 
 
@@ -188,3 +189,40 @@ pappl_file_write(pappl_device_t *device,// I - Device
 
   return (count);
 }
+
+
+//
+// 'pappl_file_writev()' - Write multiple buffers to a file.
+//
+
+static ssize_t				// O - Bytes written
+pappl_file_writev(
+    pappl_device_t      *device,	// I - Device
+    const pappl_iovec_t *iov,		// I - Buffers to write
+    int                 iovcnt)		// I - Number of buffers
+{
+  int		*fd;			// File descriptor
+#if _WIN32
+  ssize_t	count,			// Total bytes written
+		written;		// Bytes written for this buffer
+#endif // _WIN32
+
+
+  // Make sure we have a valid file descriptor...
+  if ((fd = papplDeviceGetData(device)) == NULL || *fd < 0)
+    return (-1);
+
+#if _WIN32
+  // No writev on Windows, write each buffer in turn...
+  for (count = 0; iovcnt > 0; iovcnt --, iov ++, count += written)
+  {
+    if ((written = pappl_file_write(device, iov->buffer, iov->bytes)) < 0)
+      return (-1);
+  }
+
+  return (count);
+
+#else
+  return (_papplDeviceWritevFd(*fd, iov, iovcnt));
+#endif // _WIN32
+}
@@ -22,6 +22,17 @@
 #endif // !_WIN32
 
 
+//
+// Constants...
+//
+
+#define _PAPPL_DNSSD_CACHE_TTL	300	// Seconds to cache resolved services
+#define _PAPPL_DNSSD_TIMEOUT	30	// Seconds to wait for a resolve
+#define _PAPPL_SNMP_CACHE_TTL	60	// Seconds to cache SNMP scan results
+#define _PAPPL_SNMP_STATUS_TTL	5	// Seconds to cache SNMP status values
+#define _PAPPL_SNMP_TIMEOUT	2	// Seconds to wait for SNMP responses
+
+
 //
 // Local types...
 //
@@ -32,8 +43,43 @@ typedef struct _pappl_socket_s		// Socket device data
   char			*host;			// Hostname
   int			port;			// Port number
   http_addrlist_t	*list;			// Address list
+  int			snmp_fd;		// SNMP socket for status queries or -1
+  int			snmp_version;		// SNMP version for status queries
+  bool			snmp_failed;		// Did the printer not respond to SNMP?
+  time_t		snmp_time;		// Time of last SNMP status query
+  pappl_preason_t	snmp_reasons;		// Reasons from last SNMP status query
 } _pappl_socket_t;
 
+typedef struct _pappl_socket_snmp_s	// SNMP printer status data
+{
+  pappl_preason_t	reasons;		// "printer-state-reasons" values
+  int			num_supplies;		// Number of supplies
+  int			classes[PAPPL_MAX_SUPPLY],
+						// prtMarkerSuppliesClass values
+			levels[PAPPL_MAX_SUPPLY],
+						// prtMarkerSuppliesLevel values
+			max_capacities[PAPPL_MAX_SUPPLY];
+						// prtMarkerSuppliesMaxCapacity values
+} _pappl_socket_snmp_t;
+
+#ifdef HAVE_DNSSD
+typedef struct _pappl_dnssd_res_s	// DNS-SD resolve data
+{
+  pthread_mutex_t	mutex;			// Mutex for resolve
+  pthread_cond_t	cond;			// Condition for resolve
+  char			*host;			// Hostname or `NULL` if not resolved
+  int			port;			// Port number
+} _pappl_dnssd_res_t;
+
+typedef struct _pappl_dnssd_cache_s	// DNS-SD resolve cache entry
+{
+  char			*uri,			// Device URI
+			*host;			// Hostname
+  int			port;			// Port number
+  time_t		expires;		// Expiration time
+} _pappl_dnssd_cache_t;
+#endif // HAVE_DNSSD
+
 typedef struct _pappl_dns_sd_dev_t	// DNS-SD browse data
 {
 #ifdef HAVE_MDNSRESPONDER
@@ -57,6 +103,9 @@ typedef struct _pappl_snmp_dev_s	// SNMP browse data
 		*uri,				// Device URI
 		*device_id;			// IEEE-1284 device id
   int		port;				// Port number
+  int		pending;			// Number of pending queries
+  time_t	deadline;			// Time to stop waiting for queries
+  bool		reported;			// Has the device been reported?
 } _pappl_snmp_dev_t;
 
 typedef enum _pappl_snmp_query_e	// SNMP query request IDs for each field
@@ -68,6 +117,24 @@ typedef enum _pappl_snmp_query_e	// SNMP query request IDs for each field
 } _pappl_snmp_query_t;
 
 
+//
+// Local globals...
+//
+
+static cups_array_t	*pappl_snmp_cache = NULL;
+					// Devices from the last SNMP scan
+static time_t		pappl_snmp_cache_time = 0;
+					// Time of the last SNMP scan
+static pthread_mutex_t	pappl_snmp_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for SNMP scan cache
+#ifdef HAVE_DNSSD
+static cups_array_t	*pappl_dnssd_cache = NULL;
+					// Cache of resolved DNS-SD services
+static pthread_mutex_t	pappl_dnssd_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for resolve cache
+#endif // HAVE_DNSSD
+
+
 //
 // Local functions...
 //
@@ -82,28 +149,35 @@ static void		pappl_dnssd_browse_cb(AvahiServiceBrowser *browser, AvahiIfIndex in
 static void		pappl_dnssd_query_cb(AvahiRecordBrowser *browser, AvahiIfIndex interface, AvahiProtocol protocol, AvahiBrowserEvent event, const char *name, uint16_t rrclass, uint16_t rrtype, const void *rdata, size_t rdlen, AvahiLookupResultFlags flags, void *context);
 static void		pappl_dnssd_resolve_cb(AvahiServiceResolver *resolver, AvahiIfIndex interface, AvahiProtocol protocol, AvahiResolverEvent event, const char *name, const char *type, const char *domain, const char *host_name, const AvahiAddress *address, uint16_t port, AvahiStringList *txt, AvahiLookupResultFlags flags, void *context);
 #  endif // HAVE_MDNSRESPONDER
+static int		pappl_dnssd_compare_cache(_pappl_dnssd_cache_t *a, _pappl_dnssd_cache_t *b);
 static int		pappl_dnssd_compare_devices(_pappl_dns_sd_dev_t *a, _pappl_dns_sd_dev_t *b);
 static void		pappl_dnssd_free(_pappl_dns_sd_dev_t *d);
+static void		pappl_dnssd_free_cache(_pappl_dnssd_cache_t *c);
 static _pappl_dns_sd_dev_t *pappl_dnssd_get_device(cups_array_t *devices, const char *serviceName, const char *replyDomain);
 static bool		pappl_dnssd_list(pappl_device_cb_t cb, void *data, pappl_deverror_cb_t err_cb, void *err_data);
+static bool		pappl_dnssd_resolve(pappl_device_t *device, const char *device_uri, const char *service, bool use_cache, bool *cached, _pappl_socket_t *sock);
 static void		pappl_dnssd_unescape(char *dst, const char *src, size_t dstsize);
 #endif // HAVE_DNSSD
 
 
 static int		pappl_snmp_compare_devices(_pappl_snmp_dev_t *a, _pappl_snmp_dev_t *b);
-static bool		pappl_snmp_find(pappl_device_cb_t cb, void *data, _pappl_socket_t *sock, pappl_deverror_cb_t err_cb, void *err_data);
+static bool		pappl_snmp_find(pappl_device_cb_t cb, void *data, _pappl_socket_t *sock, bool use_cache, bool *cached, pappl_deverror_cb_t err_cb, void *err_data);
 static void		pappl_snmp_free(_pappl_snmp_dev_t *d);
 static http_addrlist_t	*pappl_snmp_get_interface_addresses(void);
 static bool		pappl_snmp_list(pappl_device_cb_t cb, void *data, pappl_deverror_cb_t err_cb, void *err_data);
 static bool		pappl_snmp_open_cb(const char *device_info, const char *device_uri, const char *device_id, void *data);
-static void		pappl_snmp_read_response(cups_array_t *devices, int fd, pappl_deverror_cb_t err_cb, void *err_data);
+static void		pappl_snmp_process_response(cups_array_t *devices, int fd, _pappl_snmp_t *packet, pappl_deverror_cb_t err_cb, void *err_data);
+static bool		pappl_snmp_report(_pappl_snmp_dev_t *device, pappl_device_cb_t cb, void *data, _pappl_socket_t *sock);
 
 static void		pappl_socket_close(pappl_device_t *device);
 static char		*pappl_socket_getid(pappl_device_t *device, char *buffer, size_t bufsize);
 static bool		pappl_socket_open(pappl_device_t *device, const char *device_uri, const char *name);
 static ssize_t		pappl_socket_read(pappl_device_t *device, void *buffer, size_t bytes);
+static void		pappl_socket_snmp_cb(_pappl_snmp_t *packet, _pappl_socket_snmp_t *status);
+static pappl_preason_t	pappl_socket_snmp_status(_pappl_socket_t *sock);
 static pappl_preason_t	pappl_socket_status(pappl_device_t *device);
 static ssize_t		pappl_socket_write(pappl_device_t *device, const void *buffer, size_t bytes);
+static ssize_t		pappl_socket_writev(pappl_device_t *device, const pappl_iovec_t *iov, int iovcnt);
 
 
 //
@@ -114,10 +188,10 @@ void
 _papplDeviceAddNetworkSchemes(void)
 {
 #ifdef HAVE_DNSSD
-  papplDeviceAddScheme("dnssd", PAPPL_DEVTYPE_DNS_SD, pappl_dnssd_list, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_status, pappl_socket_getid);
+  papplDeviceAddScheme2("dnssd", PAPPL_DEVTYPE_DNS_SD, pappl_dnssd_list, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_writev, pappl_socket_status, pappl_socket_getid);
 #endif // HAVE_DNSSD
-  papplDeviceAddScheme("snmp", PAPPL_DEVTYPE_SNMP, pappl_snmp_list, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_status, pappl_socket_getid);
-  papplDeviceAddScheme("socket", PAPPL_DEVTYPE_SOCKET, NULL, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_status, pappl_socket_getid);
+  papplDeviceAddScheme2("snmp", PAPPL_DEVTYPE_SNMP, pappl_snmp_list, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_writev, pappl_socket_status, pappl_socket_getid);
+  papplDeviceAddScheme2("socket", PAPPL_DEVTYPE_SOCKET, NULL, pappl_socket_open, pappl_socket_close, pappl_socket_read, pappl_socket_write, pappl_socket_writev, pappl_socket_status, pappl_socket_getid);
 }
 
 
@@ -176,6 +250,19 @@ pappl_dnssd_browse_cb(
 #  endif // HAVE_MDNSRESPONDER
 
 
+//
+// 'pappl_dnssd_compare_cache()' - Compare two resolve cache entries.
+//
+
+static int				// O - Result of comparison
+pappl_dnssd_compare_cache(
+    _pappl_dnssd_cache_t *a,		// I - First entry
+    _pappl_dnssd_cache_t *b)		// I - Second entry
+{
+  return (strcmp(a->uri, b->uri));
+}
+
+
 //
 // 'pappl_dnssd_compare_devices()' - Compare two DNS-SD devices.
 //
@@ -209,6 +296,20 @@ pappl_dnssd_free(_pappl_dns_sd_dev_t *d)// I - Device
 }
 
 
+//
+// 'pappl_dnssd_free_cache()' - Free a resolve cache entry.
+//
+
+static void
+pappl_dnssd_free_cache(
+    _pappl_dnssd_cache_t *c)		// I - Cache entry
+{
+  free(c->uri);
+  free(c->host);
+  free(c);
+}
+
+
 //
 // 'pappl_dnssd_get_device()' - Create or update a DNS-SD device.
 //
@@ -599,6 +700,177 @@ pappl_dnssd_query_cb(
 }
 
 
+//
+// 'pappl_dnssd_resolve()' - Resolve a DNS-SD service to a hostname and port.
+//
+// Resolved services are cached for a few minutes so that consecutive jobs to
+// the same printer don't need to wait for another resolve.
+//
+
+static bool				// O - `true` on success, `false` on error
+pappl_dnssd_resolve(
+    pappl_device_t  *device,		// I - Device
+    const char      *device_uri,	// I - Device URI
+    const char      *service,		// I - Service instance name
+    bool            use_cache,		// I - Use a cached result?
+    bool            *cached,		// O - `true` if the result came from the cache
+    _pappl_socket_t *sock)		// I - Socket device
+{
+  _pappl_dnssd_cache_t	*cache,		// Cache entry
+			ckey;		// Search key
+  time_t		curtime;	// Current time
+  char			fullname[256],	// Copy of service instance name
+			srvname[256],	// Service name
+			*type,		// Service type
+			*domain;	// Domain
+  _pappl_dns_sd_t	master;		// DNS-SD context
+  _pappl_dnssd_res_t	res;		// Resolve data
+  struct timeval	curtv;		// Current time of day
+  struct timespec	timeout;	// Timeout for resolve
+#  ifdef HAVE_MDNSRESPONDER
+  int			error;		// Error code, if any
+  DNSServiceRef		resolver;	// Resolver
+#  else
+  AvahiServiceResolver	*resolver;	// Resolver
+#  endif // HAVE_MDNSRESPONDER
+
+
+  // See if we have resolved this service recently...
+  *cached  = false;
+  curtime  = time(NULL);
+  ckey.uri = (char *)device_uri;
+
+  pthread_mutex_lock(&pappl_dnssd_cache_mutex);
+
+  if ((cache = (_pappl_dnssd_cache_t *)cupsArrayFind(pappl_dnssd_cache, &ckey)) != NULL)
+  {
+    if (use_cache && cache->expires > curtime)
+    {
+      sock->host = strdup(cache->host);
+      sock->port = cache->port;
+      *cached    = true;
+
+      pthread_mutex_unlock(&pappl_dnssd_cache_mutex);
+
+      return (sock->host != NULL);
+    }
+
+    cupsArrayRemove(pappl_dnssd_cache, cache);
+  }
+
+  pthread_mutex_unlock(&pappl_dnssd_cache_mutex);
+
+  // Separate the service name, type, and domain...
+  strlcpy(fullname, service, sizeof(fullname));
+
+  if ((domain = strstr(fullname, "._tcp.")) == NULL)
+  {
+    papplDeviceError(device, "Bad DNS-SD service name in '%s'.", device_uri);
+    return (false);
+  }
+
+  // Truncate host at domain portion...
+  domain += 5;
+  *domain++ = '\0';
+
+  // Then separate the service type portion...
+  type = strstr(fullname, "._");
+  *type ++ = '\0';
+
+  // Unescape the service name...
+  pappl_dnssd_unescape(srvname, fullname, sizeof(srvname));
+
+  // Start the resolve...
+  memset(&res, 0, sizeof(res));
+  pthread_mutex_init(&res.mutex, NULL);
+  pthread_cond_init(&res.cond, NULL);
+
+  master = _papplDNSSDInit(NULL);
+
+#  ifdef HAVE_MDNSRESPONDER
+  resolver = master;
+  if ((error = DNSServiceResolve(&resolver, kDNSServiceFlagsShareConnection, 0, srvname, type, domain, (DNSServiceResolveReply)pappl_dnssd_resolve_cb, &res)) != kDNSServiceErr_NoError)
+  {
+    papplDeviceError(device, "Unable to resolve '%s': %s", device_uri, _papplDNSSDStrError(error));
+    goto done;
+  }
+#  else
+  _papplDNSSDLock();
+
+  if ((resolver = avahi_service_resolver_new(master, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, srvname, type, domain, AVAHI_PROTO_UNSPEC, 0, (AvahiServiceResolverCallback)pappl_dnssd_resolve_cb, &res)) == NULL)
+  {
+    papplDeviceError(device, "Unable to resolve '%s'.", device_uri);
+    _papplDNSSDUnlock();
+    goto done;
+  }
+
+  _papplDNSSDUnlock();
+#  endif // HAVE_MDNSRESPONDER
+
+  // Wait for the resolve to complete...
+  gettimeofday(&curtv, NULL);
+  timeout.tv_sec  = curtv.tv_sec + _PAPPL_DNSSD_TIMEOUT;
+  timeout.tv_nsec = curtv.tv_usec * 1000;
+
+  pthread_mutex_lock(&res.mutex);
+  while (!res.host)
+  {
+    if (pthread_cond_timedwait(&res.cond, &res.mutex, &timeout) == ETIMEDOUT)
+      break;
+  }
+  pthread_mutex_unlock(&res.mutex);
+
+  // Stop the resolve...
+#  ifdef HAVE_MDNSRESPONDER
+  DNSServiceRefDeallocate(resolver);
+#  else
+  _papplDNSSDLock();
+  avahi_service_resolver_free(resolver);
+  _papplDNSSDUnlock();
+#  endif // HAVE_MDNSRESPONDER
+
+  if (!res.host)
+  {
+    papplDeviceError(device, "Unable to resolve '%s'.", device_uri);
+    goto done;
+  }
+
+  // Cache the result...
+  pthread_mutex_lock(&pappl_dnssd_cache_mutex);
+
+  if (!pappl_dnssd_cache)
+    pappl_dnssd_cache = cupsArrayNew3((cups_array_func_t)pappl_dnssd_compare_cache, NULL, NULL, 0, NULL, (cups_afree_func_t)pappl_dnssd_free_cache);
+
+  if ((cache = (_pappl_dnssd_cache_t *)cupsArrayFind(pappl_dnssd_cache, &ckey)) != NULL)
+    cupsArrayRemove(pappl_dnssd_cache, cache);
+
+  if ((cache = (_pappl_dnssd_cache_t *)calloc(1, sizeof(_pappl_dnssd_cache_t))) != NULL)
+  {
+    cache->uri     = strdup(device_uri);
+    cache->host    = strdup(res.host);
+    cache->port    = res.port;
+    cache->expires = curtime + _PAPPL_DNSSD_CACHE_TTL;
+
+    if (!cache->uri || !cache->host || !cupsArrayAdd(pappl_dnssd_cache, cache))
+      pappl_dnssd_free_cache(cache);
+  }
+
+  pthread_mutex_unlock(&pappl_dnssd_cache_mutex);
+
+  sock->host = res.host;
+  sock->port = res.port;
+  res.host   = NULL;
+
+  done:
+
+  free(res.host);
+  pthread_cond_destroy(&res.cond);
+  pthread_mutex_destroy(&res.mutex);
+
+  return (sock->host != NULL);
+}
+
+
 //
 // 'pappl_dnssd_resolve_cb()' - Resolve a DNS-SD service.
 //
@@ -625,11 +897,19 @@ pappl_dnssd_resolve_cb(
 
   if (errorCode == kDNSServiceErr_NoError && (flags & kDNSServiceFlagsAdd))
   {
-    _pappl_socket_t *sock = (_pappl_socket_t *)context;
-					// Socket
+    _pappl_dnssd_res_t *res = (_pappl_dnssd_res_t *)context;
+					// Resolve data
 
-    sock->host = strdup(host_name);
-    sock->port = port;
+    pthread_mutex_lock(&res->mutex);
+
+    if (!res->host)
+    {
+      res->host = strdup(host_name);
+      res->port = ntohs(port);
+    }
+
+    pthread_cond_broadcast(&res->cond);
+    pthread_mutex_unlock(&res->mutex);
   }
 }
 
@@ -659,11 +939,19 @@ pappl_dnssd_resolve_cb(
 
   if (event == AVAHI_RESOLVER_FOUND)
   {
-    _pappl_socket_t *sock = (_pappl_socket_t *)context;
-					// Socket
+    _pappl_dnssd_res_t *res = (_pappl_dnssd_res_t *)context;
+					// Resolve data
 
-    sock->host = strdup(host_name);
-    sock->port = port;
+    pthread_mutex_lock(&res->mutex);
+
+    if (!res->host)
+    {
+      res->host = strdup(host_name);
+      res->port = port;
+    }
+
+    pthread_cond_broadcast(&res->cond);
+    pthread_mutex_unlock(&res->mutex);
   }
 }
 #  endif // HAVE_MDNSRESPONDER
@@ -727,22 +1015,36 @@ pappl_snmp_compare_devices(
 //
 // 'pappl_snmp_find()' - Find an SNMP device.
 //
+// Devices are reported as soon as their follow-up queries have been answered
+// or have timed out.  The results of a complete scan are cached for
+// `_PAPPL_SNMP_CACHE_TTL` seconds and reported without a new scan when
+// "use_cache" is `true`.
+//
 
 static bool				// O - `true` if found, `false` if not
 pappl_snmp_find(
     pappl_device_cb_t   cb,		// I - Callback function
     void                *data,		// I - User data pointer
     _pappl_socket_t     *sock,		// O - Device info
+    bool                use_cache,	// I - Report cached results?
+    bool                *cached,	// O - `true` if cached results were reported
     pappl_deverror_cb_t err_cb,		// I - Error callback
     void                *err_data)	// I - Error callback data
 {
   bool			ret = false;	// Return value
   cups_array_t		*devices = NULL;//  Device array
   int			snmp_sock = -1,	// SNMP socket
-			last_count;	// Last devices count
+			last_count,	// Last devices count
+			i,		// Looping var
+			num_packets;	// Number of responses read
+  _pappl_snmp_arena_t	*arena = NULL;	// Buffers for responses
+  _pappl_snmp_t		packet;		// Decoded response
   fd_set		input;		// Input set for select()
   struct timeval	timeout;	// Timeout for select()
-  time_t		endtime;	// End time for scan
+  time_t		curtime,	// Current time
+			endtime,	// End time for scan
+			idletime;	// Time to check for new devices
+  bool			all_reported;	// Have all devices been reported?
   http_addrlist_t	*addrs,		// List of addresses
 			*addr;		// Current address
   _pappl_snmp_dev_t	*cur_device;	// Current device
@@ -755,6 +1057,27 @@ pappl_snmp_find(
   };
 
 
+  // See if we have a recent scan...
+  *cached = false;
+
+  if (use_cache)
+  {
+    pthread_mutex_lock(&pappl_snmp_cache_mutex);
+
+    if (pappl_snmp_cache && time(NULL) < (pappl_snmp_cache_time + _PAPPL_SNMP_CACHE_TTL))
+    {
+      *cached = true;
+
+      for (cur_device = (_pappl_snmp_dev_t *)cupsArrayFirst(pappl_snmp_cache); cur_device && !ret; cur_device = (_pappl_snmp_dev_t *)cupsArrayNext(pappl_snmp_cache))
+        ret = pappl_snmp_report(cur_device, cb, data, sock);
+    }
+
+    pthread_mutex_unlock(&pappl_snmp_cache_mutex);
+
+    if (*cached)
+      return (ret);
+  }
+
   // Create an array to track SNMP devices...
   devices = cupsArrayNew3((cups_array_func_t)pappl_snmp_compare_devices, NULL, NULL, 0, NULL, (cups_afree_func_t)pappl_snmp_free);
 
@@ -765,6 +1088,13 @@ pappl_snmp_find(
     goto finished;
   }
 
+  // Allocate buffers for the responses, which are reused for each batch...
+  if ((arena = (_pappl_snmp_arena_t *)malloc(sizeof(_pappl_snmp_arena_t))) == NULL)
+  {
+    _papplDeviceError(err_cb, err_data, "Unable to allocate memory for SNMP responses.");
+    goto finished;
+  }
+
   // Get the list of network interface broadcast addresses...
   if ((addrs = pappl_snmp_get_interface_addresses()) == NULL)
   {
@@ -783,13 +1113,14 @@ pappl_snmp_find(
   // Free broadcast addresses (all done with them...)
   httpAddrFreeList(addrs);
 
-  // Wait up to 30 seconds to discover printers via SNMP...
+  // Wait up to 30 seconds to discover printers via SNMP, reporting each
+  // device as its queries complete...
   FD_ZERO(&input);
 
-  for (endtime = time(NULL) + 30, last_count = 0; time(NULL) < endtime;)
+  for (curtime = time(NULL), endtime = curtime + 30, idletime = curtime + _PAPPL_SNMP_TIMEOUT, last_count = 0; curtime < endtime; curtime = time(NULL))
   {
-    // Wait up to 2 seconds for more data...
-    timeout.tv_sec  = 2;
+    // Wait up to 1 second for more data...
+    timeout.tv_sec  = 1;
     timeout.tv_usec = 0;
 
     FD_SET(snmp_sock, &input);
@@ -803,66 +1134,87 @@ pappl_snmp_find(
 
     if (FD_ISSET(snmp_sock, &input))
     {
-      _PAPPL_DEBUG("pappl_snmp_find: Reading SNMP response.\n");
-      pappl_snmp_read_response(devices, snmp_sock, err_cb, err_data);
+      // Read and process all of the queued responses at once, since a
+      // broadcast query can get hundreds of them...
+      _PAPPL_DEBUG("pappl_snmp_find: Reading SNMP responses.\n");
+
+      if ((num_packets = _papplSNMPReadArena(snmp_sock, arena, 0.0)) < 0)
+        _papplDeviceError(err_cb, err_data, "Unable to read SNMP response data: %s", strerror(errno));
+
+      for (i = 0; i < num_packets; i ++)
+      {
+        if (_papplSNMPDecodeArena(arena, i, &packet))
+          pappl_snmp_process_response(devices, snmp_sock, &packet, err_cb, err_data);
+      }
     }
-    else
+
+    // Report devices whose queries have completed...
+    curtime = time(NULL);
+
+    for (cur_device = (_pappl_snmp_dev_t *)cupsArrayFirst(devices), all_reported = true; cur_device; cur_device = (_pappl_snmp_dev_t *)cupsArrayNext(devices))
     {
-      if (last_count == cupsArrayCount(devices))
+      if (cur_device->reported)
+        continue;
+
+      if (cur_device->pending > 0 && curtime < cur_device->deadline)
+      {
+        all_reported = false;
+        continue;
+      }
+
+      cur_device->reported = true;
+
+      if (pappl_snmp_report(cur_device, cb, data, sock))
+      {
+        ret = true;
+        goto finished;
+      }
+    }
+
+    // Stop once no new devices have shown up and everything is reported...
+    if (curtime >= idletime)
+    {
+      if (all_reported && last_count == cupsArrayCount(devices))
         break;
 
       last_count = cupsArrayCount(devices);
-      _PAPPL_DEBUG("pappl_snmp_find: timeout=%d, last_count = %d\n", (int)(endtime - time(NULL)), last_count);
+      idletime   = curtime + _PAPPL_SNMP_TIMEOUT;
+      _PAPPL_DEBUG("pappl_snmp_find: timeout=%d, last_count = %d\n", (int)(endtime - curtime), last_count);
     }
   }
 
   _PAPPL_DEBUG("pappl_snmp_find: timeout=%d, last_count = %d\n", (int)(endtime - time(NULL)), last_count);
 
-  // Report all of the devices we found...
+  // Report any stragglers...
   for (cur_device = (_pappl_snmp_dev_t *)cupsArrayFirst(devices); cur_device; cur_device = (_pappl_snmp_dev_t *)cupsArrayNext(devices))
   {
-    char	info[256];		// Device description
-    int		num_did;		// Number of device ID keys/values
-    cups_option_t *did;			// Device ID keys/values
-    const char	*make,			// Manufacturer
-		*model;			// Model name
-
-    // Skip LPD (port 515) and IPP (port 631) since they can't be raw sockets...
-    if (cur_device->port == 515 || cur_device->port == 631 || !cur_device->uri)
+    if (cur_device->reported)
       continue;
 
-    num_did = papplDeviceParseID(cur_device->device_id, &did);
-
-    if ((make = cupsGetOption("MANUFACTURER", num_did, did)) == NULL)
-      if ((make = cupsGetOption("MFG", num_did, did)) == NULL)
-        if ((make = cupsGetOption("MFGR", num_did, did)) == NULL)
-          make = "Unknown";
-
-    if ((model = cupsGetOption("MODEL", num_did, did)) == NULL)
-      if ((model = cupsGetOption("MDL", num_did, did)) == NULL)
-        model = "Printer";
-
-    if (!strcmp(make, "HP") && !strncmp(model, "HP ", 3))
-      snprintf(info, sizeof(info), "%s (Network Printer %s)", model, cur_device->uri + 7);
-    else
-      snprintf(info, sizeof(info), "%s %s (Network Printer %s)", make, model, cur_device->uri + 7);
+    cur_device->reported = true;
 
-    if ((*cb)(info, cur_device->uri, cur_device->device_id, data))
+    if (pappl_snmp_report(cur_device, cb, data, sock))
     {
-      // Save the address and port...
-      char	address_str[256];	// IP address as a string
-
-      sock->host = strdup(httpAddrString(&cur_device->address, address_str, sizeof(address_str)));
-      sock->port = cur_device->port;
-      ret        = true;
-      break;
+      ret = true;
+      goto finished;
     }
   }
 
+  // Save the completed scan for later...
+  pthread_mutex_lock(&pappl_snmp_cache_mutex);
+
+  cupsArrayDelete(pappl_snmp_cache);
+  pappl_snmp_cache      = devices;
+  pappl_snmp_cache_time = time(NULL);
+  devices               = NULL;
+
+  pthread_mutex_unlock(&pappl_snmp_cache_mutex);
+
   // Clean up and return...
   finished:
 
   cupsArrayDelete(devices);
+  free(arena);
 
   _papplSNMPClose(snmp_sock);
 
@@ -950,12 +1302,13 @@ pappl_snmp_list(
     void                *err_data)	// I - Error callback data
 {
   _pappl_socket_t	sock;		// Socket data
-  bool			ret;		// Return value
+  bool			ret,		// Return value
+			cached;		// Were cached results reported?
 
 
   memset(&sock, 0, sizeof(sock));
 
-  ret = pappl_snmp_find(cb, data, &sock, err_cb, err_data);
+  ret = pappl_snmp_find(cb, data, &sock, true, &cached, err_cb, err_data);
 
   free(sock.host);
 
@@ -987,18 +1340,18 @@ pappl_snmp_open_cb(
 
 
 //
-// 'pappl_snmp_read_response()' - Read and parse a SNMP response.
+// 'pappl_snmp_process_response()' - Process a SNMP response.
 //
 
 static void
-pappl_snmp_read_response(
+pappl_snmp_process_response(
     cups_array_t      *devices,		// Devices array
     int               fd,		// I - SNMP socket file descriptor
+    _pappl_snmp_t     *packet,		// I - Decoded packet
     pappl_deverror_cb_t err_cb,		// I - Error callback
     void              *err_data)	// I - Data for error callback
 {
   int			i;		// Looping variable
-  _pappl_snmp_t		packet;		// Decoded packet
   _pappl_snmp_dev_t	*device,	// Matching device
 			*temp;		// New device entry
   char			addrname[256];	// Source address name
@@ -1022,30 +1375,36 @@ pappl_snmp_read_response(
 					// PWG Printer Port Monitor MIB raw socket port number OID
   static const int	RawTCPPortOID[] = { 1,3,6,1,4,1,683,6,3,1,4,17,0,-1 };
 					// Extended Networks MIB (common) raw socket port number OID
-
-
-  // Read the response data
-  if (!_papplSNMPRead(fd, &packet, -1.0))
+  static const struct
   {
-    _papplDeviceError(err_cb, err_data, "Unable to read SNMP response data: %s", strerror(errno));
-    return;
-  }
+    _pappl_snmp_query_t	request_id;	// Request ID
+    const int		*oid;		// OID to query
+  }			queries[] =	// Follow-up queries for each device
+  {
+    { _PAPPL_SNMP_QUERY_DEVICE_SYSNAME,	SysNameOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_ID,	HPDeviceIDOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_ID,	LexmarkDeviceIdOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_ID,	PWGPPMDeviceIdOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_ID,	ZebraDeviceIDOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_PORT,	LexmarkPortOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_PORT,	ZebraPortOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_PORT,	PWGPPMPortOID },
+    { _PAPPL_SNMP_QUERY_DEVICE_PORT,	RawTCPPortOID }
+  };
+
 
-  httpAddrString(&(packet.address), addrname, sizeof(addrname));
+  httpAddrString(&(packet->address), addrname, sizeof(addrname));
 
   // Look for the response status code in the SNMP message header
-  if (packet.error)
+  if (packet->error)
   {
-    _papplDeviceError(err_cb, err_data, "Bad SNMP packet from '%s': %s", addrname, packet.error);
+    _papplDeviceError(err_cb, err_data, "Bad SNMP packet from '%s': %s", addrname, packet->error);
     return;
   }
 
-  _PAPPL_DEBUG("pappl_snmp_read_response: community=\"%s\"\n", packet.community);
-  _PAPPL_DEBUG("pappl_snmp_read_response: request-id=%u\n", packet.request_id);
-  _PAPPL_DEBUG("pappl_snmp_read_response: error-status=%d\n", packet.error_status);
-
-  if (packet.error_status && packet.request_id != _PAPPL_SNMP_QUERY_DEVICE_TYPE)
-    return;
+  _PAPPL_DEBUG("pappl_snmp_process_response: community=\"%s\"\n", packet->community);
+  _PAPPL_DEBUG("pappl_snmp_process_response: request-id=%u\n", packet->request_id);
+  _PAPPL_DEBUG("pappl_snmp_process_response: error-status=%d\n", packet->error_status);
 
   // Find a matching device in the cache
   for (device = (_pappl_snmp_dev_t *)cupsArrayFirst(devices); device; device = (_pappl_snmp_dev_t *)cupsArrayNext(devices))
@@ -1054,68 +1413,80 @@ pappl_snmp_read_response(
       break;
   }
 
+  // Each answer to a follow-up query, including errors, completes that query
+  if (device && packet->request_id != _PAPPL_SNMP_QUERY_DEVICE_TYPE && device->pending > 0)
+    device->pending --;
+
+  if (packet->error_status && packet->request_id != _PAPPL_SNMP_QUERY_DEVICE_TYPE)
+    return;
+
   // Process the message
-  switch (packet.request_id)
+  switch (packet->request_id)
   {
     case _PAPPL_SNMP_QUERY_DEVICE_TYPE:
         if (device)
         {
-          _PAPPL_DEBUG("pappl_snmp_read_response: Discarding duplicate device type for \"%s\".\n", addrname);
+          _PAPPL_DEBUG("pappl_snmp_process_response: Discarding duplicate device type for \"%s\".\n", addrname);
+          return;
+        }
+
+        if (packet->object_type != _PAPPL_ASN1_OID)
+        {
+          _PAPPL_DEBUG("pappl_snmp_process_response: Discarding device (no device type).\n");
           return;
         }
 
         for (i = 0; DevicePrinterOID[i] >= 0; i ++)
         {
-          if (DevicePrinterOID[i] != packet.object_value.oid[i])
+          if (DevicePrinterOID[i] != packet->object_value.oid[i])
           {
-            _PAPPL_DEBUG("pappl_snmp_read_response: Discarding device (not printer).\n");
+            _PAPPL_DEBUG("pappl_snmp_process_response: Discarding device (not printer).\n");
             return;
           }
         }
 
-        if (packet.object_value.oid[i] >= 0)
+        if (packet->object_value.oid[i] >= 0)
         {
-          _PAPPL_DEBUG("pappl_snmp_read_response: Discarding device (not printer).\n");
+          _PAPPL_DEBUG("pappl_snmp_process_response: Discarding device (not printer).\n");
           return;
         }
 
         // Add the device and request the device data
         if ((temp = calloc(1, sizeof(_pappl_snmp_dev_t))) == NULL)
         {
-          _PAPPL_DEBUG("pappl_snmp_read_response: Unable to allocate memory for device.\n");
+          _PAPPL_DEBUG("pappl_snmp_process_response: Unable to allocate memory for device.\n");
           return;
         }
 
-        temp->address  = packet.address;
+        temp->address  = packet->address;
         temp->addrname = strdup(addrname);
         temp->port     = 9100;  // Default port to use
+        temp->deadline = time(NULL) + _PAPPL_SNMP_TIMEOUT;
 
         if (!temp->addrname)
         {
-          _PAPPL_DEBUG("pappl_snmp_read_response: Unable to allocate memory for device name.\n");
+          _PAPPL_DEBUG("pappl_snmp_process_response: Unable to allocate memory for device name.\n");
           free(temp);
           return;
         }
 
         cupsArrayAdd(devices, temp);
 
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_SYSNAME, SysNameOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_ID, HPDeviceIDOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_ID, LexmarkDeviceIdOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_ID, PWGPPMDeviceIdOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_ID, ZebraDeviceIDOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_PORT, LexmarkPortOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_PORT, ZebraPortOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_PORT, PWGPPMPortOID);
-        _papplSNMPWrite(fd, &(packet.address), _PAPPL_SNMP_VERSION_1, packet.community, _PAPPL_ASN1_GET_REQUEST, _PAPPL_SNMP_QUERY_DEVICE_PORT, RawTCPPortOID);
+        // Send all of the follow-up queries at once; the responses are matched
+        // to the device by address as they arrive...
+        for (i = 0; i < (int)(sizeof(queries) / sizeof(queries[0])); i ++)
+        {
+          if (_papplSNMPWrite(fd, &(packet->address), _PAPPL_SNMP_VERSION_1, packet->community, _PAPPL_ASN1_GET_REQUEST, queries[i].request_id, queries[i].oid) > 0)
+            temp->pending ++;
+        }
         break;
 
     case _PAPPL_SNMP_QUERY_DEVICE_ID:
-        if (device && packet.object_type == _PAPPL_ASN1_OCTET_STRING && (!device->device_id || strlen(device->device_id) < packet.object_value.string.num_bytes))
+        if (device && packet->object_type == _PAPPL_ASN1_OCTET_STRING && (!device->device_id || strlen(device->device_id) < packet->object_value.string.num_bytes))
         {
           char  *ptr;			// Pointer into device ID
 
-          for (ptr = (char *)packet.object_value.string.bytes; *ptr; ptr ++)
+          for (ptr = (char *)packet->object_value.string.bytes; *ptr; ptr ++)
           {
             if (*ptr == '\n')		// A lot of bad printers put a newline
               *ptr = ';';
@@ -1123,16 +1494,16 @@ pappl_snmp_read_response(
 
 	  free(device->device_id);
 
-          device->device_id = strdup((char *)packet.object_value.string.bytes);
+          device->device_id = strdup((char *)packet->object_value.string.bytes);
         }
 	break;
 
     case _PAPPL_SNMP_QUERY_DEVICE_SYSNAME:
-        if (device && packet.object_type == _PAPPL_ASN1_OCTET_STRING && !device->uri)
+        if (device && packet->object_type == _PAPPL_ASN1_OCTET_STRING && !device->uri)
         {
           char uri[2048];		// Device URI
 
-          snprintf(uri, sizeof(uri), "snmp://%s", (char *)packet.object_value.string.bytes);
+          snprintf(uri, sizeof(uri), "snmp://%s", (char *)packet->object_value.string.bytes);
           device->uri = strdup(uri);
         }
 	break;
@@ -1140,15 +1511,15 @@ pappl_snmp_read_response(
     case _PAPPL_SNMP_QUERY_DEVICE_PORT:
         if (device)
         {
-          if (packet.object_type == _PAPPL_ASN1_INTEGER)
+          if (packet->object_type == _PAPPL_ASN1_INTEGER)
           {
-            device->port = packet.object_value.integer;
+            device->port = packet->object_value.integer;
           }
-          else if (packet.object_type == _PAPPL_ASN1_OCTET_STRING)
+          else if (packet->object_type == _PAPPL_ASN1_OCTET_STRING)
           {
             char *end;			// End of string
 
-            device->port = (int)strtol((char *)packet.object_value.string.bytes, &end, 10);
+            device->port = (int)strtol((char *)packet->object_value.string.bytes, &end, 10);
             if (errno == ERANGE || *end)
               device->port = 0;
 	  }
@@ -1158,6 +1529,61 @@ pappl_snmp_read_response(
 }
 
 
+//
+// 'pappl_snmp_report()' - Report a discovered SNMP device.
+//
+
+static bool				// O - `true` if the callback matched, `false` otherwise
+pappl_snmp_report(
+    _pappl_snmp_dev_t *device,		// I - Device
+    pappl_device_cb_t cb,		// I - Callback function
+    void              *data,		// I - User data pointer
+    _pappl_socket_t   *sock)		// O - Device info
+{
+  char		info[256];		// Device description
+  int		num_did;		// Number of device ID keys/values
+  cups_option_t	*did;			// Device ID keys/values
+  const char	*make,			// Manufacturer
+		*model;			// Model name
+
+
+  // Skip LPD (port 515) and IPP (port 631) since they can't be raw sockets...
+  if (device->port == 515 || device->port == 631 || !device->uri)
+    return (false);
+
+  num_did = papplDeviceParseID(device->device_id, &did);
+
+  if ((make = cupsGetOption("MANUFACTURER", num_did, did)) == NULL)
+    if ((make = cupsGetOption("MFG", num_did, did)) == NULL)
+      if ((make = cupsGetOption("MFGR", num_did, did)) == NULL)
+        make = "Unknown";
+
+  if ((model = cupsGetOption("MODEL", num_did, did)) == NULL)
+    if ((model = cupsGetOption("MDL", num_did, did)) == NULL)
+      model = "Printer";
+
+  if (!strcmp(make, "HP") && !strncmp(model, "HP ", 3))
+    snprintf(info, sizeof(info), "%s (Network Printer %s)", model, device->uri + 7);
+  else
+    snprintf(info, sizeof(info), "%s %s (Network Printer %s)", make, model, device->uri + 7);
+
+  cupsFreeOptions(num_did, did);
+
+  if ((*cb)(info, device->uri, device->device_id, data))
+  {
+    // Save the address and port...
+    char	address_str[256];	// IP address as a string
+
+    sock->host = strdup(httpAddrString(&device->address, address_str, sizeof(address_str)));
+    sock->port = device->port;
+
+    return (true);
+  }
+
+  return (false);
+}
+
+
 //
 // 'pappl_socket_close()' - Close a network socket.
 //
@@ -1178,6 +1604,10 @@ pappl_socket_close(
   close(sock->fd);
 #endif // _WIN32
 
+  if (sock->snmp_fd >= 0)
+    _papplSNMPClose(sock->snmp_fd);
+
+  free(sock->host);
   httpAddrFreeList(sock->list);
   free(sock);
 
@@ -1222,6 +1652,7 @@ pappl_socket_open(
 			*options;	// Pointer to options, if any
   int			port;		// Port number
   char			port_str[32];	// String for port number
+  bool			cached = false;	// Was the DNS-SD resolve or SNMP scan cached?
 
 
   (void)job_name;
@@ -1233,6 +1664,8 @@ pappl_socket_open(
     return (false);
   }
 
+  sock->snmp_fd = -1;
+
   // Split apart the URI...
   httpSeparateURI(HTTP_URI_CODING_ALL, device_uri, scheme, sizeof(scheme), userpass, sizeof(userpass), host, sizeof(host), &port, resource, sizeof(resource));
 
@@ -1243,78 +1676,19 @@ pappl_socket_open(
   {
     // DNS-SD discovered device
 #ifdef HAVE_DNSSD
-    int			i;		// Looping var
-    char		srvname[256],	// Service name
-			*type,		// Service type
-			*domain;	// Domain
-    _pappl_dns_sd_t	master;		// DNS-SD context
-#  ifdef HAVE_MDNSRESPONDER
-    int			error;		// Error code, if any
-    DNSServiceRef	resolver;	// Resolver
-#  else
-    AvahiServiceResolver *resolver;	// Resolver
-#  endif // HAVE_MDNSRESPONDER
-
-    if ((domain = strstr(host, "._tcp.")) != NULL)
-    {
-      // Truncate host at domain portion...
-      domain += 5;
-      *domain++ = '\0';
-
-      // Then separate the service type portion...
-      type = strstr(host, "._");
-      *type ++ = '\0';
-
-      // Unescape the service name...
-      pappl_dnssd_unescape(srvname, host, sizeof(srvname));
-
-      master = _papplDNSSDInit(NULL);
-
-#  ifdef HAVE_MDNSRESPONDER
-      resolver = master;
-      if ((error = DNSServiceResolve(&resolver, kDNSServiceFlagsShareConnection, 0, srvname, type, domain, (DNSServiceResolveReply)pappl_dnssd_resolve_cb, sock)) != kDNSServiceErr_NoError)
-      {
-	papplDeviceError(device, "Unable to resolve '%s': %s", device_uri, _papplDNSSDStrError(error));
-	goto error;
-      }
-#  else
-      _papplDNSSDLock();
-
-      if ((resolver = avahi_service_resolver_new(master, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, srvname, type, domain, AVAHI_PROTO_UNSPEC, 0, (AvahiServiceResolverCallback)pappl_dnssd_resolve_cb, sock)) == NULL)
-      {
-	papplDeviceError(device, "Unable to resolve '%s'.", device_uri);
-	_papplDNSSDUnlock();
-	goto error;
-      }
-
-      _papplDNSSDUnlock();
-#  endif // HAVE_MDNSRESPONDER
-
-      // Wait up to 30 seconds for the resolve to complete...
-      for (i = 0; i < 30000 && !sock->host; i ++)
-	usleep(1000);
-
-#  ifdef HAVE_MDNSRESPONDER
-      DNSServiceRefDeallocate(resolver);
-#  else
-      _papplDNSSDLock();
-      avahi_service_resolver_free(resolver);
-      _papplDNSSDUnlock();
-#  endif // HAVE_MDNSRESPONDER
-
-      if (!sock->host)
-      {
-	papplDeviceError(device, "Unable to resolve '%s'.", device_uri);
-	goto error;
-      }
-    }
+    if (!pappl_dnssd_resolve(device, device_uri, host, true, &cached, sock))
+      goto error;
 #endif // HAVE_DNSSD
   }
   else if (!strcmp(scheme, "snmp"))
   {
     // SNMP discovered device
-    if (!pappl_snmp_find(pappl_snmp_open_cb, (void *)device_uri, sock, NULL, NULL))
-      goto error;
+    if (!pappl_snmp_find(pappl_snmp_open_cb, (void *)device_uri, sock, true, &cached, NULL, NULL))
+    {
+      // Not in the cached results, scan the network again...
+      if (!cached || !pappl_snmp_find(pappl_snmp_open_cb, (void *)device_uri, sock, false, &cached, NULL, NULL))
+        goto error;
+    }
   }
   else if (!strcmp(scheme, "socket"))
   {
@@ -1325,16 +1699,41 @@ pappl_socket_open(
 
   // Lookup the address of the printer...
   snprintf(port_str, sizeof(port_str), "%d", sock->port);
-  if ((sock->list = httpAddrGetList(sock->host, AF_UNSPEC, port_str)) == NULL)
+  sock->fd   = -1;
+  sock->list = httpAddrGetList(sock->host, AF_UNSPEC, port_str);
+
+  if (sock->list)
+    httpAddrConnect2(sock->list, &sock->fd, 30000, NULL);
+
+  if (sock->fd < 0 && cached)
+  {
+    // The cached hostname or port may be stale, try resolving again...
+    free(sock->host);
+    sock->host = NULL;
+    httpAddrFreeList(sock->list);
+    sock->list = NULL;
+
+#ifdef HAVE_DNSSD
+    if (!strcmp(scheme, "dnssd") && !pappl_dnssd_resolve(device, device_uri, host, false, &cached, sock))
+      goto error;
+#endif // HAVE_DNSSD
+
+    if (!strcmp(scheme, "snmp") && !pappl_snmp_find(pappl_snmp_open_cb, (void *)device_uri, sock, false, &cached, NULL, NULL))
+      goto error;
+
+    snprintf(port_str, sizeof(port_str), "%d", sock->port);
+    sock->list = httpAddrGetList(sock->host, AF_UNSPEC, port_str);
+
+    if (sock->list)
+      httpAddrConnect2(sock->list, &sock->fd, 30000, NULL);
+  }
+
+  if (!sock->list)
   {
     papplDeviceError(device, "Unable to lookup '%s:%d': %s", sock->host, sock->port, cupsLastErrorString());
     goto error;
   }
 
-  sock->fd = -1;
-
-  httpAddrConnect2(sock->list, &sock->fd, 30000, NULL);
-
   if (sock->fd < 0)
   {
     papplDeviceError(device, "Unable to connect to '%s:%d': %s", sock->host, sock->port, cupsLastErrorString());
@@ -1406,17 +1805,231 @@ pappl_socket_read(
 }
 
 
+//
+// 'pappl_socket_snmp_cb()' - Save a SNMP printer status or supply value.
+//
+
+static void
+pappl_socket_snmp_cb(
+    _pappl_snmp_t        *packet,	// I - Response packet
+    _pappl_socket_snmp_t *status)	// I - Status data
+{
+  int			row;		// prtMarkerSuppliesIndex (0-based)
+  unsigned char		*bits;		// hrPrinterDetectedErrorState bits
+  static const int	hrPrinterDetectedErrorState[] = { 1,3,6,1,2,1,25,3,5,1,2,-1 };
+  static const int	prtMarkerSuppliesEntry[] = { 1,3,6,1,2,1,43,11,1,1,-1 };
+
+
+  if (_papplSNMPIsOIDPrefixed(packet, hrPrinterDetectedErrorState) && packet->object_type == _PAPPL_ASN1_OCTET_STRING)
+  {
+    // Map the RFC 3805 error bits to "printer-state-reasons" values...
+    bits = packet->object_value.string.bytes;
+
+    if (packet->object_value.string.num_bytes > 0)
+    {
+      if (bits[0] & 0x80)		// lowPaper
+        status->reasons |= PAPPL_PREASON_MEDIA_LOW;
+      if (bits[0] & 0x40)		// noPaper
+        status->reasons |= PAPPL_PREASON_MEDIA_EMPTY;
+      if (bits[0] & 0x20)		// lowToner
+        status->reasons |= PAPPL_PREASON_TONER_LOW;
+      if (bits[0] & 0x10)		// noToner
+        status->reasons |= PAPPL_PREASON_TONER_EMPTY;
+      if (bits[0] & 0x08)		// doorOpen
+        status->reasons |= PAPPL_PREASON_COVER_OPEN;
+      if (bits[0] & 0x04)		// jammed
+        status->reasons |= PAPPL_PREASON_MEDIA_JAM;
+      if (bits[0] & 0x02)		// offline
+        status->reasons |= PAPPL_PREASON_OFFLINE;
+      if (bits[0] & 0x01)		// serviceRequested
+        status->reasons |= PAPPL_PREASON_OTHER;
+    }
+
+    if (packet->object_value.string.num_bytes > 1)
+    {
+      if (bits[1] & 0x80)		// inputTrayMissing
+        status->reasons |= PAPPL_PREASON_INPUT_TRAY_MISSING;
+      if (bits[1] & 0x5a)		// outputTrayMissing, outputNearFull, outputFull, overduePreventMaint
+        status->reasons |= PAPPL_PREASON_OTHER;
+      if (bits[1] & 0x20)		// markerSupplyMissing
+        status->reasons |= PAPPL_PREASON_MARKER_SUPPLY_EMPTY;
+      if (bits[1] & 0x04)		// inputTrayEmpty
+        status->reasons |= PAPPL_PREASON_MEDIA_EMPTY;
+    }
+  }
+  else if (_papplSNMPIsOIDPrefixed(packet, prtMarkerSuppliesEntry) && packet->object_type == _PAPPL_ASN1_INTEGER)
+  {
+    // The OID is prtMarkerSuppliesEntry.column.hrDeviceIndex.prtMarkerSuppliesIndex...
+    if (packet->object_name[11] < 0 || packet->object_name[12] < 1 || packet->object_name[13] != -1 || (row = packet->object_name[12] - 1) >= PAPPL_MAX_SUPPLY)
+      return;
+
+    switch (packet->object_name[10])
+    {
+      case 4 :				// prtMarkerSuppliesClass
+          status->classes[row] = packet->object_value.integer;
+          break;
+      case 8 :				// prtMarkerSuppliesMaxCapacity
+          status->max_capacities[row] = packet->object_value.integer;
+          break;
+      case 9 :				// prtMarkerSuppliesLevel
+          status->levels[row] = packet->object_value.integer;
+          break;
+      default :
+          return;
+    }
+
+    if (row >= status->num_supplies)
+      status->num_supplies = row + 1;
+  }
+}
+
+
+//
+// 'pappl_socket_snmp_status()' - Get the printer state and supply levels via
+//                                SNMP.
+//
+// The hrPrinterDetectedErrorState values and the class, level, and capacity
+// columns of the prtMarkerSuppliesTable are walked at the same time.  The
+// results are cached for `_PAPPL_SNMP_STATUS_TTL` seconds, and printers that
+// do not respond to SNMPv2c or SNMPv1 are not queried again.
+//
+
+static pappl_preason_t			// O - "printer-state-reasons" values
+pappl_socket_snmp_status(
+    _pappl_socket_t *sock)		// I - Socket device
+{
+  int			i,		// Looping var
+			count;		// Number of values found
+  http_addr_t		addr;		// Printer address
+  socklen_t		addrlen = sizeof(addr);
+					// Length of printer address
+  _pappl_socket_snmp_t	status;		// Status data
+  static const int	hrPrinterDetectedErrorState[] = { 1,3,6,1,2,1,25,3,5,1,2,-1 };
+  static const int	prtMarkerSuppliesClass[] = { 1,3,6,1,2,1,43,11,1,1,4,-1 };
+  static const int	prtMarkerSuppliesMaxCapacity[] = { 1,3,6,1,2,1,43,11,1,1,8,-1 };
+  static const int	prtMarkerSuppliesLevel[] = { 1,3,6,1,2,1,43,11,1,1,9,-1 };
+  static const int * const prefixes[] =
+  {					// OID prefixes to walk
+    hrPrinterDetectedErrorState,
+    prtMarkerSuppliesClass,
+    prtMarkerSuppliesMaxCapacity,
+    prtMarkerSuppliesLevel
+  };
+
+
+  // Use the last values if they are recent enough...
+  if (sock->snmp_failed || time(NULL) < (sock->snmp_time + _PAPPL_SNMP_STATUS_TTL))
+    return (sock->snmp_reasons);
+
+  // Query the printer at the address we are connected to...
+  if (getpeername(sock->fd, (struct sockaddr *)&addr, &addrlen) || addr.addr.sa_family != AF_INET)
+  {
+    sock->snmp_failed = true;
+    return (PAPPL_PREASON_NONE);
+  }
+
+  if (sock->snmp_fd < 0)
+  {
+    if ((sock->snmp_fd = _papplSNMPOpen(AF_INET)) < 0)
+    {
+      sock->snmp_failed = true;
+      return (PAPPL_PREASON_NONE);
+    }
+
+    sock->snmp_version = _PAPPL_SNMP_VERSION_2C;
+  }
+
+  memset(&status, 0, sizeof(status));
+  for (i = 0; i < PAPPL_MAX_SUPPLY; i ++)
+  {
+    status.levels[i]         = -2;	// unknown
+    status.max_capacities[i] = -2;	// unknown
+  }
+
+  if ((count = _papplSNMPWalkMultiple(sock->snmp_fd, &addr, sock->snmp_version, _PAPPL_SNMP_COMMUNITY, (int)(sizeof(prefixes) / sizeof(prefixes[0])), prefixes, 1.0, (_pappl_snmp_cb_t)pappl_socket_snmp_cb, &status)) < 0 && sock->snmp_version == _PAPPL_SNMP_VERSION_2C)
+  {
+    // Try again with SNMPv1...
+    sock->snmp_version = _PAPPL_SNMP_VERSION_1;
+    count = _papplSNMPWalkMultiple(sock->snmp_fd, &addr, sock->snmp_version, _PAPPL_SNMP_COMMUNITY, (int)(sizeof(prefixes) / sizeof(prefixes[0])), prefixes, 1.0, (_pappl_snmp_cb_t)pappl_socket_snmp_cb, &status);
+  }
+
+  if (count < 0)
+  {
+    _papplSNMPClose(sock->snmp_fd);
+    sock->snmp_fd      = -1;
+    sock->snmp_failed  = true;
+    sock->snmp_reasons = PAPPL_PREASON_NONE;
+
+    return (PAPPL_PREASON_NONE);
+  }
+
+  // Report consumed supplies that are low or empty and receptacles that are
+  // full or almost full...
+  for (i = 0; i < status.num_supplies; i ++)
+  {
+    if (status.levels[i] < 0 || status.max_capacities[i] <= 0)
+      continue;
+
+    if (status.classes[i] == 3)		// supplyThatIsConsumed
+    {
+      if (status.levels[i] == 0)
+        status.reasons |= PAPPL_PREASON_MARKER_SUPPLY_EMPTY;
+      else if (status.levels[i] <= status.max_capacities[i] / 10)
+        status.reasons |= PAPPL_PREASON_MARKER_SUPPLY_LOW;
+    }
+    else if (status.classes[i] == 4)	// receptacleThatIsFilled
+    {
+      if (status.levels[i] >= status.max_capacities[i])
+        status.reasons |= PAPPL_PREASON_MARKER_WASTE_FULL;
+      else if (status.levels[i] >= status.max_capacities[i] - status.max_capacities[i] / 10)
+        status.reasons |= PAPPL_PREASON_MARKER_WASTE_ALMOST_FULL;
+    }
+  }
+
+  sock->snmp_time    = time(NULL);
+  sock->snmp_reasons = status.reasons;
+
+  return (status.reasons);
+}
+
+
 //
 // 'pappl_socket_status()' - Get the current network device status.
 //
+// "offline" is reported when the printer has closed the connection, which
+// allows idle connections to be checked before reuse.  Otherwise the printer
+// state and supply levels are queried via SNMP.
+//
 
 static pappl_preason_t			// O - New "printer-state-reasons" values
 pappl_socket_status(
     pappl_device_t *device)		// I - Device
 {
-  (void)device;
+  _pappl_socket_t	*sock;		// Socket device
+  struct pollfd		data;		// poll() data
+  char			ch;		// Peeked byte
+
+
+  if ((sock = papplDeviceGetData(device)) == NULL || sock->fd < 0)
+    return (PAPPL_PREASON_OFFLINE);
 
-  return (PAPPL_PREASON_NONE);
+  // See if the connection has been closed or has pending data...
+  data.fd      = sock->fd;
+  data.events  = POLLIN;
+  data.revents = 0;
+
+  if (poll(&data, 1, 0) > 0)
+  {
+    if (data.revents & (POLLERR | POLLHUP | POLLNVAL))
+      return (PAPPL_PREASON_OFFLINE);
+
+    // Readable - a peek of 0 bytes means the printer closed the connection...
+    if (recv(sock->fd, &ch, 1, MSG_PEEK) <= 0)
+      return (PAPPL_PREASON_OFFLINE);
+  }
+
+  // Get the printer state and supply levels...
+  return (pappl_socket_snmp_status(sock));
 }
 
 
@@ -1462,3 +2075,39 @@ pappl_socket_write(
 }
 
 
+//
+// 'pappl_socket_writev()' - Write multiple buffers to a network socket.
+//
+
+static ssize_t				// O - Number of bytes written
+pappl_socket_writev(
+    pappl_device_t      *device,	// I - Device
+    const pappl_iovec_t *iov,		// I - Buffers to write
+    int                 iovcnt)		// I - Number of buffers
+{
+  _pappl_socket_t	*sock;		// Socket device
+#if _WIN32
+  ssize_t		count,		// Total bytes written
+			written;	// Bytes written for this buffer
+#endif // _WIN32
+
+
+  if ((sock = papplDeviceGetData(device)) == NULL)
+    return (-1);
+
+#if _WIN32
+  // No writev on Windows, write each buffer in turn...
+  for (count = 0; iovcnt > 0; iovcnt --, iov ++, count += written)
+  {
+    if ((written = pappl_socket_write(device, iov->buffer, iov->bytes)) < 0)
+      return (-1);
+  }
+
+  return (count);
+
+#else
+  return (_papplDeviceWritevFd(sock->fd, iov, iovcnt));
+#endif // _WIN32
+}
+
+
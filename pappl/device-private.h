@@ -1,7 +1,7 @@
 //
 // Private device communication functions for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -31,7 +31,9 @@ extern "C" {
 // Constants...
 //
 
-#define PAPPL_DEVICE_BUFSIZE	8192	// Size of write buffer
+#define PAPPL_DEVICE_BUFSIZE	8192	// Default size of write buffer
+#define _PAPPL_DEVICE_MAX_IOV	64	// Maximum number of I/O vectors per write
+#define _PAPPL_DEVICE_QUEUESIZE	262144	// Default size of output queue
 
 
 //
@@ -46,14 +48,27 @@ struct _pappl_device_s			// Device connection data
   pappl_devread_cb_t	read_cb;		// Read callback
   pappl_devstatus_cb_t	status_cb;		// Status callback
   pappl_devwrite_cb_t	write_cb;		// Write callback
+  pappl_devwritev_cb_t	writev_cb;		// Vectored write callback, if any
 
   void			*device_data,		// Data pointer for device
 			*error_data;		// Data pointer for error callback
 
-  char			buffer[PAPPL_DEVICE_BUFSIZE];
-						// Write buffer
-  size_t		bufused;		// Number of bytes in write buffer
+  char			*buffer;		// Write buffer
+  size_t		bufsize,		// Size of write buffer
+			bufused;		// Number of bytes in write buffer
   pappl_devmetrics_t	metrics;		// Device metrics
+  pappl_devtimings_t	timings;		// Device timing metrics
+  unsigned long long	write_start;		// Start time of current write request or `0` if none
+
+  pthread_mutex_t	output_mutex;		// Output queue mutex
+  pthread_cond_t	output_cond;		// Output queue condition
+  pthread_t		output_thread;		// Output thread
+  char			*output_queue;		// Output queue or `NULL` for direct writes
+  size_t		output_size,		// Size of output queue
+			output_head,		// Offset of oldest queued byte
+			output_used;		// Number of bytes in output queue
+  bool			output_error,		// Did an output write fail?
+			output_stop;		// Stop the output thread?
 };
 
 typedef void (*_pappl_devscheme_cb_t)(const char *scheme, void *data);
@@ -66,8 +81,14 @@ typedef void (*_pappl_devscheme_cb_t)(const char *scheme, void *data);
 extern void		_papplDeviceAddFileScheme(void) _PAPPL_PRIVATE;
 extern void		_papplDeviceAddNetworkSchemes(void) _PAPPL_PRIVATE;
 extern void		_papplDeviceAddSupportedSchemes(ipp_t *attrs);
+extern void		_papplDeviceAddTimings(pappl_devtimings_t *dst, const pappl_devtimings_t *src) _PAPPL_PRIVATE;
 extern void		_papplDeviceAddUSBScheme(void) _PAPPL_PRIVATE;
 extern void		_papplDeviceError(pappl_deverror_cb_t err_cb, void *err_data, const char *message, ...) _PAPPL_FORMAT(3,4) _PAPPL_PRIVATE;
+extern bool		_papplDeviceStartOutput(pappl_device_t *device, int policy, int priority, unsigned cpus, size_t queue_size) _PAPPL_PRIVATE;
+extern void		_papplDeviceStopOutput(pappl_device_t *device) _PAPPL_PRIVATE;
+#  if !_WIN32
+extern ssize_t		_papplDeviceWritevFd(int fd, const pappl_iovec_t *iov, int iovcnt) _PAPPL_PRIVATE;
+#  endif // !_WIN32
 
 
 //
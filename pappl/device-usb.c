@@ -25,6 +25,17 @@
 //
 
 #ifdef HAVE_LIBUSB
+#  define _PAPPL_USB_MAX_TRANSFERS 2	// Number of bulk writes in flight
+
+typedef struct _pappl_usb_xfer_s	// Asynchronous bulk write
+{
+  struct libusb_transfer *transfer;		// libusb transfer or `NULL`
+  unsigned char		*buffer;		// Copy of write data
+  size_t		bufsize;		// Size of buffer
+  int			completed;		// Non-zero when the transfer is finished
+  bool			submitted;		// Has the transfer been submitted?
+} _pappl_usb_xfer_t;
+
 typedef struct _pappl_usb_dev_s		// USB device data
 {
   struct libusb_device	*device;		// Device info
@@ -37,7 +48,54 @@ typedef struct _pappl_usb_dev_s		// USB device data
 			write_endp,		// Write endpoint
 			read_endp,		// Read endpoint
 			protocol;		// Protocol: 1 = Uni-di, 2 = Bi-di.
+  _pappl_usb_xfer_t	xfers[_PAPPL_USB_MAX_TRANSFERS];
+						// Asynchronous bulk writes
+  int			next_xfer;		// Next bulk write to use
 } _pappl_usb_dev_t;
+
+typedef struct _pappl_usb_printer_s	// Cached USB printer
+{
+  struct _pappl_usb_printer_s *next;		// Next printer
+  struct libusb_device	*device;		// Device info
+  uint16_t		vendor_id,		// Vendor ID
+			product_id;		// Product ID
+  int			conf,			// Configuration
+			confvalue,		// Configuration value
+			iface,			// Interface
+			ifacenum,		// Interface number
+			altset,			// Alternate setting
+			num_altsetting,		// Number of alternate settings
+			write_endp,		// Write endpoint address
+			read_endp,		// Read endpoint address or `-1`
+			protocol;		// Protocol: 1 = Uni-di, 2 = Bi-di.
+  char			device_id[1024],	// IEEE-1284 device ID
+			device_info[256],	// Device description
+			device_uri[1024];	// Device URI
+} _pappl_usb_printer_t;
+#endif // HAVE_LIBUSB
+
+
+//
+// Local globals...
+//
+
+#ifdef HAVE_LIBUSB
+static pthread_mutex_t	pappl_usb_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for USB printer cache
+static _pappl_usb_printer_t *pappl_usb_printers = NULL;
+					// Cached USB printers
+static int		pappl_usb_num_printers = 0;
+					// Number of cached USB printers
+static bool		pappl_usb_initialized = false,
+					// Has libusb been initialized?
+			pappl_usb_hotplug = false,
+					// Are hotplug events being delivered?
+			pappl_usb_scanned = false;
+					// Has the bus been scanned?
+static int		pappl_usb_changes = 0,
+					// Number of hotplug events
+			pappl_usb_scan_changes = 0;
+					// Number of hotplug events at last scan
 #endif // HAVE_LIBUSB
 
 
@@ -46,15 +104,23 @@ typedef struct _pappl_usb_dev_s		// USB device data
 //
 
 #ifdef HAVE_LIBUSB
+static bool		pappl_usb_claim(_pappl_usb_dev_t *device, _pappl_usb_printer_t *printer, pappl_deverror_cb_t err_cb, void *err_data);
 static void		pappl_usb_close(pappl_device_t *device);
+static bool		pappl_usb_drain(pappl_device_t *device, _pappl_usb_dev_t *usb);
 static bool		pappl_usb_find(pappl_device_cb_t cb, void *data, _pappl_usb_dev_t *device, pappl_deverror_cb_t err_cb, void *err_data);
 static char		*pappl_usb_getid(pappl_device_t *device, char *buffer, size_t bufsize);
+static int LIBUSB_CALL	pappl_usb_hotplug_cb(libusb_context *ctx, libusb_device *udevice, libusb_hotplug_event event, void *data);
 static bool		pappl_usb_list(pappl_device_cb_t cb, void *data, pappl_deverror_cb_t err_cb, void *err_data);
 static bool		pappl_usb_open(pappl_device_t *device, const char *device_uri, const char *name);
 static bool		pappl_usb_open_cb(const char *device_info, const char *device_uri, const char *device_id, void *data);
+static bool		pappl_usb_probe(libusb_device *udevice, _pappl_usb_printer_t *printer, pappl_deverror_cb_t err_cb, void *err_data);
 static ssize_t		pappl_usb_read(pappl_device_t *device, void *buffer, size_t bytes);
+static void		*pappl_usb_run(void *data);
+static bool		pappl_usb_scan(pappl_deverror_cb_t err_cb, void *err_data);
 static pappl_preason_t	pappl_usb_status(pappl_device_t *device);
+static bool		pappl_usb_wait(pappl_device_t *device, _pappl_usb_xfer_t *xfer);
 static ssize_t		pappl_usb_write(pappl_device_t *device, const void *buffer, size_t bytes);
+static void LIBUSB_CALL	pappl_usb_write_cb(struct libusb_transfer *transfer);
 #endif // HAVE_LIBUSB
 
 
@@ -72,6 +138,92 @@ _papplDeviceAddUSBScheme(void)
 
 
 #ifdef HAVE_LIBUSB
+//
+// 'pappl_usb_claim()' - Open and claim the printer interface of a USB device.
+//
+
+static bool				// O - `true` on success, `false` on error
+pappl_usb_claim(
+    _pappl_usb_dev_t     *device,	// I - USB device info
+    _pappl_usb_printer_t *printer,	// I - Cached printer
+    pappl_deverror_cb_t  err_cb,	// I - Error callback
+    void                 *err_data)	// I - Error callback data
+{
+  ssize_t	err;			// Current error
+  uint8_t	current;		// Current configuration
+
+
+  device->device     = printer->device;
+  device->handle     = NULL;
+  device->conf       = printer->conf;
+  device->origconf   = -1;
+  device->iface      = printer->iface;
+  device->ifacenum   = printer->ifacenum;
+  device->altset     = printer->altset;
+  device->write_endp = printer->write_endp;
+  device->read_endp  = printer->read_endp;
+  device->protocol   = printer->protocol;
+
+  if (libusb_open(printer->device, &device->handle))
+  {
+    device->handle = NULL;
+    return (false);
+  }
+
+  // Opened the device, try to set the configuration...
+  if (libusb_control_transfer(device->handle, LIBUSB_REQUEST_TYPE_STANDARD | LIBUSB_ENDPOINT_IN | LIBUSB_RECIPIENT_DEVICE, 8, /* GET_CONFIGURATION */ 0, 0, (unsigned char *)&current, 1, 5000) < 0)
+    current = 0;
+
+  if (printer->confvalue != current)
+  {
+    // Select the configuration we want...
+    if (libusb_set_configuration(device->handle, printer->confvalue) < 0)
+    {
+      libusb_close(device->handle);
+      device->handle = NULL;
+      return (false);
+    }
+  }
+
+#ifdef __linux
+  // Make sure the old, busted usblp kernel driver is not loaded...
+  if (libusb_kernel_driver_active(device->handle, device->iface) == 1)
+  {
+    if ((err = libusb_detach_kernel_driver(device->handle, device->iface)) < 0 && err != LIBUSB_ERROR_NOT_FOUND)
+    {
+      _papplDeviceError(err_cb, err_data, "Unable to detach usblp kernel driver for USB printer %04x:%04x: %s", printer->vendor_id, printer->product_id, libusb_strerror((enum libusb_error)err));
+      libusb_close(device->handle);
+      device->handle = NULL;
+      return (false);
+    }
+  }
+#endif // __linux
+
+  // Claim the interface...
+  if ((err = libusb_claim_interface(device->handle, device->ifacenum)) < 0)
+  {
+    _papplDeviceError(err_cb, err_data, "Unable to claim USB interface: %s", libusb_strerror((enum libusb_error)err));
+    libusb_close(device->handle);
+    device->handle = NULL;
+    return (false);
+  }
+
+  if (printer->num_altsetting > 1)
+  {
+    // Set the alternate setting as needed...
+    if ((err = libusb_set_interface_alt_setting(device->handle, device->ifacenum, device->altset)) < 0)
+    {
+      _papplDeviceError(err_cb, err_data, "Unable to set alternate USB interface: %s", libusb_strerror((enum libusb_error)err));
+      libusb_close(device->handle);
+      device->handle = NULL;
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
 //
 // 'pappl_usb_close()' - Close a USB device.
 //
@@ -81,8 +233,20 @@ pappl_usb_close(pappl_device_t *device)	// I - Device
 {
   _pappl_usb_dev_t	*usb = (_pappl_usb_dev_t *)papplDeviceGetData(device);
 					// USB device data
+  int			i;		// Looping var
 
 
+  // Wait for any pending writes and free the transfers...
+  pappl_usb_drain(device, usb);
+
+  for (i = 0; i < _PAPPL_USB_MAX_TRANSFERS; i ++)
+  {
+    if (usb->xfers[i].transfer)
+      libusb_free_transfer(usb->xfers[i].transfer);
+
+    free(usb->xfers[i].buffer);
+  }
+
   libusb_close(usb->handle);
   libusb_unref_device(usb->device);
 
@@ -92,376 +256,122 @@ pappl_usb_close(pappl_device_t *device)	// I - Device
 }
 
 
+//
+// 'pappl_usb_drain()' - Wait for all pending writes to finish.
+//
+// If a write fails, any remaining writes are canceled since the printer won't
+// be able to make sense of the data that follows.
+//
+
+static bool				// O - `true` on success, `false` on error
+pappl_usb_drain(
+    pappl_device_t   *device,		// I - Device
+    _pappl_usb_dev_t *usb)		// I - USB device data
+{
+  int			i;		// Looping var
+  _pappl_usb_xfer_t	*xfer;		// Current transfer
+  bool			ret = true;	// Return value
+
+
+  // Transfers complete in the order they were submitted, so start with the
+  // oldest...
+  for (i = 0; i < _PAPPL_USB_MAX_TRANSFERS; i ++)
+  {
+    xfer = usb->xfers + (usb->next_xfer + i) % _PAPPL_USB_MAX_TRANSFERS;
+
+    if (!ret && xfer->submitted && !xfer->completed)
+      libusb_cancel_transfer(xfer->transfer);
+
+    if (!pappl_usb_wait(device, xfer))
+      ret = false;
+  }
+
+  return (ret);
+}
+
+
 //
 // 'pappl_usb_find()' - Find a USB printer.
 //
+// The callback is called for each cached printer, rescanning the bus first if
+// a hotplug event has been seen (or if hotplug events are not supported).  If
+// "device" is not `NULL`, the matching printer's interface is claimed.
+//
 
 static bool				// O - `true` if found, `false` if not
 pappl_usb_find(
     pappl_device_cb_t   cb,		// I - Callback function
     void                *data,		// I - User data pointer
-    _pappl_usb_dev_t    *device,	// O - USB device info
+    _pappl_usb_dev_t    *device,	// O - USB device info or `NULL` to just list
     pappl_deverror_cb_t err_cb,		// I - Error callback
     void                *err_data)	// I - Error callback data
 {
-  ssize_t	err = 0,		// Current error
-		i,			// Looping var
-		num_udevs;		// Number of USB devices
-  libusb_device	**udevs;		// USB devices
+  bool			ret = false;	// Return value
+  int			i,		// Looping var
+			num_printers;	// Number of printers
+  _pappl_usb_printer_t	*printer,	// Current cached printer
+			*printers;	// Copy of cached printers
 
 
- /*
-  * Get the list of connected USB devices...
-  */
+  if (device)
+  {
+    device->device = NULL;
+    device->handle = NULL;
+  }
 
-  device->device = NULL;
-  device->handle = NULL;
+  // Copy the cached printers so the callback can run without the cache lock...
+  pthread_mutex_lock(&pappl_usb_mutex);
 
-  if ((err = libusb_init(NULL)) != 0)
+  if (!pappl_usb_scan(err_cb, err_data) || pappl_usb_num_printers == 0 || (printers = calloc((size_t)pappl_usb_num_printers, sizeof(_pappl_usb_printer_t))) == NULL)
   {
-    _papplDeviceError(err_cb, err_data, "Unable to initialize USB access: %s", libusb_strerror((enum libusb_error)err));
+    pthread_mutex_unlock(&pappl_usb_mutex);
     return (false);
   }
 
-  num_udevs = libusb_get_device_list(NULL, &udevs);
+  for (num_printers = 0, printer = pappl_usb_printers; printer; printer = printer->next, num_printers ++)
+  {
+    printers[num_printers]      = *printer;
+    printers[num_printers].next = NULL;
 
-  _PAPPL_DEBUG("pappl_usb_find: num_udevs=%d\n", (int)num_udevs);
+    libusb_ref_device(printer->device);
+  }
 
-  // Find the printers and do the callback until we find a match.
-  for (i = 0; i < num_udevs; i ++)
+  pthread_mutex_unlock(&pappl_usb_mutex);
+
+  // Do the callback until we find a match.
+  for (i = 0; i < num_printers; i ++)
   {
-    libusb_device *udevice = udevs[i];	// Current device
-    char	device_id[1024],	// Current device ID
-		device_info[256],	// Current device description
-		device_uri[1024];	// Current device URI
-    struct libusb_device_descriptor devdesc;
-					// Current device descriptor
-    struct libusb_config_descriptor *confptr = NULL;
-					// Pointer to current configuration
-    const struct libusb_interface *ifaceptr = NULL;
-					// Pointer to current interface
-    const struct libusb_interface_descriptor *altptr = NULL;
-					// Pointer to current alternate setting
-    const struct libusb_endpoint_descriptor *endpptr = NULL;
-					// Pointer to current endpoint
-    uint8_t	conf,			// Current configuration
-		iface,			// Current interface
-		altset,			// Current alternate setting
-		endp,			// Current endpoint
-		read_endp,		// Current read endpoint
-		write_endp;		// Current write endpoint
+    printer = printers + i;
 
-    // Ignore devices with no configuration data and anything that is not
-    // a printer...
-    if (libusb_get_device_descriptor(udevice, &devdesc) < 0)
+    if (!ret && (*cb)(printer->device_info, printer->device_uri, printer->device_id, data))
     {
-      _PAPPL_DEBUG("pappl_usb_find: udev%d - no descriptor.\n", (int)i);
-      continue;
-    }
-
-    _PAPPL_DEBUG("pappl_usb_find: udev%d -\n", (int)i);
-    _PAPPL_DEBUG("pappl_usb_find:     bLength=%d\n", devdesc.bLength);
-    _PAPPL_DEBUG("pappl_usb_find:     bDescriptorType=%d\n", devdesc.bDescriptorType);
-    _PAPPL_DEBUG("pappl_usb_find:     bcdUSB=%04x\n", devdesc.bcdUSB);
-    _PAPPL_DEBUG("pappl_usb_find:     bDeviceClass=%d\n", devdesc.bDeviceClass);
-    _PAPPL_DEBUG("pappl_usb_find:     bDeviceSubClass=%d\n", devdesc.bDeviceSubClass);
-    _PAPPL_DEBUG("pappl_usb_find:     bDeviceProtocol=%d\n", devdesc.bDeviceProtocol);
-    _PAPPL_DEBUG("pappl_usb_find:     bMaxPacketSize0=%d\n", devdesc.bMaxPacketSize0);
-    _PAPPL_DEBUG("pappl_usb_find:     idVendor=0x%04x\n", devdesc.idVendor);
-    _PAPPL_DEBUG("pappl_usb_find:     idProduct=0x%04x\n", devdesc.idProduct);
-    _PAPPL_DEBUG("pappl_usb_find:     bcdDevice=%04x\n", devdesc.bcdDevice);
-    _PAPPL_DEBUG("pappl_usb_find:     iManufacturer=%d\n", devdesc.iManufacturer);
-    _PAPPL_DEBUG("pappl_usb_find:     iProduct=%d\n", devdesc.iProduct);
-    _PAPPL_DEBUG("pappl_usb_find:     iSerialNumber=%d\n", devdesc.iSerialNumber);
-    _PAPPL_DEBUG("pappl_usb_find:     bNumConfigurations=%d\n", devdesc.bNumConfigurations);
-
-    if (!devdesc.bNumConfigurations || !devdesc.idVendor || !devdesc.idProduct)
-      continue;
+      _PAPPL_DEBUG("pappl_usb_find: Found a match.\n");
 
-    if (devdesc.idVendor == 0x05ac)
-      continue;				// Skip Apple devices...
-
-    device->device     = udevice;
-    device->handle     = NULL;
-    device->conf       = -1;
-    device->origconf   = -1;
-    device->iface      = -1;
-    device->ifacenum   = -1;
-    device->altset     = -1;
-    device->write_endp = -1;
-    device->read_endp  = -1;
-    device->protocol   = 0;
-
-    for (conf = 0; conf < devdesc.bNumConfigurations; conf ++)
-    {
-      if (libusb_get_config_descriptor(udevice, conf, &confptr) < 0)
-      {
-        _PAPPL_DEBUG("pappl_usb_find:     conf%d - no descriptor\n", conf);
-	continue;
-      }
+      ret = true;
 
-      _PAPPL_DEBUG("pappl_usb_find:     conf%d -\n", conf);
-      _PAPPL_DEBUG("pappl_usb_find:         bLength=%d\n", confptr->bLength);
-      _PAPPL_DEBUG("pappl_usb_find:         bDescriptorType=%d\n", confptr->bDescriptorType);
-      _PAPPL_DEBUG("pappl_usb_find:         wTotalLength=%d\n", confptr->wTotalLength);
-      _PAPPL_DEBUG("pappl_usb_find:         bNumInterfaces=%d\n", confptr->bNumInterfaces);
-      _PAPPL_DEBUG("pappl_usb_find:         bConfigurationValue=%d\n", confptr->bConfigurationValue);
-      _PAPPL_DEBUG("pappl_usb_find:         iConfiguration=%d\n", confptr->iConfiguration);
-      _PAPPL_DEBUG("pappl_usb_find:         bmAttributes=%d\n", confptr->bmAttributes);
-      _PAPPL_DEBUG("pappl_usb_find:         MaxPower=%d\n", confptr->MaxPower);
-      _PAPPL_DEBUG("pappl_usb_find:         interface=%p\n", confptr->interface);
-      _PAPPL_DEBUG("pappl_usb_find:         extra=%p\n", confptr->extra);
-      _PAPPL_DEBUG("pappl_usb_find:         extra_length=%d\n", confptr->extra_length);
-
-      // Some printers offer multiple interfaces...
-      for (iface = 0, ifaceptr = confptr->interface; iface < confptr->bNumInterfaces; iface ++, ifaceptr ++)
+      if (device)
       {
-        if (!ifaceptr->altsetting)
+        if (pappl_usb_claim(device, printer, err_cb, err_data))
         {
-          _PAPPL_DEBUG("pappl_usb_find:         iface%d - no alternate setting\n", iface);
+          // Keep the device reference for the connection...
           continue;
         }
 
-	_PAPPL_DEBUG("pappl_usb_find:         iface%d -\n", iface);
-	_PAPPL_DEBUG("pappl_usb_find:             num_altsetting=%d\n", ifaceptr->num_altsetting);
-	_PAPPL_DEBUG("pappl_usb_find:             altsetting=%p\n", ifaceptr->altsetting);
-
-        device->protocol = 0;
-
-	for (altset = 0, altptr = ifaceptr->altsetting; (int)altset < ifaceptr->num_altsetting; altset ++, altptr ++)
-	{
-	  _PAPPL_DEBUG("pappl_usb_find:             altset%d - bInterfaceClass=%d, bInterfaceSubClass=%d, bInterfaceProtocol=%d\n", altset, altptr->bInterfaceClass, altptr->bInterfaceSubClass, altptr->bInterfaceProtocol);
-
-	  if (altptr->bInterfaceClass != LIBUSB_CLASS_PRINTER || altptr->bInterfaceSubClass != 1)
-	    continue;
-
-	  if (altptr->bInterfaceProtocol != 1 && altptr->bInterfaceProtocol != 2)
-	    continue;
-
-	  if (altptr->bInterfaceProtocol < device->protocol || altptr->bInterfaceProtocol > 2)
-	    continue;
-
-	  read_endp  = 0xff;
-	  write_endp = 0xff;
-
-	  for (endp = 0, endpptr = altptr->endpoint; endp < altptr->bNumEndpoints; endp ++, endpptr ++)
-	  {
-	    if ((endpptr->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_BULK)
-	    {
-	      if (endpptr->bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK)
-		read_endp = endp;
-	      else
-		write_endp = endp;
-	    }
-	  }
-
-	  if (write_endp != 0xff)
-	  {
-	    // Save the best match so far...
-	    device->protocol   = altptr->bInterfaceProtocol;
-	    device->altset     = altptr->bAlternateSetting;
-	    device->ifacenum   = altptr->bInterfaceNumber;
-	    device->write_endp = write_endp;
-	    if (device->protocol > 1)
-	      device->read_endp = read_endp;
-	  }
-	}
-
-        _PAPPL_DEBUG("pappl_usb_find:             device->protocol=%d\n", device->protocol);
-
-	if (device->protocol > 0)
-	{
-	  device->conf  = conf;
-	  device->iface = iface;
-
-	  if (!libusb_open(udevice, &device->handle))
-	  {
-	    uint8_t	current;	// Current configuration
-
-	    // Opened the device, try to set the configuration...
-	    if (libusb_control_transfer(device->handle, LIBUSB_REQUEST_TYPE_STANDARD | LIBUSB_ENDPOINT_IN | LIBUSB_RECIPIENT_DEVICE, 8, /* GET_CONFIGURATION */ 0, 0, (unsigned char *)&current, 1, 5000) < 0)
-	      current = 0;
-
-            if (confptr->bConfigurationValue != current)
-            {
-              // Select the configuration we want...
-              if (libusb_set_configuration(device->handle, confptr->bConfigurationValue) < 0)
-              {
-                libusb_close(device->handle);
-                device->handle = NULL;
-              }
-            }
-
-#ifdef __linux
-            if (device->handle)
-            {
-	      // Make sure the old, busted usblp kernel driver is not loaded...
-	      if (libusb_kernel_driver_active(device->handle, device->iface) == 1)
-	      {
-		if ((err = libusb_detach_kernel_driver(device->handle, device->iface)) < 0 && err != LIBUSB_ERROR_NOT_FOUND)
-		{
-		  _papplDeviceError(err_cb, err_data, "Unable to detach usblp kernel driver for USB printer %04x:%04x: %s", devdesc.idVendor, devdesc.idProduct, libusb_strerror((enum libusb_error)err));
-		  libusb_close(device->handle);
-		  device->handle = NULL;
-		}
-	      }
-	    }
-#endif // __linux
-
-            if (device->handle)
-            {
-              // Claim the interface...
-              if ((err = libusb_claim_interface(device->handle, device->ifacenum)) < 0)
-              {
-		_papplDeviceError(err_cb, err_data, "Unable to claim USB interface: %s", libusb_strerror((enum libusb_error)err));
-                libusb_close(device->handle);
-                device->handle = NULL;
-              }
-            }
-
-            if (device->handle && ifaceptr->num_altsetting > 1)
-            {
-              // Set the alternate setting as needed...
-              if ((err = libusb_set_interface_alt_setting(device->handle, device->ifacenum, device->altset)) < 0)
-              {
-		_papplDeviceError(err_cb, err_data, "Unable to set alternate USB interface: %s", libusb_strerror((enum libusb_error)err));
-                libusb_close(device->handle);
-                device->handle = NULL;
-              }
-            }
-
-            if (device->handle)
-            {
-              // Get the 1284 Device ID...
-              if ((err = libusb_control_transfer(device->handle, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_ENDPOINT_IN | LIBUSB_RECIPIENT_INTERFACE, 0, (uint16_t)device->conf, (uint16_t)((device->iface << 8) | device->altset), (unsigned char *)device_id, sizeof(device_id), 5000)) < 0)
-              {
-		_papplDeviceError(err_cb, err_data, "Unable to get IEEE-1284 device ID: %s", libusb_strerror((enum libusb_error)err));
-                device_id[0] = '\0';
-                libusb_close(device->handle);
-                device->handle = NULL;
-              }
-              else
-              {
-                int length = ((device_id[0] & 255) << 8) | (device_id[1] & 255);
-                if (length < 14 || length > (int)sizeof(device_id))
-                  length = ((device_id[1] & 255) << 8) | (device_id[0] & 255);
-
-                if (length > (int)sizeof(device_id))
-                  length = (int)sizeof(device_id);
-
-                length -= 2;
-                memmove(device_id, device_id + 2, (size_t)length);
-                device_id[length] = '\0';
-
-                _PAPPL_DEBUG("pappl_usb_find:     device_id=\"%s\"\n", device_id);
-              }
-            }
-
-            if (device->handle)
-            {
-              // Build the device URI...
-              const char *make,		// Pointer to make
-			*model,		// Pointer to model
-			*serial = NULL;	// Pointer to serial number
-	      char	*ptr,		// Pointer into device ID
-			copy_did[1024],	// Copy of device ID
-			temp[256];	// Temporary string for serial #
-
-	      strlcpy(copy_did, device_id, sizeof(copy_did));
-
-              if ((make = strstr(copy_did, "MANUFACTURER:")) != NULL)
-                make += 13;
-              else if ((make = strstr(copy_did, "MFG:")) != NULL)
-                make += 4;
-
-              if ((model = strstr(copy_did, "MODEL:")) != NULL)
-                model += 6;
-              else if ((model = strstr(copy_did, "MDL:")) != NULL)
-                model += 4;
-
-              if ((serial = strstr(copy_did, "SERIALNUMBER:")) != NULL)
-                serial += 12;
-              else if ((serial = strstr(copy_did, "SERN:")) != NULL)
-                serial += 5;
-              else if ((serial = strstr(copy_did, "SN:")) != NULL)
-                serial += 3;
-
-              if (serial)
-              {
-                if ((ptr = strchr(serial, ';')) != NULL)
-                  *ptr = '\0';
-              }
-              else
-              {
-                int length = libusb_get_string_descriptor_ascii(device->handle, devdesc.iSerialNumber, (unsigned char *)temp, sizeof(temp) - 1);
-                if (length > 0)
-                {
-                  temp[length] = '\0';
-                  serial       = temp;
-                }
-              }
-
-              if (make)
-              {
-                if ((ptr = strchr(make, ';')) != NULL)
-                  *ptr = '\0';
-              }
-              else
-                make = "Unknown";
-
-              if (model)
-              {
-                if ((ptr = strchr(model, ';')) != NULL)
-                  *ptr = '\0';
-              }
-              else
-                model = "Unknown";
-
-              if (serial)
-                httpAssembleURIf(HTTP_URI_CODING_ALL, device_uri, sizeof(device_uri), "usb", NULL, make, 0, "/%s?serial=%s", model, serial);
-              else
-                httpAssembleURIf(HTTP_URI_CODING_ALL, device_uri, sizeof(device_uri), "usb", NULL, make, 0, "/%s", model);
-
-	      if (!strcmp(make, "HP") && !strncmp(model, "HP ", 3))
-	        snprintf(device_info, sizeof(device_info), "%s (USB)", model);
-	      else
-	        snprintf(device_info, sizeof(device_info), "%s %s (USB)", make, model);
-
-              if ((*cb)(device_info, device_uri, device_id, data))
-              {
-                _PAPPL_DEBUG("pappl_usb_find:     Found a match.\n");
-
-		libusb_ref_device(device->device);
-
-		if (device->read_endp != -1)
-		  device->read_endp = confptr->interface[device->iface].altsetting[device->altset].endpoint[device->read_endp].bEndpointAddress;
-
-		if (device->write_endp != -1)
-		  device->write_endp = confptr->interface[device->iface].altsetting[device->altset].endpoint[device->write_endp].bEndpointAddress;
-
-                goto match_found;
-              }
-
-	      libusb_close(device->handle);
-	      device->handle = NULL;
-            }
-	  }
-	}
-      } // iface loop
+	// The printer may have been unplugged, so look again next time...
+	_PAPPL_ATOMIC_ADD(&pappl_usb_changes, 1);
+	device->device = NULL;
+	ret            = false;
+      }
+    }
 
-      libusb_free_config_descriptor(confptr);
-    } // conf loop
+    libusb_unref_device(printer->device);
   }
 
-  match_found:
+  free(printers);
 
-  _PAPPL_DEBUG("pappl_usb_find: device->handle=%p\n", device->handle);
+  _PAPPL_DEBUG("pappl_usb_find: ret=%s\n", ret ? "true" : "false");
 
-  // Clean up ....
-  if (num_udevs >= 0)
-    libusb_free_device_list(udevs, 1);
-
-  return (device->handle != NULL);
+  return (ret);
 }
 
 
@@ -507,6 +417,31 @@ pappl_usb_getid(
 }
 
 
+//
+// 'pappl_usb_hotplug_cb()' - Note that a USB device was added or removed.
+//
+// Hotplug callbacks cannot do any I/O, so the cache is just marked as stale and
+// the next list or open rescans the bus.
+//
+
+static int LIBUSB_CALL			// O - `0` to keep the callback registered
+pappl_usb_hotplug_cb(
+    libusb_context        *ctx,		// I - libusb context (unused)
+    libusb_device         *udevice,	// I - Device (unused)
+    libusb_hotplug_event  event,	// I - Event (unused)
+    void                  *data)	// I - Callback data (unused)
+{
+  (void)ctx;
+  (void)udevice;
+  (void)event;
+  (void)data;
+
+  _PAPPL_ATOMIC_ADD(&pappl_usb_changes, 1);
+
+  return (0);
+}
+
+
 //
 // 'pappl_usb_list()' - List USB devices.
 //
@@ -518,19 +453,7 @@ pappl_usb_list(
     pappl_deverror_cb_t err_cb,		// I - Error callback
     void                *err_data)	// I - Error callback data
 {
-  _pappl_usb_dev_t	usb;		// USB device
-  bool			ret;		// Return value
-
-
-  ret = pappl_usb_find(cb, data, &usb, err_cb, err_data);
-
-  if (usb.handle)
-  {
-    libusb_close(usb.handle);
-    libusb_unref_device(usb.device);
-  }
-
-  return (ret);
+  return (pappl_usb_find(cb, data, NULL, err_cb, err_data));
 }
 
 
@@ -545,6 +468,7 @@ pappl_usb_open(
     const char     *job_name)		// I - Job name (unused)
 {
   _pappl_usb_dev_t	*usb;		// USB device
+  int			i;		// Looping var
 
 
   (void)job_name;
@@ -561,6 +485,14 @@ pappl_usb_open(
     return (false);
   }
 
+  // Allocate the transfers for asynchronous writes - if this fails we just use
+  // synchronous bulk transfers...
+  for (i = 0; i < _PAPPL_USB_MAX_TRANSFERS; i ++)
+  {
+    usb->xfers[i].transfer  = libusb_alloc_transfer(0);
+    usb->xfers[i].completed = 1;
+  }
+
   papplDeviceSetData(device, usb);
 
   return (true);
@@ -591,6 +523,258 @@ pappl_usb_open_cb(
 }
 
 
+//
+// 'pappl_usb_probe()' - Get the printer interface and device ID of a USB device.
+//
+
+static bool				// O - `true` if the device is a printer, `false` otherwise
+pappl_usb_probe(
+    libusb_device        *udevice,	// I - USB device
+    _pappl_usb_printer_t *printer,	// O - Cached printer
+    pappl_deverror_cb_t  err_cb,	// I - Error callback
+    void                 *err_data)	// I - Error callback data
+{
+  bool		found = false;		// Found a printer interface?
+  ssize_t	err;			// Current error
+  _pappl_usb_dev_t usb;			// Temporary connection
+  struct libusb_device_descriptor devdesc;
+					// Current device descriptor
+  struct libusb_config_descriptor *confptr = NULL;
+					// Pointer to current configuration
+  const struct libusb_interface *ifaceptr = NULL;
+					// Pointer to current interface
+  const struct libusb_interface_descriptor *altptr = NULL;
+					// Pointer to current alternate setting
+  const struct libusb_endpoint_descriptor *endpptr = NULL;
+					// Pointer to current endpoint
+  uint8_t	conf,			// Current configuration
+		iface,			// Current interface
+		altset,			// Current alternate setting
+		endp,			// Current endpoint
+		read_endp,		// Current read endpoint
+		write_endp;		// Current write endpoint
+
+
+  // Ignore devices with no configuration data and anything that is not
+  // a printer...
+  if (libusb_get_device_descriptor(udevice, &devdesc) < 0)
+  {
+    _PAPPL_DEBUG("pappl_usb_probe: no descriptor.\n");
+    return (false);
+  }
+
+  _PAPPL_DEBUG("pappl_usb_probe: bLength=%d\n", devdesc.bLength);
+  _PAPPL_DEBUG("pappl_usb_probe: bDescriptorType=%d\n", devdesc.bDescriptorType);
+  _PAPPL_DEBUG("pappl_usb_probe: bcdUSB=%04x\n", devdesc.bcdUSB);
+  _PAPPL_DEBUG("pappl_usb_probe: bDeviceClass=%d\n", devdesc.bDeviceClass);
+  _PAPPL_DEBUG("pappl_usb_probe: bDeviceSubClass=%d\n", devdesc.bDeviceSubClass);
+  _PAPPL_DEBUG("pappl_usb_probe: bDeviceProtocol=%d\n", devdesc.bDeviceProtocol);
+  _PAPPL_DEBUG("pappl_usb_probe: bMaxPacketSize0=%d\n", devdesc.bMaxPacketSize0);
+  _PAPPL_DEBUG("pappl_usb_probe: idVendor=0x%04x\n", devdesc.idVendor);
+  _PAPPL_DEBUG("pappl_usb_probe: idProduct=0x%04x\n", devdesc.idProduct);
+  _PAPPL_DEBUG("pappl_usb_probe: bcdDevice=%04x\n", devdesc.bcdDevice);
+  _PAPPL_DEBUG("pappl_usb_probe: iManufacturer=%d\n", devdesc.iManufacturer);
+  _PAPPL_DEBUG("pappl_usb_probe: iProduct=%d\n", devdesc.iProduct);
+  _PAPPL_DEBUG("pappl_usb_probe: iSerialNumber=%d\n", devdesc.iSerialNumber);
+  _PAPPL_DEBUG("pappl_usb_probe: bNumConfigurations=%d\n", devdesc.bNumConfigurations);
+
+  if (!devdesc.bNumConfigurations || !devdesc.idVendor || !devdesc.idProduct)
+    return (false);
+
+  if (devdesc.idVendor == 0x05ac)
+    return (false);			// Skip Apple devices...
+
+  memset(printer, 0, sizeof(_pappl_usb_printer_t));
+
+  printer->device     = udevice;
+  printer->vendor_id  = devdesc.idVendor;
+  printer->product_id = devdesc.idProduct;
+
+  for (conf = 0; conf < devdesc.bNumConfigurations && !found; conf ++)
+  {
+    if (libusb_get_config_descriptor(udevice, conf, &confptr) < 0)
+    {
+      _PAPPL_DEBUG("pappl_usb_probe:     conf%d - no descriptor\n", conf);
+      continue;
+    }
+
+    _PAPPL_DEBUG("pappl_usb_probe:     conf%d -\n", conf);
+    _PAPPL_DEBUG("pappl_usb_probe:         bNumInterfaces=%d\n", confptr->bNumInterfaces);
+    _PAPPL_DEBUG("pappl_usb_probe:         bConfigurationValue=%d\n", confptr->bConfigurationValue);
+
+    // Some printers offer multiple interfaces...
+    for (iface = 0, ifaceptr = confptr->interface; iface < confptr->bNumInterfaces && !found; iface ++, ifaceptr ++)
+    {
+      if (!ifaceptr->altsetting)
+      {
+	_PAPPL_DEBUG("pappl_usb_probe:         iface%d - no alternate setting\n", iface);
+	continue;
+      }
+
+      _PAPPL_DEBUG("pappl_usb_probe:         iface%d - num_altsetting=%d\n", iface, ifaceptr->num_altsetting);
+
+      printer->protocol   = 0;
+      printer->read_endp  = -1;
+      printer->write_endp = -1;
+
+      for (altset = 0, altptr = ifaceptr->altsetting; (int)altset < ifaceptr->num_altsetting; altset ++, altptr ++)
+      {
+	_PAPPL_DEBUG("pappl_usb_probe:             altset%d - bInterfaceClass=%d, bInterfaceSubClass=%d, bInterfaceProtocol=%d\n", altset, altptr->bInterfaceClass, altptr->bInterfaceSubClass, altptr->bInterfaceProtocol);
+
+	if (altptr->bInterfaceClass != LIBUSB_CLASS_PRINTER || altptr->bInterfaceSubClass != 1)
+	  continue;
+
+	if (altptr->bInterfaceProtocol != 1 && altptr->bInterfaceProtocol != 2)
+	  continue;
+
+	if (altptr->bInterfaceProtocol < printer->protocol || altptr->bInterfaceProtocol > 2)
+	  continue;
+
+	read_endp  = 0xff;
+	write_endp = 0xff;
+
+	for (endp = 0, endpptr = altptr->endpoint; endp < altptr->bNumEndpoints; endp ++, endpptr ++)
+	{
+	  if ((endpptr->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK) == LIBUSB_TRANSFER_TYPE_BULK)
+	  {
+	    if (endpptr->bEndpointAddress & LIBUSB_ENDPOINT_DIR_MASK)
+	      read_endp = endp;
+	    else
+	      write_endp = endp;
+	  }
+	}
+
+	if (write_endp != 0xff)
+	{
+	  // Save the best match so far, using the endpoint addresses...
+	  printer->protocol   = altptr->bInterfaceProtocol;
+	  printer->altset     = altptr->bAlternateSetting;
+	  printer->ifacenum   = altptr->bInterfaceNumber;
+	  printer->write_endp = altptr->endpoint[write_endp].bEndpointAddress;
+	  if (printer->protocol > 1 && read_endp != 0xff)
+	    printer->read_endp = altptr->endpoint[read_endp].bEndpointAddress;
+	  else
+	    printer->read_endp = -1;
+	}
+      }
+
+      _PAPPL_DEBUG("pappl_usb_probe:             protocol=%d\n", printer->protocol);
+
+      if (printer->protocol == 0)
+        continue;
+
+      printer->conf           = conf;
+      printer->iface          = iface;
+      printer->confvalue      = confptr->bConfigurationValue;
+      printer->num_altsetting = ifaceptr->num_altsetting;
+
+      if (!pappl_usb_claim(&usb, printer, err_cb, err_data))
+        continue;
+
+      // Get the 1284 Device ID...
+      if ((err = libusb_control_transfer(usb.handle, LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_ENDPOINT_IN | LIBUSB_RECIPIENT_INTERFACE, 0, (uint16_t)usb.conf, (uint16_t)((usb.iface << 8) | usb.altset), (unsigned char *)printer->device_id, sizeof(printer->device_id), 5000)) < 0)
+      {
+	_papplDeviceError(err_cb, err_data, "Unable to get IEEE-1284 device ID: %s", libusb_strerror((enum libusb_error)err));
+	printer->device_id[0] = '\0';
+      }
+      else
+      {
+	// Build the device URI...
+	const char *make,		// Pointer to make
+		*model,			// Pointer to model
+		*serial = NULL;		// Pointer to serial number
+	char	*ptr,			// Pointer into device ID
+		copy_did[1024],		// Copy of device ID
+		temp[256];		// Temporary string for serial #
+	int	length = ((printer->device_id[0] & 255) << 8) | (printer->device_id[1] & 255);
+					// Length of device ID
+
+	if (length < 14 || length > (int)sizeof(printer->device_id))
+	  length = ((printer->device_id[1] & 255) << 8) | (printer->device_id[0] & 255);
+
+	if (length > (int)sizeof(printer->device_id))
+	  length = (int)sizeof(printer->device_id);
+
+	length -= 2;
+	memmove(printer->device_id, printer->device_id + 2, (size_t)length);
+	printer->device_id[length] = '\0';
+
+	_PAPPL_DEBUG("pappl_usb_probe:     device_id=\"%s\"\n", printer->device_id);
+
+	strlcpy(copy_did, printer->device_id, sizeof(copy_did));
+
+	if ((make = strstr(copy_did, "MANUFACTURER:")) != NULL)
+	  make += 13;
+	else if ((make = strstr(copy_did, "MFG:")) != NULL)
+	  make += 4;
+
+	if ((model = strstr(copy_did, "MODEL:")) != NULL)
+	  model += 6;
+	else if ((model = strstr(copy_did, "MDL:")) != NULL)
+	  model += 4;
+
+	if ((serial = strstr(copy_did, "SERIALNUMBER:")) != NULL)
+	  serial += 12;
+	else if ((serial = strstr(copy_did, "SERN:")) != NULL)
+	  serial += 5;
+	else if ((serial = strstr(copy_did, "SN:")) != NULL)
+	  serial += 3;
+
+	if (serial)
+	{
+	  if ((ptr = strchr(serial, ';')) != NULL)
+	    *ptr = '\0';
+	}
+	else
+	{
+	  length = libusb_get_string_descriptor_ascii(usb.handle, devdesc.iSerialNumber, (unsigned char *)temp, sizeof(temp) - 1);
+	  if (length > 0)
+	  {
+	    temp[length] = '\0';
+	    serial       = temp;
+	  }
+	}
+
+	if (make)
+	{
+	  if ((ptr = strchr(make, ';')) != NULL)
+	    *ptr = '\0';
+	}
+	else
+	  make = "Unknown";
+
+	if (model)
+	{
+	  if ((ptr = strchr(model, ';')) != NULL)
+	    *ptr = '\0';
+	}
+	else
+	  model = "Unknown";
+
+	if (serial)
+	  httpAssembleURIf(HTTP_URI_CODING_ALL, printer->device_uri, sizeof(printer->device_uri), "usb", NULL, make, 0, "/%s?serial=%s", model, serial);
+	else
+	  httpAssembleURIf(HTTP_URI_CODING_ALL, printer->device_uri, sizeof(printer->device_uri), "usb", NULL, make, 0, "/%s", model);
+
+	if (!strcmp(make, "HP") && !strncmp(model, "HP ", 3))
+	  snprintf(printer->device_info, sizeof(printer->device_info), "%s (USB)", model);
+	else
+	  snprintf(printer->device_info, sizeof(printer->device_info), "%s %s (USB)", make, model);
+
+	found = true;
+      }
+
+      libusb_release_interface(usb.handle, usb.ifacenum);
+      libusb_close(usb.handle);
+    } // iface loop
+
+    libusb_free_config_descriptor(confptr);
+  } // conf loop
+
+  return (found);
+}
+
+
 //
 // 'pappl_usb_read()' - Read data from a USB device.
 //
@@ -609,6 +793,10 @@ pappl_usb_read(pappl_device_t *device,	// I - Device
   if (usb->read_endp < 0)
     return (-1);			// No read endpoint!
 
+  // Make sure the printer has all of the data before reading the response...
+  if (!pappl_usb_drain(device, usb))
+    return (-1);
+
   if ((error = libusb_bulk_transfer(usb->handle, (unsigned char)usb->read_endp, buffer, (int)bytes, &icount, 10000)) < 0)
   {
     papplDeviceError(device, "Unable to read from USB port: %s",  libusb_strerror((enum libusb_error)error));
@@ -619,6 +807,148 @@ pappl_usb_read(pappl_device_t *device,	// I - Device
 }
 
 
+//
+// 'pappl_usb_run()' - Handle libusb events so hotplug callbacks are delivered.
+//
+
+static void *				// O - Thread exit status (not used)
+pappl_usb_run(void *data)		// I - Thread data (unused)
+{
+  (void)data;
+
+  for (;;)
+  {
+    if (libusb_handle_events(NULL) < 0)
+      sleep(1);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'pappl_usb_scan()' - Update the cache of connected USB printers.
+//
+// The caller must hold the cache mutex.  Devices that are already cached are
+// not opened again, so only newly connected devices are probed.
+//
+
+static bool				// O - `true` on success, `false` on error
+pappl_usb_scan(
+    pappl_deverror_cb_t err_cb,		// I - Error callback
+    void                *err_data)	// I - Error callback data
+{
+  ssize_t		err,		// Current error
+			i,		// Looping var
+			num_udevs;	// Number of USB devices
+  libusb_device		**udevs;	// USB devices
+  int			changes;	// Current number of hotplug events
+  _pappl_usb_printer_t	*printer,	// Current cached printer
+			**prevptr,	// Pointer to previous printer
+			temp;		// Newly probed printer
+
+
+  if (!pappl_usb_initialized)
+  {
+    // Initialize libusb and watch for devices coming and going...
+    pthread_t	tid;			// Event thread ID
+
+    if ((err = libusb_init(NULL)) != 0)
+    {
+      _papplDeviceError(err_cb, err_data, "Unable to initialize USB access: %s", libusb_strerror((enum libusb_error)err));
+      return (false);
+    }
+
+    pappl_usb_initialized = true;
+
+    if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG) && libusb_hotplug_register_callback(NULL, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT, 0, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, pappl_usb_hotplug_cb, NULL, NULL) == LIBUSB_SUCCESS)
+    {
+      if (pthread_create(&tid, NULL, (void *(*)(void *))pappl_usb_run, NULL))
+      {
+        _papplDeviceError(err_cb, err_data, "Unable to create USB event thread: %s", strerror(errno));
+      }
+      else
+      {
+        pthread_detach(tid);
+        pappl_usb_hotplug = true;
+      }
+    }
+  }
+
+  // Without hotplug events the bus has to be checked every time...
+  changes = _PAPPL_ATOMIC_GET(&pappl_usb_changes);
+
+  if (pappl_usb_hotplug && pappl_usb_scanned && changes == pappl_usb_scan_changes)
+    return (true);
+
+  num_udevs = libusb_get_device_list(NULL, &udevs);
+
+  _PAPPL_DEBUG("pappl_usb_scan: num_udevs=%d\n", (int)num_udevs);
+
+  if (num_udevs < 0)
+  {
+    _papplDeviceError(err_cb, err_data, "Unable to get list of USB devices: %s", libusb_strerror((enum libusb_error)num_udevs));
+    return (false);
+  }
+
+  // Forget printers that are no longer connected...
+  for (prevptr = &pappl_usb_printers, printer = pappl_usb_printers; printer; printer = *prevptr)
+  {
+    for (i = 0; i < num_udevs; i ++)
+    {
+      if (udevs[i] == printer->device)
+        break;
+    }
+
+    if (i < num_udevs)
+    {
+      prevptr = &printer->next;
+      continue;
+    }
+
+    *prevptr = printer->next;
+
+    libusb_unref_device(printer->device);
+    free(printer);
+    pappl_usb_num_printers --;
+  }
+
+  // Then probe the devices we haven't seen before...
+  for (i = 0; i < num_udevs; i ++)
+  {
+    for (printer = pappl_usb_printers; printer; printer = printer->next)
+    {
+      if (printer->device == udevs[i])
+        break;
+    }
+
+    if (printer || !pappl_usb_probe(udevs[i], &temp, err_cb, err_data))
+      continue;
+
+    if ((printer = malloc(sizeof(_pappl_usb_printer_t))) == NULL)
+      break;
+
+    *printer = temp;
+
+    libusb_ref_device(printer->device);
+
+    // Add to the end of the list to keep the bus order...
+    for (prevptr = &pappl_usb_printers; *prevptr; prevptr = &(*prevptr)->next);
+
+    printer->next = NULL;
+    *prevptr      = printer;
+    pappl_usb_num_printers ++;
+  }
+
+  libusb_free_device_list(udevs, 1);
+
+  pappl_usb_scanned      = true;
+  pappl_usb_scan_changes = changes;
+
+  return (true);
+}
+
+
 //
 // 'pappl_usb_status()' - Get the USB printer status.
 //
@@ -655,9 +985,60 @@ pappl_usb_status(pappl_device_t *device)// I - Device
 }
 
 
+//
+// 'pappl_usb_wait()' - Wait for a write to finish.
+//
+// This function handles libusb events until the transfer is complete and then
+// reports any error using the device error callback.
+//
+
+static bool				// O - `true` on success, `false` on error
+pappl_usb_wait(
+    pappl_device_t    *device,		// I - Device
+    _pappl_usb_xfer_t *xfer)		// I - Transfer
+{
+  struct libusb_transfer *transfer = xfer->transfer;
+					// libusb transfer
+
+
+  if (!xfer->submitted)
+    return (true);
+
+  while (!xfer->completed)
+  {
+    if (libusb_handle_events_completed(NULL, &xfer->completed) < 0 && !xfer->completed)
+    {
+      // Give the transfer a chance to finish by canceling it...
+      libusb_cancel_transfer(transfer);
+    }
+  }
+
+  xfer->submitted = false;
+
+  if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+  {
+    if (transfer->status != LIBUSB_TRANSFER_CANCELLED)
+      papplDeviceError(device, "Unable to write %d bytes to USB port: %s", transfer->length, transfer->status == LIBUSB_TRANSFER_STALL ? "Endpoint stalled" : transfer->status == LIBUSB_TRANSFER_NO_DEVICE ? "Device disconnected" : transfer->status == LIBUSB_TRANSFER_TIMED_OUT ? "Timed out" : "Transfer failed");
+
+    return (false);
+  }
+  else if (transfer->actual_length < transfer->length)
+  {
+    papplDeviceError(device, "Only wrote %d of %d bytes to USB port.", transfer->actual_length, transfer->length);
+    return (false);
+  }
+
+  return (true);
+}
+
+
 //
 // 'pappl_usb_write()' - Write data to a USB device.
 //
+// Writes are copied and submitted asynchronously so that the next line can be
+// rendered while the previous one is sent to the printer.  Errors from
+// earlier writes are reported when the transfer is reused.
+//
 
 static ssize_t				// O - Bytes written
 pappl_usb_write(pappl_device_t *device,	// I - Device
@@ -666,16 +1047,78 @@ pappl_usb_write(pappl_device_t *device,	// I - Device
 {
   _pappl_usb_dev_t	*usb = (_pappl_usb_dev_t *)papplDeviceGetData(device);
 					// USB device data
+  _pappl_usb_xfer_t	*xfer = usb->xfers + usb->next_xfer;
+					// Next transfer
+  unsigned char		*xbuffer;	// New transfer buffer
   int			icount;		// Bytes that were written
   int			error;		// USB transfer error
 
 
-  if ((error = libusb_bulk_transfer(usb->handle, (unsigned char)usb->write_endp, (unsigned char *)buffer, (int)bytes, &icount, 0)) < 0)
+  // Wait for the oldest write to finish...
+  if (!pappl_usb_wait(device, xfer))
+  {
+    pappl_usb_drain(device, usb);
+    return (-1);
+  }
+
+  if (!xfer->transfer || bytes > INT_MAX)
   {
+    // No transfer available, write synchronously after any pending writes...
+    if (!pappl_usb_drain(device, usb))
+      return (-1);
+
+    if ((error = libusb_bulk_transfer(usb->handle, (unsigned char)usb->write_endp, (unsigned char *)buffer, (int)bytes, &icount, 0)) < 0)
+    {
+      papplDeviceError(device, "Unable to write %d bytes to USB port: %s", (int)bytes, libusb_strerror((enum libusb_error)error));
+      return (-1);
+    }
+    else
+      return ((ssize_t)icount);
+  }
+
+  // Copy the data and submit the transfer...
+  if (bytes > xfer->bufsize)
+  {
+    if ((xbuffer = realloc(xfer->buffer, bytes)) == NULL)
+    {
+      papplDeviceError(device, "Unable to allocate memory for USB transfer: %s", strerror(errno));
+      return (-1);
+    }
+
+    xfer->buffer  = xbuffer;
+    xfer->bufsize = bytes;
+  }
+
+  memcpy(xfer->buffer, buffer, bytes);
+
+  libusb_fill_bulk_transfer(xfer->transfer, usb->handle, (unsigned char)usb->write_endp, xfer->buffer, (int)bytes, pappl_usb_write_cb, xfer, 0);
+
+  xfer->completed = 0;
+
+  if ((error = libusb_submit_transfer(xfer->transfer)) < 0)
+  {
+    xfer->completed = 1;
     papplDeviceError(device, "Unable to write %d bytes to USB port: %s", (int)bytes, libusb_strerror((enum libusb_error)error));
     return (-1);
   }
-  else
-    return ((ssize_t)icount);
+
+  xfer->submitted = true;
+  usb->next_xfer  = (usb->next_xfer + 1) % _PAPPL_USB_MAX_TRANSFERS;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'pappl_usb_write_cb()' - Mark an asynchronous write as finished.
+//
+// This is called by libusb from whichever thread is handling events.
+//
+
+static void LIBUSB_CALL
+pappl_usb_write_cb(
+    struct libusb_transfer *transfer)	// I - libusb transfer
+{
+  ((_pappl_usb_xfer_t *)transfer->user_data)->completed = 1;
 }
 #endif // HAVE_LIBUSB
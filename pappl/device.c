@@ -12,6 +12,9 @@
 // Include necessary headers...
 //
 
+#ifdef __linux
+#  define _GNU_SOURCE			// For pthread_setaffinity_np()
+#endif // __linux
 #include "device-private.h"
 #include "printer.h"
 #include <stdarg.h>
@@ -30,10 +33,30 @@ typedef struct _pappl_devscheme_s	// Device scheme data
   pappl_devclose_cb_t	close_cb;		// Close callback
   pappl_devread_cb_t	read_cb;		// Read callback
   pappl_devwrite_cb_t	write_cb;		// Write callback
+  pappl_devwritev_cb_t	writev_cb;		// Vectored write callback, if any
   pappl_devid_cb_t	id_cb;			// IEEE-1284 device ID callback, if any
   pappl_devstatus_cb_t	status_cb;		// Status callback, if any
 } _pappl_devscheme_t;
 
+typedef struct _pappl_devlist_s		// Device list data shared by schemes
+{
+  pthread_mutex_t	mutex;			// Mutex for callbacks
+  pappl_device_cb_t	cb;			// Device callback
+  void			*data;			// User data for device callback
+  pappl_deverror_cb_t	err_cb;			// Error callback
+  void			*err_data;		// Data for error callback
+  cups_array_t		*seen;			// Device URIs and IDs already reported
+  bool			done;			// Did the device callback return `true`?
+} _pappl_devlist_t;
+
+typedef struct _pappl_devlister_s	// Device scheme lister thread
+{
+  _pappl_devlist_t	*list;			// Shared device list data
+  _pappl_devscheme_t	*ds;			// Device scheme
+  pthread_t		thread_id;		// Thread ID
+  bool			running;		// Is the thread running?
+} _pappl_devlister_t;
+
 
 //
 // Local globals...
@@ -49,9 +72,19 @@ static cups_array_t	*device_schemes = NULL;
 // Local functions...
 //
 
+static unsigned long long pappl_add_timing(size_t *hist, unsigned long long *total, unsigned long long starttime);
 static int		pappl_compare_schemes(_pappl_devscheme_t *a, _pappl_devscheme_t *b);
 static void		pappl_default_error_cb(const char *message, void *data);
+static bool		pappl_list_cb(const char *device_info, const char *device_uri, const char *device_id, _pappl_devlist_t *list);
+static void		pappl_list_error_cb(const char *message, _pappl_devlist_t *list);
+static void		*pappl_list_run(_pappl_devlister_t *lister);
+static unsigned long long pappl_nsecs(void);
+static ssize_t		pappl_output_add(pappl_device_t *device, const void *buffer, size_t bytes);
+static void		*pappl_output_run(pappl_device_t *device);
+static bool		pappl_output_wait(pappl_device_t *device);
 static ssize_t		pappl_write(pappl_device_t *device, const void *buffer, size_t bytes);
+static ssize_t		pappl_write_device(pappl_device_t *device, const void *buffer, size_t bytes);
+static ssize_t		pappl_writev(pappl_device_t *device, const pappl_iovec_t *iov, int iovcnt);
 
 
 //
@@ -104,6 +137,37 @@ papplDeviceAddScheme(
     pappl_devwrite_cb_t  write_cb,	// I - Write callback
     pappl_devstatus_cb_t status_cb,	// I - Status callback, if any
     pappl_devid_cb_t     id_cb)		// I - IEEE-1284 device ID callback, if any
+{
+  papplDeviceAddScheme2(scheme, dtype, list_cb, open_cb, close_cb, read_cb, write_cb, NULL, status_cb, id_cb);
+}
+
+
+//
+// 'papplDeviceAddScheme2()' - Add a device URI scheme with vectored writes.
+//
+// This function registers a device URI scheme like @link papplDeviceAddScheme@
+// with an additional "writev_cb" callback that writes an array of buffers to
+// the device in as few operations as possible.  The callback must write all of
+// the data and return the total number of bytes written or `-1` on error.
+//
+// Devices without a vectored write callback have each buffer written using the
+// "write_cb" callback.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplDeviceAddScheme2(
+    const char           *scheme,	// I - URI scheme
+    pappl_devtype_t        dtype,		// I - Device type (`PAPPL_DEVTYPE_CUSTOM_LOCAL` or `PAPPL_DEVTYPE_CUSTOM_NETWORK`)
+    pappl_devlist_cb_t   list_cb,	// I - List devices callback, if any
+    pappl_devopen_cb_t   open_cb,	// I - Open callback
+    pappl_devclose_cb_t  close_cb,	// I - Close callback
+    pappl_devread_cb_t   read_cb,	// I - Read callback
+    pappl_devwrite_cb_t  write_cb,	// I - Write callback
+    pappl_devwritev_cb_t writev_cb,	// I - Vectored write callback, if any
+    pappl_devstatus_cb_t status_cb,	// I - Status callback, if any
+    pappl_devid_cb_t     id_cb)		// I - IEEE-1284 device ID callback, if any
 {
   _pappl_devscheme_t	*ds,		// Device URI scheme data
 			dkey;		// Search key
@@ -140,6 +204,7 @@ papplDeviceAddScheme(
       ds->close_cb  = close_cb;
       ds->read_cb   = read_cb;
       ds->write_cb  = write_cb;
+      ds->writev_cb = writev_cb;
       ds->status_cb = status_cb;
       ds->id_cb     = id_cb;
 
@@ -179,6 +244,38 @@ _papplDeviceAddSupportedSchemes(
 }
 
 
+//
+// '_papplDeviceAddTimings()' - Add timing metrics to a running total.
+//
+// The longest and stalled write times are the maximum of the two values.
+//
+
+void
+_papplDeviceAddTimings(
+    pappl_devtimings_t       *dst,	// I - Total timing metrics
+    const pappl_devtimings_t *src)	// I - Timing metrics to add
+{
+  int	i;				// Looping var
+
+
+  dst->read_nsecs   += src->read_nsecs;
+  dst->status_nsecs += src->status_nsecs;
+  dst->write_nsecs  += src->write_nsecs;
+
+  if (src->write_max_nsecs > dst->write_max_nsecs)
+    dst->write_max_nsecs = src->write_max_nsecs;
+  if (src->write_stall_nsecs > dst->write_stall_nsecs)
+    dst->write_stall_nsecs = src->write_stall_nsecs;
+
+  for (i = 0; i < PAPPL_DEVTIMINGS_BUCKETS; i ++)
+  {
+    dst->read_hist[i]   += src->read_hist[i];
+    dst->status_hist[i] += src->status_hist[i];
+    dst->write_hist[i]  += src->write_hist[i];
+  }
+}
+
+
 //
 // 'papplDeviceClose()' - Close a device connection.
 //
@@ -195,7 +292,10 @@ papplDeviceClose(
     if (device->bufused > 0)
       pappl_write(device, device->buffer, device->bufused);
 
+    _papplDeviceStopOutput(device);
+
     (device->close_cb)(device);
+    free(device->buffer);
     free(device);
   }
 }
@@ -276,6 +376,24 @@ papplDeviceFlush(pappl_device_t *device)// I - Device
 }
 
 
+//
+// 'papplDeviceGetBufferSize()' - Get the size of the device write buffer.
+//
+// This function returns the size of the buffer used by the
+// @link papplDevicePrintf@, @link papplDevicePuts@, @link papplDeviceWrite@,
+// and @link papplDeviceWritev@ functions.
+//
+// @since PAPPL 1.1@
+//
+
+size_t					// O - Size of write buffer in bytes
+papplDeviceGetBufferSize(
+    pappl_device_t *device)		// I - Device
+{
+  return (device ? device->bufsize : 0);
+}
+
+
 //
 // 'papplDeviceGetData()' - Get device-specific data.
 //
@@ -309,8 +427,7 @@ papplDeviceGetID(
     char           *buffer,		// I - Buffer for IEEE-1284 device ID
     size_t         bufsize)		// I - Size of buffer
 {
-  struct timeval	starttime,	// Start time
-			endtime;	// End time
+  unsigned long long	starttime;	// Start time
   char			*ret;		// Return value
 
 
@@ -321,15 +438,16 @@ papplDeviceGetID(
   if (!device || !device->id_cb || !buffer || bufsize < 64)
     return (NULL);
 
+  // Let the output thread finish writing before talking to the device...
+  pappl_output_wait(device);
+
   // Get the device ID and collect timing metrics...
-  gettimeofday(&starttime, NULL);
+  starttime = pappl_nsecs();
 
   ret = (device->id_cb)(device, buffer, bufsize);
 
-  gettimeofday(&endtime, NULL);
-
   device->metrics.status_requests ++;
-  device->metrics.status_msecs += (size_t)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000);
+  pappl_add_timing(device->timings.status_hist, &device->timings.status_nsecs, starttime);
 
   // Return the device ID
   return (ret);
@@ -345,6 +463,9 @@ papplDeviceGetID(
 // used for performance measurement and optimization during development of a
 // printer application.  It can also be useful diagnostic information.
 //
+// Use the @link papplDeviceGetTimings@ function to get the durations with
+// nanosecond precision and latency histograms.
+//
 
 pappl_devmetrics_t *			// O - Metrics data
 papplDeviceGetMetrics(
@@ -352,7 +473,13 @@ papplDeviceGetMetrics(
     pappl_devmetrics_t *metrics)	// I - Buffer for metrics data
 {
   if (device && metrics)
+  {
     memcpy(metrics, &device->metrics, sizeof(pappl_devmetrics_t));
+
+    metrics->read_msecs   = (size_t)(device->timings.read_nsecs / 1000000);
+    metrics->status_msecs = (size_t)(device->timings.status_nsecs / 1000000);
+    metrics->write_msecs  = (size_t)(device->timings.write_nsecs / 1000000);
+  }
   else if (metrics)
     memset(metrics, 0, sizeof(pappl_devmetrics_t));
 
@@ -387,29 +514,70 @@ pappl_preason_t				// O - IPP "printer-state-reasons" values
 papplDeviceGetStatus(
     pappl_device_t *device)		// I - Device
 {
-  struct timeval	starttime,	// Start time
-			endtime;	// End time
+  unsigned long long	starttime;	// Start time
   pappl_preason_t	status = PAPPL_PREASON_NONE;
 					// IPP "printer-state-reasons" values
 
 
   if (device)
   {
-    gettimeofday(&starttime, NULL);
+    pappl_output_wait(device);
+
+    starttime = pappl_nsecs();
 
     if (device->status_cb)
       status = (device->status_cb)(device);
 
-    gettimeofday(&endtime, NULL);
-
     device->metrics.status_requests ++;
-    device->metrics.status_msecs += (size_t)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000);
+    pappl_add_timing(device->timings.status_hist, &device->timings.status_nsecs, starttime);
   }
 
   return (status);
 }
 
 
+//
+// 'papplDeviceGetTimings()' - Get the device timing metrics.
+//
+// This function returns a copy of the device timing metrics, which include the
+// total duration (in nanoseconds) and a latency histogram of read, status, and
+// write requests for the current session, along with the longest write
+// request.  Durations are measured using a monotonic clock.
+//
+// Bucket `N` of each histogram counts the requests that took less than 4^N
+// microseconds, except for the last bucket which counts all longer requests.
+//
+// The "write_stall_nsecs" member reports how long the current write request,
+// if any, has been waiting.  Since this function may be called from another
+// thread while a job is writing to the device, it can be used to detect a
+// stalled printer.  The other members are only consistent when called from
+// the thread using the device.
+//
+// @since PAPPL 1.1@
+//
+
+pappl_devtimings_t *			// O - Timing metrics
+papplDeviceGetTimings(
+    pappl_device_t     *device,		// I - Device
+    pappl_devtimings_t *timings)	// I - Buffer for timing metrics
+{
+  unsigned long long	write_start;	// Start of current write request
+
+
+  if (device && timings)
+  {
+    memcpy(timings, &device->timings, sizeof(pappl_devtimings_t));
+
+    if ((write_start = _PAPPL_ATOMIC_GET(&device->write_start)) != 0)
+      timings->write_stall_nsecs = pappl_nsecs() - write_start;
+  }
+  else if (timings)
+    memset(timings, 0, sizeof(pappl_devtimings_t));
+
+  return (timings);
+}
+
+
 //
 // 'papplDeviceIsSupported()' - Determine whether a given URI is supported.
 //
@@ -481,6 +649,12 @@ papplDeviceIsSupported(
 // Any errors are reported using the supplied "err_cb" function.  If you specify
 // `NULL` for this argument, errors are sent to `stderr`.
 //
+// When more than one URI scheme is listed, the schemes are searched at the same
+// time and devices are reported as they are found.  The callback functions are
+// never called concurrently, and a device that is found by more than one
+// scheme (same IEEE-1284 manufacturer, model, and serial number) is only
+// reported once.
+//
 // > Note: This function will block (not return) until each of the device URI
 // > schemes has reported all of the devices *or* the supplied callback function
 // > returns `true`.
@@ -496,6 +670,10 @@ papplDeviceList(
 {
   bool			ret = false;	// Return value
   _pappl_devscheme_t	*ds;		// Current device scheme
+  _pappl_devlist_t	list;		// Shared device list data
+  _pappl_devlister_t	*listers;	// Lister threads
+  int			i,		// Looping var
+			num_listers = 0;// Number of lister threads
 
 
   if (!device_schemes)
@@ -510,14 +688,70 @@ papplDeviceList(
   if (!err_cb)
     err_cb = pappl_default_error_cb;
 
-  for (ds = (_pappl_devscheme_t *)cupsArrayFirst(device_schemes); ds && !ret; ds = (_pappl_devscheme_t *)cupsArrayNext(device_schemes))
+  for (ds = (_pappl_devscheme_t *)cupsArrayFirst(device_schemes); ds; ds = (_pappl_devscheme_t *)cupsArrayNext(device_schemes))
   {
     if ((types & ds->dtype) && ds->list_cb)
-      ret = (ds->list_cb)(cb, data, err_cb, err_data);
+      num_listers ++;
+  }
+
+  if (num_listers < 2 || (listers = calloc((size_t)num_listers, sizeof(_pappl_devlister_t))) == NULL)
+  {
+    // List one scheme at a time...
+    for (ds = (_pappl_devscheme_t *)cupsArrayFirst(device_schemes); ds && !ret; ds = (_pappl_devscheme_t *)cupsArrayNext(device_schemes))
+    {
+      if ((types & ds->dtype) && ds->list_cb)
+	ret = (ds->list_cb)(cb, data, err_cb, err_data);
+    }
+
+    pthread_rwlock_unlock(&device_rwlock);
+
+    return (ret);
+  }
+
+  // Search all of the schemes at the same time...
+  memset(&list, 0, sizeof(list));
+  pthread_mutex_init(&list.mutex, NULL);
+  list.cb       = cb;
+  list.data     = data;
+  list.err_cb   = err_cb;
+  list.err_data = err_data;
+  list.seen     = cupsArrayNew3((cups_array_func_t)strcmp, NULL, NULL, 0, (cups_acopy_func_t)strdup, (cups_afree_func_t)free);
+
+  for (i = 0, ds = (_pappl_devscheme_t *)cupsArrayFirst(device_schemes); ds && i < num_listers; ds = (_pappl_devscheme_t *)cupsArrayNext(device_schemes))
+  {
+    if (!(types & ds->dtype) || !ds->list_cb)
+      continue;
+
+    listers[i].list = &list;
+    listers[i].ds   = ds;
+
+    if (pthread_create(&listers[i].thread_id, NULL, (void *(*)(void *))pappl_list_run, listers + i))
+    {
+      // Unable to create a thread, list this scheme from here...
+      pappl_list_run(listers + i);
+    }
+    else
+    {
+      listers[i].running = true;
+    }
+
+    i ++;
+  }
+
+  for (i = 0; i < num_listers; i ++)
+  {
+    if (listers[i].running)
+      pthread_join(listers[i].thread_id, NULL);
   }
 
   pthread_rwlock_unlock(&device_rwlock);
 
+  ret = list.done;
+
+  cupsArrayDelete(list.seen);
+  pthread_mutex_destroy(&list.mutex);
+  free(listers);
+
   return (ret);
 }
 
@@ -587,12 +821,15 @@ papplDeviceOpen(
     return (NULL);
   }
 
-  if ((device = calloc(1, sizeof(pappl_device_t))) == NULL)
+  if ((device = calloc(1, sizeof(pappl_device_t))) == NULL || (device->buffer = malloc(PAPPL_DEVICE_BUFSIZE)) == NULL)
   {
     _papplDeviceError(err_cb, err_data, "Unable to allocate memory for device: %s", strerror(errno));
+    free(device);
     return (NULL);
   }
 
+  device->bufsize    = PAPPL_DEVICE_BUFSIZE;
+
   device->close_cb   = ds->close_cb;
   device->error_cb   = err_cb ? err_cb : pappl_default_error_cb;
   device->error_data = err_data;
@@ -600,9 +837,11 @@ papplDeviceOpen(
   device->read_cb    = ds->read_cb;
   device->status_cb  = ds->status_cb;
   device->write_cb   = ds->write_cb;
+  device->writev_cb  = ds->writev_cb;
 
   if (!(ds->open_cb)(device, device_uri, name))
   {
+    free(device->buffer);
     free(device);
     return (NULL);
   }
@@ -742,8 +981,7 @@ papplDeviceRead(
     void           *buffer,		// I - Read buffer
     size_t         bytes)		// I - Max bytes to read
 {
-  struct timeval	starttime,	// Start time
-			endtime;	// End time
+  unsigned long long	starttime;	// Start time
   ssize_t		count;		// Bytes read this time
 
 
@@ -754,14 +992,14 @@ papplDeviceRead(
   if (device->bufused > 0)
     papplDeviceFlush(device);
 
-  gettimeofday(&starttime, NULL);
+  pappl_output_wait(device);
 
-  count = (device->read_cb)(device, buffer, bytes);
+  starttime = pappl_nsecs();
 
-  gettimeofday(&endtime, NULL);
+  count = (device->read_cb)(device, buffer, bytes);
 
   device->metrics.read_requests ++;
-  device->metrics.read_msecs += (size_t)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000);
+  pappl_add_timing(device->timings.read_hist, &device->timings.read_nsecs, starttime);
   if (count > 0)
     device->metrics.read_bytes += (size_t)count;
 
@@ -769,6 +1007,50 @@ papplDeviceRead(
 }
 
 
+//
+// 'papplDeviceSetBufferSize()' - Set the size of the device write buffer.
+//
+// This function sets the size of the buffer used to collect small writes
+// before they are sent to the device.  Writes that are at least this large
+// are sent directly to the device.  Any pending data is flushed first.  Pass
+// `0` to restore the default size of 8192 bytes.
+//
+// Larger buffers reduce the number of writes for fast network printers while
+// smaller buffers reduce the latency for slow serial or USB printers.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplDeviceSetBufferSize(
+    pappl_device_t *device,		// I - Device
+    size_t         bufsize)		// I - Size of write buffer in bytes or `0` for the default
+{
+  char	*buffer;			// New write buffer
+
+
+  if (!device)
+    return;
+
+  if (bufsize == 0)
+    bufsize = PAPPL_DEVICE_BUFSIZE;
+
+  if (bufsize == device->bufsize)
+    return;
+
+  papplDeviceFlush(device);
+
+  if ((buffer = realloc(device->buffer, bufsize)) == NULL)
+  {
+    papplDeviceError(device, "Unable to allocate %u byte write buffer: %s", (unsigned)bufsize, strerror(errno));
+    return;
+  }
+
+  device->buffer  = buffer;
+  device->bufsize = bufsize;
+}
+
+
 //
 // 'papplDeviceSetData()' - Set device-specific data.
 //
@@ -804,7 +1086,19 @@ papplDeviceWrite(
   if (!device)
     return (-1);
 
-  if ((device->bufused + bytes) > sizeof(device->buffer))
+  if (bytes >= device->bufsize && device->writev_cb)
+  {
+    // Send any buffered data along with this data...
+    pappl_iovec_t	iov;		// I/O vector
+
+
+    iov.buffer = buffer;
+    iov.bytes  = bytes;
+
+    return (papplDeviceWritev(device, &iov, 1));
+  }
+
+  if ((device->bufused + bytes) > device->bufsize)
   {
     // Flush the write buffer...
     if (pappl_write(device, device->buffer, device->bufused) < 0)
@@ -813,7 +1107,7 @@ papplDeviceWrite(
     device->bufused = 0;
   }
 
-  if (bytes < sizeof(device->buffer))
+  if (bytes < device->bufsize)
   {
     memcpy(device->buffer + device->bufused, buffer, bytes);
     device->bufused += bytes;
@@ -824,6 +1118,395 @@ papplDeviceWrite(
 }
 
 
+//
+// 'papplDeviceWriteLine()' - Compress and write a line of raster data.
+//
+// This function compresses a line of raster data using
+// @link papplDeviceCompressLine@ directly into the device's write buffer,
+// preceded by the optional "prefix", which is a `printf` format string with a
+// single "%u" for the number of compressed bytes, for example "\033*b%uW" for
+// a PCL raster row.  The "prefix" string must not come from an untrusted
+// source.
+//
+// Call the @link papplDeviceFlush@ function to ensure that the line is
+// immediately sent to the device.
+//
+// @since PAPPL 1.1@
+//
+
+ssize_t					// O - Number of bytes written or -1 on error
+papplDeviceWriteLine(
+    pappl_device_t      *device,	// I - Device
+    pappl_devcomp_t     comp,		// I - Compression method
+    const unsigned char *line,		// I - Line to write
+    const unsigned char *prev,		// I - Previous line or `NULL` for none
+    size_t              bytes,		// I - Number of bytes in line
+    const char          *prefix)	// I - Format string for prefix or `NULL` for none
+{
+  size_t	maxsize,		// Maximum size of prefix and compressed line
+		count;			// Number of bytes in compressed line
+  int		plen = 0;		// Length of prefix
+  char		ptemp[64];		// Formatted prefix
+  unsigned char	*data;			// Compressed data
+
+
+  if (!device || !line)
+    return (-1);
+
+  maxsize = PAPPL_DEVCOMP_BUFSIZE(bytes) + sizeof(ptemp);
+
+  if (maxsize > device->bufsize)
+  {
+    // The line doesn't fit in the write buffer, compress to a temporary
+    // buffer...
+    unsigned char *buffer;		// Temporary buffer
+    ssize_t	ret = 0;		// Return value
+
+    if ((buffer = malloc(maxsize)) == NULL)
+      return (-1);
+
+    count = papplDeviceCompressLine(comp, line, prev, bytes, buffer);
+
+    if (prefix)
+    {
+      snprintf(ptemp, sizeof(ptemp), prefix, (unsigned)count);
+      ret = papplDevicePuts(device, ptemp);
+    }
+
+    if (ret >= 0 && papplDeviceWrite(device, buffer, count) >= 0)
+      ret += (ssize_t)count;
+    else
+      ret = -1;
+
+    free(buffer);
+
+    return (ret);
+  }
+
+  if ((device->bufused + maxsize) > device->bufsize)
+  {
+    // Flush the write buffer...
+    if (pappl_write(device, device->buffer, device->bufused) < 0)
+      return (-1);
+
+    device->bufused = 0;
+  }
+
+  // Compress the line after room for the prefix and then move the compressed
+  // data up against the prefix...
+  data  = (unsigned char *)device->buffer + device->bufused + sizeof(ptemp);
+  count = papplDeviceCompressLine(comp, line, prev, bytes, data);
+
+  if (prefix && (plen = snprintf(ptemp, sizeof(ptemp), prefix, (unsigned)count)) > 0)
+  {
+    if ((size_t)plen >= sizeof(ptemp))
+      plen = (int)sizeof(ptemp) - 1;
+
+    memcpy(device->buffer + device->bufused, ptemp, (size_t)plen);
+  }
+  else
+    plen = 0;
+
+  memmove(device->buffer + device->bufused + plen, data, count);
+  device->bufused += (size_t)plen + count;
+
+  return ((ssize_t)((size_t)plen + count));
+}
+
+
+//
+// 'papplDeviceWritev()' - Write multiple buffers to a device.
+//
+// This function writes an array of buffers to the device.  Small amounts of
+// data are copied to the write buffer like @link papplDeviceWrite@.  Otherwise
+// any buffered data and the buffers are passed to the device together so that
+// they can be sent without copying, for example using the `writev` system
+// call for network and file devices.
+//
+// @since PAPPL 1.1@
+//
+
+ssize_t					// O - Number of bytes written or -1 on error
+papplDeviceWritev(
+    pappl_device_t      *device,	// I - Device
+    const pappl_iovec_t *iov,		// I - Buffers to write
+    int                 iovcnt)		// I - Number of buffers
+{
+  int		i,			// Looping var
+		count;			// Number of buffers in this write
+  size_t	total = 0;		// Total bytes to write
+  pappl_iovec_t	vec[_PAPPL_DEVICE_MAX_IOV];
+					// Buffers for this write
+
+
+  if (!device || (!iov && iovcnt > 0) || iovcnt < 0)
+    return (-1);
+
+  for (i = 0; i < iovcnt; i ++)
+    total += iov[i].bytes;
+
+  if ((device->bufused + total) < device->bufsize || !device->writev_cb)
+  {
+    // Buffer or write each buffer in turn - papplDeviceWrite only calls back
+    // into this function for large writes when there is a writev callback,
+    // and here the buffers either fit in the write buffer or there is none...
+    for (i = 0; i < iovcnt; i ++)
+    {
+      if (papplDeviceWrite(device, iov[i].buffer, iov[i].bytes) < 0)
+        return (-1);
+    }
+
+    return ((ssize_t)total);
+  }
+
+  // Pass the buffered data and buffers to the device...
+  for (count = 0, i = 0; i < iovcnt;)
+  {
+    if (count == 0 && device->bufused > 0)
+    {
+      vec[0].buffer = device->buffer;
+      vec[0].bytes  = device->bufused;
+      count         = 1;
+    }
+
+    while (i < iovcnt && count < _PAPPL_DEVICE_MAX_IOV)
+      vec[count ++] = iov[i ++];
+
+    if (pappl_writev(device, vec, count) < 0)
+      return (-1);
+
+    device->bufused = 0;
+    count           = 0;
+  }
+
+  return ((ssize_t)total);
+}
+
+
+//
+// '_papplDeviceStartOutput()' - Start writing to a device from a separate thread.
+//
+// Data written to the device is copied to a bounded queue and sent to the
+// device by an output thread, so that the caller only blocks when the queue is
+// full.  The "policy" argument specifies the scheduling policy (`SCHED_FIFO`
+// or `SCHED_RR`, `0` for the default) and "cpus" specifies a CPU affinity mask
+// (`0` for any CPU).  Failure to apply the scheduling policy or affinity is
+// reported but does not prevent the output thread from running.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplDeviceStartOutput(
+    pappl_device_t *device,		// I - Device
+    int            policy,		// I - Scheduling policy or `0` for default
+    int            priority,		// I - Scheduling priority
+    unsigned       cpus,		// I - CPU affinity mask or `0` for any
+    size_t         queue_size)		// I - Queue size in bytes or `0` for default
+{
+  int	error;				// Error code
+
+
+  if (!device || device->output_queue)
+    return (device != NULL);
+
+  if (queue_size == 0)
+    queue_size = _PAPPL_DEVICE_QUEUESIZE;
+  else if (queue_size < device->bufsize)
+    queue_size = device->bufsize;
+
+  if ((device->output_queue = malloc(queue_size)) == NULL)
+  {
+    papplDeviceError(device, "Unable to allocate output queue: %s", strerror(errno));
+    return (false);
+  }
+
+  device->output_size  = queue_size;
+  device->output_head  = 0;
+  device->output_used  = 0;
+  device->output_error = false;
+  device->output_stop  = false;
+
+  pthread_mutex_init(&device->output_mutex, NULL);
+  pthread_cond_init(&device->output_cond, NULL);
+
+  if ((error = pthread_create(&device->output_thread, NULL, (void *(*)(void *))pappl_output_run, device)) != 0)
+  {
+    papplDeviceError(device, "Unable to create output thread: %s", strerror(error));
+    pthread_cond_destroy(&device->output_cond);
+    pthread_mutex_destroy(&device->output_mutex);
+    free(device->output_queue);
+    device->output_queue = NULL;
+    return (false);
+  }
+
+  if (policy == SCHED_FIFO || policy == SCHED_RR)
+  {
+    struct sched_param	param;		// Scheduling parameters
+
+    memset(&param, 0, sizeof(param));
+
+    if (priority < sched_get_priority_min(policy))
+      priority = sched_get_priority_min(policy);
+    else if (priority > sched_get_priority_max(policy))
+      priority = sched_get_priority_max(policy);
+
+    param.sched_priority = priority;
+
+    if ((error = pthread_setschedparam(device->output_thread, policy, &param)) != 0)
+      papplDeviceError(device, "Unable to set output thread priority: %s", strerror(error));
+  }
+
+#ifdef __linux
+  if (cpus)
+  {
+    cpu_set_t	cpuset;			// CPU affinity
+    unsigned	cpu;			// Current CPU
+
+    CPU_ZERO(&cpuset);
+    for (cpu = 0; cpu < 8 * sizeof(cpus); cpu ++)
+    {
+      if (cpus & (1U << cpu))
+        CPU_SET(cpu, &cpuset);
+    }
+
+    if ((error = pthread_setaffinity_np(device->output_thread, sizeof(cpuset), &cpuset)) != 0)
+      papplDeviceError(device, "Unable to set output thread CPU affinity: %s", strerror(error));
+  }
+#endif // __linux
+
+  return (true);
+}
+
+
+//
+// '_papplDeviceStopOutput()' - Drain the output queue and stop the output thread.
+//
+
+void
+_papplDeviceStopOutput(
+    pappl_device_t *device)		// I - Device
+{
+  if (!device || !device->output_queue)
+    return;
+
+  pthread_mutex_lock(&device->output_mutex);
+  device->output_stop = true;
+  pthread_cond_broadcast(&device->output_cond);
+  pthread_mutex_unlock(&device->output_mutex);
+
+  pthread_join(device->output_thread, NULL);
+
+  pthread_cond_destroy(&device->output_cond);
+  pthread_mutex_destroy(&device->output_mutex);
+  free(device->output_queue);
+
+  device->output_queue = NULL;
+  device->output_size  = 0;
+  device->output_used  = 0;
+}
+
+
+#if !_WIN32
+//
+// '_papplDeviceWritevFd()' - Write multiple buffers to a file descriptor.
+//
+// This function is used by the file and network devices to implement the
+// vectored write callback.  Partial writes are retried until all of the data
+// is written.
+//
+
+ssize_t					// O - Number of bytes written or `-1` on error
+_papplDeviceWritevFd(
+    int                 fd,		// I - File descriptor
+    const pappl_iovec_t *iov,		// I - Buffers to write
+    int                 iovcnt)		// I - Number of buffers
+{
+  struct iovec	vec[_PAPPL_DEVICE_MAX_IOV],
+					// System I/O vectors
+		*vecptr;		// Current I/O vector
+  int		i,			// Looping var
+		count;			// Number of vectors remaining
+  ssize_t	total = 0,		// Total bytes written
+		written;		// Bytes written this time
+
+
+  while (iovcnt > 0)
+  {
+    // Copy the next group of buffers...
+    count = iovcnt > _PAPPL_DEVICE_MAX_IOV ? _PAPPL_DEVICE_MAX_IOV : iovcnt;
+
+    for (i = 0; i < count; i ++)
+    {
+      vec[i].iov_base = (void *)iov[i].buffer;
+      vec[i].iov_len  = iov[i].bytes;
+    }
+
+    iov    += count;
+    iovcnt -= count;
+    vecptr = vec;
+
+    // Write them, advancing past anything written by a partial write...
+    while (count > 0)
+    {
+      if ((written = writev(fd, vecptr, count)) < 0)
+      {
+	if (errno == EINTR || errno == EAGAIN)
+	  continue;
+
+	return (-1);
+      }
+
+      total += written;
+
+      while (count > 0 && (size_t)written >= vecptr->iov_len)
+      {
+        written -= (ssize_t)vecptr->iov_len;
+        vecptr ++;
+        count --;
+      }
+
+      if (count > 0)
+      {
+        vecptr->iov_base = (char *)vecptr->iov_base + written;
+        vecptr->iov_len  -= (size_t)written;
+      }
+    }
+  }
+
+  return (total);
+}
+#endif // !_WIN32
+
+
+//
+// 'pappl_add_timing()' - Add the duration of a request to the timing metrics.
+//
+
+static unsigned long long		// O - Duration in nanoseconds
+pappl_add_timing(
+    size_t             *hist,		// I - Latency histogram
+    unsigned long long *total,		// I - Total nanoseconds
+    unsigned long long starttime)	// I - Start time from @code pappl_nsecs@
+{
+  unsigned long long	nsecs,		// Duration in nanoseconds
+			limit;		// Upper bound of current bucket
+  int			i;		// Looping var
+
+
+  nsecs = pappl_nsecs() - starttime;
+
+  for (i = 0, limit = 1000; i < (PAPPL_DEVTIMINGS_BUCKETS - 1); i ++, limit *= 4)
+  {
+    if (nsecs < limit)
+      break;
+  }
+
+  hist[i] ++;
+  *total += nsecs;
+
+  return (nsecs);
+}
+
+
 //
 // 'pappl_compare_schemes()' - Compare two device URI schemes.
 //
@@ -853,7 +1536,273 @@ pappl_default_error_cb(
 
 
 //
-// 'pappl_write()' - Write data to the device.
+// 'pappl_list_cb()' - Report a device found by one of several schemes.
+//
+
+static bool				// O - `true` to stop listing, `false` to continue
+pappl_list_cb(
+    const char       *device_info,	// I - Device description
+    const char       *device_uri,	// I - Device URI
+    const char       *device_id,	// I - IEEE-1284 device ID
+    _pappl_devlist_t *list)		// I - Device list data
+{
+  bool		ret;			// Return value
+  int		num_did;		// Number of device ID keys/values
+  cups_option_t	*did;			// Device ID keys/values
+  const char	*make,			// Manufacturer
+		*model,			// Model name
+		*serial;		// Serial number
+  char		key[1024];		// Device ID key for duplicates
+
+
+  pthread_mutex_lock(&list->mutex);
+
+  if (list->done)
+  {
+    // Another scheme's callback already asked to stop...
+    pthread_mutex_unlock(&list->mutex);
+    return (true);
+  }
+
+  if (cupsArrayFind(list->seen, (void *)device_uri))
+  {
+    pthread_mutex_unlock(&list->mutex);
+    return (false);
+  }
+
+  // The same printer reported by different schemes has different URIs, so
+  // also look for a matching make, model, and serial number...
+  key[0]  = '\0';
+  num_did = papplDeviceParseID(device_id, &did);
+
+  if ((make = cupsGetOption("MANUFACTURER", num_did, did)) == NULL)
+    make = cupsGetOption("MFG", num_did, did);
+  if ((model = cupsGetOption("MODEL", num_did, did)) == NULL)
+    model = cupsGetOption("MDL", num_did, did);
+  if ((serial = cupsGetOption("SERIALNUMBER", num_did, did)) == NULL)
+    serial = cupsGetOption("SN", num_did, did);
+
+  if (make && model && serial && *serial)
+    snprintf(key, sizeof(key), "%s\t%s\t%s", make, model, serial);
+
+  cupsFreeOptions(num_did, did);
+
+  if (key[0] && cupsArrayFind(list->seen, key))
+  {
+    pthread_mutex_unlock(&list->mutex);
+    return (false);
+  }
+
+  ret = (list->cb)(device_info, device_uri, device_id, list->data);
+
+  if (ret)
+  {
+    list->done = true;
+  }
+  else
+  {
+    cupsArrayAdd(list->seen, (void *)device_uri);
+    if (key[0])
+      cupsArrayAdd(list->seen, key);
+  }
+
+  pthread_mutex_unlock(&list->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'pappl_list_error_cb()' - Report an error from one of several schemes.
+//
+
+static void
+pappl_list_error_cb(
+    const char       *message,		// I - Error message
+    _pappl_devlist_t *list)		// I - Device list data
+{
+  pthread_mutex_lock(&list->mutex);
+  (list->err_cb)(message, list->err_data);
+  pthread_mutex_unlock(&list->mutex);
+}
+
+
+//
+// 'pappl_list_run()' - List the devices for one scheme.
+//
+
+static void *				// O - Thread exit status (not used)
+pappl_list_run(
+    _pappl_devlister_t *lister)		// I - Lister thread data
+{
+  (lister->ds->list_cb)((pappl_device_cb_t)pappl_list_cb, lister->list, (pappl_deverror_cb_t)pappl_list_error_cb, lister->list);
+
+  return (NULL);
+}
+
+
+//
+// 'pappl_nsecs()' - Get the current monotonic time in nanoseconds.
+//
+
+static unsigned long long		// O - Current time in nanoseconds
+pappl_nsecs(void)
+{
+#ifdef CLOCK_MONOTONIC
+  struct timespec	curtime;	// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+
+  return ((unsigned long long)curtime.tv_sec * 1000000000 + (unsigned long long)curtime.tv_nsec);
+
+#else
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((unsigned long long)curtime.tv_sec * 1000000000 + (unsigned long long)curtime.tv_usec * 1000);
+#endif // CLOCK_MONOTONIC
+}
+
+
+//
+// 'pappl_output_add()' - Add data to the output queue.
+//
+// The caller waits while the queue is full.
+//
+
+static ssize_t				// O - Number of bytes queued or `-1` on error
+pappl_output_add(
+    pappl_device_t *device,		// I - Device
+    const void     *buffer,		// I - Buffer
+    size_t         bytes)		// I - Bytes to queue
+{
+  const char	*ptr = (const char *)buffer;
+					// Pointer into buffer
+  size_t	total = bytes,		// Total bytes to queue
+		tail,			// Offset of first free byte
+		count;			// Bytes to copy this time
+
+
+  pthread_mutex_lock(&device->output_mutex);
+
+  while (bytes > 0)
+  {
+    while (device->output_used == device->output_size && !device->output_error)
+      pthread_cond_wait(&device->output_cond, &device->output_mutex);
+
+    if (device->output_error)
+    {
+      pthread_mutex_unlock(&device->output_mutex);
+      return (-1);
+    }
+
+    // Copy as much as fits before the end of the ring buffer...
+    tail  = (device->output_head + device->output_used) % device->output_size;
+    count = device->output_size - device->output_used;
+
+    if (count > device->output_size - tail)
+      count = device->output_size - tail;
+    if (count > bytes)
+      count = bytes;
+
+    memcpy(device->output_queue + tail, ptr, count);
+
+    device->output_used += count;
+    ptr                 += count;
+    bytes               -= count;
+
+    pthread_cond_broadcast(&device->output_cond);
+  }
+
+  pthread_mutex_unlock(&device->output_mutex);
+
+  return ((ssize_t)total);
+}
+
+
+//
+// 'pappl_output_run()' - Send queued data to the device.
+//
+
+static void *				// O - Thread exit status (not used)
+pappl_output_run(
+    pappl_device_t *device)		// I - Device
+{
+  size_t	count;			// Bytes to write this time
+
+
+  pthread_mutex_lock(&device->output_mutex);
+
+  for (;;)
+  {
+    while (device->output_used == 0 && !device->output_stop)
+      pthread_cond_wait(&device->output_cond, &device->output_mutex);
+
+    if (device->output_used == 0)
+      break;
+
+    // Write the oldest contiguous run of data - the bytes stay in the queue
+    // until they have been written so the writer cannot reuse them...
+    if ((count = device->output_size - device->output_head) > device->output_used)
+      count = device->output_used;
+
+    pthread_mutex_unlock(&device->output_mutex);
+
+    if (pappl_write_device(device, device->output_queue + device->output_head, count) < 0)
+    {
+      pthread_mutex_lock(&device->output_mutex);
+      device->output_error = true;
+      device->output_head  = 0;
+      device->output_used  = 0;
+    }
+    else
+    {
+      pthread_mutex_lock(&device->output_mutex);
+      device->output_head = (device->output_head + count) % device->output_size;
+      device->output_used -= count;
+    }
+
+    pthread_cond_broadcast(&device->output_cond);
+  }
+
+  pthread_mutex_unlock(&device->output_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'pappl_output_wait()' - Wait for the output queue to drain.
+//
+
+static bool				// O - `true` on success, `false` on write error
+pappl_output_wait(
+    pappl_device_t *device)		// I - Device
+{
+  bool	ret;				// Return value
+
+
+  if (!device->output_queue)
+    return (true);
+
+  pthread_mutex_lock(&device->output_mutex);
+
+  while (device->output_used > 0 && !device->output_error)
+    pthread_cond_wait(&device->output_cond, &device->output_mutex);
+
+  ret = !device->output_error;
+
+  pthread_mutex_unlock(&device->output_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'pappl_write()' - Write data to the device or output queue.
 //
 
 static ssize_t				// O - Number of bytes written or `-1` on error
@@ -861,19 +1810,90 @@ pappl_write(pappl_device_t *device,	// I - Device
             const void     *buffer,	// I - Buffer
             size_t         bytes)	// I - Bytes to write
 {
-  struct timeval	starttime,	// Start time
-			endtime;	// End time
+  if (device->output_queue)
+    return (pappl_output_add(device, buffer, bytes));
+  else
+    return (pappl_write_device(device, buffer, bytes));
+}
+
+
+//
+// 'pappl_write_device()' - Write data to the device.
+//
+
+static ssize_t				// O - Number of bytes written or `-1` on error
+pappl_write_device(
+    pappl_device_t *device,		// I - Device
+    const void     *buffer,		// I - Buffer
+    size_t         bytes)		// I - Bytes to write
+{
+  unsigned long long	starttime,	// Start time
+			nsecs;		// Duration
   ssize_t		count;		// Total bytes written
 
 
-  gettimeofday(&starttime, NULL);
+  // Record the start time so that a stalled write can be seen while it is
+  // still blocked in the callback...
+  starttime = pappl_nsecs();
+  _PAPPL_ATOMIC_SET(&device->write_start, starttime);
 
   count = (device->write_cb)(device, buffer, bytes);
 
-  gettimeofday(&endtime, NULL);
+  _PAPPL_ATOMIC_SET(&device->write_start, 0);
+
+  device->metrics.write_requests ++;
+  if ((nsecs = pappl_add_timing(device->timings.write_hist, &device->timings.write_nsecs, starttime)) > device->timings.write_max_nsecs)
+    device->timings.write_max_nsecs = nsecs;
+  if (count > 0)
+    device->metrics.write_bytes += (size_t)count;
+
+  return (count);
+}
+
+
+//
+// 'pappl_writev()' - Write multiple buffers to the device.
+//
+
+static ssize_t				// O - Number of bytes written or `-1` on error
+pappl_writev(
+    pappl_device_t      *device,	// I - Device
+    const pappl_iovec_t *iov,		// I - Buffers to write
+    int                 iovcnt)		// I - Number of buffers
+{
+  unsigned long long	starttime,	// Start time
+			nsecs;		// Duration
+  ssize_t		count;		// Total bytes written
+
+
+  if (device->output_queue)
+  {
+    // Queue each buffer for the output thread...
+    int	i;				// Looping var
+
+    for (count = 0, i = 0; i < iovcnt; i ++)
+    {
+      if (pappl_output_add(device, iov[i].buffer, iov[i].bytes) < 0)
+        return (-1);
+
+      count += (ssize_t)iov[i].bytes;
+    }
+
+    return (count);
+  }
+
+  // Record the start time so that a stalled write can be seen while it is
+  // still blocked in the callback...
+  starttime = pappl_nsecs();
+  _PAPPL_ATOMIC_SET(&device->write_start, starttime);
+
+  count = (device->writev_cb)(device, iov, iovcnt);
+
+  _PAPPL_ATOMIC_SET(&device->write_start, 0);
 
   device->metrics.write_requests ++;
-  device->metrics.write_msecs += (size_t)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000);
+  if ((nsecs = pappl_add_timing(device->timings.write_hist, &device->timings.write_nsecs, starttime)) > device->timings.write_max_nsecs)
+    device->timings.write_max_nsecs = nsecs;
   if (count > 0)
     device->metrics.write_bytes += (size_t)count;
 
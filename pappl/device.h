@@ -1,7 +1,7 @@
 //
 // Device communication functions for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -26,10 +26,27 @@ extern "C" {
 #  endif // __cplusplus
 
 
+//
+// Limits...
+//
+
+#  define PAPPL_DEVTIMINGS_BUCKETS 13	// Number of device latency histogram buckets
+#  define PAPPL_DEVCOMP_BUFSIZE(bytes) (2 * (bytes) + 8)
+					// Size of buffer for a compressed line @since PAPPL 1.1@
+
+
 //
 // Types...
 //
 
+typedef enum pappl_devcomp_e		// Line compression methods @since PAPPL 1.1@
+{
+  PAPPL_DEVCOMP_NONE,				// No compression
+  PAPPL_DEVCOMP_PACKBITS,			// PackBits (TIFF, PCL mode 2)
+  PAPPL_DEVCOMP_DELTAROW,			// Delta row (PCL mode 3)
+  PAPPL_DEVCOMP_ZPL				// ZPL compressed ASCII hex
+} pappl_devcomp_t;
+
 typedef struct pappl_devmetrics_s	// Device metrics
 {
   size_t	read_bytes;			// Total number of bytes read
@@ -42,6 +59,21 @@ typedef struct pappl_devmetrics_s	// Device metrics
   size_t	write_msecs;			// Total number of milliseconds spent writing
 } pappl_devmetrics_t;
 
+typedef struct pappl_devtimings_s	// Device timing metrics @since PAPPL 1.1@
+{
+  unsigned long long read_nsecs;		// Total number of nanoseconds spent reading
+  unsigned long long status_nsecs;		// Total number of nanoseconds spent getting status
+  unsigned long long write_nsecs;		// Total number of nanoseconds spent writing
+  unsigned long long write_max_nsecs;		// Longest completed write request in nanoseconds
+  unsigned long long write_stall_nsecs;		// Nanoseconds spent in the current write request or `0` if none
+  size_t	read_hist[PAPPL_DEVTIMINGS_BUCKETS];
+						// Read requests by duration
+  size_t	status_hist[PAPPL_DEVTIMINGS_BUCKETS];
+						// Status requests by duration
+  size_t	write_hist[PAPPL_DEVTIMINGS_BUCKETS];
+						// Write requests by duration
+} pappl_devtimings_t;
+
 enum pappl_devtype_e			// Device type bit values
 {
   PAPPL_DEVTYPE_FILE = 0x01,			// Local file/directory
@@ -58,6 +90,12 @@ enum pappl_devtype_e			// Device type bit values
 };
 typedef unsigned pappl_devtype_t;		// Device type bitfield
 
+typedef struct pappl_iovec_s		// I/O vector for vectored writes
+{
+  const void	*buffer;			// Data to write
+  size_t	bytes;				// Number of bytes to write
+} pappl_iovec_t;
+
 typedef bool (*pappl_device_cb_t)(const char *device_info, const char *device_uri, const char *device_id, void *data);
 					// Device callback - return `true` to stop, `false` to continue
 typedef void (*pappl_devclose_cb_t)(pappl_device_t *device);
@@ -76,6 +114,8 @@ typedef pappl_preason_t (*pappl_devstatus_cb_t)(pappl_device_t *device);
 					// Device status callback
 typedef ssize_t (*pappl_devwrite_cb_t)(pappl_device_t *device, const void *buffer, size_t bytes);
 					// Device write callback
+typedef ssize_t (*pappl_devwritev_cb_t)(pappl_device_t *device, const pappl_iovec_t *iov, int iovcnt);
+					// Device vectored write callback
 
 
 //
@@ -83,13 +123,18 @@ typedef ssize_t (*pappl_devwrite_cb_t)(pappl_device_t *device, const void *buffe
 //
 
 extern void		papplDeviceAddScheme(const char *scheme, pappl_devtype_t dtype, pappl_devlist_cb_t list_cb, pappl_devopen_cb_t open_cb, pappl_devclose_cb_t close_cb, pappl_devread_cb_t read_cb, pappl_devwrite_cb_t write_cb, pappl_devstatus_cb_t status_cb, pappl_devid_cb_t id_cb) _PAPPL_PUBLIC;
+extern void		papplDeviceAddScheme2(const char *scheme, pappl_devtype_t dtype, pappl_devlist_cb_t list_cb, pappl_devopen_cb_t open_cb, pappl_devclose_cb_t close_cb, pappl_devread_cb_t read_cb, pappl_devwrite_cb_t write_cb, pappl_devwritev_cb_t writev_cb, pappl_devstatus_cb_t status_cb, pappl_devid_cb_t id_cb) _PAPPL_PUBLIC;
 extern void		papplDeviceClose(pappl_device_t *device) _PAPPL_PUBLIC;
+extern size_t		papplDeviceCompressLine(pappl_devcomp_t comp, const unsigned char *line, const unsigned char *prev, size_t bytes, unsigned char *buffer) _PAPPL_PUBLIC;
 extern void		papplDeviceError(pappl_device_t *device, const char *message, ...) _PAPPL_PUBLIC _PAPPL_FORMAT(2,3);
 extern void		papplDeviceFlush(pappl_device_t *device) _PAPPL_PUBLIC;
+extern size_t		papplDeviceGetBufferSize(pappl_device_t *device) _PAPPL_PUBLIC;
 extern void		*papplDeviceGetData(pappl_device_t *device) _PAPPL_PUBLIC;
 extern char		*papplDeviceGetID(pappl_device_t *device, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern pappl_devmetrics_t *papplDeviceGetMetrics(pappl_device_t *device, pappl_devmetrics_t *metrics) _PAPPL_PUBLIC;
 extern pappl_preason_t	papplDeviceGetStatus(pappl_device_t *device) _PAPPL_PUBLIC;
+extern pappl_devtimings_t *papplDeviceGetTimings(pappl_device_t *device, pappl_devtimings_t *timings) _PAPPL_PUBLIC;
+extern bool		papplDeviceIsBlankLine(const unsigned char *line, size_t bytes, unsigned char blank) _PAPPL_PUBLIC;
 extern bool		papplDeviceIsSupported(const char *uri) _PAPPL_PUBLIC;
 extern bool		papplDeviceList(pappl_devtype_t types, pappl_device_cb_t cb, void *data, pappl_deverror_cb_t err_cb, void *err_data) _PAPPL_PUBLIC;
 extern pappl_device_t	*papplDeviceOpen(const char *device_uri, const char *name, pappl_deverror_cb_t err_cb, void *err_data) _PAPPL_PUBLIC;
@@ -97,8 +142,11 @@ extern int		papplDeviceParseID(const char *device_id, cups_option_t **pairs) _PA
 extern ssize_t		papplDevicePrintf(pappl_device_t *device, const char *format, ...) _PAPPL_PUBLIC _PAPPL_FORMAT(2, 3);
 extern ssize_t		papplDevicePuts(pappl_device_t *device, const char *s) _PAPPL_PUBLIC;
 extern ssize_t		papplDeviceRead(pappl_device_t *device, void *buffer, size_t bytes) _PAPPL_PUBLIC;
+extern void		papplDeviceSetBufferSize(pappl_device_t *device, size_t bufsize) _PAPPL_PUBLIC;
 extern void		papplDeviceSetData(pappl_device_t *device, void *data) _PAPPL_PUBLIC;
 extern ssize_t		papplDeviceWrite(pappl_device_t *device, const void *buffer, size_t bytes) _PAPPL_PUBLIC;
+extern ssize_t		papplDeviceWriteLine(pappl_device_t *device, pappl_devcomp_t comp, const unsigned char *line, const unsigned char *prev, size_t bytes, const char *prefix) _PAPPL_PUBLIC;
+extern ssize_t		papplDeviceWritev(pappl_device_t *device, const pappl_iovec_t *iov, int iovcnt) _PAPPL_PUBLIC;
 
 
 //
@@ -34,6 +34,14 @@ static _pappl_dns_sd_t	pappl_dns_sd_master = NULL;
 					// DNS-SD master reference
 static pthread_mutex_t	pappl_dns_sd_mutex = PTHREAD_MUTEX_INITIALIZER;
 					// DNS-SD master mutex
+static pappl_system_t	*pappl_dns_sd_system = NULL;
+					// System that started DNS-SD
+#ifdef HAVE_MDNSRESPONDER
+static int		pappl_dns_sd_pipe[2] = { -1, -1 };
+					// Wakeup pipe for DNS-SD thread
+static pthread_t	pappl_dns_sd_thread;
+					// DNS-SD thread
+#endif // HAVE_MDNSRESPONDER
 #ifdef HAVE_AVAHI
 static AvahiThreadedPoll *pappl_dns_sd_poll = NULL;
 					// Avahi background thread
@@ -44,6 +52,7 @@ static AvahiThreadedPoll *pappl_dns_sd_poll = NULL;
 // Local functions...
 //
 
+static void		dns_sd_cache_txt(pappl_printer_t *printer, const char *key, const unsigned char *txt, size_t txtlen);
 static void		dns_sd_geo_to_loc(const char *geo, unsigned char loc[16]);
 #ifdef HAVE_MDNSRESPONDER
 static void DNSSD_API	dns_sd_printer_callback(DNSServiceRef sdRef, DNSServiceFlags flags, DNSServiceErrorType errorCode, const char *name, const char *regtype, const char *domain, pappl_printer_t *printer);
@@ -77,7 +86,6 @@ _papplDNSSDInit(
 {
 #ifdef HAVE_MDNSRESPONDER
   int		error;			// Error code, if any
-  pthread_t	tid;			// Thread ID
 
 
   pthread_mutex_lock(&pappl_dns_sd_mutex);
@@ -90,14 +98,24 @@ _papplDNSSDInit(
 
   if ((error = DNSServiceCreateConnection(&pappl_dns_sd_master)) == kDNSServiceErr_NoError)
   {
-    if (pthread_create(&tid, NULL, dns_sd_run, system))
+    if (pipe(pappl_dns_sd_pipe))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create DNS-SD wakeup pipe: %s", strerror(errno));
+      pappl_dns_sd_pipe[0] = pappl_dns_sd_pipe[1] = -1;
+      DNSServiceRefDeallocate(pappl_dns_sd_master);
+      pappl_dns_sd_master = NULL;
+    }
+    else if (pthread_create(&pappl_dns_sd_thread, NULL, dns_sd_run, system))
     {
       papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create DNS-SD thread: %s", strerror(errno));
+      close(pappl_dns_sd_pipe[0]);
+      close(pappl_dns_sd_pipe[1]);
+      pappl_dns_sd_pipe[0] = pappl_dns_sd_pipe[1] = -1;
       DNSServiceRefDeallocate(pappl_dns_sd_master);
       pappl_dns_sd_master = NULL;
     }
     else
-      pthread_detach(tid);
+      pappl_dns_sd_system = system;
   }
   else
   {
@@ -136,6 +154,7 @@ _papplDNSSDInit(
   {
     // Start the background thread...
     avahi_threaded_poll_start(pappl_dns_sd_poll);
+    pappl_dns_sd_system = system;
   }
 
   pthread_mutex_unlock(&pappl_dns_sd_mutex);
@@ -280,6 +299,53 @@ _papplDNSSDStrError(int error)		// I - Error code
 }
 
 
+//
+// '_papplDNSSDShutdown()' - Stop DNS-SD services.
+//
+// This function stops the background DNS-SD thread and frees the master
+// reference if they were started for the specified system, since the thread
+// logs to that system.  The system's services must already be unregistered.
+// A later call to @code _papplDNSSDInit@ starts them again.
+//
+
+void
+_papplDNSSDShutdown(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&pappl_dns_sd_mutex);
+
+  if (!pappl_dns_sd_master || (pappl_dns_sd_system && pappl_dns_sd_system != system))
+  {
+    pthread_mutex_unlock(&pappl_dns_sd_mutex);
+    return;
+  }
+
+#ifdef HAVE_MDNSRESPONDER
+  // Wake up the thread and wait for it to exit...
+  write(pappl_dns_sd_pipe[1], "", 1);
+  pthread_join(pappl_dns_sd_thread, NULL);
+
+  close(pappl_dns_sd_pipe[0]);
+  close(pappl_dns_sd_pipe[1]);
+  pappl_dns_sd_pipe[0] = pappl_dns_sd_pipe[1] = -1;
+
+  DNSServiceRefDeallocate(pappl_dns_sd_master);
+
+#elif defined(HAVE_AVAHI)
+  // Stop the background thread before freeing the client...
+  avahi_threaded_poll_stop(pappl_dns_sd_poll);
+  avahi_client_free(pappl_dns_sd_master);
+  avahi_threaded_poll_free(pappl_dns_sd_poll);
+  pappl_dns_sd_poll = NULL;
+#endif // HAVE_MDNSRESPONDER
+
+  pappl_dns_sd_master = NULL;
+  pappl_dns_sd_system = NULL;
+
+  pthread_mutex_unlock(&pappl_dns_sd_mutex);
+}
+
+
 //
 // '_papplDNSSDUnlock()' - Release a lock after making DNS-SD changes.
 //
@@ -297,6 +363,9 @@ _papplDNSSDUnlock(void)
 //
 // '_papplPrinterRegisterDNSSDNoLock()' - Register a printer's DNS-SD service.
 //
+// When only the TXT records have changed since the last registration, the
+// existing services are updated in place instead of being registered again.
+//
 
 bool					// O - `true` on success, `false` on failure
 _papplPrinterRegisterDNSSDNoLock(
@@ -321,6 +390,12 @@ _papplPrinterRegisterDNSSDNoLock(
 			urf[252],	// List of supported URF values
 			*ptr;		// Pointer into string
   char			regtype[256];	// DNS-SD service type
+  char			key[1024];	// Service key
+  bool			raw,		// Register the AppSocket service?
+			force;		// Force a new registration?
+  _pappl_txt_t		pdltxt;		// DNS-SD TXT record for AppSocket
+  unsigned char		txtdata[1024];	// TXT record data for the cache
+  size_t		txtlen;		// Length of TXT record data
   char			product[248];	// Make and model (legacy)
   int			max_width;	// Maximum media width (legacy)
   const char		*papermax;	// PaperMax string value (legacy)
@@ -336,14 +411,17 @@ _papplPrinterRegisterDNSSDNoLock(
   if (!printer->dns_sd_name || !printer->system->is_running)
     return (false);
 
+  force                  = printer->dns_sd_update;
+  printer->dns_sd_update = false;
+
   papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Registering DNS-SD name '%s' on '%s'", printer->dns_sd_name, printer->system->hostname);
 
   // Get attributes and values for the TXT record...
-  color_supported           = ippFindAttribute(printer->driver_attrs, "color-supported", IPP_TAG_BOOLEAN);
-  document_format_supported = ippFindAttribute(printer->driver_attrs, "document-format-supported", IPP_TAG_MIMETYPE);
-  printer_kind              = ippFindAttribute(printer->driver_attrs, "printer-kind", IPP_TAG_KEYWORD);
+  color_supported           = _papplPrinterFindDriverAttr(printer, "color-supported", IPP_TAG_BOOLEAN);
+  document_format_supported = _papplPrinterFindDriverAttr(printer, "document-format-supported", IPP_TAG_MIMETYPE);
+  printer_kind              = _papplPrinterFindDriverAttr(printer, "printer-kind", IPP_TAG_KEYWORD);
   printer_uuid              = ippFindAttribute(printer->attrs, "printer-uuid", IPP_TAG_URI);
-  urf_supported             = ippFindAttribute(printer->driver_attrs, "urf-supported", IPP_TAG_KEYWORD);
+  urf_supported             = _papplPrinterFindDriverAttr(printer, "urf-supported", IPP_TAG_KEYWORD);
 
   for (i = 0, count = ippGetCount(document_format_supported), ptr = formats; i < count; i ++)
   {
@@ -466,6 +544,12 @@ _papplPrinterRegisterDNSSDNoLock(
 
   if ((master = _papplDNSSDInit(printer->system)) == NULL)
     return (false);
+
+  // Everything but the TXT records is part of the service key - when the key
+  // is unchanged the existing services just get new TXT records...
+  raw = (system->options & PAPPL_SOPTIONS_RAW_SOCKET) && printer->num_raw_listeners > 0;
+
+  snprintf(key, sizeof(key), "%s\n%s\n%d\n%s\n%s\n%s\n%d\n%d", printer->dns_sd_name, system->hostname, system->port, system->subtypes ? system->subtypes : "", printer->geo_location ? printer->geo_location : "", printer->uriname, !(system->options & PAPPL_SOPTIONS_NO_TLS), raw);
 #endif // HAVE_DNSSD
 
 #ifdef HAVE_MDNSRESPONDER
@@ -500,6 +584,72 @@ _papplPrinterRegisterDNSSDNoLock(
   TXTRecordSetValue(&txt, "PaperMax", (uint8_t)strlen(papermax), papermax);
   TXTRecordSetValue(&txt, "Scan", 1, "F");
 
+  if (raw)
+  {
+    // Build the TXT record for the PDL datastream (raw socket) service...
+    TXTRecordCreate(&pdltxt, 1024, NULL);
+    if (printer->driver_data.make_and_model[0])
+      TXTRecordSetValue(&pdltxt, "ty", (uint8_t)strlen(printer->driver_data.make_and_model), printer->driver_data.make_and_model);
+    TXTRecordSetValue(&pdltxt, "adminurl", (uint8_t)strlen(adminurl), adminurl);
+    if (printer->location)
+      TXTRecordSetValue(&pdltxt, "note", (uint8_t)strlen(printer->location), printer->location);
+    else
+      TXTRecordSetValue(&pdltxt, "note", 0, "");
+    TXTRecordSetValue(&pdltxt, "pdl", (uint8_t)strlen(formats), formats);
+    if ((value = ippGetString(printer_uuid, 0, NULL)) != NULL)
+      TXTRecordSetValue(&pdltxt, "UUID", (uint8_t)strlen(value) - 9, value + 9);
+    TXTRecordSetValue(&pdltxt, "Color", 1, ippGetBoolean(color_supported, 0) ? "T" : "F");
+    TXTRecordSetValue(&pdltxt, "Duplex", 1, (printer->driver_data.sides_supported & PAPPL_SIDES_TWO_SIDED_LONG_EDGE) ? "T" : "F");
+    TXTRecordSetValue(&pdltxt, "txtvers", 1, "1");
+    TXTRecordSetValue(&pdltxt, "qtotal", 1, "1");
+    TXTRecordSetValue(&pdltxt, "priority", 3, "100");
+
+    // Legacy keys...
+    TXTRecordSetValue(&pdltxt, "product", (uint8_t)strlen(product), product);
+    TXTRecordSetValue(&pdltxt, "Fax", 1, "F");
+    TXTRecordSetValue(&pdltxt, "PaperMax", (uint8_t)strlen(papermax), papermax);
+    TXTRecordSetValue(&pdltxt, "Scan", 1, "F");
+  }
+
+  if ((txtlen = TXTRecordGetLength(&txt)) > sizeof(txtdata))
+    txtlen = sizeof(txtdata);
+  memcpy(txtdata, TXTRecordGetBytesPtr(&txt), txtlen);
+
+  if (printer->dns_sd_ipp_ref && !force && printer->dns_sd_key && !strcmp(printer->dns_sd_key, key))
+  {
+    // Same services, just update the TXT records if they have changed...
+    if (printer->dns_sd_txtlen != txtlen || memcmp(printer->dns_sd_txt, txtdata, txtlen))
+    {
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Updating DNS-SD TXT records for '%s'.", printer->dns_sd_name);
+
+      if ((error = DNSServiceUpdateRecord(printer->dns_sd_ipp_ref, NULL, 0, TXTRecordGetLength(&txt), TXTRecordGetBytesPtr(&txt), 0)) != kDNSServiceErr_NoError)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._ipp._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      if (printer->dns_sd_ipps_ref && (error = DNSServiceUpdateRecord(printer->dns_sd_ipps_ref, NULL, 0, TXTRecordGetLength(&txt), TXTRecordGetBytesPtr(&txt), 0)) != kDNSServiceErr_NoError)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._ipps._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      if (raw && printer->dns_sd_pdl_ref && (error = DNSServiceUpdateRecord(printer->dns_sd_pdl_ref, NULL, 0, TXTRecordGetLength(&pdltxt), TXTRecordGetBytesPtr(&pdltxt), 0)) != kDNSServiceErr_NoError)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._pdl-datastream._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      dns_sd_cache_txt(printer, ret ? key : NULL, txtdata, txtlen);
+    }
+
+    TXTRecordDeallocate(&txt);
+    if (raw)
+      TXTRecordDeallocate(&pdltxt);
+
+    return (ret);
+  }
+
   // Register the _printer._tcp (LPD) service type with a port number of 0 to
   // defend our service name but not actually support LPD...
   if (printer->dns_sd_printer_ref)
@@ -572,44 +722,25 @@ _papplPrinterRegisterDNSSDNoLock(
 
   TXTRecordDeallocate(&txt);
 
-  if ((system->options & PAPPL_SOPTIONS_RAW_SOCKET) && printer->num_raw_listeners > 0)
+  if (printer->dns_sd_pdl_ref)
   {
-    // Register a PDL datastream (raw socket) service...
-    TXTRecordCreate(&txt, 1024, NULL);
-    if (printer->driver_data.make_and_model[0])
-      TXTRecordSetValue(&txt, "ty", (uint8_t)strlen(printer->driver_data.make_and_model), printer->driver_data.make_and_model);
-    TXTRecordSetValue(&txt, "adminurl", (uint8_t)strlen(adminurl), adminurl);
-    if (printer->location)
-      TXTRecordSetValue(&txt, "note", (uint8_t)strlen(printer->location), printer->location);
-    else
-      TXTRecordSetValue(&txt, "note", 0, "");
-    TXTRecordSetValue(&txt, "pdl", (uint8_t)strlen(formats), formats);
-    if ((value = ippGetString(printer_uuid, 0, NULL)) != NULL)
-      TXTRecordSetValue(&txt, "UUID", (uint8_t)strlen(value) - 9, value + 9);
-    TXTRecordSetValue(&txt, "Color", 1, ippGetBoolean(color_supported, 0) ? "T" : "F");
-    TXTRecordSetValue(&txt, "Duplex", 1, (printer->driver_data.sides_supported & PAPPL_SIDES_TWO_SIDED_LONG_EDGE) ? "T" : "F");
-    TXTRecordSetValue(&txt, "txtvers", 1, "1");
-    TXTRecordSetValue(&txt, "qtotal", 1, "1");
-    TXTRecordSetValue(&txt, "priority", 3, "100");
-
-    // Legacy keys...
-    TXTRecordSetValue(&txt, "product", (uint8_t)strlen(product), product);
-    TXTRecordSetValue(&txt, "Fax", 1, "F");
-    TXTRecordSetValue(&txt, "PaperMax", (uint8_t)strlen(papermax), papermax);
-    TXTRecordSetValue(&txt, "Scan", 1, "F");
-
-    if (printer->dns_sd_pdl_ref)
-      DNSServiceRefDeallocate(printer->dns_sd_pdl_ref);
+    DNSServiceRefDeallocate(printer->dns_sd_pdl_ref);
+    printer->dns_sd_pdl_ref = NULL;
+  }
 
+  if (raw)
+  {
+    // Register a PDL datastream (raw socket) service...
     printer->dns_sd_pdl_ref = master;
 
-    if ((error = DNSServiceRegister(&printer->dns_sd_pdl_ref, kDNSServiceFlagsShareConnection | kDNSServiceFlagsNoAutoRename, 0 /* interfaceIndex */, printer->dns_sd_name, "_pdl-datastream._tcp", NULL /* domain */, system->hostname, htons(9099 + printer->printer_id), TXTRecordGetLength(&txt), TXTRecordGetBytesPtr(&txt), (DNSServiceRegisterReply)dns_sd_printer_callback, printer)) != kDNSServiceErr_NoError)
+    if ((error = DNSServiceRegister(&printer->dns_sd_pdl_ref, kDNSServiceFlagsShareConnection | kDNSServiceFlagsNoAutoRename, 0 /* interfaceIndex */, printer->dns_sd_name, "_pdl-datastream._tcp", NULL /* domain */, system->hostname, htons(9099 + printer->printer_id), TXTRecordGetLength(&pdltxt), TXTRecordGetBytesPtr(&pdltxt), (DNSServiceRegisterReply)dns_sd_printer_callback, printer)) != kDNSServiceErr_NoError)
     {
       papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to register '%s.%s': %s", printer->dns_sd_name, "_pdl-datastream._tcp", _papplDNSSDStrError(error));
+      printer->dns_sd_pdl_ref = NULL;
       ret = false;
     }
 
-    TXTRecordDeallocate(&txt);
+    TXTRecordDeallocate(&pdltxt);
   }
 
   // Register the _http._tcp,_printer (HTTP) service type with the real port
@@ -632,6 +763,9 @@ _papplPrinterRegisterDNSSDNoLock(
 
   TXTRecordDeallocate(&txt);
 
+  // Remember what was registered for the next update...
+  dns_sd_cache_txt(printer, ret ? key : NULL, txtdata, txtlen);
+
 #elif defined(HAVE_AVAHI)
   // Create the TXT record...
   txt = NULL;
@@ -661,17 +795,82 @@ _papplPrinterRegisterDNSSDNoLock(
   txt = avahi_string_list_add_printf(txt, "PaperMax=%s", papermax);
   txt = avahi_string_list_add_printf(txt, "Scan=F");
 
-  // Register _printer._tcp (LPD) with port 0 to reserve the service name...
+  pdltxt = NULL;
+  if (raw)
+  {
+    // Create the TXT record for the PDL datastream (raw socket) service...
+    if (printer->driver_data.make_and_model[0])
+      pdltxt = avahi_string_list_add_printf(pdltxt, "ty=%s", printer->driver_data.make_and_model);
+    pdltxt = avahi_string_list_add_printf(pdltxt, "adminurl=%s", adminurl);
+    pdltxt = avahi_string_list_add_printf(pdltxt, "note=%s", printer->location ? printer->location : "");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "pdl=%s", formats);
+    if ((value = ippGetString(printer_uuid, 0, NULL)) != NULL)
+      pdltxt = avahi_string_list_add_printf(pdltxt, "UUID=%s", value + 9);
+    pdltxt = avahi_string_list_add_printf(pdltxt, "Color=%s", ippGetBoolean(color_supported, 0) ? "T" : "F");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "Duplex=%s", (printer->driver_data.sides_supported & PAPPL_SIDES_TWO_SIDED_LONG_EDGE) ? "T" : "F");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "txtvers=1");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "qtotal=1");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "priority=100");
+
+    // Legacy keys...
+    pdltxt = avahi_string_list_add_printf(pdltxt, "product=%s", product);
+    pdltxt = avahi_string_list_add_printf(pdltxt, "Fax=F");
+    pdltxt = avahi_string_list_add_printf(pdltxt, "PaperMax=%s", papermax);
+    pdltxt = avahi_string_list_add_printf(pdltxt, "Scan=F");
+  }
+
+  txtlen = avahi_string_list_serialize(txt, txtdata, sizeof(txtdata));
+
   _papplDNSSDLock();
 
+  if (printer->dns_sd_ref && !force && printer->dns_sd_key && !strcmp(printer->dns_sd_key, key))
+  {
+    // Same services, just update the TXT records if they have changed...
+    if (printer->dns_sd_txtlen != txtlen || memcmp(printer->dns_sd_txt, txtdata, txtlen))
+    {
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Updating DNS-SD TXT records for '%s'.", printer->dns_sd_name);
+
+      if ((error = avahi_entry_group_update_service_txt_strlst(printer->dns_sd_ref, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, 0, printer->dns_sd_name, "_ipp._tcp", NULL, txt)) < 0)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._ipp._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      if (!(system->options & PAPPL_SOPTIONS_NO_TLS) && (error = avahi_entry_group_update_service_txt_strlst(printer->dns_sd_ref, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, 0, printer->dns_sd_name, "_ipps._tcp", NULL, txt)) < 0)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._ipps._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      if (raw && (error = avahi_entry_group_update_service_txt_strlst(printer->dns_sd_ref, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, 0, printer->dns_sd_name, "_pdl-datastream._tcp", NULL, pdltxt)) < 0)
+      {
+	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to update TXT record for '%s._pdl-datastream._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
+	ret = false;
+      }
+
+      dns_sd_cache_txt(printer, ret ? key : NULL, txtdata, txtlen);
+    }
+
+    _papplDNSSDUnlock();
+
+    avahi_string_list_free(txt);
+    avahi_string_list_free(pdltxt);
+
+    return (ret);
+  }
+
+  // Register _printer._tcp (LPD) with port 0 to reserve the service name...
+
   if (printer->dns_sd_ref)
     avahi_entry_group_free(printer->dns_sd_ref);
 
   if ((printer->dns_sd_ref = avahi_entry_group_new(master, (AvahiEntryGroupCallback)dns_sd_printer_callback, printer)) == NULL)
   {
     papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to register printer, is the Avahi daemon running?");
+    dns_sd_cache_txt(printer, NULL, NULL, 0);
     _papplDNSSDUnlock();
     avahi_string_list_free(txt);
+    avahi_string_list_free(pdltxt);
     return (false);
   }
 
@@ -745,36 +944,16 @@ _papplPrinterRegisterDNSSDNoLock(
 
   avahi_string_list_free(txt);
 
-  if ((system->options & PAPPL_SOPTIONS_RAW_SOCKET) && printer->num_raw_listeners > 0)
+  if (raw)
   {
     // Register a PDL datastream (raw socket) service...
-    txt = NULL;
-    if (printer->driver_data.make_and_model[0])
-      txt = avahi_string_list_add_printf(txt, "ty=%s", printer->driver_data.make_and_model);
-    txt = avahi_string_list_add_printf(txt, "adminurl=%s", adminurl);
-    txt = avahi_string_list_add_printf(txt, "note=%s", printer->location ? printer->location : "");
-    txt = avahi_string_list_add_printf(txt, "pdl=%s", formats);
-    if ((value = ippGetString(printer_uuid, 0, NULL)) != NULL)
-      txt = avahi_string_list_add_printf(txt, "UUID=%s", value + 9);
-    txt = avahi_string_list_add_printf(txt, "Color=%s", ippGetBoolean(color_supported, 0) ? "T" : "F");
-    txt = avahi_string_list_add_printf(txt, "Duplex=%s", (printer->driver_data.sides_supported & PAPPL_SIDES_TWO_SIDED_LONG_EDGE) ? "T" : "F");
-    txt = avahi_string_list_add_printf(txt, "txtvers=1");
-    txt = avahi_string_list_add_printf(txt, "qtotal=1");
-    txt = avahi_string_list_add_printf(txt, "priority=100");
-
-    // Legacy keys...
-    txt = avahi_string_list_add_printf(txt, "product=%s", product);
-    txt = avahi_string_list_add_printf(txt, "Fax=F");
-    txt = avahi_string_list_add_printf(txt, "PaperMax=%s", papermax);
-    txt = avahi_string_list_add_printf(txt, "Scan=F");
-
-    if ((error = avahi_entry_group_add_service_strlst(printer->dns_sd_ref, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, 0, printer->dns_sd_name, "_pdl-datastream._tcp", NULL, system->hostname, 9099 + printer->printer_id, txt)) < 0)
+    if ((error = avahi_entry_group_add_service_strlst(printer->dns_sd_ref, AVAHI_IF_UNSPEC, AVAHI_PROTO_UNSPEC, 0, printer->dns_sd_name, "_pdl-datastream._tcp", NULL, system->hostname, 9099 + printer->printer_id, pdltxt)) < 0)
     {
       papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to register '%s._pdl-datastream._tcp': %s", printer->dns_sd_name, _papplDNSSDStrError(error));
       ret = false;
     }
 
-    avahi_string_list_free(txt);
+    avahi_string_list_free(pdltxt);
   }
 
   // Register the geolocation of the service...
@@ -808,6 +987,10 @@ _papplPrinterRegisterDNSSDNoLock(
 
   // Commit it...
   avahi_entry_group_commit(printer->dns_sd_ref);
+
+  // Remember what was registered for the next update...
+  dns_sd_cache_txt(printer, ret ? key : NULL, txtdata, txtlen);
+
   _papplDNSSDUnlock();
 #endif // HAVE_MDNSRESPONDER
 
@@ -846,6 +1029,13 @@ _papplPrinterUnregisterDNSSDNoLock(
     DNSServiceRefDeallocate(printer->dns_sd_http_ref);
     printer->dns_sd_http_ref = NULL;
   }
+  if (printer->dns_sd_pdl_ref)
+  {
+    DNSServiceRefDeallocate(printer->dns_sd_pdl_ref);
+    printer->dns_sd_pdl_ref = NULL;
+  }
+
+  dns_sd_cache_txt(printer, NULL, NULL, 0);
 
 #elif defined(HAVE_AVAHI)
   _papplDNSSDLock();
@@ -856,6 +1046,8 @@ _papplPrinterUnregisterDNSSDNoLock(
     printer->dns_sd_ref = NULL;
   }
 
+  dns_sd_cache_txt(printer, NULL, NULL, 0);
+
   _papplDNSSDUnlock();
 
 #else
@@ -1091,6 +1283,42 @@ _papplSystemUnregisterDNSSDNoLock(
 }
 
 
+//
+// 'dns_sd_cache_txt()' - Remember the registered service key and TXT record.
+//
+// A `NULL` key clears the cache so that the next registration is done from
+// scratch.
+//
+
+static void
+dns_sd_cache_txt(
+    pappl_printer_t     *printer,	// I - Printer
+    const char          *key,		// I - Service key or `NULL` to clear
+    const unsigned char *txt,		// I - TXT record data
+    size_t              txtlen)		// I - Length of TXT record data
+{
+  free(printer->dns_sd_key);
+  free(printer->dns_sd_txt);
+
+  printer->dns_sd_key    = NULL;
+  printer->dns_sd_txt    = NULL;
+  printer->dns_sd_txtlen = 0;
+
+  if (!key || (printer->dns_sd_key = strdup(key)) == NULL)
+    return;
+
+  if ((printer->dns_sd_txt = malloc(txtlen > 0 ? txtlen : 1)) == NULL)
+  {
+    free(printer->dns_sd_key);
+    printer->dns_sd_key = NULL;
+    return;
+  }
+
+  memcpy(printer->dns_sd_txt, txt, txtlen);
+  printer->dns_sd_txtlen = txtlen;
+}
+
+
 //
 // 'dns_sd_geo_to_loc()' - Convert a "geo:" URI to a DNS LOC record.
 //
@@ -1158,6 +1386,7 @@ dns_sd_printer_callback(
   {
     printer->dns_sd_collision             = true;
     printer->system->dns_sd_any_collision = true;
+    _papplSystemWakeup(printer->system);
   }
   else if (errorCode)
   {
@@ -1170,6 +1399,11 @@ dns_sd_printer_callback(
 //
 // 'dns_sd_run()' - Handle DNS-SD traffic.
 //
+// The master connection is shared by every system in the process, so the
+// thread blocks until there is traffic rather than waking up periodically to
+// check whether the system is still running.  @code _papplDNSSDShutdown@
+// writes to the wakeup pipe to stop the thread.
+//
 
 static void *				// O - Exit status
 dns_sd_run(void *data)			// I - System object
@@ -1177,25 +1411,30 @@ dns_sd_run(void *data)			// I - System object
   int		err;			// Status
   pappl_system_t *system = (pappl_system_t *)data;
 					// System object
-  struct pollfd	pfd;			// Poll data
+  struct pollfd	pfds[2];		// Poll data
 
 
-  pfd.events = POLLIN | POLLERR;
-  pfd.fd     = DNSServiceRefSockFD(pappl_dns_sd_master);
+  pfds[0].events = POLLIN | POLLERR;
+  pfds[0].fd     = DNSServiceRefSockFD(pappl_dns_sd_master);
+  pfds[1].events = POLLIN;
+  pfds[1].fd     = pappl_dns_sd_pipe[0];
 
-  while (papplSystemIsRunning(system))
+  for (;;)
   {
 #if _WIN32
-    if (poll(&pfd, 1, 1000) < 0 && WSAGetLastError() == WSAEINTR)
+    if (poll(pfds, 2, -1) < 0 && WSAGetLastError() == WSAEINTR)
 #else
-    if (poll(&pfd, 1, 1000) < 0 && errno != EINTR && errno != EAGAIN)
+    if (poll(pfds, 2, -1) < 0 && errno != EINTR && errno != EAGAIN)
 #endif // _WIN32
     {
       papplLog(system, PAPPL_LOGLEVEL_ERROR, "DNS-SD poll failed: %s", strerror(errno));
       break;
     }
 
-    if (pfd.revents & POLLIN)
+    if (pfds[1].revents)
+      break;				// Shutting down
+
+    if (pfds[0].revents & POLLIN)
     {
       if ((err = DNSServiceProcessResult(pappl_dns_sd_master)) != kDNSServiceErr_NoError)
       {
@@ -1203,7 +1442,7 @@ dns_sd_run(void *data)			// I - System object
 	break;
       }
     }
-    else if (pfd.revents)
+    else if (pfds[0].revents)
       break;
   }
 
@@ -1234,6 +1473,7 @@ dns_sd_system_callback(
   {
     system->dns_sd_collision     = true;
     system->dns_sd_any_collision = true;
+    _papplSystemWakeup(system);
   }
   else if (errorCode)
   {
@@ -1290,6 +1530,7 @@ dns_sd_printer_callback(
   {
     printer->dns_sd_collision             = true;
     printer->system->dns_sd_any_collision = true;
+    _papplSystemWakeup(printer->system);
   }
 }
 
@@ -1310,6 +1551,7 @@ dns_sd_system_callback(
   {
     system->dns_sd_collision     = true;
     system->dns_sd_any_collision = true;
+    _papplSystemWakeup(system);
   }
 }
 #endif // HAVE_MDNSRESPONDER
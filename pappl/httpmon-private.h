@@ -41,9 +41,11 @@ typedef enum _pappl_http_phase_e	// HTTP state phases (sub-states)
 } _pappl_http_phase_t;
 
 
-typedef struct _pappl_http_buffer_s	// HTTP data buffer
+typedef struct _pappl_http_buffer_s	// HTTP data ring buffer
 {
-  size_t	used;			// Bytes used in buffer
+  size_t	start,			// Offset of first byte in buffer
+		used,			// Bytes used in buffer
+		scanned;		// Bytes already searched for a newline
   char		data[HTTP_MAX_BUFFER];	// Data in buffer
 } _pappl_http_buffer_t;
 
@@ -67,11 +69,13 @@ typedef struct _pappl_http_monitor_s	// HTTP state monitoring data
 // Prototypes...
 //
 
+extern size_t		_papplHTTPMonitorGetDataRemaining(_pappl_http_monitor_t *hm) _PAPPL_PRIVATE;
 extern const char	*_papplHTTPMonitorGetError(_pappl_http_monitor_t *hm) _PAPPL_PRIVATE;
 extern http_state_t	_papplHTTPMonitorGetState(_pappl_http_monitor_t *hm) _PAPPL_PRIVATE;
 extern void		_papplHTTPMonitorInit(_pappl_http_monitor_t *hm) _PAPPL_PRIVATE;
 extern http_status_t	_papplHTTPMonitorProcessDeviceData(_pappl_http_monitor_t *hm, const char *data, size_t datasize) _PAPPL_PRIVATE;
 extern http_status_t	_papplHTTPMonitorProcessHostData(_pappl_http_monitor_t *hm, const char **data, size_t *datasize) _PAPPL_PRIVATE;
+extern void		_papplHTTPMonitorSkipData(_pappl_http_monitor_t *hm, size_t bytes) _PAPPL_PRIVATE;
 
 
 #endif // !PAPPL_HTTPMON_PRIVATE_H
@@ -20,6 +20,42 @@ static size_t	http_buffer_consume(_pappl_http_buffer_t *hb, const char **data, s
 static char	*http_buffer_line(_pappl_http_monitor_t *hm, _pappl_http_buffer_t *hb, const char **data, size_t *datasize, char *line, size_t linesize);
 
 
+//
+// '_papplHTTPMonitorGetDataRemaining()' - Get the number of message body bytes
+//                                         that can be relayed without parsing.
+//
+// This function returns the number of bytes of request (client data phase) or
+// response (server data phase) body data that the monitor only needs to count.
+// Those bytes can be relayed directly, for example using `splice()`, and then
+// reported with @link _papplHTTPMonitorSkipData@.  `0` is returned when the
+// next bytes must be passed to @link _papplHTTPMonitorProcessHostData@ or
+// @link _papplHTTPMonitorProcessDeviceData@.
+//
+
+size_t					// O - Number of bytes
+_papplHTTPMonitorGetDataRemaining(
+    _pappl_http_monitor_t *hm)		// I - HTTP monitor
+{
+  _pappl_http_buffer_t	*hb;		// Buffer for current phase
+
+
+  if (hm->status == HTTP_STATUS_ERROR || hm->data_remaining <= 0)
+    return (0);
+
+  if (hm->phase == _PAPPL_HTTP_PHASE_CLIENT_DATA)
+    hb = &hm->host;
+  else if (hm->phase == _PAPPL_HTTP_PHASE_SERVER_DATA)
+    hb = &hm->device;
+  else
+    return (0);
+
+  if (hb->used > 0 || (hm->data_encoding == HTTP_ENCODE_CHUNKED && hm->data_chunk != _PAPPL_HTTP_CHUNK_DATA))
+    return (0);
+
+  return ((size_t)hm->data_remaining);
+}
+
+
 //
 // '_papplHTTPMonitorGetError()' - Get the current HTTP monitor error, if any.
 //
@@ -364,7 +400,7 @@ _papplHTTPMonitorProcessDeviceData(
   size_t	bytes;			// Bytes consumed
 
 
-  while (hm->status != HTTP_STATUS_ERROR && (hm->host.used > 0 || datasize > 0))
+  while (hm->status != HTTP_STATUS_ERROR && (hm->device.used > 0 || datasize > 0))
   {
     switch (hm->state)
     {
@@ -377,7 +413,7 @@ _papplHTTPMonitorProcessDeviceData(
 	  switch (hm->phase)
 	  {
 	    case _PAPPL_HTTP_PHASE_SERVER_HEADERS : /* Waiting for blank line */
-		if (!http_buffer_line(hm, &hm->host, &data, &datasize, line, sizeof(line)))
+		if (!http_buffer_line(hm, &hm->device, &data, &datasize, line, sizeof(line)))
 		  return (hm->status);
 
 		if (!line[0])
@@ -463,7 +499,7 @@ _papplHTTPMonitorProcessDeviceData(
 		switch (hm->data_chunk)
 		{
 		  case _PAPPL_HTTP_CHUNK_HEADER :
-		      if (!http_buffer_line(hm, &hm->host, &data, &datasize, line, sizeof(line)))
+		      if (!http_buffer_line(hm, &hm->device, &data, &datasize, line, sizeof(line)))
 			return (hm->status);
 
 		      // Get chunk length (hex)
@@ -498,7 +534,7 @@ _papplHTTPMonitorProcessDeviceData(
 		  case _PAPPL_HTTP_CHUNK_DATA : // Consume chunk data...
 		      if (hm->data_remaining > 0)
 		      {
-			bytes = http_buffer_consume(&hm->host, &data, &datasize, (size_t)hm->data_remaining);
+			bytes = http_buffer_consume(&hm->device, &data, &datasize, (size_t)hm->data_remaining);
 			hm->data_remaining -= (off_t)bytes;
 		      }
 
@@ -511,7 +547,7 @@ _papplHTTPMonitorProcessDeviceData(
 		      break;
 
 		  case _PAPPL_HTTP_CHUNK_TRAILER : // Look for blank line at end of chunk
-		      if (!http_buffer_line(hm, &hm->host, &data, &datasize, line, sizeof(line)))
+		      if (!http_buffer_line(hm, &hm->device, &data, &datasize, line, sizeof(line)))
 			return (hm->status);
 
 		      if (line[0])
@@ -543,7 +579,7 @@ _papplHTTPMonitorProcessDeviceData(
 		// Skip fixed-length data...
 		if (hm->data_remaining > 0)
 		{
-		  bytes = http_buffer_consume(&hm->host, &data, &datasize, (size_t)hm->data_remaining);
+		  bytes = http_buffer_consume(&hm->device, &data, &datasize, (size_t)hm->data_remaining);
 		  hm->data_remaining -= (off_t)bytes;
 		}
 
@@ -563,7 +599,7 @@ _papplHTTPMonitorProcessDeviceData(
 	      break;
 
 	  case _PAPPL_HTTP_PHASE_CLIENT_DATA : // Server may send failure response before client completes POST/PUT
-	      if (!http_buffer_line(hm, &hm->host, &data, &datasize, line, sizeof(line)))
+	      if (!http_buffer_line(hm, &hm->device, &data, &datasize, line, sizeof(line)))
 		return (hm->status);
 
 	      if (!strncmp(line, "HTTP/", 5))
@@ -608,9 +644,53 @@ _papplHTTPMonitorProcessDeviceData(
 }
 
 
+//
+// '_papplHTTPMonitorSkipData()' - Account for message body data that was
+//                                 relayed without parsing.
+//
+// The "bytes" argument must not exceed the value returned by
+// @link _papplHTTPMonitorGetDataRemaining@.
+//
+
+void
+_papplHTTPMonitorSkipData(
+    _pappl_http_monitor_t *hm,		// I - HTTP monitor
+    size_t                bytes)	// I - Number of bytes relayed
+{
+  if ((off_t)bytes > hm->data_remaining)
+    bytes = (size_t)hm->data_remaining;
+
+  if ((hm->data_remaining -= (off_t)bytes) > 0)
+    return;
+
+  if (hm->data_encoding == HTTP_ENCODE_CHUNKED)
+  {
+    // End of data, expect chunk trailer...
+    hm->data_chunk = _PAPPL_HTTP_CHUNK_TRAILER;
+  }
+  else if (hm->phase == _PAPPL_HTTP_PHASE_CLIENT_DATA)
+  {
+    // End of data, expect server headers in response...
+    hm->phase         = _PAPPL_HTTP_PHASE_SERVER_HEADERS;
+    hm->status        = HTTP_STATUS_CONTINUE;
+    hm->data_encoding = HTTP_ENCODE_LENGTH;
+    hm->data_length   = hm->data_remaining = 0;
+  }
+  else
+  {
+    // End of data, expect new request from client...
+    hm->phase = _PAPPL_HTTP_PHASE_CLIENT_HEADERS;
+    hm->state = HTTP_WAITING;
+  }
+}
+
+
 //
 // 'http_buffer_add()' - Add bytes to the buffer from the data stream.
 //
+// The buffer is a ring - new data is copied after the last byte, wrapping
+// around to the front of the buffer as needed.
+//
 
 static size_t				// O  - Number of bytes added
 http_buffer_add(
@@ -618,16 +698,25 @@ http_buffer_add(
     const char           **data,	// IO - Pointer to data
     size_t               *datasize)	// IO - Bytes of data (remaining)
 {
-  size_t	bytes = 0;		// Bytes to add
+  size_t	bytes = 0,		// Bytes to add
+		offset,			// Offset of end of buffer
+		count;			// Bytes before wrapping around
 
 
   if (*datasize > 0 && hb->used < HTTP_MAX_BUFFER)
   {
-    // Copy more data into client_data
+    // Copy more data into the free part of the ring...
     if ((bytes = HTTP_MAX_BUFFER - hb->used) > *datasize)
       bytes = *datasize;
 
-    memcpy(hb->data + hb->used, *data, bytes);
+    offset = (hb->start + hb->used) % HTTP_MAX_BUFFER;
+
+    if ((count = HTTP_MAX_BUFFER - offset) > bytes)
+      count = bytes;
+
+    memcpy(hb->data + offset, *data, count);
+    if (count < bytes)
+      memcpy(hb->data, *data + count, bytes - count);
 
     (*data)     += bytes;
     (*datasize) -= bytes;
@@ -641,6 +730,9 @@ http_buffer_add(
 //
 // 'http_buffer_consume()' - Consume bytes from the buffer or data stream.
 //
+// Consumed bytes are skipped by advancing offsets and pointers, so message
+// bodies are never copied or moved.
+//
 
 static size_t				// O  - Total bytes consumed
 http_buffer_consume(
@@ -658,37 +750,32 @@ http_buffer_consume(
     if (bytes >= hb->used)
     {
       // Consume all of the buffer
-      bytes -= hb->used;
-      total += hb->used;
-      hb->used = 0;
+      bytes       -= hb->used;
+      total       += hb->used;
+      hb->start   = 0;
+      hb->used    = 0;
+      hb->scanned = 0;
     }
     else
     {
-      // Consume part of the buffer and move things around
-      memmove(hb->data, hb->data + bytes, hb->used - bytes);
-      hb->used -= bytes;
-      total    += bytes;
-      bytes    = 0;
+      // Consume part of the buffer by advancing the start of the ring
+      hb->start   = (hb->start + bytes) % HTTP_MAX_BUFFER;
+      hb->used    -= bytes;
+      hb->scanned = hb->scanned > bytes ? hb->scanned - bytes : 0;
+      total       += bytes;
+      bytes       = 0;
     }
   }
 
   if (bytes > 0 && *datasize > 0)
   {
     // Didn't consume everything requested, pull from the data stream
-    if (bytes >= *datasize)
-    {
-      // Consume all of the data stream
-      (*data)   += *datasize;
-      total     += *datasize;
-      *datasize = 0;
-    }
-    else
-    {
-      // Consume part of the data stream
-      (*data)     += bytes;
-      (*datasize) -= bytes;
-      total       += bytes;
-    }
+    if (bytes > *datasize)
+      bytes = *datasize;
+
+    (*data)     += bytes;
+    (*datasize) -= bytes;
+    total       += bytes;
   }
 
   // Return the total number of bytes consumed
@@ -700,6 +787,9 @@ http_buffer_consume(
 // 'http_buffer_line()' - Copy a single line from the buffer or data stream,
 //                        stripping CR and LF.
 //
+// Only the bytes added since the last call are searched for a newline, and
+// the line is copied straight out of the ring and data stream.
+//
 
 static char *				// O - Pointer to line or `NULL` if none
 http_buffer_line(
@@ -713,12 +803,33 @@ http_buffer_line(
   char		*lineptr,		// Pointer into line buffer
 		*lineend;		// Pointer to end of line buffer
   const char	*dataptr,		// Pointer into data buffer
-		*dataend;		// Pointer to end of data buffer
-  bool		eol = false;		// EOL seen?
+		*dataend,		// Pointer to end of data buffer
+		*eol = NULL;		// Newline in data stream
+  size_t	offset,			// Offset into ring
+		count,			// Bytes before wrapping around
+		bytes;			// Bytes of line in ring
+  bool		found = false;		// Newline found in ring?
 
 
-  // See if the buffer or data stream contains a newline...
-  if ((hb->used == 0 || !memchr(hb->data, '\n', hb->used)) && (*datasize == 0 || !memchr(*data, '\n', *datasize)))
+  // See if the unscanned part of the ring contains a newline...
+  while (!found && hb->scanned < hb->used)
+  {
+    offset = (hb->start + hb->scanned) % HTTP_MAX_BUFFER;
+
+    if ((count = HTTP_MAX_BUFFER - offset) > (hb->used - hb->scanned))
+      count = hb->used - hb->scanned;
+
+    if ((dataptr = memchr(hb->data + offset, '\n', count)) != NULL)
+    {
+      hb->scanned += (size_t)(dataptr - hb->data - offset) + 1;
+      found       = true;
+    }
+    else
+      hb->scanned += count;
+  }
+
+  // If not, see if the data stream contains a newline...
+  if (!found && (*datasize == 0 || (eol = memchr(*data, '\n', *datasize)) == NULL))
   {
     // No, try to add the data stream to the buffer and return...
     http_buffer_add(hb, data, datasize);
@@ -734,48 +845,42 @@ http_buffer_line(
     return (NULL);
   }
 
-  // Grab one line from the input buffer
+  // Copy the line from the ring, in at most two segments...
   lineptr = line;
   lineend = line + linesize - 1;
-  dataptr = hb->data;
-  dataend = hb->data + hb->used;
+  bytes   = found ? hb->scanned : hb->used;
+  offset  = hb->start;
 
-  while (!eol && dataptr < dataend)
+  while (bytes > 0)
   {
-    if (*dataptr == '\n')
-      eol = true;
-    else if (*dataptr != '\r' && lineptr < lineend)
-      *lineptr++ = *dataptr;
+    if ((count = HTTP_MAX_BUFFER - offset) > bytes)
+      count = bytes;
 
-    dataptr ++;
-  }
+    for (dataptr = hb->data + offset, dataend = dataptr + count; dataptr < dataend; dataptr ++)
+    {
+      if (*dataptr != '\r' && *dataptr != '\n' && lineptr < lineend)
+        *lineptr++ = *dataptr;
+    }
 
-  // If we consumed any data in the buffer, move the remainder to the front
-  // of the buffer...
-  if (dataptr < dataend)
-    memmove(hb->data, dataptr, dataend - dataptr);
+    bytes  -= count;
+    offset = 0;
+  }
 
-  hb->used -= (size_t)(dataptr - hb->data);
+  // Consume the line from the ring (or all of it if the line continues in the
+  // data stream)...
+  http_buffer_consume(hb, data, datasize, found ? hb->scanned : hb->used);
 
-  if (!eol)
+  if (eol)
   {
-    // Didn't get the whole line in our buffer, grab the rest from the data
-    // stream...
-    dataptr = *data;
-    dataend = *data + *datasize;
-
-    while (!eol && dataptr < dataend)
+    // Grab the rest of the line from the data stream...
+    for (dataptr = *data; dataptr < eol; dataptr ++)
     {
-      if (*dataptr == '\n')
-	eol = true;
-      else if (*dataptr != '\r' && lineptr < lineend)
+      if (*dataptr != '\r' && lineptr < lineend)
 	*lineptr++ = *dataptr;
-
-      dataptr ++;
     }
 
-    *data     = dataptr;
-    *datasize = (size_t)(dataend - dataptr);
+    (*datasize) -= (size_t)(eol + 1 - *data);
+    *data       = eol + 1;
   }
 
   // Add a trailing nul and return the line...
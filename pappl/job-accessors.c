@@ -51,18 +51,34 @@ static const char * const pappl_jreasons[] =
 // This function gets the named IPP attribute from a job.  The returned
 // attribute can be examined using the `ippGetXxx` functions.
 //
+// Completed jobs have their attributes compacted after a minute, so look up
+// the attributes of a completed job when you need them rather than keeping the
+// returned attribute.
+//
 
 ipp_attribute_t *			// O - Attribute or `NULL` if not found
 papplJobGetAttribute(pappl_job_t *job,	// I - Job
                      const char  *name)	// I - Attribute name
 {
   ipp_attribute_t	*attr = NULL;	// Attribute
+  bool			compacted = false;
+					// Are the job attributes compacted?
 
   if (job)
   {
     pthread_rwlock_rdlock(&job->rwlock);
-    attr = ippFindAttribute(job->attrs, name, IPP_TAG_ZERO);
+    if ((attr = ippFindAttribute(job->attrs, name, IPP_TAG_ZERO)) == NULL)
+      compacted = job->is_compacted;
     pthread_rwlock_unlock(&job->rwlock);
+
+    if (compacted)
+    {
+      // Restore the attributes that were freed when the job was compacted...
+      pthread_rwlock_wrlock(&job->rwlock);
+      _papplJobExpandNoLock(job);
+      attr = ippFindAttribute(job->attrs, name, IPP_TAG_ZERO);
+      pthread_rwlock_unlock(&job->rwlock);
+    }
   }
 
   return (attr);
@@ -149,7 +165,23 @@ int					// O - Number of completed impressions in job
 papplJobGetImpressionsCompleted(
     pappl_job_t *job)			// I - Job
 {
-  return (job ? job->impcompleted : 0);
+  return (job ? (int)_PAPPL_ATOMIC_GET(&job->impcompleted) : 0);
+}
+
+
+//
+// 'papplJobGetLogLevel()' - Get the log level for the job.
+//
+// This function returns the log level set using the
+// @link papplJobSetLogLevel@ function.
+//
+// @since PAPPL 1.1@
+//
+
+pappl_loglevel_t			// O - Log level or `PAPPL_LOGLEVEL_UNSPEC` for the printer's log level
+papplJobGetLogLevel(pappl_job_t *job)	// I - Job
+{
+  return (job ? job->loglevel : PAPPL_LOGLEVEL_UNSPEC);
 }
 
 
@@ -201,7 +233,7 @@ papplJobGetPrinter(pappl_job_t *job) 	// I - Job
 pappl_jreason_t				// O - IPP "job-state-reasons" bits
 papplJobGetReasons(pappl_job_t *job)	// I - Job
 {
-  return (job ? job->state_reasons : PAPPL_JREASON_NONE);
+  return (job ? (pappl_jreason_t)_PAPPL_ATOMIC_GET(&job->state_reasons) : PAPPL_JREASON_NONE);
 }
 
 
@@ -225,7 +257,41 @@ papplJobGetReasons(pappl_job_t *job)	// I - Job
 ipp_jstate_t				// O - IPP "job-state" value
 papplJobGetState(pappl_job_t *job)	// I - Job
 {
-  return (job ? job->state : IPP_JSTATE_ABORTED);
+  return (job ? (ipp_jstate_t)_PAPPL_ATOMIC_GET(&job->state) : IPP_JSTATE_ABORTED);
+}
+
+
+//
+// '_papplJobGetStatus()' - Get a consistent snapshot of the job status.
+//
+// The job state and state reasons are updated together between
+// `_PAPPL_JOB_STATUS_BEGIN` and `_PAPPL_JOB_STATUS_END` (or the
+// `_PAPPL_JOB_SET_STATE` and `_PAPPL_JOB_SET_COMPLETED` macros), which bump the
+// status sequence number.  Readers retry until they see the same even sequence number
+// before and after reading the values, so they never need to take the job or
+// printer locks and never hold up a job that is updating its progress.
+//
+
+void
+_papplJobGetStatus(
+    pappl_job_t     *job,		// I - Job
+    ipp_jstate_t    *state,		// O - "job-state" value
+    pappl_jreason_t *reasons,		// O - "job-state-reasons" values
+    int             *impcompleted)	// O - "job-impressions-completed" value
+{
+  unsigned	seq;			// Sequence number
+
+
+  do
+  {
+    while ((seq = (unsigned)_PAPPL_ATOMIC_GET(&job->status_seq)) & 1)
+      ;				// Wait for the writer to finish
+
+    *state        = (ipp_jstate_t)_PAPPL_ATOMIC_GET(&job->state);
+    *reasons      = (pappl_jreason_t)_PAPPL_ATOMIC_GET(&job->state_reasons);
+    *impcompleted = (int)_PAPPL_ATOMIC_GET(&job->impcompleted);
+  }
+  while ((unsigned)_PAPPL_ATOMIC_GET(&job->status_seq) != seq);
 }
 
 
@@ -366,13 +432,36 @@ papplJobSetImpressionsCompleted(
 {
   if (job)
   {
-    pthread_rwlock_wrlock(&job->rwlock);
-    job->impcompleted += add;
-    pthread_rwlock_unlock(&job->rwlock);
+    _PAPPL_ATOMIC_ADD(&job->impcompleted, add);
+
+    // The event includes the printer status, so take the locks for it...
+    papplSystemAddEvent(job->system, job->printer, job, PAPPL_EVENT_JOB_PROGRESS, NULL);
   }
 }
 
 
+//
+// 'papplJobSetLogLevel()' - Set the log level for the job.
+//
+// This function overrides the printer and system log levels for messages
+// logged for the job, for example to debug a single job.  Messages below the
+// level are discarded before they are formatted.
+//
+// Use `PAPPL_LOGLEVEL_UNSPEC` to use the printer's log level again.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplJobSetLogLevel(
+    pappl_job_t      *job,		// I - Job
+    pappl_loglevel_t loglevel)		// I - Log level or `PAPPL_LOGLEVEL_UNSPEC` for the printer's log level
+{
+  if (job && loglevel >= PAPPL_LOGLEVEL_UNSPEC && loglevel <= PAPPL_LOGLEVEL_FATAL)
+    job->loglevel = loglevel;
+}
+
+
 //
 // 'papplJobSetMessage()' - Set the job message string.
 //
@@ -420,8 +509,10 @@ papplJobSetReasons(
   if (job)
   {
     pthread_rwlock_wrlock(&job->rwlock);
+    _PAPPL_JOB_STATUS_BEGIN(job);
     job->state_reasons &= ~remove;
     job->state_reasons |= add;
+    _PAPPL_JOB_STATUS_END(job);
     pthread_rwlock_unlock(&job->rwlock);
   }
 }
@@ -438,6 +529,7 @@ _papplJobSetState(pappl_job_t  *job,	// I - Job
   if (job && job->state != state)
   {
     pthread_rwlock_wrlock(&job->rwlock);
+    _PAPPL_JOB_STATUS_BEGIN(job);
 
     job->state = state;
 
@@ -461,6 +553,11 @@ _papplJobSetState(pappl_job_t  *job,	// I - Job
       if (job->state_reasons & PAPPL_JREASON_WARNINGS_DETECTED)
         job->state_reasons |= PAPPL_JREASON_JOB_COMPLETED_WITH_WARNINGS;
     }
+
+    _PAPPL_JOB_STATUS_END(job);
+
+    _papplSystemAddEventNoLock(job->system, job->printer, job, state >= IPP_JSTATE_CANCELED ? PAPPL_EVENT_JOB_COMPLETED | PAPPL_EVENT_JOB_STATE_CHANGED : PAPPL_EVENT_JOB_STATE_CHANGED, NULL);
+
     pthread_rwlock_unlock(&job->rwlock);
   }
 }
@@ -0,0 +1,444 @@
+//
+// Raster conversion functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define _PAPPL_CONVERT_SSE2	1	// Use SSE2 kernels
+#endif // __SSE2__ || _M_X64 || _M_AMD64
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define _PAPPL_CONVERT_NEON	1	// Use NEON kernels
+#endif // __ARM_NEON || __ARM_NEON__
+
+
+//
+// Types...
+//
+
+typedef enum _pappl_cfamily_e		// Color space family
+{
+  _PAPPL_CFAMILY_NONE,			// Unsupported color space
+  _PAPPL_CFAMILY_GRAY,			// Luminance, 0 is black
+  _PAPPL_CFAMILY_BLACK,			// Black, 0 is white
+  _PAPPL_CFAMILY_RGB,			// Red, green, and blue, 0 is black
+  _PAPPL_CFAMILY_CMYK			// Cyan, magenta, yellow, and black, 0 is white
+} _pappl_cfamily_t;
+
+
+//
+// Local functions...
+//
+
+static void		convert_add(_pappl_convert_t *conv, _pappl_cstep_t step, unsigned samples);
+static void		convert_cmyk_rgb(unsigned char *dst, const unsigned char *src, unsigned count);
+static void		convert_copy(unsigned char *dst, const unsigned char *src, unsigned count);
+static void		convert_expand1(unsigned char *dst, const unsigned char *src, unsigned count);
+static _pappl_cfamily_t	convert_family(cups_cspace_t cspace);
+static void		convert_gray_rgb(unsigned char *dst, const unsigned char *src, unsigned count);
+static void		convert_invert(unsigned char *dst, const unsigned char *src, unsigned count);
+static void		convert_narrow16(unsigned char *dst, const unsigned char *src, unsigned count);
+static void		convert_rgb_gray(unsigned char *dst, const unsigned char *src, unsigned count);
+
+
+//
+// '_papplConvertInit()' - Prepare a raster line conversion.
+//
+// This function chooses the steps needed to convert lines described by the
+// "in" page header to 8-bit lines in the color space of the "out" page header.
+// When the output is a 1-bit bitmap the lines are converted to 8-bit black for
+// dithering.  Adobe RGB and device RGB are treated like sRGB, and sGray like
+// device gray.
+//
+// The first step reads from the source line and any remaining steps update
+// the destination line in place, so the destination must hold
+// `_PAPPL_CONVERT_BPP` bytes per pixel.
+//
+
+bool					// O - `true` on success, `false` if unsupported
+_papplConvertInit(
+    _pappl_convert_t          *conv,	// I - Conversion
+    const cups_page_header2_t *in,	// I - Page header for input lines
+    const cups_page_header2_t *out)	// I - Page header for output lines
+{
+  _pappl_cfamily_t	in_family,	// Input color space family
+			out_family,	// Output color space family
+			family;		// Current color space family
+  unsigned		channels;	// Input values per pixel
+
+
+  memset(conv, 0, sizeof(_pappl_convert_t));
+
+  in_family  = convert_family(in->cupsColorSpace);
+  out_family = convert_family(out->cupsColorSpace);
+
+  if (in_family == _PAPPL_CFAMILY_NONE || out_family == _PAPPL_CFAMILY_NONE || out_family == _PAPPL_CFAMILY_CMYK || in->cupsBitsPerColor == 0)
+    return (false);
+
+  if (out->cupsBitsPerColor == 1)
+  {
+    if (out_family == _PAPPL_CFAMILY_RGB)
+      return (false);
+
+    out_family = _PAPPL_CFAMILY_BLACK;
+  }
+  else if (out->cupsBitsPerColor != 8)
+    return (false);
+
+  // Reduce the bit depth to 8 bits per color...
+  channels = in->cupsBitsPerPixel / in->cupsBitsPerColor;
+
+  if (in->cupsBitsPerColor == 16)
+    convert_add(conv, convert_narrow16, channels);
+  else if (in->cupsBitsPerColor == 1)
+  {
+    if (channels != 1)
+      return (false);
+
+    convert_add(conv, convert_expand1, 1);
+  }
+  else if (in->cupsBitsPerColor != 8)
+    return (false);
+
+  // Then convert the color space...
+  family = in_family;
+
+  if (family == _PAPPL_CFAMILY_CMYK)
+  {
+    convert_add(conv, convert_cmyk_rgb, 1);
+    family = _PAPPL_CFAMILY_RGB;
+  }
+
+  if (family == _PAPPL_CFAMILY_RGB && out_family != _PAPPL_CFAMILY_RGB)
+  {
+    convert_add(conv, convert_rgb_gray, 1);
+    family = _PAPPL_CFAMILY_GRAY;
+  }
+
+  if ((family == _PAPPL_CFAMILY_GRAY && out_family == _PAPPL_CFAMILY_BLACK) || (family == _PAPPL_CFAMILY_BLACK && out_family != _PAPPL_CFAMILY_BLACK))
+  {
+    convert_add(conv, convert_invert, 1);
+    family = family == _PAPPL_CFAMILY_GRAY ? _PAPPL_CFAMILY_BLACK : _PAPPL_CFAMILY_GRAY;
+  }
+
+  if (family == _PAPPL_CFAMILY_GRAY && out_family == _PAPPL_CFAMILY_RGB)
+    convert_add(conv, convert_gray_rgb, 1);
+
+  if (conv->num_steps == 0)
+    convert_add(conv, convert_copy, channels);
+
+  return (true);
+}
+
+
+//
+// '_papplConvertLine()' - Convert a raster line.
+//
+// 16-bit input values are in host byte order as returned by
+// `cupsRasterReadPixels`.
+//
+
+void
+_papplConvertLine(
+    _pappl_convert_t    *conv,		// I - Conversion
+    unsigned char       *dst,		// I - Output line
+    const unsigned char *src,		// I - Input line
+    unsigned            width)		// I - Width of line in pixels
+{
+  unsigned	i;			// Looping var
+
+
+  for (i = 0; i < conv->num_steps; i ++, src = dst)
+    (conv->steps[i])(dst, src, width * conv->samples[i]);
+}
+
+
+//
+// 'convert_add()' - Add a conversion step.
+//
+
+static void
+convert_add(_pappl_convert_t *conv,	// I - Conversion
+            _pappl_cstep_t   step,	// I - Conversion step
+            unsigned         samples)	// I - Values per pixel for step
+{
+  if (conv->num_steps < _PAPPL_CONVERT_MAX)
+  {
+    conv->steps[conv->num_steps]   = step;
+    conv->samples[conv->num_steps] = samples;
+    conv->num_steps ++;
+  }
+}
+
+
+//
+// 'convert_cmyk_rgb()' - Convert 8-bit CMYK pixels to RGB.
+//
+
+static void
+convert_cmyk_rgb(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src,		// I - Input pixels
+    unsigned            count)		// I - Number of pixels
+{
+  unsigned char	r, g, b;		// RGB values
+
+
+#if _PAPPL_CONVERT_NEON
+  for (; count >= 16; count -= 16, src += 64, dst += 48)
+  {
+    uint8x16x4_t	cmyk = vld4q_u8(src);
+    uint8x16x3_t	rgb;
+
+    rgb.val[0] = vqsubq_u8(vmvnq_u8(cmyk.val[0]), cmyk.val[3]);
+    rgb.val[1] = vqsubq_u8(vmvnq_u8(cmyk.val[1]), cmyk.val[3]);
+    rgb.val[2] = vqsubq_u8(vmvnq_u8(cmyk.val[2]), cmyk.val[3]);
+
+    vst3q_u8(dst, rgb);
+  }
+#endif // _PAPPL_CONVERT_NEON
+
+  for (; count > 0; count --, src += 4, dst += 3)
+  {
+    r = (unsigned char)(255 - src[0]);
+    g = (unsigned char)(255 - src[1]);
+    b = (unsigned char)(255 - src[2]);
+
+    dst[0] = r > src[3] ? (unsigned char)(r - src[3]) : 0;
+    dst[1] = g > src[3] ? (unsigned char)(g - src[3]) : 0;
+    dst[2] = b > src[3] ? (unsigned char)(b - src[3]) : 0;
+  }
+}
+
+
+//
+// 'convert_copy()' - Copy 8-bit values.
+//
+
+static void
+convert_copy(
+    unsigned char       *dst,		// I - Output values
+    const unsigned char *src,		// I - Input values
+    unsigned            count)		// I - Number of values
+{
+  if (dst != src)
+    memcpy(dst, src, count);
+}
+
+
+//
+// 'convert_expand1()' - Expand 1-bit pixels to 8 bits.
+//
+
+static void
+convert_expand1(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src,		// I - Input bitmap
+    unsigned            count)		// I - Number of pixels
+{
+  unsigned char	byte;			// Current byte
+  unsigned	i;			// Looping var
+
+
+  for (; count >= 8; count -= 8, src ++, dst += 8)
+  {
+    for (i = 0, byte = *src; i < 8; i ++, byte <<= 1)
+      dst[i] = (byte & 128) ? 255 : 0;
+  }
+
+  if (count > 0)
+  {
+    for (i = 0, byte = *src; i < count; i ++, byte <<= 1)
+      dst[i] = (byte & 128) ? 255 : 0;
+  }
+}
+
+
+//
+// 'convert_family()' - Get the family of a color space.
+//
+
+static _pappl_cfamily_t			// O - Color space family
+convert_family(cups_cspace_t cspace)	// I - Color space
+{
+  switch (cspace)
+  {
+    case CUPS_CSPACE_W :
+    case CUPS_CSPACE_SW :
+        return (_PAPPL_CFAMILY_GRAY);
+
+    case CUPS_CSPACE_K :
+        return (_PAPPL_CFAMILY_BLACK);
+
+    case CUPS_CSPACE_RGB :
+    case CUPS_CSPACE_SRGB :
+    case CUPS_CSPACE_ADOBERGB :
+        return (_PAPPL_CFAMILY_RGB);
+
+    case CUPS_CSPACE_CMYK :
+        return (_PAPPL_CFAMILY_CMYK);
+
+    default :
+        return (_PAPPL_CFAMILY_NONE);
+  }
+}
+
+
+//
+// 'convert_gray_rgb()' - Convert 8-bit gray pixels to RGB.
+//
+// Pixels are converted from the end of the line so that the conversion can be
+// done in place.
+//
+
+static void
+convert_gray_rgb(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src,		// I - Input pixels
+    unsigned            count)		// I - Number of pixels
+{
+  unsigned char	v;			// Gray value
+
+
+#if _PAPPL_CONVERT_NEON
+  unsigned	blocks = count / 16;	// Whole blocks
+
+
+  for (; count > blocks * 16; count --)
+  {
+    v = src[count - 1];
+
+    dst[3 * count - 3] = v;
+    dst[3 * count - 2] = v;
+    dst[3 * count - 1] = v;
+  }
+
+  while (blocks > 0)
+  {
+    uint8x16x3_t	rgb;
+
+    blocks --;
+
+    rgb.val[0] = vld1q_u8(src + 16 * blocks);
+    rgb.val[1] = rgb.val[0];
+    rgb.val[2] = rgb.val[0];
+
+    vst3q_u8(dst + 48 * blocks, rgb);
+  }
+
+#else
+  for (; count > 0; count --)
+  {
+    v = src[count - 1];
+
+    dst[3 * count - 3] = v;
+    dst[3 * count - 2] = v;
+    dst[3 * count - 1] = v;
+  }
+#endif // _PAPPL_CONVERT_NEON
+}
+
+
+//
+// 'convert_invert()' - Invert 8-bit values.
+//
+
+static void
+convert_invert(
+    unsigned char       *dst,		// I - Output values
+    const unsigned char *src,		// I - Input values
+    unsigned            count)		// I - Number of values
+{
+#if _PAPPL_CONVERT_SSE2
+  __m128i	ones = _mm_set1_epi8(-1);
+					// All bits set
+
+
+  for (; count >= 16; count -= 16, src += 16, dst += 16)
+    _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(_mm_loadu_si128((const __m128i *)src), ones));
+
+#elif _PAPPL_CONVERT_NEON
+  for (; count >= 16; count -= 16, src += 16, dst += 16)
+    vst1q_u8(dst, vmvnq_u8(vld1q_u8(src)));
+#endif // _PAPPL_CONVERT_SSE2
+
+  for (; count > 0; count --)
+    *dst++ = (unsigned char)(255 - *src++);
+}
+
+
+//
+// 'convert_narrow16()' - Convert 16-bit values to 8 bits.
+//
+
+static void
+convert_narrow16(
+    unsigned char       *dst,		// I - Output values
+    const unsigned char *src,		// I - Input values
+    unsigned            count)		// I - Number of values
+{
+  const unsigned short	*src16 = (const unsigned short *)src;
+					// 16-bit input values
+
+
+#if _PAPPL_CONVERT_SSE2
+  for (; count >= 16; count -= 16, src16 += 16, dst += 16)
+    _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)src16), 8), _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src16 + 8)), 8)));
+
+#elif _PAPPL_CONVERT_NEON
+  for (; count >= 16; count -= 16, src16 += 16, dst += 16)
+    vst1q_u8(dst, vcombine_u8(vshrn_n_u16(vld1q_u16(src16), 8), vshrn_n_u16(vld1q_u16(src16 + 8), 8)));
+#endif // _PAPPL_CONVERT_SSE2
+
+  for (; count > 0; count --)
+    *dst++ = (unsigned char)(*src16++ >> 8);
+}
+
+
+//
+// 'convert_rgb_gray()' - Convert 8-bit RGB pixels to gray.
+//
+// The luminance uses the Rec. 601 weights scaled to 256, rounded.
+//
+
+static void
+convert_rgb_gray(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *src,		// I - Input pixels
+    unsigned            count)		// I - Number of pixels
+{
+#if _PAPPL_CONVERT_NEON
+  uint8x8_t	rw = vdup_n_u8(77),	// Red weight
+		gw = vdup_n_u8(150),	// Green weight
+		bw = vdup_n_u8(29);	// Blue weight
+
+
+  for (; count >= 16; count -= 16, src += 48, dst += 16)
+  {
+    uint8x16x3_t	rgb = vld3q_u8(src);
+    uint16x8_t		lo, hi;
+
+    lo = vmull_u8(vget_low_u8(rgb.val[0]), rw);
+    lo = vmlal_u8(lo, vget_low_u8(rgb.val[1]), gw);
+    lo = vmlal_u8(lo, vget_low_u8(rgb.val[2]), bw);
+    hi = vmull_u8(vget_high_u8(rgb.val[0]), rw);
+    hi = vmlal_u8(hi, vget_high_u8(rgb.val[1]), gw);
+    hi = vmlal_u8(hi, vget_high_u8(rgb.val[2]), bw);
+
+    vst1q_u8(dst, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+  }
+#endif // _PAPPL_CONVERT_NEON
+
+  for (; count > 0; count --, src += 3)
+    *dst++ = (unsigned char)((77 * src[0] + 150 * src[1] + 29 * src[2] + 128) >> 8);
+}
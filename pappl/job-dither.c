@@ -0,0 +1,475 @@
+//
+// Dithering functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define _PAPPL_DITHER_SSE2	1	// Use SSE2 kernel
+#endif // __SSE2__ || _M_X64 || _M_AMD64
+#if _PAPPL_DITHER_SSE2 && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define _PAPPL_DITHER_AVX2	1	// Use AVX2 kernel when available
+#endif // _PAPPL_DITHER_SSE2 && (__GNUC__ || __clang__) && (__x86_64__ || __i386__)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define _PAPPL_DITHER_NEON	1	// Use NEON kernel
+#endif // __ARM_NEON || __ARM_NEON__
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_DPLANE_ALIGN	64	// Alignment of threshold rows
+#define _PAPPL_DPLANE_MAX	8	// Maximum cached planes per printer
+
+
+//
+// Types...
+//
+
+typedef void (*_pappl_dither_kernel_t)(unsigned char *line, const unsigned char *pixels, unsigned count, const unsigned char *thresholds, bool invert);
+					// Vector dithering kernel
+
+
+//
+// Local globals...
+//
+
+static pthread_once_t	dither_once = PTHREAD_ONCE_INIT;
+					// One-time initialization
+static _pappl_dither_kernel_t dither_kernel = NULL;
+					// Vector kernel, if any
+static unsigned		dither_block = 0;
+					// Pixels per kernel block
+#if _PAPPL_DITHER_SSE2
+static const unsigned char dither_reverse[256] =
+{					// Bit-reversed bytes
+  0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+  0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
+  0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+  0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
+  0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
+  0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+  0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
+  0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
+  0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+  0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
+  0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
+  0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+  0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+  0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
+  0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+  0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF
+};
+#endif // _PAPPL_DITHER_SSE2
+
+
+//
+// Local functions...
+//
+
+static void	dither_init(void);
+static void	dither_scalar(unsigned char *line, unsigned x, unsigned count, const unsigned char *pixels, const unsigned char *thresholds, bool invert);
+#if _PAPPL_DITHER_SSE2
+static void	dither_sse2(unsigned char *line, const unsigned char *pixels, unsigned count, const unsigned char *thresholds, bool invert);
+#endif // _PAPPL_DITHER_SSE2
+#if _PAPPL_DITHER_AVX2
+static void	dither_avx2(unsigned char *line, const unsigned char *pixels, unsigned count, const unsigned char *thresholds, bool invert) __attribute__((target("avx2")));
+#endif // _PAPPL_DITHER_AVX2
+#if _PAPPL_DITHER_NEON
+static void	dither_neon(unsigned char *line, const unsigned char *pixels, unsigned count, const unsigned char *thresholds, bool invert);
+#endif // _PAPPL_DITHER_NEON
+
+
+//
+// '_papplDitherLine()' - Dither a line of 8-bit pixels to a 1-bit bitmap.
+//
+// This function thresholds "count" 8-bit pixels against a row of a dither
+// threshold plane (see `_PAPPL_DPLANE_ROW`), which holds a threshold for every
+// column of the line, and stores the resulting bits (most significant bit
+// first) in "line" starting at column "x".  Bytes containing the first and last
+// columns are overwritten, with bits outside the range set to 0.
+//
+// When "invert" is `false` a bit is set for pixels greater than the dither
+// value (black input), otherwise a bit is set for pixels less than or equal to
+// the dither value (grayscale input).
+//
+// A SIMD kernel is used when the CPU supports one.  Results are identical to
+// the scalar loop.
+//
+
+void
+_papplDitherLine(
+    unsigned char       *line,		// I - Output bitmap line
+    unsigned            x,		// I - Starting column
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *pixels,	// I - 8-bit pixels
+    const unsigned char *thresholds,	// I - Threshold row for the whole line
+    bool                invert)		// I - `true` for grayscale, `false` for black
+{
+  unsigned	lead,			// Pixels before first byte boundary
+		n;			// Pixels for vector kernel
+
+
+  pthread_once(&dither_once, dither_init);
+
+  lead = (8 - (x & 7)) & 7;
+
+  if (dither_kernel && count >= (lead + dither_block))
+  {
+    // Dither any pixels up to the next byte boundary...
+    if (lead > 0)
+    {
+      dither_scalar(line, x, lead, pixels, thresholds, invert);
+
+      x      += lead;
+      pixels += lead;
+      count  -= lead;
+    }
+
+    // Then use the vector kernel for whole blocks...
+    n = count - count % dither_block;
+
+    (dither_kernel)(line + x / 8, pixels, n, thresholds + x, invert);
+
+    x      += n;
+    pixels += n;
+    count  -= n;
+  }
+
+  // Dither whatever is left, including the partial byte for an empty range
+  // like the scalar loop does...
+  if (count > 0 || (x & 7))
+    dither_scalar(line, x, count, pixels, thresholds, invert);
+}
+
+
+//
+// '_papplDitherPlaneCreate()' - Create a dither threshold plane.
+//
+// The "mwidth" by "mheight" dither matrix is repeated across "width" columns
+// so that each row of the plane holds the threshold for every column of a
+// line.  Rows are padded to a multiple of 64 bytes and 64-byte aligned, which
+// lets the dithering kernels compare pixels and thresholds directly and makes
+// the per-pixel cost independent of the matrix size.
+//
+
+_pappl_dplane_t *			// O - Threshold plane or `NULL` on error
+_papplDitherPlaneCreate(
+    const unsigned char *matrix,	// I - Dither matrix, row by row
+    unsigned            mwidth,		// I - Matrix width
+    unsigned            mheight,	// I - Matrix height
+    unsigned            width)		// I - Line width in columns
+{
+  _pappl_dplane_t	*plane;		// Threshold plane
+  unsigned		y;		// Current row
+  size_t		filled,		// Bytes filled in row
+			bytes;		// Bytes to copy
+  unsigned char		*row;		// Current row
+
+
+  if (!matrix || mwidth == 0 || mheight == 0 || width == 0)
+    return (NULL);
+
+  if ((plane = calloc(1, sizeof(_pappl_dplane_t))) == NULL)
+    return (NULL);
+
+  plane->refcount = 1;
+  plane->width    = width;
+  plane->height   = mheight;
+  plane->stride   = ((size_t)width + _PAPPL_DPLANE_ALIGN - 1) & ~(size_t)(_PAPPL_DPLANE_ALIGN - 1);
+
+  if ((plane->data = malloc(plane->stride * mheight + _PAPPL_DPLANE_ALIGN - 1)) == NULL)
+  {
+    free(plane);
+    return (NULL);
+  }
+
+  plane->rows = plane->data + ((_PAPPL_DPLANE_ALIGN - (size_t)plane->data % _PAPPL_DPLANE_ALIGN) % _PAPPL_DPLANE_ALIGN);
+
+  for (y = 0, row = plane->rows; y < mheight; y ++, row += plane->stride, matrix += mwidth)
+  {
+    // Copy the matrix row and then double it until the row is full...
+    filled = mwidth < plane->stride ? mwidth : plane->stride;
+    memcpy(row, matrix, filled);
+
+    while (filled < plane->stride)
+    {
+      bytes = plane->stride - filled < filled ? plane->stride - filled : filled;
+      memcpy(row + filled, row, bytes);
+      filled += bytes;
+    }
+  }
+
+  return (plane);
+}
+
+
+//
+// '_papplDitherPlaneRelease()' - Release a reference to a dither threshold
+//                                plane.
+//
+
+void
+_papplDitherPlaneRelease(
+    _pappl_dplane_t *plane)		// I - Threshold plane
+{
+  if (!plane || _PAPPL_ATOMIC_ADD(&plane->refcount, -1) > 1)
+    return;
+
+  free(plane->data);
+  free(plane);
+}
+
+
+//
+// '_papplPrinterGetDitherPlane()' - Get a cached dither threshold plane.
+//
+// The printer keeps the most recently used planes for each dither matrix and
+// line width, so the planes for its content types are only built once.  The
+// returned plane is retained and must be released using
+// `_papplDitherPlaneRelease`.
+//
+
+_pappl_dplane_t *			// O - Threshold plane or `NULL` on error
+_papplPrinterGetDitherPlane(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_dither_t  dither,		// I - Dither matrix
+    unsigned        width)		// I - Line width in columns
+{
+  _pappl_dplane_t	*plane,		// Current plane
+			*prev;		// Previous plane
+  int			count;		// Number of planes
+
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  for (plane = printer->dplanes, prev = NULL; plane; prev = plane, plane = plane->next)
+  {
+    if (plane->width >= width && !memcmp(plane->dither, dither, sizeof(pappl_dither_t)))
+      break;
+  }
+
+  if (plane)
+  {
+    // Move the plane to the front of the cache...
+    if (prev)
+    {
+      prev->next       = plane->next;
+      plane->next      = printer->dplanes;
+      printer->dplanes = plane;
+    }
+  }
+  else if ((plane = _papplDitherPlaneCreate(dither[0], 16, 16, width)) != NULL)
+  {
+    // Add a new plane to the front of the cache, dropping the least recently
+    // used plane when the cache is full...
+    memcpy(plane->dither, dither, sizeof(pappl_dither_t));
+
+    plane->next      = printer->dplanes;
+    printer->dplanes = plane;
+
+    for (prev = plane, count = 1; prev->next; prev = prev->next, count ++)
+    {
+      if (count >= _PAPPL_DPLANE_MAX)
+      {
+        _papplDitherPlaneRelease(prev->next);
+        prev->next = NULL;
+        break;
+      }
+    }
+  }
+
+  if (plane)
+    _PAPPL_ATOMIC_ADD(&plane->refcount, 1);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  return (plane);
+}
+
+
+//
+// 'dither_init()' - Choose the dithering kernel for this CPU.
+//
+
+static void
+dither_init(void)
+{
+#if _PAPPL_DITHER_AVX2
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+  {
+    dither_kernel = dither_avx2;
+    dither_block  = 32;
+    return;
+  }
+#endif // _PAPPL_DITHER_AVX2
+
+#if _PAPPL_DITHER_SSE2
+  dither_kernel = dither_sse2;
+  dither_block  = 16;
+
+#elif _PAPPL_DITHER_NEON
+  dither_kernel = dither_neon;
+  dither_block  = 16;
+#endif // _PAPPL_DITHER_SSE2
+}
+
+
+//
+// 'dither_scalar()' - Dither pixels one at a time.
+//
+
+static void
+dither_scalar(
+    unsigned char       *line,		// I - Output bitmap line
+    unsigned            x,		// I - Starting column
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *pixels,	// I - 8-bit pixels
+    const unsigned char *thresholds,	// I - Threshold row for the whole line
+    bool                invert)		// I - `true` for grayscale, `false` for black
+{
+  unsigned char	*lineptr,		// Pointer into line
+		byte,			// Byte in line
+		bit;			// Current bit
+
+
+  for (lineptr = line + x / 8, bit = 128 >> (x & 7), byte = 0; count > 0; count --, x ++, pixels ++)
+  {
+    if ((*pixels > thresholds[x]) != invert)
+      byte |= bit;
+
+    if (bit == 1)
+    {
+      *lineptr++ = byte;
+      byte       = 0;
+      bit        = 128;
+    }
+    else
+      bit /= 2;
+  }
+
+  if (bit < 128)
+    *lineptr = byte;
+}
+
+
+#if _PAPPL_DITHER_SSE2
+//
+// 'dither_sse2()' - Dither 16 pixels at a time using SSE2.
+//
+
+static void
+dither_sse2(
+    unsigned char       *line,		// I - Output bitmap line (byte aligned)
+    const unsigned char *pixels,	// I - 8-bit pixels
+    unsigned            count,		// I - Number of pixels (multiple of 16)
+    const unsigned char *thresholds,	// I - Thresholds for the pixels
+    bool                invert)		// I - `true` for grayscale, `false` for black
+{
+  __m128i	zero = _mm_setzero_si128();
+					// Zero
+  int		flip = invert ? 0 : 0xffff,
+					// Bits to flip for black
+		bits;			// Bits for 16 pixels
+
+
+  for (; count > 0; count -= 16, pixels += 16, thresholds += 16, line += 2)
+  {
+    // An unsigned saturated subtraction is 0 when pixel <= threshold...
+    bits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(_mm_loadu_si128((const __m128i *)pixels), _mm_loadu_si128((const __m128i *)thresholds)), zero)) ^ flip;
+
+    // movemask puts the first pixel in the least significant bit...
+    line[0] = dither_reverse[bits & 255];
+    line[1] = dither_reverse[(bits >> 8) & 255];
+  }
+}
+#endif // _PAPPL_DITHER_SSE2
+
+
+#if _PAPPL_DITHER_AVX2
+//
+// 'dither_avx2()' - Dither 32 pixels at a time using AVX2.
+//
+
+static void
+dither_avx2(
+    unsigned char       *line,		// I - Output bitmap line (byte aligned)
+    const unsigned char *pixels,	// I - 8-bit pixels
+    unsigned            count,		// I - Number of pixels (multiple of 32)
+    const unsigned char *thresholds,	// I - Thresholds for the pixels
+    bool                invert)		// I - `true` for grayscale, `false` for black
+{
+  __m256i	zero = _mm256_setzero_si256();
+					// Zero
+  unsigned	flip = invert ? 0 : 0xffffffff,
+					// Bits to flip for black
+		bits;			// Bits for 32 pixels
+
+
+  for (; count > 0; count -= 32, pixels += 32, thresholds += 32, line += 4)
+  {
+    bits = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_subs_epu8(_mm256_loadu_si256((const __m256i *)pixels), _mm256_loadu_si256((const __m256i *)thresholds)), zero)) ^ flip;
+
+    line[0] = dither_reverse[bits & 255];
+    line[1] = dither_reverse[(bits >> 8) & 255];
+    line[2] = dither_reverse[(bits >> 16) & 255];
+    line[3] = dither_reverse[bits >> 24];
+  }
+}
+#endif // _PAPPL_DITHER_AVX2
+
+
+#if _PAPPL_DITHER_NEON
+//
+// 'dither_neon()' - Dither 16 pixels at a time using NEON.
+//
+
+static void
+dither_neon(
+    unsigned char       *line,		// I - Output bitmap line (byte aligned)
+    const unsigned char *pixels,	// I - 8-bit pixels
+    unsigned            count,		// I - Number of pixels (multiple of 16)
+    const unsigned char *thresholds,	// I - Thresholds for the pixels
+    bool                invert)		// I - `true` for grayscale, `false` for black
+{
+  static const unsigned char weights[16] =
+  {					// Bit for each pixel
+    128, 64, 32, 16, 8, 4, 2, 1, 128, 64, 32, 16, 8, 4, 2, 1
+  };
+  uint8x16_t	w = vld1q_u8(weights),	// Bit weights
+		p,			// Pixels
+		d,			// Thresholds
+		m;			// Threshold mask
+  uint8x8_t	b;			// Packed bits
+
+
+  for (; count > 0; count -= 16, pixels += 16, thresholds += 16, line += 2)
+  {
+    p = vld1q_u8(pixels);
+    d = vld1q_u8(thresholds);
+    m = vandq_u8(invert ? vcleq_u8(p, d) : vcgtq_u8(p, d), w);
+
+    // Add the weighted bits within each half to get two bytes...
+    b = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+    b = vpadd_u8(b, b);
+    b = vpadd_u8(b, b);
+
+    line[0] = vget_lane_u8(b, 0);
+    line[1] = vget_lane_u8(b, 1);
+  }
+}
+#endif // _PAPPL_DITHER_NEON
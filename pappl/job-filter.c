@@ -1,7 +1,7 @@
 //
 // Job MIME filter functions for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -11,8 +11,7 @@
 // Include necessary headers...
 //
 
-#include "pappl.h"
-#include "job-private.h"
+#include "pappl-private.h"
 #ifdef HAVE_LIBJPEG
 #  include <setjmp.h>
 #  include <jpeglib.h>
@@ -22,10 +21,94 @@
 #endif // HAVE_LIBPNG
 
 
+//
+// Constants...
+//
+
+#define _PAPPL_BAND_LINES	32	// Lines per band for parallel rendering
+#define _PAPPL_BAND_SLOTS	2	// Band buffers per thread
+
+
 //
 // Local types...
 //
 
+typedef enum _pappl_isrc_mode_e		// Image source modes
+{
+  _PAPPL_ISRC_MEMORY,				// Whole image in memory
+  _PAPPL_ISRC_STREAM,				// Rows read in order from the callback
+  _PAPPL_ISRC_ROWS,				// Bands of rows spooled to a scratch file
+  _PAPPL_ISRC_STRIPS				// Strips of columns spooled to a scratch file
+} _pappl_isrc_mode_t;
+
+typedef struct _pappl_isrc_s		// Image source
+{
+  pappl_job_t		*job;			// Job
+  _pappl_isrc_mode_t	mode;			// Source mode
+  ipp_orient_t		orient;			// Orientation of output
+  pappl_image_row_cb_t	row_cb;			// Row callback
+  void			*row_data;		// Row callback data
+  int			width,			// Width in columns
+			height,			// Height in lines
+			depth;			// Bytes per pixel
+  size_t		rowsize;		// Bytes per image row
+  const unsigned char	*pixels;		// Image in memory, if any
+  unsigned char		*image,			// Loaded image, if any
+			*buffer;		// Row/strip buffer
+  int			fd;			// Scratch file, if any
+  char			filename[1024];		// Scratch filename
+  int			band,			// Rows or columns per band/strip
+			first,			// First row/column in buffer or -1
+			count;			// Number of rows/columns in buffer
+} _pappl_isrc_t;
+
+typedef struct _pappl_lerp_s		// Bilinear interpolation state
+{
+  int			width,			// Width of rotated image
+			depth,			// Bytes per pixel
+			count;			// Number of output pixels per line
+  int			*xoff;			// Left source column for each output pixel
+  unsigned char		*xfrac;			// Weight of right source column
+  unsigned char		*rows[2];		// Source lines
+  int			lines[2];		// Source line numbers or -1
+  unsigned char		*line;			// Interpolated line
+} _pappl_lerp_t;
+
+typedef struct _pappl_irender_s		// Image line renderer
+{
+  pappl_pr_options_t	*options;		// Print options
+  _pappl_isrc_t		*src;			// Image source
+  _pappl_dplane_t	*dplane;		// Dither thresholds for 1-bit output
+  int			depth,			// Bytes per pixel
+			img_width,		// Rotated image width
+			img_height,		// Rotated image height
+			xsize,			// Scaled width
+			xstart,			// X start position
+			xend,			// X end position
+			xmod,			// X modulus
+			ysize,			// Scaled height
+			ystart;			// Y start position
+  bool			smoothing;		// Interpolate the image?
+} _pappl_irender_t;
+
+typedef struct _pappl_bands_s		// Parallel band rendering state
+{
+  _pappl_irender_t	*render;		// Line renderer
+  pthread_mutex_t	mutex;			// Mutex for state
+  pthread_cond_t	cond;			// Condition for state changes
+  int			first,			// First image line
+			last,			// Last image line plus 1
+			lines,			// Lines per band
+			num_bands,		// Number of bands
+			num_slots,		// Number of band buffers
+			next_band,		// Next band to render
+			written_band;		// Next band to write
+  int			*slot_band;		// Band rendered in each buffer or -1
+  unsigned char		*buffer;		// Band buffers
+  size_t		bufsize;		// Bytes per band buffer
+  bool			failed;			// Did rendering fail?
+} _pappl_bands_t;
+
 #ifdef HAVE_LIBJPEG
 typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
 {
@@ -33,17 +116,63 @@ typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
   jmp_buf	retbuf;				// setjmp() return buffer
   char		message[JMSG_LENGTH_MAX];	// Last error message
 } _pappl_jpeg_err_t;
+
+typedef struct _pappl_jpeg_src_s	// JPEG HTTP source manager
+{
+  struct jpeg_source_mgr pub;			// Public source manager data
+  http_t	*http;				// HTTP connection
+  JOCTET	buffer[8192];			// Read buffer
+} _pappl_jpeg_src_t;
 #endif // HAVE_LIBJPEG
 
+#ifdef HAVE_LIBPNG
+typedef struct _pappl_png_mem_s		// PNG memory source
+{
+  const unsigned char	*data;			// Mapped document data
+  size_t		length,			// Length of data
+			offset;			// Current offset in data
+} _pappl_png_mem_t;
+#endif // HAVE_LIBPNG
+
 
 //
 // Local functions...
 //
 
+static int	filter_bands(pappl_job_t *job, pappl_device_t *device, pappl_pr_driver_data_t *driver_data, _pappl_irender_t *render, int y, int yend, int num_threads);
+static bool	filter_image(pappl_job_t *job, pappl_device_t *device, pappl_pr_options_t *options, const unsigned char *pixels, pappl_image_row_cb_t row_cb, void *row_data, int width, int height, int depth, int ppi, bool smoothing);
+static double	image_scale(pappl_pr_options_t *options, int width, int height, int ppi);
+static void	isrc_free(_pappl_isrc_t *src);
+static const unsigned char *isrc_get_row(_pappl_isrc_t *src, int y, int *xdir);
+static bool	isrc_init(_pappl_isrc_t *src, pappl_job_t *job, ipp_orient_t orient, int copies, const unsigned char *pixels, pappl_image_row_cb_t row_cb, void *row_data, int width, int height, int depth);
+static bool	isrc_read(_pappl_isrc_t *src, off_t offset, size_t bytes);
+static bool	isrc_read_rows(_pappl_isrc_t *src, unsigned char *rows, int count);
+static bool	isrc_spool(_pappl_isrc_t *src, size_t max_memory);
+static void	lerp_free(_pappl_lerp_t *lerp);
+static bool	lerp_init(_pappl_lerp_t *lerp, int width, int depth, int xstart, int xend, int xsize);
+static const unsigned char *lerp_line(_pappl_lerp_t *lerp, _pappl_isrc_t *src, int height, int y, int ysize);
+static bool	render_line(_pappl_irender_t *render, _pappl_lerp_t *lerp, unsigned char *row, int y, unsigned char *line);
+static void	*run_bands_thread(_pappl_bands_t *bands);
+
 #ifdef HAVE_LIBJPEG
+static bool	filter_jpeg(pappl_job_t *job, pappl_device_t *device, const unsigned char *data, size_t length, http_t *http);
 static void	jpeg_error_handler(j_common_ptr p) _PAPPL_NORETURN;
+static boolean	jpeg_fill_http(j_decompress_ptr dinfo);
+static void	jpeg_init_http(j_decompress_ptr dinfo);
+static bool	jpeg_read_row(j_decompress_ptr dinfo, unsigned char *row);
+static void	jpeg_skip_http(j_decompress_ptr dinfo, long num_bytes);
 #endif // HAVE_LIBJPEG
 
+#ifdef HAVE_LIBPNG
+static bool	filter_png(pappl_job_t *job, pappl_device_t *device, const unsigned char *data, size_t length, http_t *http);
+static void	png_error_handler(png_structp pp, png_const_charp message) _PAPPL_NORETURN;
+static void	png_read_http(png_structp pp, png_bytep buffer, png_size_t bytes);
+static bool	png_read_image_row(png_structp pp, unsigned char *row);
+static unsigned char *png_read_interlaced(png_structp pp, png_uint_32 width, png_uint_32 height, int bpp);
+static void	png_read_mem(png_structp pp, png_bytep buffer, png_size_t bytes);
+static void	png_warning_handler(png_structp pp, png_const_charp message);
+#endif // HAVE_LIBPNG
+
 
 //
 // 'papplJobFilterImage()' - Filter an image in memory.
@@ -71,25 +200,318 @@ papplJobFilterImage(
     int                 depth,		// I - Bytes per pixel (`1` for grayscale or `3` for sRGB)
     int                 ppi,		// I - Pixels per inch (`0` for unknown)
     bool		smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
+{
+  return (filter_image(job, device, options, pixels, NULL, NULL, width, height, depth, ppi, smoothing));
+}
+
+
+//
+// 'papplJobFilterImageRows()' - Filter an image that is read a line at a time.
+//
+// This function prints a grayscale or sRGB image like @link papplJobFilterImage@
+// but reads the image data one line at a time, from top to bottom, using the
+// "row_cb" callback.  The callback receives the "row_data" pointer and a buffer
+// for "width" * "depth" bytes and returns `true` on success or `false` on
+// error.
+//
+// Portrait images are printed without holding more than one line of the image
+// in memory.  Rotated images and multiple copies need random access to the
+// image data, so the image is either loaded into memory or, when it is larger
+// than the limit set with @link papplSystemSetMaxImageMemory@, spooled to a
+// scratch file and read back in bands.
+//
+// @since PAPPL 1.1@
+//
+
+bool					// O - `true` on success, `false` otherwise
+papplJobFilterImageRows(
+    pappl_job_t          *job,		// I - Job
+    pappl_device_t       *device,	// I - Device
+    pappl_pr_options_t   *options,	// I - Print options
+    pappl_image_row_cb_t row_cb,	// I - Row callback
+    void                 *row_data,	// I - Row callback data
+    int                  width,		// I - Width in columns
+    int                  height,	// I - Height in lines
+    int                  depth,		// I - Bytes per pixel (`1` for grayscale or `3` for sRGB)
+    int                  ppi,		// I - Pixels per inch (`0` for unknown)
+    bool		 smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
+{
+  if (!row_cb)
+    return (false);
+
+  return (filter_image(job, device, options, NULL, row_cb, row_data, width, height, depth, ppi, smoothing));
+}
+
+
+//
+// '_papplJobFilterJPEG()' - Filter a JPEG image file.
+//
+
+#ifdef HAVE_LIBJPEG
+bool
+_papplJobFilterJPEG(
+    pappl_job_t    *job,		// I - Job
+    pappl_device_t *device,		// I - Device
+    void           *data)		// I - Filter data (unused)
+{
+  const unsigned char	*jpeg;		// JPEG data
+  size_t		length;		// Length of JPEG data
+  bool			ret;		// Return value
+
+
+  (void)data;
+
+  // Map the JPEG file...
+  if ((jpeg = papplJobMapFile(job, &length)) == NULL)
+    return (false);
+
+  ret = filter_jpeg(job, device, jpeg, length, NULL);
+
+  papplJobUnmapFile(job, jpeg, length);
+
+  return (ret);
+}
+#endif // HAVE_LIBJPEG
+
+
+//
+// '_papplJobFilterPNG()' - Filter a PNG image file.
+//
+
+#ifdef HAVE_LIBPNG
+bool					// O - `true` on success and `false` otherwise
+_papplJobFilterPNG(
+    pappl_job_t    *job,		// I - Job
+    pappl_device_t *device,		// I - Device
+    void           *data)		// I - Filter data (unused)
+{
+  const unsigned char	*png;		// PNG data
+  size_t		length;		// Length of PNG data
+  bool			ret;		// Return value
+
+
+  (void)data;
+
+  // Map the PNG file...
+  if ((png = papplJobMapFile(job, &length)) == NULL)
+    return (false);
+
+  ret = filter_png(job, device, png, length, NULL);
+
+  papplJobUnmapFile(job, png, length);
+
+  return (ret);
+}
+#endif // HAVE_LIBPNG
+
+
+//
+// '_papplJobStreamImage()' - Print a JPEG or PNG image as it is received.
+//
+// The image is decoded directly from the HTTP connection without spooling it
+// to a file first.
+//
+
+bool					// O - `true` on success and `false` otherwise
+_papplJobStreamImage(
+    pappl_job_t    *job,		// I - Job
+    pappl_device_t *device,		// I - Device
+    http_t         *http)		// I - HTTP connection
+{
+#ifdef HAVE_LIBJPEG
+  if (!strcmp(job->format, "image/jpeg"))
+    return (filter_jpeg(job, device, NULL, 0, http));
+#endif // HAVE_LIBJPEG
+
+#ifdef HAVE_LIBPNG
+  if (!strcmp(job->format, "image/png"))
+    return (filter_png(job, device, NULL, 0, http));
+#endif // HAVE_LIBPNG
+
+  (void)device;
+  (void)http;
+
+  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to stream job with format '%s'.", job->format);
+
+  return (false);
+}
+
+
+//
+// 'filter_bands()' - Render the image lines of a page in parallel bands.
+//
+// Worker threads render consecutive bands of "_PAPPL_BAND_LINES" lines into a
+// ring of band buffers while this thread writes the finished bands to the
+// driver in order, so the driver callbacks are still only called from the
+// job's thread.  A worker waits for its buffer to be written before it starts
+// a band that is more than one ring ahead.
+//
+
+static int				// O - Next line to write or `-1` on error
+filter_bands(
+    pappl_job_t            *job,	// I - Job
+    pappl_device_t         *device,	// I - Device
+    pappl_pr_driver_data_t *driver_data,// I - Driver data
+    _pappl_irender_t       *render,	// I - Line renderer
+    int                    y,		// I - First image line
+    int                    yend,	// I - Last image line plus 1
+    int                    num_threads)	// I - Number of threads
+{
+  pappl_pr_options_t	*options = render->options;
+					// Print options
+  _pappl_bands_t	bands;		// Band rendering state
+  pthread_t		*threads;	// Worker threads
+  int			i,		// Looping var
+			count,		// Number of threads started
+			band,		// Current band
+			slot,		// Buffer for current band
+			last;		// Last line in band plus 1
+  unsigned char		*line;		// Current line
+  bool			ok = true;	// Did everything work?
+
+
+  memset(&bands, 0, sizeof(bands));
+
+  bands.render    = render;
+  bands.first     = y;
+  bands.last      = yend;
+  bands.lines     = _PAPPL_BAND_LINES;
+  bands.num_bands = (yend - y + _PAPPL_BAND_LINES - 1) / _PAPPL_BAND_LINES;
+
+  if (num_threads > bands.num_bands)
+    num_threads = bands.num_bands;
+
+  bands.num_slots = _PAPPL_BAND_SLOTS * num_threads;
+  bands.bufsize   = (size_t)bands.lines * options->header.cupsBytesPerLine;
+
+  if ((threads = calloc((size_t)num_threads, sizeof(pthread_t))) == NULL || (bands.slot_band = calloc((size_t)bands.num_slots, sizeof(int))) == NULL || (bands.buffer = malloc((size_t)bands.num_slots * bands.bufsize)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for image bands.");
+    free(threads);
+    free(bands.slot_band);
+    return (-1);
+  }
+
+  // The renderers only write the image columns of each line, so start with
+  // blank lines...
+  memset(bands.buffer, options->header.cupsColorSpace == CUPS_CSPACE_K || options->header.cupsColorSpace == CUPS_CSPACE_CMYK ? 0x00 : 0xff, (size_t)bands.num_slots * bands.bufsize);
+
+  for (i = 0; i < bands.num_slots; i ++)
+    bands.slot_band[i] = -1;
+
+  pthread_mutex_init(&bands.mutex, NULL);
+  pthread_cond_init(&bands.cond, NULL);
+
+  for (count = 0; count < num_threads; count ++)
+  {
+    if (pthread_create(threads + count, NULL, (void *(*)(void *))run_bands_thread, &bands))
+      break;
+  }
+
+  if (count == 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create image band thread.");
+    ok = false;
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Rendering %d bands with %d threads.", bands.num_bands, count);
+
+  // Write the bands in order as they are finished...
+  for (band = 0; ok && band < bands.num_bands; band ++)
+  {
+    slot = band % bands.num_slots;
+
+    pthread_mutex_lock(&bands.mutex);
+    while (!bands.failed && bands.slot_band[slot] != band)
+      pthread_cond_wait(&bands.cond, &bands.mutex);
+    ok = !bands.failed;
+    pthread_mutex_unlock(&bands.mutex);
+
+    if (!ok)
+      break;
+
+    last = y + bands.lines;
+    if (last > yend)
+      last = yend;
+
+    for (line = bands.buffer + (size_t)slot * bands.bufsize; y < last; y ++, line += options->header.cupsBytesPerLine)
+    {
+      if (!(driver_data->rwriteline_cb)(job, options, device, (unsigned)y, line))
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+	ok = false;
+	break;
+      }
+    }
+
+    if (job->is_canceled)
+      break;
+
+    // Let the workers reuse the buffer...
+    pthread_mutex_lock(&bands.mutex);
+    bands.slot_band[slot] = -1;
+    bands.written_band    = band + 1;
+    pthread_cond_broadcast(&bands.cond);
+    pthread_mutex_unlock(&bands.mutex);
+  }
+
+  // Stop any workers that are still running and clean up...
+  pthread_mutex_lock(&bands.mutex);
+  bands.failed = true;
+  pthread_cond_broadcast(&bands.cond);
+  pthread_mutex_unlock(&bands.mutex);
+
+  for (i = 0; i < count; i ++)
+    pthread_join(threads[i], NULL);
+
+  pthread_cond_destroy(&bands.cond);
+  pthread_mutex_destroy(&bands.mutex);
+
+  free(threads);
+  free(bands.slot_band);
+  free(bands.buffer);
+
+  return (ok ? y : -1);
+}
+
+
+//
+// 'filter_image()' - Filter an image in memory or streamed a line at a time.
+//
+// When "pixels" is `NULL`, the image lines are read using the row callback
+// through an image source that keeps memory use within the system limit.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+filter_image(
+    pappl_job_t         *job,		// I - Job
+    pappl_device_t      *device,	// I - Device
+    pappl_pr_options_t  *options,	// I - Print options
+    const unsigned char *pixels,	// I - Pointer to the top-left corner of the image data or `NULL` to stream
+    pappl_image_row_cb_t row_cb,	// I - Row callback for streamed images
+    void                *row_data,	// I - Row callback data
+    int                 width,		// I - Width in columns
+    int                 height,		// I - Height in lines
+    int                 depth,		// I - Bytes per pixel (`1` for grayscale or `3` for sRGB)
+    int                 ppi,		// I - Pixels per inch (`0` for unknown)
+    bool		smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
 {
   bool			started = false;// Have we started the job?
   int			i;		// Looping var
+  long long		trace_start;	// Start of traced span
   pappl_pr_driver_data_t driver_data;	// Printer driver data
-  const unsigned char	*dither;	// Dither line
   int			ileft,		// Imageable left margin
 			itop,		// Imageable top margin
 			iwidth,		// Imageable width
 			iheight;	// Imageable length/height
   unsigned char		white,		// White color
 			*line = NULL,	// Output line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
-  const unsigned char	*pixbase,	// Pointer to first pixel
-			*pixptr;	// Pointer into image
+			*row = NULL;	// Sampled pixels for dithering
+  _pappl_isrc_t		src;		// Image source
+  _pappl_lerp_t		lerp;		// Interpolation state
+  _pappl_irender_t	render;		// Line renderer
   int			img_width,	// Rotated image width
 			img_height,	// Rotated image height
-			x,		// X position
 			xsize,		// Scaled width
 			xstart,		// X start position
 			xend,		// X end position
@@ -97,15 +519,9 @@ papplJobFilterImage(
 			ysize,		// Scaled height
 			ystart,		// Y start position
 			yend;		// Y end position
-  int			xdir,		// X direction
-			xerr,		// X error accumulator
-			xmod,		// X modulus
-			xstep,		// X step
-			ydir;		// Y direction
-
+  int			xmod,		// X modulus
+			num_threads;	// Number of band threads
 
-  // TODO: Implement interpolation (Issue #64)
-  (void)smoothing;
 
   // Images contain a single page/impression...
   papplJobSetImpressions(job, 1);
@@ -194,11 +610,8 @@ papplJobFilterImage(
   {
     default :
     case IPP_ORIENT_PORTRAIT :
-        pixbase    = pixels;
         img_width  = width;
         img_height = height;
-        xdir       = (int)depth;
-        ydir       = (int)depth * (int)width;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -221,11 +634,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_REVERSE_PORTRAIT :
-        pixbase    = pixels + depth * width * height - depth;
         img_width  = width;
         img_height = height;
-        xdir       = -(int)depth;
-        ydir       = -(int)depth * (int)width;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -248,11 +658,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_LANDSCAPE : // 90 counter-clockwise
-        pixbase    = pixels + depth * width - depth;
         img_width  = height;
         img_height = width;
-        xdir       = (int)depth * (int)width;
-        ydir       = -(int)depth;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -275,11 +682,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_REVERSE_LANDSCAPE : // 90 clockwise
-        pixbase    = pixels + depth * (height - 1) * width;
         img_width  = height;
         img_height = width;
-        xdir       = -(int)depth * (int)width;
-        ydir       = (int)depth;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -302,6 +706,10 @@ papplJobFilterImage(
         break;
   }
 
+  // Set up the image source, which does the rotation for us...
+  if (!isrc_init(&src, job, options->orientation_requested, options->copies, pixels, row_cb, row_data, width, height, depth))
+    return (false);
+
   // Don't rotate in the driver...
   options->orientation_requested = IPP_ORIENT_PORTRAIT;
 
@@ -311,7 +719,6 @@ papplJobFilterImage(
   yend   = ystart + ysize;
 
   xmod   = (int)(img_width % xsize);
-  xstep  = (int)(img_width / xsize) * xdir;
 
   if (xend > (int)options->header.cupsWidth)
     xend = (int)options->header.cupsWidth;
@@ -319,17 +726,57 @@ papplJobFilterImage(
   if (yend > (int)options->header.cupsHeight)
     yend = (int)options->header.cupsHeight;
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%d, xstart=%d, xend=%d, xdir=%d, xmod=%d, xstep=%d", xsize, xstart, xend, xdir, xmod, xstep);
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%d, ystart=%d, yend=%d, ydir=%d", ysize, ystart, yend, ydir);
+  // Only interpolate when enlarging the image in both directions -
+  // nearest-neighbor sampling is just as good when reducing it...
+  if (smoothing && (xsize <= img_width || ysize <= img_height || xsize < 2 || ysize < 2))
+    smoothing = false;
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%d, xstart=%d, xend=%d, xmod=%d", xsize, xstart, xend, xmod);
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%d, ystart=%d, yend=%d, smoothing=%s", ysize, ystart, yend, smoothing ? "true" : "false");
 
   papplPrinterGetDriverData(papplJobGetPrinter(job), &driver_data);
 
-  if ((line = malloc(options->header.cupsBytesPerLine)) == NULL)
+  memset(&lerp, 0, sizeof(lerp));
+  memset(&render, 0, sizeof(render));
+
+  if (smoothing)
+  {
+    // Interpolated lines have one pixel per output column...
+    xmod = 0;
+
+    if (!lerp_init(&lerp, img_width, depth, xstart, xend, xsize))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for image interpolation.");
+      goto abort_job;
+    }
+  }
+
+  if ((line = malloc(options->header.cupsBytesPerLine)) == NULL || (options->header.cupsBitsPerPixel == 1 && (row = malloc(options->header.cupsWidth)) == NULL))
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster line.");
     goto abort_job;
   }
 
+  render.options    = options;
+  render.src        = &src;
+  render.depth      = depth;
+  render.img_width  = img_width;
+  render.img_height = img_height;
+  render.xsize      = xsize;
+  render.xstart     = xstart;
+  render.xend       = xend;
+  render.xmod       = xmod;
+  render.ysize      = ysize;
+  render.ystart     = ystart;
+  render.smoothing  = smoothing;
+
+  // Images in memory can be rendered in bands by several threads, as long as
+  // there are enough lines to keep them busy...
+  if (src.mode == _PAPPL_ISRC_MEMORY && (yend - ystart) >= 2 * _PAPPL_BAND_LINES)
+    num_threads = papplSystemGetMaxImageThreads(job->system);
+  else
+    num_threads = 1;
+
   // Start the job...
   if (!(driver_data.rstartjob_cb)(job, options, device))
   {
@@ -339,6 +786,12 @@ papplJobFilterImage(
 
   started = true;
 
+  if (options->header.cupsBitsPerPixel == 1 && (render.dplane = _papplPrinterGetDitherPlane(job->printer, options->dither, options->header.cupsWidth)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for dither thresholds.");
+    goto abort_job;
+  }
+
   if (options->header.cupsColorSpace == CUPS_CSPACE_K || options->header.cupsColorSpace == CUPS_CSPACE_CMYK)
     white = 0x00;
   else
@@ -347,12 +800,16 @@ papplJobFilterImage(
   // Print every copy...
   for (i = 0; i < options->copies; i ++)
   {
+    trace_start = _PAPPL_TRACE_BEGIN(job);
+
     if (!(driver_data.rstartpage_cb)(job, options, device, 1))
     {
       papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster page.");
       goto abort_job;
     }
 
+    _PAPPL_TRACE_END(job, _PAPPL_JTRACE_STARTPAGE, trace_start);
+
     // Leading blank space...
     memset(line, white, options->header.cupsBytesPerLine);
     for (y = 0; y < ystart; y ++)
@@ -365,104 +822,27 @@ papplJobFilterImage(
     }
 
     // Now RIP the image...
-    for (; y < yend && !job->is_canceled; y ++)
+    if (num_threads > 1)
     {
-      pixptr = pixbase + ydir * (int)((y - ystart) * (img_height - 1) / (ysize - 1));
-
-      if (xstart < 0)
-      {
-	pixptr -= (xstart * xmod / xsize) * xdir;
-	x    = 0;
-	xerr = -xmod / 2 - (xstart * xmod) % xsize;
-      }
-      else
-      {
-	x    = xstart;
-	xerr = -xmod / 2;
-      }
-
-      if (options->header.cupsBitsPerPixel == 1)
-      {
-        // Need to dither the image to 1-bit black...
-	dither = options->dither[y & 15];
-
-	for (lineptr = line + x / 8, bit = 128 >> (x & 7), byte = 0; x < xend; x ++)
-	{
-	  // Dither the current pixel...
-	  if (*pixptr <= dither[x & 15])
-	    byte |= bit;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-
-	  // and the next bit
-	  if (bit == 1)
-	  {
-	    // Current byte is "full", save it...
-	    *lineptr++ = byte;
-	    byte = 0;
-	    bit  = 128;
-	  }
-	  else
-	    bit /= 2;
-	}
-
-	if (bit < 128)
-	  *lineptr = byte;
-      }
-      else if (options->header.cupsColorSpace == CUPS_CSPACE_K)
+      if ((y = filter_bands(job, device, &driver_data, &render, y, yend, num_threads)) < 0)
+        goto abort_job;
+    }
+    else
+    {
+      for (; y < yend && !job->is_canceled; y ++)
       {
-        // Need to invert the image...
-	for (lineptr = line + x; x < xend; x ++)
-	{
-	  // Copy an inverted grayscale pixel...
-	  *lineptr++ = ~*pixptr;
+	if (!render_line(&render, &lerp, row, y, line))
+	  goto abort_job;
 
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-	}
-      }
-      else
-      {
-        // Need to copy the image...
-        int bpp = (int)options->header.cupsBitsPerPixel / 8;
+	trace_start = _PAPPL_TRACE_BEGIN(job);
 
-	for (lineptr = line + x * bpp; x < xend; x ++)
+	if (!(driver_data.rwriteline_cb)(job, options, device, (unsigned)y, line))
 	{
-	  // Copy a grayscale or RGB pixel...
-	  memcpy(lineptr, pixptr, (unsigned)bpp);
-	  lineptr += bpp;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
+	  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+	  goto abort_job;
 	}
-      }
 
-      if (!(driver_data.rwriteline_cb)(job, options, device, (unsigned)y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
+	_PAPPL_TRACE_END(job, _PAPPL_JTRACE_WRITELINE, trace_start);
       }
     }
 
@@ -478,12 +858,16 @@ papplJobFilterImage(
     }
 
     // End the page...
+    trace_start = _PAPPL_TRACE_BEGIN(job);
+
     if (!(driver_data.rendpage_cb)(job, options, device, 1))
     {
       papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster page.");
       goto abort_job;
     }
 
+    _PAPPL_TRACE_END(job, _PAPPL_JTRACE_ENDPAGE, trace_start);
+
     papplJobSetImpressionsCompleted(job, 1);
   }
 
@@ -496,6 +880,10 @@ papplJobFilterImage(
 
   // Free memory and return...
   free(line);
+  free(row);
+  isrc_free(&src);
+  lerp_free(&lerp);
+  _papplDitherPlaneRelease(render.dplane);
 
   return (true);
 
@@ -506,59 +894,73 @@ papplJobFilterImage(
     (driver_data.rendjob_cb)(job, options, device);
 
   free(line);
+  free(row);
+  isrc_free(&src);
+  lerp_free(&lerp);
+  _papplDitherPlaneRelease(render.dplane);
 
   return (false);
 }
 
 
+#ifdef HAVE_LIBJPEG
 //
-// '_papplJobFilterJPEG()' - Filter a JPEG image file.
+// 'filter_jpeg()' - Filter a JPEG image from memory or a HTTP connection.
 //
 
-#ifdef HAVE_LIBJPEG
-bool
-_papplJobFilterJPEG(
-    pappl_job_t    *job,		// I - Job
-    pappl_device_t *device,		// I - Device
-    void           *data)		// I - Filter data (unused)
+static bool				// O - `true` on success and `false` otherwise
+filter_jpeg(pappl_job_t         *job,	// I - Job
+            pappl_device_t      *device,// I - Device
+            const unsigned char *data,	// I - JPEG data or `NULL`
+            size_t              length,	// I - Length of JPEG data
+            http_t              *http)	// I - HTTP connection or `NULL`
 {
-  const char		*filename;	// JPEG filename
-  FILE			*fp;		// JPEG file
   pappl_pr_options_t	*options = NULL;// Job options
   struct jpeg_decompress_struct	dinfo;	// Decompressor info
-  int			ppi;		// Pixels per inch
+  _pappl_jpeg_src_t	src;		// HTTP source manager
+  int			ppi,		// Pixels per inch
+			denom;		// DCT scaling denominator
+  double		scale;		// Output pixels per image pixel
   _pappl_jpeg_err_t	jerr;		// Error handler info
-  unsigned char		*pixels = NULL;	// Image pixels
-  JSAMPROW		row;		// Sample row pointer
   bool			ret = false;	// Return value
 
 
-  (void)data;
-
-  // Open the JPEG file...
-  filename = papplJobGetFilename(job);
-  if ((fp = fopen(filename, "rb")) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open JPEG file '%s': %s", filename, strerror(errno));
-    return (false);
-  }
-
   // Read the image header...
   jpeg_std_error(&jerr.jerr);
   jerr.jerr.error_exit = jpeg_error_handler;
+  jerr.message[0]      = '\0';
 
   if (setjmp(jerr.retbuf))
   {
     // JPEG library errors are directed to this point...
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open JPEG file '%s': %s", filename, jerr.message);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read JPEG image: %s", jerr.message);
     ret = false;
     goto finish_jpeg;
   }
 
   dinfo.err = (struct jpeg_error_mgr *)&jerr;
   jpeg_create_decompress(&dinfo);
-  jpeg_stdio_src(&dinfo, fp);
+
+  if (data)
+  {
+    // Decode straight from the mapped file...
+    jpeg_mem_src(&dinfo, (unsigned char *)data, (unsigned long)length);
+  }
+  else
+  {
+    memset(&src, 0, sizeof(src));
+
+    src.pub.init_source       = jpeg_init_http;
+    src.pub.fill_input_buffer = jpeg_fill_http;
+    src.pub.skip_input_data   = jpeg_skip_http;
+    src.pub.resync_to_restart = jpeg_resync_to_restart;
+    src.pub.term_source       = jpeg_init_http;
+    src.http                  = http;
+
+    dinfo.src = &src.pub;
+  }
+
   jpeg_read_header(&dinfo, TRUE);
 
   // Get job options and request the image data in the format we need...
@@ -579,25 +981,6 @@ _papplJobFilterJPEG(
     dinfo.output_components    = 3;
   }
 
-  jpeg_calc_output_dimensions(&dinfo);
-
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Loading %dx%dx%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
-
-  if ((pixels = (unsigned char *)malloc((size_t)(dinfo.output_width * dinfo.output_height * (unsigned)dinfo.output_components))) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
-    papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
-    goto finish_jpeg;
-  }
-
-  jpeg_start_decompress(&dinfo);
-
-  while (dinfo.output_scanline < dinfo.output_height)
-  {
-    row = (JSAMPROW)(pixels + (size_t)dinfo.output_scanline * (size_t)dinfo.output_width * (size_t)dinfo.output_components);
-    jpeg_read_scanlines(&dinfo, &row, 1);
-  }
-
   if (dinfo.X_density != dinfo.Y_density)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unsupported non-square JPEG resolution %ux%u%s, using default.", dinfo.X_density, dinfo.Y_density, dinfo.density_unit == 1 ? "dpi" : dinfo.density_unit == 2 ? "dpcm" : "???");
@@ -620,119 +1003,1362 @@ _papplJobFilterJPEG(
     }
   }
 
-  ret = papplJobFilterImage(job, device, options, pixels, (int)dinfo.output_width, (int)dinfo.output_height, dinfo.output_components, ppi, true);
+  // Let the decompressor downscale the image in the DCT domain when the
+  // printer doesn't need all of the pixels, using the smallest size that is
+  // still at least as large as the printed image.  The resolution must divide
+  // evenly so that unscaled images still print at the same size...
+  scale = image_scale(options, (int)dinfo.image_width, (int)dinfo.image_height, ppi);
 
-  jpeg_finish_decompress(&dinfo);
+  for (denom = 8; denom > 1; denom /= 2)
+  {
+    if (scale * denom <= 1.0 && (ppi % denom) == 0)
+      break;
+  }
 
-  finish_jpeg:
+  dinfo.scale_num   = 1;
+  dinfo.scale_denom = (unsigned)denom;
+  ppi               /= denom;
 
-  papplJobDeletePrintOptions(options);
-  free(pixels);
-  jpeg_destroy_decompress(&dinfo);
-  fclose(fp);
+  jpeg_calc_output_dimensions(&dinfo);
+
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Loading %dx%dx%d JPEG image (1/%d scale).", dinfo.output_width, dinfo.output_height, dinfo.output_components, denom);
+
+  jpeg_start_decompress(&dinfo);
+
+  // Print the image, decoding scanlines as they are needed...
+  ret = filter_image(job, device, options, NULL, (pappl_image_row_cb_t)jpeg_read_row, &dinfo, (int)dinfo.output_width, (int)dinfo.output_height, dinfo.output_components, ppi, true);
+
+  if (!ret && jerr.message[0])
+  {
+    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read JPEG image: %s", jerr.message);
+  }
+
+  // jpeg_read_row uses its own setjmp buffer, so reset ours before finishing
+  // the decompression...
+  if (setjmp(jerr.retbuf))
+    goto finish_jpeg;
+
+  if (dinfo.output_scanline < dinfo.output_height)
+    jpeg_abort_decompress(&dinfo);	// Didn't need all of the lines
+  else
+    jpeg_finish_decompress(&dinfo);
+
+  finish_jpeg:
+
+  papplJobDeletePrintOptions(options);
+  jpeg_destroy_decompress(&dinfo);
 
   return (ret);
 }
 #endif // HAVE_LIBJPEG
 
 
+#ifdef HAVE_LIBPNG
 //
-// 'process_png()' - Process a PNG image file.
+// 'filter_png()' - Filter a PNG image from memory or a HTTP connection.
 //
 
-#ifdef HAVE_LIBPNG
-bool					// O - `true` on success and `false` otherwise
-_papplJobFilterPNG(
-    pappl_job_t    *job,		// I - Job
-    pappl_device_t *device,		// I - Device
-    void           *data)		// I - Filter data (unused)
+static bool				// O - `true` on success and `false` otherwise
+filter_png(pappl_job_t         *job,	// I - Job
+           pappl_device_t      *device,	// I - Device
+           const unsigned char *data,	// I - PNG data or `NULL`
+           size_t              length,	// I - Length of PNG data
+           http_t              *http)	// I - HTTP connection or `NULL`
 {
   pappl_pr_options_t	*options = NULL;// Job options
-  png_image		png;		// PNG image data
-  png_color		bg;		// Background color
+  png_structp		pp;		// PNG read pointer
+  png_infop		info = NULL;	// PNG info pointer
+  png_uint_32		width,		// Width in columns
+			height;		// Height in lines
+  int			bit_depth,	// Bits per component
+			color_type,	// Color type
+			interlace_type;	// Interlace type
+  png_color_16		bg;		// Background color
   int			png_bpp;	// Bytes per pixel
-  unsigned char		*pixels = NULL;	// Image pixels
+  unsigned char		*pixels;	// Image pixels for interlaced images
+  _pappl_png_mem_t	mem;		// Memory source
   bool			ret = false;	// Return value
 
 
-  // Load the PNG...
-  (void)data;
-
-  memset(&png, 0, sizeof(png));
-  png.version = PNG_IMAGE_VERSION;
-
-  bg.red = bg.green = bg.blue = 255;
-
-  png_image_begin_read_from_file(&png, job->filename);
+  // Read the PNG header...
+  if ((pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, job, png_error_handler, png_warning_handler)) == NULL || (info = png_create_info_struct(pp)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image.");
+    png_destroy_read_struct(&pp, NULL, NULL);
+    return (false);
+  }
 
-  if (png.warning_or_error & PNG_IMAGE_ERROR)
+  if (setjmp(png_jmpbuf(pp)))
   {
+    // PNG library errors are directed to this point...
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", job->filename, png.message);
-    goto finish_job;
+    ret = false;
+    goto finish_png;
+  }
+
+  if (data)
+  {
+    mem.data   = data;
+    mem.length = length;
+    mem.offset = 0;
+
+    png_set_read_fn(pp, &mem, png_read_mem);
   }
+  else
+    png_set_read_fn(pp, http, png_read_http);
+
+  png_read_info(pp, info);
+  png_get_IHDR(pp, info, &width, &height, &bit_depth, &color_type, &interlace_type, NULL, NULL);
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image is %ux%u", png.width, png.height);
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image is %ux%u", (unsigned)width, (unsigned)height);
 
   // Prepare options...
-  options = papplJobCreatePrintOptions(job, 1, (png.format & PNG_FORMAT_FLAG_COLOR) != 0);
+  options = papplJobCreatePrintOptions(job, 1, (color_type & PNG_COLOR_MASK_COLOR) != 0);
+
+  // Convert the image to 8-bit grayscale or sRGB on a white background...
+  png_set_alpha_mode_fixed(pp, PNG_ALPHA_PNG, PNG_GAMMA_sRGB);
+
+  if (color_type == PNG_COLOR_TYPE_PALETTE)
+    png_set_palette_to_rgb(pp);
+  else if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+    png_set_expand_gray_1_2_4_to_8(pp);
+
+  if (png_get_valid(pp, info, PNG_INFO_tRNS))
+    png_set_tRNS_to_alpha(pp);
+
+  if (bit_depth == 16)
+    png_set_strip_16(pp);
 
   if (options->header.cupsNumColors > 1)
   {
-    png.format = PNG_FORMAT_RGB;
-    png_bpp    = 3;
+    if (!(color_type & PNG_COLOR_MASK_COLOR))
+      png_set_gray_to_rgb(pp);
+
+    png_bpp = 3;
   }
   else
   {
-    png.format = PNG_FORMAT_GRAY;
-    png_bpp    = 1;
-  }
+    if (color_type & PNG_COLOR_MASK_COLOR)
+      png_set_rgb_to_gray_fixed(pp, 1, -1, -1);
 
-  pixels = malloc(PNG_IMAGE_SIZE(png));
-
-  png_image_finish_read(&png, &bg, pixels, 0, NULL);
+    png_bpp = 1;
+  }
 
-  if (png.warning_or_error & PNG_IMAGE_ERROR)
+  if ((color_type & PNG_COLOR_MASK_ALPHA) || png_get_valid(pp, info, PNG_INFO_tRNS))
   {
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open PNG file '%s': %s", job->filename, png.message);
-    goto finish_job;
+    memset(&bg, 0, sizeof(bg));
+    bg.red = bg.green = bg.blue = bg.gray = 255;
+
+    png_set_background_fixed(pp, &bg, PNG_BACKGROUND_GAMMA_SCREEN, 0, PNG_FP_1);
   }
 
   // TODO: Get PNG image resolution information (Issue #65)
 
-  // Print the image...
-  ret = papplJobFilterImage(job, device, options, pixels, (int)png.width, (int)png.height, png_bpp, 0, false);
+  if (interlace_type != PNG_INTERLACE_NONE)
+  {
+    // Interlaced images have to be decoded into memory...
+    png_set_interlace_handling(pp);
+    png_read_update_info(pp, info);
+
+    if ((pixels = png_read_interlaced(pp, width, height, png_bpp)) != NULL)
+    {
+      ret = filter_image(job, device, options, pixels, NULL, NULL, (int)width, (int)height, png_bpp, 0, false);
+      free(pixels);
+    }
+    else
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to load interlaced PNG image.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    }
+  }
+  else
+  {
+    // Otherwise decode the rows as they are needed...
+    png_read_update_info(pp, info);
+
+    ret = filter_image(job, device, options, NULL, (pappl_image_row_cb_t)png_read_image_row, pp, (int)width, (int)height, png_bpp, 0, false);
+  }
 
-  finish_job:
+  finish_png:
 
   papplJobDeletePrintOptions(options);
-
-  // Free the image data when we're done...
-  png_image_free(&png);
-  free(pixels);
+  png_destroy_read_struct(&pp, &info, NULL);
 
   return (ret);
 }
 #endif // HAVE_LIBPNG
 
+//
+// 'image_scale()' - Compute the number of output pixels per image pixel.
+//
+// This follows the scaling and orientation rules of `filter_image` without
+// changing the print options, so that decoders can skip image data the printer
+// won't use.
+//
+
+static double				// O - Output pixels per image pixel
+image_scale(
+    pappl_pr_options_t *options,	// I - Print options
+    int                width,		// I - Width in columns
+    int                height,		// I - Height in lines
+    int                ppi)		// I - Pixels per inch (`0` for unknown)
+{
+  int		iwidth,			// Imageable width
+		iheight,		// Imageable length/height
+		xres = options->printer_resolution[0],
+					// Horizontal resolution
+		yres = options->printer_resolution[1],
+					// Vertical resolution
+		temp;			// Swap variable
+  ipp_orient_t	orient = options->orientation_requested;
+					// Orientation
+  pappl_scaling_t scaling = options->print_scaling;
+					// Scaling mode
+  double	xscale,			// Horizontal scaling
+		yscale;			// Vertical scaling
+
+
+  if (width <= 0 || height <= 0)
+    return (1.0);
+
+  if (scaling == PAPPL_SCALING_FILL)
+  {
+    iwidth  = (int)options->header.cupsWidth;
+    iheight = (int)options->header.cupsHeight;
+  }
+  else
+  {
+    iwidth  = (int)options->header.cupsWidth - (options->media.left_margin + options->media.right_margin) * xres / 2540;
+    iheight = (int)options->header.cupsHeight - (options->media.bottom_margin + options->media.top_margin) * yres / 2540;
+  }
+
+  if (orient == IPP_ORIENT_NONE)
+    orient = width > height && options->header.cupsWidth < options->header.cupsHeight ? IPP_ORIENT_LANDSCAPE : IPP_ORIENT_PORTRAIT;
+
+  if (orient == IPP_ORIENT_LANDSCAPE || orient == IPP_ORIENT_REVERSE_LANDSCAPE)
+  {
+    // Rotated, swap the image dimensions...
+    temp   = width;
+    width  = height;
+    height = temp;
+  }
+
+  if (scaling == PAPPL_SCALING_AUTO || scaling == PAPPL_SCALING_AUTO_FIT)
+  {
+    if (ppi > 0 && width * xres / ppi <= iwidth && height * yres / ppi <= iheight)
+      scaling = PAPPL_SCALING_NONE;
+    else if (scaling == PAPPL_SCALING_AUTO && options->media.bottom_margin == 0 && options->media.left_margin == 0 && options->media.right_margin == 0 && options->media.top_margin == 0)
+      scaling = PAPPL_SCALING_FILL;
+    else
+      scaling = PAPPL_SCALING_FIT;
+  }
+  else if (scaling == PAPPL_SCALING_NONE && ppi <= 0)
+  {
+    ppi = 200;
+  }
+
+  if (scaling == PAPPL_SCALING_NONE)
+    return ((double)(xres > yres ? xres : yres) / ppi);
+
+  xscale = (double)iwidth / width;
+  yscale = (double)iheight / height;
+
+  if (scaling == PAPPL_SCALING_FILL)
+    return (xscale > yscale ? xscale : yscale);
+  else
+    return (xscale < yscale ? xscale : yscale);
+}
+
 
-#ifdef HAVE_LIBJPEG
 //
-// 'jpeg_error_handler()' - Handle JPEG errors by not exiting.
+// 'isrc_free()' - Free the memory and scratch file used by an image source.
 //
 
 static void
-jpeg_error_handler(j_common_ptr p)	// I - JPEG data
+isrc_free(_pappl_isrc_t *src)		// I - Image source
 {
-  _pappl_jpeg_err_t	*jerr = (_pappl_jpeg_err_t *)p->err;
-					// JPEG error handler
+  free(src->image);
+  free(src->buffer);
 
+  if (src->fd >= 0)
+  {
+    close(src->fd);
+    papplJobOpenFile(src->job, src->filename, sizeof(src->filename), NULL, "tmp", "x");
+  }
 
-  // Save the error message in the string buffer...
-  (jerr->jerr.format_message)(p, jerr->message);
+  memset(src, 0, sizeof(_pappl_isrc_t));
+  src->fd = -1;
+}
 
-  // Return to the point we called setjmp()...
-  longjmp(jerr->retbuf, 1);
+
+//
+// 'isrc_get_row()' - Get a line of the rotated image.
+//
+// The returned pointer points to the first pixel of line "y" in the output
+// orientation, and "xdir" is set to the offset of the next pixel in the line.
+//
+
+static const unsigned char *		// O - First pixel or `NULL` on error
+isrc_get_row(_pappl_isrc_t *src,	// I - Image source
+             int           y,		// I - Line in output orientation
+             int           *xdir)	// O - Offset to next pixel
+{
+  int		c,			// Column in source image
+		first;			// First row/column to load
+  size_t	offset;			// Offset in scratch file
+
+
+  switch (src->mode)
+  {
+    case _PAPPL_ISRC_MEMORY :
+        switch (src->orient)
+        {
+          default :
+          case IPP_ORIENT_PORTRAIT :
+              *xdir = src->depth;
+              return (src->pixels + (size_t)y * src->rowsize);
+
+          case IPP_ORIENT_REVERSE_PORTRAIT :
+              *xdir = -src->depth;
+              return (src->pixels + (size_t)(src->height - y) * src->rowsize - (size_t)src->depth);
+
+          case IPP_ORIENT_LANDSCAPE : // 90 counter-clockwise
+              *xdir = (int)src->rowsize;
+              return (src->pixels + (size_t)(src->width - 1 - y) * (size_t)src->depth);
+
+          case IPP_ORIENT_REVERSE_LANDSCAPE : // 90 clockwise
+              *xdir = -(int)src->rowsize;
+              return (src->pixels + (size_t)(src->height - 1) * src->rowsize + (size_t)y * (size_t)src->depth);
+        }
+
+    case _PAPPL_ISRC_STREAM :
+        // Read lines from the stream until we get to the one we need...
+        while (src->first < y)
+        {
+          if (!isrc_read_rows(src, src->buffer, 1))
+            return (NULL);
+
+          src->first ++;
+        }
+
+        *xdir = src->depth;
+        return (src->buffer);
+
+    case _PAPPL_ISRC_ROWS :
+        // Load the band containing the source line, reading upwards for
+        // reverse portrait...
+        if (src->orient == IPP_ORIENT_REVERSE_PORTRAIT)
+          y = src->height - 1 - y;
+
+        if (src->first < 0 || y < src->first || y >= (src->first + src->count))
+        {
+          if (src->orient == IPP_ORIENT_REVERSE_PORTRAIT)
+            first = y >= src->band ? y - src->band + 1 : 0;
+          else
+            first = y;
+
+          src->first = -1;
+          src->count = src->height - first < src->band ? src->height - first : src->band;
+
+          if (!isrc_read(src, (off_t)((size_t)first * src->rowsize), (size_t)src->count * src->rowsize))
+            return (NULL);
+
+          src->first = first;
+        }
+
+        if (src->orient == IPP_ORIENT_REVERSE_PORTRAIT)
+        {
+          *xdir = -src->depth;
+          return (src->buffer + (size_t)(y - src->first + 1) * src->rowsize - (size_t)src->depth);
+        }
+        else
+        {
+          *xdir = src->depth;
+          return (src->buffer + (size_t)(y - src->first) * src->rowsize);
+        }
+
+    case _PAPPL_ISRC_STRIPS :
+        // Load the strip of columns containing the source column.  Each strip
+        // is stored as "height" rows of "count" pixels...
+        if (src->orient == IPP_ORIENT_LANDSCAPE)
+          c = src->width - 1 - y;
+        else
+          c = y;
+
+        first = c - c % src->band;
+
+        if (first != src->first)
+        {
+          src->first = -1;
+          src->count = src->width - first < src->band ? src->width - first : src->band;
+          offset     = (size_t)first * (size_t)src->height * (size_t)src->depth;
+
+          if (!isrc_read(src, (off_t)offset, (size_t)src->count * (size_t)src->height * (size_t)src->depth))
+            return (NULL);
+
+          src->first = first;
+        }
+
+        if (src->orient == IPP_ORIENT_LANDSCAPE)
+        {
+          *xdir = src->count * src->depth;
+          return (src->buffer + (size_t)(c - first) * (size_t)src->depth);
+        }
+        else
+        {
+          *xdir = -src->count * src->depth;
+          return (src->buffer + ((size_t)(src->height - 1) * (size_t)src->count + (size_t)(c - first)) * (size_t)src->depth);
+        }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'isrc_init()' - Initialize an image source.
+//
+// Images in memory are used as-is.  Streamed portrait images with a single
+// copy are read a line at a time.  Everything else is loaded into memory when
+// it fits within the system image memory limit, and spooled to a scratch file
+// otherwise.
+//
+
+static bool				// O - `true` on success, `false` on error
+isrc_init(
+    _pappl_isrc_t        *src,		// I - Image source
+    pappl_job_t          *job,		// I - Job
+    ipp_orient_t         orient,	// I - Output orientation
+    int                  copies,	// I - Number of copies
+    const unsigned char  *pixels,	// I - Image in memory or `NULL`
+    pappl_image_row_cb_t row_cb,	// I - Row callback
+    void                 *row_data,	// I - Row callback data
+    int                  width,		// I - Width in columns
+    int                  height,	// I - Height in lines
+    int                  depth)		// I - Bytes per pixel
+{
+  size_t	max_memory;		// Maximum image memory
+
+
+  memset(src, 0, sizeof(_pappl_isrc_t));
+
+  src->job      = job;
+  src->orient   = orient;
+  src->row_cb   = row_cb;
+  src->row_data = row_data;
+  src->width    = width;
+  src->height   = height;
+  src->depth    = depth;
+  src->rowsize  = (size_t)width * (size_t)depth;
+  src->pixels   = pixels;
+  src->fd       = -1;
+  src->first    = -1;
+
+  if (pixels)
+  {
+    src->mode = _PAPPL_ISRC_MEMORY;
+    return (true);
+  }
+
+  if (orient == IPP_ORIENT_PORTRAIT && copies <= 1)
+  {
+    src->mode = _PAPPL_ISRC_STREAM;
+
+    if ((src->buffer = malloc(src->rowsize)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster line.");
+      return (false);
+    }
+
+    return (true);
+  }
+
+  max_memory = papplSystemGetMaxImageMemory(job->system);
+
+  if (max_memory == 0 || src->rowsize * (size_t)height <= max_memory)
+  {
+    // Rotated images and multiple copies need random access to the image
+    // data, so read the whole stream into memory...
+    src->mode = _PAPPL_ISRC_MEMORY;
+
+    if ((src->image = malloc(src->rowsize * (size_t)height)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d image.", width, height, depth);
+      return (false);
+    }
+
+    if (!isrc_read_rows(src, src->image, height))
+    {
+      isrc_free(src);
+      return (false);
+    }
+
+    src->pixels = src->image;
+
+    return (true);
+  }
+
+  // Otherwise spool the image to a scratch file...
+  if (!isrc_spool(src, max_memory))
+  {
+    isrc_free(src);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'isrc_read()' - Read bytes from the scratch file into the buffer.
+//
+
+static bool				// O - `true` on success, `false` on error
+isrc_read(_pappl_isrc_t *src,		// I - Image source
+          off_t         offset,		// I - Offset in scratch file
+          size_t        bytes)		// I - Number of bytes to read
+{
+  unsigned char	*ptr;			// Pointer into buffer
+  ssize_t	rbytes;			// Bytes read
+
+
+  if (lseek(src->fd, offset, SEEK_SET) < 0)
+  {
+    papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to seek in image scratch file '%s': %s", src->filename, strerror(errno));
+    return (false);
+  }
+
+  for (ptr = src->buffer; bytes > 0; bytes -= (size_t)rbytes, ptr += rbytes)
+  {
+    if ((rbytes = read(src->fd, ptr, bytes)) <= 0)
+    {
+      if (rbytes < 0 && (errno == EINTR || errno == EAGAIN))
+      {
+        rbytes = 0;
+        continue;
+      }
+
+      papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to read image scratch file '%s': %s", src->filename, rbytes < 0 ? strerror(errno) : "Unexpected end of file");
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'isrc_read_rows()' - Read lines from the row callback.
+//
+
+static bool				// O - `true` on success, `false` on error
+isrc_read_rows(_pappl_isrc_t *src,	// I - Image source
+               unsigned char *rows,	// I - Buffer for lines
+               int           count)	// I - Number of lines
+{
+  for (; count > 0; count --, rows += src->rowsize)
+  {
+    if (!(src->row_cb)(src->row_data, rows))
+    {
+      papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to read image data.");
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'isrc_spool()' - Spool an image to a scratch file.
+//
+// Images printed upright or upside down are stored a line at a time and read
+// back in bands of lines.  Rotated images are stored as vertical strips of
+// columns so that each output line can be read back with a single read, with
+// the strip width chosen so that the band of source lines and the tile copied
+// out of it fit within "max_memory" bytes.
+//
+
+static bool				// O - `true` on success, `false` on error
+isrc_spool(_pappl_isrc_t *src,		// I - Image source
+           size_t        max_memory)	// I - Maximum image memory
+{
+  int		y,			// Current line
+		count,			// Number of lines in band
+		first,			// First column in strip
+		cols,			// Number of columns in strip
+		row;			// Row in tile
+  size_t	bandsize,		// Size of band buffer
+		tilesize;		// Size of one strip of a band
+  unsigned char	*band = NULL,		// Band of source lines
+		*tile = NULL,		// Tile copied from band
+		*ptr;			// Pointer into data to write
+  const unsigned char *outptr;		// Pointer to data to write
+  ssize_t	bytes,			// Bytes written
+		remaining;		// Bytes remaining
+  bool		ret = false;		// Return value
+
+
+  if ((src->fd = papplJobOpenFile(src->job, src->filename, sizeof(src->filename), NULL, "tmp", "w")) < 0)
+  {
+    papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to create image scratch file '%s': %s", src->filename, strerror(errno));
+    return (false);
+  }
+
+  if (src->orient == IPP_ORIENT_PORTRAIT || src->orient == IPP_ORIENT_REVERSE_PORTRAIT)
+  {
+    src->mode = _PAPPL_ISRC_ROWS;
+    src->band = (int)(max_memory / src->rowsize);
+    bandsize  = src->rowsize;
+  }
+  else
+  {
+    src->mode = _PAPPL_ISRC_STRIPS;
+    src->band = (int)(max_memory / (2 * (size_t)(src->width > src->height ? src->width : src->height) * (size_t)src->depth));
+    bandsize  = src->rowsize;
+
+    if (src->band > src->width)
+      src->band = src->width;
+  }
+
+  if (src->band < 1)
+    src->band = 1;
+  else if (src->band > src->height && src->mode == _PAPPL_ISRC_ROWS)
+    src->band = src->height;
+
+  bandsize *= (size_t)src->band;
+  tilesize  = (size_t)src->band * (size_t)src->band * (size_t)src->depth;
+
+  papplLogJob(src->job, PAPPL_LOGLEVEL_DEBUG, "Spooling %dx%dx%d image to '%s' in %s of %d.", src->width, src->height, src->depth, src->filename, src->mode == _PAPPL_ISRC_ROWS ? "bands" : "strips", src->band);
+
+  if ((band = malloc(bandsize)) == NULL || (src->mode == _PAPPL_ISRC_STRIPS && (tile = malloc(tilesize)) == NULL))
+  {
+    papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d image band.", src->width, src->band, src->depth);
+    goto done;
+  }
+
+  for (y = 0; y < src->height; y += count)
+  {
+    if ((count = src->height - y) > src->band)
+      count = src->band;
+
+    if (!isrc_read_rows(src, band, count))
+      goto done;
+
+    for (first = 0; first < src->width; first += cols)
+    {
+      if (src->mode == _PAPPL_ISRC_ROWS)
+      {
+        // Write the lines as-is...
+        cols      = src->width;
+        outptr    = band;
+        remaining = (ssize_t)((size_t)count * src->rowsize);
+      }
+      else
+      {
+        // Copy the tile for this strip and write it after the lines above it...
+        if ((cols = src->width - first) > src->band)
+          cols = src->band;
+
+        for (row = 0, ptr = tile; row < count; row ++, ptr += (size_t)cols * (size_t)src->depth)
+          memcpy(ptr, band + (size_t)row * src->rowsize + (size_t)first * (size_t)src->depth, (size_t)cols * (size_t)src->depth);
+
+        if (lseek(src->fd, (off_t)(((size_t)first * (size_t)src->height + (size_t)y * (size_t)cols) * (size_t)src->depth), SEEK_SET) < 0)
+        {
+	  papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to seek in image scratch file '%s': %s", src->filename, strerror(errno));
+	  goto done;
+        }
+
+        outptr    = tile;
+        remaining = (ssize_t)((size_t)count * (size_t)cols * (size_t)src->depth);
+      }
+
+      for (; remaining > 0; remaining -= bytes, outptr += bytes)
+      {
+        if ((bytes = write(src->fd, outptr, (size_t)remaining)) < 0)
+        {
+          if (errno == EINTR || errno == EAGAIN)
+          {
+            bytes = 0;
+            continue;
+          }
+
+	  papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to write image scratch file '%s': %s", src->filename, strerror(errno));
+	  goto done;
+        }
+      }
+    }
+  }
+
+  // Reopen the scratch file for reading...
+  close(src->fd);
+
+  if ((src->fd = papplJobOpenFile(src->job, src->filename, sizeof(src->filename), NULL, "tmp", "r")) < 0)
+  {
+    papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to open image scratch file '%s': %s", src->filename, strerror(errno));
+    papplJobOpenFile(src->job, src->filename, sizeof(src->filename), NULL, "tmp", "x");
+    goto done;
+  }
+
+  // Reuse the band buffer for reading...
+  if (src->mode == _PAPPL_ISRC_STRIPS && bandsize < (size_t)src->band * (size_t)src->height * (size_t)src->depth)
+  {
+    free(band);
+    band = NULL;
+
+    if ((src->buffer = malloc((size_t)src->band * (size_t)src->height * (size_t)src->depth)) == NULL)
+    {
+      papplLogJob(src->job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %dx%dx%d image strip.", src->band, src->height, src->depth);
+      goto done;
+    }
+  }
+  else
+  {
+    src->buffer = band;
+    band        = NULL;
+  }
+
+  ret = true;
+
+  done:
+
+  free(band);
+  free(tile);
+
+  return (ret);
+}
+
+
+
+#ifdef HAVE_LIBJPEG
+//
+// 'jpeg_error_handler()' - Handle JPEG errors by not exiting.
+//
+
+static void
+jpeg_error_handler(j_common_ptr p)	// I - JPEG data
+{
+  _pappl_jpeg_err_t	*jerr = (_pappl_jpeg_err_t *)p->err;
+					// JPEG error handler
+
+
+  // Save the error message in the string buffer...
+  (jerr->jerr.format_message)(p, jerr->message);
+
+  // Return to the point we called setjmp()...
+  longjmp(jerr->retbuf, 1);
+}
+
+
+//
+// 'jpeg_fill_http()' - Read more JPEG data from the HTTP connection.
+//
+
+static boolean				// O - `TRUE` always
+jpeg_fill_http(j_decompress_ptr dinfo)	// I - Decompressor info
+{
+  _pappl_jpeg_src_t	*src = (_pappl_jpeg_src_t *)dinfo->src;
+					// HTTP source manager
+  ssize_t		bytes;		// Bytes read
+
+
+  if ((bytes = httpRead2(src->http, (char *)src->buffer, sizeof(src->buffer))) <= 0)
+  {
+    // Insert a fake EOI marker at the end of the data, like the stdio source
+    // manager does...
+    src->buffer[0] = (JOCTET)0xFF;
+    src->buffer[1] = (JOCTET)JPEG_EOI;
+    bytes          = 2;
+  }
+
+  src->pub.next_input_byte = src->buffer;
+  src->pub.bytes_in_buffer = (size_t)bytes;
+
+  return (TRUE);
+}
+
+
+//
+// 'jpeg_init_http()' - Initialize or terminate the HTTP source manager.
+//
+
+static void
+jpeg_init_http(j_decompress_ptr dinfo)	// I - Decompressor info
+{
+  (void)dinfo;
+}
+
+
+//
+// 'jpeg_read_row()' - Read the next line from a JPEG image.
+//
+
+static bool				// O - `true` on success, `false` on error
+jpeg_read_row(j_decompress_ptr dinfo,	// I - Decompressor info
+              unsigned char    *row)	// I - Row buffer
+{
+  _pappl_jpeg_err_t	*jerr = (_pappl_jpeg_err_t *)dinfo->err;
+					// JPEG error handler
+  JSAMPROW		samples = (JSAMPROW)row;
+					// Sample row pointer
+
+
+  if (setjmp(jerr->retbuf))
+    return (false);
+
+  return (jpeg_read_scanlines(dinfo, &samples, 1) == 1);
+}
+
+
+//
+// 'jpeg_skip_http()' - Skip JPEG data from the HTTP connection.
+//
+
+static void
+jpeg_skip_http(j_decompress_ptr dinfo,	// I - Decompressor info
+               long             num_bytes)
+					// I - Number of bytes to skip
+{
+  _pappl_jpeg_src_t	*src = (_pappl_jpeg_src_t *)dinfo->src;
+					// HTTP source manager
+
+
+  if (num_bytes <= 0)
+    return;
+
+  while (num_bytes > (long)src->pub.bytes_in_buffer)
+  {
+    num_bytes -= (long)src->pub.bytes_in_buffer;
+    jpeg_fill_http(dinfo);
+  }
+
+  src->pub.next_input_byte += num_bytes;
+  src->pub.bytes_in_buffer -= (size_t)num_bytes;
+}
+#endif // HAVE_LIBJPEG
+
+//
+// 'lerp_free()' - Free the memory used for interpolation.
+//
+
+static void
+lerp_free(_pappl_lerp_t *lerp)		// I - Interpolation state
+{
+  free(lerp->xoff);
+  free(lerp->xfrac);
+  free(lerp->rows[0]);
+  free(lerp->rows[1]);
+  free(lerp->line);
+
+  memset(lerp, 0, sizeof(_pappl_lerp_t));
+}
+
+
+//
+// 'lerp_init()' - Initialize bilinear interpolation for an image.
+//
+// The source column and weight for every output column are computed once so
+// that each line only needs integer multiplies and adds.  Weights are 8-bit
+// fixed-point values.
+//
+
+static bool				// O - `true` on success, `false` on error
+lerp_init(_pappl_lerp_t *lerp,		// I - Interpolation state
+          int           width,		// I - Width of rotated image
+          int           depth,		// I - Bytes per pixel
+          int           xstart,		// I - X start position
+          int           xend,		// I - X end position
+          int           xsize)		// I - Scaled width
+{
+  int		i,			// Looping var
+		x,			// First output column
+		sx;			// Source column (24.8 fixed-point)
+
+
+  memset(lerp, 0, sizeof(_pappl_lerp_t));
+
+  x = xstart < 0 ? 0 : xstart;
+
+  lerp->width    = width;
+  lerp->depth    = depth;
+  lerp->count    = xend > x ? xend - x : 0;
+  lerp->lines[0] = -1;
+  lerp->lines[1] = -1;
+
+  if ((lerp->xoff = calloc((size_t)lerp->count + 1, sizeof(int))) == NULL || (lerp->xfrac = calloc((size_t)lerp->count + 1, 1)) == NULL || (lerp->rows[0] = malloc((size_t)width * (size_t)depth)) == NULL || (lerp->rows[1] = malloc((size_t)width * (size_t)depth)) == NULL || (lerp->line = malloc((size_t)(lerp->count + 1) * (size_t)depth)) == NULL)
+  {
+    lerp_free(lerp);
+    return (false);
+  }
+
+  for (i = 0; i < lerp->count; i ++, x ++)
+  {
+    sx = (int)((long long)(x - xstart) * (width - 1) * 256 / (xsize - 1));
+
+    if ((sx >> 8) >= (width - 1))
+    {
+      lerp->xoff[i]  = (width - 1) * depth;
+      lerp->xfrac[i] = 0;
+    }
+    else
+    {
+      lerp->xoff[i]  = (sx >> 8) * depth;
+      lerp->xfrac[i] = (unsigned char)(sx & 255);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'lerp_line()' - Interpolate an output line.
+//
+// The two source lines around the output line are copied from the image
+// source in output orientation, reusing the previous lines whenever possible
+// so that each source line is only read once for streamed images.
+//
+
+static const unsigned char *		// O - Interpolated pixels or `NULL` on error
+lerp_line(_pappl_lerp_t *lerp,		// I - Interpolation state
+          _pappl_isrc_t *src,		// I - Image source
+          int           height,		// I - Height of rotated image
+          int           y,		// I - Output line relative to the top of the image
+          int           ysize)		// I - Scaled height
+{
+  int			i,		// Looping var
+			c,		// Color component
+			sy,		// Source line (24.8 fixed-point)
+			lines[2],	// Source lines needed
+			xdir;		// Offset to next pixel in source
+  unsigned		fy,		// Weight of bottom line
+			fx,		// Weight of right column
+			next,		// Offset to right column
+			top,		// Top value
+			bottom;		// Bottom value
+  const unsigned char	*pixptr,	// Pointer into source
+			*p0,		// Pointer into top line
+			*p1;		// Pointer into bottom line
+  unsigned char		*lineptr,	// Pointer into interpolated line
+			*temp;		// Temporary line pointer
+
+
+  // Figure out which lines we need...
+  sy = (int)((long long)y * (height - 1) * 256 / (ysize - 1));
+
+  if ((sy >> 8) >= (height - 1))
+  {
+    lines[0] = height - 1;
+    fy       = 0;
+  }
+  else
+  {
+    lines[0] = sy >> 8;
+    fy       = (unsigned)(sy & 255);
+  }
+
+  lines[1] = fy ? lines[0] + 1 : -1;
+
+  if (lerp->lines[0] != lines[0] && lerp->lines[1] == lines[0])
+  {
+    // Move the bottom line to the top...
+    temp           = lerp->rows[0];
+    lerp->rows[0]  = lerp->rows[1];
+    lerp->rows[1]  = temp;
+    lerp->lines[0] = lerp->lines[1];
+    lerp->lines[1] = -1;
+  }
+
+  for (i = 0; i < 2; i ++)
+  {
+    if (lines[i] < 0 || lerp->lines[i] == lines[i])
+      continue;
+
+    lerp->lines[i] = -1;
+
+    if ((pixptr = isrc_get_row(src, lines[i], &xdir)) == NULL)
+      return (NULL);
+
+    if (xdir == lerp->depth)
+    {
+      memcpy(lerp->rows[i], pixptr, (size_t)lerp->width * (size_t)lerp->depth);
+    }
+    else
+    {
+      for (c = 0, lineptr = lerp->rows[i]; c < lerp->width; c ++, pixptr += xdir, lineptr += lerp->depth)
+        memcpy(lineptr, pixptr, (size_t)lerp->depth);
+    }
+
+    lerp->lines[i] = lines[i];
+  }
+
+  // Interpolate the output pixels...
+  for (i = 0, lineptr = lerp->line; i < lerp->count; i ++)
+  {
+    p0   = lerp->rows[0] + lerp->xoff[i];
+    p1   = lerp->rows[1] + lerp->xoff[i];
+    fx   = lerp->xfrac[i];
+    next = fx ? (unsigned)lerp->depth : 0;
+
+    for (c = lerp->depth; c > 0; c --, p0 ++, p1 ++)
+    {
+      top = p0[0] * (256 - fx) + p0[next] * fx;
+
+      if (fy)
+      {
+        bottom     = p1[0] * (256 - fx) + p1[next] * fx;
+        *lineptr++ = (unsigned char)((top * (256 - fy) + bottom * fy + 32768) >> 16);
+      }
+      else
+      {
+        *lineptr++ = (unsigned char)((top + 128) >> 8);
+      }
+    }
+  }
+
+  return (lerp->line);
+}
+
+
+
+#ifdef HAVE_LIBPNG
+//
+// 'png_error_handler()' - Log PNG errors and return to the filter.
+//
+
+static void
+png_error_handler(
+    png_structp     pp,			// I - PNG read pointer
+    png_const_charp message)		// I - Error message
+{
+  papplLogJob((pappl_job_t *)png_get_error_ptr(pp), PAPPL_LOGLEVEL_ERROR, "Unable to read PNG image: %s", message);
+
+  png_longjmp(pp, 1);
+}
+
+
+//
+// 'png_read_http()' - Read PNG data from the HTTP connection.
+//
+
+static void
+png_read_http(png_structp pp,		// I - PNG read pointer
+              png_bytep   buffer,	// I - Read buffer
+              png_size_t  bytes)	// I - Number of bytes to read
+{
+  http_t	*http = (http_t *)png_get_io_ptr(pp);
+					// HTTP connection
+  ssize_t	rbytes;			// Bytes read
+
+
+  while (bytes > 0)
+  {
+    if ((rbytes = httpRead2(http, (char *)buffer, bytes)) <= 0)
+      png_error(pp, "Unexpected end of PNG data.");
+
+    buffer += rbytes;
+    bytes  -= (png_size_t)rbytes;
+  }
+}
+
+
+//
+// 'png_read_image_row()' - Read the next line from a PNG image.
+//
+
+static bool				// O - `true` on success, `false` on error
+png_read_image_row(png_structp   pp,	// I - PNG read pointer
+                   unsigned char *row)	// I - Row buffer
+{
+  if (setjmp(png_jmpbuf(pp)))
+    return (false);
+
+  png_read_row(pp, row, NULL);
+
+  return (true);
+}
+
+
+//
+// 'png_read_interlaced()' - Read an interlaced PNG image into memory.
+//
+
+static unsigned char *			// O - Image pixels or `NULL` on error
+png_read_interlaced(png_structp pp,	// I - PNG read pointer
+                    png_uint_32 width,	// I - Width in columns
+                    png_uint_32 height,	// I - Height in lines
+                    int         bpp)	// I - Bytes per pixel
+{
+  unsigned char	*pixels;		// Image pixels
+  png_bytep	*rows;			// Row pointers
+  png_uint_32	y;			// Current line
+
+
+  if ((pixels = malloc((size_t)width * (size_t)height * (size_t)bpp)) == NULL)
+    return (NULL);
+
+  if ((rows = calloc(height, sizeof(png_bytep))) == NULL)
+  {
+    free(pixels);
+    return (NULL);
+  }
+
+  for (y = 0; y < height; y ++)
+    rows[y] = pixels + (size_t)y * (size_t)width * (size_t)bpp;
+
+  if (setjmp(png_jmpbuf(pp)))
+  {
+    free(rows);
+    free(pixels);
+    return (NULL);
+  }
+
+  png_read_image(pp, rows);
+
+  free(rows);
+
+  return (pixels);
+}
+
+
+//
+// 'png_read_mem()' - Read PNG data from memory.
+//
+
+static void
+png_read_mem(png_structp pp,		// I - PNG read pointer
+             png_bytep   buffer,	// I - Read buffer
+             png_size_t  bytes)		// I - Number of bytes to read
+{
+  _pappl_png_mem_t *mem = (_pappl_png_mem_t *)png_get_io_ptr(pp);
+					// Memory source
+
+
+  if (bytes > (mem->length - mem->offset))
+    png_error(pp, "Unexpected end of PNG data.");
+
+  memcpy(buffer, mem->data + mem->offset, bytes);
+  mem->offset += bytes;
+}
+
+
+//
+// 'png_warning_handler()' - Log PNG warnings.
+//
+
+static void
+png_warning_handler(
+    png_structp     pp,			// I - PNG read pointer
+    png_const_charp message)		// I - Warning message
+{
+  papplLogJob((pappl_job_t *)png_get_error_ptr(pp), PAPPL_LOGLEVEL_WARN, "PNG image: %s", message);
+}
+#endif // HAVE_LIBPNG
+
+
+//
+// 'render_line()' - Render an image line for the printer.
+//
+// The image columns of "line" are replaced by the scaled pixels for output
+// line "y", which are dithered for 1-bit output.  The "row" buffer is only used
+// for 1-bit output.
+//
+
+static bool				// O - `true` on success, `false` on error
+render_line(_pappl_irender_t *render,	// I - Line renderer
+            _pappl_lerp_t    *lerp,	// I - Interpolation state
+            unsigned char    *row,	// I - Sampled pixels for dithering
+            int              y,		// I - Output line
+            unsigned char    *line)	// I - Output line buffer
+{
+  pappl_pr_options_t	*options = render->options;
+					// Print options
+  const unsigned char	*pixptr;	// Pointer into image
+  unsigned char		*lineptr,	// Pointer in line
+			*rowptr;	// Pointer in sampled pixels
+  int			x,		// X position
+			xcount,		// X pixel count
+			xdir,		// X direction
+			xerr,		// X error accumulator
+			xmod = render->xmod,
+					// X modulus
+			xsize = render->xsize,
+					// Scaled width
+			xend = render->xend,
+					// X end position
+			xstep;		// X step
+
+
+  if (render->smoothing)
+  {
+    if ((pixptr = lerp_line(lerp, render->src, render->img_height, y - render->ystart, render->ysize)) == NULL)
+      return (false);
+
+    xdir = render->depth;
+  }
+  else if ((pixptr = isrc_get_row(render->src, (int)((y - render->ystart) * (render->img_height - 1) / (render->ysize - 1)), &xdir)) == NULL)
+    return (false);
+
+  // Interpolated lines already have one pixel per output column...
+  if (render->smoothing)
+    xstep = xdir;
+  else
+    xstep = (int)(render->img_width / xsize) * xdir;
+
+  if (render->xstart < 0)
+  {
+    pixptr -= (render->xstart * xmod / xsize) * xdir;
+    x    = 0;
+    xerr = -xmod / 2 - (render->xstart * xmod) % xsize;
+  }
+  else
+  {
+    x    = render->xstart;
+    xerr = -xmod / 2;
+  }
+
+  if (options->header.cupsBitsPerPixel == 1)
+  {
+    // Sample the image and then dither it to 1-bit black...
+    for (rowptr = row, xcount = xend - x; xcount > 0; xcount --)
+    {
+      // Copy the current pixel...
+      *rowptr++ = *pixptr;
+
+      // Advance to the next pixel...
+      pixptr += xstep;
+      xerr += xmod;
+      if (xerr >= (int)xsize)
+      {
+	// Accumulated error has overflowed, advance another pixel...
+	xerr -= xsize;
+	pixptr += xdir;
+      }
+    }
+
+    _papplDitherLine(line, (unsigned)x, xend > x ? (unsigned)(xend - x) : 0, row, _PAPPL_DPLANE_ROW(render->dplane, y), true);
+  }
+  else if (options->header.cupsColorSpace == CUPS_CSPACE_K)
+  {
+    // Need to invert the image...
+    for (lineptr = line + x; x < xend; x ++)
+    {
+      // Copy an inverted grayscale pixel...
+      *lineptr++ = ~*pixptr;
+
+      // Advance to the next pixel...
+      pixptr += xstep;
+      xerr += xmod;
+      if (xerr >= (int)xsize)
+      {
+	// Accumulated error has overflowed, advance another pixel...
+	xerr -= xsize;
+	pixptr += xdir;
+      }
+    }
+  }
+  else
+  {
+    // Need to copy the image...
+    int bpp = (int)options->header.cupsBitsPerPixel / 8;
+
+    for (lineptr = line + x * bpp; x < xend; x ++)
+    {
+      // Copy a grayscale or RGB pixel...
+      memcpy(lineptr, pixptr, (unsigned)bpp);
+      lineptr += bpp;
+
+      // Advance to the next pixel...
+      pixptr += xstep;
+      xerr += xmod;
+      if (xerr >= (int)xsize)
+      {
+	// Accumulated error has overflowed, advance another pixel...
+	xerr -= xsize;
+	pixptr += xdir;
+      }
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'run_bands_thread()' - Render bands of image lines.
+//
+// Each worker has its own interpolation state and dither buffer, and the image
+// source is only read through its in-memory pointers, so the only shared state
+// is the band bookkeeping protected by the mutex.
+//
+
+static void *				// O - Thread exit status
+run_bands_thread(_pappl_bands_t *bands)	// I - Band rendering state
+{
+  _pappl_irender_t	*render = bands->render;
+					// Line renderer
+  pappl_pr_options_t	*options = render->options;
+					// Print options
+  _pappl_lerp_t		lerp;		// Interpolation state
+  unsigned char		*row = NULL,	// Sampled pixels for dithering
+			*line;		// Current line
+  int			band,		// Current band
+			slot,		// Buffer for current band
+			y,		// Current line
+			last;		// Last line in band plus 1
+  bool			ok = true;	// Did the band render?
+
+
+  memset(&lerp, 0, sizeof(lerp));
+
+  if ((render->smoothing && !lerp_init(&lerp, render->img_width, render->depth, render->xstart, render->xend, render->xsize)) || (options->header.cupsBitsPerPixel == 1 && (row = malloc(options->header.cupsWidth)) == NULL))
+    ok = false;
+
+  pthread_mutex_lock(&bands->mutex);
+
+  while (ok && !bands->failed && bands->next_band < bands->num_bands)
+  {
+    // Claim the next band and wait for its buffer to be written...
+    band = bands->next_band ++;
+    slot = band % bands->num_slots;
+
+    while (!bands->failed && band >= (bands->written_band + bands->num_slots))
+      pthread_cond_wait(&bands->cond, &bands->mutex);
+
+    if (bands->failed)
+      break;
+
+    pthread_mutex_unlock(&bands->mutex);
+
+    // Render the band...
+    y    = bands->first + band * bands->lines;
+    last = y + bands->lines;
+    if (last > bands->last)
+      last = bands->last;
+
+    for (line = bands->buffer + (size_t)slot * bands->bufsize; ok && y < last; y ++, line += options->header.cupsBytesPerLine)
+      ok = render_line(render, &lerp, row, y, line);
+
+    pthread_mutex_lock(&bands->mutex);
+
+    if (ok)
+      bands->slot_band[slot] = band;
+
+    pthread_cond_broadcast(&bands->cond);
+  }
+
+  if (!ok)
+  {
+    papplLogJob(render->src->job, PAPPL_LOGLEVEL_ERROR, "Unable to render image band.");
+    bands->failed = true;
+    pthread_cond_broadcast(&bands->cond);
+  }
+
+  pthread_mutex_unlock(&bands->mutex);
+
+  lerp_free(&lerp);
+  free(row);
+
+  return (NULL);
 }
-#endif // HAVE_LIBJPEG
@@ -1,7 +1,7 @@
 //
 // Job IPP processing for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -12,7 +12,13 @@
 // Include necessary headers...
 //
 
+#ifdef __linux
+#  define _GNU_SOURCE			// For memfd_create()
+#endif // __linux
 #include "pappl-private.h"
+#ifdef __linux
+#  include <sys/mman.h>
+#endif // __linux
 
 
 //
@@ -31,10 +37,16 @@ typedef struct _pappl_attr_s		// Input attribute structure
 // Local functions...
 //
 
+static bool		can_stream_image(pappl_job_t *job);
+static void		close_documents(pappl_job_t *job);
 static void		ipp_cancel_job(pappl_client_t *client);
 static void		ipp_close_job(pappl_client_t *client);
 static void		ipp_get_job_attributes(pappl_client_t *client);
 static void		ipp_send_document(pappl_client_t *client);
+static int		open_memory_spool(pappl_job_t *job);
+static void		release_memory_spool(pappl_job_t *job);
+static bool		reserve_memory_spool(pappl_job_t *job, size_t bytes, size_t max_memory);
+static bool		spill_memory_spool(pappl_job_t *job, char *filename, size_t filesize);
 
 
 //
@@ -45,14 +57,36 @@ void
 _papplJobCopyAttributes(
     pappl_client_t *client,		// I - Client
     pappl_job_t    *job,		// I - Job
-    cups_array_t   *ra)			// I - requested-attributes
+    _pappl_raset_t *ra)			// I - requested-attributes
 {
-  _papplCopyAttributes(client->response, job->attrs, ra, IPP_TAG_JOB, 0);
+  ipp_jstate_t		state;		// "job-state" value
+  pappl_jreason_t	state_reasons;	// "job-state-reasons" values
+  int			impcompleted;	// "job-impressions-completed" value
+  ipp_t			*attrs;		// Full attributes of compacted job
 
-  if (!ra || cupsArrayFind(ra, "date-time-at-creation"))
+
+  // Get a consistent snapshot of the job status without locking the job...
+  _papplJobGetStatus(job, &state, &state_reasons, &impcompleted);
+
+  // Copy the static attributes, decoding them if the job has been compacted...
+  pthread_rwlock_rdlock(&job->rwlock);
+
+  if ((attrs = _papplJobUnpackNoLock(job)) != NULL)
+  {
+    _papplCopyAttributes(client->response, attrs, ra, IPP_TAG_JOB, 0);
+    ippDelete(attrs);
+  }
+  else
+  {
+    _papplCopyAttributes(client->response, job->attrs, ra, IPP_TAG_JOB, 0);
+  }
+
+  pthread_rwlock_unlock(&job->rwlock);
+
+  if (_papplRASetContains(ra, "date-time-at-creation"))
     ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-creation", ippTimeToDate(job->created));
 
-  if (!ra || cupsArrayFind(ra, "date-time-at-completed"))
+  if (_papplRASetContains(ra, "date-time-at-completed"))
   {
     if (job->completed)
       ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-completed", ippTimeToDate(job->completed));
@@ -60,7 +94,7 @@ _papplJobCopyAttributes(
       ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-completed");
   }
 
-  if (!ra || cupsArrayFind(ra, "date-time-at-processing"))
+  if (_papplRASetContains(ra, "date-time-at-processing"))
   {
     if (job->processing)
       ippAddDate(client->response, IPP_TAG_JOB, "date-time-at-processing", ippTimeToDate(job->processing));
@@ -68,19 +102,19 @@ _papplJobCopyAttributes(
       ippAddOutOfBand(client->response, IPP_TAG_JOB, IPP_TAG_NOVALUE, "date-time-at-processing");
   }
 
-  if (!ra || cupsArrayFind(ra, "job-impressions"))
+  if (_papplRASetContains(ra, "job-impressions"))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions", job->impressions);
 
-  if (!ra || cupsArrayFind(ra, "job-impressions-completed"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
+  if (_papplRASetContains(ra, "job-impressions-completed"))
+    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", impcompleted);
 
-  if (!ra || cupsArrayFind(ra, "job-printer-up-time"))
+  if (_papplRASetContains(ra, "job-printer-up-time"))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-printer-up-time", (int)(time(NULL) - client->printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "job-state"))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", (int)job->state);
+  if (_papplRASetContains(ra, "job-state"))
+    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_ENUM, "job-state", (int)state);
 
-  if (!ra || cupsArrayFind(ra, "job-state-message"))
+  if (_papplRASetContains(ra, "job-state-message"))
   {
     if (job->message)
     {
@@ -88,7 +122,7 @@ _papplJobCopyAttributes(
     }
     else
     {
-      switch (job->state)
+      switch (state)
       {
 	case IPP_JSTATE_PENDING :
 	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_TEXT), "job-state-message", NULL, "Job pending.");
@@ -129,9 +163,9 @@ _papplJobCopyAttributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "job-state-reasons"))
+  if (_papplRASetContains(ra, "job-state-reasons"))
   {
-    if (job->state_reasons)
+    if (state_reasons)
     {
       int		num_values = 0;	// Number of string values
       const char	*svalues[32];	// String values
@@ -139,7 +173,7 @@ _papplJobCopyAttributes(
 
       for (bit = PAPPL_JREASON_ABORTED_BY_SYSTEM; bit <= PAPPL_JREASON_WARNINGS_DETECTED; bit *= 2)
       {
-        if (bit & job->state_reasons)
+        if (bit & state_reasons)
           svalues[num_values ++] = _papplJobReasonString(bit);
       }
 
@@ -147,7 +181,7 @@ _papplJobCopyAttributes(
     }
     else
     {
-      switch (job->state)
+      switch (state)
       {
 	case IPP_JSTATE_PENDING :
 	    ippAddString(client->response, IPP_TAG_JOB, IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons", NULL, "none");
@@ -186,13 +220,13 @@ _papplJobCopyAttributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "time-at-creation"))
+  if (_papplRASetContains(ra, "time-at-creation"))
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "time-at-creation", (int)(job->created - client->printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "time-at-completed"))
+  if (_papplRASetContains(ra, "time-at-completed"))
     ippAddInteger(client->response, IPP_TAG_JOB, job->completed ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE, "time-at-completed", (int)(job->completed - client->printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "time-at-processing"))
+  if (_papplRASetContains(ra, "time-at-processing"))
     ippAddInteger(client->response, IPP_TAG_JOB, job->processing ? IPP_TAG_INTEGER : IPP_TAG_NOVALUE, "time-at-processing", (int)(job->processing - client->printer->start_time));
 }
 
@@ -201,48 +235,122 @@ _papplJobCopyAttributes(
 // '_papplJobCopyDocumentData()' - Finish receiving a document file in an IPP
 //                                 request and start processing.
 //
+// Documents after the first are spooled and handed to the job's processing
+// thread, which may already be printing the earlier documents.
+//
 
 void
 _papplJobCopyDocumentData(
     pappl_client_t *client,		// I - Client
-    pappl_job_t    *job)		// I - Job
+    pappl_job_t    *job,		// I - Job
+    const char     *format,		// I - Document format
+    bool           last)		// I - Last document in job?
 {
+  bool			first = job->num_documents == 0;
+					// First document in job?
+  bool			in_memory = false;
+					// Spooling to memory?
+  size_t		max_memory,	// Maximum document size in memory
+			total = 0;	// Total bytes received
   char			filename[1024],	// Filename buffer
+			ext[32],	// Extension for later documents
 			buffer[4096];	// Copy buffer
   ssize_t		bytes;		// Bytes read
-  cups_array_t		*ra;		// Attributes to send in response
+  long long		spool_start;	// Start of spool span
+  _pappl_raset_t	*ra;		// Attributes to send in response
+  static const char * const complete_attrs[] =
+  {					// Attributes for completed document data
+    "job-id",
+    "job-state",
+    "job-state-message",
+    "job-state-reasons",
+    "job-uri"
+  };
+  static const char * const abort_attrs[] =
+  {					// Attributes for aborted document data
+    "job-id",
+    "job-state",
+    "job-state-reasons",
+    "job-uri"
+  };
+
+
+  // If we have a PWG or Apple raster file and the printer is idle, process it
+  // as it is received.  Otherwise it is spooled like any other document and
+  // printed by the job's processing thread...
+  if (first && last && job->printer->num_processing_jobs < job->printer->max_processing_jobs && (!strcmp(format, "image/pwg-raster") || !strcmp(format, "image/urf")))
+  {
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_PENDING);
 
+    _papplJobProcessRaster(job, client);
 
-  // If we have a PWG or Apple raster file, process it directly or return
-  // server-error-busy...
-  if (!strcmp(job->format, "image/pwg-raster") || !strcmp(job->format, "image/urf"))
-  {
-    if (job->printer->processing_job)
-    {
-      papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Currently printing another job.");
-      _papplClientFlushDocumentData(client);
-      return;
-    }
+    goto complete_job;
+  }
 
-    job->state = IPP_JSTATE_PENDING;
+  // If we have a JPEG or PNG file that will be printed using the built-in
+  // image filters and the printer is idle, decode it as it is received
+  // instead of spooling it first...
+  if (first && last && job->printer->num_processing_jobs < job->printer->max_processing_jobs && can_stream_image(job))
+  {
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_PENDING);
 
-    _papplJobProcessRaster(job, client);
+    _papplJobProcessImage(job, client);
 
     goto complete_job;
   }
 
-  // Create a file for the request data...
-  if ((job->fd = papplJobOpenFile(job, filename, sizeof(filename), client->system->directory, NULL, "w")) < 0)
+  // Create a file for the request data, numbering documents after the first so
+  // they don't replace the one being printed...
+  spool_start = _PAPPL_TRACE_BEGIN(job);
+
+  if (!first)
+    snprintf(ext, sizeof(ext), "d%d.prn", job->num_documents + 1);
+
+  // Small first documents can be kept in memory until they outgrow the limit,
+  // and filters open the memory file through /proc...
+  max_memory = first ? papplSystemGetMaxSpoolMemory(client->system) : 0;
+
+  if (max_memory > 0 && (job->fd = open_memory_spool(job)) >= 0)
+  {
+    in_memory = true;
+    snprintf(filename, sizeof(filename), "/proc/self/fd/%d", job->fd);
+  }
+  else if ((job->fd = papplJobOpenFile(job, filename, sizeof(filename), client->system->directory, first ? NULL : ext, "w")) < 0)
   {
     papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print file: %s", strerror(errno));
 
     goto abort_job;
   }
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file \"%s\", format \"%s\".", filename, job->format);
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file \"%s\", format \"%s\".", filename, format);
 
   while ((bytes = httpRead2(client->http, buffer, sizeof(buffer))) > 0)
   {
+    if (in_memory && ((total + (size_t)bytes) > max_memory || !reserve_memory_spool(job, (size_t)bytes, max_memory)))
+    {
+      // Document is too large or too much memory is in use, move it to the
+      // spool directory...
+      in_memory = false;
+
+      if (!spill_memory_spool(job, filename, sizeof(filename)))
+      {
+        int error = errno;		// Spool error
+
+        close(job->fd);
+        job->fd = -1;
+
+        release_memory_spool(job);
+
+        papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print file: %s", strerror(error));
+
+        goto abort_job;
+      }
+
+      release_memory_spool(job);
+    }
+
+    total += (size_t)bytes;
+
     if (write(job->fd, buffer, (size_t)bytes) < bytes)
     {
       int error = errno;		// Write error
@@ -250,7 +358,10 @@ _papplJobCopyDocumentData(
       close(job->fd);
       job->fd = -1;
 
-      unlink(filename);
+      if (in_memory)
+        release_memory_spool(job);
+      else
+        unlink(filename);
 
       papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
 
@@ -264,14 +375,24 @@ _papplJobCopyDocumentData(
     close(job->fd);
     job->fd = -1;
 
-    unlink(filename);
+    if (in_memory)
+      release_memory_spool(job);
+    else
+      unlink(filename);
 
     papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to read print file.");
 
     goto abort_job;
   }
 
-  if (close(job->fd))
+  if (in_memory)
+  {
+    // Keep the memory file open until the job is done with it...
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Spooled %lu bytes in memory.", (unsigned long)total);
+
+    job->spool_fd = job->fd;
+  }
+  else if (close(job->fd))
   {
     int error = errno;			// Write error
 
@@ -286,23 +407,31 @@ _papplJobCopyDocumentData(
 
   job->fd = -1;
 
+  _PAPPL_TRACE_END(job, _PAPPL_JTRACE_SPOOL, spool_start);
+
   // Submit the job for processing...
-  _papplJobSubmitFile(job, filename);
+  if (!_papplJobSubmitFile(job, filename, format, last))
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to queue document for printing.");
+
+    if (first)
+    {
+      ra = _papplRASetCreateNames((int)(sizeof(abort_attrs) / sizeof(abort_attrs[0])), abort_attrs);
+      _papplJobCopyAttributes(client, job, ra);
+      _papplRASetDelete(ra);
+    }
+
+    return;
+  }
 
   complete_job:
 
   // Return the job info...
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-message");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
-
+  ra = _papplRASetCreateNames((int)(sizeof(complete_attrs) / sizeof(complete_attrs[0])), complete_attrs);
   _papplJobCopyAttributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
   return;
 
   // If we get here we had to abort the job...
@@ -310,27 +439,30 @@ _papplJobCopyDocumentData(
 
   _papplClientFlushDocumentData(client);
 
-  job->state     = IPP_JSTATE_ABORTED;
-  job->completed = time(NULL);
+  if (!first)
+  {
+    // The job is already queued, so let it finish the documents it has...
+    close_documents(job);
+    return;
+  }
+
+  _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_ABORTED);
 
   pthread_rwlock_wrlock(&client->printer->rwlock);
 
-  cupsArrayRemove(client->printer->active_jobs, job);
-  cupsArrayAdd(client->printer->completed_jobs, job);
+  _papplPrinterCompleteJobNoLock(client->printer, job);
 
   if (!client->system->clean_time)
+  {
     client->system->clean_time = time(NULL) + 60;
+    _papplSystemWakeup(client->system);
+  }
 
   pthread_rwlock_unlock(&client->printer->rwlock);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
-
+  ra = _papplRASetCreateNames((int)(sizeof(abort_attrs) / sizeof(abort_attrs[0])), abort_attrs);
   _papplJobCopyAttributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -498,6 +630,52 @@ _papplJobValidateDocumentAttributes(
 }
 
 
+//
+// 'can_stream_image()' - Determine whether a job can be streamed to the
+//                        built-in JPEG or PNG filter.
+//
+
+static bool				// O - `true` if the job can be streamed, `false` otherwise
+can_stream_image(pappl_job_t *job)	// I - Job
+{
+  _pappl_mime_filter_t	*filter;	// Filter for printing
+
+
+  // Don't stream when the driver or application provides its own filter...
+  if (_papplSystemFindMIMEFilter(job->system, job->format, job->printer->driver_data.format))
+    return (false);
+
+  if ((filter = _papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster")) == NULL)
+    return (false);
+
+#ifdef HAVE_LIBJPEG
+  if (filter->cb == _papplJobFilterJPEG)
+    return (true);
+#endif // HAVE_LIBJPEG
+
+#ifdef HAVE_LIBPNG
+  if (filter->cb == _papplJobFilterPNG)
+    return (true);
+#endif // HAVE_LIBPNG
+
+  return (false);
+}
+
+
+//
+// 'close_documents()' - Stop waiting for more documents in a job.
+//
+
+static void
+close_documents(pappl_job_t *job)	// I - Job
+{
+  pthread_mutex_lock(&job->doc_mutex);
+  job->more_documents = false;
+  pthread_cond_broadcast(&job->doc_cond);
+  pthread_mutex_unlock(&job->doc_mutex);
+}
+
+
 //
 // 'ipp_cancel_job()' - Cancel a job.
 //
@@ -581,10 +759,17 @@ ipp_close_job(pappl_client_t *client)	// I - Client
 
     case IPP_JSTATE_PROCESSING :
     case IPP_JSTATE_STOPPED :
-	papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_POSSIBLE, "Job #%d is already closed.", job->job_id);
+        if (job->more_documents)
+        {
+          close_documents(job);
+	  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+	}
+	else
+	  papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_POSSIBLE, "Job #%d is already closed.", job->job_id);
         break;
 
     default :
+        close_documents(job);
 	papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
         break;
   }
@@ -600,7 +785,7 @@ ipp_get_job_attributes(
     pappl_client_t *client)		// I - Client
 {
   pappl_job_t	*job = client->job;	// Job information
-  cups_array_t	*ra;			// requested-attributes
+  _pappl_raset_t *ra;			// requested-attributes
 
 
   if (!job)
@@ -611,9 +796,9 @@ ipp_get_job_attributes(
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = ippCreateRequestedArray(client->request);
+  ra = _papplRASetCreate(client->request);
   _papplJobCopyAttributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -628,7 +813,10 @@ ipp_send_document(
 {
   pappl_job_t	*job = client->job;	// Job information
   ipp_attribute_t *attr;		// Current attribute
-  bool		have_data;		// Do we have document data?
+  bool		have_data,		// Do we have document data?
+		first,			// First document in job?
+		last;			// Last document in job?
+  const char	*format;		// Document format
 
 
   // Get the job...
@@ -639,19 +827,21 @@ ipp_send_document(
     return;
   }
 
-  // See if we already have a document for this job or the job has already
-  // in a non-pending state...
+  // See if the job can accept another document - the first document must
+  // arrive while the job is held and later ones while the job still expects
+  // them, even if it is already printing...
   have_data = _papplClientHaveDocumentData(client);
+  first     = job->num_documents == 0;
 
   if (have_data)
   {
-    if (job->filename || job->fd >= 0 || job->streaming)
+    if (job->fd >= 0 || job->streaming)
     {
-      papplClientRespondIPP(client, IPP_STATUS_ERROR_MULTIPLE_JOBS_NOT_SUPPORTED, "Multiple document jobs are not supported.");
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Job is receiving another document.");
       _papplClientFlushDocumentData(client);
       return;
     }
-    else if (job->state > IPP_JSTATE_HELD)
+    else if (first ? job->state > IPP_JSTATE_HELD : (!job->more_documents || job->state > IPP_JSTATE_PROCESSING))
     {
       papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_POSSIBLE, "Job is not in a pending state.");
       _papplClientFlushDocumentData(client);
@@ -686,23 +876,159 @@ ipp_send_document(
     return;
   }
 
-  if (!have_data && !job->filename)
-    job->state = IPP_JSTATE_ABORTED;
+  last = ippGetBoolean(attr, 0);
 
-  // Then finish getting the document data and process things...
-  pthread_rwlock_wrlock(&(client->printer->rwlock));
+  if (!have_data)
+  {
+    // An empty request just closes the job...
+    if (first)
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+    else if (last)
+      close_documents(job);
 
-  _papplCopyAttributes(job->attrs, client->request, NULL, IPP_TAG_JOB, 0);
+    papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+    return;
+  }
+
+  if (first)
+  {
+    // Then finish getting the document data and process things...
+    pthread_rwlock_wrlock(&(client->printer->rwlock));
+    pthread_rwlock_wrlock(&job->rwlock);
 
-  if ((attr = ippFindAttribute(job->attrs, "document-format-detected", IPP_TAG_MIMETYPE)) != NULL)
-    job->format = ippGetString(attr, 0, NULL);
-  else if ((attr = ippFindAttribute(job->attrs, "document-format-supplied", IPP_TAG_MIMETYPE)) != NULL)
-    job->format = ippGetString(attr, 0, NULL);
+    _papplCopyAttributes(job->attrs, client->request, NULL, IPP_TAG_JOB, 0);
+
+    if ((attr = ippFindAttribute(job->attrs, "document-format-detected", IPP_TAG_MIMETYPE)) != NULL)
+      job->format = ippGetString(attr, 0, NULL);
+    else if ((attr = ippFindAttribute(job->attrs, "document-format-supplied", IPP_TAG_MIMETYPE)) != NULL)
+      job->format = ippGetString(attr, 0, NULL);
+    else
+      job->format = client->printer->driver_data.format;
+
+    pthread_rwlock_unlock(&job->rwlock);
+    pthread_rwlock_unlock(&(client->printer->rwlock));
+
+    format = job->format;
+  }
+  else if ((attr = ippFindAttribute(client->request, "document-format-detected", IPP_TAG_MIMETYPE)) != NULL)
+  {
+    // Later documents keep their own format, the job attributes describe the
+    // first document...
+    format = ippGetString(attr, 0, NULL);
+  }
+  else if ((attr = ippFindAttribute(client->request, "document-format-supplied", IPP_TAG_MIMETYPE)) != NULL)
+    format = ippGetString(attr, 0, NULL);
   else
-    job->format = client->printer->driver_data.format;
+    format = client->printer->driver_data.format;
 
-  pthread_rwlock_unlock(&(client->printer->rwlock));
+  _papplJobCopyDocumentData(client, job, format, last);
+}
 
-  if (have_data)
-    _papplJobCopyDocumentData(client, job);
+
+//
+// 'open_memory_spool()' - Create a memory file for a document.
+//
+
+static int				// O - File descriptor or `-1` if not available
+open_memory_spool(pappl_job_t *job)	// I - Job
+{
+#if defined(__linux) && defined(MFD_CLOEXEC)
+  int	fd;				// Memory file
+
+
+  if ((fd = memfd_create("pappl-spool", MFD_CLOEXEC)) < 0)
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Unable to create memory spool file: %s", strerror(errno));
+
+  return (fd);
+
+#else
+  (void)job;
+
+  return (-1);
+#endif // __linux && MFD_CLOEXEC
+}
+
+
+//
+// 'release_memory_spool()' - Remove a document from the memory spool total.
+//
+
+static void
+release_memory_spool(pappl_job_t *job)	// I - Job
+{
+  _PAPPL_ATOMIC_ADD(&job->system->spool_memory, -job->spool_size);
+  job->spool_size = 0;
+}
+
+
+//
+// 'reserve_memory_spool()' - Add document data to the memory spool total.
+//
+// The documents spooled in memory by all jobs can use up to
+// `_PAPPL_MAX_SPOOL_DOCUMENTS` times the maximum document size.
+//
+
+static bool				// O - `true` if the data fits, `false` otherwise
+reserve_memory_spool(
+    pappl_job_t *job,			// I - Job
+    size_t      bytes,			// I - Number of bytes to add
+    size_t      max_memory)		// I - Maximum document size
+{
+  if (_PAPPL_ATOMIC_ADD(&job->system->spool_memory, bytes) + bytes > _PAPPL_MAX_SPOOL_DOCUMENTS * max_memory)
+  {
+    _PAPPL_ATOMIC_ADD(&job->system->spool_memory, -bytes);
+    return (false);
+  }
+
+  job->spool_size += bytes;
+
+  return (true);
+}
+
+
+//
+// 'spill_memory_spool()' - Move a document from memory to the spool directory.
+//
+// The job's file descriptor is replaced by the new spool file and "filename"
+// is updated with its name.
+//
+
+static bool				// O - `true` on success, `false` on error
+spill_memory_spool(pappl_job_t *job,	// I - Job
+                   char        *filename,// IO - Filename buffer
+                   size_t      filesize)// I - Size of filename buffer
+{
+  int		fd;			// Spool file
+  char		buffer[8192];		// Copy buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  if ((fd = papplJobOpenFile(job, filename, filesize, job->system->directory, NULL, "w")) < 0)
+    return (false);
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Moving document to job file \"%s\".", filename);
+
+  lseek(job->fd, 0, SEEK_SET);
+
+  while ((bytes = read(job->fd, buffer, sizeof(buffer))) > 0)
+  {
+    if (write(fd, buffer, (size_t)bytes) < bytes)
+      break;
+  }
+
+  if (bytes != 0)
+  {
+    int error = errno;			// Write error
+
+    close(fd);
+    unlink(filename);
+
+    errno = error;
+    return (false);
+  }
+
+  close(job->fd);
+  job->fd = fd;
+
+  return (true);
 }
@@ -1,7 +1,7 @@
 //
 // Private job header file for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -20,10 +20,80 @@
 #  include "log.h"
 
 
+//
+// Macros...
+//
+
+#  define _PAPPL_JOB_STATUS_BEGIN(job) _PAPPL_ATOMIC_ADD(&(job)->status_seq, 1)
+#  define _PAPPL_JOB_STATUS_END(job) _PAPPL_ATOMIC_ADD(&(job)->status_seq, 1)
+#  define _PAPPL_JOB_SET_STATE(job,s) do { _PAPPL_JOB_STATUS_BEGIN(job); (job)->state = (s); _PAPPL_JOB_STATUS_END(job); } while (0)
+					// Set "job-state" for status readers
+#  define _PAPPL_JOB_SET_COMPLETED(job,s) do { _PAPPL_JOB_STATUS_BEGIN(job); (job)->state = (s); (job)->completed = time(NULL); _PAPPL_JOB_STATUS_END(job); } while (0)
+					// Set a final "job-state" and the completion time
+#  define _PAPPL_DPLANE_ROW(p,y) ((p)->rows + (size_t)((y) % (p)->height) * (p)->stride)
+					// Threshold row for line "y"
+#  define _PAPPL_DOC_TIMEOUT	60	// "multiple-operation-time-out" value
+#  define _PAPPL_CONVERT_BPP	4	// Bytes per pixel needed for a converted line
+#  define _PAPPL_CONVERT_MAX	4	// Maximum number of conversion steps
+#  ifdef PAPPL_NO_TRACE
+#    define _PAPPL_TRACE_BEGIN(job) 0
+#    define _PAPPL_TRACE_END(job,phase,start) (void)(start)
+#  else
+#    define _PAPPL_TRACE_BEGIN(job) ((job)->system->tracing ? _papplTraceTime() : 0)
+					// Start time of a traced span or `0` if tracing is off
+#    define _PAPPL_TRACE_END(job,phase,start) do { if (start) _papplJobAddTrace(job, phase, start); } while (0)
+					// Finish a traced span
+#  endif // PAPPL_NO_TRACE
+
+
 //
 // Types and structures...
 //
 
+typedef enum _pappl_jtrace_e		// Traced job processing phases
+{
+  _PAPPL_JTRACE_SPOOL,				// Copying document data to the spool file
+  _PAPPL_JTRACE_QUEUE,				// Waiting to be processed
+  _PAPPL_JTRACE_OPEN,				// Opening the device
+  _PAPPL_JTRACE_FILTER,				// Running the document filter
+  _PAPPL_JTRACE_STARTPAGE,			// Driver start page callback
+  _PAPPL_JTRACE_WRITELINE,			// Driver write line callback(s)
+  _PAPPL_JTRACE_WRITELINES,			// Driver write lines callback for a band
+  _PAPPL_JTRACE_ENDPAGE,			// Driver end page callback
+  _PAPPL_JTRACE_FINISH,				// Sending spooled output and finishing
+  _PAPPL_JTRACE_MAX				// Number of phases
+} _pappl_jtrace_t;
+
+typedef struct _pappl_jdoc_s		// Document received after the first
+{
+  char			*filename;		// Print file name
+  char			*format;		// "document-format" value
+} _pappl_jdoc_t;
+
+typedef struct _pappl_dplane_s		// Dither threshold plane
+{
+  struct _pappl_dplane_s *next;			// Next plane in printer's cache
+  int			refcount;		// Reference count
+  pappl_dither_t	dither;			// Source dither matrix
+  unsigned		width,			// Width in columns
+			height;			// Number of threshold rows
+  size_t		stride;			// Bytes per row (multiple of 64)
+  unsigned char		*data,			// Allocated memory
+			*rows;			// 64-byte aligned threshold rows
+} _pappl_dplane_t;
+
+typedef void (*_pappl_cstep_t)(unsigned char *dst, const unsigned char *src, unsigned count);
+					// Raster conversion step
+
+typedef struct _pappl_convert_s		// Raster line conversion
+{
+  unsigned		num_steps;		// Number of steps
+  _pappl_cstep_t	steps[_PAPPL_CONVERT_MAX];
+						// Conversion steps
+  unsigned		samples[_PAPPL_CONVERT_MAX];
+						// Values per pixel for each step
+} _pappl_convert_t;
+
 struct _pappl_job_s			// Job data
 {
   pthread_rwlock_t	rwlock;			// Reader/writer lock
@@ -35,19 +105,51 @@ struct _pappl_job_s			// Job data
 			*format;		// "document-format" value
   ipp_jstate_t		state;			// "job-state" value
   pappl_jreason_t	state_reasons;		// "job-state-reasons" values
+  unsigned		status_seq;		// Status sequence number, odd while updating
   bool			is_canceled;		// Has this job been canceled?
+  bool			is_compacted;		// Have the job attributes been compacted?
   char			*message;		// "job-state-message" value
   pappl_loglevel_t	msglevel;		// "job-state-message" log level
+  pappl_loglevel_t	loglevel;		// Log level or `PAPPL_LOGLEVEL_UNSPEC` for the printer's level
   time_t		created,		// "[date-]time-at-creation" value
 			processing,		// "[date-]time-at-processing" value
 			completed;		// "[date-]time-at-completed" value
   int			impressions,		// "job-impressions" value
 			impcompleted;		// "job-impressions-completed" value
   ipp_t			*attrs;			// Static attributes
+  unsigned char		*packed;		// Encoded attributes and strings of a compacted job
+  size_t		packed_len;		// Length of encoded attributes
   char			*filename;		// Print file name
   int			fd;			// Print file descriptor
+  int			spool_fd;		// Memory spool file for the print file, if any
+  size_t		spool_size;		// Bytes counted in the system's memory spool total
   bool			streaming;		// Streaming job?
+  bool			is_scheduled;		// Counted in printer's processing jobs?
+  pthread_mutex_t	doc_mutex;		// Mutex for document queue
+  pthread_cond_t	doc_cond;		// Condition for new documents
+  int			num_documents;		// Number of documents received
+  _pappl_jdoc_t		*documents;		// Documents received after the first
+  bool			more_documents;		// Are more documents expected?
+  double		score;			// Scheduling score, higher runs first
+  int			pending_index;		// Index in printer's pending heap plus 1, 0 if none
+  pappl_device_t	*device;		// Output device while processing
+  char			*spool_output;		// Output spool file for pipelined job, if any
   void			*data;			// Per-job driver data
+  pappl_pr_options_t	*options;		// Cached print options, if any
+  unsigned		options_pages;		// Number of pages for cached options
+  bool			options_color;		// Color flag for cached options
+  int			options_gen;		// Option table generation for cached options
+  long long		trace_queued;		// Time queued for tracing or `0` if not traced
+  long long		trace_usecs[_PAPPL_JTRACE_MAX];
+						// Total traced microseconds for each phase
+  int			refcount;		// Number of references to the job
+  pappl_job_t		*prev,			// Previous job in active/completed list
+			*next,			// Next job in active/completed list
+			*all_prev,		// Previous job in all jobs list
+			*all_next,		// Next job in all jobs list
+			*user_prev,		// Previous job for same user
+			*user_next,		// Next job for same user
+			*hash_next;		// Next job in "job-id" hash bucket
 };
 
 
@@ -55,13 +157,18 @@ struct _pappl_job_s			// Job data
 // Functions...
 //
 
-extern int		_papplJobCompareActive(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
-extern int		_papplJobCompareAll(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
-extern int		_papplJobCompareCompleted(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
-extern void		_papplJobCopyAttributes(pappl_client_t *client, pappl_job_t *job, cups_array_t *ra) _PAPPL_PRIVATE;
-extern void		_papplJobCopyDocumentData(pappl_client_t *client, pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplConvertInit(_pappl_convert_t *conv, const cups_page_header2_t *in, const cups_page_header2_t *out) _PAPPL_PRIVATE;
+extern void		_papplConvertLine(_pappl_convert_t *conv, unsigned char *dst, const unsigned char *src, unsigned width) _PAPPL_PRIVATE;
+extern void		_papplDitherLine(unsigned char *line, unsigned x, unsigned count, const unsigned char *pixels, const unsigned char *thresholds, bool invert) _PAPPL_PRIVATE;
+extern _pappl_dplane_t	*_papplDitherPlaneCreate(const unsigned char *matrix, unsigned mwidth, unsigned mheight, unsigned width) _PAPPL_PRIVATE;
+extern void		_papplDitherPlaneRelease(_pappl_dplane_t *plane) _PAPPL_PRIVATE;
+extern void		_papplJobAddTrace(pappl_job_t *job, _pappl_jtrace_t phase, long long start) _PAPPL_PRIVATE;
+extern void		_papplJobCopyAttributes(pappl_client_t *client, pappl_job_t *job, _pappl_raset_t *ra) _PAPPL_PRIVATE;
+extern void		_papplJobCopyDocumentData(pappl_client_t *client, pappl_job_t *job, const char *format, bool last) _PAPPL_PRIVATE;
 extern pappl_job_t	*_papplJobCreate(pappl_printer_t *printer, int job_id, const char *username, const char *format, const char *job_name, ipp_t *attrs) _PAPPL_PRIVATE;
 extern void		_papplJobDelete(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobExpandNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobGetStatus(pappl_job_t *job, ipp_jstate_t *state, pappl_jreason_t *reasons, int *impcompleted) _PAPPL_PRIVATE;
 #  ifdef HAVE_LIBJPEG
 extern bool		_papplJobFilterJPEG(pappl_job_t *job, pappl_device_t *device, void *data);
 #  endif // HAVE_LIBJPEG
@@ -69,13 +176,21 @@ extern bool		_papplJobFilterJPEG(pappl_job_t *job, pappl_device_t *device, void
 extern bool		_papplJobFilterPNG(pappl_job_t *job, pappl_device_t *device, void *data);
 #  endif // HAVE_LIBPNG
 extern void		*_papplJobProcess(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobProcessImage(pappl_job_t *job, pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplJobProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplJobProcessRaster(pappl_job_t *job, pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplJobProcessRaw(pappl_job_t *job, int sock, bool raster) _PAPPL_PRIVATE;
 extern const char	*_papplJobReasonString(pappl_jreason_t reason) _PAPPL_PRIVATE;
+extern void		_papplJobRelease(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplJobRemoveFile(pappl_job_t *job) _PAPPL_PRIVATE;
+extern pappl_job_t	*_papplJobRetain(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplJobSetState(pappl_job_t *job, ipp_jstate_t state) _PAPPL_PRIVATE;
-extern void		_papplJobSubmitFile(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
+extern bool		_papplJobStreamImage(pappl_job_t *job, pappl_device_t *device, http_t *http) _PAPPL_PRIVATE;
+extern bool		_papplJobSubmitFile(pappl_job_t *job, const char *filename, const char *format, bool last) _PAPPL_PRIVATE;
+extern ipp_t		*_papplJobUnpackNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
 extern bool		_papplJobValidateDocumentAttributes(pappl_client_t *client) _PAPPL_PRIVATE;
+extern bool		_papplJobWriteJournal(pappl_job_t *job) _PAPPL_PRIVATE;
+extern long long	_papplTraceTime(void) _PAPPL_PRIVATE;
 
 
 #endif // !_PAPPL_JOB_PRIVATE_H_
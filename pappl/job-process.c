@@ -12,15 +12,44 @@
 //
 
 #include "pappl-private.h"
+#include "device-private.h"
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_RASTER_BAND	262144	// Bytes per band of pass-through raster lines
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_rawsock_s		// Socket print raster stream
+{
+  pappl_job_t		*job;			// Job
+  int			sock;			// Client socket
+} _pappl_rawsock_t;
 
 
 //
 // Local functions...
 //
 
+static pappl_pr_options_t *copy_options(pappl_pr_options_t *options);
 static const char *cups_cspace_string(cups_cspace_t cspace);
+static bool	filter_raster(pappl_job_t *job);
 static bool	filter_raw(pappl_job_t *job, pappl_device_t *device);
+static int	find_keyword(_pappl_optable_t *table, const char *name, ipp_attribute_t *attr);
 static void	finish_job(pappl_job_t *job);
+static bool	next_document(pappl_job_t *job, int number);
+static bool	open_printer_device(pappl_job_t *job);
+static pappl_device_t *open_spool_output(pappl_job_t *job);
+static void	print_raster(pappl_job_t *job, cups_raster_t *ras);
+static pappl_raster_type_t raster_type(const cups_page_header2_t *header);
+static ssize_t	read_raw_cb(_pappl_rawsock_t *rsock, unsigned char *buffer, size_t bytes);
+static void	send_spool_output(pappl_job_t *job);
 static bool	start_job(pappl_job_t *job);
 
 
@@ -49,6 +78,8 @@ papplJobCreatePrintOptions(
   pappl_printer_t	*printer = job->printer;
 					// Printer
   const char		*raster_type;	// Raster type for output
+  _pappl_optable_t	*table;		// Option table
+  const _pappl_optentry_t *entry;	// Option table entry
   static const char * const sheet_back[] =
   {					// "pwg-raster-document-sheet-back values
     "normal",
@@ -60,13 +91,26 @@ papplJobCreatePrintOptions(
 
   papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Getting options for num_pages=%u, color=%s", num_pages, color ? "true" : "false");
 
-  // Clear all options...
-  if ((options = calloc(1, sizeof(pappl_pr_options_t))) == NULL)
-    return (NULL);
+  pthread_rwlock_rdlock(&printer->rwlock);
 
-  options->media = printer->driver_data.media_default;
+  // Reuse the options from the last call if nothing has changed...
+  if (job->options && job->options_pages == num_pages && job->options_color == color && job->options_gen == printer->options_gen)
+  {
+    options = copy_options(job->options);
 
-  pthread_rwlock_rdlock(&printer->rwlock);
+    pthread_rwlock_unlock(&printer->rwlock);
+
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Using cached options.");
+
+    return (options);
+  }
+
+  // Clear all options...
+  if ((table = _papplPrinterGetOptionTable(printer)) == NULL || (options = calloc(1, sizeof(pappl_pr_options_t))) == NULL)
+  {
+    pthread_rwlock_unlock(&printer->rwlock);
+    return (NULL);
+  }
 
   // copies
   if ((attr = ippFindAttribute(job->attrs, "copies", IPP_TAG_INTEGER)) != NULL)
@@ -95,12 +139,8 @@ papplJobCreatePrintOptions(
       const char *template = ippGetString(ippFindAttribute(col, "finishing-template", IPP_TAG_ZERO), 0, NULL);
 					// "finishing-template" value
 
-      if (template && !strcmp(template, "punch"))
-        options->finishings |= PAPPL_FINISHINGS_PUNCH;
-      else if (template && !strcmp(template, "staple"))
-        options->finishings |= PAPPL_FINISHINGS_STAPLE;
-      else if (template && !strcmp(template, "trim"))
-        options->finishings |= PAPPL_FINISHINGS_TRIM;
+      if ((entry = _papplOptionTableFind(table, "finishing-template", template)) != NULL)
+        options->finishings |= (pappl_finishings_t)entry->value;
     }
   }
 
@@ -116,7 +156,12 @@ papplJobCreatePrintOptions(
   else if ((attr = ippFindAttribute(job->attrs, "media", IPP_TAG_ZERO)) != NULL)
   {
     const char	*pwg_name = ippGetString(attr, 0, NULL);
-    pwg_media_t	*pwg_media = pwgMediaForPWG(pwg_name);
+    pwg_media_t	*pwg_media;
+
+    if ((entry = _papplOptionTableFind(table, "media", pwg_name)) != NULL)
+      pwg_media = (pwg_media_t *)&entry->media;
+    else
+      pwg_media = pwgMediaForPWG(pwg_name);
 
     if (pwg_name && pwg_media)
     {
@@ -129,16 +174,9 @@ papplJobCreatePrintOptions(
 
   if (!options->media.source[0])
   {
-    for (i = 0; i < printer->driver_data.num_source; i ++)
-    {
-      if (!strcmp(options->media.size_name, printer->driver_data.media_ready[i].size_name))
-      {
-        strlcpy(options->media.source, printer->driver_data.source[i], sizeof(options->media.source));
-        break;
-      }
-    }
-
-    if (!options->media.source[0])
+    if ((entry = _papplOptionTableFind(table, "media", options->media.size_name)) != NULL && entry->value >= 0)
+      strlcpy(options->media.source, printer->driver_data.source[entry->value], sizeof(options->media.source));
+    else
       strlcpy(options->media.source, printer->driver_data.media_default.source, sizeof(options->media.source));
   }
 
@@ -201,7 +239,7 @@ papplJobCreatePrintOptions(
 
   // print-color-mode
   if ((attr = ippFindAttribute(job->attrs, "print-color-mode", IPP_TAG_KEYWORD)) != NULL)
-    options->print_color_mode = _papplColorModeValue(ippGetString(attr, 0, NULL));
+    options->print_color_mode = (pappl_color_mode_t)find_keyword(table, "print-color-mode", attr);
   else
     options->print_color_mode = printer->driver_data.color_default;
 
@@ -225,7 +263,7 @@ papplJobCreatePrintOptions(
 
   // print-content-optimize
   if ((attr = ippFindAttribute(job->attrs, "print-content-optimize", IPP_TAG_KEYWORD)) != NULL)
-    options->print_content_optimize = _papplContentValue(ippGetString(attr, 0, NULL));
+    options->print_content_optimize = (pappl_content_t)find_keyword(table, "print-content-optimize", attr);
   else
     options->print_content_optimize = printer->driver_data.content_default;
 
@@ -245,7 +283,7 @@ papplJobCreatePrintOptions(
 
   // print-scaling
   if ((attr = ippFindAttribute(job->attrs, "print-scaling", IPP_TAG_KEYWORD)) != NULL)
-    options->print_scaling = _papplScalingValue(ippGetString(attr, 0, NULL));
+    options->print_scaling = (pappl_scaling_t)find_keyword(table, "print-scaling", attr);
   else
     options->print_scaling = printer->driver_data.scaling_default;
 
@@ -285,7 +323,7 @@ papplJobCreatePrintOptions(
 
   // sides
   if ((attr = ippFindAttribute(job->attrs, "sides", IPP_TAG_KEYWORD)) != NULL)
-    options->sides = _papplSidesValue(ippGetString(attr, 0, NULL));
+    options->sides = (pappl_sides_t)find_keyword(table, "sides", attr);
   else if (printer->driver_data.sides_default != PAPPL_SIDES_ONE_SIDED && options->num_pages != 1)
     options->sides = printer->driver_data.sides_default;
   else
@@ -346,7 +384,10 @@ papplJobCreatePrintOptions(
       raster_type = "black_8";
   }
 
-  cupsRasterInitPWGHeader(&options->header, pwgMediaForPWG(options->media.size_name), raster_type, options->printer_resolution[0], options->printer_resolution[1], _papplSidesString(options->sides), sheet_back[printer->driver_data.duplex]);
+  if ((entry = _papplOptionTableFind(table, "media", options->media.size_name)) != NULL)
+    cupsRasterInitPWGHeader(&options->header, (pwg_media_t *)&entry->media, raster_type, options->printer_resolution[0], options->printer_resolution[1], _papplSidesString(options->sides), sheet_back[printer->driver_data.duplex]);
+  else
+    cupsRasterInitPWGHeader(&options->header, pwgMediaForPWG(options->media.size_name), raster_type, options->printer_resolution[0], options->printer_resolution[1], _papplSidesString(options->sides), sheet_back[printer->driver_data.duplex]);
 
   options->header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount] = (unsigned)options->copies * options->num_pages;
 
@@ -393,6 +434,14 @@ papplJobCreatePrintOptions(
   for (i = 0; i < options->num_vendor; i ++)
     papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "%s=%s", options->vendor[i].name, options->vendor[i].value);
 
+  // Cache the options for the next page or document...
+  papplJobDeletePrintOptions(job->options);
+
+  job->options       = copy_options(options);
+  job->options_pages = num_pages;
+  job->options_color = color;
+  job->options_gen   = printer->options_gen;
+
   pthread_rwlock_unlock(&printer->rwlock);
 
   return (options);
@@ -425,31 +474,54 @@ void *					// O - Thread exit status
 _papplJobProcess(pappl_job_t *job)	// I - Job
 {
   _pappl_mime_filter_t	*filter;	// Filter for printing
+  long long		filter_start;	// Start of filter span
+  int			number = 0;	// Current document number
 
 
   // Start processing the job...
   if (start_job(job))
   {
-    // Do file-specific conversions...
-    if ((filter = _papplSystemFindMIMEFilter(job->system, job->format, job->printer->driver_data.format)) == NULL)
-      filter =_papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster");
-
-    if (filter)
+    // Print each document as it becomes available...
+    do
     {
-      if (!(filter->cb)(job, job->printer->device, filter->cbdata))
-	job->state = IPP_JSTATE_ABORTED;
-    }
-    else if (!strcmp(job->format, job->printer->driver_data.format))
-    {
-      if (!filter_raw(job, job->printer->device))
-	job->state = IPP_JSTATE_ABORTED;
-    }
-    else
-    {
-      // Abort a job we can't process...
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", job->format);
-      job->state = IPP_JSTATE_ABORTED;
+      number ++;
+
+      // Do file-specific conversions...
+      if ((filter = _papplSystemFindMIMEFilter(job->system, job->format, job->printer->driver_data.format)) == NULL)
+	filter =_papplSystemFindMIMEFilter(job->system, job->format, "image/pwg-raster");
+
+      if (filter)
+      {
+	filter_start = _PAPPL_TRACE_BEGIN(job);
+
+	if (!(filter->cb)(job, job->device, filter->cbdata))
+	  _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+
+	_PAPPL_TRACE_END(job, _PAPPL_JTRACE_FILTER, filter_start);
+      }
+      else if (!strcmp(job->format, "image/pwg-raster") || !strcmp(job->format, "image/urf"))
+      {
+        // Print raster documents that were spooled instead of streamed...
+	filter_start = _PAPPL_TRACE_BEGIN(job);
+
+	if (!filter_raster(job))
+	  _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+
+	_PAPPL_TRACE_END(job, _PAPPL_JTRACE_FILTER, filter_start);
+      }
+      else if (!strcmp(job->format, job->printer->driver_data.format))
+      {
+	if (!filter_raw(job, job->device))
+	  _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      }
+      else
+      {
+	// Abort a job we can't process...
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", job->format);
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      }
     }
+    while (job->state == IPP_JSTATE_PROCESSING && !job->is_canceled && next_document(job, number));
   }
 
   // Move the job to a completed state...
@@ -459,6 +531,37 @@ _papplJobProcess(pappl_job_t *job)	// I - Job
 }
 
 
+//
+// '_papplJobProcessImage()' - Process a JPEG or PNG image stream.
+//
+
+void
+_papplJobProcessImage(
+    pappl_job_t    *job,		// I - Job
+    pappl_client_t *client)		// I - Client
+{
+  // Start processing the job...
+  job->streaming = true;
+
+  if (start_job(job))
+  {
+    if (!_papplJobStreamImage(job, job->device, client->http))
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+  }
+
+  if (httpGetState(client->http) == HTTP_STATE_POST_RECV)
+  {
+    // Flush excess data...
+    char	buffer[8192];		// Read buffer
+
+    while (httpRead2(client->http, buffer, sizeof(buffer)) > 0)
+      ;				// Read all document data
+  }
+
+  finish_job(job);
+}
+
+
 //
 // '_papplJobProcessRaster()' - Process an Apple/PWG Raster file.
 //
@@ -468,22 +571,7 @@ _papplJobProcessRaster(
     pappl_job_t    *job,		// I - Job
     pappl_client_t *client)		// I - Client
 {
-  pappl_printer_t	*printer = job->printer;
-					// Printer for job
-  pappl_pr_options_t	*options = NULL;// Job options
   cups_raster_t		*ras = NULL;	// Raster stream
-  cups_page_header2_t	header;		// Page header
-  unsigned		header_pages;	// Number of pages from page header
-  const unsigned char	*dither;	// Dither line
-  unsigned char		*pixels,	// Incoming pixel line
-			*pixptr,	// Pixel pointer in line
-			*line,		// Output (bitmap) line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
-  unsigned		page = 0,	// Current page
-			x,		// Current column
-			y;		// Current line
 
 
   // Start processing the job...
@@ -496,245 +584,174 @@ _papplJobProcessRaster(
   if ((ras = cupsRasterOpenIO((cups_raster_iocb_t)httpRead2, client->http, CUPS_RASTER_READ)) == NULL)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster stream from client - %s", cupsLastErrorString());
-    job->state = IPP_JSTATE_ABORTED;
-    goto complete_job;
-  }
-
-  // Prepare options...
-  if (!cupsRasterReadHeader2(ras, &header))
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read raster stream from client - %s", cupsLastErrorString());
-    job->state = IPP_JSTATE_ABORTED;
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
     goto complete_job;
   }
 
-  if ((header_pages = header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]) > 0)
-    papplJobSetImpressions(job, (int)header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
+  print_raster(job, ras);
 
-  options = papplJobCreatePrintOptions(job, (unsigned)job->impressions, header.cupsBitsPerPixel > 8);
+  complete_job:
 
-  if (!(printer->driver_data.rstartjob_cb)(job, options, job->printer->device))
+  if (httpGetState(client->http) == HTTP_STATE_POST_RECV)
   {
-    job->state = IPP_JSTATE_ABORTED;
-    goto complete_job;
+    // Flush excess data...
+    char	buffer[8192];		// Read buffer
+
+    while (httpRead2(client->http, buffer, sizeof(buffer)) > 0)
+      ;				// Read all document data
   }
 
-  // Print pages...
-  do
-  {
-    if (job->is_canceled)
-      break;
+  cupsRasterClose(ras);
 
-    page ++;
-    papplJobSetImpressionsCompleted(job, 1);
+  finish_job(job);
+  return;
+}
 
-    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Page %u raster data is %ux%ux%u (%s)", page, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, cups_cspace_string(header.cupsColorSpace));
 
-    // Set options for this page...
-    papplJobDeletePrintOptions(options);
-    options = papplJobCreatePrintOptions(job, (unsigned)job->impressions, header.cupsBitsPerPixel > 8);
+//
+// '_papplJobProcessRaw()' - Send print data from a socket directly to the
+//                           device.
+//
+// This is used for socket print jobs that can start immediately.  When
+// "raster" is `true` the Apple/PWG Raster data is printed as it is received
+// using the driver's raster callbacks.  Otherwise the data is in the
+// printer's native format, the driver sets the `raw_streaming` member, and the
+// data goes to the device as it is received, without a spool file or the
+// driver's `printfile_cb` callback.
+//
 
-    if (header.cupsWidth == 0 || header.cupsHeight == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 8) || header.cupsColorOrder != CUPS_ORDER_CHUNKED || (header.cupsBytesPerLine != ((header.cupsWidth * header.cupsBitsPerPixel + 7) / 8)))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Bad raster data seen.");
-      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+void
+_papplJobProcessRaw(
+    pappl_job_t *job,			// I - Job
+    int         sock,			// I - Client socket
+    bool        raster)			// I - Apple/PWG Raster data?
+{
+  char		*buffer;		// Copy buffer
+  ssize_t	bytes;			// Bytes read from socket
+  bool		eof = false;		// Got the end of the print data?
+  struct pollfd	sockp;			// poll() data for client socket
+  time_t	activity;		// Network activity watchdog
 
-    if (header.cupsBitsPerPixel > 8 && !(printer->driver_data.color_supported & PAPPL_COLOR_MODE_COLOR))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unsupported raster data seen.");
-      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
 
-    if (options->header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8)
-      options->header = header;		// Use page header from client
+  // Start processing the job...
+  job->streaming = true;
 
-    if (!(printer->driver_data.rstartpage_cb)(job, options, job->printer->device, page))
-    {
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+  if (raster)
+  {
+    // Print raster data as it is received, a band at a time...
+    _pappl_rawsock_t	rsock;		// Raster stream data
+    cups_raster_t	*ras;		// Raster stream
 
-    if (options->header.cupsBytesPerLine > header.cupsBytesPerLine)
+    if (start_job(job))
     {
-      // Allocate enough space for the entire output line and clear to white
-      if ((pixels = malloc(options->header.cupsBytesPerLine)) == NULL)
+      rsock.job  = job;
+      rsock.sock = sock;
+
+      if ((ras = cupsRasterOpenIO((cups_raster_iocb_t)read_raw_cb, &rsock, CUPS_RASTER_READ)) == NULL)
       {
-        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
-	job->state = IPP_JSTATE_ABORTED;
-	break;
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster stream from client - %s", cupsLastErrorString());
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
       }
-
-      if (options->header.cupsColorSpace == CUPS_CSPACE_K)
-        memset(pixels, 0, options->header.cupsBytesPerLine);
       else
-        memset(pixels, 255, options->header.cupsBytesPerLine);
-    }
-    else
-    {
-      // The input raster is at least as wide as the output raster...
-      if ((pixels = malloc(header.cupsBytesPerLine)) == NULL)
       {
-        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
-	job->state = IPP_JSTATE_ABORTED;
-	break;
+	print_raster(job, ras);
+	cupsRasterClose(ras);
       }
     }
 
-    if ((line = malloc(options->header.cupsBytesPerLine)) == NULL)
-    {
-      free(pixels);
+    finish_job(job);
+    return;
+  }
 
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+  if ((buffer = malloc(_PAPPL_RAW_BUFSIZE)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate socket print buffer: %s", strerror(errno));
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+  }
+  else if (start_job(job))
+  {
+    papplJobSetImpressions(job, 1);
 
-    for (y = 0; !job->is_canceled && y < header.cupsHeight && y < options->header.cupsHeight; y ++)
+    activity     = time(NULL);
+    sockp.fd     = sock;
+    sockp.events = POLLIN | POLLERR;
+
+    while (!job->is_canceled && !job->printer->is_deleted && job->system->is_running)
     {
-      if (cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine))
+      if ((bytes = poll(&sockp, 1, 1000)) <= 0)
       {
-        if (header.cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1)
+        if (bytes < 0 && errno != EINTR && errno != EAGAIN)
         {
-          // Dither the line...
-	  dither = options->dither[y & 15];
-	  memset(line, 0, options->header.cupsBytesPerLine);
-
-          if (header.cupsColorSpace == CUPS_CSPACE_K)
-          {
-            // Black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr > dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-	  else
-	  {
-	    // Grayscale to black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr <= dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-
-          (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, line);
+          papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read print data: %s", strerror(errno));
+          break;
+        }
+        else if ((time(NULL) - activity) >= _PAPPL_RAW_TIMEOUT)
+        {
+          papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Timed out waiting for print data.");
+          break;
         }
-        else
-          (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, pixels);
-      }
-      else
-        break;
-    }
 
-    if (!job->is_canceled && y < header.cupsHeight)
-    {
-      // Discard excess lines from client...
-      while (y < header.cupsHeight)
-      {
-        cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine);
-        y ++;
+        continue;
       }
-    }
-    else
-    {
-      // Pad missing lines with whitespace...
-      if (header.cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1)
-      {
-        memset(line, 0, options->header.cupsBytesPerLine);
 
-        while (y < options->header.cupsHeight)
-        {
-	  (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, line);
-          y ++;
-        }
+      activity = time(NULL);
+
+      if ((bytes = recv(sock, buffer, _PAPPL_RAW_BUFSIZE, 0)) == 0)
+      {
+        // End of print data...
+        eof = true;
+        break;
       }
-      else
+      else if (bytes < 0)
       {
-        if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
-          memset(pixels, 0x00, header.cupsBytesPerLine);
-	else
-          memset(pixels, 0xff, header.cupsBytesPerLine);
+        if (errno == EINTR || errno == EAGAIN)
+          continue;
 
-        while (y < options->header.cupsHeight)
-        {
-	  (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, pixels);
-          y ++;
-        }
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read print data: %s", strerror(errno));
+        break;
       }
+      else if (papplDeviceWrite(job->device, buffer, (size_t)bytes) < 0)
+        break;
     }
 
-    free(pixels);
-    free(line);
+    papplDeviceFlush(job->device);
 
-    if (!(printer->driver_data.rendpage_cb)(job, options, job->printer->device, page))
-    {
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
-
-    if (job->is_canceled)
-      break;
-    else if (y < header.cupsHeight)
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page from raster stream from client - %s", cupsLastErrorString());
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+    if (eof)
+      papplJobSetImpressionsCompleted(job, 1);
+    else if (!job->is_canceled)
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
   }
-  while (cupsRasterReadHeader2(ras, &header));
 
-  if (!(printer->driver_data.rendjob_cb)(job, options, job->printer->device))
-    job->state = IPP_JSTATE_ABORTED;
-  else if (header_pages == 0)
-    papplJobSetImpressions(job, (int)page);
+  free(buffer);
 
-  complete_job:
+  finish_job(job);
+}
 
-  papplJobDeletePrintOptions(options);
 
-  if (httpGetState(client->http) == HTTP_STATE_POST_RECV)
-  {
-    // Flush excess data...
-    char	buffer[8192];		// Read buffer
+//
+// 'copy_options()' - Make a copy of a job options structure.
+//
 
-    while (httpRead2(client->http, buffer, sizeof(buffer)) > 0)
-      ;				// Read all document data
-  }
+static pappl_pr_options_t *		// O - Copy of options
+copy_options(
+    pappl_pr_options_t *options)	// I - Options
+{
+  pappl_pr_options_t	*copy;		// Copy of options
+  int			i;		// Looping var
 
-  cupsRasterClose(ras);
 
-  finish_job(job);
-  return;
+  if ((copy = malloc(sizeof(pappl_pr_options_t))) == NULL)
+    return (NULL);
+
+  memcpy(copy, options, sizeof(pappl_pr_options_t));
+
+  copy->num_vendor = 0;
+  copy->vendor     = NULL;
+
+  for (i = 0; i < options->num_vendor; i ++)
+    copy->num_vendor = cupsAddOption(options->vendor[i].name, options->vendor[i].value, copy->num_vendor, &copy->vendor);
+
+  return (copy);
 }
 
 
@@ -822,61 +839,143 @@ cups_cspace_string(
 
 
 //
-// 'filter_raw()' - "Filter" a raw print file.
+// 'filter_raster()' - Print a spooled Apple/PWG Raster file.
 //
 
 static bool				// O - `true` on success, `false` otherwise
-filter_raw(pappl_job_t    *job,		// I - Job
-           pappl_device_t *device)	// I - Device
+filter_raster(pappl_job_t *job)		// I - Job
 {
-  pappl_pr_options_t	*options;	// Job options
+  int		fd;			// Raster file
+  cups_raster_t	*ras;			// Raster stream
 
 
-  papplJobSetImpressions(job, 1);
-  options = papplJobCreatePrintOptions(job, 1, false);
+  if ((fd = open(job->filename, O_RDONLY | O_CLOEXEC | O_BINARY)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open print file '%s': %s", job->filename, strerror(errno));
+    return (false);
+  }
 
-  if (!(job->printer->driver_data.printfile_cb)(job, options, device))
+  if ((ras = cupsRasterOpen(fd, CUPS_RASTER_READ)) == NULL)
   {
-    papplJobDeletePrintOptions(options);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open raster file '%s' - %s", job->filename, cupsLastErrorString());
+    close(fd);
     return (false);
   }
 
-  papplJobDeletePrintOptions(options);
-  papplJobSetImpressionsCompleted(job, 1);
+  print_raster(job, ras);
 
-  return (true);
+  cupsRasterClose(ras);
+  close(fd);
+
+  return (job->state != IPP_JSTATE_ABORTED);
 }
 
 
 //
-// 'finish_job()' - Finish job processing...
+// 'filter_raw()' - "Filter" a raw print file.
 //
 
-static void
-finish_job(pappl_job_t  *job)		// I - Job
+static bool				// O - `true` on success, `false` otherwise
+filter_raw(pappl_job_t    *job,		// I - Job
+           pappl_device_t *device)	// I - Device
+{
+  pappl_pr_options_t	*options;	// Job options
+
+
+  papplJobSetImpressions(job, 1);
+  options = papplJobCreatePrintOptions(job, 1, false);
+
+  if (!(job->printer->driver_data.printfile_cb)(job, options, device))
+  {
+    papplJobDeletePrintOptions(options);
+    return (false);
+  }
+
+  papplJobDeletePrintOptions(options);
+  papplJobSetImpressionsCompleted(job, 1);
+
+  return (true);
+}
+
+
+//
+// 'find_keyword()' - Look up the bit value for a keyword attribute.
+//
+
+static int				// O - Bit value or `0` if unknown
+find_keyword(_pappl_optable_t *table,	// I - Option table
+             const char       *name,	// I - Attribute name
+             ipp_attribute_t  *attr)	// I - Attribute
+{
+  const _pappl_optentry_t *entry = _papplOptionTableFind(table, name, ippGetString(attr, 0, NULL));
+					// Option table entry
+
+
+  return (entry ? entry->value : 0);
+}
+
+
+//
+// 'finish_job()' - Finish job processing...
+//
+
+static void
+finish_job(pappl_job_t  *job)		// I - Job
 {
   pappl_printer_t *printer = job->printer;
 					// Printer
+  bool		delete_printer;		// Delete the printer?
+  long long	finish_start;		// Start of finish span
+
+
+  // Send any queued or spooled output to the device...
+  finish_start = _PAPPL_TRACE_BEGIN(job);
+
+  _papplDeviceStopOutput(job->device);
+
+  if (job->spool_output)
+    send_spool_output(job);
 
+  _PAPPL_TRACE_END(job, _PAPPL_JTRACE_FINISH, finish_start);
+
+  if (finish_start)
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Timings: spool=%.3fs, queue=%.3fs, open=%.3fs, filter=%.3fs, startpage=%.3fs, writeline=%.3fs, writelines=%.3fs, endpage=%.3fs, finish=%.3fs", job->trace_usecs[_PAPPL_JTRACE_SPOOL] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_QUEUE] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_OPEN] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_FILTER] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_STARTPAGE] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_WRITELINE] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_WRITELINES] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_ENDPAGE] * 0.000001, job->trace_usecs[_PAPPL_JTRACE_FINISH] * 0.000001);
 
   pthread_rwlock_wrlock(&job->rwlock);
   pthread_rwlock_wrlock(&printer->rwlock);
 
+  _PAPPL_JOB_STATUS_BEGIN(job);
   if (job->is_canceled)
     job->state = IPP_JSTATE_CANCELED;
   else if (job->state == IPP_JSTATE_PROCESSING)
     job->state = IPP_JSTATE_COMPLETED;
+  job->completed = time(NULL);
+  _PAPPL_JOB_STATUS_END(job);
 
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "%s, job-impressions-completed=%d.", job->state == IPP_JSTATE_COMPLETED ? "Completed" : job->state == IPP_JSTATE_CANCELED ? "Canceled" : "Aborted", job->impcompleted);
 
-  job->completed          = time(NULL);
-  printer->processing_job = NULL;
+  _papplSystemAddEventNoLock(job->system, printer, job, PAPPL_EVENT_JOB_COMPLETED | PAPPL_EVENT_JOB_STATE_CHANGED, "Job %s.", job->state == IPP_JSTATE_COMPLETED ? "completed" : job->state == IPP_JSTATE_CANCELED ? "canceled" : "aborted");
+
+  // Close the job's own device connection, if any...
+  if (job->device && job->device != printer->device)
+    papplDeviceClose(job->device);
+
+  job->device = NULL;
+
+  _papplPrinterUnscheduleJobNoLock(printer, job);
 
   _papplJobRemoveFile(job);
 
+  papplJobDeletePrintOptions(job->options);
+  job->options = NULL;
+
   pthread_rwlock_unlock(&job->rwlock);
 
-  if (printer->is_stopped)
+  if (printer->num_processing_jobs > 0)
+  {
+    // Other jobs are still being processed...
+  }
+  else if (printer->is_stopped)
   {
     // New printer-state is 'stopped'...
     printer->state      = IPP_PSTATE_STOPPED;
@@ -890,23 +989,34 @@ finish_job(pappl_job_t  *job)		// I - Job
 
   printer->state_time = time(NULL);
 
-  cupsArrayRemove(printer->active_jobs, job);
-  cupsArrayAdd(printer->completed_jobs, job);
+  if (printer->num_processing_jobs == 0)
+    _papplSystemAddEventNoLock(job->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED | (printer->state == IPP_PSTATE_STOPPED ? PAPPL_EVENT_PRINTER_STOPPED : PAPPL_EVENT_NONE), printer->state == IPP_PSTATE_STOPPED ? "Printer stopped." : "Printer idle.");
+
+  _papplPrinterCompleteJobNoLock(printer, job);
 
   printer->impcompleted += job->impcompleted;
 
   if (!job->system->clean_time)
+  {
     job->system->clean_time = time(NULL) + 60;
+    _papplSystemWakeup(job->system);
+  }
+
+  delete_printer = printer->is_deleted && printer->num_processing_jobs == 0;
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  _papplSystemConfigChanged(printer->system);
+  // The job journal (if any) already has the completed job...
+  if (printer->system->journal_fd < 0)
+    _papplSystemConfigChanged(printer->system);
 
   if (printer->is_deleted)
   {
-    papplPrinterDelete(printer);
+    // Delete the printer once the last processing job is done...
+    if (delete_printer)
+      papplPrinterDelete(printer);
   }
-  else if (cupsArrayCount(printer->active_jobs) > 0)
+  else if (printer->active_jobs.count > 0)
   {
     _papplPrinterCheckJobs(printer);
   }
@@ -916,12 +1026,14 @@ finish_job(pappl_job_t  *job)		// I - Job
 
     pthread_rwlock_wrlock(&printer->rwlock);
 
-    papplDeviceGetMetrics(printer->device, &metrics);
-    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device read metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.read_requests, (unsigned long)metrics.read_bytes, (unsigned long)metrics.read_msecs);
-    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device write metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.write_requests, (unsigned long)metrics.write_bytes, (unsigned long)metrics.write_msecs);
+    if (!printer->processing_job)
+    {
+      papplDeviceGetMetrics(printer->device, &metrics);
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device read metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.read_requests, (unsigned long)metrics.read_bytes, (unsigned long)metrics.read_msecs);
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device write metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.write_requests, (unsigned long)metrics.write_bytes, (unsigned long)metrics.write_msecs);
 
-    papplDeviceClose(printer->device);
-    printer->device = NULL;
+      _papplPrinterReleaseDeviceNoLock(printer);
+    }
 
     pthread_rwlock_unlock(&printer->rwlock);
   }
@@ -929,30 +1041,108 @@ finish_job(pappl_job_t  *job)		// I - Job
 
 
 //
-// 'start_job()' - Start processing a job...
+// 'next_document()' - Switch to the next document in a job.
+//
+// Client threads queue documents as they are received.  Wait up to the
+// "multiple-operation-time-out" for the next one and abort the job if it does
+// not arrive in time.  The timeout does not run while a client is sending a
+// document.  The document that was just printed is removed.
 //
 
-static bool				// O - `true` on success, `false` otherwise
-start_job(pappl_job_t *job)		// I - Job
+static bool				// O - `true` if there is another document, `false` otherwise
+next_document(pappl_job_t *job,		// I - Job
+              int         number)	// I - Number of the document that was printed
 {
-  pappl_printer_t *printer = job->printer;
-					// Printer
-  bool	first_open = true;		// Is this the first time we try to open the device?
+  bool			ready,		// Is the next document ready?
+			timed_out;	// Did we time out waiting?
+  time_t		timeout;	// Time when we give up
+  struct timeval	curtime;	// Current time
+  struct timespec	abstime;	// Time to wait until
+  char			*filename;	// Next document file
+  size_t		dirlen = strlen(job->system->directory);
+					// Length of spool directory
 
 
-  // Move the job to the 'processing' state...
+  // Wait for the next document, checking for cancellation once a second...
+  timeout = time(NULL) + _PAPPL_DOC_TIMEOUT;
+
+  pthread_mutex_lock(&job->doc_mutex);
+
+  while (job->num_documents <= number && job->more_documents && !job->is_canceled && time(NULL) < timeout)
+  {
+    gettimeofday(&curtime, NULL);
+    abstime.tv_sec  = curtime.tv_sec + 1;
+    abstime.tv_nsec = curtime.tv_usec * 1000;
+
+    pthread_cond_timedwait(&job->doc_cond, &job->doc_mutex, &abstime);
+
+    // Restart the timeout while a document is being received...
+    if (job->fd >= 0)
+      timeout = time(NULL) + _PAPPL_DOC_TIMEOUT;
+  }
+
+  ready     = job->num_documents > number && !job->is_canceled;
+  timed_out = !ready && job->more_documents && !job->is_canceled;
+
+  if (timed_out)
+    job->more_documents = false;
+
+  pthread_mutex_unlock(&job->doc_mutex);
+
+  if (timed_out)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Timed out waiting for document #%d.", number + 1);
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+    return (false);
+  }
+  else if (!ready)
+  {
+    return (false);
+  }
+
+  // Replace the printed document with the next one...
   pthread_rwlock_wrlock(&job->rwlock);
-  pthread_rwlock_wrlock(&printer->rwlock);
+  pthread_mutex_lock(&job->doc_mutex);
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Starting print job.");
+  filename = job->documents[number - 1].filename;
+  job->documents[number - 1].filename = NULL;
+
+  if (job->filename && !strncmp(job->filename, job->system->directory, dirlen) && job->filename[dirlen] == '/')
+    unlink(job->filename);
 
-  job->state              = IPP_JSTATE_PROCESSING;
-  job->processing         = time(NULL);
-  printer->processing_job = job;
+  free(job->filename);
+  job->filename = filename;
+  job->format   = job->documents[number - 1].format;
 
+  pthread_mutex_unlock(&job->doc_mutex);
   pthread_rwlock_unlock(&job->rwlock);
 
-  // Open the output device...
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Printing document #%d, format \"%s\".", number + 1, job->format);
+
+  return (filename != NULL);
+}
+
+
+//
+// 'open_printer_device()' - Open the printer's device connection for a job.
+//
+// The printer's writer lock must be held and the job must be the printer's
+// processing job.  The lock is released while waiting for the device to
+// become available.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+open_printer_device(pappl_job_t *job)	// I - Job
+{
+  pappl_printer_t *printer = job->printer;
+					// Printer
+  bool	first_open = true;		// Is this the first time we try to open the device?
+
+
+  // Open the output device, reusing an idle connection as needed...
+  if (printer->device && !printer->device_in_use)
+    _papplPrinterCheckDeviceNoLock(printer);
+
   while (!printer->device && !printer->is_deleted && !job->is_canceled)
   {
     printer->device = papplDeviceOpen(printer->device_uri, job->name, papplLogDevice, job->system);
@@ -967,6 +1157,8 @@ start_job(pappl_job_t *job)		// I - Job
 
 	printer->state      = IPP_PSTATE_STOPPED;
 	printer->state_time = time(NULL);
+
+        _papplSystemAddEventNoLock(job->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED | PAPPL_EVENT_PRINTER_STOPPED, "Printer unavailable.");
       }
 
       pthread_rwlock_unlock(&printer->rwlock);
@@ -975,14 +1167,667 @@ start_job(pappl_job_t *job)		// I - Job
     }
   }
 
-  if (printer->device)
+  job->device = printer->device;
+
+  return (job->device != NULL);
+}
+
+
+//
+// 'open_spool_output()' - Open a spool file for a job's output.
+//
+
+static pappl_device_t *			// O - Spool file device or `NULL` on error
+open_spool_output(pappl_job_t *job)	// I - Job
+{
+  int		fd;			// Spool file descriptor
+  char		filename[1024],		// Spool filename
+		uri[1024];		// Spool file device URI
+  pappl_device_t *device;		// Spool file device
+
+
+  if ((fd = papplJobOpenFile(job, filename, sizeof(filename), NULL, "out", "w")) < 0)
+    return (NULL);
+
+  close(fd);
+
+  httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), "file", NULL, NULL, 0, filename);
+
+  if ((device = papplDeviceOpen(uri, job->name, papplLogDevice, job->system)) == NULL || (job->spool_output = strdup(filename)) == NULL)
+  {
+    papplDeviceClose(device);
+    unlink(filename);
+    return (NULL);
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device is busy, spooling output to '%s'.", filename);
+
+  return (device);
+}
+
+
+//
+// 'print_raster()' - Print the pages in an Apple/PWG Raster stream.
+//
+// The stream is either being received from the client or read from a spooled
+// document file.
+//
+
+static void
+print_raster(pappl_job_t   *job,	// I - Job
+             cups_raster_t *ras)	// I - Raster stream
+{
+  pappl_printer_t	*printer = job->printer;
+					// Printer for job
+  pappl_pr_options_t	*options = NULL;// Job options
+  cups_page_header2_t	header,		// Page header
+			options_header;	// Page header from print options
+  bool			color;		// Is the page in color?
+  unsigned		header_pages;	// Number of pages from page header
+  unsigned char		*pixels = NULL,	// Incoming pixel line
+			*line = NULL,	// Output (bitmap) line
+			*cline = NULL;	// Converted pixel line
+  _pappl_dplane_t	*dplane = NULL;	// Dither thresholds
+  _pappl_convert_t	conv;		// Pixel conversion
+  bool			convert,	// Convert pixels for driver?
+			dither;		// Dither pixels for driver?
+  size_t		pixels_size = 0,// Size of pixel line buffer
+			line_size = 0,	// Size of output line buffer
+			cline_size = 0,	// Size of converted line buffer
+			bpl;		// Bytes per line needed
+  unsigned		page = 0,	// Current page
+			y,		// Current line
+			ylast,		// Last line to read plus 1
+			band,		// Lines per band
+			count,		// Lines in current band
+			i;		// Looping var
+  long long		trace_start;	// Start of traced span
+
+
+  // Prepare options...
+  if (!cupsRasterReadHeader2(ras, &header))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read raster data - %s", cupsLastErrorString());
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+    goto complete_job;
+  }
+
+  if ((header_pages = header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]) > 0)
+    papplJobSetImpressions(job, (int)header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
+
+  color          = header.cupsBitsPerPixel > 8;
+  options        = papplJobCreatePrintOptions(job, (unsigned)job->impressions, color);
+  options_header = options->header;
+
+  if (!(printer->driver_data.rstartjob_cb)(job, options, job->device))
+  {
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+    goto complete_job;
+  }
+
+  // Print pages...
+  do
+  {
+    if (job->is_canceled)
+      break;
+
+    page ++;
+    papplJobSetImpressionsCompleted(job, 1);
+
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Page %u raster data is %ux%ux%u (%s)", page, header.cupsWidth, header.cupsHeight, header.cupsBitsPerPixel, cups_cspace_string(header.cupsColorSpace));
+
+    // Set options for this page - the options only depend on the job
+    // attributes and whether the page is in color, so only rebuild them when
+    // the color mode changes...
+    if ((header.cupsBitsPerPixel > 8) != color)
+    {
+      color = header.cupsBitsPerPixel > 8;
+
+      papplJobDeletePrintOptions(options);
+      options        = papplJobCreatePrintOptions(job, (unsigned)job->impressions, color);
+      options_header = options->header;
+    }
+    else
+      options->header = options_header;
+
+    if (header.cupsWidth == 0 || header.cupsHeight == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 8 && header.cupsBitsPerColor != 16) || header.cupsColorOrder != CUPS_ORDER_CHUNKED || (header.cupsBytesPerLine != ((header.cupsWidth * header.cupsBitsPerPixel + 7) / 8)))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Bad raster data seen.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      break;
+    }
+
+    // Pass the client's pixels through when the driver supports them or they
+    // only need dithering, otherwise convert them to the driver's format...
+    dither = options->header.cupsBitsPerPixel == 1 && (header.cupsBitsPerPixel != 1 || header.cupsColorSpace != options->header.cupsColorSpace);
+
+    if (header.cupsColorSpace == options->header.cupsColorSpace && header.cupsBitsPerPixel == options->header.cupsBitsPerPixel)
+      convert = false;
+    else if (options->header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8 && (printer->driver_data.raster_types & raster_type(&header)) && (header.cupsBitsPerPixel <= 8 || (printer->driver_data.color_supported & PAPPL_COLOR_MODE_COLOR)))
+      convert = false;
+    else if (dither && header.cupsBitsPerPixel == 8)
+      convert = false;
+    else if (_papplConvertInit(&conv, &header, &options->header))
+      convert = true;
+    else
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unsupported raster data seen.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      break;
+    }
+
+    if (options->header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8 && !convert)
+      options->header = header;		// Use page header from client
+    else if (convert && !dither)
+    {
+      // Use page header from client with the driver's pixel format...
+      cups_page_header2_t temp = options->header;
+					// Driver's page header
+
+      options->header                  = header;
+      options->header.cupsColorSpace   = temp.cupsColorSpace;
+      options->header.cupsBitsPerColor = temp.cupsBitsPerColor;
+      options->header.cupsBitsPerPixel = temp.cupsBitsPerPixel;
+      options->header.cupsNumColors    = temp.cupsNumColors;
+      options->header.cupsBytesPerLine = (header.cupsWidth * temp.cupsBitsPerPixel + 7) / 8;
+    }
+
+    if (convert)
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Converting page %u from %ux%u %s to %ux%u %s.", page, header.cupsBitsPerColor, header.cupsBitsPerPixel / header.cupsBitsPerColor, cups_cspace_string(header.cupsColorSpace), options->header.cupsBitsPerColor, options->header.cupsBitsPerPixel / options->header.cupsBitsPerColor, cups_cspace_string(options->header.cupsColorSpace));
+
+    trace_start = _PAPPL_TRACE_BEGIN(job);
+
+    if (!(printer->driver_data.rstartpage_cb)(job, options, job->device, page))
+    {
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      break;
+    }
+
+    _PAPPL_TRACE_END(job, _PAPPL_JTRACE_STARTPAGE, trace_start);
+
+    // When the client's raster lines already match the driver's lines, read
+    // them in bands and pass them through without copying each line...
+    if (!convert && header.cupsBitsPerPixel == options->header.cupsBitsPerPixel && header.cupsBytesPerLine == options->header.cupsBytesPerLine)
+    {
+      if ((band = _PAPPL_RASTER_BAND / header.cupsBytesPerLine) < 1)
+        band = 1;
+    }
+    else
+      band = 1;
+
+    // Grow the line buffers as needed, reusing them for subsequent pages...
+    if ((bpl = options->header.cupsBytesPerLine) < header.cupsBytesPerLine)
+      bpl = header.cupsBytesPerLine;
+
+    bpl *= band;
+
+    if (bpl > pixels_size)
+    {
+      unsigned char *temp;		// New pixel buffer
+
+      if ((temp = realloc(pixels, bpl)) == NULL)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+	break;
+      }
+
+      pixels      = temp;
+      pixels_size = bpl;
+    }
+
+    if (options->header.cupsBytesPerLine > line_size)
+    {
+      unsigned char *temp;		// New output buffer
+
+      if ((temp = realloc(line, options->header.cupsBytesPerLine)) == NULL)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+	break;
+      }
+
+      line      = temp;
+      line_size = options->header.cupsBytesPerLine;
+    }
+
+    if (convert && (bpl = _PAPPL_CONVERT_BPP * (size_t)header.cupsWidth) > cline_size)
+    {
+      unsigned char *temp;		// New conversion buffer
+
+      if ((temp = realloc(cline, bpl)) == NULL)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+	break;
+      }
+
+      cline      = temp;
+      cline_size = bpl;
+    }
+
+    if (dither)
+    {
+      // Get the dither thresholds for this page, which are normally cached...
+      _papplDitherPlaneRelease(dplane);
+
+      if ((dplane = _papplPrinterGetDitherPlane(printer, options->dither, header.cupsWidth)) == NULL)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate dither thresholds.");
+	_PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+	break;
+      }
+    }
+
+    if (!convert && options->header.cupsBytesPerLine > header.cupsBytesPerLine)
+    {
+      // The input raster is narrower than the output raster, clear to white...
+      if (options->header.cupsColorSpace == CUPS_CSPACE_K)
+        memset(pixels, 0, options->header.cupsBytesPerLine);
+      else
+        memset(pixels, 255, options->header.cupsBytesPerLine);
+    }
+
+    ylast = header.cupsHeight < options->header.cupsHeight ? header.cupsHeight : options->header.cupsHeight;
+
+    for (y = 0; !job->is_canceled && y < ylast; y += count)
+    {
+      if ((count = ylast - y) > band)
+        count = band;
+
+      if (!cupsRasterReadPixels(ras, pixels, count * header.cupsBytesPerLine))
+        break;
+
+      trace_start = _PAPPL_TRACE_BEGIN(job);
+
+      if (dither)
+      {
+	// Dither the line, converting to 8-bit black first as needed...
+        unsigned dwidth = header.cupsWidth < options->header.cupsWidth ? header.cupsWidth : options->header.cupsWidth;
+					// Number of pixels to dither
+
+	memset(line, 0, options->header.cupsBytesPerLine);
+
+	if (convert)
+	{
+	  _papplConvertLine(&conv, cline, pixels, header.cupsWidth);
+	  _papplDitherLine(line, 0, dwidth, cline, _PAPPL_DPLANE_ROW(dplane, y), false);
+	}
+	else
+	  _papplDitherLine(line, 0, dwidth, pixels, _PAPPL_DPLANE_ROW(dplane, y), header.cupsColorSpace != CUPS_CSPACE_K);
+
+	(printer->driver_data.rwriteline_cb)(job, options, job->device, y, line);
+      }
+      else if (convert)
+      {
+        // Convert the line...
+        _papplConvertLine(&conv, cline, pixels, header.cupsWidth);
+
+	(printer->driver_data.rwriteline_cb)(job, options, job->device, y, cline);
+      }
+      else if (count > 1 && printer->driver_data.rwritelines_cb)
+      {
+        // Send the whole band, recording a span for each one...
+	(printer->driver_data.rwritelines_cb)(job, options, job->device, y, count, pixels);
+
+	_PAPPL_TRACE_END(job, _PAPPL_JTRACE_WRITELINES, trace_start);
+	continue;
+      }
+      else
+      {
+        for (i = 0; i < count; i ++)
+	  (printer->driver_data.rwriteline_cb)(job, options, job->device, y + i, pixels + i * header.cupsBytesPerLine);
+      }
+
+      _PAPPL_TRACE_END(job, _PAPPL_JTRACE_WRITELINE, trace_start);
+    }
+
+    if (!job->is_canceled && y < header.cupsHeight)
+    {
+      // Discard excess lines from client...
+      while (y < header.cupsHeight)
+      {
+        cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine);
+        y ++;
+      }
+    }
+    else
+    {
+      // Pad missing lines with whitespace...
+      if (dither)
+      {
+        memset(line, 0, options->header.cupsBytesPerLine);
+
+        while (y < options->header.cupsHeight)
+        {
+	  (printer->driver_data.rwriteline_cb)(job, options, job->device, y, line);
+          y ++;
+        }
+      }
+      else
+      {
+        if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
+          memset(pixels, 0x00, header.cupsBytesPerLine);
+	else
+          memset(pixels, 0xff, header.cupsBytesPerLine);
+
+        if (convert)
+          _papplConvertLine(&conv, cline, pixels, header.cupsWidth);
+
+        while (y < options->header.cupsHeight)
+        {
+	  (printer->driver_data.rwriteline_cb)(job, options, job->device, y, convert ? cline : pixels);
+          y ++;
+        }
+      }
+    }
+
+    trace_start = _PAPPL_TRACE_BEGIN(job);
+
+    if (!(printer->driver_data.rendpage_cb)(job, options, job->device, page))
+    {
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      break;
+    }
+
+    _PAPPL_TRACE_END(job, _PAPPL_JTRACE_ENDPAGE, trace_start);
+
+    if (job->is_canceled)
+      break;
+    else if (y < header.cupsHeight)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page from raster data - %s", cupsLastErrorString());
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+      break;
+    }
+  }
+  while (cupsRasterReadHeader2(ras, &header));
+
+  if (!(printer->driver_data.rendjob_cb)(job, options, job->device))
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+  else if (header_pages == 0)
+    papplJobSetImpressions(job, (int)page);
+
+  complete_job:
+
+  free(pixels);
+  free(line);
+  free(cline);
+  _papplDitherPlaneRelease(dplane);
+
+  papplJobDeletePrintOptions(options);
+}
+
+
+//
+// 'raster_type()' - Get the PWG raster type for a page header.
+//
+
+static pappl_raster_type_t		// O - Raster type bit or `PAPPL_PWG_RASTER_TYPE_NONE`
+raster_type(
+    const cups_page_header2_t *header)	// I - Page header
+{
+  bool	is16 = header->cupsBitsPerColor == 16;
+					// 16 bits per color?
+
+
+  if (header->cupsBitsPerColor == 1)
+    return (header->cupsColorSpace == CUPS_CSPACE_K ? PAPPL_PWG_RASTER_TYPE_BLACK_1 : PAPPL_PWG_RASTER_TYPE_NONE);
+  else if (header->cupsBitsPerColor != 8 && !is16)
+    return (PAPPL_PWG_RASTER_TYPE_NONE);
+
+  switch (header->cupsColorSpace)
+  {
+    case CUPS_CSPACE_ADOBERGB :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_ADOBE_RGB_16 : PAPPL_PWG_RASTER_TYPE_ADOBE_RGB_8);
+    case CUPS_CSPACE_K :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_BLACK_16 : PAPPL_PWG_RASTER_TYPE_BLACK_8);
+    case CUPS_CSPACE_CMYK :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_CMYK_16 : PAPPL_PWG_RASTER_TYPE_CMYK_8);
+    case CUPS_CSPACE_RGB :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_RGB_16 : PAPPL_PWG_RASTER_TYPE_RGB_8);
+    case CUPS_CSPACE_SW :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_SGRAY_16 : PAPPL_PWG_RASTER_TYPE_SGRAY_8);
+    case CUPS_CSPACE_SRGB :
+        return (is16 ? PAPPL_PWG_RASTER_TYPE_SRGB_16 : PAPPL_PWG_RASTER_TYPE_SRGB_8);
+    default :
+        return (PAPPL_PWG_RASTER_TYPE_NONE);
+  }
+}
+
+
+//
+// 'read_raw_cb()' - Read raster data from a socket print connection.
+//
+
+static ssize_t				// O - Number of bytes read or -1 on error
+read_raw_cb(_pappl_rawsock_t *rsock,	// I - Raster stream data
+            unsigned char    *buffer,	// I - Read buffer
+            size_t           bytes)	// I - Number of bytes to read
+{
+  ssize_t	rbytes;			// Bytes read
+  struct pollfd	sockp;			// poll() data for client socket
+  time_t	activity = time(NULL);	// Network activity watchdog
+
+
+  sockp.fd     = rsock->sock;
+  sockp.events = POLLIN | POLLERR;
+
+  while (!rsock->job->is_canceled && !rsock->job->printer->is_deleted && rsock->job->system->is_running)
+  {
+    if ((rbytes = poll(&sockp, 1, 1000)) <= 0)
+    {
+      if (rbytes < 0 && errno != EINTR && errno != EAGAIN)
+        break;
+      else if ((time(NULL) - activity) >= _PAPPL_RAW_TIMEOUT)
+      {
+        papplLogJob(rsock->job, PAPPL_LOGLEVEL_ERROR, "Timed out waiting for print data.");
+        return (-1);
+      }
+
+      continue;
+    }
+
+    if ((rbytes = recv(rsock->sock, buffer, bytes, 0)) >= 0)
+      return (rbytes);
+    else if (errno != EINTR && errno != EAGAIN)
+      break;
+  }
+
+  if (!rsock->job->is_canceled)
+    papplLogJob(rsock->job, PAPPL_LOGLEVEL_ERROR, "Unable to read print data: %s", strerror(errno));
+
+  return (-1);
+}
+
+
+//
+// 'send_spool_output()' - Send a pipelined job's spooled output to the device.
+//
+
+static void
+send_spool_output(pappl_job_t *job)	// I - Job
+{
+  pappl_printer_t *printer = job->printer;
+					// Printer
+  int		fd;			// Spool file descriptor
+  char		buffer[65536];		// Copy buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  // Close the spool file and wait for the printer's device...
+  papplDeviceClose(job->device);
+  job->device = NULL;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  if (!printer->processing_job)
+  {
+    printer->processing_job = job;
+  }
+  else if (printer->processing_job != job)
+  {
+    // Wait in line, the job using the device hands it to the first waiting
+    // job when it is done...
+    if (!printer->spool_jobs)
+      printer->spool_jobs = cupsArrayNew(NULL, NULL);
+
+    cupsArrayAdd(printer->spool_jobs, job);
+
+    while (printer->processing_job != job && !printer->is_deleted && !job->is_canceled)
+    {
+      struct timeval	curtime;	// Current time
+      struct timespec	abstime;	// Time to wait until
+
+      pthread_rwlock_unlock(&printer->rwlock);
+
+      // Wake up once a second to check for cancellation...
+      gettimeofday(&curtime, NULL);
+      abstime.tv_sec  = curtime.tv_sec + 1;
+      abstime.tv_nsec = curtime.tv_usec * 1000;
+
+      pthread_mutex_lock(&printer->spool_mutex);
+      if (printer->processing_job != job)
+        pthread_cond_timedwait(&printer->spool_cond, &printer->spool_mutex, &abstime);
+      pthread_mutex_unlock(&printer->spool_mutex);
+
+      pthread_rwlock_wrlock(&printer->rwlock);
+
+      // Nobody is ahead of us if the device was released without a hand off
+      // (we could not be added to the line)...
+      if (!printer->processing_job)
+        printer->processing_job = job;
+    }
+
+    cupsArrayRemove(printer->spool_jobs, job);
+  }
+
+  if (printer->processing_job == job)
+  {
+    if (open_printer_device(job))
+    {
+      printer->state      = IPP_PSTATE_PROCESSING;
+      printer->state_time = time(NULL);
+
+      _papplSystemAddEventNoLock(job->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, "Printing.");
+    }
+  }
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  // Copy the spooled output...
+  if (job->device && job->state == IPP_JSTATE_PROCESSING && !job->is_canceled)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Sending spooled output to device.");
+
+    if ((fd = open(job->spool_output, O_RDONLY | O_BINARY)) >= 0)
+    {
+      while ((bytes = read(fd, buffer, sizeof(buffer))) > 0 && !job->is_canceled)
+      {
+	if (papplDeviceWrite(job->device, buffer, (size_t)bytes) < 0)
+	{
+	  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to send spooled output to device.");
+	  _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+	  break;
+	}
+      }
+
+      close(fd);
+      papplDeviceFlush(job->device);
+    }
+    else
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open spooled output '%s': %s", job->spool_output, strerror(errno));
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+    }
+  }
+  else if (!job->device && job->state == IPP_JSTATE_PROCESSING)
+  {
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_ABORTED);
+  }
+
+  unlink(job->spool_output);
+  free(job->spool_output);
+  job->spool_output = NULL;
+}
+
+
+//
+// 'start_job()' - Start processing a job...
+//
+
+static bool				// O - `true` on success, `false` otherwise
+start_job(pappl_job_t *job)		// I - Job
+{
+  pappl_printer_t *printer = job->printer;
+					// Printer
+  long long	open_start;		// Start of device open span
+
+
+  // Move the job to the 'processing' state...
+  pthread_rwlock_wrlock(&job->rwlock);
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Starting print job.");
+
+  _PAPPL_TRACE_END(job, _PAPPL_JTRACE_QUEUE, job->trace_queued);
+  job->trace_queued = 0;
+
+  _PAPPL_JOB_STATUS_BEGIN(job);
+  job->state      = IPP_JSTATE_PROCESSING;
+  job->processing = time(NULL);
+  _PAPPL_JOB_STATUS_END(job);
+
+  _papplSystemAddEventNoLock(job->system, printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job printing.");
+
+  if (!job->is_scheduled)
+  {
+    // Streamed jobs are not started by _papplPrinterCheckJobs...
+    job->is_scheduled = true;
+    printer->num_processing_jobs ++;
+  }
+
+  if (!printer->processing_job || printer->processing_job == job)
+    printer->processing_job = job;
+
+  pthread_rwlock_unlock(&job->rwlock);
+
+  open_start = _PAPPL_TRACE_BEGIN(job);
+
+  if (printer->processing_job == job)
+  {
+    // Use the printer's device connection...
+    open_printer_device(job);
+  }
+  else
+  {
+    // Another job is using the printer's connection, so open a separate
+    // connection (pooled printers) or spool the output until the device is
+    // available...
+    pthread_rwlock_unlock(&printer->rwlock);
+
+    if ((job->device = papplDeviceOpen(printer->device_uri, job->name, papplLogDevice, job->system)) == NULL)
+      job->device = open_spool_output(job);
+
+    pthread_rwlock_wrlock(&printer->rwlock);
+  }
+
+  _PAPPL_TRACE_END(job, _PAPPL_JTRACE_OPEN, open_start);
+
+  if (job->device)
   {
     // Move the printer to the 'processing' state...
     printer->state      = IPP_PSTATE_PROCESSING;
     printer->state_time = time(NULL);
+
+    // Hand device writes to an output thread if the driver asks for one...
+    if (printer->driver_data.output_thread && !job->spool_output)
+      _papplDeviceStartOutput(job->device, printer->driver_data.output_policy, printer->driver_data.output_priority, printer->driver_data.output_cpus, printer->driver_data.output_queue);
   }
 
   pthread_rwlock_unlock(&printer->rwlock);
 
-  return (printer->device != NULL);
+  return (job->device != NULL);
 }
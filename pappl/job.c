@@ -1,7 +1,7 @@
 //
 // Job object for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -13,6 +13,45 @@
 //
 
 #include "pappl-private.h"
+#if !_WIN32
+#  include <sys/mman.h>
+#endif // !_WIN32
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_jpack_s		// Encoded attributes buffer
+{
+  unsigned char	*data;			// Buffer
+  size_t	length,			// Bytes in buffer
+		size,			// Allocated size of buffer
+		offset;			// Read offset
+} _pappl_jpack_t;
+
+
+//
+// Local functions...
+//
+
+static void	add_job_index(pappl_printer_t *printer, pappl_job_t *job);
+static void	compact_job(pappl_job_t *job);
+static int	compare_user_jobs(_pappl_userjobs_t *a, _pappl_userjobs_t *b);
+static bool	dequeue_job(pappl_job_t *job);
+static int	expand_cb(void *context, ipp_t *dst, ipp_attribute_t *attr);
+static void	free_user_jobs(_pappl_userjobs_t *u);
+static void	move_pending(pappl_printer_t *printer, int index);
+static ssize_t	pack_read_cb(_pappl_jpack_t *pack, ipp_uchar_t *buffer, size_t bytes);
+static ssize_t	pack_write_cb(_pappl_jpack_t *pack, ipp_uchar_t *buffer, size_t bytes);
+static bool	pending_before(pappl_job_t *a, pappl_job_t *b);
+static bool	queue_job(pappl_job_t *job);
+static void	remove_job_index(pappl_printer_t *printer, pappl_job_t *job);
+static void	remove_pending(pappl_printer_t *printer, pappl_job_t *job);
+static void	*run_clean_thread(pappl_system_t *system);
+static void	*run_job_thread(pappl_system_t *system);
+static double	score_job(pappl_printer_t *printer, pappl_job_t *job);
+static void	unlink_job(_pappl_joblist_t *list, pappl_job_t *job);
 
 
 //
@@ -26,6 +65,10 @@
 void
 papplJobCancel(pappl_job_t *job)	// I - Job
 {
+  bool	check_jobs = false,		// Check for new jobs?
+	delete_printer;			// Delete the printer?
+
+
   if (!job)
     return;
 
@@ -36,23 +79,43 @@ papplJobCancel(pappl_job_t *job)	// I - Job
   {
     job->is_canceled = true;
   }
-  else
+  else if (job->state < IPP_JSTATE_CANCELED)
   {
-    job->state     = IPP_JSTATE_CANCELED;
-    job->completed = time(NULL);
+    if (job->is_scheduled && dequeue_job(job))
+    {
+      // Job was still waiting for a worker thread...
+      _papplPrinterUnscheduleJobNoLock(job->printer, job);
+      check_jobs = true;
+    }
+
+    _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_CANCELED);
+
+    _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_COMPLETED | PAPPL_EVENT_JOB_STATE_CHANGED, "Job canceled.");
 
     _papplJobRemoveFile(job);
 
-    cupsArrayRemove(job->printer->active_jobs, job);
-    cupsArrayAdd(job->printer->completed_jobs, job);
+    _papplPrinterCompleteJobNoLock(job->printer, job);
   }
 
+  delete_printer = job->printer->is_deleted && job->printer->num_processing_jobs == 0;
+
   pthread_rwlock_unlock(&job->printer->rwlock);
 
   if (!job->system->clean_time)
+  {
     job->system->clean_time = time(NULL) + 60;
+    _papplSystemWakeup(job->system);
+  }
 
   pthread_rwlock_unlock(&job->rwlock);
+
+  if (check_jobs)
+  {
+    if (delete_printer)
+      papplPrinterDelete(job->printer);
+    else if (!job->printer->is_deleted)
+      _papplPrinterCheckJobs(job->printer);
+  }
 }
 
 
@@ -80,7 +143,7 @@ _papplJobCreate(
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
-  if (printer->max_active_jobs > 0 && cupsArrayCount(printer->active_jobs) >= printer->max_active_jobs)
+  if (printer->max_active_jobs > 0 && printer->active_jobs.count >= printer->max_active_jobs)
   {
     pthread_rwlock_unlock(&printer->rwlock);
     return (NULL);
@@ -94,14 +157,20 @@ _papplJobCreate(
     return (NULL);
   }
 
-  job->attrs   = ippNew();
-  job->fd      = -1;
-  job->format  = format;
-  job->name    = job_name;
-  job->printer = printer;
-  job->state   = IPP_JSTATE_HELD;
-  job->system  = printer->system;
-  job->created = time(NULL);
+  job->attrs    = ippNew();
+  job->fd       = -1;
+  job->spool_fd = -1;
+  job->format   = format;
+  job->loglevel = PAPPL_LOGLEVEL_UNSPEC;
+  job->name     = job_name;
+  job->printer  = printer;
+  job->state    = IPP_JSTATE_HELD;
+  job->system   = printer->system;
+  job->created  = time(NULL);
+  job->refcount = 1;			// Reference held by the printer
+
+  pthread_mutex_init(&job->doc_mutex, NULL);
+  pthread_cond_init(&job->doc_cond, NULL);
 
   if (attrs)
   {
@@ -149,10 +218,14 @@ _papplJobCreate(
   ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-uuid", NULL, job_uuid);
   ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri", NULL, job_printer_uri);
 
-  cupsArrayAdd(printer->all_jobs, job);
+  add_job_index(printer, job);
 
   if (!job_id)
-    cupsArrayAdd(printer->active_jobs, job);
+  {
+    _papplPrinterAddJobNoLock(printer, job);
+
+    _papplSystemAddEventNoLock(printer->system, printer, job, PAPPL_EVENT_JOB_CREATED | PAPPL_EVENT_JOB_STATE_CHANGED, "Job created.");
+  }
 
   pthread_rwlock_unlock(&printer->rwlock);
 
@@ -165,21 +238,135 @@ _papplJobCreate(
 //
 // '_papplJobDelete()' - Remove a job from the system and free its memory.
 //
+// The job must already be removed from the printer's lists.  The memory is
+// freed once any other threads that retained the job release it.
+//
 
 void
 _papplJobDelete(pappl_job_t *job)	// I - Job
 {
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Removing job from history.");
 
-  ippDelete(job->attrs);
-
-  free(job->message);
-
   // Only remove the job file (document) if the job is in a terminating state...
   if (job->state >= IPP_JSTATE_CANCELED)
     _papplJobRemoveFile(job);
 
-  free(job);
+  _papplJobRelease(job);
+}
+
+
+//
+// '_papplJobExpandNoLock()' - Restore the attributes of a compacted job.
+//
+// The attributes freed by compaction are added back to the job's attributes
+// and stay there until the job is deleted.  The caller must hold the job's
+// write lock.
+//
+
+void
+_papplJobExpandNoLock(pappl_job_t *job)	// I - Job
+{
+  ipp_t	*attrs;				// Full attributes
+
+
+  if (!job->is_compacted || (attrs = _papplJobUnpackNoLock(job)) == NULL)
+    return;
+
+  ippCopyAttributes(job->attrs, attrs, 0, (ipp_copycb_t)expand_cb, NULL);
+  ippDelete(attrs);
+
+  job->is_compacted = false;
+}
+
+
+//
+// 'papplJobMapFile()'' - Map the job's document file into memory.
+//
+// This function returns a read-only mapping of the current document file for
+// use by file filter callbacks.  The "length" argument receives the size of
+// the document in bytes.  The mapping is advised for sequential access and
+// must be released with @link papplJobUnmapFile@.
+//
+// `NULL` is returned if the document cannot be opened or is empty.
+//
+// @since PAPPL 1.1@
+//
+
+const void *				// O - Document data or `NULL` on error
+papplJobMapFile(pappl_job_t *job,	// I - Job
+                size_t      *length)	// O - Length of document data
+{
+  int		fd;			// Document file
+  struct stat	fileinfo;		// File information
+  void		*map;			// Mapped document
+
+
+  if (length)
+    *length = 0;
+
+  if (!job || !job->filename || !length)
+    return (NULL);
+
+  if ((fd = open(job->filename, O_RDONLY | O_CLOEXEC | O_BINARY)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open print file '%s': %s", job->filename, strerror(errno));
+    return (NULL);
+  }
+
+  if (fstat(fd, &fileinfo))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to get size of print file '%s': %s", job->filename, strerror(errno));
+    close(fd);
+    return (NULL);
+  }
+  else if (fileinfo.st_size <= 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Print file '%s' is empty.", job->filename);
+    close(fd);
+    return (NULL);
+  }
+
+#if _WIN32
+  // No mmap, so read the whole file...
+  if ((map = malloc((size_t)fileinfo.st_size)) != NULL)
+  {
+    char	*ptr;			// Pointer into buffer
+    size_t	remaining;		// Bytes remaining
+    ssize_t	bytes;			// Bytes read
+
+    for (ptr = (char *)map, remaining = (size_t)fileinfo.st_size; remaining > 0; ptr += bytes, remaining -= (size_t)bytes)
+    {
+      if ((bytes = read(fd, ptr, (unsigned)remaining)) <= 0)
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read print file '%s': %s", job->filename, bytes < 0 ? strerror(errno) : "Unexpected end of file.");
+        free(map);
+        map = NULL;
+        break;
+      }
+    }
+  }
+  else
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for print file '%s': %s", job->filename, strerror(errno));
+
+#else
+  if ((map = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to map print file '%s': %s", job->filename, strerror(errno));
+    map = NULL;
+  }
+  else
+  {
+    // Filters read documents from front to back...
+    madvise(map, (size_t)fileinfo.st_size, MADV_SEQUENTIAL);
+  }
+#endif // _WIN32
+
+  close(fd);
+
+  if (map)
+    *length = (size_t)fileinfo.st_size;
+
+  return (map);
 }
 
 
@@ -290,6 +477,43 @@ papplJobOpenFile(
 }
 
 
+//
+// '_papplJobRelease()' - Release a reference to a job.
+//
+// The job is freed when the last reference is released.
+//
+
+void
+_papplJobRelease(pappl_job_t *job)	// I - Job
+{
+  int	i;				// Looping var
+
+
+  if (!job || _PAPPL_ATOMIC_ADD(&job->refcount, -1) > 1)
+    return;
+
+  ippDelete(job->attrs);
+  free(job->packed);
+
+  for (i = 1; i < job->num_documents; i ++)
+  {
+    free(job->documents[i - 1].filename);
+    free(job->documents[i - 1].format);
+  }
+
+  free(job->documents);
+
+  pthread_cond_destroy(&job->doc_cond);
+  pthread_mutex_destroy(&job->doc_mutex);
+
+  free(job->message);
+
+  papplJobDeletePrintOptions(job->options);
+
+  free(job);
+}
+
+
 //
 // '_papplJobRemoveFile()' - Remove a file in spool directory
 //
@@ -297,6 +521,7 @@ papplJobOpenFile(
 void
 _papplJobRemoveFile(pappl_job_t *job)	// I - Job
 {
+  int	i;				// Looping var
   size_t dirlen = strlen(job->system->directory);
 					// Length of spool directory
 
@@ -307,19 +532,79 @@ _papplJobRemoveFile(pappl_job_t *job)	// I - Job
 
   free(job->filename);
   job->filename = NULL;
+
+  // Memory spool files go away when closed...
+  if (job->spool_fd >= 0)
+  {
+    close(job->spool_fd);
+    job->spool_fd = -1;
+
+    _PAPPL_ATOMIC_ADD(&job->system->spool_memory, -job->spool_size);
+    job->spool_size = 0;
+  }
+
+  // Remove any documents that were received but not printed - the formats are
+  // kept until the job is freed since "job->format" may point to one...
+  pthread_mutex_lock(&job->doc_mutex);
+
+  for (i = 1; i < job->num_documents; i ++)
+  {
+    if (job->documents[i - 1].filename)
+    {
+      unlink(job->documents[i - 1].filename);
+      free(job->documents[i - 1].filename);
+      job->documents[i - 1].filename = NULL;
+    }
+  }
+
+  job->more_documents = false;
+
+  pthread_mutex_unlock(&job->doc_mutex);
+}
+
+
+//
+// '_papplJobRetain()' - Retain a reference to a job.
+//
+// The caller must hold the printer lock or another reference to the job.
+// Retained jobs remain valid after the printer lock is released and must be
+// released with @link _papplJobRelease@.
+//
+
+pappl_job_t *				// O - Job
+_papplJobRetain(pappl_job_t *job)	// I - Job
+{
+  if (job)
+    _PAPPL_ATOMIC_ADD(&job->refcount, 1);
+
+  return (job);
 }
 
 
 //
 // '_papplJobSubmitFile()' - Submit a file for printing.
 //
+// The first document queues the job for processing.  Later documents are
+// handed to the job's processing thread, which prints them in order after the
+// documents before them.  The "last" argument tells the processing thread
+// whether to wait for more documents.
+//
+// `false` is returned if the document could not be queued, in which case the
+// file has been removed and, for the first document, the job aborted.
+//
 
-void
+bool					// O - `true` on success, `false` on error
 _papplJobSubmitFile(
     pappl_job_t *job,			// I - Job
-    const char  *filename)		// I - Filename
+    const char  *filename,		// I - Filename
+    const char  *format,		// I - Document format or `NULL` to auto-type
+    bool        last)			// I - Last document in job?
 {
-  if (!job->format)
+  _pappl_jdoc_t	*doc;			// New document
+  bool		ret = false;		// Return value
+
+
+  if (!format)
   {
     // Open the file
     unsigned char	header[8192];	// First 8k bytes of file
@@ -334,223 +619,1535 @@ _papplJobSubmitFile(
       close(fd);
 
       if (!memcmp(header, "%PDF", 4))
-	job->format = "application/pdf";
+	format = "application/pdf";
       else if (!memcmp(header, "%!", 2))
-	job->format = "application/postscript";
+	format = "application/postscript";
       else if (!memcmp(header, "\377\330\377", 3) && header[3] >= 0xe0 && header[3] <= 0xef)
-	job->format = "image/jpeg";
+	format = "image/jpeg";
       else if (!memcmp(header, "\211PNG", 4))
-	job->format = "image/png";
+	format = "image/png";
       else if (!memcmp(header, "RaS2PwgR", 8))
-	job->format = "image/pwg-raster";
+	format = "image/pwg-raster";
       else if (!memcmp(header, "UNIRAST", 8))
-	job->format = "image/urf";
+	format = "image/urf";
       else if (job->system->mime_cb)
-	job->format = (job->system->mime_cb)(header, (size_t)headersize, job->system->mime_cbdata);
+	format = (job->system->mime_cb)(header, (size_t)headersize, job->system->mime_cbdata);
     }
   }
 
-  if (!job->format)
+  if (!format)
   {
     // Guess the format using the filename extension...
     const char *ext = strrchr(filename, '.');
 				// Extension on filename
 
     if (!ext)
-      job->format = job->printer->driver_data.format;
+      format = job->printer->driver_data.format;
     else if (!strcmp(ext, ".jpg") || !strcmp(ext, ".jpeg"))
-      job->format = "image/jpeg";
+      format = "image/jpeg";
     else if (!strcmp(ext, ".png"))
-      job->format = "image/png";
+      format = "image/png";
     else if (!strcmp(ext, ".pwg"))
-      job->format = "image/pwg-raster";
+      format = "image/pwg-raster";
     else if (!strcmp(ext, ".urf"))
-      job->format = "image/urf";
+      format = "image/urf";
     else if (!strcmp(ext, ".txt"))
-      job->format = "text/plain";
+      format = "text/plain";
     else if (!strcmp(ext, ".pdf"))
-      job->format = "application/pdf";
+      format = "application/pdf";
     else if (!strcmp(ext, ".ps"))
-      job->format = "application/postscript";
+      format = "application/postscript";
+    else
+      format = job->printer->driver_data.format;
+  }
+
+  pthread_mutex_lock(&job->doc_mutex);
+
+  if (job->num_documents > 0)
+  {
+    // Queue a later document for the processing thread...
+    if (!job->more_documents)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Document received after the job was closed.");
+      unlink(filename);
+    }
+    else if ((doc = realloc(job->documents, (size_t)job->num_documents * sizeof(_pappl_jdoc_t))) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document: %s", strerror(errno));
+      unlink(filename);
+
+      job->more_documents = false;
+    }
     else
-      job->format = job->printer->driver_data.format;
+    {
+      job->documents = doc;
+      doc += job->num_documents - 1;
+
+      if ((doc->filename = strdup(filename)) != NULL && (doc->format = strdup(format)) != NULL)
+      {
+	job->num_documents ++;
+	job->more_documents = !last;
+	ret                 = true;
+
+	papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Queued document #%d, format \"%s\".", job->num_documents, format);
+      }
+      else
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate document filename.");
+	unlink(filename);
+	free(doc->filename);
+
+	job->more_documents = false;
+      }
+    }
+
+    pthread_cond_broadcast(&job->doc_cond);
+    pthread_mutex_unlock(&job->doc_mutex);
+    return (ret);
   }
 
+  job->num_documents  = 1;
+  job->more_documents = !last;
+
+  pthread_mutex_unlock(&job->doc_mutex);
+
   // Save the print file information...
+  job->format = format;
+
   if ((job->filename = strdup(filename)) != NULL)
   {
     // Process the job...
-    job->state = IPP_JSTATE_PENDING;
+    pthread_rwlock_wrlock(&job->printer->rwlock);
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_PENDING);
+    job->trace_queued = _PAPPL_TRACE_BEGIN(job);
+    _papplPrinterAddPendingJobNoLock(job->printer, job);
+    _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job queued.");
+    pthread_rwlock_unlock(&job->printer->rwlock);
 
     _papplPrinterCheckJobs(job->printer);
+
+    ret = true;
   }
   else
   {
     // Abort the job...
-    job->state     = IPP_JSTATE_ABORTED;
-    job->completed = time(NULL);
+    _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_ABORTED);
 
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate filename.");
     unlink(filename);
 
     pthread_rwlock_wrlock(&job->printer->rwlock);
-    cupsArrayRemove(job->printer->active_jobs, job);
-    cupsArrayAdd(job->printer->completed_jobs, job);
+    _papplPrinterCompleteJobNoLock(job->printer, job);
     pthread_rwlock_unlock(&job->printer->rwlock);
 
     if (!job->system->clean_time)
+    {
       job->system->clean_time = time(NULL) + 60;
+      _papplSystemWakeup(job->system);
+    }
   }
+
+  return (ret);
 }
 
 
 //
-// '_papplPrinterCheckJobs()' - Check for new jobs to process.
+// 'papplJobUnmapFile()'' - Release a document mapping.
+//
+// This function releases a mapping returned by @link papplJobMapFile@.
+//
+// @since PAPPL 1.1@
 //
 
 void
-_papplPrinterCheckJobs(
-    pappl_printer_t *printer)		// I - Printer
+papplJobUnmapFile(pappl_job_t *job,	// I - Job
+                  const void  *data,	// I - Document data
+                  size_t      length)	// I - Length of document data
 {
-  pappl_job_t	*job;			// Current job
+  (void)job;
 
+  if (!data)
+    return;
 
-  papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Checking for new jobs to process.");
+#if _WIN32
+  (void)length;
 
-  if (printer->processing_job)
-  {
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is already processing job %d.", printer->processing_job->job_id);
-    return;
-  }
-  else if (printer->is_deleted)
-  {
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is being deleted.");
-    return;
-  }
-  else if (printer->state == IPP_PSTATE_STOPPED || printer->is_stopped)
-  {
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is stopped.");
-    return;
-  }
+  free((void *)data);
+#else
+  munmap((void *)data, length);
+#endif // _WIN32
+}
 
-  pthread_rwlock_wrlock(&printer->rwlock);
 
-  // Enumerate the jobs.  Since we have a writer (exclusive) lock, we are the
-  // only thread enumerating and can use cupsArrayFirst/Last...
+//
+// '_papplJobUnpackNoLock()' - Decode the full attributes of a compacted job.
+//
+// The caller must hold the job's read or write lock and free the returned
+// attributes using `ippDelete`.
+//
 
-  for (job = (pappl_job_t *)cupsArrayFirst(printer->active_jobs); job; job = (pappl_job_t *)cupsArrayNext(printer->active_jobs))
-  {
-    if (job->state == IPP_JSTATE_PENDING)
-    {
-      pthread_t	t;			// Thread
+ipp_t *					// O - Full attributes or `NULL` if not compacted
+_papplJobUnpackNoLock(pappl_job_t *job)	// I - Job
+{
+  _pappl_jpack_t	pack;		// Encoded attributes
+  ipp_t			*attrs;		// Full attributes
 
-      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
 
-      if (pthread_create(&t, NULL, (void *(*)(void *))_papplJobProcess, job))
-      {
-	job->state     = IPP_JSTATE_ABORTED;
-	job->completed = time(NULL);
+  if (!job->is_compacted || (attrs = ippNew()) == NULL)
+    return (NULL);
 
-	cupsArrayRemove(printer->active_jobs, job);
-	cupsArrayAdd(printer->completed_jobs, job);
+  pack.data   = job->packed;
+  pack.length = job->packed_len;
+  pack.size   = job->packed_len;
+  pack.offset = 0;
 
-	if (!printer->system->clean_time)
-	  printer->system->clean_time = time(NULL) + 60;
-      }
-      else
-	pthread_detach(t);
-      break;
-    }
+  if (ippReadIO(&pack, (ipp_iocb_t)pack_read_cb, 1, NULL, attrs) != IPP_STATE_DATA)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to decode compacted job attributes.");
+    ippDelete(attrs);
+    return (NULL);
   }
 
-  if (!job)
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
-
-  pthread_rwlock_unlock(&printer->rwlock);
+  return (attrs);
 }
 
 
 //
-// 'papplPrinterFindJob()' - Find a job.
+// '_papplPrinterAddJobNoLock()' - Add a job to the active or completed jobs list.
 //
-// This function finds a job submitted to a printer using its integer ID value.
+// Both lists are kept newest first.  New jobs always go at the head of the
+// active list and jobs loaded from the state file (which is written newest
+// first) go at the tail, so neither case has to walk the list.  Pending jobs
+// are also added to the pending jobs heap.
 //
 
-pappl_job_t *				// O - Job or `NULL` if not found
-papplPrinterFindJob(
+void
+_papplPrinterAddJobNoLock(
     pappl_printer_t *printer,		// I - Printer
-    int             job_id)		// I - Job ID
+    pappl_job_t     *job)		// I - Job
 {
-  pappl_job_t		key,		// Job search key
-			*job;		// Matching job, if any
+  _pappl_joblist_t	*list;		// Jobs list
+  pappl_job_t		*current;	// Current job in list
 
 
-  key.job_id = job_id;
+  list = job->state < IPP_JSTATE_STOPPED ? &printer->active_jobs : &printer->completed_jobs;
 
-  pthread_rwlock_rdlock(&(printer->rwlock));
-  job = (pappl_job_t *)cupsArrayFind(printer->all_jobs, &key);
-  pthread_rwlock_unlock(&(printer->rwlock));
+  if (!list->first || job->job_id > list->first->job_id)
+  {
+    // Add to the head of the list...
+    job->prev = NULL;
+    job->next = list->first;
 
-  return (job);
+    if (list->first)
+      list->first->prev = job;
+    else
+      list->last = job;
+
+    list->first = job;
+  }
+  else
+  {
+    // Insert after the nearest newer job, searching from the tail...
+    for (current = list->last; current->job_id < job->job_id; current = current->prev);
+
+    job->prev = current;
+    job->next = current->next;
+
+    if (current->next)
+      current->next->prev = job;
+    else
+      list->last = job;
+
+    current->next = job;
+  }
+
+  list->count ++;
+
+  if (job->state == IPP_JSTATE_PENDING)
+    _papplPrinterAddPendingJobNoLock(printer, job);
 }
 
 
 //
-// 'papplSystemCleanJobs()' - Clean out old (completed) jobs.
+// '_papplPrinterAddPendingJobNoLock()' - Add a job to the pending jobs heap.
 //
-// This function deletes all old (completed) jobs above the limit set by the
-// @link papplPrinterSetMaxCompletedJobs@ function.  The level may temporarily
-// exceed this limit if the jobs were completed within the last 60 seconds.
+// The pending jobs heap orders the printer's pending jobs by their scheduling
+// score so that `_papplPrinterCheckJobs` can start the next job without
+// walking the active jobs list.  The score is computed once here - priority
+// aging is folded into the score as an offset from the creation time, so the
+// relative order of two pending jobs never changes while they wait.
 //
-// > Note: This function is normally called automatically from the
-// > @link papplSystemRun@ function.
+// The job is aborted if the heap cannot be grown.
 //
 
 void
-papplSystemCleanJobs(
-    pappl_system_t *system)		// I - System
+_papplPrinterAddPendingJobNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
 {
-  int			i,		// Looping var
-			count;		// Number of printers
-  pappl_printer_t	*printer;	// Current printer
-  pappl_job_t		*job;		// Current job
-  time_t		cleantime;	// Clean time
+  if (job->pending_index)
+    return;
 
+  if (printer->num_pending >= printer->alloc_pending)
+  {
+    // Grow the heap...
+    pappl_job_t	**pending;		// New heap
+    int		alloc_pending = printer->alloc_pending ? 2 * printer->alloc_pending : 16;
+					// New allocation
 
-  cleantime = time(NULL) - 60;
+    if ((pending = realloc(printer->pending, (size_t)alloc_pending * sizeof(pappl_job_t *))) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for pending jobs: %s", strerror(errno));
 
-  pthread_rwlock_rdlock(&system->rwlock);
+      _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_ABORTED);
 
-  // Loop through the printers.
-  //
-  // Note: Cannot use cupsArrayFirst/Last since other threads might be
-  // enumerating the printers array.
+      _papplPrinterCompleteJobNoLock(printer, job);
+      return;
+    }
 
-  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
-  {
-    printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
+    printer->pending       = pending;
+    printer->alloc_pending = alloc_pending;
+  }
+
+  job->score = score_job(printer, job);
+
+  printer->pending[printer->num_pending ++] = job;
+  move_pending(printer, printer->num_pending - 1);
+}
+
+
+//
+// '_papplPrinterCheckJobs()' - Check for new jobs to process.
+//
+
+void
+_papplPrinterCheckJobs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t	*job;			// Current job
+  int		started = 0;		// Number of jobs started
+
+
+  papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Checking for new jobs to process.");
+
+  if (printer->num_processing_jobs >= printer->max_processing_jobs)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is already processing %d job(s).", printer->num_processing_jobs);
+    return;
+  }
+  else if (printer->is_deleted)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is being deleted.");
+    return;
+  }
+  else if (printer->state == IPP_PSTATE_STOPPED || printer->is_stopped)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is stopped.");
+    return;
+  }
 
-    if (cupsArrayCount(printer->completed_jobs) == 0 || printer->max_completed_jobs <= 0)
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  // Start the highest scoring pending jobs, as many as the printer can process
+  // (another thread may have started jobs while we were waiting for the
+  // lock)...
+  while (printer->num_pending > 0 && printer->num_processing_jobs < printer->max_processing_jobs)
+  {
+    job = printer->pending[0];
+
+    remove_pending(printer, job);
+
+    if (job->state != IPP_JSTATE_PENDING || job->is_scheduled)
       continue;
 
-    pthread_rwlock_wrlock(&printer->rwlock);
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
 
-    // Enumerate the jobs.  Since we have a writer (exclusive) lock, we are the
-    // only thread enumerating and can use cupsArrayFirst/Last...
+    // Reserve the printer for this job until a worker thread picks it up.
+    // The first job gets the printer's device connection...
+    job->is_scheduled = true;
+    printer->num_processing_jobs ++;
 
-    for (job = (pappl_job_t *)cupsArrayFirst(printer->completed_jobs); job; job = (pappl_job_t *)cupsArrayNext(printer->completed_jobs))
+    if (!printer->processing_job)
+      printer->processing_job = job;
+
+    if (!queue_job(job))
     {
-      if (job->completed && job->completed < cleantime && cupsArrayCount(printer->completed_jobs) > printer->max_completed_jobs)
+      _papplPrinterUnscheduleJobNoLock(printer, job);
+
+      _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_ABORTED);
+
+      _papplPrinterCompleteJobNoLock(printer, job);
+
+      if (!printer->system->clean_time)
       {
-	cupsArrayRemove(printer->completed_jobs, job);
-	cupsArrayRemove(printer->all_jobs, job);
+	printer->system->clean_time = time(NULL) + 60;
+	_papplSystemWakeup(printer->system);
+      }
+      break;
+    }
+
+    started ++;
+  }
+
+  if (!started)
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
+
+  pthread_rwlock_unlock(&printer->rwlock);
+}
+
+
+//
+// '_papplPrinterCompleteJobNoLock()' - Move a job to the completed jobs list.
+//
+// The completed jobs list is ordered by completion, most recent first, so the
+// jobs that have been in the history longest are always at the tail.  The job
+// is also recorded in the job journal, if enabled.
+//
+
+void
+_papplPrinterCompleteJobNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  _pappl_joblist_t	*list = &printer->completed_jobs;
+					// Completed jobs list
+
+
+  remove_pending(printer, job);
+  unlink_job(&printer->active_jobs, job);
+
+  job->prev = NULL;
+  job->next = list->first;
+
+  if (list->first)
+    list->first->prev = job;
+  else
+    list->last = job;
+
+  list->first = job;
+  list->count ++;
+
+  // Update the job metrics for the printer...
+  if (job->state >= IPP_JSTATE_CANCELED && job->state <= IPP_JSTATE_COMPLETED)
+  {
+    printer->job_counts[job->state - IPP_JSTATE_CANCELED] ++;
+
+    if (job->processing && job->completed >= job->processing)
+      printer->job_secs[job->state - IPP_JSTATE_CANCELED] += (size_t)(job->completed - job->processing);
+  }
+
+  _papplJobWriteJournal(job);
+
+  // Let the socket print thread accept new jobs and a pending shutdown see
+  // the job count change...
+  _papplPrinterWakeup(printer);
+
+  if (printer->system->shutdown_time)
+    _papplSystemWakeup(printer->system);
+}
+
+
+//
+// 'papplPrinterFindJob()' - Find a job.
+//
+// This function finds a job submitted to a printer using its integer ID value.
+//
+
+pappl_job_t *				// O - Job or `NULL` if not found
+papplPrinterFindJob(
+    pappl_printer_t *printer,		// I - Printer
+    int             job_id)		// I - Job ID
+{
+  pappl_job_t		*job;		// Matching job, if any
+
+
+  pthread_rwlock_rdlock(&(printer->rwlock));
+
+  if (printer->job_hash)
+  {
+    for (job = printer->job_hash[(size_t)job_id & (printer->job_hash_size - 1)]; job; job = job->hash_next)
+    {
+      if (job->job_id == job_id)
+        break;
+    }
+  }
+  else
+  {
+    // No hash table (out of memory), do a linear search...
+    for (job = printer->all_jobs.first; job; job = job->all_next)
+    {
+      if (job->job_id == job_id)
+        break;
+    }
+  }
+
+  pthread_rwlock_unlock(&(printer->rwlock));
+
+  return (job);
+}
+
+
+//
+// '_papplPrinterFindUserJobsNoLock()' - Find the jobs list for a user.
+//
+// The returned list is linked using the `user_next` and `user_prev` members
+// and lists all of the user's jobs, newest first.
+//
+
+_pappl_joblist_t *			// O - Jobs list or `NULL` if none
+_papplPrinterFindUserJobsNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    const char      *username)		// I - Username
+{
+  _pappl_userjobs_t	key,		// Search key
+			*u;		// Matching user
+
+
+  key.username = (char *)username;
+
+  if ((u = (_pappl_userjobs_t *)cupsArrayFind(printer->user_jobs, &key)) != NULL)
+    return (&u->jobs);
+  else
+    return (NULL);
+}
+
+
+//
+// '_papplPrinterSortPendingJobsNoLock()' - Recompute the scores of all pending
+//                                          jobs.
+//
+// This is called after the scheduling policy or callback changes.
+//
+
+void
+_papplPrinterSortPendingJobsNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  int		i,			// Looping var
+		count = printer->num_pending;
+					// Number of pending jobs
+  pappl_job_t	*job;			// Current job
+
+
+  // Rebuild the heap in place, adding each job back with its new score...
+  for (i = 0, printer->num_pending = 0; i < count; i ++)
+  {
+    job        = printer->pending[i];
+    job->score = score_job(printer, job);
+
+    printer->pending[printer->num_pending ++] = job;
+    move_pending(printer, printer->num_pending - 1);
+  }
+}
+
+
+//
+// '_papplPrinterUnscheduleJobNoLock()' - Release the processing slot reserved
+//                                        for a job.
+//
+// The printer's writer lock must be held.
+//
+
+void
+_papplPrinterUnscheduleJobNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  if (!job->is_scheduled)
+    return;
+
+  job->is_scheduled = false;
+  printer->num_processing_jobs --;
+
+  if (printer->processing_job == job)
+  {
+    // Spooled jobs waiting for the device get it before any pending job, in
+    // the order they finished spooling...
+    if ((printer->processing_job = (pappl_job_t *)cupsArrayFirst(printer->spool_jobs)) != NULL)
+    {
+      cupsArrayRemove(printer->spool_jobs, printer->processing_job);
+
+      pthread_mutex_lock(&printer->spool_mutex);
+      pthread_cond_broadcast(&printer->spool_cond);
+      pthread_mutex_unlock(&printer->spool_mutex);
+    }
+    else
+    {
+      // Status updates and idle device timers resume now...
+      _papplSystemWakeup(printer->system);
+    }
+  }
+}
+
+
+//
+// 'papplSystemCleanJobs()' - Clean out old (completed) jobs.
+//
+// This function deletes all old (completed) jobs above the limit set by the
+// @link papplPrinterSetMaxCompletedJobs@ function.  The level may temporarily
+// exceed this limit if the jobs were completed within the last 60 seconds.
+//
+// Expired jobs are detached from the printer in small batches and their
+// attributes and spool files are freed after the printer lock is released, so
+// other threads can keep using the printer during a large cleanup.  Jobs that
+// are kept have their attributes compacted so that a long job history uses
+// less memory.
+//
+// > Note: This function is normally called automatically from a background
+// > thread started by the @link papplSystemRun@ function.
+//
+
+void
+papplSystemCleanJobs(
+    pappl_system_t *system)		// I - System
+{
+  int			i,		// Looping var
+			count,		// Number of printers
+			jcount;		// Number of jobs in batch
+  pappl_printer_t	*printer;	// Current printer
+  pappl_job_t		*job,		// Current job
+			*prev,		// Previous (newer) job
+			*batch;		// Detached jobs
+  time_t		cleantime,	// Clean time
+			nexttime = 0;	// Next time to clean
+
+
+  system->clean_time = 0;
+  cleantime          = time(NULL) - 60;
+
+  pthread_rwlock_rdlock(&system->printers_rwlock);
+
+  // Loop through the printers.
+  //
+  // Note: Cannot use cupsArrayFirst/Last since other threads might be
+  // enumerating the printers array.
+
+  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
+  {
+    printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
+
+    if (printer->completed_jobs.count == 0)
+      continue;
+
+    // Compact jobs that completed more than a minute ago and have not been
+    // compacted by an earlier pass...
+    pthread_rwlock_wrlock(&printer->rwlock);
+
+    for (job = printer->completed_jobs.first; job; job = job->next)
+    {
+      if (job->packed)
+        continue;
+
+      if (job->completed >= cleantime)
+      {
+	if (!nexttime || (job->completed + 60) < nexttime)
+	  nexttime = job->completed + 60;
+	continue;
+      }
+
+      // Skip jobs that are busy, they just stay uncompacted...
+      if (!pthread_rwlock_trywrlock(&job->rwlock))
+      {
+        compact_job(job);
+        pthread_rwlock_unlock(&job->rwlock);
       }
-      else
-	break;
     }
 
     pthread_rwlock_unlock(&printer->rwlock);
+
+    if (printer->max_completed_jobs <= 0)
+      continue;
+
+    do
+    {
+      pthread_rwlock_wrlock(&printer->rwlock);
+
+      // Detach a batch of jobs from the oldest completion time...
+      for (job = printer->completed_jobs.last, batch = NULL, jcount = 0; job && jcount < _PAPPL_JOB_CLEAN_BATCH; job = prev, jcount ++)
+      {
+	prev = job->prev;
+
+	if (printer->completed_jobs.count <= printer->max_completed_jobs)
+	  break;
+
+	if (!job->completed || job->completed >= cleantime)
+	{
+	  // Look again when this job expires...
+	  if (job->completed && (!nexttime || (job->completed + 60) < nexttime))
+	    nexttime = job->completed + 60;
+	  break;
+	}
+
+	unlink_job(&printer->completed_jobs, job);
+	remove_job_index(printer, job);
+
+	job->next = batch;
+	batch     = job;
+      }
+
+      pthread_rwlock_unlock(&printer->rwlock);
+
+      // Then free the jobs without holding the printer lock...
+      for (job = batch; job; job = batch)
+      {
+        batch = job->next;
+        _papplJobDelete(job);
+      }
+    }
+    while (jcount == _PAPPL_JOB_CLEAN_BATCH);
+  }
+
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
+  if (nexttime && (!system->clean_time || nexttime < system->clean_time))
+    system->clean_time = nexttime;
+}
+
+
+//
+// '_papplSystemCleanJobs()' - Clean out old jobs in the background.
+//
+// This function starts a thread to run @link papplSystemCleanJobs@ unless one
+// is already running.
+//
+
+void
+_papplSystemCleanJobs(
+    pappl_system_t *system)		// I - System
+{
+  pthread_t	tid;			// Thread ID
+
+
+  pthread_mutex_lock(&system->job_mutex);
+
+  if (!system->clean_active && !system->job_threads_stop)
+  {
+    if (pthread_create(&tid, NULL, (void *(*)(void *))run_clean_thread, system))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create clean jobs thread: %s", strerror(errno));
+    }
+    else
+    {
+      pthread_detach(tid);
+      system->clean_active = true;
+    }
+  }
+
+  pthread_mutex_unlock(&system->job_mutex);
+}
+
+
+//
+// 'papplSystemGetMaxJobThreads()' - Get the maximum number of job threads.
+//
+// This function gets the maximum number of threads used to process jobs.  Jobs
+// are queued until a thread is available.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum number of job threads or `0` for no limit
+papplSystemGetMaxJobThreads(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->job_mutex);
+    ret = system->max_job_threads;
+    pthread_mutex_unlock(&system->job_mutex);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  return (ret);
 }
+
+
+//
+// 'papplSystemSetMaxJobThreads()' - Set the maximum number of job threads.
+//
+// This function sets the maximum number of threads used to process jobs for
+// all printers.  Jobs are queued until a thread is available.  Set the maximum
+// to `0` to disable the limit.
+//
+// Since each printer processes one job at a time, the number of job threads
+// never exceeds the number of printers.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxJobThreads(
+    pappl_system_t *system,		// I - System
+    int            max_threads)		// I - Maximum number of job threads or `0` for no limit
+{
+  if (system)
+  {
+    pthread_mutex_lock(&system->job_mutex);
+    system->max_job_threads = max_threads > 0 ? max_threads : 0;
+    pthread_mutex_unlock(&system->job_mutex);
+  }
+}
+
+
+//
+// '_papplSystemStopJobThreads()' - Stop the job worker threads.
+//
+// This function waits for all job worker threads to exit.
+//
+
+void
+_papplSystemStopJobThreads(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->job_mutex);
+
+  system->job_threads_stop = true;
+  pthread_cond_broadcast(&system->job_cond);
+
+  while (system->num_job_threads > 0 || system->clean_active)
+    pthread_cond_wait(&system->job_cond, &system->job_mutex);
+
+  cupsArrayClear(system->job_queue);
+
+  pthread_mutex_unlock(&system->job_mutex);
+}
+
+
+//
+// 'add_job_index()' - Add a job to the all jobs, user jobs, and job-id indices.
+//
+
+static void
+add_job_index(pappl_printer_t *printer,	// I - Printer
+              pappl_job_t     *job)	// I - Job
+{
+  _pappl_joblist_t	*list = &printer->all_jobs;
+					// All jobs list
+  pappl_job_t		*current,	// Current job
+			**bucket;	// Hash bucket
+  size_t		hash_size;	// New hash table size
+  _pappl_userjobs_t	key,		// Search key for user
+			*u;		// Jobs for user
+
+
+  // Add the job to the user's list, newest first...
+  if (job->username)
+  {
+    if (!printer->user_jobs)
+      printer->user_jobs = cupsArrayNew3((cups_array_func_t)compare_user_jobs, NULL, NULL, 0, NULL, (cups_afree_func_t)free_user_jobs);
+
+    key.username = (char *)job->username;
+
+    if ((u = (_pappl_userjobs_t *)cupsArrayFind(printer->user_jobs, &key)) == NULL && (u = (_pappl_userjobs_t *)calloc(1, sizeof(_pappl_userjobs_t))) != NULL)
+    {
+      if ((u->username = strdup(job->username)) == NULL)
+      {
+        free(u);
+        u = NULL;
+      }
+      else
+        cupsArrayAdd(printer->user_jobs, u);
+    }
+
+    if (u)
+    {
+      if (!u->jobs.first || job->job_id > u->jobs.first->job_id)
+      {
+	job->user_prev = NULL;
+	job->user_next = u->jobs.first;
+
+	if (u->jobs.first)
+	  u->jobs.first->user_prev = job;
+	else
+	  u->jobs.last = job;
+
+	u->jobs.first = job;
+      }
+      else
+      {
+	for (current = u->jobs.last; current->job_id < job->job_id; current = current->user_prev);
+
+	job->user_prev = current;
+	job->user_next = current->user_next;
+
+	if (current->user_next)
+	  current->user_next->user_prev = job;
+	else
+	  u->jobs.last = job;
+
+	current->user_next = job;
+      }
+
+      u->jobs.count ++;
+    }
+  }
+
+  // Add the job to the list, newest first...
+  if (!list->first || job->job_id > list->first->job_id)
+  {
+    job->all_prev = NULL;
+    job->all_next = list->first;
+
+    if (list->first)
+      list->first->all_prev = job;
+    else
+      list->last = job;
+
+    list->first = job;
+  }
+  else
+  {
+    for (current = list->last; current->job_id < job->job_id; current = current->all_prev);
+
+    job->all_prev = current;
+    job->all_next = current->all_next;
+
+    if (current->all_next)
+      current->all_next->all_prev = job;
+    else
+      list->last = job;
+
+    current->all_next = job;
+  }
+
+  list->count ++;
+
+  // Then add it to the hash table, growing the table as needed to keep the
+  // chains short...
+  if ((size_t)list->count > printer->job_hash_size)
+  {
+    hash_size = printer->job_hash_size ? 2 * printer->job_hash_size : _PAPPL_JOB_HASH_SIZE;
+
+    if ((bucket = calloc(hash_size, sizeof(pappl_job_t *))) != NULL)
+    {
+      free(printer->job_hash);
+
+      printer->job_hash      = bucket;
+      printer->job_hash_size = hash_size;
+
+      for (current = list->first; current; current = current->all_next)
+      {
+        bucket             = printer->job_hash + ((size_t)current->job_id & (hash_size - 1));
+        current->hash_next = *bucket;
+        *bucket            = current;
+      }
+
+      return;
+    }
+  }
+
+  if (printer->job_hash)
+  {
+    bucket         = printer->job_hash + ((size_t)job->job_id & (printer->job_hash_size - 1));
+    job->hash_next = *bucket;
+    *bucket        = job;
+  }
+}
+
+
+//
+// 'compact_job()' - Free the attributes a completed job no longer needs.
+//
+// The full attribute set is encoded into a single buffer along with the job's
+// name, owner, and format strings, and only the job description attributes
+// that Get-Jobs and the web interface report are kept as IPP attributes.
+// Get-Job-Attributes decodes the buffer when needed and
+// @link papplJobGetAttribute@ restores the full attributes.  The caller must
+// hold the job's write lock.
+//
+
+static void
+compact_job(pappl_job_t *job)		// I - Job
+{
+  ipp_t			*attrs;		// Compacted attributes
+  _pappl_raset_t	*ra;		// Attributes to keep
+  _pappl_jpack_t	pack;		// Encoded attributes
+  size_t		namelen,	// Length of name
+			userlen,	// Length of username
+			formatlen;	// Length of format
+  unsigned char		*data;		// Buffer with strings
+  char			*strings;	// Pointer to strings in buffer
+  static const char * const keep[] =	// Attributes to keep
+  {
+    "document-format-detected",
+    "document-format-supplied",
+    "document-name-supplied",
+    "job-id",
+    "job-name",
+    "job-originating-user-name",
+    "job-printer-uri",
+    "job-uri",
+    "job-uuid"
+  };
+
+
+  // Encode the full attributes...
+  memset(&pack, 0, sizeof(pack));
+
+  ippSetState(job->attrs, IPP_STATE_IDLE);
+
+  if (ippWriteIO(&pack, (ipp_iocb_t)pack_write_cb, 1, NULL, job->attrs) != IPP_STATE_DATA)
+  {
+    free(pack.data);
+    return;
+  }
+
+  // Then add copies of the strings the job points to...
+  namelen   = job->name ? strlen(job->name) + 1 : 0;
+  userlen   = job->username ? strlen(job->username) + 1 : 0;
+  formatlen = job->format ? strlen(job->format) + 1 : 0;
+
+  if ((data = realloc(pack.data, pack.length + namelen + userlen + formatlen)) == NULL)
+  {
+    free(pack.data);
+    return;
+  }
+
+  // Copy the attributes to keep...
+  if ((ra = _papplRASetCreateNames((int)(sizeof(keep) / sizeof(keep[0])), keep)) == NULL)
+  {
+    free(data);
+    return;
+  }
+
+  if ((attrs = ippNew()) == NULL)
+  {
+    _papplRASetDelete(ra);
+    free(data);
+    return;
+  }
+
+  _papplCopyAttributes(attrs, job->attrs, ra, IPP_TAG_JOB, 0);
+  _papplRASetDelete(ra);
+
+  // Point the job's strings at the copies before freeing the originals...
+  strings = (char *)data + pack.length;
+
+  if (job->name)
+  {
+    memcpy(strings, job->name, namelen);
+    job->name = strings;
+    strings += namelen;
+  }
+
+  if (job->username)
+  {
+    memcpy(strings, job->username, userlen);
+    job->username = strings;
+    strings += userlen;
+  }
+
+  if (job->format)
+  {
+    memcpy(strings, job->format, formatlen);
+    job->format = strings;
+  }
+
+  ippDelete(job->attrs);
+  job->attrs        = attrs;
+  job->packed       = data;
+  job->packed_len   = pack.length;
+  job->is_compacted = true;
+}
+
+
+//
+// 'compare_user_jobs()' - Compare the usernames for two user jobs lists.
+//
+
+static int				// O - Result of comparison
+compare_user_jobs(
+    _pappl_userjobs_t *a,		// I - First user
+    _pappl_userjobs_t *b)		// I - Second user
+{
+  return (strcasecmp(a->username, b->username));
+}
+
+
+//
+// 'dequeue_job()' - Remove a job from the system job queue.
+//
+
+static bool				// O - `true` if removed, `false` if not queued
+dequeue_job(pappl_job_t *job)		// I - Job
+{
+  pappl_system_t *system = job->system;	// System
+  bool		 ret;			// Return value
+
+
+  pthread_mutex_lock(&system->job_mutex);
+  ret = cupsArrayRemove(system->job_queue, job) != 0;
+  pthread_mutex_unlock(&system->job_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'expand_cb()' - Only copy attributes that a compacted job no longer has.
+//
+
+static int				// O - 1 to copy, 0 to skip
+expand_cb(void            *context,	// I - Context (unused)
+          ipp_t           *dst,		// I - Destination attributes
+          ipp_attribute_t *attr)	// I - Source attribute
+{
+  const char	*name = ippGetName(attr);
+					// Attribute name
+
+
+  (void)context;
+
+  return (name && !ippFindAttribute(dst, name, IPP_TAG_ZERO));
+}
+
+
+//
+// 'free_user_jobs()' - Free a user jobs list.
+//
+
+static void
+free_user_jobs(_pappl_userjobs_t *u)	// I - User jobs list
+{
+  free(u->username);
+  free(u);
+}
+
+
+//
+// 'move_pending()' - Move a job in the pending jobs heap to its proper place.
+//
+
+static void
+move_pending(
+    pappl_printer_t *printer,		// I - Printer
+    int             index)		// I - Index of job in heap
+{
+  pappl_job_t	**heap = printer->pending,
+					// Pending jobs heap
+		*job = heap[index];	// Job to move
+  int		parent,			// Parent index
+		child;			// Child index
+
+
+  // Move up while the job runs before its parent...
+  while (index > 0)
+  {
+    parent = (index - 1) / 2;
+
+    if (!pending_before(job, heap[parent]))
+      break;
+
+    heap[index]                = heap[parent];
+    heap[index]->pending_index = index + 1;
+    index                      = parent;
+  }
+
+  // Then move down while a child runs before the job...
+  while ((child = 2 * index + 1) < printer->num_pending)
+  {
+    if ((child + 1) < printer->num_pending && pending_before(heap[child + 1], heap[child]))
+      child ++;
+
+    if (!pending_before(heap[child], job))
+      break;
+
+    heap[index]                = heap[child];
+    heap[index]->pending_index = index + 1;
+    index                      = child;
+  }
+
+  heap[index]        = job;
+  job->pending_index = index + 1;
+}
+
+
+//
+// 'pack_read_cb()' - Read encoded attributes from a buffer.
+//
+
+static ssize_t				// O - Number of bytes read
+pack_read_cb(_pappl_jpack_t *pack,	// I - Encoded attributes
+             ipp_uchar_t    *buffer,	// I - Read buffer
+             size_t         bytes)	// I - Number of bytes to read
+{
+  if (bytes > (pack->length - pack->offset))
+    bytes = pack->length - pack->offset;
+
+  memcpy(buffer, pack->data + pack->offset, bytes);
+  pack->offset += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'pack_write_cb()' - Write encoded attributes to a buffer.
+//
+
+static ssize_t				// O - Number of bytes written or -1 on error
+pack_write_cb(_pappl_jpack_t *pack,	// I - Encoded attributes
+              ipp_uchar_t    *buffer,	// I - Write buffer
+              size_t         bytes)	// I - Number of bytes to write
+{
+  if ((pack->length + bytes) > pack->size)
+  {
+    size_t		size;		// New size of buffer
+    unsigned char	*data;		// New buffer
+
+    for (size = pack->size ? pack->size : 1024; size < (pack->length + bytes); size *= 2);
+
+    if ((data = realloc(pack->data, size)) == NULL)
+      return (-1);
+
+    pack->data = data;
+    pack->size = size;
+  }
+
+  memcpy(pack->data + pack->length, buffer, bytes);
+  pack->length += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'pending_before()' - Determine whether a pending job runs before another.
+//
+// Jobs with higher scores run first, and jobs with the same score run in the
+// order they were submitted.
+//
+
+static bool				// O - `true` if "a" runs before "b"
+pending_before(pappl_job_t *a,		// I - First job
+               pappl_job_t *b)		// I - Second job
+{
+  if (a->score != b->score)
+    return (a->score > b->score);
+  else
+    return (a->job_id < b->job_id);
+}
+
+
+//
+// 'queue_job()' - Queue a job for processing by a worker thread.
+//
+// A new worker thread is started if all of the current threads are busy and
+// the limit has not been reached.  Otherwise the job waits for the next free
+// thread.
+//
+
+static bool				// O - `true` on success, `false` on error
+queue_job(pappl_job_t *job)		// I - Job
+{
+  pappl_system_t *system = job->system;	// System
+  bool		 ret = true;		// Return value
+  pthread_t	 tid;			// Thread ID
+
+
+  pthread_mutex_lock(&system->job_mutex);
+
+  cupsArrayAdd(system->job_queue, job);
+
+  if ((system->num_job_threads - system->busy_job_threads) >= cupsArrayCount(system->job_queue))
+  {
+    // Wake up an idle worker thread...
+    pthread_cond_signal(&system->job_cond);
+  }
+  else if (system->max_job_threads == 0 || system->num_job_threads < system->max_job_threads)
+  {
+    // Start another worker thread...
+    if (pthread_create(&tid, NULL, (void *(*)(void *))run_job_thread, system))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create job thread: %s", strerror(errno));
+
+      if (system->num_job_threads == 0)
+      {
+        // No thread will pick up this job...
+        cupsArrayRemove(system->job_queue, job);
+        ret = false;
+      }
+    }
+    else
+    {
+      pthread_detach(tid);
+      system->num_job_threads ++;
+    }
+  }
+  else
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Waiting for a job thread, %d of %d busy.", system->busy_job_threads, system->max_job_threads);
+  }
+
+  pthread_mutex_unlock(&system->job_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'remove_job_index()' - Remove a job from the all jobs, user jobs, and job-id
+//                        indices.
+//
+
+static void
+remove_job_index(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  pappl_job_t		**bucket;	// Hash bucket
+  _pappl_userjobs_t	key,		// Search key for user
+			*u;		// Jobs for user
+
+
+  key.username = (char *)job->username;
+
+  if (job->username && (u = (_pappl_userjobs_t *)cupsArrayFind(printer->user_jobs, &key)) != NULL && (job->user_prev || u->jobs.first == job))
+  {
+    if (job->user_prev)
+      job->user_prev->user_next = job->user_next;
+    else
+      u->jobs.first = job->user_next;
+
+    if (job->user_next)
+      job->user_next->user_prev = job->user_prev;
+    else
+      u->jobs.last = job->user_prev;
+
+    if (-- u->jobs.count == 0)
+      cupsArrayRemove(printer->user_jobs, u);
+  }
+
+  job->user_prev = job->user_next = NULL;
+
+  if (job->all_prev)
+    job->all_prev->all_next = job->all_next;
+  else
+    printer->all_jobs.first = job->all_next;
+
+  if (job->all_next)
+    job->all_next->all_prev = job->all_prev;
+  else
+    printer->all_jobs.last = job->all_prev;
+
+  job->all_prev = job->all_next = NULL;
+
+  printer->all_jobs.count --;
+
+  if (printer->job_hash)
+  {
+    for (bucket = printer->job_hash + ((size_t)job->job_id & (printer->job_hash_size - 1)); *bucket; bucket = &(*bucket)->hash_next)
+    {
+      if (*bucket == job)
+      {
+        *bucket = job->hash_next;
+        break;
+      }
+    }
+  }
+
+  job->hash_next = NULL;
+}
+
+
+//
+// 'remove_pending()' - Remove a job from the pending jobs heap.
+//
+
+static void
+remove_pending(pappl_printer_t *printer,// I - Printer
+               pappl_job_t     *job)	// I - Job
+{
+  int	index;				// Index of job in heap
+
+
+  if (!job->pending_index)
+    return;
+
+  index              = job->pending_index - 1;
+  job->pending_index = 0;
+
+  if (index < -- printer->num_pending)
+  {
+    // Fill the hole with the last job in the heap...
+    printer->pending[index] = printer->pending[printer->num_pending];
+    move_pending(printer, index);
+  }
+}
+
+
+//
+// 'run_clean_thread()' - Clean out old jobs.
+//
+
+static void *				// O - Thread exit status
+run_clean_thread(pappl_system_t *system)// I - System
+{
+  papplSystemCleanJobs(system);
+
+  pthread_mutex_lock(&system->job_mutex);
+
+  system->clean_active = false;
+  pthread_cond_broadcast(&system->job_cond);
+
+  pthread_mutex_unlock(&system->job_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'run_job_thread()' - Process queued jobs.
+//
+// Worker threads exit after 60 seconds without a job.
+//
+
+static void *				// O - Thread exit status
+run_job_thread(pappl_system_t *system)	// I - System
+{
+  pappl_job_t		*job;		// Current job
+  pappl_printer_t	*printer;	// Printer for job
+  bool			process,	// Process the job?
+			follow_up,	// Check the printer afterwards?
+			delete_printer;	// Delete the printer afterwards?
+  struct timeval	curtime;	// Current time
+  struct timespec	timeout;	// Timeout for waiting
+
+
+  pthread_mutex_lock(&system->job_mutex);
+
+  while (!system->job_threads_stop)
+  {
+    if ((job = (pappl_job_t *)cupsArrayFirst(system->job_queue)) == NULL)
+    {
+      // Wait for another job...
+      gettimeofday(&curtime, NULL);
+      timeout.tv_sec  = curtime.tv_sec + 60;
+      timeout.tv_nsec = curtime.tv_usec * 1000;
+
+      if (pthread_cond_timedwait(&system->job_cond, &system->job_mutex, &timeout) == ETIMEDOUT && cupsArrayCount(system->job_queue) == 0)
+        break;
+
+      continue;
+    }
+
+    cupsArrayRemove(system->job_queue, job);
+    system->busy_job_threads ++;
+
+    pthread_mutex_unlock(&system->job_mutex);
+
+    // Make sure the job wasn't canceled while it was waiting...
+    printer   = job->printer;
+    follow_up = false;
+
+    pthread_rwlock_wrlock(&printer->rwlock);
+
+    if ((process = job->state == IPP_JSTATE_PENDING) == false && job->is_scheduled)
+    {
+      _papplPrinterUnscheduleJobNoLock(printer, job);
+      follow_up = true;
+    }
+
+    delete_printer = printer->is_deleted && printer->num_processing_jobs == 0;
+
+    pthread_rwlock_unlock(&printer->rwlock);
+
+    if (process)
+    {
+      _papplJobProcess(job);
+    }
+    else if (follow_up)
+    {
+      if (delete_printer)
+        papplPrinterDelete(printer);
+      else if (!printer->is_deleted)
+        _papplPrinterCheckJobs(printer);
+    }
+
+    pthread_mutex_lock(&system->job_mutex);
+    system->busy_job_threads --;
+  }
+
+  system->num_job_threads --;
+  pthread_cond_broadcast(&system->job_cond);
+
+  pthread_mutex_unlock(&system->job_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'score_job()' - Compute the scheduling score for a job.
+//
+// With the priority schedulers each "job-priority" level is worth
+// `sched_aging` seconds of waiting, so a job that has waited long enough
+// overtakes newer jobs of a higher priority.  The shortest-job-first scheduler
+// also counts each impression as one second of waiting, or every 100k of
+// document data when the number of impressions is not known.
+//
+
+static double				// O - Score, higher runs first
+score_job(pappl_printer_t *printer,	// I - Printer
+          pappl_job_t     *job)		// I - Job
+{
+  double		score;		// Score
+  int			priority = 50;	// "job-priority" value
+  ipp_attribute_t	*attr;		// "job-priority" attribute
+  struct stat		fileinfo;	// Document file information
+
+
+  if (printer->sched_cb)
+    return ((printer->sched_cb)(job, printer->sched_cbdata));
+  else if (printer->scheduler == PAPPL_SCHEDULER_FIFO)
+    return (0.0);
+
+  if ((attr = ippFindAttribute(job->attrs, "job-priority", IPP_TAG_INTEGER)) != NULL)
+    priority = ippGetInteger(attr, 0);
+
+  score = (double)priority * printer->sched_aging - (double)job->created;
+
+  if (printer->scheduler == PAPPL_SCHEDULER_PRIORITY_SJF)
+  {
+    if (job->impressions > 0)
+      score -= job->impressions;
+    else if (job->filename && !stat(job->filename, &fileinfo))
+      score -= fileinfo.st_size / 102400.0;
+  }
+
+  return (score);
+}
+
+
+//
+// 'unlink_job()' - Remove a job from the active or completed jobs list.
+//
+
+static void
+unlink_job(_pappl_joblist_t *list,	// I - Jobs list
+           pappl_job_t      *job)	// I - Job
+{
+  if (!job->prev && list->first != job)
+    return;				// Not in this list
+
+  if (job->prev)
+    job->prev->next = job->next;
+  else
+    list->first = job->next;
+
+  if (job->next)
+    job->next->prev = job->prev;
+  else
+    list->last = job->prev;
+
+  job->prev = job->next = NULL;
+
+  list->count --;
+}
+
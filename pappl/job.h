@@ -1,7 +1,7 @@
 //
 // Public job header file for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -15,6 +15,7 @@
 //
 
 #  include "base.h"
+#  include "log.h"
 
 
 //
@@ -59,6 +60,14 @@ enum pappl_jreason_e			// IPP "job-state-reasons" bit values
 typedef unsigned int pappl_jreason_t;	// Bitfield for IPP "job-state-reasons" values
 
 
+//
+// Callback function types...
+//
+
+typedef bool (*pappl_image_row_cb_t)(void *data, unsigned char *row);
+					// Image row callback
+
+
 //
 // Functions...
 //
@@ -69,6 +78,7 @@ extern pappl_pr_options_t *papplJobCreatePrintOptions(pappl_job_t *job, unsigned
 extern void		papplJobDeletePrintOptions(pappl_pr_options_t *options);
 
 extern bool		papplJobFilterImage(pappl_job_t *job, pappl_device_t *device, pappl_pr_options_t *options, const unsigned char *pixels, int width, int height, int depth, int ppi, bool smoothing) _PAPPL_PUBLIC;
+extern bool		papplJobFilterImageRows(pappl_job_t *job, pappl_device_t *device, pappl_pr_options_t *options, pappl_image_row_cb_t row_cb, void *row_data, int width, int height, int depth, int ppi, bool smoothing) _PAPPL_PUBLIC;
 
 extern ipp_attribute_t	*papplJobGetAttribute(pappl_job_t *job, const char *name) _PAPPL_PUBLIC;
 extern void		*papplJobGetData(pappl_job_t *job) _PAPPL_PUBLIC;
@@ -77,6 +87,7 @@ extern const char	*papplJobGetFormat(pappl_job_t *job) _PAPPL_PUBLIC;
 extern int		papplJobGetID(pappl_job_t *job) _PAPPL_PUBLIC;
 extern int		papplJobGetImpressions(pappl_job_t *job) _PAPPL_PUBLIC;
 extern int		papplJobGetImpressionsCompleted(pappl_job_t *job) _PAPPL_PUBLIC;
+extern pappl_loglevel_t	papplJobGetLogLevel(pappl_job_t *job) _PAPPL_PUBLIC;
 extern const char	*papplJobGetMessage(pappl_job_t *job) _PAPPL_PUBLIC;
 extern const char	*papplJobGetName(pappl_job_t *job) _PAPPL_PUBLIC;
 extern pappl_printer_t	*papplJobGetPrinter(pappl_job_t *job) _PAPPL_PUBLIC;
@@ -88,14 +99,18 @@ extern time_t		papplJobGetTimeProcessed(pappl_job_t *job) _PAPPL_PUBLIC;
 extern const char	*papplJobGetUsername(pappl_job_t *job) _PAPPL_PUBLIC;
 extern bool		papplJobIsCanceled(pappl_job_t *job) _PAPPL_PUBLIC;
 
+extern const void	*papplJobMapFile(pappl_job_t *job, size_t *length) _PAPPL_PUBLIC;
 extern int		papplJobOpenFile(pappl_job_t *job, char *fname, size_t fnamesize, const char *directory, const char *ext, const char *mode) _PAPPL_PUBLIC;
 
 extern void		papplJobSetData(pappl_job_t *job, void *data) _PAPPL_PUBLIC;
 extern void		papplJobSetImpressions(pappl_job_t *job, int impressions) _PAPPL_PUBLIC;
 extern void		papplJobSetImpressionsCompleted(pappl_job_t *job, int add) _PAPPL_PUBLIC;
+extern void		papplJobSetLogLevel(pappl_job_t *job, pappl_loglevel_t loglevel) _PAPPL_PUBLIC;
 extern void		papplJobSetMessage(pappl_job_t *job, const char *message, ...) _PAPPL_PUBLIC _PAPPL_FORMAT(2,3);
 extern void		papplJobSetReasons(pappl_job_t *job, pappl_jreason_t add, pappl_jreason_t remove) _PAPPL_PUBLIC;
 
+extern void		papplJobUnmapFile(pappl_job_t *job, const void *data, size_t length) _PAPPL_PUBLIC;
+
 
 //
 // C++ magic...
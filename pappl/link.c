@@ -112,7 +112,7 @@ papplSystemAddLink(
   if (!system || !label || !path_or_url)
     return;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  pthread_rwlock_wrlock(&system->resource_rwlock);
 
   if (!system->links)
     system->links = cupsArrayNew3((cups_array_func_t)compare_links, NULL, NULL, 0, (cups_acopy_func_t)copy_link, (cups_afree_func_t)free_link);
@@ -124,7 +124,7 @@ papplSystemAddLink(
   if (!cupsArrayFind(system->links, &l))
     cupsArrayAdd(system->links, &l);
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->resource_rwlock);
 }
 
 
@@ -145,13 +145,13 @@ papplSystemRemoveLink(
   if (!system || !label)
     return;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  pthread_rwlock_wrlock(&system->resource_rwlock);
 
   l.label = (char *)label;
 
   cupsArrayRemove(system->links, &l);
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->resource_rwlock);
 }
 
 
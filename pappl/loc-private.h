@@ -0,0 +1,53 @@
+//
+// Private localization header file for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef _PAPPL_LOC_PRIVATE_H_
+#  define _PAPPL_LOC_PRIVATE_H_
+
+//
+// Include necessary headers...
+//
+
+#  include "system-private.h"
+#  include "loc.h"
+
+
+//
+// Types...
+//
+
+typedef struct _pappl_locpair_s		// Localized string
+{
+  char			*key,			// Key string
+			*text;			// Localized text
+} _pappl_locpair_t;
+
+struct _pappl_loc_s			// Localization catalog
+{
+  char			*language,		// Language tag
+			*path;			// Resource path of strings file
+  bool			is_stale;		// Has the strings resource been replaced?
+  int			refcount;		// Number of client requests using catalog
+  size_t		num_pairs,		// Number of strings
+			num_slots;		// Size of hash table (power of 2)
+  _pappl_locpair_t	*pairs;			// Hash table of strings
+};
+
+
+//
+// Functions...
+//
+
+extern void		_papplLocDeleteAll(pappl_system_t *system) _PAPPL_PRIVATE;
+extern const char	*_papplLocFind(pappl_loc_t *loc, const char *key) _PAPPL_PRIVATE;
+extern void		_papplLocInvalidate(pappl_system_t *system, const char *path) _PAPPL_PRIVATE;
+extern void		_papplLocRelease(pappl_system_t *system, pappl_loc_t *loc) _PAPPL_PRIVATE;
+
+
+#endif // !_PAPPL_LOC_PRIVATE_H_
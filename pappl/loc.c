@@ -0,0 +1,844 @@
+//
+// Localization functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local constants...
+//
+
+#define _PAPPL_LOC_MAX_REFS	64	// Maximum number of cached language lookups
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_locref_s		// Cached language lookup
+{
+  char		language[64];		// Requested language
+  pappl_loc_t	*loc;			// Catalog or `NULL` if none
+} _pappl_locref_t;
+
+
+//
+// Local globals...
+//
+
+static pappl_loc_t	*loc_default = NULL;
+					// Built-in English strings
+static pthread_once_t	loc_default_once = PTHREAD_ONCE_INIT;
+					// One-time initialization of built-in strings
+static const char	*loc_default_strings =
+					// Built-in English strings
+  "\"media.iso_a4_210x297mm\" = \"A4\";\n"
+  "\"media.iso_a5_148x210mm\" = \"A5\";\n"
+  "\"media.iso_a6_105x148mm\" = \"A6\";\n"
+  "\"media.iso_dl_110x220mm\" = \"DL Envelope\";\n"
+  "\"media.na_legal_8.5x14in\" = \"US Legal\";\n"
+  "\"media.na_letter_8.5x11in\" = \"US Letter\";\n"
+  "\"media.na_number-10_4.125x9.5in\" = \"#10 Envelope\";\n"
+  "\"media-source.alternate-roll\" = \"Alternate\";\n"
+  "\"media-source.main-roll\" = \"Main\";\n"
+  "\"media-type.continuous\" = \"Continuous Paper\";\n"
+  "\"media-type.labels\" = \"Cut Labels\";\n"
+  "\"media-type.labels-continuous\" = \"Continuous Labels\";\n"
+  "\"media-type.photographic\" = \"Photo Paper\";\n"
+  "\"media-type.stationery\" = \"Plain Paper\";\n"
+  "\"media-type.stationery-letterhead\" = \"Letterhead\";\n"
+  "\"print-color-mode.bi-level\" = \"B&W (no shading)\";\n"
+  "\"print-color-mode.monochrome\" = \"B&W\";\n"
+  "\"sides.one-sided\" = \"Off\";\n"
+  "\"sides.two-sided-long-edge\" = \"On (Portrait)\";\n"
+  "\"sides.two-sided-short-edge\" = \"On (Landscape)\";\n";
+
+
+//
+// Local functions...
+//
+
+static void		loc_add(pappl_loc_t *loc, char *key, char *text);
+static int		loc_compare_refs(_pappl_locref_t *a, _pappl_locref_t *b);
+static pappl_loc_t	*loc_create(const char *language, const char *path);
+static void		loc_default_init(void);
+static void		loc_delete(pappl_loc_t *loc);
+static pappl_loc_t	*loc_find(pappl_system_t *system, const char *language, bool retain);
+static pappl_loc_t	*loc_find_resource(pappl_system_t *system, const char *language);
+static size_t		loc_hash(const char *key);
+static void		loc_load(pappl_loc_t *loc, const char *data);
+static bool		loc_load_file(pappl_loc_t *loc, const char *filename);
+static char		*loc_string(const char **ptr);
+
+
+//
+// 'papplClientGetLoc()' - Get the localization catalog for a client.
+//
+// This function returns the localization catalog for the language of the
+// current request.  IPP requests use the "attributes-natural-language"
+// attribute while other HTTP requests use the languages listed in the
+// "Accept-Language" header.  `NULL` is returned if no strings resource has
+// been added for the language(s), in which case @link papplLocGetString@ will
+// use the built-in English strings.
+//
+// The catalog remains valid until the end of the current request, even if
+// the strings resource is replaced or removed.
+//
+// @since PAPPL 1.1@
+//
+
+pappl_loc_t *				// O - Localization catalog or `NULL` for none
+papplClientGetLoc(
+    pappl_client_t *client)		// I - Client
+{
+  ipp_attribute_t	*attr;		// "attributes-natural-language" attribute
+  const char		*ptr;		// Pointer into Accept-Language
+  char			language[64],	// Current language tag
+			*langptr;	// Pointer into language tag
+
+
+  if (!client)
+    return (NULL);
+
+  if (client->loc_checked)
+    return (client->loc);
+
+  client->loc_checked = true;
+
+  if (client->request && (attr = ippFindAttribute(client->request, "attributes-natural-language", IPP_TAG_LANGUAGE)) != NULL)
+  {
+    client->loc = loc_find(client->system, ippGetString(attr, 0, NULL), true);
+    return (client->loc);
+  }
+
+  // Use the first Accept-Language entry that we have strings for, ignoring the
+  // quality values since browsers list languages in order of preference...
+  for (ptr = httpGetField(client->http, HTTP_FIELD_ACCEPT_LANGUAGE); *ptr && !client->loc;)
+  {
+    while (*ptr == ',' || isspace(*ptr & 255))
+      ptr ++;
+
+    for (langptr = language; *ptr && *ptr != ',' && *ptr != ';' && !isspace(*ptr & 255); ptr ++)
+    {
+      if (langptr < (language + sizeof(language) - 1))
+        *langptr++ = *ptr;
+    }
+
+    *langptr = '\0';
+
+    while (*ptr && *ptr != ',')
+      ptr ++;
+
+    if (language[0] && strcmp(language, "*"))
+      client->loc = loc_find(client->system, language, true);
+  }
+
+  return (client->loc);
+}
+
+
+//
+// 'papplClientGetLocString()' - Get a localized string for a client.
+//
+// This function returns the localized text for the "key" string using the
+// language of the current request.  The key is returned if there is no
+// localization for it.
+//
+// @since PAPPL 1.1@
+//
+
+const char *				// O - Localized text
+papplClientGetLocString(
+    pappl_client_t *client,		// I - Client
+    const char     *key)		// I - Key string
+{
+  return (papplLocGetString(papplClientGetLoc(client), key));
+}
+
+
+//
+// '_papplLocDeleteAll()' - Free all localization catalogs for a system.
+//
+
+void
+_papplLocDeleteAll(
+    pappl_system_t *system)		// I - System
+{
+  pappl_loc_t	*loc;			// Current catalog
+
+
+  cupsArrayDelete(system->loc_refs);
+  system->loc_refs = NULL;
+
+  for (loc = (pappl_loc_t *)cupsArrayFirst(system->localizations); loc; loc = (pappl_loc_t *)cupsArrayNext(system->localizations))
+    loc_delete(loc);
+
+  cupsArrayDelete(system->localizations);
+  system->localizations = NULL;
+}
+
+
+//
+// '_papplLocFind()' - Find a localized string.
+//
+
+const char *				// O - Localized text or `NULL` if none
+_papplLocFind(pappl_loc_t *loc,		// I - Localization catalog
+              const char  *key)		// I - Key string
+{
+  size_t		i,		// Current slot
+			mask;		// Slot mask
+  _pappl_locpair_t	*pair;		// Current string
+
+
+  if (!loc || !loc->num_pairs || !key)
+    return (NULL);
+
+  mask = loc->num_slots - 1;
+
+  for (i = loc_hash(key) & mask; (pair = loc->pairs + i)->key; i = (i + 1) & mask)
+  {
+    if (!strcmp(pair->key, key))
+      return (pair->text);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'papplLocGetLanguage()' - Get the language of a localization catalog.
+//
+// @since PAPPL 1.1@
+//
+
+const char *				// O - Language tag or `NULL` for none
+papplLocGetLanguage(pappl_loc_t *loc)	// I - Localization catalog
+{
+  return (loc ? loc->language : NULL);
+}
+
+
+//
+// 'papplLocGetString()' - Get a localized string.
+//
+// This function returns the localized text for the "key" string.  Keys that
+// are not in the catalog are looked up in PAPPL's built-in English strings,
+// which use keys of the form "attribute-name.keyword" for IPP keywords, and
+// the key itself is returned if neither has a localization for it.  Pass
+// `NULL` for the "loc" argument to only use the built-in strings.
+//
+// Catalogs are read-only once loaded so the returned string can be used
+// without any locking for as long as the catalog is valid.
+//
+// @since PAPPL 1.1@
+//
+
+const char *				// O - Localized text
+papplLocGetString(pappl_loc_t *loc,	// I - Localization catalog or `NULL` for built-in
+                  const char  *key)	// I - Key string
+{
+  const char	*text;			// Localized text
+
+
+  if (!key)
+    return (NULL);
+
+  if ((text = _papplLocFind(loc, key)) == NULL)
+  {
+    pthread_once(&loc_default_once, loc_default_init);
+
+    if ((text = _papplLocFind(loc_default, key)) == NULL)
+      text = key;
+  }
+
+  return (text);
+}
+
+
+//
+// '_papplLocInvalidate()' - Note that a strings resource has been added.
+//
+// Catalogs already loaded from the resource path are not used for new
+// lookups.  They are freed now if no client request is using them, otherwise
+// by @link _papplLocRelease@ at the end of the last request.
+//
+
+void
+_papplLocInvalidate(
+    pappl_system_t *system,		// I - System
+    const char     *path)		// I - Resource path
+{
+  pappl_loc_t	*loc;			// Current catalog
+
+
+  pthread_mutex_lock(&system->loc_mutex);
+
+  for (loc = (pappl_loc_t *)cupsArrayFirst(system->localizations); loc; loc = (pappl_loc_t *)cupsArrayNext(system->localizations))
+  {
+    if (strcmp(loc->path, path))
+      continue;
+
+    loc->is_stale = true;
+
+    if (loc->refcount == 0)
+    {
+      cupsArrayRemove(system->localizations, loc);
+      loc_delete(loc);
+    }
+  }
+
+  cupsArrayClear(system->loc_refs);
+
+  pthread_mutex_unlock(&system->loc_mutex);
+}
+
+
+//
+// '_papplLocRelease()' - Release a client request's reference to a catalog.
+//
+// Stale catalogs are freed when the last request using them is done.
+//
+
+void
+_papplLocRelease(
+    pappl_system_t *system,		// I - System
+    pappl_loc_t    *loc)		// I - Localization catalog or `NULL`
+{
+  if (!loc)
+    return;
+
+  pthread_mutex_lock(&system->loc_mutex);
+
+  if (-- loc->refcount == 0 && loc->is_stale)
+  {
+    cupsArrayRemove(system->localizations, loc);
+    loc_delete(loc);
+  }
+
+  pthread_mutex_unlock(&system->loc_mutex);
+}
+
+
+//
+// 'papplSystemFindLoc()' - Find the localization catalog for a language.
+//
+// This function returns the localization catalog for the given language,
+// using the strings resources added with @link papplSystemAddStringsData@ or
+// @link papplSystemAddStringsFile@.  If there are no strings for the full
+// language tag ("fr-CA"), the strings for the base language ("fr") are used.
+//
+// Strings files are parsed the first time their language is requested and the
+// result is kept until the strings resource is replaced or removed.  `NULL` is
+// returned if there are no strings for the language.  Request handlers should
+// use @link papplClientGetLoc@, which keeps the catalog until the end of the
+// request.
+//
+// @since PAPPL 1.1@
+//
+
+pappl_loc_t *				// O - Localization catalog or `NULL` for none
+papplSystemFindLoc(
+    pappl_system_t *system,		// I - System
+    const char     *language)		// I - ISO language tag such as "en-US", "fr-CA", etc.
+{
+  if (!system)
+    return (NULL);
+
+  return (loc_find(system, language, false));
+}
+
+
+//
+// 'loc_add()' - Add a string to a catalog.
+//
+// The catalog takes ownership of the key and text strings.
+//
+
+static void
+loc_add(pappl_loc_t *loc,		// I - Localization catalog
+        char        *key,		// I - Key string
+        char        *text)		// I - Localized text
+{
+  size_t		i,		// Current slot
+			mask;		// Slot mask
+  _pappl_locpair_t	*pair;		// Current string
+
+
+  if ((loc->num_pairs + 1) * 4 > loc->num_slots * 3)
+  {
+    // Grow the hash table...
+    size_t		num_slots = loc->num_slots ? 2 * loc->num_slots : 64;
+					// New size of hash table
+    _pappl_locpair_t	*pairs,		// New hash table
+			*oldpair;	// Current old string
+
+    if ((pairs = (_pappl_locpair_t *)calloc(num_slots, sizeof(_pappl_locpair_t))) == NULL)
+    {
+      free(key);
+      free(text);
+      return;
+    }
+
+    for (i = loc->num_slots, oldpair = loc->pairs; i > 0; i --, oldpair ++)
+    {
+      size_t j;				// New slot
+
+      if (!oldpair->key)
+        continue;
+
+      for (j = loc_hash(oldpair->key) & (num_slots - 1); pairs[j].key; j = (j + 1) & (num_slots - 1));
+
+      pairs[j] = *oldpair;
+    }
+
+    free(loc->pairs);
+
+    loc->pairs     = pairs;
+    loc->num_slots = num_slots;
+  }
+
+  mask = loc->num_slots - 1;
+
+  for (i = loc_hash(key) & mask; (pair = loc->pairs + i)->key; i = (i + 1) & mask)
+  {
+    if (!strcmp(pair->key, key))
+    {
+      // Later strings replace earlier ones...
+      free(key);
+      free(pair->text);
+      pair->text = text;
+      return;
+    }
+  }
+
+  pair->key  = key;
+  pair->text = text;
+
+  loc->num_pairs ++;
+}
+
+
+//
+// 'loc_compare_refs()' - Compare two cached language lookups.
+//
+
+static int				// O - Result of comparison
+loc_compare_refs(_pappl_locref_t *a,	// I - First lookup
+                 _pappl_locref_t *b)	// I - Second lookup
+{
+  return (strcasecmp(a->language, b->language));
+}
+
+
+//
+// 'loc_create()' - Create an empty localization catalog.
+//
+
+static pappl_loc_t *			// O - Localization catalog or `NULL` on error
+loc_create(const char *language,	// I - Language tag
+           const char *path)		// I - Resource path
+{
+  pappl_loc_t	*loc;			// Catalog
+
+
+  if ((loc = (pappl_loc_t *)calloc(1, sizeof(pappl_loc_t))) == NULL)
+    return (NULL);
+
+  loc->language = strdup(language);
+  loc->path     = strdup(path);
+
+  if (!loc->language || !loc->path)
+  {
+    loc_delete(loc);
+    return (NULL);
+  }
+
+  return (loc);
+}
+
+
+//
+// 'loc_default_init()' - Load the built-in English strings.
+//
+
+static void
+loc_default_init(void)
+{
+  if ((loc_default = loc_create("en", "/")) != NULL)
+    loc_load(loc_default, loc_default_strings);
+}
+
+
+//
+// 'loc_delete()' - Free a localization catalog.
+//
+
+static void
+loc_delete(pappl_loc_t *loc)		// I - Localization catalog
+{
+  size_t		i;		// Looping var
+  _pappl_locpair_t	*pair;		// Current string
+
+
+  for (i = loc->num_slots, pair = loc->pairs; i > 0; i --, pair ++)
+  {
+    free(pair->key);
+    free(pair->text);
+  }
+
+  free(loc->pairs);
+  free(loc->language);
+  free(loc->path);
+  free(loc);
+}
+
+
+//
+// 'loc_find()' - Find the localization catalog for a language.
+//
+// When "retain" is `true` the catalog is retained for a client request and
+// must be released with @link _papplLocRelease@.
+//
+
+static pappl_loc_t *			// O - Localization catalog or `NULL` for none
+loc_find(pappl_system_t *system,	// I - System
+         const char     *language,	// I - Language tag
+         bool           retain)		// I - Retain the catalog for a client request?
+{
+  _pappl_locref_t	key,		// Search key
+			*ref;		// Cached lookup
+  pappl_loc_t		*loc;		// Catalog
+
+
+  if (!language || !*language)
+    return (NULL);
+
+  strlcpy(key.language, language, sizeof(key.language));
+
+  pthread_mutex_lock(&system->loc_mutex);
+
+  if (!system->loc_refs)
+    system->loc_refs = cupsArrayNew3((cups_array_func_t)loc_compare_refs, NULL, NULL, 0, NULL, (cups_afree_func_t)free);
+
+  if ((ref = (_pappl_locref_t *)cupsArrayFind(system->loc_refs, &key)) != NULL)
+  {
+    loc = ref->loc;
+  }
+  else
+  {
+    // Not looked up yet, find (and load) the strings and cache the result,
+    // including a miss, so the next request for the language is a single
+    // lookup...
+    loc = loc_find_resource(system, language);
+
+    if (cupsArrayCount(system->loc_refs) >= _PAPPL_LOC_MAX_REFS)
+      cupsArrayClear(system->loc_refs);
+
+    if ((ref = (_pappl_locref_t *)calloc(1, sizeof(_pappl_locref_t))) != NULL)
+    {
+      memcpy(ref, &key, sizeof(_pappl_locref_t));
+      ref->loc = loc;
+
+      cupsArrayAdd(system->loc_refs, ref);
+    }
+  }
+
+  if (loc && retain)
+    loc->refcount ++;
+
+  pthread_mutex_unlock(&system->loc_mutex);
+
+  return (loc);
+}
+
+
+//
+// 'loc_find_resource()' - Find and load the strings for a language.
+//
+// The system's "loc_mutex" must be held when calling this function.
+//
+
+static pappl_loc_t *			// O - Localization catalog or `NULL` for none
+loc_find_resource(
+    pappl_system_t *system,		// I - System
+    const char     *language)		// I - Language tag
+{
+  int			i,		// Looping var
+			rcount;		// Number of resources
+  char			baselang[3];	// Base language
+  _pappl_resource_t	*r,		// Current resource
+			*match = NULL;	// Matching resource
+  pappl_loc_t		*loc = NULL;	// Catalog
+
+
+  strlcpy(baselang, language, sizeof(baselang));
+
+  pthread_rwlock_rdlock(&system->resource_rwlock);
+
+  // Cannot use cupsArrayFirst/Last since other threads might be iterating
+  // this array...
+  for (i = 0, rcount = cupsArrayCount(system->resources); i < rcount; i ++)
+  {
+    r = (_pappl_resource_t *)cupsArrayIndex(system->resources, i);
+
+    if (!r->language)
+      continue;
+
+    if (!strcasecmp(r->language, language))
+    {
+      match = r;
+      break;
+    }
+    else if (!match && !strcasecmp(r->language, baselang))
+    {
+      match = r;
+    }
+  }
+
+  if (match)
+  {
+    // Reuse the catalog for the resource if it has already been loaded for
+    // another language tag...
+    for (loc = (pappl_loc_t *)cupsArrayFirst(system->localizations); loc; loc = (pappl_loc_t *)cupsArrayNext(system->localizations))
+    {
+      if (!loc->is_stale && !strcmp(loc->path, match->path))
+        break;
+    }
+
+    if (!loc && (loc = loc_create(match->language, match->path)) != NULL)
+    {
+      if (match->filename)
+      {
+        if (!loc_load_file(loc, match->filename))
+          papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to read strings file '%s': %s", match->filename, strerror(errno));
+      }
+      else if (match->data)
+      {
+        loc_load(loc, (const char *)match->data);
+      }
+
+      papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Loaded %u strings for language '%s' from '%s'.", (unsigned)loc->num_pairs, loc->language, loc->path);
+
+      if (!system->localizations)
+        system->localizations = cupsArrayNew(NULL, NULL);
+
+      cupsArrayAdd(system->localizations, loc);
+    }
+  }
+
+  pthread_rwlock_unlock(&system->resource_rwlock);
+
+  return (loc);
+}
+
+
+//
+// 'loc_hash()' - Compute the hash of a key string.
+//
+// This is the 32-bit FNV-1a hash.
+//
+
+static size_t				// O - Hash value
+loc_hash(const char *key)		// I - Key string
+{
+  unsigned	hash = 2166136261U;	// Hash value
+
+
+  while (*key)
+  {
+    hash ^= (unsigned char)*key++;
+    hash *= 16777619U;
+  }
+
+  return ((size_t)hash);
+}
+
+
+//
+// 'loc_load()' - Load strings into a catalog.
+//
+// The strings use the NeXTStep format - `"key" = "text";` - with C-style
+// comments.  Invalid lines are skipped.
+//
+
+static void
+loc_load(pappl_loc_t *loc,		// I - Localization catalog
+         const char  *data)		// I - Strings data
+{
+  const char	*ptr = data;		// Pointer into data
+  char		*key,			// Key string
+		*text;			// Localized text
+
+
+  while (*ptr)
+  {
+    // Skip whitespace and comments...
+    if (isspace(*ptr & 255))
+    {
+      ptr ++;
+      continue;
+    }
+    else if (!strncmp(ptr, "/*", 2))
+    {
+      if ((ptr = strstr(ptr + 2, "*/")) == NULL)
+        break;
+
+      ptr += 2;
+      continue;
+    }
+    else if (*ptr != '\"')
+    {
+      // Skip "//" comments and anything else we don't understand...
+      while (*ptr && *ptr != '\n')
+        ptr ++;
+      continue;
+    }
+
+    // Read "key" = "text";
+    key  = loc_string(&ptr);
+    text = NULL;
+
+    while (isspace(*ptr & 255))
+      ptr ++;
+
+    if (key && *ptr == '=')
+    {
+      for (ptr ++; isspace(*ptr & 255); ptr ++);
+
+      if (*ptr == '\"' && (text = loc_string(&ptr)) != NULL)
+      {
+        while (isspace(*ptr & 255))
+          ptr ++;
+
+        if (*ptr == ';')
+          ptr ++;
+      }
+    }
+
+    if (key && text)
+    {
+      loc_add(loc, key, text);
+    }
+    else
+    {
+      free(key);
+      free(text);
+
+      while (*ptr && *ptr != '\n')
+        ptr ++;
+    }
+  }
+}
+
+
+//
+// 'loc_load_file()' - Load a strings file into a catalog.
+//
+
+static bool				// O - `true` on success, `false` on error
+loc_load_file(pappl_loc_t *loc,		// I - Localization catalog
+              const char  *filename)	// I - Strings file
+{
+  int		fd;			// File descriptor
+  struct stat	fileinfo;		// File information
+  char		*data;			// File data
+  ssize_t	bytes;			// Bytes read
+  size_t	total = 0;		// Total bytes read
+
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+    return (false);
+
+  if (fstat(fd, &fileinfo) || (data = malloc((size_t)fileinfo.st_size + 1)) == NULL)
+  {
+    close(fd);
+    return (false);
+  }
+
+  while (total < (size_t)fileinfo.st_size && (bytes = read(fd, data + total, (size_t)fileinfo.st_size - total)) > 0)
+    total += (size_t)bytes;
+
+  close(fd);
+
+  data[total] = '\0';
+
+  loc_load(loc, data);
+
+  free(data);
+
+  return (true);
+}
+
+
+//
+// 'loc_string()' - Read a quoted string.
+//
+// The pointer is advanced past the closing quote.  `NULL` is returned if the
+// string is not terminated.
+//
+
+static char *				// O - String or `NULL` on error
+loc_string(const char **ptr)		// IO - Pointer into strings data
+{
+  const char	*start = *ptr + 1,	// Start of string
+		*end;			// End of string
+  char		*s,			// String
+		*sptr;			// Pointer into string
+
+
+  // Find the end of the string...
+  for (end = start; *end && *end != '\"'; end ++)
+  {
+    if (*end == '\\' && end[1])
+      end ++;
+  }
+
+  if (!*end || (s = malloc((size_t)(end - start + 1))) == NULL)
+  {
+    *ptr = end;
+    return (NULL);
+  }
+
+  // Copy it, replacing escapes...
+  for (sptr = s; start < end; start ++)
+  {
+    if (*start == '\\')
+    {
+      switch (*(++ start))
+      {
+        case 'n' :
+            *sptr++ = '\n';
+            break;
+        case 'r' :
+            *sptr++ = '\r';
+            break;
+        case 't' :
+            *sptr++ = '\t';
+            break;
+        default :
+            *sptr++ = *start;
+            break;
+      }
+    }
+    else
+    {
+      *sptr++ = *start;
+    }
+  }
+
+  *sptr = '\0';
+  *ptr  = end + 1;
+
+  return (s);
+}
@@ -0,0 +1,46 @@
+//
+// Localization header file for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef _PAPPL_LOC_H_
+#  define _PAPPL_LOC_H_
+
+//
+// Include necessary headers...
+//
+
+#  include "base.h"
+
+
+//
+// C++ magic...
+//
+
+#  ifdef __cplusplus
+extern "C" {
+#  endif // __cplusplus
+
+
+//
+// Functions...
+//
+
+extern const char	*papplLocGetLanguage(pappl_loc_t *loc) _PAPPL_PUBLIC;
+extern const char	*papplLocGetString(pappl_loc_t *loc, const char *key) _PAPPL_PUBLIC;
+
+
+//
+// C++ magic...
+//
+
+#  ifdef __cplusplus
+}
+#  endif // __cplusplus
+
+
+#endif // !_PAPPL_LOC_H_
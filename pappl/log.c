@@ -1,7 +1,7 @@
 //
 // Logging functions for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
 // information.
@@ -22,12 +22,68 @@
 #endif // !_WIN32
 
 
+//
+// Constants...
+//
+
+#define _PAPPL_LOG_MAXLINE	2048	// Maximum length of a log line
+#define _PAPPL_LOG_SLOTS	512	// Number of lines in the log ring (power of 2)
+#define _PAPPL_LOG_BATCH	65536	// Maximum number of bytes per write
+#define _PAPPL_LOG_PREFIX	29	// Length of "L [YYYY-MM-DDTHH:MM:SS.mmmZ] " prefix
+#define _PAPPL_LOG_TAIL		65536	// Size of recent log lines buffer for followers
+
+
+//
+// Macros...
+//
+
+#if _WIN32
+#  define _PAPPL_LOG_THREAD	__declspec(thread)
+#else
+#  define _PAPPL_LOG_THREAD	__thread
+#endif // _WIN32
+
+
+//
+// Types...
+//
+
+typedef struct _pappl_logslot_s		// Log ring slot
+{
+  unsigned		seq;			// Slot sequence number
+  size_t		len;			// Length of line
+  char			line[_PAPPL_LOG_MAXLINE];
+						// Line
+} _pappl_logslot_t;
+
+struct _pappl_logring_s			// Asynchronous log writer
+{
+  pappl_system_t	*system;		// System
+  pthread_t		thread_id;		// Writer thread
+  pthread_mutex_t	mutex;			// Mutex for wakeups
+  pthread_cond_t	cond;			// Condition for wakeups
+  unsigned		is_running,		// Is the writer running?
+			is_waiting,		// Is the writer waiting for lines?
+			reopen,			// Reopen the log file?
+			head,			// Next slot for producers
+			tail,			// Next slot for the writer
+			dropped;		// Number of dropped lines
+  _pappl_logslot_t	slots[_PAPPL_LOG_SLOTS];// Lines
+};
+
+
 //
 // Local functions...
 //
 
+static void	log_ring_add(_pappl_logring_t *ring, const char *line, size_t len);
+static void	*log_ring_run(_pappl_logring_t *ring);
+static void	log_tail_add(pappl_system_t *system, const char *buffer, size_t bytes);
+static size_t	log_json(char *json, size_t jsonsize, const char *buffer, size_t bytes, int printer_id, int job_id, int client_number);
+static pappl_loglevel_t	log_level(pappl_printer_t *printer, pappl_job_t *job);
+static void	log_write(pappl_system_t *system, const char *buffer, size_t bytes);
 static void	rotate_log(pappl_system_t *system);
-static void	write_log(pappl_system_t *system, pappl_loglevel_t level, const char *message, va_list ap);
+static void	write_log(pappl_system_t *system, pappl_loglevel_t level, pappl_printer_t *printer, int job_id, int client_number, const char *message, va_list ap);
 
 
 //
@@ -36,6 +92,10 @@ static void	write_log(pappl_system_t *system, pappl_loglevel_t level, const char
 
 static pthread_mutex_t	log_mutex = PTHREAD_MUTEX_INITIALIZER;
 					// Log rotation mutex
+static _PAPPL_LOG_THREAD time_t log_time = 0;
+					// Time of cached prefix for this thread
+static _PAPPL_LOG_THREAD char log_prefix[100];
+					// Cached date/time prefix for this thread
 #if !_WIN32
 static const int	syslevels[] =	// Mapping of log levels to syslog
 {
@@ -93,10 +153,12 @@ papplLog(pappl_system_t   *system,	// I - System
   if (level < system->loglevel)
     return;
 
+  _PAPPL_ATOMIC_ADD(&system->log_counts[level], 1);
+
   va_start(ap, message);
 
   if (system->logfd >= 0)
-    write_log(system, level, message, ap);
+    write_log(system, level, NULL, 0, 0, message, ap);
 #if !_WIN32
   else
     vsyslog(syslevels[level], message, ap);
@@ -195,14 +257,20 @@ papplLogClient(
   if (level < client->system->loglevel)
     return;
 
-  snprintf(cmessage, sizeof(cmessage), "[Client %d] %s", client->number, message);
+  _PAPPL_ATOMIC_ADD(&client->system->log_counts[level], 1);
+
   va_start(ap, message);
 
   if (client->system->logfd >= 0)
-    write_log(client->system, level, cmessage, ap);
+  {
+    write_log(client->system, level, client->printer, 0, client->number, message, ap);
+  }
 #if !_WIN32
   else
+  {
+    snprintf(cmessage, sizeof(cmessage), "[Client %d] %s", client->number, message);
     vsyslog(syslevels[level], cmessage, ap);
+  }
 #endif // !_WIN32
 
   va_end(ap);
@@ -259,17 +327,23 @@ papplLogJob(
   if (!job || !message)
     return;
 
-  if (level < job->system->loglevel)
+  if (level < log_level(job->printer, job))
     return;
 
-  snprintf(jmessage, sizeof(jmessage), "[Job %d] %s", job->job_id, message);
+  _PAPPL_ATOMIC_ADD(&job->system->log_counts[level], 1);
+
   va_start(ap, message);
 
   if (job->system->logfd >= 0)
-    write_log(job->system, level, jmessage, ap);
+  {
+    write_log(job->system, level, job->printer, job->job_id, 0, message, ap);
+  }
 #if !_WIN32
   else
+  {
+    snprintf(jmessage, sizeof(jmessage), "[Job %d] %s", job->job_id, message);
     vsyslog(syslevels[level], jmessage, ap);
+  }
 #endif // !_WIN32
 
   va_end(ap);
@@ -284,6 +358,17 @@ void
 _papplLogOpen(
     pappl_system_t *system)		// I - System
 {
+  _pappl_logring_t	*ring = (_pappl_logring_t *)_PAPPL_ATOMIC_GETPTR(&system->logring);
+					// Log writer, if any
+
+
+  // The log writer thread owns the log file while it is running...
+  if (ring && _PAPPL_ATOMIC_GET(&ring->is_running) && !pthread_equal(pthread_self(), ring->thread_id))
+  {
+    _PAPPL_ATOMIC_SET(&ring->reopen, 1);
+    return;
+  }
+
   // Open the log file...
   if (!strcmp(system->logfile, "syslog"))
   {
@@ -297,7 +382,8 @@ _papplLogOpen(
   }
   else
   {
-    int	oldfd = system->logfd;		// Old log file descriptor
+    int		oldfd = system->logfd;	// Old log file descriptor
+    struct stat	loginfo;		// Log file information
 
     // Log to a file...
     if ((system->logfd = open(system->logfile, O_CREAT | O_WRONLY | O_APPEND | O_NOFOLLOW | O_CLOEXEC, 0600)) < 0)
@@ -308,6 +394,13 @@ _papplLogOpen(
       system->logfd = 2;
     }
 
+    // Track the size of the log file from here on, so that we don't need to
+    // stat it for every line...
+    if (system->logfd != 2 && !fstat(system->logfd, &loginfo))
+      system->logsize = (size_t)loginfo.st_size;
+    else
+      system->logsize = 0;
+
     // Close any old file...
     if (oldfd != -1)
       close(oldfd);
@@ -351,30 +444,36 @@ papplLogPrinter(
   if (!printer || !message)
     return;
 
-  if (level < printer->system->loglevel)
+  if (level < log_level(printer, NULL))
     return;
 
-  // Prefix the message with "[Printer foo]", making sure to not insert any
-  // printf format specifiers.
-  strlcpy(pmessage, "[Printer ", sizeof(pmessage));
-  for (pptr = pmessage + 9, nameptr = printer->name; *nameptr && pptr < (pmessage + 200); pptr ++)
-  {
-    if (*nameptr == '%')
-      *pptr++ = '%';
-    *pptr = *nameptr++;
-  }
-  *pptr++ = ']';
-  *pptr++ = ' ';
-  strlcpy(pptr, message, sizeof(pmessage) - (size_t)(pptr - pmessage));
+  _PAPPL_ATOMIC_ADD(&printer->system->log_counts[level], 1);
 
   // Write the log message...
   va_start(ap, message);
 
   if (printer->system->logfd >= 0)
-    write_log(printer->system, level, pmessage, ap);
+  {
+    write_log(printer->system, level, printer, 0, 0, message, ap);
+  }
 #if !_WIN32
   else
+  {
+    // Prefix the message with "[Printer foo]", making sure to not insert any
+    // printf format specifiers.
+    strlcpy(pmessage, "[Printer ", sizeof(pmessage));
+    for (pptr = pmessage + 9, nameptr = printer->name; *nameptr && pptr < (pmessage + 200); pptr ++)
+    {
+      if (*nameptr == '%')
+	*pptr++ = '%';
+      *pptr = *nameptr++;
+    }
+    *pptr++ = ']';
+    *pptr++ = ' ';
+    strlcpy(pptr, message, sizeof(pmessage) - (size_t)(pptr - pmessage));
+
     vsyslog(syslevels[level], pmessage, ap);
+  }
 #endif // !_WIN32
 
   va_end(ap);
@@ -382,17 +481,512 @@ papplLogPrinter(
 
 
 //
-// 'rotate_log()' - Rotate the log file...
+// '_papplLogStart()' - Start the log writer thread.
+//
+// Log messages are queued in a ring buffer and written by a single thread in
+// batches, so logging from job and client threads never waits for the log
+// file.  Messages are dropped (and counted) when the ring buffer is full.
+//
+// > Note: This function is normally only called from @link papplSystemRun@.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplLogStart(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_logring_t	*ring;		// Log writer
+  unsigned		i;		// Looping var
+
+
+  if (system->logring || system->logfd < 0)
+    return (system->logring != NULL);
+
+  if ((ring = calloc(1, sizeof(_pappl_logring_t))) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for log writer: %s", strerror(errno));
+    return (false);
+  }
+
+  ring->system     = system;
+  ring->is_running = 1;
+
+  for (i = 0; i < _PAPPL_LOG_SLOTS; i ++)
+    ring->slots[i].seq = i;
+
+  pthread_mutex_init(&ring->mutex, NULL);
+  pthread_cond_init(&ring->cond, NULL);
+
+  if (pthread_create(&ring->thread_id, NULL, (void *(*)(void *))log_ring_run, ring))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create log writer thread: %s", strerror(errno));
+
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->mutex);
+    free(ring);
+
+    return (false);
+  }
+
+  _PAPPL_ATOMIC_SETPTR(&system->logring, ring);
+
+  return (true);
+}
+
+
+//
+// '_papplLogStop()' - Stop the log writer thread.
+//
+// Any queued messages are written before the thread exits.  Call this function
+// only after every other thread that can log has stopped.
+//
+
+void
+_papplLogStop(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_logring_t	*ring;		// Log writer
+  _pappl_logslot_t	*slot;		// Current slot
+
+
+  if ((ring = (_pappl_logring_t *)_PAPPL_ATOMIC_GETPTR(&system->logring)) == NULL)
+    return;
+
+  // Write new messages directly, then let the writer finish...
+  _PAPPL_ATOMIC_SETPTR(&system->logring, NULL);
+
+  pthread_mutex_lock(&ring->mutex);
+  _PAPPL_ATOMIC_SET(&ring->is_running, 0);
+  pthread_cond_signal(&ring->cond);
+  pthread_mutex_unlock(&ring->mutex);
+
+  pthread_join(ring->thread_id, NULL);
+
+  // Write any messages that were queued after the writer's last pass...
+  for (;;)
+  {
+    slot = ring->slots + (ring->tail & (_PAPPL_LOG_SLOTS - 1));
+
+    if ((unsigned)_PAPPL_ATOMIC_GET(&slot->seq) != ring->tail + 1)
+      break;
+
+    log_write(system, slot->line, slot->len);
+
+    _PAPPL_ATOMIC_SET(&slot->seq, ring->tail + _PAPPL_LOG_SLOTS);
+    ring->tail ++;
+  }
+
+  pthread_cond_destroy(&ring->cond);
+  pthread_mutex_destroy(&ring->mutex);
+  free(ring);
+}
+
+
+//
+// '_papplLogTailRead()' - Read recent log lines.
+//
+// This function copies complete log lines that were written after "pos",
+// waiting up to "timeout" seconds for new lines.  Set "pos" to `(size_t)-1` to
+// start with the oldest line that is still in memory.  The "pos" value is
+// updated to the position after the copied lines; if the caller has fallen
+// behind, any lines that are no longer in memory are skipped.
+//
+// Recent log lines are kept when the `PAPPL_SOPTIONS_WEB_LOG` option is used
+// so that the log can be followed without reading the log file.
+//
+
+size_t					// O - Number of bytes copied or `0` on timeout
+_papplLogTailRead(
+    pappl_system_t *system,		// I  - System
+    size_t         *pos,		// IO - Position in log
+    char           *buffer,		// I  - Buffer
+    size_t         bufsize,		// I  - Size of buffer
+    int            timeout)		// I  - Timeout in seconds
+{
+  size_t		start,		// Position of oldest byte in memory
+			offset,		// Offset in ring buffer
+			bytes,		// Bytes to copy
+			count;		// Bytes to copy before wrapping
+  bool			partial = false;// Skip a partial first line?
+  char			*ptr;		// Pointer into buffer
+  struct timeval	curtime;	// Current time
+  struct timespec	abstime;	// Wait timeout
+
+
+  *buffer = '\0';
+
+  pthread_mutex_lock(&system->logtail_mutex);
+
+  if ((!system->logtail || *pos == system->logtail_pos) && timeout > 0 && !system->shutdown_time)
+  {
+    gettimeofday(&curtime, NULL);
+    abstime.tv_sec  = curtime.tv_sec + timeout;
+    abstime.tv_nsec = curtime.tv_usec * 1000;
+
+    pthread_cond_timedwait(&system->logtail_cond, &system->logtail_mutex, &abstime);
+  }
+
+  if (!system->logtail || *pos == system->logtail_pos)
+  {
+    pthread_mutex_unlock(&system->logtail_mutex);
+    return (0);
+  }
+
+  start = system->logtail_pos > _PAPPL_LOG_TAIL ? system->logtail_pos - _PAPPL_LOG_TAIL : 0;
+
+  if (*pos < start || *pos > system->logtail_pos)
+  {
+    *pos    = start;
+    partial = start > 0;
+  }
+
+  if ((bytes = system->logtail_pos - *pos) > (bufsize - 1))
+    bytes = bufsize - 1;
+
+  offset = *pos % _PAPPL_LOG_TAIL;
+  if ((count = _PAPPL_LOG_TAIL - offset) > bytes)
+    count = bytes;
+
+  memcpy(buffer, system->logtail + offset, count);
+  memcpy(buffer + count, system->logtail, bytes - count);
+  buffer[bytes] = '\0';
+
+  *pos += bytes;
+
+  pthread_mutex_unlock(&system->logtail_mutex);
+
+  // Only return complete lines...
+  if (partial && (ptr = strchr(buffer, '\n')) != NULL)
+  {
+    bytes -= (size_t)(ptr + 1 - buffer);
+    memmove(buffer, ptr + 1, bytes + 1);
+  }
+
+  if (bytes > 0 && buffer[bytes - 1] != '\n' && (ptr = strrchr(buffer, '\n')) != NULL)
+  {
+    *pos  -= bytes - (size_t)(ptr + 1 - buffer);
+    bytes  = (size_t)(ptr + 1 - buffer);
+
+    buffer[bytes] = '\0';
+  }
+
+  return (bytes);
+}
+
+
+//
+// 'log_json()' - Convert a formatted log line to a JSON line.
+//
+// The level and time fields come first and have a fixed width so that the
+// level can be found without parsing the line.
+//
+
+static size_t				// O - Length of JSON line
+log_json(char       *json,		// I - JSON buffer
+         size_t     jsonsize,		// I - Size of JSON buffer
+         const char *buffer,		// I - Formatted log line
+         size_t     bytes,		// I - Length of log line
+         int        printer_id,		// I - Printer ID or `0` for none
+         int        job_id,		// I - Job ID or `0` for none
+         int        client_number)	// I - Client number or `0` for none
+{
+  char		*jptr,			// Pointer into JSON buffer
+		*jend;			// End of JSON buffer
+  const char	*bptr,			// Pointer into log line
+		*bend;			// End of log message
+
+
+  snprintf(json, jsonsize, "{\"level\":\"%c\",\"time\":\"%.24s\",\"printer\":%d,\"job\":%d,\"client\":%d,\"message\":\"", buffer[0], buffer + 3, printer_id, job_id, client_number);
+
+  jptr = json + strlen(json);
+  jend = json + jsonsize - 4;		// Leave room for '"}\n' and nul
+
+  for (bptr = buffer + _PAPPL_LOG_PREFIX, bend = buffer + bytes - 1; bptr < bend && jptr < jend; bptr ++)
+  {
+    int ch = *bptr & 255;		// Current character
+
+    if (ch == '\"' || ch == '\\')
+    {
+      if (jptr > (jend - 2))
+        break;
+
+      *jptr++ = '\\';
+      *jptr++ = (char)ch;
+    }
+    else if (ch < ' ')
+    {
+      if (jptr > (jend - 6))
+        break;
+
+      snprintf(jptr, 7, "\\u%04x", ch);
+      jptr += 6;
+    }
+    else
+      *jptr++ = (char)ch;
+  }
+
+  memcpy(jptr, "\"}\n", 4);
+
+  return ((size_t)(jptr + 3 - json));
+}
+
+
+//
+// 'log_level()' - Get the log level for a printer or job.
+//
+
+static pappl_loglevel_t			// O - Log level
+log_level(pappl_printer_t *printer,	// I - Printer
+          pappl_job_t     *job)		// I - Job or `NULL` for none
+{
+  if (job && job->loglevel != PAPPL_LOGLEVEL_UNSPEC)
+    return (job->loglevel);
+  else if (printer->loglevel != PAPPL_LOGLEVEL_UNSPEC)
+    return (printer->loglevel);
+  else
+    return (printer->system->loglevel);
+}
+
+
+//
+// 'log_ring_add()' - Add a line to the log ring buffer.
+//
+// Producers claim a slot by advancing the head with compare-and-swap and then
+// publish the line by updating the slot's sequence number, so no lock is held
+// while the line is copied.
 //
 
 static void
-rotate_log(pappl_system_t *system)	// I - System
+log_ring_add(_pappl_logring_t *ring,	// I - Log writer
+             const char       *line,	// I - Line
+             size_t           len)	// I - Length of line
 {
-  struct stat	loginfo;		// Lof file information
+  unsigned		pos,		// Position in ring
+			seq;		// Slot sequence number
+  _pappl_logslot_t	*slot;		// Slot
+
+
+  for (pos = (unsigned)_PAPPL_ATOMIC_GET(&ring->head);;)
+  {
+    slot = ring->slots + (pos & (_PAPPL_LOG_SLOTS - 1));
+    seq  = (unsigned)_PAPPL_ATOMIC_GET(&slot->seq);
+
+    if (seq == pos)
+    {
+      // Slot is free, try to claim it...
+      if (_PAPPL_ATOMIC_CAS(&ring->head, pos, pos + 1))
+        break;
+    }
+    else if ((int)(seq - pos) < 0)
+    {
+      // Ring is full...
+      _PAPPL_ATOMIC_ADD(&ring->dropped, 1);
+      return;
+    }
+
+    pos = (unsigned)_PAPPL_ATOMIC_GET(&ring->head);
+  }
+
+  if (len > sizeof(slot->line))
+    len = sizeof(slot->line);
+
+  memcpy(slot->line, line, len);
+  slot->len = len;
+
+  _PAPPL_ATOMIC_SET(&slot->seq, pos + 1);
+
+  // Wake up the writer as needed...
+  if (_PAPPL_ATOMIC_GET(&ring->is_waiting))
+  {
+    pthread_mutex_lock(&ring->mutex);
+    pthread_cond_signal(&ring->cond);
+    pthread_mutex_unlock(&ring->mutex);
+  }
+}
+
+
+//
+// 'log_ring_run()' - Write queued log lines.
+//
+
+static void *				// O - Thread exit status
+log_ring_run(_pappl_logring_t *ring)	// I - Log writer
+{
+  pappl_system_t	*system = ring->system;
+					// System
+  char			buffer[_PAPPL_LOG_BATCH];
+					// Output buffer
+  size_t		bufused = 0;	// Bytes in output buffer
+  _pappl_logslot_t	*slot;		// Current slot
+  unsigned		dropped;	// Number of dropped lines
+  struct timeval	curtime;	// Current time
+  struct timespec	timeout;	// Wait timeout
+
+
+  for (;;)
+  {
+    // Copy published lines into the output buffer...
+    slot = ring->slots + (ring->tail & (_PAPPL_LOG_SLOTS - 1));
+
+    if ((unsigned)_PAPPL_ATOMIC_GET(&slot->seq) == ring->tail + 1)
+    {
+      if ((bufused + slot->len) > sizeof(buffer))
+      {
+        log_write(system, buffer, bufused);
+        bufused = 0;
+      }
+
+      memcpy(buffer + bufused, slot->line, slot->len);
+      bufused += slot->len;
+
+      _PAPPL_ATOMIC_SET(&slot->seq, ring->tail + _PAPPL_LOG_SLOTS);
+      ring->tail ++;
+      continue;
+    }
+
+    // Nothing more is ready, write what we have...
+    if (bufused > 0)
+    {
+      log_write(system, buffer, bufused);
+      bufused = 0;
+    }
+
+    if ((dropped = (unsigned)_PAPPL_ATOMIC_GET(&ring->dropped)) > 0)
+    {
+      _PAPPL_ATOMIC_ADD(&ring->dropped, -(int)dropped);
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Dropped %u log message(s) because the log writer fell behind.", dropped);
+    }
+
+    if (_PAPPL_ATOMIC_GET(&ring->reopen))
+    {
+      _PAPPL_ATOMIC_SET(&ring->reopen, 0);
+      _papplLogOpen(system);
+    }
+
+    if (dropped)
+      continue;
+
+    if (!_PAPPL_ATOMIC_GET(&ring->is_running))
+      break;
+
+    // Wait for more lines, checking again after announcing that we are waiting
+    // so that a producer cannot publish a line without waking us up...
+    pthread_mutex_lock(&ring->mutex);
+
+    _PAPPL_ATOMIC_SET(&ring->is_waiting, 1);
+
+    if ((unsigned)_PAPPL_ATOMIC_GET(&slot->seq) != ring->tail + 1 && _PAPPL_ATOMIC_GET(&ring->is_running) && !_PAPPL_ATOMIC_GET(&ring->reopen))
+    {
+      gettimeofday(&curtime, NULL);
+      timeout.tv_sec  = curtime.tv_sec + 1;
+      timeout.tv_nsec = curtime.tv_usec * 1000;
+
+      pthread_cond_timedwait(&ring->cond, &ring->mutex, &timeout);
+    }
+
+    _PAPPL_ATOMIC_SET(&ring->is_waiting, 0);
+
+    pthread_mutex_unlock(&ring->mutex);
+  }
+
+  return (NULL);
+}
 
 
+//
+// 'log_tail_add()' - Add lines to the recent log lines for followers.
+//
+
+static void
+log_tail_add(pappl_system_t *system,	// I - System
+             const char     *buffer,	// I - Lines
+             size_t         bytes)	// I - Number of bytes
+{
+  size_t	offset,			// Offset in ring buffer
+		count;			// Bytes to copy before wrapping
+
+
+  pthread_mutex_lock(&system->logtail_mutex);
+
+  if (!system->logtail)
+    system->logtail = malloc(_PAPPL_LOG_TAIL);
+
+  if (system->logtail)
+  {
+    if (bytes > _PAPPL_LOG_TAIL)
+    {
+      // Only keep the end of a large batch...
+      system->logtail_pos += bytes - _PAPPL_LOG_TAIL;
+      buffer              += bytes - _PAPPL_LOG_TAIL;
+      bytes               = _PAPPL_LOG_TAIL;
+    }
+
+    offset = system->logtail_pos % _PAPPL_LOG_TAIL;
+    if ((count = _PAPPL_LOG_TAIL - offset) > bytes)
+      count = bytes;
+
+    memcpy(system->logtail + offset, buffer, count);
+    memcpy(system->logtail, buffer + count, bytes - count);
+
+    system->logtail_pos += bytes;
+
+    pthread_cond_broadcast(&system->logtail_cond);
+  }
+
+  pthread_mutex_unlock(&system->logtail_mutex);
+}
+
+
+//
+// 'log_write()' - Write data to the log file, rotating as needed.
+//
+
+static void
+log_write(pappl_system_t *system,	// I - System
+          const char     *buffer,	// I - Data to write
+          size_t         bytes)		// I - Number of bytes
+{
+  ssize_t	written;		// Bytes written
+
+
+  // Keep recent lines for the web interface...
+  if (system->options & PAPPL_SOPTIONS_WEB_LOG)
+    log_tail_add(system, buffer, bytes);
+
+  // Rotate log as needed, using the size we have written so far...
+  if (system->logmaxsize > 0 && system->logfd != 2 && _PAPPL_ATOMIC_GET(&system->logsize) >= system->logmaxsize)
+  {
+    pthread_mutex_lock(&log_mutex);
+    rotate_log(system);
+    pthread_mutex_unlock(&log_mutex);
+  }
+
+  while (bytes > 0)
+  {
+    if ((written = write(system->logfd, buffer, bytes)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      break;
+    }
+
+    _PAPPL_ATOMIC_ADD(&system->logsize, (size_t)written);
+
+    buffer += written;
+    bytes  -= (size_t)written;
+  }
+}
+
+
+//
+// 'rotate_log()' - Rotate the log file...
+//
+
+static void
+rotate_log(pappl_system_t *system)	// I - System
+{
   // Re-check whether we need to rotate the log file...
-  if (!fstat(system->logfd, &loginfo) && loginfo.st_size >= (off_t)system->logmaxsize)
+  if (system->logsize >= system->logmaxsize)
   {
     // Rename existing log file to "xxx.O"
     char	backname[1024];		// Backup log filename
@@ -419,15 +1013,25 @@ rotate_log(pappl_system_t *system)	// I - System
 static void
 write_log(pappl_system_t   *system,	// I - System
           pappl_loglevel_t level,	// I - Log level
+          pappl_printer_t  *printer,	// I - Printer, if any
+          int              job_id,	// I - Job ID, if any
+          int              client_number,// I - Client number, if any
           const char       *message,	// I - Printf-style message string
           va_list          ap)		// I - Pointer to additional arguments
 {
-  struct stat	loginfo;		// Log file information
-  char		buffer[2048],		// Output buffer
+  char		buffer[_PAPPL_LOG_MAXLINE],
+					// Output buffer
 		*bufptr,		// Pointer into buffer
 		*bufend;		// Pointer to end of buffer
+  char		json[_PAPPL_LOG_MAXLINE];
+					// JSON output buffer
+  const char	*line;			// Line to write
+  size_t	linelen;		// Length of line
+  bool		is_json = (system->options & PAPPL_SOPTIONS_LOG_JSON) != 0;
+					// Write JSON lines?
   struct timeval curtime;		// Current time
   struct tm	curdate;		// Current date
+  int		msec;			// Milliseconds
   static const char *prefix = "DIWEF";	// Message prefix
   const char	*sval;			// String value
   char		size,			// Size character (h, l, L)
@@ -436,29 +1040,54 @@ write_log(pappl_system_t   *system,	// I - System
 		prec;			// Number of characters of precision
   char		tformat[100],		// Temporary format string for sprintf()
 		*tptr;			// Pointer into temporary format
+  _pappl_logring_t *ring;		// Log writer, if any
 
 
-  // Rotate log as needed...
-  if (system->logmaxsize > 0 && !fstat(system->logfd, &loginfo) && loginfo.st_size >= (off_t)system->logmaxsize)
-  {
-    pthread_mutex_lock(&log_mutex);
-    rotate_log(system);
-    pthread_mutex_unlock(&log_mutex);
-  }
-
-  // Each log line starts with a standard prefix of log level and date/time...
+  // Each log line starts with a standard prefix of log level and date/time.
+  // The date and time are only formatted once a second, after which just the
+  // level and milliseconds are filled in...
   gettimeofday(&curtime, NULL);
+
+  if ((time_t)curtime.tv_sec != log_time)
+  {
 #if _WIN32
-  time_t curtemp = (time_t)curtime.tv_sec;
-  gmtime_s(&curdate, &curtemp);
+    time_t curtemp = (time_t)curtime.tv_sec;
+    gmtime_s(&curdate, &curtemp);
 #else
-  gmtime_r(&curtime.tv_sec, &curdate);
+    gmtime_r(&curtime.tv_sec, &curdate);
 #endif // _WIN32
 
-  snprintf(buffer, sizeof(buffer), "%c [%04d-%02d-%02dT%02d:%02d:%02d.%03dZ] ", prefix[level], curdate.tm_year + 1900, curdate.tm_mon + 1, curdate.tm_mday, curdate.tm_hour, curdate.tm_min, curdate.tm_sec, (int)(curtime.tv_usec / 1000));
-  bufptr = buffer + 29;			// Skip level/date/time
+    snprintf(log_prefix, sizeof(log_prefix), "  [%04d-%02d-%02dT%02d:%02d:%02d.000Z] ", curdate.tm_year + 1900, curdate.tm_mon + 1, curdate.tm_mday, curdate.tm_hour, curdate.tm_min, curdate.tm_sec);
+    log_time = (time_t)curtime.tv_sec;
+  }
+
+  msec = (int)(curtime.tv_usec / 1000);
+
+  memcpy(buffer, log_prefix, _PAPPL_LOG_PREFIX);
+  buffer[0]  = prefix[level];
+  buffer[23] = (char)('0' + msec / 100);
+  buffer[24] = (char)('0' + (msec / 10) % 10);
+  buffer[25] = (char)('0' + msec % 10);
+
+  bufptr = buffer + _PAPPL_LOG_PREFIX;	// Skip level/date/time
   bufend = buffer + sizeof(buffer) - 1;	// Leave room for newline on end
 
+  // Text lines identify the job, client, or printer in the message, while
+  // JSON lines have separate fields...
+  if (!is_json)
+  {
+    if (job_id)
+      snprintf(bufptr, (size_t)(bufend - bufptr), "[Job %d] ", job_id);
+    else if (client_number)
+      snprintf(bufptr, (size_t)(bufend - bufptr), "[Client %d] ", client_number);
+    else if (printer)
+      snprintf(bufptr, (size_t)(bufend - bufptr), "[Printer %s] ", printer->name);
+    else
+      *bufptr = '\0';
+
+    bufptr += strlen(bufptr);
+  }
+
   // Then format the message line using printf format sequences...
   while (*message && bufptr < bufend)
   {
@@ -660,8 +1289,22 @@ write_log(pappl_system_t   *system,	// I - System
       *bufptr++ = *message++;
   }
 
-  // Add a newline and write it out...
+  // Add a newline and write it out, or queue it for the log writer thread...
   *bufptr++ = '\n';
 
-  write(system->logfd, buffer, (size_t)(bufptr - buffer));
+  if (is_json)
+  {
+    line    = json;
+    linelen = log_json(json, sizeof(json), buffer, (size_t)(bufptr - buffer), printer ? printer->printer_id : 0, job_id, client_number);
+  }
+  else
+  {
+    line    = buffer;
+    linelen = (size_t)(bufptr - buffer);
+  }
+
+  if ((ring = (_pappl_logring_t *)_PAPPL_ATOMIC_GETPTR(&system->logring)) != NULL && _PAPPL_ATOMIC_GET(&ring->is_running))
+    log_ring_add(ring, line, linelen);
+  else
+    log_write(system, line, linelen);
 }
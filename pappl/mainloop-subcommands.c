@@ -33,14 +33,24 @@ typedef struct _pappl_ml_printer_s	// Printer data
   char	*device_id;			// IEEE-1284 device ID
 } _pappl_ml_printer_t;
 
+typedef struct _pappl_ml_submit_s	// Job submission data
+{
+  const char	*base_name;		// Base name
+  http_t	*http;			// HTTP connection to server
+  const char	*printer_uri,		// Printer URI, if any
+		*printer_name;		// Printer name, if any
+  char		resource[1024];		// Resource path
+  ipp_t		*supported;		// Supported attributes
+} _pappl_ml_submit_t;
+
 
 //
 // Local functions
 //
 
+static void	cancel_job(_pappl_ml_submit_t *submit, int job_id);
 static int	compare_printers(_pappl_ml_printer_t *a, _pappl_ml_printer_t *b);
 static _pappl_ml_printer_t *copy_printer(_pappl_ml_printer_t *p);
-static char	*copy_stdin(const char *base_name, char *name, size_t namesize);
 static pappl_system_t *default_system_cb(const char *base_name, int num_options, cups_option_t *options, void *data);
 static bool	device_autoadd_cb(const char *device_info, const char *device_uri, const char *device_id, void *data);
 static void	device_error_cb(const char *message, void *err_data);
@@ -49,6 +59,9 @@ static void	free_printer(_pappl_ml_printer_t *p);
 static ipp_t	*get_printer_attributes(http_t *http, const char *printer_uri, const char *printer_name, const char *resource, int num_requested, const char * const *requested);
 static char	*get_value(ipp_attribute_t *attr, const char *name, int element, char *buffer, size_t bufsize);
 static void	print_option(ipp_t *response, const char *name);
+static ipp_t	*send_document(_pappl_ml_submit_t *submit, ipp_t *request, const char *filename, int *job_id);
+static bool	submit_batch(_pappl_ml_submit_t *submit, int num_options, cups_option_t *options, const char *manifest);
+static bool	submit_job(_pappl_ml_submit_t *submit, int num_options, cups_option_t *options, int num_files, char **files);
 
 
 //
@@ -111,7 +124,7 @@ _papplMainloopAddPrinter(
 
   ippDelete(cupsDoRequest(http, request, "/ipp/system"));
 
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   if (cupsLastError() != IPP_STATUS_OK)
   {
@@ -192,7 +205,7 @@ _papplMainloopAutoAddPrinters(
 
   // Close the connection to the server and return...
   cupsArrayDelete(autoadd.printers);
-  httpClose(autoadd.http);
+  _papplMainloopDisconnect(autoadd.http);
 
   return (0);
 }
@@ -235,7 +248,7 @@ _papplMainloopCancelJob(
       if ((printer_name = _papplMainloopGetDefaultPrinter(http, default_printer, sizeof(default_printer))) == NULL)
       {
         fprintf(stderr, "%s: No default printer available.\n", base_name);
-        httpClose(http);
+        _papplMainloopDisconnect(http);
         return (1);
       }
     }
@@ -256,7 +269,7 @@ _papplMainloopCancelJob(
     if (job_id < 1 || errno == ERANGE || *end)
     {
       fprintf(stderr, "%s: Bad job ID.\n", base_name);
-      httpClose(http);
+      _papplMainloopDisconnect(http);
       return (1);
     }
   }
@@ -273,7 +286,7 @@ _papplMainloopCancelJob(
   ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
 
   ippDelete(cupsDoRequest(http, request, resource));
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   if (cupsLastError() != IPP_STATUS_OK)
   {
@@ -322,7 +335,7 @@ _papplMainloopDeletePrinter(
   else if ((printer_name = cupsGetOption("printer-name", num_options, options)) == NULL)
   {
     fprintf(stderr, "%s: Missing '-d PRINTER'.\n", base_name);
-    httpClose(http);
+    _papplMainloopDisconnect(http);
     return (1);
   }
 
@@ -334,7 +347,7 @@ _papplMainloopDeletePrinter(
   if (printer_id == 0)
   {
     fprintf(stderr, "%s: Unable to get information for printer: %s\n", base_name, cupsLastErrorString());
-    httpClose(http);
+    _papplMainloopDisconnect(http);
     return (1);
   }
 
@@ -345,7 +358,7 @@ _papplMainloopDeletePrinter(
   ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
 
   ippDelete(cupsDoRequest(http, request, "/ipp/system"));
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   if (cupsLastError() != IPP_STATUS_OK)
   {
@@ -399,7 +412,7 @@ _papplMainloopGetSetDefaultPrinter(
     else
       puts("No default printer set");
 
-    httpClose(http);
+    _papplMainloopDisconnect(http);
 
     return (0);
   }
@@ -412,7 +425,7 @@ _papplMainloopGetSetDefaultPrinter(
   if (printer_id == 0)
   {
     fprintf(stderr, "%s: Unable to get information for '%s' - %s\n", base_name, printer_name, cupsLastErrorString());
-    httpClose(http);
+    _papplMainloopDisconnect(http);
     return (1);
   }
 
@@ -424,7 +437,7 @@ _papplMainloopGetSetDefaultPrinter(
   ippAddInteger(request, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-default-printer-id", printer_id);
 
   ippDelete(cupsDoRequest(http, request, "/ipp/system"));
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   if (cupsLastError() != IPP_STATUS_OK)
   {
@@ -487,7 +500,7 @@ _papplMainloopModifyPrinter(
 
   ippDelete(cupsDoRequest(http, request, resource));
 
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   if (cupsLastError() != IPP_STATUS_OK)
   {
@@ -657,6 +670,120 @@ _papplMainloopRunServer(
 }
 
 
+//
+// '_papplMainloopRunShell()' - Run sub-commands from the standard input.
+//
+// Each line contains a sub-command name followed by optional "name=value"
+// options that are combined with the command-line options.  All of the
+// sub-commands use a single connection to the server.
+//
+
+int					// O - Exit status
+_papplMainloopRunShell(
+    const char    *base_name,		// I - Base name
+    int           num_options,		// I - Number of options
+    cups_option_t *options)		// I - Options
+{
+  char		line[2048],		// Line from stdin
+		*command,		// Sub-command
+		*lineptr;		// Pointer into line
+  int		i, j,			// Looping vars
+		num_cmd_options;	// Number of sub-command options
+  cups_option_t	*cmd_options;		// Sub-command options
+  bool		interactive;		// Show a prompt?
+  int		status = 0;		// Exit status
+  static const struct
+  {
+    const char	*name;			// Sub-command name
+    int		(*cb)(const char *base_name, int num_options, cups_option_t *options);
+					// Sub-command function
+  }		commands[] =		// Supported sub-commands
+  {
+    { "add",		_papplMainloopAddPrinter },
+    { "cancel",		_papplMainloopCancelJob },
+    { "default",	_papplMainloopGetSetDefaultPrinter },
+    { "delete",		_papplMainloopDeletePrinter },
+    { "devices",	_papplMainloopShowDevices },
+    { "jobs",		_papplMainloopShowJobs },
+    { "modify",		_papplMainloopModifyPrinter },
+    { "options",	_papplMainloopShowOptions },
+    { "printers",	_papplMainloopShowPrinters },
+    { "shutdown",	_papplMainloopShutdownServer },
+    { "status",		_papplMainloopShowStatus }
+  };
+
+
+  // Connect to/start up the server...
+  if ((_papplMainloopHTTP = _papplMainloopConnect(base_name, true)) == NULL)
+    return (1);
+
+#if _WIN32
+  interactive = false;
+#else
+  interactive = isatty(0);
+#endif // _WIN32
+
+  for (;;)
+  {
+    if (interactive)
+    {
+      printf("%s> ", base_name);
+      fflush(stdout);
+    }
+
+    if (!fgets(line, sizeof(line), stdin))
+      break;
+
+    // Skip leading whitespace, blank lines, and comments...
+    for (command = line; isspace(*command & 255); command ++);
+
+    if (!*command || *command == '#')
+      continue;
+
+    // Split the sub-command from any options...
+    for (lineptr = command; *lineptr && !isspace(*lineptr & 255); lineptr ++);
+
+    if (*lineptr)
+      *lineptr++ = '\0';
+
+    if (!strcmp(command, "exit") || !strcmp(command, "quit"))
+      break;
+
+    for (i = 0; i < (int)(sizeof(commands) / sizeof(commands[0])); i ++)
+    {
+      if (!strcmp(command, commands[i].name))
+        break;
+    }
+
+    if (i >= (int)(sizeof(commands) / sizeof(commands[0])))
+    {
+      fprintf(stderr, "%s: Unknown sub-command '%s'.\n", base_name, command);
+      status = 1;
+      continue;
+    }
+
+    // Combine the command-line and sub-command options and run it...
+    for (j = 0, num_cmd_options = 0, cmd_options = NULL; j < num_options; j ++)
+      num_cmd_options = cupsAddOption(options[j].name, options[j].value, num_cmd_options, &cmd_options);
+
+    num_cmd_options = cupsParseOptions(lineptr, num_cmd_options, &cmd_options);
+
+    status = (commands[i].cb)(base_name, num_cmd_options, cmd_options);
+
+    cupsFreeOptions(num_cmd_options, cmd_options);
+    fflush(stdout);
+
+    if (!strcmp(command, "shutdown"))
+      break;
+  }
+
+  httpClose(_papplMainloopHTTP);
+  _papplMainloopHTTP = NULL;
+
+  return (status);
+}
+
+
 //
 // '_papplMainlooploopShowDevices()' - Show available devices.
 //
@@ -773,7 +900,7 @@ _papplMainloopShowJobs(
       if ((printer_name = _papplMainloopGetDefaultPrinter(http, default_printer, sizeof(default_printer))) == NULL)
       {
         fprintf(stderr, "%s: No default printer available.\n", base_name);
-        httpClose(http);
+        _papplMainloopDisconnect(http);
         return (1);
       }
     }
@@ -819,7 +946,7 @@ _papplMainloopShowJobs(
   }
 
   ippDelete(response);
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   return (0);
 }
@@ -862,7 +989,7 @@ _papplMainloopShowOptions(
       if ((printer_name = _papplMainloopGetDefaultPrinter(http, default_printer, sizeof(default_printer))) == NULL)
       {
         fprintf(stderr, "%s: No default printer available.\n", base_name);
-        httpClose(http);
+        _papplMainloopDisconnect(http);
         return (1);
       }
     }
@@ -875,7 +1002,7 @@ _papplMainloopShowOptions(
   {
     fprintf(stderr, "%s: Unable to get printer options: %s\n", base_name, cupsLastErrorString());
     ippDelete(response);
-    httpClose(http);
+    _papplMainloopDisconnect(http);
     return (1);
   }
 
@@ -907,7 +1034,7 @@ _papplMainloopShowOptions(
   printf("  -o printer-organizational-unit='UNIT/SECTION'\n");
 
   ippDelete(response);
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   return (0);
 }
@@ -946,7 +1073,7 @@ _papplMainloopShowPrinters(
     puts(ippGetString(attr, 0, NULL));
 
   ippDelete(response);
-  httpClose(http);
+  _papplMainloopDisconnect(http);
 
   return (0);
 }
@@ -971,7 +1098,10 @@ _papplMainloopShowStatus(
   int			i,		// Looping var
 			count,		// Number of reasons
 			state;		// *-state value
-  ipp_attribute_t	*state_reasons;	// *-state-reasons attribute
+  ipp_attribute_t	*state_reasons,	// *-state-reasons attribute
+			*printers,	// system-configured-printers attribute
+			*attr;		// queued-job-count attribute
+  ipp_t			*col;		// system-configured-printers value
   time_t		state_time;	// *-state-change-time value
   const char		*reason;	// *-state-reasons value
   static const char * const states[] =	// *-state strings
@@ -984,10 +1114,12 @@ _papplMainloopShowStatus(
   {					// Requested printer attributes
       "printer-state",
       "printer-state-change-date-time",
-      "printer-state-reasons"
+      "printer-state-reasons",
+      "queued-job-count"
   };
   static const char * const sysattrs[] =
   {					// Requested system attributes
+      "system-configured-printers",
       "system-state",
       "system-state-change-date-time",
       "system-state-reasons"
@@ -1012,6 +1144,8 @@ _papplMainloopShowStatus(
     }
   }
 
+  // Get the printer or system state and the printer and job states in a single
+  // request...
   if (printer_uri || (printer_name = cupsGetOption("printer-name", num_options, options)) != NULL)
   {
     // Get the printer's status
@@ -1051,7 +1185,28 @@ _papplMainloopShowStatus(
     }
   }
 
+  if ((attr = ippFindAttribute(response, "queued-job-count", IPP_TAG_INTEGER)) != NULL)
+    printf("%d queued jobs\n", ippGetInteger(attr, 0));
+
+  if ((printers = ippFindAttribute(response, "system-configured-printers", IPP_TAG_BEGIN_COLLECTION)) != NULL)
+  {
+    // Show the state of each printer...
+    for (i = 0, count = ippGetCount(printers); i < count; i ++)
+    {
+      col   = ippGetCollection(printers, i);
+      state = ippGetInteger(ippFindAttribute(col, "printer-state", IPP_TAG_ENUM), 0);
+
+      if (state < IPP_PSTATE_IDLE)
+        state = IPP_PSTATE_IDLE;
+      else if (state > IPP_PSTATE_STOPPED)
+        state = IPP_PSTATE_STOPPED;
+
+      printf("%s: %s, %d queued jobs\n", ippGetString(ippFindAttribute(col, "printer-name", IPP_TAG_ZERO), 0, NULL), states[state - IPP_PSTATE_IDLE], ippGetInteger(ippFindAttribute(col, "queued-job-count", IPP_TAG_INTEGER), 0));
+    }
+  }
+
   ippDelete(response);
+  _papplMainloopDisconnect(http);
 
   return (0);
 }
@@ -1100,6 +1255,10 @@ _papplMainloopShutdownServer(
 //
 // '_papplMainloopSubmitJob()' - Submit job(s).
 //
+// All of the jobs are submitted over a single connection.  Each file is
+// normally printed as a separate job - the "multiple-documents" option prints
+// them as one job and the "batch" option reads files from a manifest.
+//
 
 int					// O - Exit status
 _papplMainloopSubmitJob(
@@ -1109,29 +1268,29 @@ _papplMainloopSubmitJob(
     int           num_files,		// I - Number of files
     char          **files)		// I - Files
 {
-  const char	*document_format,	// Document format
-		*document_name,		// Document name
-		*filename,		// Current print filename
-		*job_name,		// Job name
-		*printer_name,		// Printer name
-		*printer_uri;		// Printer URI
-  http_t	*http;			// Server connection
-  ipp_t		*request,		// IPP request
-		*response,		// IPP response
-		*supported;		// Supported attributes
-  char		default_printer[256],	// Default printer name
-		resource[1024],		// Resource path
-		tempfile[1024] = "";	// Temporary file
+  _pappl_ml_submit_t submit;		// Submission data
+  const char	*batch;			// Batch manifest file
+  bool		multiple;		// Print files as a single job?
+  char		default_printer[256];	// Default printer name
   int		i;			// Looping var
-  ipp_attribute_t *job_id;		// job-id for created job
+  bool		ret = true;		// Return value
+
 
+  batch    = cupsGetOption("batch", num_options, options);
+  multiple = cupsGetOption("multiple-documents", num_options, options) != NULL;
+
+  if (batch && (num_files > 0 || multiple))
+  {
+    fprintf(stderr, "%s: Cannot specify '--batch' with files or '--multiple-documents'.\n", base_name);
+    return (1);
+  }
 
 #if !_WIN32
   // If there are no input files and stdin is not a TTY, treat that as an
   // implicit request to print from stdin...
   char		*stdin_file;		// Dummy filename for passive stdin jobs
 
-  if (num_files == 0 && !isatty(0))
+  if (num_files == 0 && !batch && !isatty(0))
   {
     stdin_file = (char *)"-";
     files      = &stdin_file;
@@ -1139,108 +1298,143 @@ _papplMainloopSubmitJob(
   }
 #endif // !_WIN32
 
-  if (num_files == 0)
+  if (num_files == 0 && !batch)
   {
     fprintf(stderr, "%s: No files to print.\n", base_name);
     return (1);
   }
 
-  if ((printer_uri = cupsGetOption("printer-uri", num_options, options)) != NULL)
+  memset(&submit, 0, sizeof(submit));
+  submit.base_name = base_name;
+
+  if ((submit.printer_uri = cupsGetOption("printer-uri", num_options, options)) != NULL)
   {
     // Connect to the remote printer...
-    if ((http = _papplMainloopConnectURI(base_name, printer_uri, resource, sizeof(resource))) == NULL)
+    if ((submit.http = _papplMainloopConnectURI(base_name, submit.printer_uri, submit.resource, sizeof(submit.resource))) == NULL)
       return (1);
-
-    printer_name = NULL;
   }
   else
   {
     // Connect to/start up the server and get the destination printer...
-    if ((http = _papplMainloopConnect(base_name, true)) == NULL)
+    if ((submit.http = _papplMainloopConnect(base_name, true)) == NULL)
       return (1);
 
-    if ((printer_name = cupsGetOption("printer-name", num_options, options)) == NULL)
+    if ((submit.printer_name = cupsGetOption("printer-name", num_options, options)) == NULL)
     {
-      if ((printer_name = _papplMainloopGetDefaultPrinter(http, default_printer, sizeof(default_printer))) == NULL)
+      if ((submit.printer_name = _papplMainloopGetDefaultPrinter(submit.http, default_printer, sizeof(default_printer))) == NULL)
       {
         fprintf(stderr, "%s: No default printer available.\n", base_name);
-        httpClose(http);
+        _papplMainloopDisconnect(submit.http);
         return (1);
       }
     }
   }
 
-  // Loop through the print files
-  job_name        = cupsGetOption("job-name", num_options, options);
-  document_format = cupsGetOption("document-format", num_options, options);
+  // Get supported attributes once for all of the jobs...
+  submit.supported = get_printer_attributes(submit.http, submit.printer_uri, submit.printer_name, submit.resource, 0, NULL);
 
-  for (i = 0; i < num_files; i ++)
+  if (multiple && num_files > 1 && !ippGetBoolean(ippFindAttribute(submit.supported, "multiple-document-jobs-supported", IPP_TAG_BOOLEAN), 0))
   {
-    // Get the current print file...
-    if (!strcmp(files[i], "-"))
-    {
-      if (!copy_stdin(base_name, tempfile, sizeof(tempfile)))
-      {
-        httpClose(http);
-        return (1);
-      }
+    fprintf(stderr, "%s: Printer does not support multiple-document jobs.\n", base_name);
+    ret = false;
+  }
+  else if (batch)
+  {
+    ret = submit_batch(&submit, num_options, options, batch);
+  }
+  else if (multiple)
+  {
+    ret = submit_job(&submit, num_options, options, num_files, files);
+  }
+  else
+  {
+    // Print each file as a separate job...
+    for (i = 0; i < num_files && ret; i ++)
+      ret = submit_job(&submit, num_options, options, 1, files + i);
+  }
 
-      filename      = tempfile;
-      document_name = "(stdin)";
-    }
-    else
-    {
-      filename = files[i];
-      if ((document_name = strrchr(filename, '/')) != NULL)
-        document_name ++;
-      else
-        document_name = filename;
-    }
+  ippDelete(submit.supported);
+  _papplMainloopDisconnect(submit.http);
 
-    // Get supported attributes...
-    supported = get_printer_attributes(http, printer_uri, printer_name, resource, 0, NULL);
+  return (ret ? 0 : 1);
+}
 
-    // Send a Print-Job request...
-    request = ippNewRequest(IPP_OP_PRINT_JOB);
-    if (printer_uri)
-      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, printer_uri);
-    else
-      _papplMainloopAddPrinterURI(request, printer_name, resource, sizeof(resource));
 
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "job-name", NULL, job_name ? job_name : document_name);
-    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "document-name", NULL, document_name);
+//
+// '_papplMainloopWatch()' - Show status and jobs periodically.
+//
+// The status (and jobs when a printer is specified) are shown every
+// "interval" seconds (default 10) using a single connection to the server.
+//
 
-    if (document_format)
-      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_MIMETYPE, "document-format", NULL, document_format);
+int					// O - Exit status
+_papplMainloopWatch(
+    const char    *base_name,		// I - Base name
+    int           num_options,		// I - Number of options
+    cups_option_t *options)		// I - Options
+{
+  const char	*value;			// Option value
+  int		interval;		// Seconds between updates
+  bool		show_jobs;		// Show jobs?
+  int		status;			// Exit status
 
-    _papplMainloopAddOptions(request, num_options, options, supported);
-    ippDelete(supported);
 
-    response = cupsDoFileRequest(http, request, resource, filename);
+  if ((value = cupsGetOption("interval", num_options, options)) == NULL || (interval = atoi(value)) < 1)
+    interval = 10;
 
-    if ((job_id = ippFindAttribute(response, "job-id", IPP_TAG_INTEGER)) == NULL)
-    {
-      fprintf(stderr, "%s: Unable to print '%s': %s\n", base_name, filename, cupsLastErrorString());
-      ippDelete(response);
-      httpClose(http);
-      return (1);
-    }
+  show_jobs = cupsGetOption("printer-name", num_options, options) != NULL || cupsGetOption("printer-uri", num_options, options) != NULL;
 
-    if (printer_uri)
-      printf("%d\n", ippGetInteger(job_id, 0));
-    else
-      printf("%s-%d\n", printer_name, ippGetInteger(job_id, 0));
+  // Connect to/start up the server...
+  if ((_papplMainloopHTTP = _papplMainloopConnect(base_name, true)) == NULL)
+    return (1);
 
-    ippDelete(response);
+  for (;;)
+  {
+    printf("%s\n", httpGetDateString(time(NULL)));
+
+    if ((status = _papplMainloopShowStatus(base_name, num_options, options)) != 0)
+      break;
 
-    if (tempfile[0])
-      unlink(tempfile);
+    if (show_jobs && (status = _papplMainloopShowJobs(base_name, num_options, options)) != 0)
+      break;
+
+    putchar('\n');
+    fflush(stdout);
+
+    sleep((unsigned)interval);
   }
 
-  httpClose(http);
+  httpClose(_papplMainloopHTTP);
+  _papplMainloopHTTP = NULL;
 
-  return (0);
+  return (status);
+}
+
+
+//
+// 'cancel_job()' - Cancel a job that could not be submitted.
+//
+
+static void
+cancel_job(_pappl_ml_submit_t *submit,	// I - Submission data
+           int                job_id)	// I - Job ID
+{
+  ipp_t	*request;			// Cancel-Job request
+
+
+  request = ippNewRequest(IPP_OP_CANCEL_JOB);
+  if (submit->printer_uri)
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, submit->printer_uri);
+  else
+    _papplMainloopAddPrinterURI(request, submit->printer_name, submit->resource, sizeof(submit->resource));
+
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_id);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+
+  ippDelete(cupsDoRequest(submit->http, request, submit->resource));
+
+  if (cupsLastError() > IPP_STATUS_OK_CONFLICTING)
+    fprintf(stderr, "%s: Unable to cancel job %d: %s\n", submit->base_name, job_id, cupsLastErrorString());
 }
 
 
@@ -1285,67 +1479,6 @@ copy_printer(_pappl_ml_printer_t *p)	// I - Printer to copy
 }
 
 
-//
-// 'copy_stdin()' - Copy print data from the standard input.
-//
-
-static char *				// O - Temporary filename or `NULL` on error
-copy_stdin(
-    const char *base_name,		// I - Printer application name
-    char       *name,			// I - Filename buffer
-    size_t     namesize)		// I - Size of filename buffer
-{
-  int		tempfd;			// Temporary file descriptor
-  size_t	total = 0;		// Total bytes read/written
-  ssize_t	bytes;			// Number of bytes read/written
-  char		buffer[65536];		// Copy buffer
-
-
-  // Create a temporary file for printing...
-  if ((tempfd = cupsTempFd(name, (int)namesize)) < 0)
-  {
-    fprintf(stderr, "%s: Unable to create temporary file: %s\n", base_name, strerror(errno));
-    return (NULL);
-  }
-
-  // Read from stdin until we see EOF...
-  while ((bytes = read(0, buffer, sizeof(buffer))) > 0)
-  {
-    if (write(tempfd, buffer, (size_t)bytes) < 0)
-    {
-      fprintf(stderr, "%s: Unable to write to temporary file: %s\n", base_name, strerror(errno));
-      goto fail;
-    }
-
-    total += (size_t)bytes;
-  }
-
-  // Only allow non-empty files...
-  if (total == 0)
-  {
-    fprintf(stderr, "%s: Empty print file received on the standard input.\n", base_name);
-    goto fail;
-  }
-
-  // Close the temporary file and return it...
-  close(tempfd);
-
-  return (name);
-
-  // If we get here, something went wrong...
-  fail:
-
-  // Close and remove the temporary file...
-  close(tempfd);
-  unlink(name);
-
-  // Return NULL and an empty filename...
-  *name = '\0';
-
-  return (NULL);
-}
-
-
 //
 // 'device_autoadd_cb()' - Device callback.
 //
@@ -1727,3 +1860,307 @@ print_option(ipp_t      *response,	// I - Get-Printer-Attributes response
       printf("  -o %s=%s\n", name, supvalue);
   }
 }
+
+
+//
+// 'send_document()' - Send a request with a print file.
+//
+// The standard input ("-") is sent as it is read using chunked encoding.  The
+// request is freed.  The "job_id" argument receives the ID of a new job from
+// the response, including when the print data could not be read and `NULL`
+// is returned, so that the job can be canceled.
+//
+
+static ipp_t *				// O - IPP response or `NULL` on error
+send_document(
+    _pappl_ml_submit_t *submit,		// I - Submission data
+    ipp_t              *request,	// I - IPP request
+    const char         *filename,	// I - Print file or "-" for stdin
+    int                *job_id)		// IO - Job ID or `0` for a new job
+{
+  int		fd;			// Print file descriptor
+  size_t	length;			// Length of print file
+  struct stat	fileinfo;		// Print file information
+  ssize_t	bytes = 0;		// Bytes read
+  int		read_error = 0;		// Read error, if any
+  http_status_t	status;			// HTTP status
+  ipp_t		*response;		// IPP response
+  ipp_attribute_t *attr;		// job-id attribute
+  char		buffer[65536];		// Copy buffer
+
+
+  if (!strcmp(filename, "-"))
+  {
+    // Only allow non-empty print data...
+    while ((bytes = read(0, buffer, sizeof(buffer))) < 0 && (errno == EINTR || errno == EAGAIN));
+
+    if (bytes < 0)
+    {
+      fprintf(stderr, "%s: Unable to read the standard input: %s\n", submit->base_name, strerror(errno));
+      ippDelete(request);
+      return (NULL);
+    }
+    else if (bytes == 0)
+    {
+      fprintf(stderr, "%s: Empty print file received on the standard input.\n", submit->base_name);
+      ippDelete(request);
+      return (NULL);
+    }
+
+    fd     = 0;
+    length = CUPS_LENGTH_VARIABLE;
+  }
+  else if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0 || fstat(fd, &fileinfo))
+  {
+    fprintf(stderr, "%s: Unable to open '%s': %s\n", submit->base_name, filename, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    ippDelete(request);
+    return (NULL);
+  }
+  else
+  {
+    length = (size_t)fileinfo.st_size;
+  }
+
+  // Send the request followed by the print data...
+  status = cupsSendRequest(submit->http, request, submit->resource, length);
+
+  while (status == HTTP_STATUS_CONTINUE)
+  {
+    if (bytes == 0 && (bytes = read(fd, buffer, sizeof(buffer))) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+      {
+        bytes = 0;
+        continue;
+      }
+
+      read_error = errno;
+      break;
+    }
+    else if (bytes == 0)
+      break;
+
+    status = cupsWriteRequestData(submit->http, buffer, (size_t)bytes);
+    bytes  = 0;
+  }
+
+  if (fd > 0)
+    close(fd);
+
+  response = cupsGetResponse(submit->http, submit->resource);
+
+  ippDelete(request);
+
+  if (!*job_id && (attr = ippFindAttribute(response, "job-id", IPP_TAG_INTEGER)) != NULL)
+    *job_id = ippGetInteger(attr, 0);
+
+  if (read_error)
+  {
+    // Don't let a partial document print...
+    fprintf(stderr, "%s: Unable to read '%s': %s\n", submit->base_name, filename, strerror(read_error));
+    ippDelete(response);
+    return (NULL);
+  }
+
+  return (response);
+}
+
+
+//
+// 'submit_batch()' - Submit the jobs listed in a manifest file.
+//
+// Each line of the manifest contains a filename optionally followed by
+// "name=value" options for that job.  Blank lines and lines starting with "#"
+// are ignored.
+//
+
+static bool				// O - `true` on success, `false` on error
+submit_batch(
+    _pappl_ml_submit_t *submit,		// I - Submission data
+    int                num_options,	// I - Number of options
+    cups_option_t      *options,	// I - Options
+    const char         *manifest)	// I - Manifest file or "-" for stdin
+{
+  cups_file_t	*fp;			// Manifest file
+  char		line[2048],		// Line from manifest
+		*filename,		// Print file
+		*lineptr;		// Pointer into line
+  int		i,			// Looping var
+		linenum = 0,		// Line number
+		num_job_options;	// Number of job options
+  cups_option_t	*job_options;		// Job options
+  bool		ret = true;		// Return value
+
+
+  if ((fp = strcmp(manifest, "-") ? cupsFileOpen(manifest, "r") : cupsFileStdin()) == NULL)
+  {
+    fprintf(stderr, "%s: Unable to open '%s': %s\n", submit->base_name, manifest, strerror(errno));
+    return (false);
+  }
+
+  while (ret && cupsFileGets(fp, line, sizeof(line)))
+  {
+    linenum ++;
+
+    // Skip leading whitespace, blank lines, and comments...
+    for (filename = line; isspace(*filename & 255); filename ++);
+
+    if (!*filename || *filename == '#')
+      continue;
+
+    // Split the filename from any options...
+    for (lineptr = filename; *lineptr && !isspace(*lineptr & 255); lineptr ++);
+
+    if (*lineptr)
+      *lineptr++ = '\0';
+
+    if (!strcmp(filename, "-"))
+    {
+      fprintf(stderr, "%s: Cannot print the standard input from a manifest on line %d of '%s'.\n", submit->base_name, linenum, manifest);
+      ret = false;
+      break;
+    }
+
+    // Combine the command-line and job options...
+    for (i = 0, num_job_options = 0, job_options = NULL; i < num_options; i ++)
+      num_job_options = cupsAddOption(options[i].name, options[i].value, num_job_options, &job_options);
+
+    num_job_options = cupsParseOptions(lineptr, num_job_options, &job_options);
+
+    ret = submit_job(submit, num_job_options, job_options, 1, &filename);
+
+    cupsFreeOptions(num_job_options, job_options);
+  }
+
+  if (fp != cupsFileStdin())
+    cupsFileClose(fp);
+
+  return (ret);
+}
+
+
+//
+// 'submit_job()' - Submit a job with one or more files.
+//
+// One file is sent with Print-Job.  Multiple files are sent using Create-Job
+// followed by a Send-Document request for each file.
+//
+
+static bool				// O - `true` on success, `false` on error
+submit_job(
+    _pappl_ml_submit_t *submit,		// I - Submission data
+    int                num_options,	// I - Number of options
+    cups_option_t      *options,	// I - Options
+    int                num_files,	// I - Number of files
+    char               **files)		// I - Files
+{
+  int		i;			// Looping var
+  const char	*document_format,	// Document format
+		*document_name,		// Document name
+		*job_name;		// Job name
+  ipp_t		*request,		// IPP request
+		*response = NULL;	// IPP response
+  ipp_attribute_t *attr;		// job-id attribute
+  int		job_id = 0;		// Job ID
+
+
+  job_name        = cupsGetOption("job-name", num_options, options);
+  document_format = cupsGetOption("document-format", num_options, options);
+
+  for (i = 0; i < num_files; i ++)
+  {
+    // Get the current document name...
+    if (!strcmp(files[i], "-"))
+      document_name = "(stdin)";
+    else if ((document_name = strrchr(files[i], '/')) != NULL)
+      document_name ++;
+    else
+      document_name = files[i];
+
+    if (i == 0)
+    {
+      // Send a Print-Job or Create-Job request...
+      request = ippNewRequest(num_files == 1 ? IPP_OP_PRINT_JOB : IPP_OP_CREATE_JOB);
+      if (submit->printer_uri)
+        ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, submit->printer_uri);
+      else
+        _papplMainloopAddPrinterURI(request, submit->printer_name, submit->resource, sizeof(submit->resource));
+
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "job-name", NULL, job_name ? job_name : document_name);
+
+      if (num_files == 1)
+      {
+        ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "document-name", NULL, document_name);
+
+        if (document_format)
+          ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_MIMETYPE, "document-format", NULL, document_format);
+      }
+
+      _papplMainloopAddOptions(request, num_options, options, submit->supported);
+
+      if (num_files == 1)
+      {
+        response = send_document(submit, request, files[i], &job_id);
+      }
+      else
+      {
+        response = cupsDoRequest(submit->http, request, submit->resource);
+
+        if ((attr = ippFindAttribute(response, "job-id", IPP_TAG_INTEGER)) == NULL)
+        {
+          fprintf(stderr, "%s: Unable to create job: %s\n", submit->base_name, cupsLastErrorString());
+          ippDelete(response);
+          return (false);
+        }
+
+        job_id = ippGetInteger(attr, 0);
+        ippDelete(response);
+      }
+    }
+
+    if (job_id > 0)
+    {
+      // Send the document...
+      request = ippNewRequest(IPP_OP_SEND_DOCUMENT);
+      if (submit->printer_uri)
+        ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, submit->printer_uri);
+      else
+        _papplMainloopAddPrinterURI(request, submit->printer_name, submit->resource, sizeof(submit->resource));
+
+      ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_id);
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+      ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "document-name", NULL, document_name);
+
+      if (document_format)
+        ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_MIMETYPE, "document-format", NULL, document_format);
+
+      ippAddBoolean(request, IPP_TAG_OPERATION, "last-document", i == (num_files - 1));
+
+      response = send_document(submit, request, files[i], &job_id);
+    }
+
+    if (!response || cupsLastError() > IPP_STATUS_OK_CONFLICTING)
+    {
+      fprintf(stderr, "%s: Unable to print '%s': %s\n", submit->base_name, files[i], cupsLastErrorString());
+      ippDelete(response);
+
+      // Cancel the job so that the documents sent so far don't print...
+      if (job_id > 0)
+        cancel_job(submit, job_id);
+
+      return (false);
+    }
+
+    ippDelete(response);
+  }
+
+  if (submit->printer_uri)
+    printf("%d\n", job_id);
+  else
+    printf("%s-%d\n", submit->printer_name, job_id);
+
+  return (true);
+}
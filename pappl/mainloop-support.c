@@ -23,6 +23,7 @@
 // Globals...
 //
 
+http_t	*_papplMainloopHTTP = NULL;	// Shared server connection, if any
 char	*_papplMainloopPath = NULL;	// Path to self
 
 
@@ -59,7 +60,7 @@ _papplMainloopAddOptions(
 
 
   // Determine what kind of options we are adding...
-  group_tag  = ippGetOperation(request) == IPP_PRINT_JOB ? IPP_TAG_JOB : IPP_TAG_PRINTER;
+  group_tag  = (ippGetOperation(request) == IPP_OP_PRINT_JOB || ippGetOperation(request) == IPP_OP_CREATE_JOB) ? IPP_TAG_JOB : IPP_TAG_PRINTER;
   is_default = (group_tag == IPP_TAG_PRINTER);
 
   if (is_default)
@@ -329,6 +330,10 @@ _papplMainloopConnect(
   char		sockname[1024];		// Socket filename
 
 
+  // Use the shell/watch connection if we have one...
+  if (_papplMainloopHTTP)
+    return (_papplMainloopHTTP);
+
   // See if the server is running...
 #if _WIN32
   http = httpConnect2(_papplMainloopGetServerPath(base_name, 0, sockname, sizeof(sockname)), 0, NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, 1, 30000, NULL);
@@ -434,6 +439,18 @@ _papplMainloopConnectURI(
 }
 
 
+//
+// '_papplMainloopDisconnect()' - Close a connection unless it is shared.
+//
+
+void
+_papplMainloopDisconnect(http_t *http)	// I - HTTP connection
+{
+  if (http != _papplMainloopHTTP)
+    httpClose(http);
+}
+
+
 //
 // '_papplMainloopGetDefaultPrinter' - Get the default printer.
 //
@@ -95,9 +95,11 @@ papplMainloop(
     "options",
     "printers",
     "server",
+    "shell",
     "shutdown",
     "status",
-    "submit"
+    "submit",
+    "watch"
   };
 
 
@@ -143,6 +145,23 @@ papplMainloop(
       puts(version);
       return (0);
     }
+    else if (!strcmp(argv[i], "--batch"))
+    {
+      // Manifest of files to print follows
+      i ++;
+
+      if (i >= argc)
+      {
+        fprintf(stderr, "%s: Missing manifest filename after '--batch'.\n", base_name);
+        return (1);
+      }
+
+      num_options = cupsAddOption("batch", argv[i], num_options, &options);
+    }
+    else if (!strcmp(argv[i], "--multiple-documents"))
+    {
+      num_options = cupsAddOption("multiple-documents", "true", num_options, &options);
+    }
     else if (!strcmp(argv[i], "--"))
     {
       // Filename follows
@@ -413,6 +432,10 @@ papplMainloop(
   {
     return (_papplMainloopRunServer(base_name, version, footer_html, num_drivers, drivers, autoadd_cb, driver_cb, num_options, options, system_cb, data));
   }
+  else if (!strcmp(subcommand, "shell"))
+  {
+    return (_papplMainloopRunShell(base_name, num_options, options));
+  }
   else if (!strcmp(subcommand, "shutdown"))
   {
     return (_papplMainloopShutdownServer(base_name, num_options, options));
@@ -421,6 +444,10 @@ papplMainloop(
   {
     return (_papplMainloopShowStatus(base_name, num_options, options));
   }
+  else if (!strcmp(subcommand, "watch"))
+  {
+    return (_papplMainloopWatch(base_name, num_options, options));
+  }
   else
   {
     // This should never happen...
@@ -456,17 +483,24 @@ usage(const char *base_name,		// I - Base name of application
   puts("  options          List printer options.");
   puts("  printers         List printers.");
   puts("  server           Run a server.");
+  puts("  shell            Run sub-commands from the standard input.");
   puts("  shutdown         Shutdown a running server.");
   puts("  status           Show server/printer/job status.");
   puts("  submit           Submit a file for printing.");
+  puts("  watch            Show status and jobs every 10 seconds.");
   puts("");
   puts("Options:");
+  puts("  --batch FILENAME Submit the files listed in a manifest (submit).");
+  puts("  --multiple-documents");
+  puts("                   Submit all files as a single job (submit).");
   puts("  -a               Cancel all jobs (cancel).");
   puts("  -d PRINTER       Specify printer.");
   puts("  -j JOB-ID        Specify job ID (cancel).");
   puts("  -m DRIVER-NAME   Specify driver (add/modify).");
   puts("  -n COPIES        Specify number of copies (submit).");
   puts("  -o NAME=VALUE    Specify option (add,modify,server,submit).");
+  puts("  -o interval=SECONDS");
+  puts("                   Specify seconds between updates (watch).");
   puts("  -u URI           Specify ipp: or ipps: printer/server.");
   puts("  -v DEVICE-URI    Specify socket: or usb: device (add/modify).");
 }
@@ -21,7 +21,9 @@
 #  include "client-private.h"
 #  include "printer-private.h"
 #  include "job-private.h"
+#  include "subscription-private.h"
 #  include "mainloop-private.h"
+#  include "loc-private.h"
 #  include "log-private.h"
 
 #endif // !_PAPPL_PAPPL_PRIVATE_H_
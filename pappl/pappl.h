@@ -19,6 +19,7 @@
 #  include "client.h"
 #  include "printer.h"
 #  include "job.h"
+#  include "loc.h"
 #  include "log.h"
 #  include "mainloop.h"
 
@@ -13,6 +13,118 @@
 
 #include "printer-private.h"
 #include "system-private.h"
+#include "job-private.h"
+#include "subscription-private.h"
+#include "device-private.h"
+
+
+//
+// Local functions...
+//
+
+static void	iterate_jobs(pappl_printer_t *printer, _pappl_joblist_t *list, bool all_jobs, pappl_job_cb_t cb, void *data, int job_index, int limit);
+static void	*run_status(pappl_printer_t *printer);
+
+
+//
+// '_papplPrinterCheckDeviceNoLock()' - Check whether an idle device connection
+//                                      can be reused.
+//
+// The printer's writer lock must be held.  Connections that report an offline
+// status are closed.
+//
+
+bool					// O - `true` if the open device can be reused
+_papplPrinterCheckDeviceNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  if (!printer->device)
+    return (false);
+
+  if (papplDeviceGetStatus(printer->device) & PAPPL_PREASON_OFFLINE)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Idle connection to device was lost, reconnecting.");
+
+    _papplPrinterCloseDeviceNoLock(printer);
+
+    return (false);
+  }
+
+  papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Reusing idle connection to device.");
+
+  return (true);
+}
+
+
+//
+// '_papplPrinterCheckStatus()' - Start a background status update as needed.
+//
+// This function is called by the system's housekeeping loop.  The driver's
+// status callback is run in a separate thread so that IPP and web requests are
+// always answered from the last known status, even when the device takes
+// several seconds to respond.  The system counts the running status threads
+// and @link papplSystemDelete@ waits for them to finish.
+//
+// The time of the next status update is returned so the loop can sleep until
+// then.  `0` is returned when no update is scheduled - the loop is woken up
+// when the status thread finishes or the device is released.
+//
+
+time_t					// O - Time of next status update or `0` for none
+_papplPrinterCheckStatus(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_system_t *system = printer->system;
+					// System
+  pthread_t	tid;			// Status thread ID
+  time_t	next;			// Time of next status update
+
+
+  if (!printer->driver_data.status_cb || printer->status_interval == 0 || printer->status_active || printer->is_deleted || printer->device_in_use || printer->processing_job)
+    return (0);
+
+  if ((next = printer->status_time + printer->status_delay) > time(NULL))
+    return (next);
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  if (printer->status_active || printer->device_in_use || printer->processing_job)
+  {
+    pthread_rwlock_unlock(&printer->rwlock);
+    return (0);
+  }
+
+  printer->status_active = true;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterRetain(printer);
+
+  pthread_mutex_lock(&system->status_mutex);
+  system->num_status_threads ++;
+  pthread_mutex_unlock(&system->status_mutex);
+
+  if (pthread_create(&tid, NULL, (void *(*)(void *))run_status, printer))
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to create status thread: %s", strerror(errno));
+
+    printer->status_active = false;
+    printer->status_time   = time(NULL);
+
+    _papplPrinterRelease(printer);
+
+    pthread_mutex_lock(&system->status_mutex);
+    system->num_status_threads --;
+    pthread_cond_broadcast(&system->status_cond);
+    pthread_mutex_unlock(&system->status_mutex);
+
+    return (printer->status_time + printer->status_delay);
+  }
+
+  pthread_detach(tid);
+
+  return (0);
+}
 
 
 //
@@ -21,6 +133,9 @@
 // This function closes the device for a printer.  The device must have been
 // previously opened using the @link papplPrinterOpenDevice@ function.
 //
+// If the printer has a device idle time, the connection is kept open for
+// reuse by the next job or call to @link papplPrinterOpenDevice@.
+//
 
 void
 papplPrinterCloseDevice(
@@ -31,12 +146,86 @@ papplPrinterCloseDevice(
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
+  printer->device_in_use = false;
+
+  _papplPrinterReleaseDeviceNoLock(printer);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+}
+
+
+//
+// '_papplPrinterCloseDeviceNoLock()' - Close the device connection.
+//
+// The connection's metrics are added to the printer's totals before it is
+// closed.  The printer's writer lock must be held.
+//
+
+void
+_papplPrinterCloseDeviceNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_devmetrics_t	metrics;	// Metrics for connection
+  pappl_devtimings_t	timings;	// Timing metrics for connection
+
+
+  if (!printer->device)
+    return;
+
+  papplDeviceGetMetrics(printer->device, &metrics);
+
+  printer->device_metrics.read_bytes      += metrics.read_bytes;
+  printer->device_metrics.read_requests   += metrics.read_requests;
+  printer->device_metrics.read_msecs      += metrics.read_msecs;
+  printer->device_metrics.status_requests += metrics.status_requests;
+  printer->device_metrics.status_msecs    += metrics.status_msecs;
+  printer->device_metrics.write_bytes     += metrics.write_bytes;
+  printer->device_metrics.write_requests  += metrics.write_requests;
+  printer->device_metrics.write_msecs     += metrics.write_msecs;
+
+  papplDeviceGetTimings(printer->device, &timings);
+  timings.write_stall_nsecs = 0;
+  _papplDeviceAddTimings(&printer->device_timings, &timings);
+
   papplDeviceClose(printer->device);
+  printer->device = NULL;
+}
 
-  printer->device        = NULL;
-  printer->device_in_use = false;
+
+//
+// '_papplPrinterCloseIdleDevice()' - Close an idle device connection that has
+//                                    timed out.
+//
+// The time when the idle connection will be closed is returned, or `0` if
+// there is no idle connection.
+//
+
+time_t					// O - Time to close the idle device or `0` for none
+_papplPrinterCloseIdleDevice(
+    pappl_printer_t *printer)		// I - Printer
+{
+  time_t	next = 0;		// Time to close the idle device
+
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  if (printer->device && !printer->device_in_use && !printer->processing_job)
+  {
+    if (printer->device_idle_time == 0 || time(NULL) >= printer->device_close_time)
+    {
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Closing idle connection to device.");
+
+      _papplPrinterCloseDeviceNoLock(printer);
+    }
+    else
+    {
+      next = printer->device_close_time;
+    }
+  }
 
   pthread_rwlock_unlock(&printer->rwlock);
+
+  return (next);
 }
 
 
@@ -84,6 +273,25 @@ papplPrinterGetDeviceID(
 }
 
 
+//
+// 'papplPrinterGetDeviceIdleTime()' - Get the number of seconds an idle device
+//                                     connection is kept open.
+//
+// This function returns the number of seconds the printer keeps its device
+// connection open after a job completes, as configured by the
+// @link papplPrinterSetDeviceIdleTime@ function.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Idle time in seconds, `0` if not kept open
+papplPrinterGetDeviceIdleTime(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->device_idle_time : 0);
+}
+
+
 //
 // 'papplPrinterGetDeviceURI()' - Get the URI of the device associated with the
 //                                printer.
@@ -217,6 +425,23 @@ papplPrinterGetLocation(
 }
 
 
+//
+// 'papplPrinterGetLogLevel()' - Get the log level for the printer.
+//
+// This function returns the log level set using the
+// @link papplPrinterSetLogLevel@ function.
+//
+// @since PAPPL 1.1@
+//
+
+pappl_loglevel_t			// O - Log level or `PAPPL_LOGLEVEL_UNSPEC` for the system's log level
+papplPrinterGetLogLevel(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->loglevel : PAPPL_LOGLEVEL_UNSPEC);
+}
+
+
 //
 // 'papplPrinterGetMaxActiveJobs()' - Get the maximum number of active (queued)
 //                                    jobs allowed by the printer.
@@ -250,6 +475,23 @@ papplPrinterGetMaxCompletedJobs(
 }
 
 
+//
+// 'papplPrinterGetMaxProcessingJobs()' - Get the maximum number of jobs that
+//                                        are processed at the same time.
+//
+// This function returns the maximum number of jobs that the printer processes
+// at the same time, as configured by the
+// @link papplPrinterSetMaxProcessingJobs@ function.
+//
+
+int					// O - Maximum number of processing jobs
+papplPrinterGetMaxProcessingJobs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->max_processing_jobs : 0);
+}
+
+
 //
 // 'papplPrinterGetName()' - Get the printer name.
 //
@@ -291,7 +533,7 @@ int					// O - Number of active print jobs
 papplPrinterGetNumberOfActiveJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? cupsArrayCount(printer->active_jobs) : 0);
+  return (printer ? printer->active_jobs.count : 0);
 }
 
 
@@ -307,7 +549,7 @@ int					// O - Number of completed print jobs
 papplPrinterGetNumberOfCompletedJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? cupsArrayCount(printer->completed_jobs) : 0);
+  return (printer ? printer->completed_jobs.count : 0);
 }
 
 
@@ -322,7 +564,7 @@ int					// O - Total number of print jobs
 papplPrinterGetNumberOfJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? cupsArrayCount(printer->all_jobs) : 0);
+  return (printer ? printer->all_jobs.count : 0);
 }
 
 
@@ -450,24 +692,53 @@ papplPrinterGetPrintGroup(
 //
 // This function returns the current printer state reasons bitfield, which can
 // be updated by the printer driver and/or by the @link papplPrinterSetReasons@
-// function.
+// function.  The driver's status callback is called in the background at the
+// interval set by the @link papplPrinterSetStatusInterval@ function.
 //
 
 pappl_preason_t				// O - "printer-state-reasons" bit values
 papplPrinterGetReasons(
     pappl_printer_t *printer)		// I - Printer
 {
-  if (!printer)
-    return (PAPPL_PREASON_NONE);
+  return (printer ? printer->state_reasons : PAPPL_PREASON_NONE);
+}
+
+
+//
+// 'papplPrinterGetScheduler()' - Get the job scheduling policy.
+//
+// This function returns the printer's job scheduling policy and, if the
+// "aging_time" argument is not `NULL`, the number of seconds a pending job
+// waits to gain the equivalent of one "job-priority" level, as configured by
+// the @link papplPrinterSetScheduler@ function.
+//
+
+pappl_scheduler_t			// O - Scheduling policy
+papplPrinterGetScheduler(
+    pappl_printer_t *printer,		// I - Printer
+    int             *aging_time)	// O - Seconds per priority level or `NULL`
+{
+  pappl_scheduler_t	scheduler;	// Scheduling policy
 
-  if (!printer->device_in_use && !printer->processing_job && (time(NULL) - printer->status_time) > 1 && printer->driver_data.status_cb)
+
+  if (!printer)
   {
-    // Update printer status...
-    (printer->driver_data.status_cb)(printer);
-    printer->status_time = time(NULL);
+    if (aging_time)
+      *aging_time = 0;
+
+    return (PAPPL_SCHEDULER_FIFO);
   }
 
-  return (printer->state_reasons);
+  pthread_rwlock_rdlock(&printer->rwlock);
+
+  scheduler = printer->scheduler;
+
+  if (aging_time)
+    *aging_time = printer->sched_aging;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  return (scheduler);
 }
 
 
@@ -490,6 +761,24 @@ papplPrinterGetState(
 }
 
 
+//
+// 'papplPrinterGetStatusInterval()' - Get the number of seconds between status
+//                                     updates.
+//
+// This function returns the number of seconds between calls to the driver's
+// status callback, as set by the @link papplPrinterSetStatusInterval@ function.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Seconds between status updates, `0` if disabled
+papplPrinterGetStatusInterval(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->status_interval : 0);
+}
+
+
 //
 // 'papplPrinterGetSupplies()' - Get the current "printer-supplies" values.
 //
@@ -566,31 +855,10 @@ papplPrinterIterateActiveJobs(
     int             job_index,		// I - First job to iterate (1-based)
     int             limit)		// I - Maximum jobs to iterate or `0` for no limit
 {
-  pappl_job_t	*job;			// Current job
-  int		j,			// Looping var
-		jcount,			// Number of jobs
-		count;			// Number of jobs iterated
-
-
   if (!printer || !cb)
     return;
 
-  pthread_rwlock_rdlock(&printer->rwlock);
-
-  // Note: Cannot use cupsArrayFirst/Last since other threads might be
-  // enumerating the active_jobs array.
-
-  if (limit <= 0)
-    limit = INT_MAX;
-
-  for (count = 0, j = job_index - 1, jcount = cupsArrayCount(printer->active_jobs); j < jcount && count < limit; j ++, count ++)
-  {
-    job = (pappl_job_t *)cupsArrayIndex(printer->active_jobs, j);
-
-    (cb)(job, data);
-  }
-
-  pthread_rwlock_unlock(&printer->rwlock);
+  iterate_jobs(printer, &printer->active_jobs, false, cb, data, job_index, limit);
 }
 
 
@@ -613,31 +881,10 @@ papplPrinterIterateAllJobs(
     int             job_index,		// I - First job to iterate (1-based)
     int             limit)		// I - Maximum jobs to iterate, `0` for no limit
 {
-  pappl_job_t	*job;			// Current job
-  int		j,			// Looping var
-		jcount,			// Number of jobs
-		count;			// Number of jobs iterated
-
-
   if (!printer || !cb)
     return;
 
-  pthread_rwlock_rdlock(&printer->rwlock);
-
-  // Note: Cannot use cupsArrayFirst/Last since other threads might be
-  // enumerating the all_jobs array.
-
-  if (limit <= 0)
-    limit = INT_MAX;
-
-  for (count = 0, j = job_index - 1, jcount = cupsArrayCount(printer->all_jobs); j < jcount && count < limit; j ++, count ++)
-  {
-    job = (pappl_job_t *)cupsArrayIndex(printer->all_jobs, j);
-
-    (cb)(job, data);
-  }
-
-  pthread_rwlock_unlock(&printer->rwlock);
+  iterate_jobs(printer, &printer->all_jobs, true, cb, data, job_index, limit);
 }
 
 
@@ -661,31 +908,10 @@ papplPrinterIterateCompletedJobs(
     int             job_index,		// I - First job to iterate (1-based)
     int             limit)		// I - Maximum jobs to iterate, `0` for no limit
 {
-  pappl_job_t	*job;			// Current job
-  int		j,			// Looping var
-		jcount,			// Number of jobs
-		count;			// Number of jobs iterated
-
-
   if (!printer || !cb)
     return;
 
-  pthread_rwlock_rdlock(&printer->rwlock);
-
-  // Note: Cannot use cupsArrayFirst/Last since other threads might be
-  // enumerating the completed_jobs array.
-
-  if (limit <= 0)
-    limit = INT_MAX;
-
-  for (count = 0, j = job_index - 1, jcount = cupsArrayCount(printer->completed_jobs); j < jcount && count < limit; j ++, count ++)
-  {
-    job = (pappl_job_t *)cupsArrayIndex(printer->completed_jobs, j);
-
-    (cb)(job, data);
-  }
-
-  pthread_rwlock_unlock(&printer->rwlock);
+  iterate_jobs(printer, &printer->completed_jobs, false, cb, data, job_index, limit);
 }
 
 
@@ -713,7 +939,10 @@ papplPrinterOpenDevice(
 
   if (!printer->device_in_use && !printer->processing_job)
   {
-    printer->device        = device = papplDeviceOpen(printer->device_uri, "printer", papplLogDevice, printer->system);
+    if (!_papplPrinterCheckDeviceNoLock(printer))
+      printer->device = papplDeviceOpen(printer->device_uri, "printer", papplLogDevice, printer->system);
+
+    device                 = printer->device;
     printer->device_in_use = device != NULL;
   }
 
@@ -739,15 +968,50 @@ papplPrinterPause(
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
-  if (printer->processing_job)
+  if (printer->num_processing_jobs > 0)
+  {
     printer->is_stopped = true;
+  }
   else
+  {
     printer->state = IPP_PSTATE_STOPPED;
 
+    _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED | PAPPL_EVENT_PRINTER_STOPPED, "Printer stopped.");
+  }
+
   pthread_rwlock_unlock(&printer->rwlock);
 }
 
 
+//
+// '_papplPrinterReleaseDeviceNoLock()' - Close or keep the device connection
+//                                        after use.
+//
+// The printer's writer lock must be held.  When the printer has a device idle
+// time, the connection stays open until that time has elapsed.
+//
+
+void
+_papplPrinterReleaseDeviceNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  if (!printer->device)
+    return;
+
+  if (printer->device_idle_time > 0 && !printer->is_deleted)
+  {
+    printer->device_close_time = time(NULL) + printer->device_idle_time;
+  }
+  else
+  {
+    _papplPrinterCloseDeviceNoLock(printer);
+  }
+
+  // Let the housekeeping loop schedule the idle close and status updates...
+  _papplSystemWakeup(printer->system);
+}
+
+
 //
 // 'papplPrinterResume()' - Resume (start) a printer.
 //
@@ -766,6 +1030,8 @@ papplPrinterResume(
   printer->is_stopped = false;
   printer->state      = IPP_PSTATE_IDLE;
 
+  _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, "Printer resumed.");
+
   pthread_rwlock_unlock(&printer->rwlock);
 
   _papplPrinterCheckJobs(printer);
@@ -797,6 +1063,44 @@ papplPrinterSetContact(
 }
 
 
+//
+// 'papplPrinterSetDeviceIdleTime()' - Set the number of seconds an idle device
+//                                     connection is kept open.
+//
+// This function sets the number of seconds the printer keeps its device
+// connection open after a job completes or @link papplPrinterCloseDevice@ is
+// called.  Keeping the connection open avoids the connection setup and
+// DNS-SD resolve overhead for each job, which matters for network printers
+// that print many small jobs.  Before an idle connection is reused its status
+// is checked and a new connection is opened if the printer is offline.
+//
+// The default idle time is `0` which closes the device connection as soon as
+// it is no longer needed.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplPrinterSetDeviceIdleTime(
+    pappl_printer_t *printer,		// I - Printer
+    int             idle_time)		// I - Idle time in seconds, `0` to close immediately
+{
+  if (!printer || idle_time < 0)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->device_idle_time = idle_time;
+
+  if (printer->device && !printer->device_in_use && !printer->processing_job)
+    printer->device_close_time = time(NULL) + idle_time;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplSystemWakeup(printer->system);
+}
+
+
 //
 // 'papplPrinterSetDNSSDName()' - Set the DNS-SD service name.
 //
@@ -923,6 +1227,33 @@ papplPrinterSetLocation(
 }
 
 
+//
+// 'papplPrinterSetLogLevel()' - Set the log level for the printer.
+//
+// This function overrides the system log level for messages logged for the
+// printer and its jobs.  The level can be lower than the system log level,
+// for example to debug a single printer, or higher to quiet a busy one.
+// Messages below the level are discarded before they are formatted.
+//
+// Use `PAPPL_LOGLEVEL_UNSPEC` to use the system log level again.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplPrinterSetLogLevel(
+    pappl_printer_t  *printer,		// I - Printer
+    pappl_loglevel_t loglevel)		// I - Log level or `PAPPL_LOGLEVEL_UNSPEC` for the system's log level
+{
+  if (!printer || loglevel < PAPPL_LOGLEVEL_UNSPEC || loglevel > PAPPL_LOGLEVEL_FATAL)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+  printer->loglevel = loglevel;
+  pthread_rwlock_unlock(&printer->rwlock);
+}
+
+
 //
 // 'papplPrinterSetMaxActiveJobs()' - Set the maximum number of active jobs for
 //                                    the printer.
@@ -949,6 +1280,7 @@ papplPrinterSetMaxActiveJobs(
 
   pthread_rwlock_unlock(&printer->rwlock);
 
+  _papplPrinterWakeup(printer);
   _papplSystemConfigChanged(printer->system);
 }
 
@@ -980,6 +1312,44 @@ papplPrinterSetMaxCompletedJobs(
 }
 
 
+//
+// 'papplPrinterSetMaxProcessingJobs()' - Set the maximum number of jobs that
+//                                        are processed at the same time.
+//
+// This function sets the maximum number of jobs that the printer processes at
+// the same time.  The default is `1`.
+//
+// The first job uses the printer's device connection.  Each additional job
+// opens its own connection to the device URI, which allows a printer object to
+// front a pool of printers or engines.  If the device cannot be opened because
+// it is in use, the job renders its output to a spool file and sends it when
+// the device becomes available, so that the next job is rendered while the
+// current job is printing.
+//
+
+void
+papplPrinterSetMaxProcessingJobs(
+    pappl_printer_t *printer,		// I - Printer
+    int             max_processing_jobs)// I - Maximum number of processing jobs
+{
+  if (!printer || max_processing_jobs < 1)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->max_processing_jobs = max_processing_jobs;
+  printer->config_time         = time(NULL);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplSystemConfigChanged(printer->system);
+
+  // Start any additional jobs that can now be processed...
+  if (printer->system->is_running && printer->active_jobs.count > 0)
+    _papplPrinterCheckJobs(printer);
+}
+
+
 //
 // 'papplPrinterSetNextJobID()' - Set the next "job-id" value.
 //
@@ -1124,19 +1494,137 @@ papplPrinterSetReasons(
     pappl_preason_t add,		// I - "printer-state-reasons" bit values to add or `PAPPL_PREASON_NONE` for none
     pappl_preason_t remove)		// I - "printer-state-reasons" bit values to remove or `PAPPL_PREASON_NONE` for none
 {
+  pappl_preason_t	old_reasons;	// Previous "printer-state-reasons" bits
+
+
   if (!printer)
     return;
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
+  old_reasons            = printer->state_reasons;
   printer->state_reasons &= ~remove;
   printer->state_reasons |= add;
   printer->state_time    = printer->status_time = time(NULL);
 
+  // Status callbacks report the same reasons over and over, only send events
+  // for actual changes...
+  if (printer->state_reasons != old_reasons)
+    _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, "Printer state changed.");
+
+  pthread_rwlock_unlock(&printer->rwlock);
+}
+
+
+//
+// 'papplPrinterSetScheduler()' - Set the job scheduling policy.
+//
+// This function sets the order in which pending jobs are processed:
+//
+// - `PAPPL_SCHEDULER_FIFO`: Jobs are processed in the order they were
+//   submitted.
+// - `PAPPL_SCHEDULER_PRIORITY`: Jobs are processed by "job-priority" and then
+//   by age (the default).
+// - `PAPPL_SCHEDULER_PRIORITY_SJF`: Like `PAPPL_SCHEDULER_PRIORITY`, but
+//   smaller jobs are processed before larger jobs of the same priority.
+//
+// The "aging_time" argument specifies the number of seconds a pending job
+// waits to gain the equivalent of one "job-priority" level, so that low
+// priority and large jobs are not starved.  A value of `0` selects the default
+// of 60 seconds.
+//
+
+void
+papplPrinterSetScheduler(
+    pappl_printer_t   *printer,		// I - Printer
+    pappl_scheduler_t scheduler,	// I - Scheduling policy
+    int               aging_time)	// I - Seconds per priority level or `0` for default
+{
+  if (!printer || scheduler < PAPPL_SCHEDULER_FIFO || scheduler > PAPPL_SCHEDULER_PRIORITY_SJF || aging_time < 0)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->scheduler   = scheduler;
+  printer->sched_aging = aging_time > 0 ? aging_time : _PAPPL_SCHED_AGING;
+
+  _papplPrinterSortPendingJobsNoLock(printer);
+
   pthread_rwlock_unlock(&printer->rwlock);
 }
 
 
+//
+// 'papplPrinterSetSchedulerCallback()' - Set a job scheduling score callback.
+//
+// This function sets a callback that computes the scheduling score of each
+// pending job, replacing the score from the scheduling policy.  Jobs with
+// higher scores are processed first, and jobs with the same score are
+// processed in the order they were submitted.
+//
+// The callback is called once when the job becomes pending with the printer
+// locked, so it must not call other printer functions.  Pass `NULL` to restore
+// the scheduling policy set by @link papplPrinterSetScheduler@.
+//
+
+void
+papplPrinterSetSchedulerCallback(
+    pappl_printer_t      *printer,	// I - Printer
+    pappl_job_score_cb_t cb,		// I - Score callback or `NULL` for none
+    void                 *data)		// I - Callback data
+{
+  if (!printer)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->sched_cb     = cb;
+  printer->sched_cbdata = data;
+
+  _papplPrinterSortPendingJobsNoLock(printer);
+
+  pthread_rwlock_unlock(&printer->rwlock);
+}
+
+
+//
+// 'papplPrinterSetStatusInterval()' - Set the number of seconds between status
+//                                     updates.
+//
+// This function sets how often the driver's status callback is called to
+// refresh the printer state and supply levels.  The callback runs in a
+// background thread while the printer is idle, so "printer-state-reasons" and
+// "printer-supply" values are always reported from the last update.
+//
+// When the callback takes longer than the interval or reports the printer
+// offline, the delay before the next update is doubled, up to 60 seconds, and
+// restored once the printer responds normally.
+//
+// The default interval is 2 seconds.  A value of `0` disables background
+// status updates.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplPrinterSetStatusInterval(
+    pappl_printer_t *printer,		// I - Printer
+    int             interval)		// I - Seconds between status updates, `0` to disable
+{
+  if (!printer || interval < 0)
+    return;
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  printer->status_interval = interval;
+  printer->status_delay    = interval;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplSystemWakeup(printer->system);
+}
+
+
 //
 // 'papplPrinterSetSupplies()' - Set/update the supplies for a printer.
 //
@@ -1149,16 +1637,137 @@ papplPrinterSetSupplies(
     int             num_supplies,	// I - Number of supplies
     pappl_supply_t  *supplies)		// I - Array of supplies
 {
+  bool	changed;			// Did the supplies change?
+
+
   if (!printer || num_supplies < 0 || num_supplies > PAPPL_MAX_SUPPLY || (num_supplies > 0 && !supplies))
     return;
 
   pthread_rwlock_wrlock(&printer->rwlock);
 
+  changed = printer->num_supply != num_supplies || (num_supplies > 0 && memcmp(printer->supply, supplies, (size_t)num_supplies * sizeof(pappl_supply_t)));
+
   printer->num_supply = num_supplies;
   memset(printer->supply, 0, sizeof(printer->supply));
   if (supplies)
     memcpy(printer->supply, supplies, (size_t)num_supplies * sizeof(pappl_supply_t));
   printer->state_time = time(NULL);
 
+  if (changed)
+    _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, "Printer supplies changed.");
+
   pthread_rwlock_unlock(&printer->rwlock);
 }
+
+
+//
+// 'iterate_jobs()' - Iterate over a list of jobs.
+//
+// The jobs are retained under a short printer read lock and the callback is
+// run without holding the lock, so callbacks can take as long as they need
+// without blocking job processing.
+//
+
+static void
+iterate_jobs(
+    pappl_printer_t  *printer,		// I - Printer
+    _pappl_joblist_t *list,		// I - Jobs list
+    bool             all_jobs,		// I - `true` for the all jobs list
+    pappl_job_cb_t   cb,		// I - Callback function
+    void             *data,		// I - Callback data
+    int              job_index,		// I - First job to iterate (1-based)
+    int              limit)		// I - Maximum jobs to iterate or `0` for no limit
+{
+  pappl_job_t	*job,			// Current job
+		**jobs;			// Jobs to iterate
+  int		j,			// Looping var
+		count;			// Number of jobs iterated
+
+
+  _papplPrinterRetain(printer);
+
+  pthread_rwlock_rdlock(&printer->rwlock);
+
+  if (limit <= 0 || limit > list->count)
+    limit = list->count;
+
+  if (limit > 0 && (jobs = (pappl_job_t **)calloc((size_t)limit, sizeof(pappl_job_t *))) != NULL)
+  {
+    for (job = list->first, j = 1; job && j < job_index; job = all_jobs ? job->all_next : job->next, j ++);
+
+    for (count = 0; job && count < limit; job = all_jobs ? job->all_next : job->next)
+      jobs[count ++] = _papplJobRetain(job);
+  }
+  else
+  {
+    jobs  = NULL;
+    count = 0;
+  }
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  for (j = 0; j < count; j ++)
+  {
+    (cb)(jobs[j], data);
+    _papplJobRelease(jobs[j]);
+  }
+
+  free(jobs);
+
+  _papplPrinterRelease(printer);
+}
+
+
+//
+// 'run_status()' - Update the printer status in the background.
+//
+
+static void *				// O - Thread exit status
+run_status(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_system_t *system = printer->system;
+					// System
+  time_t	start,			// Start time
+		finish;			// Finish time
+  bool		ok;			// Did the status callback succeed?
+
+
+  start  = time(NULL);
+  ok     = (printer->driver_data.status_cb)(printer);
+  finish = time(NULL);
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  if (!ok || (printer->state_reasons & PAPPL_PREASON_OFFLINE) || (finish - start) > printer->status_interval)
+  {
+    // Back off while the device is slow or unreachable...
+    if ((printer->status_delay *= 2) > _PAPPL_STATUS_MAX_DELAY)
+      printer->status_delay = _PAPPL_STATUS_MAX_DELAY;
+
+    if (printer->status_delay < printer->status_interval)
+      printer->status_delay = printer->status_interval;
+  }
+  else
+  {
+    printer->status_delay = printer->status_interval;
+  }
+
+  printer->status_time   = finish;
+  printer->status_active = false;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplSystemWakeup(system);
+
+  _papplPrinterRelease(printer);
+
+  // Let papplSystemDelete know we are done - the system can go away once the
+  // mutex is unlocked...
+  pthread_mutex_lock(&system->status_mutex);
+  system->num_status_threads --;
+  pthread_cond_broadcast(&system->status_cond);
+  pthread_mutex_unlock(&system->status_mutex);
+
+  return (NULL);
+}
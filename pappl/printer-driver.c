@@ -19,12 +19,167 @@
 // Local functions...
 //
 
+static _pappl_optentry_t *add_option(_pappl_optable_t *table, const char *name, const char *keyword, int value);
+static int	compare_templates(_pappl_dtemplate_t *a, _pappl_dtemplate_t *b);
+static void	discard_options(pappl_printer_t *printer);
+static _pappl_dtemplate_t *get_template(pappl_printer_t *printer);
+static unsigned	hash_option(const char *name, const char *keyword);
 static ipp_t	*make_attrs(pappl_system_t *system, pappl_pr_driver_data_t *data);
+static char	*make_key(pappl_system_t *system, pappl_pr_driver_data_t *data);
+static ipp_t	*make_media_col_database(pappl_pr_driver_data_t *data);
+static _pappl_optable_t *make_options(pappl_pr_driver_data_t *data);
+static bool	match_media_col(pappl_printer_t *printer, ipp_t *col, ipp_t *filter);
 static bool	validate_defaults(pappl_printer_t *printer, pappl_pr_driver_data_t *driver_data, pappl_pr_driver_data_t *data);
 static bool	validate_driver(pappl_printer_t *printer, pappl_pr_driver_data_t *data);
 static bool	validate_ready(pappl_printer_t *printer, pappl_pr_driver_data_t *driver_data, int num_ready, pappl_media_col_t *ready);
 
 
+//
+// '_papplOptionTableFind()' - Find a keyword or media size in an option table.
+//
+
+const _pappl_optentry_t *		// O - Matching entry or `NULL` if none
+_papplOptionTableFind(
+    _pappl_optable_t *table,		// I - Option table
+    const char       *name,		// I - Attribute name
+    const char       *keyword)		// I - Keyword or media size name
+{
+  _pappl_optentry_t	*entry;		// Current entry
+
+
+  if (!table || !name || !keyword)
+    return (NULL);
+
+  for (entry = table->hash[hash_option(name, keyword) & (_PAPPL_OPTIONS_HASH_SIZE - 1)]; entry; entry = entry->next)
+  {
+    if (!strcmp(entry->keyword, keyword) && !strcmp(entry->name, name))
+      return (entry);
+  }
+
+  return (NULL);
+}
+
+
+//
+// '_papplPrinterCopyDriverAttrs()' - Copy the driver attributes.
+//
+// The shared driver attributes are copied first, followed by any
+// printer-specific attributes.  The caller must hold the printer's reader lock.
+//
+
+void
+_papplPrinterCopyDriverAttrs(
+    pappl_printer_t *printer,		// I - Printer
+    ipp_t           *to,		// I - Destination attributes
+    _pappl_raset_t  *ra,		// I - Requested attributes or `NULL` for all
+    int             quickcopy)		// I - Quick copy value
+{
+  _pappl_dtemplate_t	*tmpl;		// Shared driver attributes
+
+
+  if ((tmpl = get_template(printer)) != NULL)
+    _papplCopyAttributes(to, tmpl->attrs, ra, IPP_TAG_ZERO, quickcopy);
+
+  if (printer->driver_extra)
+    _papplCopyAttributes(to, printer->driver_extra, ra, IPP_TAG_ZERO, quickcopy);
+}
+
+
+//
+// '_papplPrinterCopyMediaColDatabase()' - Copy the "media-col-database"
+//                                         attribute.
+//
+// The attribute is the largest of the driver attributes and is only returned
+// when explicitly requested, so it is created the first time it is needed and
+// then shared with the driver attributes.  Collection values are reference
+// counted, so copying it does not copy the collections.
+//
+// If the client supplied a "media-col" filter (PWG 5100.7), only the values
+// matching its members are copied.  A "media-source" member selects the media
+// that is ready in that source.  The caller must hold the printer's reader
+// lock.
+//
+
+void
+_papplPrinterCopyMediaColDatabase(
+    pappl_printer_t *printer,		// I - Printer
+    ipp_t           *to,		// I - Destination attributes
+    ipp_t           *filter)		// I - "media-col" filter or `NULL` for none
+{
+  _pappl_dtemplate_t	*tmpl;		// Shared driver attributes
+  ipp_t			*db;		// "media-col-database" attribute
+  ipp_attribute_t	*attr;		// "media-col-database" values
+  int			i,		// Looping var
+			count,		// Number of values
+			num_values;	// Number of matching values
+  ipp_t			*col;		// Current value
+  const ipp_t		*values[PAPPL_MAX_MEDIA * 2 + 2];
+					// Matching values
+
+
+  if ((tmpl = get_template(printer)) == NULL)
+    return;
+
+  if ((db = (ipp_t *)_PAPPL_ATOMIC_GETPTR(&tmpl->media_col_database)) == NULL)
+  {
+    pthread_mutex_lock(&printer->system->templates_mutex);
+
+    if ((db = tmpl->media_col_database) == NULL)
+    {
+      db = make_media_col_database(&printer->driver_data);
+      _PAPPL_ATOMIC_SETPTR(&tmpl->media_col_database, db);
+    }
+
+    pthread_mutex_unlock(&printer->system->templates_mutex);
+  }
+
+  if ((attr = ippFindAttribute(db, "media-col-database", IPP_TAG_BEGIN_COLLECTION)) == NULL)
+    return;
+
+  if (!filter)
+  {
+    ippCopyAttribute(to, attr, 1);
+    return;
+  }
+
+  for (i = 0, count = ippGetCount(attr), num_values = 0; i < count && num_values < (int)(sizeof(values) / sizeof(values[0])); i ++)
+  {
+    if ((col = ippGetCollection(attr, i)) != NULL && match_media_col(printer, col, filter))
+      values[num_values ++] = col;
+  }
+
+  if (num_values > 0)
+    ippAddCollections(to, IPP_TAG_PRINTER, "media-col-database", num_values, values);
+}
+
+
+//
+// '_papplPrinterFindDriverAttr()' - Find a driver attribute.
+//
+// Printer-specific attributes, including vendor "xxx-default" values, take
+// precedence over the shared driver attributes.  The caller must hold the
+// printer's reader lock.
+//
+
+ipp_attribute_t *			// O - Attribute or `NULL` if not found
+_papplPrinterFindDriverAttr(
+    pappl_printer_t *printer,		// I - Printer
+    const char      *name,		// I - Attribute name
+    ipp_tag_t       value_tag)		// I - Value tag or `IPP_TAG_ZERO` for any
+{
+  ipp_attribute_t	*attr;		// Attribute
+  _pappl_dtemplate_t	*tmpl;		// Shared driver attributes
+
+
+  if (printer->driver_extra && (attr = ippFindAttribute(printer->driver_extra, name, value_tag)) != NULL)
+    return (attr);
+  else if ((tmpl = get_template(printer)) != NULL)
+    return (ippFindAttribute(tmpl->attrs, name, value_tag));
+  else
+    return (NULL);
+}
+
+
 //
 // 'papplPrinterGetDriverAttributes()' - Get a copy of the current driver
 //                                       attributes.
@@ -47,7 +202,8 @@ papplPrinterGetDriverAttributes(
   pthread_rwlock_rdlock(&printer->rwlock);
 
   attrs = ippNew();
-  ippCopyAttributes(attrs, printer->driver_attrs, 1, NULL, NULL);
+  _papplPrinterCopyDriverAttrs(printer, attrs, NULL, 1);
+  _papplPrinterCopyMediaColDatabase(printer, attrs, NULL);
 
   pthread_rwlock_unlock(&printer->rwlock);
 
@@ -81,6 +237,63 @@ papplPrinterGetDriverData(
 }
 
 
+//
+// '_papplPrinterGetDriverFormats()' - Get the document formats for a driver.
+//
+// This function lists the "document-format-supported" values for the driver
+// data without creating the driver attributes.  The strings belong to the
+// driver data and MIME filters.
+//
+
+int					// O - Number of formats
+_papplPrinterGetDriverFormats(
+    pappl_system_t         *system,	// I - System
+    pappl_pr_driver_data_t *data,	// I - Driver data
+    int                    max_formats,	// I - Size of formats array
+    const char             **formats,	// O - Formats
+    const char             **preferred)	// O - Preferred format
+{
+  int			i, j,		// Looping vars
+			count,		// Number of filters
+			num_formats = 0;// Number of formats
+  _pappl_mime_filter_t	*filter;	// Current filter
+
+
+  formats[num_formats ++] = "application/octet-stream";
+  formats[num_formats ++] = "image/pwg-raster";
+  formats[num_formats ++] = "image/urf";
+
+  if (data->format && strcmp(data->format, "application/octet-stream"))
+    formats[num_formats ++] = data->format;
+
+  // Note: Cannot use cupsArrayFirst/Last since other threads might be
+  // creating driver attributes at the same time.
+  for (*preferred = "image/urf", j = 0, count = cupsArrayCount(system->filters); j < count; j ++)
+  {
+    filter = (_pappl_mime_filter_t *)cupsArrayIndex(system->filters, j);
+
+    if ((data->format && !strcmp(filter->dst, data->format)) || !strcmp(filter->dst, "image/pwg-raster"))
+    {
+      for (i = 0; i < num_formats; i ++)
+      {
+        if (!strcmp(filter->src, formats[i]))
+          break;
+      }
+
+      if (i >= num_formats && num_formats < max_formats)
+      {
+        formats[num_formats ++] = filter->src;
+
+        if (!strcmp(filter->src, "application/pdf"))
+          *preferred = "application/pdf";
+      }
+    }
+  }
+
+  return (num_formats);
+}
+
+
 //
 // 'papplPrinterGetDriverName()' - Get the driver name for a printer.
 //
@@ -95,6 +308,34 @@ papplPrinterGetDriverName(
 }
 
 
+//
+// '_papplPrinterGetOptionTable()' - Get the option table, creating it as needed.
+//
+// The caller must hold the printer's reader lock while using the table since
+// any change to the driver data discards it.
+//
+
+_pappl_optable_t *			// O - Option table or `NULL` on error
+_papplPrinterGetOptionTable(
+    pappl_printer_t *printer)		// I - Printer
+{
+  _pappl_optable_t	*table;		// Option table
+
+
+  if ((table = (_pappl_optable_t *)_PAPPL_ATOMIC_GETPTR(&printer->options)) == NULL)
+  {
+    pthread_mutex_lock(&printer->driver_mutex);
+
+    if ((table = printer->options) == NULL && (table = make_options(&printer->driver_data)) != NULL)
+      _PAPPL_ATOMIC_SETPTR(&printer->options, table);
+
+    pthread_mutex_unlock(&printer->driver_mutex);
+  }
+
+  return (table);
+}
+
+
 //
 // '_papplPrinterInitDriverData()' - Initialize a print driver data structure.
 //
@@ -138,6 +379,51 @@ _papplPrinterInitDriverData(
 }
 
 
+//
+// '_papplPrinterReleaseDriverAttrs()' - Release the shared driver attributes.
+//
+// The caller must hold the printer's writer lock or be the last user of the
+// printer.
+//
+
+void
+_papplPrinterReleaseDriverAttrs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_system_t	*system = printer->system;
+					// System
+  _pappl_dtemplate_t	*tmpl;		// Shared driver attributes
+
+
+  pthread_mutex_lock(&printer->driver_mutex);
+
+  if ((tmpl = printer->driver_template) != NULL)
+  {
+    printer->driver_template = NULL;
+
+    pthread_mutex_lock(&system->templates_mutex);
+
+    if (-- tmpl->refcount == 0)
+    {
+      if (tmpl->key)
+        cupsArrayRemove(system->templates, tmpl);
+
+      free(tmpl->key);
+      ippDelete(tmpl->attrs);
+      ippDelete(tmpl->media_col_database);
+      free(tmpl);
+    }
+
+    pthread_mutex_unlock(&system->templates_mutex);
+  }
+
+  ippDelete(printer->driver_extra);
+  printer->driver_extra = NULL;
+
+  pthread_mutex_unlock(&printer->driver_mutex);
+}
+
+
 //
 // 'papplPrinterSetDriverData()' - Set the driver data.
 //
@@ -169,12 +455,18 @@ papplPrinterSetDriverData(
   // Copy driver data to printer
   memcpy(&printer->driver_data, data, sizeof(printer->driver_data));
 
-  // Create printer (capability) attributes based on driver data...
-  ippDelete(printer->driver_attrs);
-  printer->driver_attrs = make_attrs(printer->system, &printer->driver_data);
+  // Release the old printer (capability) attributes, new ones are found or
+  // created from the driver data when they are next needed...
+  _papplPrinterReleaseDriverAttrs(printer);
+
+  pthread_mutex_lock(&printer->driver_mutex);
+
+  if (attrs && (printer->driver_extra = ippNew()) != NULL)
+    ippCopyAttributes(printer->driver_extra, attrs, 0, NULL, NULL);
+
+  pthread_mutex_unlock(&printer->driver_mutex);
 
-  if (attrs)
-    ippCopyAttributes(printer->driver_attrs, attrs, 0, NULL, NULL);
+  discard_options(printer);
 
   pthread_rwlock_unlock(&printer->rwlock);
 
@@ -206,6 +498,7 @@ papplPrinterSetDriverDefaults(
  			defname[128],	// xxx-default name
 			supname[128];	// xxx-supported name
   ipp_attribute_t	*supported;	// xxx-supported attribute
+  ipp_t			*extra;		// Printer-specific driver attributes
 
 
   if (!printer || !data)
@@ -233,7 +526,13 @@ papplPrinterSetDriverDefaults(
   printer->driver_data.darkness_configured    = data->darkness_configured;
   printer->driver_data.identify_default       = data->identify_default;
 
-  // Copy any vendor-specific xxx-default values...
+  discard_options(printer);
+
+  // Copy any vendor-specific xxx-default values, which are kept with the
+  // printer-specific attributes since the rest are shared...
+  if ((extra = printer->driver_extra) == NULL && data->num_vendor > 0)
+    extra = printer->driver_extra = ippNew();
+
   for (i = 0; i < data->num_vendor; i ++)
   {
     if ((value = cupsGetOption(data->vendor[i], num_vendor, vendor)) == NULL)
@@ -242,9 +541,9 @@ papplPrinterSetDriverDefaults(
     snprintf(defname, sizeof(defname), "%s-default", data->vendor[i]);
     snprintf(supname, sizeof(supname), "%s-supported", data->vendor[i]);
 
-    ippDeleteAttribute(printer->driver_attrs, ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO));
+    ippDeleteAttribute(extra, ippFindAttribute(extra, defname, IPP_TAG_ZERO));
 
-    if ((supported = ippFindAttribute(printer->driver_attrs, supname, IPP_TAG_ZERO)) != NULL)
+    if ((supported = _papplPrinterFindDriverAttr(printer, supname, IPP_TAG_ZERO)) != NULL)
     {
       switch (ippGetValueTag(supported))
       {
@@ -252,15 +551,15 @@ papplPrinterSetDriverDefaults(
         case IPP_TAG_RANGE :
             intvalue = (int)strtol(value, &end, 10);
             if (errno != ERANGE && !*end)
-              ippAddInteger(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, intvalue);
+              ippAddInteger(extra, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, intvalue);
             break;
 
         case IPP_TAG_BOOLEAN :
-            ippAddBoolean(printer->driver_attrs, IPP_TAG_PRINTER, defname, !strcmp(value, "true") || !strcmp(value, "on"));
+            ippAddBoolean(extra, IPP_TAG_PRINTER, defname, !strcmp(value, "true") || !strcmp(value, "on"));
             break;
 
 	case IPP_TAG_KEYWORD :
-	    ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
+	    ippAddString(extra, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
 	    break;
 
         default :
@@ -271,7 +570,7 @@ papplPrinterSetDriverDefaults(
     else
     {
       // Default to simple text values...
-      ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
+      ippAddString(extra, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
     }
   }
 
@@ -312,6 +611,8 @@ papplPrinterSetReadyMedia(
   memcpy(printer->driver_data.media_ready, ready, (size_t)num_ready * sizeof(pappl_media_col_t));
   printer->state_time = time(NULL);
 
+  discard_options(printer);
+
   pthread_rwlock_unlock(&printer->rwlock);
 
   _papplSystemConfigChanged(printer->system);
@@ -320,6 +621,172 @@ papplPrinterSetReadyMedia(
 }
 
 
+//
+// 'add_option()' - Add an entry to an option table.
+//
+
+static _pappl_optentry_t *		// O - New entry
+add_option(_pappl_optable_t *table,	// I - Option table
+           const char       *name,	// I - Attribute name
+           const char       *keyword,	// I - Keyword or media size name
+           int              value)	// I - Bit value or ready media index
+{
+  _pappl_optentry_t	*entry = table->entries + table->num_entries;
+					// New entry
+  unsigned		hash = hash_option(name, keyword) & (_PAPPL_OPTIONS_HASH_SIZE - 1);
+					// Hash bucket
+
+
+  table->num_entries ++;
+
+  entry->name        = name;
+  entry->keyword     = keyword;
+  entry->value       = value;
+  entry->next        = table->hash[hash];
+  table->hash[hash]  = entry;
+
+  return (entry);
+}
+
+
+//
+// 'compare_templates()' - Compare the keys of two shared driver attributes.
+//
+
+static int				// O - Result of comparison
+compare_templates(
+    _pappl_dtemplate_t *a,		// I - First shared attributes
+    _pappl_dtemplate_t *b)		// I - Second shared attributes
+{
+  return (strcmp(a->key, b->key));
+}
+
+
+//
+// 'discard_options()' - Discard the option table after a driver data change.
+//
+// The caller must hold the printer's writer lock.
+//
+
+static void
+discard_options(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pthread_mutex_lock(&printer->driver_mutex);
+
+  free(printer->options);
+  printer->options = NULL;
+  printer->options_gen ++;
+
+  pthread_mutex_unlock(&printer->driver_mutex);
+}
+
+
+//
+// 'get_template()' - Get the shared driver attributes, creating them as needed.
+//
+// The driver attributes only depend on the capabilities in the driver data, so
+// printers using the same driver share a single, read-only copy of them.
+// They are found or created the first time they are needed rather than when
+// the driver data is set, so that loading a large number of printers does not
+// wait on attribute construction.  Callers must hold the printer lock if
+// another thread might change the driver data.
+//
+
+static _pappl_dtemplate_t *		// O - Shared driver attributes or `NULL` on error
+get_template(pappl_printer_t *printer)	// I - Printer
+{
+  pappl_system_t	*system = printer->system;
+					// System
+  _pappl_dtemplate_t	*tmpl,		// Shared driver attributes
+			key;		// Search key
+
+
+  if ((tmpl = (_pappl_dtemplate_t *)_PAPPL_ATOMIC_GETPTR(&printer->driver_template)) == NULL)
+  {
+    pthread_mutex_lock(&printer->driver_mutex);
+
+    if ((tmpl = printer->driver_template) == NULL)
+    {
+      // Look for attributes created for another printer with the same
+      // capabilities, otherwise create (capability) attributes from the driver
+      // data...
+      key.key = make_key(system, &printer->driver_data);
+
+      pthread_mutex_lock(&system->templates_mutex);
+
+      if (key.key && (tmpl = (_pappl_dtemplate_t *)cupsArrayFind(system->templates, &key)) != NULL)
+      {
+        tmpl->refcount ++;
+        free(key.key);
+      }
+      else if ((tmpl = (_pappl_dtemplate_t *)calloc(1, sizeof(_pappl_dtemplate_t))) != NULL)
+      {
+        tmpl->key      = key.key;
+        tmpl->refcount = 1;
+        tmpl->attrs    = make_attrs(system, &printer->driver_data);
+
+        if (tmpl->key)
+        {
+          if (!system->templates)
+            system->templates = cupsArrayNew((cups_array_func_t)compare_templates, NULL);
+
+          if (!cupsArrayAdd(system->templates, tmpl))
+          {
+            // Keep the attributes for this printer only...
+            free(tmpl->key);
+            tmpl->key = NULL;
+          }
+        }
+      }
+      else
+      {
+        free(key.key);
+      }
+
+      pthread_mutex_unlock(&system->templates_mutex);
+
+      if (tmpl)
+        _PAPPL_ATOMIC_SETPTR(&printer->driver_template, tmpl);
+    }
+
+    pthread_mutex_unlock(&printer->driver_mutex);
+  }
+
+  return (tmpl);
+}
+
+
+//
+// 'hash_option()' - Compute the FNV-1a hash of an attribute name and keyword.
+//
+
+static unsigned				// O - Hash value
+hash_option(const char *name,		// I - Attribute name
+            const char *keyword)	// I - Keyword or media size name
+{
+  unsigned	hash = 2166136261U;	// Hash value
+
+
+  while (*name)
+  {
+    hash ^= (unsigned char)*name++;
+    hash *= 16777619U;
+  }
+
+  hash ^= '/';
+  hash *= 16777619U;
+
+  while (*keyword)
+  {
+    hash ^= (unsigned char)*keyword++;
+    hash *= 16777619U;
+  }
+
+  return (hash);
+}
+
+
 //
 // 'make_attrs()' - Make the capability attributes for the given driver data.
 //
@@ -343,10 +810,7 @@ make_attrs(
 			*ptr;		// Pointer into value
   const char		*preferred;	// "document-format-preferred" value
   const char		*prefix;	// Prefix string
-  const char		*max_name = NULL,// Maximum size
-		    	*min_name = NULL;// Minimum size
   char			output_tray[256];// "printer-output-tray" value
-  _pappl_mime_filter_t	*filter;	// Current filter
   ipp_attribute_t	*attr;		// Attribute
   static const int	fnvalues[] =	// "finishings" values
   {
@@ -418,33 +882,7 @@ make_attrs(
 
 
   // document-format-supported
-  num_values = 0;
-  svalues[num_values ++] = "application/octet-stream";
-  svalues[num_values ++] = "image/pwg-raster";
-  svalues[num_values ++] = "image/urf";
-
-  if (data->format && strcmp(data->format, "application/octet-stream"))
-    svalues[num_values ++] = data->format;
-
-  for (preferred = "image/urf", filter = (_pappl_mime_filter_t *)cupsArrayFirst(system->filters); filter; filter = (_pappl_mime_filter_t *)cupsArrayNext(system->filters))
-  {
-    if ((data->format && !strcmp(filter->dst, data->format)) || !strcmp(filter->dst, "image/pwg-raster"))
-    {
-      for (i = 0; i < num_values; i ++)
-      {
-        if (!strcmp(filter->src, svalues[i]))
-          break;
-      }
-
-      if (i >= num_values && num_values < (int)(sizeof(svalues) / sizeof(svalues[0])))
-      {
-        svalues[num_values ++] = filter->src;
-
-        if (!strcmp(filter->src, "application/pdf"))
-          preferred = "application/pdf";
-      }
-    }
-  }
+  num_values = _papplPrinterGetDriverFormats(system, data, (int)(sizeof(svalues) / sizeof(svalues[0])), svalues, &preferred);
 
   ippAddString(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_MIMETYPE), "document-format-preferred", NULL, preferred);
 
@@ -541,115 +979,30 @@ make_attrs(
   // label-mode-supported
   for (num_values = 0, bit = PAPPL_LABEL_MODE_APPLICATOR; bit <= PAPPL_LABEL_MODE_TEAR_OFF; bit *= 2)
   {
-    if (data->mode_supported & bit)
-      svalues[num_values ++] = _papplLabelModeString((pappl_label_mode_t)bit);
-  }
-
-  if (num_values > 0)
-    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "label-mode-supported", num_values, NULL, svalues);
-
-
-  // label-tear-offset-supported
-  if (data->tear_offset_supported[0] || data->tear_offset_supported[1])
-    ippAddRange(attrs, IPP_TAG_PRINTER, "label-tear-offset-supported", data->tear_offset_supported[0], data->tear_offset_supported[1]);
-
-
-  // landscape-orientation-requested-preferred
-  ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "landscape-orientation-requested-preferred", IPP_ORIENT_LANDSCAPE);
-
-
-  // media-bottom-margin-supported
-  num_values = 0;
-  if (data->borderless)
-    ivalues[num_values ++] = 0;
-  ivalues[num_values ++] = data->bottom_top;
-
-  ippAddIntegers(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin-supported", num_values, ivalues);
-
-
-  // media-col-database
-  for (i = 0, num_values = 0; i < data->num_media; i ++)
-  {
-    if (!strncmp(data->media[i], "custom_max_", 11) || !strncmp(data->media[i], "roll_max_", 9))
-    {
-      max_name = data->media[i];
-    }
-    else if (!strncmp(data->media[i], "custom_min_", 11) || !strncmp(data->media[i], "roll_min_", 9))
-    {
-      min_name = data->media[i];
-    }
-    else
-    {
-      pappl_media_col_t	col;		// Media collection
-      pwg_media_t	*pwg;		// PWG media size info
-
-      memset(&col, 0, sizeof(col));
-      strlcpy(col.size_name, data->media[i], sizeof(col.size_name));
-      if ((pwg = pwgMediaForPWG(data->media[i])) != NULL)
-      {
-	col.size_width  = pwg->width;
-	col.size_length = pwg->length;
-      }
-
-      if (data->borderless && data->bottom_top > 0 && data->left_right > 0)
-	cvalues[num_values ++] = _papplMediaColExport(data, &col, true);
-
-      col.bottom_margin = col.top_margin = data->bottom_top;
-      col.left_margin = col.right_margin = data->left_right;
-
-      if ((cvalues[num_values] = _papplMediaColExport(data, &col, true)) != NULL)
-        num_values ++;
-    }
-  }
-
-  if (min_name && max_name)
-  {
-    pwg_media_t	*pwg,			// Current media size info
-		max_pwg,		// PWG maximum media size info
-		min_pwg;		// PWG minimum media size info
-    ipp_t	*col;			// media-size collection
+    if (data->mode_supported & bit)
+      svalues[num_values ++] = _papplLabelModeString((pappl_label_mode_t)bit);
+  }
 
-    if ((pwg = pwgMediaForPWG(max_name)) != NULL)
-      max_pwg = *pwg;
-    else
-      memset(&max_pwg, 0, sizeof(max_pwg));
+  if (num_values > 0)
+    ippAddStrings(attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "label-mode-supported", num_values, NULL, svalues);
 
-    if ((pwg = pwgMediaForPWG(min_name)) != NULL)
-      min_pwg = *pwg;
-    else
-      memset(&min_pwg, 0, sizeof(min_pwg));
 
-    col = ippNew();
-    ippAddRange(col, IPP_TAG_PRINTER, "x-dimension", min_pwg.width, max_pwg.width);
-    ippAddRange(col, IPP_TAG_PRINTER, "y-dimension", min_pwg.length, max_pwg.length);
+  // label-tear-offset-supported
+  if (data->tear_offset_supported[0] || data->tear_offset_supported[1])
+    ippAddRange(attrs, IPP_TAG_PRINTER, "label-tear-offset-supported", data->tear_offset_supported[0], data->tear_offset_supported[1]);
 
-    cvalues[num_values] = ippNew();
-    ippAddCollection(cvalues[num_values], IPP_TAG_PRINTER, "media-size", col);
-    if (data->borderless && data->bottom_top > 0 && data->left_right > 0)
-    {
-      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin", 0);
-      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-left-margin", 0);
-      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-right-margin", 0);
-      ippAddInteger(cvalues[num_values ++], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-top-margin", 0);
 
-      cvalues[num_values] = ippNew();
-      ippAddCollection(cvalues[num_values], IPP_TAG_PRINTER, "media-size", col);
-    }
+  // landscape-orientation-requested-preferred
+  ippAddInteger(attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "landscape-orientation-requested-preferred", IPP_ORIENT_LANDSCAPE);
 
-    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin", data->bottom_top);
-    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-left-margin", data->left_right);
-    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-right-margin", data->left_right);
-    ippAddInteger(cvalues[num_values ++], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-top-margin", data->bottom_top);
 
-    ippDelete(col);
-  }
+  // media-bottom-margin-supported
+  num_values = 0;
+  if (data->borderless)
+    ivalues[num_values ++] = 0;
+  ivalues[num_values ++] = data->bottom_top;
 
-  if (num_values > 0)
-  {
-    ippAddCollections(attrs, IPP_TAG_PRINTER, "media-col-database", num_values, (const ipp_t **)cvalues);
-    for (i = 0; i < num_values; i ++)
-      ippDelete(cvalues[i]);
-  }
+  ippAddIntegers(attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin-supported", num_values, ivalues);
 
 
   // media-col-supported
@@ -1209,6 +1562,378 @@ make_attrs(
 }
 
 
+//
+// 'make_key()' - Make the shared driver attributes key for the given driver
+//                data.
+//
+// The key includes every driver data member that is used by `make_attrs`.
+// `NULL` is returned if the key is too long, in which case the attributes are
+// not shared.
+//
+
+static char *				// O - Key string or `NULL` on error
+make_key(pappl_system_t         *system,// I - System
+         pappl_pr_driver_data_t *data)	// I - Driver data
+{
+  int			i, j;		// Looping vars
+  char			*key,		// Key string
+			*ptr,		// Pointer into key string
+			*end;		// End of key string
+  int			len;		// Length of current value
+  const char * const	*strings[6];	// String values
+  int			num_strings[6];	// Number of string values
+  const size_t		keysize = 32768;// Size of key string
+
+
+  if ((key = (char *)malloc(keysize)) == NULL)
+    return (NULL);
+
+  end = key + keysize;
+  len = snprintf(key, keysize, "%d|%d|%u:%s|%u:%s|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d,%d|%d,%d|%d|%d|%d,%d|%d,%d|%d|%d", cupsArrayCount(system->filters), system->wifi_join_cb != NULL, data->format ? (unsigned)strlen(data->format) : 0, data->format ? data->format : "", (unsigned)strlen(data->make_and_model), data->make_and_model, data->ppm, data->ppm_color, data->kind, data->input_face_up, data->output_face_up, data->color_supported, data->raster_types, data->duplex, data->sides_supported, data->finishings, data->borderless, data->left_right, data->bottom_top, data->left_offset_supported[0], data->left_offset_supported[1], data->top_offset_supported[0], data->top_offset_supported[1], data->tracking_supported, data->mode_supported, data->tear_offset_supported[0], data->tear_offset_supported[1], data->speed_supported[0], data->speed_supported[1], data->darkness_supported, data->identify_supported);
+
+  if (len < 0 || (size_t)len >= keysize)
+    goto too_long;
+
+  ptr = key + len;
+
+  for (i = 0; i < data->num_resolution; i ++)
+  {
+    len = snprintf(ptr, (size_t)(end - ptr), "|%dx%d", data->x_resolution[i], data->y_resolution[i]);
+    if (len < 0 || len >= (end - ptr))
+      goto too_long;
+
+    ptr += len;
+  }
+
+  strings[0] = data->media;
+  strings[1] = data->source;
+  strings[2] = data->type;
+  strings[3] = data->bin;
+  strings[4] = data->features;
+  strings[5] = data->vendor;
+
+  num_strings[0] = data->num_media;
+  num_strings[1] = data->num_source;
+  num_strings[2] = data->num_type;
+  num_strings[3] = data->num_bin;
+  num_strings[4] = data->num_features;
+  num_strings[5] = data->num_vendor;
+
+  for (i = 0; i < (int)(sizeof(strings) / sizeof(strings[0])); i ++)
+  {
+    // Prefix each list with its count and each string with its length so that
+    // the key cannot be ambiguous...
+    len = snprintf(ptr, (size_t)(end - ptr), "|%d", num_strings[i]);
+    if (len < 0 || len >= (end - ptr))
+      goto too_long;
+
+    ptr += len;
+
+    for (j = 0; j < num_strings[i]; j ++)
+    {
+      len = snprintf(ptr, (size_t)(end - ptr), ",%u:%s", (unsigned)strlen(strings[i][j]), strings[i][j]);
+      if (len < 0 || len >= (end - ptr))
+        goto too_long;
+
+      ptr += len;
+    }
+  }
+
+  return (key);
+
+  // If we get here the key is too long...
+  too_long:
+
+  free(key);
+
+  return (NULL);
+}
+
+
+//
+// 'make_media_col_database()' - Make the "media-col-database" attribute for
+//                               the given driver data.
+//
+
+static ipp_t *				// O - "media-col-database" attribute
+make_media_col_database(
+    pappl_pr_driver_data_t *data)	// I - Driver data
+{
+  ipp_t			*attrs;		// "media-col-database" attribute
+  int			i,		// Looping var
+			num_values;	// Number of values
+  ipp_t			*cvalues[PAPPL_MAX_MEDIA * 2 + 2];
+					// Collection values
+  const char		*max_name = NULL,// Maximum size
+		    	*min_name = NULL;// Minimum size
+
+
+  for (i = 0, num_values = 0; i < data->num_media; i ++)
+  {
+    if (!strncmp(data->media[i], "custom_max_", 11) || !strncmp(data->media[i], "roll_max_", 9))
+    {
+      max_name = data->media[i];
+    }
+    else if (!strncmp(data->media[i], "custom_min_", 11) || !strncmp(data->media[i], "roll_min_", 9))
+    {
+      min_name = data->media[i];
+    }
+    else
+    {
+      pappl_media_col_t	col;		// Media collection
+      pwg_media_t	*pwg;		// PWG media size info
+
+      memset(&col, 0, sizeof(col));
+      strlcpy(col.size_name, data->media[i], sizeof(col.size_name));
+      if ((pwg = pwgMediaForPWG(data->media[i])) != NULL)
+      {
+	col.size_width  = pwg->width;
+	col.size_length = pwg->length;
+      }
+
+      if (data->borderless && data->bottom_top > 0 && data->left_right > 0)
+	cvalues[num_values ++] = _papplMediaColExport(data, &col, true);
+
+      col.bottom_margin = col.top_margin = data->bottom_top;
+      col.left_margin = col.right_margin = data->left_right;
+
+      if ((cvalues[num_values] = _papplMediaColExport(data, &col, true)) != NULL)
+        num_values ++;
+    }
+  }
+
+  if (min_name && max_name)
+  {
+    pwg_media_t	*pwg,			// Current media size info
+		max_pwg,		// PWG maximum media size info
+		min_pwg;		// PWG minimum media size info
+    ipp_t	*col;			// media-size collection
+
+    if ((pwg = pwgMediaForPWG(max_name)) != NULL)
+      max_pwg = *pwg;
+    else
+      memset(&max_pwg, 0, sizeof(max_pwg));
+
+    if ((pwg = pwgMediaForPWG(min_name)) != NULL)
+      min_pwg = *pwg;
+    else
+      memset(&min_pwg, 0, sizeof(min_pwg));
+
+    col = ippNew();
+    ippAddRange(col, IPP_TAG_PRINTER, "x-dimension", min_pwg.width, max_pwg.width);
+    ippAddRange(col, IPP_TAG_PRINTER, "y-dimension", min_pwg.length, max_pwg.length);
+
+    cvalues[num_values] = ippNew();
+    ippAddCollection(cvalues[num_values], IPP_TAG_PRINTER, "media-size", col);
+    if (data->borderless && data->bottom_top > 0 && data->left_right > 0)
+    {
+      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin", 0);
+      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-left-margin", 0);
+      ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-right-margin", 0);
+      ippAddInteger(cvalues[num_values ++], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-top-margin", 0);
+
+      cvalues[num_values] = ippNew();
+      ippAddCollection(cvalues[num_values], IPP_TAG_PRINTER, "media-size", col);
+    }
+
+    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-bottom-margin", data->bottom_top);
+    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-left-margin", data->left_right);
+    ippAddInteger(cvalues[num_values], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-right-margin", data->left_right);
+    ippAddInteger(cvalues[num_values ++], IPP_TAG_PRINTER, IPP_TAG_INTEGER, "media-top-margin", data->bottom_top);
+
+    ippDelete(col);
+  }
+
+  attrs = ippNew();
+
+  if (num_values > 0)
+  {
+    ippAddCollections(attrs, IPP_TAG_PRINTER, "media-col-database", num_values, (const ipp_t **)cvalues);
+    for (i = 0; i < num_values; i ++)
+      ippDelete(cvalues[i]);
+  }
+
+  return (attrs);
+}
+
+
+//
+// 'make_options()' - Make the option table for the given driver data.
+//
+// The table maps the keywords used by @link papplJobCreatePrintOptions@ to
+// their bit values and the supported and ready media size names to their
+// dimensions and (first) ready media index.  Strings are not copied, so the
+// table must be discarded whenever the driver data changes.
+//
+
+static _pappl_optable_t *		// O - Option table
+make_options(
+    pappl_pr_driver_data_t *data)	// I - Driver data
+{
+  _pappl_optable_t	*table;		// Option table
+  _pappl_optentry_t	*entry;		// Current entry
+  int			i,		// Looping var
+			bit,		// Current bit value
+			max_entries;	// Maximum number of entries
+  pwg_media_t		*pwg;		// PWG media size
+  static const struct
+  {
+    const char		*keyword;	// "finishing-template" value
+    pappl_finishings_t	value;		// Bit value
+  }			finishings[] =
+  {				// Supported "finishing-template" values
+    { "punch",  PAPPL_FINISHINGS_PUNCH },
+    { "staple", PAPPL_FINISHINGS_STAPLE },
+    { "trim",   PAPPL_FINISHINGS_TRIM }
+  };
+
+
+  // Allocate the table; there are 3 finishings, 6 color modes, 5 content
+  // optimizations, 5 scaling modes, and 3 sides keywords plus the media...
+  max_entries = 22 + data->num_media + data->num_source;
+
+  if ((table = calloc(1, sizeof(_pappl_optable_t) + (size_t)(max_entries - 1) * sizeof(_pappl_optentry_t))) == NULL)
+    return (NULL);
+
+  // Add keywords...
+  for (i = 0; i < (int)(sizeof(finishings) / sizeof(finishings[0])); i ++)
+    add_option(table, "finishing-template", finishings[i].keyword, finishings[i].value);
+
+  for (bit = PAPPL_COLOR_MODE_AUTO; bit <= PAPPL_COLOR_MODE_PROCESS_MONOCHROME; bit *= 2)
+    add_option(table, "print-color-mode", _papplColorModeString((pappl_color_mode_t)bit), bit);
+
+  for (bit = PAPPL_CONTENT_AUTO; bit <= PAPPL_CONTENT_TEXT_AND_GRAPHIC; bit *= 2)
+    add_option(table, "print-content-optimize", _papplContentString((pappl_content_t)bit), bit);
+
+  for (bit = PAPPL_SCALING_AUTO; bit <= PAPPL_SCALING_NONE; bit *= 2)
+    add_option(table, "print-scaling", _papplScalingString((pappl_scaling_t)bit), bit);
+
+  for (bit = PAPPL_SIDES_ONE_SIDED; bit <= PAPPL_SIDES_TWO_SIDED_SHORT_EDGE; bit *= 2)
+    add_option(table, "sides", _papplSidesString((pappl_sides_t)bit), bit);
+
+  // Add supported media sizes...
+  for (i = 0; i < data->num_media; i ++)
+  {
+    if (_papplOptionTableFind(table, "media", data->media[i]) || (pwg = pwgMediaForPWG(data->media[i])) == NULL)
+      continue;
+
+    entry = add_option(table, "media", data->media[i], -1);
+    entry->media.pwg    = entry->keyword;
+    entry->media.width  = pwg->width;
+    entry->media.length = pwg->length;
+  }
+
+  // Then the ready media, which may include custom sizes...
+  for (i = 0; i < data->num_source; i ++)
+  {
+    const char *size_name = data->media_ready[i].size_name;
+					// Ready media size name
+
+    if (!size_name[0])
+      continue;
+
+    if ((entry = (_pappl_optentry_t *)_papplOptionTableFind(table, "media", size_name)) == NULL)
+    {
+      entry = add_option(table, "media", size_name, i);
+      entry->media.pwg    = entry->keyword;
+      entry->media.width  = data->media_ready[i].size_width;
+      entry->media.length = data->media_ready[i].size_length;
+    }
+    else if (entry->value < 0)
+    {
+      entry->value = i;
+    }
+  }
+
+  return (table);
+}
+
+
+//
+// 'match_media_col()' - Determine whether a "media-col-database" value matches
+//                       a "media-col" filter.
+//
+
+static bool				// O - `true` on match, `false` otherwise
+match_media_col(
+    pappl_printer_t *printer,		// I - Printer
+    ipp_t           *col,		// I - "media-col-database" value
+    ipp_t           *filter)		// I - "media-col" filter
+{
+  pappl_pr_driver_data_t *data = &printer->driver_data;
+					// Driver data
+  ipp_attribute_t	*member,	// Filter member
+			*attr;		// Matching member
+  const char		*name,		// Member name
+			*source,	// "media-source" value
+			*size_name;	// "media-size-name" value
+  ipp_t			*size;		// "media-size" value
+  ipp_attribute_t	*x_dim,		// "x-dimension" value
+			*y_dim;		// "y-dimension" value
+  int			i;		// Looping var
+
+
+  for (member = ippFirstAttribute(filter); member; member = ippNextAttribute(filter))
+  {
+    if ((name = ippGetName(member)) == NULL)
+      continue;
+
+    if (!strcmp(name, "media-source"))
+    {
+      // Only match the media that is ready in the named source...
+      source    = ippGetString(member, 0, NULL);
+      size_name = ippGetString(ippFindAttribute(col, "media-size-name", IPP_TAG_ZERO), 0, NULL);
+
+      for (i = 0; i < data->num_source; i ++)
+      {
+        if (source && !strcmp(source, data->source[i]))
+          break;
+      }
+
+      if (i >= data->num_source || !size_name || strcmp(size_name, data->media_ready[i].size_name))
+        return (false);
+    }
+    else if (!strcmp(name, "media-size"))
+    {
+      // Match the dimensions, which may be ranges for custom sizes...
+      size  = ippGetCollection(member, 0);
+      x_dim = ippFindAttribute(size, "x-dimension", IPP_TAG_INTEGER);
+      y_dim = ippFindAttribute(size, "y-dimension", IPP_TAG_INTEGER);
+
+      if (x_dim && !ippContainsInteger(ippFindAttribute(col, "media-size/x-dimension", IPP_TAG_ZERO), ippGetInteger(x_dim, 0)))
+        return (false);
+      if (y_dim && !ippContainsInteger(ippFindAttribute(col, "media-size/y-dimension", IPP_TAG_ZERO), ippGetInteger(y_dim, 0)))
+        return (false);
+    }
+    else if ((attr = ippFindAttribute(col, name, IPP_TAG_ZERO)) == NULL)
+    {
+      return (false);
+    }
+    else
+    {
+      switch (ippGetValueTag(member))
+      {
+        case IPP_TAG_INTEGER :
+            if (!ippContainsInteger(attr, ippGetInteger(member, 0)))
+              return (false);
+            break;
+
+        case IPP_TAG_KEYWORD :
+        case IPP_TAG_NAME :
+            if (!ippContainsString(attr, ippGetString(member, 0, NULL)))
+              return (false);
+            break;
+
+        default :
+            break;
+      }
+    }
+  }
+
+  return (true);
+}
+
+
 //
 // 'validate_defaults()' - Validate the printing defaults and supported values.
 //
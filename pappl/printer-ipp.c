@@ -31,7 +31,10 @@ typedef struct _pappl_attr_s		// Input attribute structure
 // Local functions...
 //
 
+static int		compare_pattrs(_pappl_pattrs_t *a, _pappl_pattrs_t *b);
+static void		copy_static_attrs(pappl_client_t *client, pappl_printer_t *printer, _pappl_raset_t *ra);
 static pappl_job_t	*create_job(pappl_client_t *client);
+static void		free_pattrs(_pappl_pattrs_t *pa);
 
 static void		ipp_cancel_current_job(pappl_client_t *client);
 static void		ipp_cancel_jobs(pappl_client_t *client);
@@ -56,7 +59,7 @@ void
 _papplPrinterCopyAttributes(
     pappl_client_t  *client,		// I - Client
     pappl_printer_t *printer,		// I - Printer
-    cups_array_t    *ra,		// I - Requested attributes
+    _pappl_raset_t  *ra,		// I - Requested attributes
     const char      *format)		// I - "document-format" value, if any
 {
   int		i,			// Looping var
@@ -70,11 +73,10 @@ _papplPrinterCopyAttributes(
 					// URL scheme for resources
 
 
-  _papplCopyAttributes(client->response, printer->attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
-  _papplCopyAttributes(client->response, printer->driver_attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
+  copy_static_attrs(client, printer, ra);
   _papplPrinterCopyState(client, client->response, printer, ra);
 
-  if (!ra || cupsArrayFind(ra, "copies-supported"))
+  if (_papplRASetContains(ra, "copies-supported"))
   {
     // Filter copies-supported value based on the document format...
     // (no copy support for streaming raster formats)
@@ -84,7 +86,7 @@ _papplPrinterCopyAttributes(
       ippAddRange(client->response, IPP_TAG_PRINTER, "copies-supported", 1, 999);
   }
 
-  if (!ra || cupsArrayFind(ra, "identify-actions-default"))
+  if (_papplRASetContains(ra, "identify-actions-default"))
   {
     for (num_values = 0, bit = PAPPL_IDENTIFY_ACTIONS_DISPLAY; bit <= PAPPL_IDENTIFY_ACTIONS_SPEAK; bit *= 2)
     {
@@ -98,10 +100,10 @@ _papplPrinterCopyAttributes(
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "identify-actions-default", NULL, "none");
   }
 
-  if ((!ra || cupsArrayFind(ra, "label-mode-configured")) && data->mode_configured)
+  if (_papplRASetContains(ra, "label-mode-configured") && data->mode_configured)
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "label-mode-configured", NULL, _papplLabelModeString(data->mode_configured));
 
-  if ((!ra || cupsArrayFind(ra, "label-tear-offset-configured")) && data->tear_offset_supported[1] > 0)
+  if (_papplRASetContains(ra, "label-tear-offset-configured") && data->tear_offset_supported[1] > 0)
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "label-tear-offset-configured", data->tear_offset_configured);
 
   if (printer->num_supply > 0)
@@ -109,7 +111,7 @@ _papplPrinterCopyAttributes(
     pappl_supply_t *supply = printer->supply;
 					// Supply values...
 
-    if (!ra || cupsArrayFind(ra, "marker-colors"))
+    if (_papplRASetContains(ra, "marker-colors"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = _papplMarkerColorString(supply[i].color);
@@ -117,7 +119,7 @@ _papplPrinterCopyAttributes(
       ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_NAME), "marker-colors", printer->num_supply, NULL, svalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-high-levels"))
+    if (_papplRASetContains(ra, "marker-high-levels"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].is_consumed ? 100 : 90;
@@ -125,7 +127,7 @@ _papplPrinterCopyAttributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-high-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-levels"))
+    if (_papplRASetContains(ra, "marker-levels"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].level;
@@ -133,7 +135,7 @@ _papplPrinterCopyAttributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-low-levels"))
+    if (_papplRASetContains(ra, "marker-low-levels"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         ivalues[i] = supply[i].is_consumed ? 10 : 0;
@@ -141,7 +143,7 @@ _papplPrinterCopyAttributes(
       ippAddIntegers(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "marker-low-levels", printer->num_supply, ivalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-names"))
+    if (_papplRASetContains(ra, "marker-names"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = supply[i].description;
@@ -149,7 +151,7 @@ _papplPrinterCopyAttributes(
       ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "marker-names", printer->num_supply, NULL, svalues);
     }
 
-    if (!ra || cupsArrayFind(ra, "marker-types"))
+    if (_papplRASetContains(ra, "marker-types"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = _papplMarkerTypeString(supply[i].type);
@@ -158,7 +160,10 @@ _papplPrinterCopyAttributes(
     }
   }
 
-  if ((!ra || cupsArrayFind(ra, "media-col-default")) && data->media_default.size_name[0])
+  if (ra && _papplRASetContains(ra, "media-col-database"))
+    _papplPrinterCopyMediaColDatabase(printer, client->response, ippGetCollection(ippFindAttribute(client->request, "media-col", IPP_TAG_BEGIN_COLLECTION), 0));
+
+  if (_papplRASetContains(ra, "media-col-default") && data->media_default.size_name[0])
   {
     ipp_t *col = _papplMediaColExport(&printer->driver_data, &data->media_default, 0);
 					// Collection value
@@ -167,7 +172,7 @@ _papplPrinterCopyAttributes(
     ippDelete(col);
   }
 
-  if (!ra || cupsArrayFind(ra, "media-col-ready"))
+  if (_papplRASetContains(ra, "media-col-ready"))
   {
     int			j,		// Looping var
 			count;		// Number of values
@@ -221,10 +226,10 @@ _papplPrinterCopyAttributes(
     }
   }
 
-  if ((!ra || cupsArrayFind(ra, "media-default")) && data->media_default.size_name[0])
+  if (_papplRASetContains(ra, "media-default") && data->media_default.size_name[0])
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, "media-default", NULL, data->media_default.size_name);
 
-  if (!ra || cupsArrayFind(ra, "media-ready"))
+  if (_papplRASetContains(ra, "media-ready"))
   {
     int			j,		// Looping vars
 			count;		// Number of values
@@ -248,13 +253,13 @@ _papplPrinterCopyAttributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "multiple-document-handling-default"))
+  if (_papplRASetContains(ra, "multiple-document-handling-default"))
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-document-handling-default", NULL, "separate-documents-collated-copies");
 
-  if (!ra || cupsArrayFind(ra, "orientation-requested-default"))
+  if (_papplRASetContains(ra, "orientation-requested-default"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "orientation-requested-default", (int)data->orient_default);
 
-  if (!ra || cupsArrayFind(ra, "output-bin-default"))
+  if (_papplRASetContains(ra, "output-bin-default"))
   {
     if (data->num_bin > 0)
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, data->bin[data->bin_default]);
@@ -264,10 +269,10 @@ _papplPrinterCopyAttributes(
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "output-bin-default", NULL, "face-down");
   }
 
-  if ((!ra || cupsArrayFind(ra, "print-color-mode-default")) && data->color_default)
+  if (_papplRASetContains(ra, "print-color-mode-default") && data->color_default)
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-color-mode-default", NULL, _papplColorModeString(data->color_default));
 
-  if (!ra || cupsArrayFind(ra, "print-content-optimize-default"))
+  if (_papplRASetContains(ra, "print-content-optimize-default"))
   {
     if (data->content_default)
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, _papplContentString(data->content_default));
@@ -275,7 +280,7 @@ _papplPrinterCopyAttributes(
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-content-optimize-default", NULL, "auto");
   }
 
-  if (!ra || cupsArrayFind(ra, "print-quality-default"))
+  if (_papplRASetContains(ra, "print-quality-default"))
   {
     if (data->quality_default)
       ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", (int)data->quality_default);
@@ -283,7 +288,7 @@ _papplPrinterCopyAttributes(
       ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "print-quality-default", IPP_QUALITY_NORMAL);
   }
 
-  if (!ra || cupsArrayFind(ra, "print-scaling-default"))
+  if (_papplRASetContains(ra, "print-scaling-default"))
   {
     if (data->scaling_default)
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, _papplScalingString(data->scaling_default));
@@ -291,33 +296,33 @@ _papplPrinterCopyAttributes(
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "print-scaling-default", NULL, "auto");
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-config-change-date-time"))
+  if (_papplRASetContains(ra, "printer-config-change-date-time"))
     ippAddDate(client->response, IPP_TAG_PRINTER, "printer-config-change-date-time", ippTimeToDate(printer->config_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-config-change-time"))
+  if (_papplRASetContains(ra, "printer-config-change-time"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-config-change-time", (int)(printer->config_time - printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-contact-col"))
+  if (_papplRASetContains(ra, "printer-contact-col"))
   {
     ipp_t *col = _papplContactExport(&printer->contact);
     ippAddCollection(client->response, IPP_TAG_PRINTER, "printer-contact-col", col);
     ippDelete(col);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-current-time"))
+  if (_papplRASetContains(ra, "printer-current-time"))
     ippAddDate(client->response, IPP_TAG_PRINTER, "printer-current-time", ippTimeToDate(time(NULL)));
 
-  if ((!ra || cupsArrayFind(ra, "printer-darkness-configured")) && data->darkness_supported > 0)
+  if (_papplRASetContains(ra, "printer-darkness-configured") && data->darkness_supported > 0)
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-darkness-configured", data->darkness_configured);
 
-  if (!ra || cupsArrayFind(ra, "printer-dns-sd-name"))
+  if (_papplRASetContains(ra, "printer-dns-sd-name"))
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "printer-dns-sd-name", NULL, printer->dns_sd_name ? printer->dns_sd_name : "");
 
   pthread_rwlock_rdlock(&client->system->rwlock);
   _papplSystemExportVersions(client->system, client->response, IPP_TAG_PRINTER, ra);
   pthread_rwlock_unlock(&client->system->rwlock);
 
-  if (!ra || cupsArrayFind(ra, "printer-geo-location"))
+  if (_papplRASetContains(ra, "printer-geo-location"))
   {
     if (printer->geo_location)
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-geo-location", NULL, printer->geo_location);
@@ -325,7 +330,7 @@ _papplPrinterCopyAttributes(
       ippAddOutOfBand(client->response, IPP_TAG_PRINTER, IPP_TAG_UNKNOWN, "printer-geo-location");
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-icons"))
+  if (_papplRASetContains(ra, "printer-icons"))
   {
     char	uris[3][1024];		// Buffers for URIs
     const char	*values[3];		// Values for attribute
@@ -341,10 +346,10 @@ _papplPrinterCopyAttributes(
     ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-icons", 3, NULL, values);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-impressions-completed"))
+  if (_papplRASetContains(ra, "printer-impressions-completed"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-impressions-completed", printer->impcompleted);
 
-  if (!ra || cupsArrayFind(ra, "printer-input-tray"))
+  if (_papplRASetContains(ra, "printer-input-tray"))
   {
     ipp_attribute_t	*attr = NULL;	// "printer-input-tray" attribute
     char		value[256];	// Value for current tray
@@ -374,13 +379,13 @@ _papplPrinterCopyAttributes(
     ippSetOctetString(client->response, &attr, ippGetCount(attr), value, (int)strlen(value));
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-is-accepting-jobs"))
+  if (_papplRASetContains(ra, "printer-is-accepting-jobs"))
     ippAddBoolean(client->response, IPP_TAG_PRINTER, "printer-is-accepting-jobs", !printer->system->shutdown_time);
 
-  if (!ra || cupsArrayFind(ra, "printer-location"))
+  if (_papplRASetContains(ra, "printer-location"))
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-location", NULL, printer->location ? printer->location : "");
 
-  if (!ra || cupsArrayFind(ra, "printer-more-info"))
+  if (_papplRASetContains(ra, "printer-more-info"))
   {
     char	uri[1024];		// URI value
 
@@ -388,30 +393,30 @@ _papplPrinterCopyAttributes(
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-more-info", NULL, uri);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-organization"))
+  if (_papplRASetContains(ra, "printer-organization"))
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organization", NULL, printer->organization ? printer->organization : "");
 
-  if (!ra || cupsArrayFind(ra, "printer-organizational-unit"))
+  if (_papplRASetContains(ra, "printer-organizational-unit"))
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_TEXT, "printer-organizational-unit", NULL, printer->org_unit ? printer->org_unit : "");
 
-  if (!ra || cupsArrayFind(ra, "printer-resolution-default"))
+  if (_papplRASetContains(ra, "printer-resolution-default"))
     ippAddResolution(client->response, IPP_TAG_PRINTER, "printer-resolution-default", IPP_RES_PER_INCH, data->x_default, data->y_default);
 
-  if (!ra || cupsArrayFind(ra, "printer-speed-default"))
+  if (_papplRASetContains(ra, "printer-speed-default"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-speed-default", data->speed_default);
 
-  if (!ra || cupsArrayFind(ra, "printer-state-change-date-time"))
+  if (_papplRASetContains(ra, "printer-state-change-date-time"))
     ippAddDate(client->response, IPP_TAG_PRINTER, "printer-state-change-date-time", ippTimeToDate(printer->state_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-state-change-time"))
+  if (_papplRASetContains(ra, "printer-state-change-time"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-state-change-time", (int)(printer->state_time - printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-strings-languages-supported"))
+  if (_papplRASetContains(ra, "printer-strings-languages-supported"))
   {
     _pappl_resource_t	*r;		// Current resource
     int			rcount;		// Number of resources
 
-    pthread_rwlock_rdlock(&printer->system->rwlock);
+    pthread_rwlock_rdlock(&printer->system->resource_rwlock);
 
     // Cannot use cupsArrayFirst/Last since other threads might be iterating
     // this array...
@@ -422,40 +427,24 @@ _papplPrinterCopyAttributes(
       if (r->language)
         svalues[num_values ++] = r->language;
     }
-    pthread_rwlock_unlock(&printer->system->rwlock);
+    pthread_rwlock_unlock(&printer->system->resource_rwlock);
 
     if (num_values > 0)
-      ippAddStrings(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_LANGUAGE, "printer-strings-languages-supported", num_values, NULL, svalues);
+      ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_LANGUAGE, "printer-strings-languages-supported", num_values, NULL, svalues);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-strings-uri"))
+  if (_papplRASetContains(ra, "printer-strings-uri"))
   {
-    const char	*lang = ippGetString(ippFindAttribute(client->request, "attributes-natural-language", IPP_TAG_LANGUAGE), 0, NULL);
-					// Language
-    char	baselang[3],		// Base language
-		uri[1024];		// Strings file URI
-    _pappl_resource_t	*r;		// Current resource
-    int		rcount;			// Number of resources
-
-    strlcpy(baselang, lang, sizeof(baselang));
-
-    pthread_rwlock_rdlock(&printer->system->rwlock);
+    pappl_loc_t	*loc;			// Localization for the request
+    char	uri[1024];		// Strings file URI
 
-    // Cannot use cupsArrayFirst/Last since other threads might be iterating
-    // this array...
-    for (i = 0, rcount = cupsArrayCount(printer->system->resources); i < rcount; i ++)
+    // The client's catalog comes from the same strings resource that it would
+    // download...
+    if ((loc = papplClientGetLoc(client)) != NULL)
     {
-      r = (_pappl_resource_t *)cupsArrayIndex(printer->system->resources, i);
-
-      if (r->language && (!strcmp(r->language, lang) || !strcmp(r->language, baselang)))
-      {
-        httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), webscheme, NULL, client->host_field, client->host_port, r->path);
-        ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-strings-uri", NULL, uri);
-        break;
-      }
+      httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), webscheme, NULL, client->host_field, client->host_port, loc->path);
+      ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-strings-uri", NULL, uri);
     }
-
-    pthread_rwlock_unlock(&printer->system->rwlock);
   }
 
   if (printer->num_supply > 0)
@@ -463,7 +452,7 @@ _papplPrinterCopyAttributes(
     pappl_supply_t	 *supply = printer->supply;
 					// Supply values...
 
-    if (!ra || cupsArrayFind(ra, "printer-supply"))
+    if (_papplRASetContains(ra, "printer-supply"))
     {
       char		value[256];	// "printer-supply" value
       ipp_attribute_t	*attr = NULL;	// "printer-supply" attribute
@@ -479,7 +468,7 @@ _papplPrinterCopyAttributes(
       }
     }
 
-    if (!ra || cupsArrayFind(ra, "printer-supply-description"))
+    if (_papplRASetContains(ra, "printer-supply-description"))
     {
       for (i = 0; i < printer->num_supply; i ++)
         svalues[i] = supply[i].description;
@@ -488,7 +477,7 @@ _papplPrinterCopyAttributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-supply-info-uri"))
+  if (_papplRASetContains(ra, "printer-supply-info-uri"))
   {
     char	uri[1024];		// URI value
 
@@ -496,10 +485,10 @@ _papplPrinterCopyAttributes(
     ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-supply-info-uri", NULL, uri);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-up-time"))
+  if (_papplRASetContains(ra, "printer-up-time"))
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-up-time", (int)(time(NULL) - printer->start_time));
 
-  if (!ra || cupsArrayFind(ra, "printer-uri-supported"))
+  if (_papplRASetContains(ra, "printer-uri-supported"))
   {
     char	uris[2][1024];		// Buffers for URIs
     const char	*values[2];		// Values for attribute
@@ -524,28 +513,28 @@ _papplPrinterCopyAttributes(
       ippAddStrings(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "printer-uri-supported", num_values, NULL, values);
   }
 
-  if (client->system->wifi_status_cb && httpAddrLocalhost(httpGetAddress(client->http)) && (!ra || cupsArrayFind(ra, "printer-wifi-ssid") || cupsArrayFind(ra, "printer-wifi-state")))
+  if (client->system->wifi_status_cb && httpAddrLocalhost(httpGetAddress(client->http)) && (_papplRASetContains(ra, "printer-wifi-ssid") || _papplRASetContains(ra, "printer-wifi-state")))
   {
     // Get Wi-Fi status...
     pappl_wifi_t	wifi;		// Wi-Fi status
 
     if ((client->system->wifi_status_cb)(client->system, client->system->wifi_cbdata, &wifi))
     {
-      if (!ra || cupsArrayFind(ra, "printer-wifi-ssid"))
+      if (_papplRASetContains(ra, "printer-wifi-ssid"))
         ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "printer-wifi-ssid", NULL, wifi.ssid);
 
-      if (!ra || cupsArrayFind(ra, "printer-wifi-state"))
+      if (_papplRASetContains(ra, "printer-wifi-state"))
         ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_ENUM, "printer-wifi-state", (int)wifi.state);
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-xri-supported"))
+  if (_papplRASetContains(ra, "printer-xri-supported"))
     _papplPrinterCopyXRI(client, client->response, printer);
 
-  if (!ra || cupsArrayFind(ra, "queued-job-count"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "queued-job-count", cupsArrayCount(printer->active_jobs));
+  if (_papplRASetContains(ra, "queued-job-count"))
+    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "queued-job-count", printer->active_jobs.count);
 
-  if (!ra || cupsArrayFind(ra, "sides-default"))
+  if (_papplRASetContains(ra, "sides-default"))
   {
     if (data->sides_default)
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, _papplSidesString(data->sides_default));
@@ -553,7 +542,7 @@ _papplPrinterCopyAttributes(
       ippAddString(client->response, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "sides-default", NULL, "one-sided");
   }
 
-  if (!ra || cupsArrayFind(ra, "uri-authentication-supported"))
+  if (_papplRASetContains(ra, "uri-authentication-supported"))
   {
     // For each supported printer-uri value, report whether authentication is
     // supported.  Since we only support authentication over a secure (TLS)
@@ -603,19 +592,19 @@ _papplPrinterCopyState(
     pappl_client_t  *client,		// I - Client connection
     ipp_t           *ipp,		// I - IPP message
     pappl_printer_t *printer,		// I - Printer
-    cups_array_t    *ra)		// I - Requested attributes
+    _pappl_raset_t  *ra)		// I - Requested attributes
 {
-  if (!ra || cupsArrayFind(ra, "printer-state"))
+  if (_papplRASetContains(ra, "printer-state"))
     ippAddInteger(ipp, IPP_TAG_PRINTER, IPP_TAG_ENUM, "printer-state", (int)printer->state);
 
-  if (!ra || cupsArrayFind(ra, "printer-state-message"))
+  if (_papplRASetContains(ra, "printer-state-message"))
   {
     static const char * const messages[] = { "Idle.", "Printing.", "Stopped." };
 
     ippAddString(ipp, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_TEXT), "printer-state-message", NULL, messages[printer->state - IPP_PSTATE_IDLE]);
   }
 
-  if (!ra || cupsArrayFind(ra, "printer-state-reasons"))
+  if (_papplRASetContains(ra, "printer-state-reasons"))
   {
     ipp_attribute_t	*attr = NULL;	// printer-state-reasons
     bool		wifi_not_configured = false;
@@ -781,6 +770,31 @@ _papplPrinterProcessIPP(
 	ipp_resume_printer(client);
 	break;
 
+    case IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS :
+    case IPP_OP_CREATE_JOB_SUBSCRIPTIONS :
+	_papplSubscriptionIPPCreate(client);
+	break;
+
+    case IPP_OP_GET_SUBSCRIPTION_ATTRIBUTES :
+	_papplSubscriptionIPPGetAttributes(client);
+	break;
+
+    case IPP_OP_GET_SUBSCRIPTIONS :
+	_papplSubscriptionIPPList(client);
+	break;
+
+    case IPP_OP_RENEW_SUBSCRIPTION :
+	_papplSubscriptionIPPRenew(client);
+	break;
+
+    case IPP_OP_CANCEL_SUBSCRIPTION :
+	_papplSubscriptionIPPCancel(client);
+	break;
+
+    case IPP_OP_GET_NOTIFICATIONS :
+	_papplSubscriptionIPPGetNotifications(client);
+	break;
+
     default :
         if (client->system->op_cb && (client->system->op_cb)(client, client->system->op_cbdata))
           break;
@@ -1131,6 +1145,100 @@ _papplPrinterSetAttributes(
 }
 
 
+//
+// 'compare_pattrs()' - Compare two cached attribute sets.
+//
+
+static int				// O - Result of comparison
+compare_pattrs(_pappl_pattrs_t *a,	// I - First attribute set
+               _pappl_pattrs_t *b)	// I - Second attribute set
+{
+  return (strcmp(a->ra, b->ra));
+}
+
+
+//
+// 'copy_static_attrs()' - Copy the static printer and driver attributes.
+//
+// The static attributes only change when the printer configuration changes,
+// so the filtered copy for each set of requested attributes is cached until
+// the next change of "printer-config-change-time".  The cache is only used
+// when it was started after the last configuration change, which avoids
+// missing changes made within the same second.
+//
+// The printer reader lock must be held by the caller.
+//
+
+static void
+copy_static_attrs(
+    pappl_client_t  *client,		// I - Client
+    pappl_printer_t *printer,		// I - Printer
+    _pappl_raset_t  *ra)		// I - Requested attributes
+{
+  _pappl_pattrs_t	key,		// Search key
+			*pa;		// Cached attributes
+  ipp_t			*attrs;		// Attributes
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  // Use the requested attribute set's key string, "all" for all attributes;
+  // sets without a key (too many names) are not cached...
+  if ((ra && !ra->key) || (key.ra = strdup(ra ? ra->key : "all")) == NULL)
+  {
+    _papplCopyAttributes(client->response, printer->attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
+    _papplPrinterCopyDriverAttrs(printer, client->response, ra, IPP_TAG_CUPS_CONST);
+    return;
+  }
+
+  // See if we have a current copy...
+  pthread_rwlock_rdlock(&printer->attrs_rwlock);
+
+  if (printer->attrs_time > printer->config_time && (pa = (_pappl_pattrs_t *)cupsArrayFind(printer->attrs_cache, &key)) != NULL)
+  {
+    ippCopyAttributes(client->response, pa->attrs, 1, NULL, NULL);
+    pthread_rwlock_unlock(&printer->attrs_rwlock);
+    free(key.ra);
+    return;
+  }
+
+  pthread_rwlock_unlock(&printer->attrs_rwlock);
+
+  // No, copy the attributes and add them to the cache...
+  attrs = ippNew();
+  _papplCopyAttributes(attrs, printer->attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
+  _papplPrinterCopyDriverAttrs(printer, attrs, ra, IPP_TAG_CUPS_CONST);
+  ippCopyAttributes(client->response, attrs, 1, NULL, NULL);
+
+  pthread_rwlock_wrlock(&printer->attrs_rwlock);
+
+  if (!printer->attrs_cache)
+    printer->attrs_cache = cupsArrayNew3((cups_array_func_t)compare_pattrs, NULL, NULL, 0, NULL, (cups_afree_func_t)free_pattrs);
+
+  if (printer->attrs_time <= printer->config_time)
+  {
+    // Configuration has changed, start over...
+    cupsArrayClear(printer->attrs_cache);
+    printer->attrs_time = curtime;
+  }
+
+  if (curtime > printer->config_time && cupsArrayCount(printer->attrs_cache) < _PAPPL_MAX_ATTRS_CACHE && !cupsArrayFind(printer->attrs_cache, &key) && (pa = (_pappl_pattrs_t *)calloc(1, sizeof(_pappl_pattrs_t))) != NULL)
+  {
+    pa->ra    = key.ra;
+    pa->attrs = attrs;
+
+    cupsArrayAdd(printer->attrs_cache, pa);
+  }
+  else
+  {
+    free(key.ra);
+    ippDelete(attrs);
+  }
+
+  pthread_rwlock_unlock(&printer->attrs_rwlock);
+}
+
+
 //
 // 'create_job()' - Create a new job object from a Print-Job or Create-Job
 //                  request.
@@ -1162,6 +1270,19 @@ create_job(
 }
 
 
+//
+// 'free_pattrs()' - Free a cached attribute set.
+//
+
+static void
+free_pattrs(_pappl_pattrs_t *pa)	// I - Cached attributes
+{
+  free(pa->ra);
+  ippDelete(pa->attrs);
+  free(pa);
+}
+
+
 //
 // 'ipp_cancel_current_job()' - Cancel the current job.
 //
@@ -1238,7 +1359,15 @@ static void
 ipp_create_job(pappl_client_t *client)	// I - Client
 {
   pappl_job_t		*job;		// New job
-  cups_array_t		*ra;		// Attributes to send in response
+  _pappl_raset_t	*ra;		// Attributes to send in response
+  static const char * const job_attrs[] =
+  {					// Attributes for the new job
+    "job-id",
+    "job-state",
+    "job-state-message",
+    "job-state-reasons",
+    "job-uri"
+  };
 
 
   // Do we have a file to print?
@@ -1263,15 +1392,9 @@ ipp_create_job(pappl_client_t *client)	// I - Client
   // Return the job info...
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "job-id");
-  cupsArrayAdd(ra, "job-state");
-  cupsArrayAdd(ra, "job-state-message");
-  cupsArrayAdd(ra, "job-state-reasons");
-  cupsArrayAdd(ra, "job-uri");
-
+  ra = _papplRASetCreateNames((int)(sizeof(job_attrs) / sizeof(job_attrs[0])), job_attrs);
   _papplJobCopyAttributes(client, job, ra);
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -1288,12 +1411,17 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
   int			job_comparison;	// Job comparison
   ipp_jstate_t		job_state;	// job-state value
   int			i,		// Looping var
+			first_index,	// First matching job to return
 			limit,		// Maximum number of jobs to return
-			count;		// Number of jobs that match
+			count,		// Number of jobs that match
+			num_jobs;	// Number of jobs to return
   const char		*username;	// Username
-  cups_array_t		*list;		// Jobs list
-  pappl_job_t		*job;		// Current job pointer
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_joblist_t	*list,		// Jobs list
+			*ulist;		// Jobs list for user
+  bool			all_jobs;	// Listing all jobs?
+  pappl_job_t		*job,		// Current job pointer
+			**jobs;		// Jobs to return
+  _pappl_raset_t	*ra;		// Requested attributes
 
 
   // See if the "which-jobs" attribute have been specified...
@@ -1307,19 +1435,22 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
   {
     job_comparison = -1;
     job_state      = IPP_JSTATE_STOPPED;
-    list           = client->printer->active_jobs;
+    list           = &client->printer->active_jobs;
+    all_jobs       = false;
   }
   else if (!strcmp(which_jobs, "completed"))
   {
     job_comparison = 1;
     job_state      = IPP_JSTATE_CANCELED;
-    list           = client->printer->completed_jobs;
+    list           = &client->printer->completed_jobs;
+    all_jobs       = false;
   }
   else if (!strcmp(which_jobs, "all"))
   {
     job_comparison = 1;
     job_state      = IPP_JSTATE_PENDING;
-    list           = client->printer->all_jobs;
+    list           = &client->printer->all_jobs;
+    all_jobs       = true;
   }
   else
   {
@@ -1338,6 +1469,20 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
   else
     limit = 0;
 
+  // See if they want to start with a particular job...
+  if ((attr = ippFindAttribute(client->request, "first-index", IPP_TAG_ZERO)) != NULL)
+  {
+    if (ippGetGroupTag(attr) != IPP_TAG_OPERATION || ippGetValueTag(attr) != IPP_TAG_INTEGER || ippGetCount(attr) != 1 || (first_index = ippGetInteger(attr, 0)) < 1)
+    {
+      papplClientRespondIPPUnsupported(client, attr);
+      return;
+    }
+
+    papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Get-Jobs \"first-index\"='%d'", first_index);
+  }
+  else
+    first_index = 1;
+
   // See if we only want to see jobs for a specific user...
   username = NULL;
 
@@ -1361,35 +1506,77 @@ ipp_get_jobs(pappl_client_t *client)	// I - Client
     }
   }
 
-  // OK, build a list of jobs for this printer...
-  ra = ippCreateRequestedArray(client->request);
-
-  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+  // OK, take a snapshot of the matching jobs for this printer, retaining each
+  // one so that the attributes can be copied without holding the printer
+  // lock...
+  _papplPrinterRetain(client->printer);
 
   pthread_rwlock_rdlock(&(client->printer->rwlock));
 
-  count = cupsArrayCount(list);
-  if (limit <= 0 || limit > count)
-    limit = count;
+  ulist = username ? _papplPrinterFindUserJobsNoLock(client->printer, username) : NULL;
 
-  for (count = 0, i = 0; i < limit; i ++)
+  if (ulist && ulist->count < list->count)
+    list = ulist;			// Scan the (shorter) list of the user's jobs
+
+  if (username && !ulist)
+    num_jobs = 0;			// No jobs for this user
+  else if (limit <= 0 || limit > list->count)
+    num_jobs = list->count;
+  else
+    num_jobs = limit;
+
+  if (num_jobs > 0)
   {
-    job = (pappl_job_t *)cupsArrayIndex(list, i);
+    if ((jobs = (pappl_job_t **)calloc((size_t)num_jobs, sizeof(pappl_job_t *))) == NULL)
+    {
+      pthread_rwlock_unlock(&(client->printer->rwlock));
+      _papplPrinterRelease(client->printer);
 
-    // Filter out jobs that don't match...
-    if ((job_comparison < 0 && job->state > job_state) || /* (job_comparison == 0 && job->state != job_state) || */ (job_comparison > 0 && job->state < job_state) || (username && job->username && strcasecmp(username, job->username)))
-      continue;
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to allocate memory for jobs.");
+      return;
+    }
 
-    if (count > 0)
+    for (count = 0, i = 0, job = list->first; job && i < num_jobs; job = list == ulist ? job->user_next : all_jobs ? job->all_next : job->next)
+    {
+      // Filter out jobs that don't match...
+      if ((job_comparison < 0 && job->state > job_state) || (job_comparison > 0 && job->state < job_state) || (username && list != ulist && job->username && strcasecmp(username, job->username)))
+	continue;
+
+      if (++ count >= first_index)
+	jobs[i ++] = _papplJobRetain(job);
+    }
+
+    num_jobs = i;
+  }
+  else
+  {
+    jobs     = NULL;
+    num_jobs = 0;
+  }
+
+  pthread_rwlock_unlock(&(client->printer->rwlock));
+
+  // Then copy the job attributes...
+  ra = _papplRASetCreate(client->request);
+
+  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    if (i > 0)
       ippAddSeparator(client->response);
 
-    count ++;
-    _papplJobCopyAttributes(client, job, ra);
+    pthread_rwlock_rdlock(&jobs[i]->rwlock);
+    _papplJobCopyAttributes(client, jobs[i], ra);
+    pthread_rwlock_unlock(&jobs[i]->rwlock);
+
+    _papplJobRelease(jobs[i]);
   }
 
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
+  free(jobs);
 
-  pthread_rwlock_unlock(&(client->printer->rwlock));
+  _papplPrinterRelease(client->printer);
 }
 
 
@@ -1401,20 +1588,13 @@ static void
 ipp_get_printer_attributes(
     pappl_client_t *client)		// I - Client
 {
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_raset_t	*ra;		// Requested attributes
   pappl_printer_t	*printer = client->printer;
 					// Printer
 
 
-  if (!printer->device_in_use && !printer->processing_job && (time(NULL) - printer->status_time) > 1 && printer->driver_data.status_cb)
-  {
-    // Update printer status...
-    (printer->driver_data.status_cb)(printer);
-    printer->status_time = time(NULL);
-  }
-
-  // Send the attributes...
-  ra = ippCreateRequestedArray(client->request);
+  // Send the attributes, using the status from the last background update...
+  ra = _papplRASetCreate(client->request);
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
@@ -1424,7 +1604,7 @@ ipp_get_printer_attributes(
 
   pthread_rwlock_unlock(&(printer->rwlock));
 
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -1521,7 +1701,7 @@ ipp_print_job(pappl_client_t *client)	// I - Client
   }
 
   // Then finish getting the document data and process things...
-  _papplJobCopyDocumentData(client, job);
+  _papplJobCopyDocumentData(client, job, job->format, true);
 }
 
 
@@ -1569,6 +1749,8 @@ ipp_set_printer_attributes(
   if (!_papplPrinterSetAttributes(client, client->printer))
     return;
 
+  papplSystemAddEvent(client->system, client->printer, NULL, PAPPL_EVENT_PRINTER_CONFIG_CHANGED, "Printer attributes changed.");
+
   papplClientRespondIPP(client, IPP_STATUS_OK, "Printer attributes set.");
 }
 
@@ -1693,7 +1875,7 @@ valid_job_attributes(
     }
     else
     {
-      supported = ippFindAttribute(client->printer->driver_attrs, "media-supported", IPP_TAG_KEYWORD);
+      supported = _papplPrinterFindDriverAttr(client->printer, "media-supported", IPP_TAG_KEYWORD);
 
       if (!ippContainsString(supported, ippGetString(attr, 0, NULL)))
       {
@@ -1730,7 +1912,7 @@ valid_job_attributes(
       }
       else
       {
-	supported = ippFindAttribute(client->printer->driver_attrs, "media-supported", IPP_TAG_KEYWORD);
+	supported = _papplPrinterFindDriverAttr(client->printer, "media-supported", IPP_TAG_KEYWORD);
 
 	if (!ippContainsString(supported, ippGetString(member, 0, NULL)))
 	{
@@ -1759,7 +1941,7 @@ valid_job_attributes(
 	{
 	  x_value   = ippGetInteger(x_dim, 0);
 	  y_value   = ippGetInteger(y_dim, 0);
-	  supported = ippFindAttribute(client->printer->driver_attrs, "media-size-supported", IPP_TAG_BEGIN_COLLECTION);
+	  supported = _papplPrinterFindDriverAttr(client->printer, "media-size-supported", IPP_TAG_BEGIN_COLLECTION);
 	  count     = ippGetCount(supported);
 
 	  for (i = 0; i < count ; i ++)
@@ -41,15 +41,77 @@
 #  include "device.h"
 
 
+//
+// Constants...
+//
+
+#  define _PAPPL_MAX_ATTRS_CACHE	16	// Maximum number of cached attribute sets
+#  define _PAPPL_MAX_WEB_EVENTS	8	// Maximum number of web interface event streams per printer
+#  define _PAPPL_JOB_CLEAN_BATCH	64	// Maximum number of jobs to clean per lock
+#  define _PAPPL_JOB_HASH_SIZE	64	// Initial size of job-id hash table
+#  define _PAPPL_OPTIONS_HASH_SIZE 128	// Size of option table hash (power of 2)
+#  define _PAPPL_RAW_BUFSIZE	65536	// Size of socket print copy buffers
+#  define _PAPPL_RAW_MAX_CONNS	16	// Maximum number of simultaneous socket print connections
+#  define _PAPPL_RAW_TIMEOUT	60	// Seconds of socket print inactivity before aborting
+#  define _PAPPL_SCHED_AGING	60	// Default seconds per "job-priority" level of aging
+#  define _PAPPL_STATUS_INTERVAL 2	// Default seconds between status updates
+#  define _PAPPL_STATUS_MAX_DELAY 60	// Maximum seconds between status updates with backoff
+
+
 //
 // Types and structures...
 //
 
+typedef struct _pappl_joblist_s		// List of jobs, newest first
+{
+  pappl_job_t		*first,			// First job
+			*last;			// Last job
+  int			count;			// Number of jobs
+} _pappl_joblist_t;
+
+typedef struct _pappl_userjobs_s	// Jobs for a user
+{
+  char			*username;		// "job-originating-user-name" value
+  _pappl_joblist_t	jobs;			// All jobs for user (user_next/prev)
+} _pappl_userjobs_t;
+
+typedef struct _pappl_optentry_s	// Option table entry
+{
+  struct _pappl_optentry_s *next;		// Next entry in hash bucket
+  const char		*name,			// Attribute name
+			*keyword;		// Keyword or media size name
+  int			value;			// Bit value or ready media index (-1 for none)
+  pwg_media_t		media;			// Media size, if any
+} _pappl_optentry_t;
+
+typedef struct _pappl_optable_s		// Option table compiled from driver data
+{
+  _pappl_optentry_t	*hash[_PAPPL_OPTIONS_HASH_SIZE];
+						// Hash buckets
+  int			num_entries;		// Number of entries
+  _pappl_optentry_t	entries[1];		// Entries
+} _pappl_optable_t;
+
+typedef struct _pappl_dtemplate_s	// Driver attributes shared by printers
+{
+  char			*key;			// Driver data key or `NULL` if not shared
+  int			refcount;		// Number of printers using the attributes
+  ipp_t			*attrs,			// Driver (capability) attributes
+			*media_col_database;	// "media-col-database" attribute, created as needed
+} _pappl_dtemplate_t;
+
+typedef struct _pappl_pattrs_s		// Cached printer attributes
+{
+  char			*ra;			// Requested attributes key
+  ipp_t			*attrs;			// Static and driver attributes
+} _pappl_pattrs_t;
+
 struct _pappl_printer_s			// Printer data
 {
   pthread_rwlock_t	rwlock;			// Reader/writer lock
   pappl_system_t	*system;		// Containing system
   int			printer_id;		// "printer-id" value
+  pappl_loglevel_t	loglevel;		// Log level or `PAPPL_LOGLEVEL_UNSPEC` for the system's level
   char			*name,			// "printer-name" value
 			*dns_sd_name,		// "printer-dns-sd-name" value
 			*location,		// "printer-location" value
@@ -65,28 +127,65 @@ struct _pappl_printer_s			// Printer data
   time_t		state_time;		// "printer-state-change-time" value
   bool			is_stopped,		// Are we stopping this printer?
 			is_deleted;		// Has this printer been deleted?
+  int			refcount;		// Number of references to the printer
+  int			num_web_events;		// Number of web interface event streams
   char			*device_id,		// "printer-device-id" value
 			*device_uri;		// Device URI
+  pappl_printer_t	*id_next,		// Next printer in "printer-id" hash bucket
+			*resource_next,		// Next printer in resource hash bucket
+			*uri_next;		// Next printer in device URI hash bucket
   pappl_device_t	*device;		// Current connection to device (if any)
   bool			device_in_use;		// Is the device in use?
+  int			device_idle_time;	// Seconds to keep an idle device open
+  time_t		device_close_time;	// Time to close the idle device
+  pappl_devmetrics_t	device_metrics;		// Metrics for closed device connections
+  pappl_devtimings_t	device_timings;		// Timing metrics for closed device connections
+  size_t		job_counts[3],		// Number of canceled, aborted, and completed jobs
+			job_secs[3];		// Seconds spent processing canceled, aborted, and completed jobs
   char			*driver_name;		// Driver name
   pappl_pr_driver_data_t driver_data;	// Driver data
-  ipp_t			*driver_attrs;		// Driver attributes
+  pthread_mutex_t	driver_mutex;		// Mutex for creating driver attributes
+  _pappl_dtemplate_t	*driver_template;	// Shared driver attributes, created as needed
+  ipp_t			*driver_extra;		// Printer-specific driver attributes and vendor defaults
+  _pappl_optable_t	*options;		// Option table, created as needed
+  int			options_gen;		// Option table generation
   ipp_t			*attrs;			// Other (static) printer attributes
   time_t		start_time;		// Startup time
   time_t		config_time;		// "printer-config-change-time" value
   time_t		status_time;		// Last time status was updated
+  int			status_interval,	// Seconds between status updates
+			status_delay;		// Current seconds between status updates, with backoff
+  bool			status_active;		// Is a status update running?
+  pthread_rwlock_t	attrs_rwlock;		// Reader/writer lock for attribute cache
+  cups_array_t		*attrs_cache;		// Cached static attributes
+  time_t		attrs_time;		// Time when attribute cache was started
   char			*print_group;		// PAM printing group, if any
   gid_t			print_gid;		// PAM printing group ID
   int			num_supply;		// Number of "printer-supply" values
   pappl_supply_t	supply[PAPPL_MAX_SUPPLY];
 						// "printer-supply" values
-  pappl_job_t		*processing_job;	// Currently printing job, if any
+  pappl_job_t		*processing_job;	// Currently printing job using the printer's device, if any
+  cups_array_t		*spool_jobs;		// Spooled jobs waiting for the device, oldest first
+  pthread_mutex_t	spool_mutex;		// Mutex for spooled job hand off
+  pthread_cond_t	spool_cond;		// Condition for spooled job hand off
+  int			max_processing_jobs,	// Maximum number of jobs to process at once
+			num_processing_jobs;	// Number of jobs being processed
+  pappl_scheduler_t	scheduler;		// Job scheduling policy
+  int			sched_aging;		// Seconds per "job-priority" level of aging
+  pappl_job_score_cb_t	sched_cb;		// Job scheduling score callback, if any
+  void			*sched_cbdata;		// Job scheduling score callback data
+  pappl_job_t		**pending;		// Heap of pending jobs by score
+  int			num_pending,		// Number of pending jobs
+			alloc_pending;		// Allocated size of pending heap
   int			max_active_jobs,	// Maximum number of active jobs to accept
 			max_completed_jobs;	// Maximum number of completed jobs to retain in history
-  cups_array_t		*active_jobs,		// Array of active jobs
-			*all_jobs,		// Array of all jobs
-			*completed_jobs;	// Array of completed jobs
+  _pappl_joblist_t	active_jobs,		// Active jobs
+			all_jobs,		// All jobs
+			completed_jobs;		// Completed jobs
+  cups_array_t		*user_jobs;		// All jobs by user (_pappl_userjobs_t)
+  struct _pappl_dplane_s *dplanes;		// Cached dither threshold planes
+  pappl_job_t		**job_hash;		// Hash table of all jobs by "job-id"
+  size_t		job_hash_size;		// Size of hash table (power of 2)
   int			next_job_id,		// Next "job-id" value
 			impcompleted;		// "printer-impressions-completed" value
   cups_array_t		*links;			// Web navigation links
@@ -102,12 +201,19 @@ struct _pappl_printer_s			// Printer data
   _pappl_srv_t		dns_sd_ref;		// DNS-SD services
 #  endif // HAVE_MDNSRESPONDER
   unsigned char		dns_sd_loc[16];		// DNS-SD LOC record data
+  char			*dns_sd_key;		// Registered service name, host, port, etc.
+  unsigned char		*dns_sd_txt;		// Registered IPP TXT record data
+  size_t		dns_sd_txtlen;		// Length of registered TXT record data
   bool			dns_sd_collision;	// Was there a name collision?
+  bool			dns_sd_update;		// Does the registration need to be redone?
   int			dns_sd_serial;		// DNS-SD serial number (for collisions)
   bool			raw_active;		// Raw listener active?
   int			num_raw_listeners;	// Number of raw socket listeners
   struct pollfd		raw_listeners[2];	// Raw socket listeners
+  int			wakefds[2];		// Wakeup pipe for raw listener thread
   bool			usb_active;		// USB gadget active?
+  pthread_mutex_t	threads_mutex;		// Mutex for raw/USB thread exits
+  pthread_cond_t	threads_cond;		// Condition for raw/USB thread exits
   unsigned short	usb_vendor_id,		// USB vendor ID
 			usb_product_id;		// USB product ID
   pappl_uoptions_t	usb_options;		// USB gadget options
@@ -124,17 +230,38 @@ extern void		*_papplPrinterRunRaw(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
 extern void		*_papplPrinterRunUSB(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
+extern void		_papplPrinterAddJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplPrinterAddPendingJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplPrinterCheckDeviceNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterCheckJobs(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern time_t		_papplPrinterCheckStatus(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterCleanJobs(pappl_printer_t *printer) _PAPPL_PRIVATE;
-extern void		_papplPrinterCopyAttributes(pappl_client_t *client, pappl_printer_t *printer, cups_array_t *ra, const char *format) _PAPPL_PRIVATE;
-extern void		_papplPrinterCopyState(pappl_client_t *client, ipp_t *ipp, pappl_printer_t *printer, cups_array_t *ra) _PAPPL_PRIVATE;
+extern void		_papplPrinterCloseDeviceNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern time_t		_papplPrinterCloseIdleDevice(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterCompleteJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplPrinterCopyAttributes(pappl_client_t *client, pappl_printer_t *printer, _pappl_raset_t *ra, const char *format) _PAPPL_PRIVATE;
+extern void		_papplPrinterCopyDriverAttrs(pappl_printer_t *printer, ipp_t *to, _pappl_raset_t *ra, int quickcopy) _PAPPL_PRIVATE;
+extern void		_papplPrinterCopyMediaColDatabase(pappl_printer_t *printer, ipp_t *to, ipp_t *filter) _PAPPL_PRIVATE;
+extern void		_papplPrinterCopyState(pappl_client_t *client, ipp_t *ipp, pappl_printer_t *printer, _pappl_raset_t *ra) _PAPPL_PRIVATE;
 extern void		_papplPrinterCopyXRI(pappl_client_t *client, ipp_t *ipp, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterDelete(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern ipp_attribute_t	*_papplPrinterFindDriverAttr(pappl_printer_t *printer, const char *name, ipp_tag_t value_tag) _PAPPL_PRIVATE;
+extern _pappl_joblist_t	*_papplPrinterFindUserJobsNoLock(pappl_printer_t *printer, const char *username) _PAPPL_PRIVATE;
+extern struct _pappl_dplane_s *_papplPrinterGetDitherPlane(pappl_printer_t *printer, pappl_dither_t dither, unsigned width) _PAPPL_PRIVATE;
+extern int		_papplPrinterGetDriverFormats(pappl_system_t *system, pappl_pr_driver_data_t *data, int max_formats, const char **formats, const char **preferred) _PAPPL_PRIVATE;
+extern _pappl_optable_t	*_papplPrinterGetOptionTable(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterInitDriverData(pappl_pr_driver_data_t *d) _PAPPL_PRIVATE;
 extern void		_papplPrinterProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern bool		_papplPrinterRegisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterRelease(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterReleaseDeviceNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterReleaseDriverAttrs(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern pappl_printer_t	*_papplPrinterRetain(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern bool		_papplPrinterSetAttributes(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterSortPendingJobsNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterUnregisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterUnscheduleJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplPrinterWakeup(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
 extern void		_papplPrinterWebCancelAllJobs(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebCancelJob(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
@@ -142,6 +269,7 @@ extern void		_papplPrinterWebConfig(pappl_client_t *client, pappl_printer_t *pri
 extern void		_papplPrinterWebConfigFinalize(pappl_printer_t *printer, int num_form, cups_option_t *form) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebDefaults(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebDelete(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterWebEvents(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebHome(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebIteratorCallback(pappl_printer_t *printer, pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplPrinterWebJobs(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
@@ -172,6 +300,8 @@ extern void		_papplMediaColImport(ipp_t *col, pappl_media_col_t *media) _PAPPL_P
 extern const char	*_papplMediaTrackingString(pappl_media_tracking_t v);
 extern pappl_media_tracking_t _papplMediaTrackingValue(const char *s);
 
+extern const _pappl_optentry_t *_papplOptionTableFind(_pappl_optable_t *table, const char *name, const char *keyword) _PAPPL_PRIVATE;
+
 extern const char	*_papplPrinterReasonString(pappl_preason_t value) _PAPPL_PRIVATE;
 extern pappl_preason_t	_papplPrinterReasonValue(const char *value) _PAPPL_PRIVATE;
 
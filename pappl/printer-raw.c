@@ -12,7 +12,47 @@
 // Include necessary headers...
 //
 
+#ifdef __linux
+#  define _GNU_SOURCE			// For splice()
+#endif // __linux
 #include "pappl-private.h"
+#ifdef __linux
+#  include <fcntl.h>
+#endif // __linux
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_rawconn_s		// Socket print connection
+{
+  int		sock;			// Client socket
+  pappl_job_t	*job;			// Print job or `NULL` while waiting
+  time_t	activity;		// Network activity watchdog
+  long long	spool_start;		// Start of spool span
+  bool		raster;			// Streaming Apple/PWG Raster data?
+#ifdef __linux
+  int		pipefds[2];		// Relay pipe for splice()
+#endif // __linux
+} _pappl_rawconn_t;
+
+
+//
+// Local functions...
+//
+
+static _pappl_rawconn_t *accept_conn(pappl_printer_t *printer, int fd);
+static void	close_conn(_pappl_rawconn_t *conn);
+static ssize_t	copy_data(_pappl_rawconn_t *conn, char *buffer);
+static void	finish_conn(pappl_printer_t *printer, _pappl_rawconn_t *conn, bool ok);
+static const char *get_raster_format(pappl_printer_t *printer, int sock);
+static void	*run_stream(_pappl_rawconn_t *conn);
+#ifdef __linux
+static ssize_t	splice_data(_pappl_rawconn_t *conn, char *buffer);
+#endif // __linux
+static bool	start_conn(pappl_printer_t *printer, _pappl_rawconn_t *conn);
+static bool	write_data(int fd, const char *buffer, size_t bytes);
 
 
 //
@@ -66,8 +106,21 @@ _papplPrinterAddRawListeners(
   }
 
   if (printer->num_raw_listeners > 0)
+  {
     papplLogPrinter(printer, PAPPL_LOGLEVEL_INFO, "Listening for socket print jobs on '*:%d'.", port);
 
+#if !_WIN32
+    // Create the pipe used to wake up the socket print thread...
+    if (printer->wakefds[0] < 0 && !pipe(printer->wakefds))
+    {
+      fcntl(printer->wakefds[0], F_SETFL, fcntl(printer->wakefds[0], F_GETFL) | O_NONBLOCK);
+      fcntl(printer->wakefds[1], F_SETFL, fcntl(printer->wakefds[1], F_GETFL) | O_NONBLOCK);
+      fcntl(printer->wakefds[0], F_SETFD, FD_CLOEXEC);
+      fcntl(printer->wakefds[1], F_SETFD, FD_CLOEXEC);
+    }
+#endif // !_WIN32
+  }
+
   return (printer->num_raw_listeners > 0);
 }
 
@@ -75,155 +128,576 @@ _papplPrinterAddRawListeners(
 //
 // '_papplPrinterRunRaw()' - Accept raw print requests over sockets.
 //
+// Up to `_PAPPL_RAW_MAX_CONNS` connections are accepted and spooled at the same
+// time.  Connections beyond the printer's active job limit stay open but are
+// not read until a job completes, so TCP flow control holds off the senders.
+//
 
 void *					// O - Thread exit value
 _papplPrinterRunRaw(
     pappl_printer_t *printer)		// I - Printer
 {
-  int	i;				// Looping var
+  int		i, j,			// Looping vars
+		num_pollfds,		// Number of poll() descriptors
+		first_conn,		// First connection in poll() descriptors
+		num_conns = 0;		// Number of connections
+  ssize_t	bytes;			// Bytes copied
+  time_t	curtime;		// Current time
+  struct pollfd	pollfds[_PAPPL_RAW_MAX_CONNS + 3];
+					// Listeners, wakeup pipe, and connections
+  _pappl_rawconn_t *conns[_PAPPL_RAW_MAX_CONNS],
+					// Connections in order of arrival
+		*pollconns[_PAPPL_RAW_MAX_CONNS],
+					// Connections being read
+		*conn;			// Current connection
+  char		wakebuf[256];		// Wakeup pipe data
+  char		*buffer;		// Copy buffer
 
 
   papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Running socket print thread with %d listeners.", printer->num_raw_listeners);
 
+  if ((buffer = malloc(_PAPPL_RAW_BUFSIZE)) == NULL)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to allocate socket print buffer: %s", strerror(errno));
+    return (NULL);
+  }
+
   printer->raw_active = true;
 
   while (!printer->is_deleted && printer->system->is_running)
   {
-    // Don't accept connections if we can't accept a new job...
-    while (cupsArrayCount(printer->active_jobs) >= printer->max_active_jobs && !printer->is_deleted && printer->system->is_running)
-      usleep(100000);
+    // Start jobs for waiting connections until we reach the active job limit -
+    // completed jobs, printer deletion, and system shutdown write to the
+    // wakeup pipe...
+    for (i = 0; i < num_conns;)
+    {
+      conn = conns[i];
+
+      if (!conn->job)
+      {
+        if (printer->max_active_jobs > 0 && printer->active_jobs.count >= printer->max_active_jobs)
+          break;
+
+        if (!start_conn(printer, conn))
+        {
+          num_conns --;
+          memmove(conns + i, conns + i + 1, (size_t)(num_conns - i) * sizeof(conns[0]));
+          continue;
+        }
+      }
+
+      i ++;
+    }
+
+    // Don't accept connections when all of the connection slots are in use...
+    for (num_pollfds = 0; num_pollfds < printer->num_raw_listeners; num_pollfds ++)
+    {
+      pollfds[num_pollfds].fd     = printer->raw_listeners[num_pollfds].fd;
+      pollfds[num_pollfds].events = num_conns < _PAPPL_RAW_MAX_CONNS ? POLLIN | POLLERR : 0;
+    }
+
+    if (printer->wakefds[0] >= 0)
+    {
+      pollfds[num_pollfds].fd     = printer->wakefds[0];
+      pollfds[num_pollfds].events = POLLIN;
+      num_pollfds ++;
+    }
+
+    // Only read from connections that have a job...
+    for (i = 0, first_conn = num_pollfds; i < num_conns; i ++)
+    {
+      if (conns[i]->job)
+      {
+        pollconns[num_pollfds - first_conn] = conns[i];
+        pollfds[num_pollfds].fd             = conns[i]->sock;
+        pollfds[num_pollfds].events         = POLLIN | POLLERR;
+        num_pollfds ++;
+      }
+    }
+
+    if ((i = poll(pollfds, (nfds_t)num_pollfds, printer->wakefds[0] < 0 || num_pollfds > first_conn ? 1000 : -1)) < 0)
+    {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      else
+        break;
+    }
 
     if (printer->is_deleted || !printer->system->is_running)
       break;
 
-    // Wait 1 second for new connections...
-    if ((i = poll(printer->raw_listeners, (nfds_t)printer->num_raw_listeners, 1000)) > 0)
+    if (printer->wakefds[0] >= 0 && pollfds[first_conn - 1].revents)
+    {
+      // Drain the wakeup pipe...
+      while (read(printer->wakefds[0], wakebuf, sizeof(wakebuf)) > 0);
+    }
+
+    // Got a new connection request, accept from the corresponding listener...
+    for (i = 0; i < printer->num_raw_listeners; i ++)
+    {
+      if ((pollfds[i].revents & POLLIN) && num_conns < _PAPPL_RAW_MAX_CONNS && (conn = accept_conn(printer, pollfds[i].fd)) != NULL)
+        conns[num_conns ++] = conn;
+    }
+
+    // Copy print data from each connection that has some...
+    curtime = time(NULL);
+
+    for (i = first_conn; i < num_pollfds; i ++)
     {
-      if (printer->is_deleted || !printer->system->is_running)
-	break;
+      conn = pollconns[i - first_conn];
 
-      // Got a new connection request, accept from the corresponding listener...
-      for (i = 0; i < printer->num_raw_listeners; i ++)
+      if (pollfds[i].revents)
       {
-        if (printer->raw_listeners[i].revents & POLLIN)
-        {
-          time_t	activity;	// Network activity watchdog
-          int		sock;		// Client socket
-          http_addr_t	sockaddr;	// Client address
-          socklen_t	sockaddrlen;	// Length of client address
-          struct pollfd	sockp;		// poll() data for client socket
-          pappl_job_t	*job;		// New print job
-          ssize_t	bytes;		// Bytes read from socket
-          char		buffer[8192];	// Copy buffer
-          char		filename[1024];	// Job filename
-
-          // Accept the connection...
-          sockaddrlen = sizeof(sockaddr);
-          if ((sock = (int)accept(printer->raw_listeners[i].fd, (struct sockaddr *)&sockaddr, &sockaddrlen)) < 0)
-          {
-            papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to accept socket print connection: %s", strerror(errno));
-            continue;
-          }
-
-	  // Create a new job with default attributes...
-	  papplLogPrinter(printer, PAPPL_LOGLEVEL_INFO, "Accepted socket print connection from '%s'.", httpAddrString(&sockaddr, buffer, sizeof(buffer)));
-          if ((job = _papplJobCreate(printer, 0, "guest", printer->driver_data.format ? printer->driver_data.format : "application/octet-stream", "Untitled", NULL)) == NULL)
-          {
-            close(sock);
-            continue;
-          }
-
-          // Read the print data from the socket...
-	  if ((job->fd = papplJobOpenFile(job, filename, sizeof(filename), printer->system->directory, NULL, "w")) < 0)
-	  {
-	    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create print file: %s", strerror(errno));
-
-	    goto abort_job;
-	  }
-
-	  if ((job->filename = strdup(filename)) == NULL)
-	  {
-            unlink(filename);
-	    goto abort_job;
-	  }
-
-	  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file \"%s\", format \"%s\".", filename, job->format);
-
-          activity     = time(NULL);
-          sockp.fd     = sock;
-          sockp.events = POLLIN | POLLERR;
-
-          for (;;)
-          {
-	    if (printer->is_deleted || !printer->system->is_running)
-	    {
-	      bytes = -1;
-	      break;
-	    }
-
-            if ((bytes = poll(&sockp, 1, 1000)) < 0)
-	    {
-	      if ((time(NULL) - activity) >= 60)
-	        break;
-	      else
-	        continue;
-	    }
-
-            activity = time(NULL);
-
-            if (sockp.revents & POLLIN)
-            {
-              if ((bytes = recv(sock, buffer, sizeof(buffer), 0)) > 0)
-                write(job->fd, buffer, (size_t)bytes);
-              else
-                break;
-            }
-            else if (sockp.revents & POLLERR)
-            {
-              bytes = -1;
-              break;
-            }
-          }
-
-          close(sock);
-	  close(job->fd);
-	  job->fd = -1;
-
-          if (bytes < 0)
-          {
-            // Error while reading
-	    goto abort_job;
-	  }
-
-	  // Finish the job...
-	  job->state = IPP_JSTATE_PENDING;
-
-	  _papplPrinterCheckJobs(printer);
-	  continue;
-
-	  // Abort the job...
-	  abort_job:
-
-	  job->state     = IPP_JSTATE_ABORTED;
-	  job->completed = time(NULL);
-
-	  pthread_rwlock_wrlock(&printer->rwlock);
-
-	  cupsArrayRemove(printer->active_jobs, job);
-	  cupsArrayAdd(printer->completed_jobs, job);
-
-	  if (!printer->system->clean_time)
-	    printer->system->clean_time = time(NULL) + 60;
-
-	  pthread_rwlock_unlock(&printer->rwlock);
-        }
+        conn->activity = curtime;
+
+        if ((bytes = copy_data(conn, buffer)) > 0 || (bytes < 0 && (errno == EINTR || errno == EAGAIN)))
+          continue;
+
+        if (bytes < 0)
+          papplLogJob(conn->job, PAPPL_LOGLEVEL_ERROR, "Unable to copy print data: %s", strerror(errno));
+      }
+      else if ((curtime - conn->activity) < _PAPPL_RAW_TIMEOUT)
+      {
+        continue;
       }
+      else
+      {
+        papplLogJob(conn->job, PAPPL_LOGLEVEL_ERROR, "Timed out waiting for print data.");
+        bytes = -1;
+      }
+
+      // Finish the job and remove the connection...
+      for (j = 0; j < num_conns && conns[j] != conn; j ++);
+
+      num_conns --;
+      memmove(conns + j, conns + j + 1, (size_t)(num_conns - j) * sizeof(conns[0]));
+
+      finish_conn(printer, conn, bytes == 0);
     }
-    else if (i < 0 && errno != EAGAIN)
-      break;
   }
 
+  // Abort any jobs that were in progress...
+  for (i = 0; i < num_conns; i ++)
+  {
+    if (conns[i]->job)
+      finish_conn(printer, conns[i], false);
+    else
+      close_conn(conns[i]);
+  }
+
+  free(buffer);
+
+  pthread_mutex_lock(&printer->threads_mutex);
   printer->raw_active = false;
+  pthread_cond_broadcast(&printer->threads_cond);
+  pthread_mutex_unlock(&printer->threads_mutex);
 
   return (NULL);
 }
+
+
+//
+// '_papplPrinterWakeup()' - Wake up the printer's socket print thread.
+//
+// This is used when printer deletion, system shutdown, or a completed job
+// needs the thread to re-check its state.
+//
+
+void
+_papplPrinterWakeup(
+    pappl_printer_t *printer)		// I - Printer
+{
+  if (printer->wakefds[1] >= 0 && write(printer->wakefds[1], "", 1) < 0 && errno != EAGAIN)
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to wake up socket print thread: %s", strerror(errno));
+}
+
+
+//
+// 'accept_conn()' - Accept a socket print connection.
+//
+
+static _pappl_rawconn_t *		// O - Connection or `NULL` on error
+accept_conn(pappl_printer_t *printer,	// I - Printer
+            int             fd)		// I - Listener socket
+{
+  _pappl_rawconn_t *conn;		// Connection
+  int		sock;			// Client socket
+  http_addr_t	sockaddr;		// Client address
+  socklen_t	sockaddrlen;		// Length of client address
+  char		addrstr[256];		// Client address string
+
+
+  sockaddrlen = sizeof(sockaddr);
+  if ((sock = (int)accept(fd, (struct sockaddr *)&sockaddr, &sockaddrlen)) < 0)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to accept socket print connection: %s", strerror(errno));
+    return (NULL);
+  }
+
+  papplLogPrinter(printer, PAPPL_LOGLEVEL_INFO, "Accepted socket print connection from '%s'.", httpAddrString(&sockaddr, addrstr, sizeof(addrstr)));
+
+  if ((conn = calloc(1, sizeof(_pappl_rawconn_t))) == NULL)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to allocate socket print connection: %s", strerror(errno));
+    close(sock);
+    return (NULL);
+  }
+
+  conn->sock     = sock;
+  conn->activity = time(NULL);
+#ifdef __linux
+  conn->pipefds[0] = conn->pipefds[1] = -1;
+#endif // __linux
+
+  return (conn);
+}
+
+
+//
+// 'close_conn()' - Close a socket print connection.
+//
+
+static void
+close_conn(_pappl_rawconn_t *conn)	// I - Connection
+{
+  close(conn->sock);
+
+#ifdef __linux
+  if (conn->pipefds[0] >= 0)
+  {
+    close(conn->pipefds[0]);
+    close(conn->pipefds[1]);
+  }
+#endif // __linux
+
+  free(conn);
+}
+
+
+//
+// 'copy_data()' - Copy available print data from the socket to the job file.
+//
+
+static ssize_t				// O - Number of bytes copied, `0` on EOF, or `-1` on error
+copy_data(_pappl_rawconn_t *conn,	// I - Connection
+          char             *buffer)	// I - Copy buffer
+{
+  ssize_t	bytes;			// Bytes copied
+
+
+#ifdef __linux
+  if (conn->pipefds[0] >= 0)
+  {
+    if ((bytes = splice_data(conn, buffer)) >= 0 || errno != ENOTSUP)
+      return (bytes);
+
+    // Fall back to copying...
+    close(conn->pipefds[0]);
+    close(conn->pipefds[1]);
+    conn->pipefds[0] = conn->pipefds[1] = -1;
+  }
+#endif // __linux
+
+  if ((bytes = recv(conn->sock, buffer, _PAPPL_RAW_BUFSIZE, 0)) > 0 && !write_data(conn->job->fd, buffer, (size_t)bytes))
+    bytes = -1;
+
+  return (bytes);
+}
+
+
+//
+// 'finish_conn()' - Queue or abort the job for a connection and close it.
+//
+
+static void
+finish_conn(pappl_printer_t  *printer,	// I - Printer
+            _pappl_rawconn_t *conn,	// I - Connection
+            bool             ok)	// I - Was all of the print data received?
+{
+  pappl_job_t	*job = conn->job;	// Print job
+
+
+  if (job->fd >= 0)
+  {
+    if (close(job->fd) && ok)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write print file: %s", strerror(errno));
+      ok = false;
+    }
+
+    job->fd = -1;
+  }
+
+  _PAPPL_TRACE_END(job, _PAPPL_JTRACE_SPOOL, conn->spool_start);
+
+  close_conn(conn);
+
+  if (ok)
+  {
+    // Finish the job...
+    pthread_rwlock_wrlock(&printer->rwlock);
+    _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_PENDING);
+    _papplPrinterAddPendingJobNoLock(printer, job);
+    _papplSystemAddEventNoLock(printer->system, printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job queued.");
+    pthread_rwlock_unlock(&printer->rwlock);
+
+    _papplPrinterCheckJobs(printer);
+  }
+  else
+  {
+    // Abort the job...
+    _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_ABORTED);
+
+    pthread_rwlock_wrlock(&printer->rwlock);
+
+    _papplPrinterCompleteJobNoLock(printer, job);
+
+    if (!printer->system->clean_time)
+    {
+      printer->system->clean_time = time(NULL) + 60;
+      _papplSystemWakeup(printer->system);
+    }
+
+    pthread_rwlock_unlock(&printer->rwlock);
+  }
+}
+
+
+//
+// 'get_raster_format()' - Check for Apple/PWG Raster data from a connection.
+//
+// Only data that has already been received is checked, so print data that
+// arrives later is always spooled.
+//
+
+static const char *			// O - MIME media type or `NULL` if not raster
+get_raster_format(
+    pappl_printer_t *printer,		// I - Printer
+    int             sock)		// I - Client socket
+{
+  char		header[8];		// Start of print data
+  struct pollfd	sockp;			// poll() data for client socket
+
+
+  if (!printer->driver_data.rstartjob_cb || !printer->driver_data.rwriteline_cb)
+    return (NULL);
+
+  sockp.fd     = sock;
+  sockp.events = POLLIN;
+
+  if (poll(&sockp, 1, 0) <= 0 || recv(sock, header, sizeof(header), MSG_PEEK) != (ssize_t)sizeof(header))
+    return (NULL);
+
+  if (!memcmp(header, "RaS2", 4))
+    return ("image/pwg-raster");
+  else if (!memcmp(header, "UNIRAST", 8))
+    return ("image/urf");
+  else
+    return (NULL);
+}
+
+
+//
+// 'run_stream()' - Send the print data for a connection directly to the device.
+//
+
+static void *				// O - Thread exit status
+run_stream(_pappl_rawconn_t *conn)	// I - Connection
+{
+  _papplJobProcessRaw(conn->job, conn->sock, conn->raster);
+  close_conn(conn);
+
+  return (NULL);
+}
+
+
+#ifdef __linux
+//
+// 'splice_data()' - Move print data from the socket to the job file.
+//
+// The data goes through a pipe so that it stays in the kernel.  `ENOTSUP` is
+// returned when the socket cannot be spliced so the caller can fall back to
+// copying.
+//
+
+static ssize_t				// O - Number of bytes moved, `0` on EOF, or `-1` on error
+splice_data(_pappl_rawconn_t *conn,	// I - Connection
+            char             *buffer)	// I - Copy buffer
+{
+  int		fd = conn->job->fd;	// Job file
+  ssize_t	count,			// Bytes in pipe
+		total,			// Bytes left to write
+		written;		// Bytes written
+
+
+  do
+  {
+    count = splice(conn->sock, NULL, conn->pipefds[1], NULL, _PAPPL_RAW_BUFSIZE, SPLICE_F_MOVE);
+  }
+  while (count < 0 && errno == EINTR);
+
+  if (count < 0 && (errno == EINVAL || errno == ENOSYS))
+  {
+    papplLogJob(conn->job, PAPPL_LOGLEVEL_DEBUG, "splice() not supported, copying data.");
+    errno = ENOTSUP;
+    return (-1);
+  }
+  else if (count <= 0)
+  {
+    return (count);
+  }
+
+  for (total = count; total > 0; total -= written)
+  {
+    if ((written = splice(conn->pipefds[0], NULL, fd, NULL, (size_t)total, SPLICE_F_MOVE)) < 0)
+    {
+      if (errno == EINTR)
+      {
+        written = 0;
+      }
+      else if (errno == EINVAL)
+      {
+        // Spool file cannot be spliced, copy what is in the pipe...
+        if ((written = read(conn->pipefds[0], buffer, (size_t)total)) <= 0 || !write_data(fd, buffer, (size_t)written))
+          return (-1);
+      }
+      else
+      {
+        return (-1);
+      }
+    }
+  }
+
+  return (count);
+}
+#endif // __linux
+
+
+//
+// 'start_conn()' - Start a job for a socket print connection.
+//
+// The connection is closed and `false` is returned when it no longer needs to
+// be read by the socket print thread, either because the job is being sent
+// directly to the device or because of an error.
+//
+
+static bool				// O - `true` to read the connection, `false` if it was closed
+start_conn(pappl_printer_t  *printer,	// I - Printer
+           _pappl_rawconn_t *conn)	// I - Connection
+{
+  pappl_job_t	*job;			// New print job
+  bool		stream = false;		// Send directly to the device?
+  const char	*raster_format = NULL;	// Apple/PWG Raster format, if any
+  pthread_t	tid;			// Streaming thread
+  char		filename[1024];		// Job filename
+
+
+  // Create a new job with default attributes...
+  if ((job = _papplJobCreate(printer, 0, "guest", printer->driver_data.format ? printer->driver_data.format : "application/octet-stream", "Untitled", NULL)) == NULL)
+  {
+    close_conn(conn);
+    return (false);
+  }
+
+  conn->job      = job;
+  conn->activity = time(NULL);
+
+  // Raster data that has already arrived can be printed as it is received by
+  // raster drivers...
+  if (!printer->driver_data.raw_streaming)
+    raster_format = get_raster_format(printer, conn->sock);
+
+  if ((printer->driver_data.raw_streaming && printer->driver_data.format) || raster_format)
+  {
+    // Reserve a processing slot for the job so that other connections don't
+    // also try to stream...
+    pthread_rwlock_wrlock(&printer->rwlock);
+
+    if ((stream = printer->num_processing_jobs < printer->max_processing_jobs) == true)
+    {
+      _PAPPL_JOB_SET_STATE(job, IPP_JSTATE_PENDING);
+      job->is_scheduled = true;
+      printer->num_processing_jobs ++;
+    }
+
+    pthread_rwlock_unlock(&printer->rwlock);
+  }
+
+  if (stream)
+  {
+    if (raster_format)
+    {
+      job->format  = raster_format;
+      conn->raster = true;
+    }
+
+    // Send the print data directly to the device...
+    if (pthread_create(&tid, NULL, (void *(*)(void *))run_stream, conn))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Unable to create streaming thread: %s", strerror(errno));
+      run_stream(conn);
+    }
+    else
+    {
+      pthread_detach(tid);
+    }
+
+    return (false);
+  }
+
+  // Create the print file...
+  conn->spool_start = _PAPPL_TRACE_BEGIN(job);
+
+  if ((job->fd = papplJobOpenFile(job, filename, sizeof(filename), printer->system->directory, NULL, "w")) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create print file: %s", strerror(errno));
+    finish_conn(printer, conn, false);
+    return (false);
+  }
+
+  if ((job->filename = strdup(filename)) == NULL)
+  {
+    unlink(filename);
+    finish_conn(printer, conn, false);
+    return (false);
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file \"%s\", format \"%s\".", filename, job->format);
+
+#ifdef __linux
+  if (pipe2(conn->pipefds, O_CLOEXEC))
+    conn->pipefds[0] = conn->pipefds[1] = -1;
+#endif // __linux
+
+  return (true);
+}
+
+
+//
+// 'write_data()' - Write all of a buffer to a file.
+//
+
+static bool				// O - `true` on success, `false` on error
+write_data(int        fd,		// I - File descriptor
+           const char *buffer,		// I - Buffer
+           size_t     bytes)		// I - Number of bytes
+{
+  ssize_t	written;		// Bytes written
+
+
+  while (bytes > 0)
+  {
+    if ((written = write(fd, buffer, bytes)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (false);
+    }
+
+    buffer += written;
+    bytes  -= (size_t)written;
+  }
+
+  return (true);
+}
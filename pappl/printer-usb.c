@@ -12,9 +12,13 @@
 // Include necessary headers...
 //
 
+#ifdef __linux
+#  define _GNU_SOURCE			// For splice()
+#endif // __linux
 #include "pappl-private.h"
 #include <cups/dir.h>
 #ifdef __linux
+#  include <fcntl.h>
 #  include <sys/ioctl.h>
 #  include <sys/mount.h>
 #  include <sys/syscall.h>
@@ -33,6 +37,7 @@
 #  define LINUX_USB_CONTROLLER	"/sys/class/udc"
 #  define LINUX_USB_GADGET	"/sys/kernel/config/usb_gadget/g1"
 #  define LINUX_IPPUSB_FFSPATH	"/dev/ffs-ippusb%d"
+#  define IPP_USB_BUFFER	65536	// Size of relay buffers and splice() requests
 #endif // __linux
 
 
@@ -71,7 +76,9 @@ typedef struct _ipp_usb_iface_s		// IPP-USB interface data
 		ipp_control,		// IPP-USB control file
 		ipp_to_device,		// IPP/HTTP requests file
 		ipp_to_host,		// IPP/HTTP responses file
-		ipp_sock;		// Local IPP socket connection, if any
+		ipp_sock,		// Local IPP socket connection, if any
+		relay_pipe[2];		// Pipe for splice() relay
+  bool		use_splice;		// Relay message bodies with splice()?
   http_addrlist_t *addrlist;		// Local socket address
   pthread_t	host_thread,		// Thread ID for "to host" comm
 		device_thread;		// Thread ID for "to printer" comm
@@ -92,6 +99,7 @@ static void	delete_ipp_usb_iface(_ipp_usb_iface_t *data);
 static void	disable_usb_printer(pappl_printer_t *printer, _ipp_usb_iface_t *ifaces);
 static bool	enable_usb_printer(pappl_printer_t *printer, _ipp_usb_iface_t *ifaces);
 static void	*run_ipp_usb_iface(_ipp_usb_iface_t *iface);
+static ssize_t	splice_data(_ipp_usb_iface_t *iface, int infd, int outfd, size_t bytes);
 #endif // __linux
 
 
@@ -403,6 +411,9 @@ create_ipp_usb_iface(
   iface->ipp_to_device = -1;
   iface->ipp_to_host    = -1;
   iface->ipp_sock       = -1;
+  iface->relay_pipe[0]  = -1;
+  iface->relay_pipe[1]  = -1;
+  iface->use_splice     = true;
   iface->addrlist       = NULL;
 
   // Start by creating the function in the configfs directory...
@@ -670,6 +681,13 @@ delete_ipp_usb_iface(
     iface->ipp_sock = -1;
   }
 
+  if (iface->relay_pipe[0] >= 0)
+  {
+    close(iface->relay_pipe[0]);
+    close(iface->relay_pipe[1]);
+    iface->relay_pipe[0] = iface->relay_pipe[1] = -1;
+  }
+
   httpAddrFreeList(iface->addrlist);
   iface->addrlist = NULL;
 
@@ -703,7 +721,10 @@ disable_usb_printer(
   for (i = 0; i < NUM_IPP_USB; i ++)
     delete_ipp_usb_iface(ifaces + i);
 
+  pthread_mutex_lock(&printer->threads_mutex);
   printer->usb_active = false;
+  pthread_cond_broadcast(&printer->threads_cond);
+  pthread_mutex_unlock(&printer->threads_mutex);
 }
 
 
@@ -1027,10 +1048,11 @@ static void *				// O - Thread exit status
 run_ipp_usb_iface(
     _ipp_usb_iface_t *iface)		// I - Thread data
 {
-  char		devbuf[8192],		// Device buffer
-		hostbuf[8192];		// Host buffer
+  char		devbuf[IPP_USB_BUFFER],	// Device buffer
+		hostbuf[IPP_USB_BUFFER];// Host buffer
   const char	*hostptr;		// Pointer into buffer
-  size_t	hostlen;		// Number of bytes in host buffer
+  size_t	hostlen,		// Number of bytes in host buffer
+		remaining;		// Body bytes that can be spliced
   ssize_t	bytes;			// Bytes read
 
 
@@ -1038,8 +1060,25 @@ run_ipp_usb_iface(
 
   while (!iface->printer->is_deleted && iface->printer->system->is_running)
   {
-    // Wait for data from the host...
-    if ((bytes = read(iface->ipp_to_device, hostbuf, sizeof(hostbuf))) > 0)
+    if (iface->ipp_sock >= 0 && iface->use_splice && (remaining = _papplHTTPMonitorGetDataRemaining(&iface->monitor)) > 0)
+    {
+      // Relay request body data directly to the local socket...
+      if ((bytes = splice_data(iface, iface->ipp_to_device, iface->ipp_sock, remaining)) < 0)
+      {
+        if (errno == ENOTSUP)
+          continue;			// Not supported, use read() and write()
+
+	papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Unable to send data to socket: %s", iface->number, strerror(errno));
+	close(iface->ipp_sock);
+	iface->ipp_sock = -1;
+	continue;
+      }
+
+      papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_DEBUG, "IPP-USB%d: Spliced %d bytes to socket %d.", iface->number, (int)bytes, iface->ipp_sock);
+
+      _papplHTTPMonitorSkipData(&iface->monitor, (size_t)bytes);
+    }
+    else if ((bytes = read(iface->ipp_to_device, hostbuf, sizeof(hostbuf))) > 0)
     {
       // Got data from the host, send it to the local socket...
       if (iface->ipp_sock < 0)
@@ -1085,56 +1124,80 @@ run_ipp_usb_iface(
 	iface->ipp_sock = -1;
 	continue;
       }
+    }
+    else
+      continue;
 
-      // If we are ready for a response, read it back...
-      if (iface->monitor.state != HTTP_STATE_WAITING && iface->monitor.phase == _PAPPL_HTTP_PHASE_SERVER_HEADERS)
+    // If we are ready for a response, read it back...
+    if (iface->monitor.state != HTTP_STATE_WAITING && iface->monitor.phase == _PAPPL_HTTP_PHASE_SERVER_HEADERS)
+    {
+      while (iface->monitor.state != HTTP_STATE_WAITING)
       {
-        while (iface->monitor.state != HTTP_STATE_WAITING)
+        if (iface->use_splice && (remaining = _papplHTTPMonitorGetDataRemaining(&iface->monitor)) > 0)
         {
-	  do
-	  {
-	    bytes = read(iface->ipp_sock, devbuf, sizeof(devbuf));
-	  }
-	  while (bytes < 0 && (errno == EAGAIN || errno == EINTR));
+          // Relay response body data directly to the host...
+          if ((bytes = splice_data(iface, iface->ipp_sock, iface->ipp_to_host, remaining)) > 0)
+          {
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_DEBUG, "IPP-USB%d: Spliced %d bytes to host.", iface->number, (int)bytes);
+	    _papplHTTPMonitorSkipData(&iface->monitor, (size_t)bytes);
+	    continue;
+          }
+          else if (bytes < 0 && errno != ENOTSUP)
+          {
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Error returning data to host: %s", iface->number, strerror(errno));
+	    goto error;
+          }
+          else if (bytes == 0)
+          {
+	    // Closed connection
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_INFO, "IPP-USB%d: Socket %d closed.", iface->number, iface->ipp_sock);
+	    break;
+          }
+        }
 
-	  if (bytes > 0)
-	  {
-	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_DEBUG, "IPP-USB%d: Returning %d bytes.", iface->number, (int)bytes);
-
-	    if (_papplHTTPMonitorProcessDeviceData(&iface->monitor, devbuf, bytes) == HTTP_STATUS_ERROR)
-	    {
-	      papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: %s", iface->number, _papplHTTPMonitorGetError(&iface->monitor));
-	      goto error;
-	    }
-
-	    if (write(iface->ipp_to_host, devbuf, (size_t)bytes) < 0)
-	    {
-	      papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Error returning data to host: %s", iface->number, strerror(errno));
-	      goto error;
-	    }
-	  }
-	  else if (bytes < 0)
-	  {
-	    // Close socket...
-	    if (errno == EPIPE || errno == ECONNRESET)
-	      papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_INFO, "IPP-USB%d: Socket %d closed prematurely.", iface->number, iface->ipp_sock);
-	    else
-	      papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Unable to read data from socket: %s", iface->number, strerror(errno));
+	do
+	{
+	  bytes = read(iface->ipp_sock, devbuf, sizeof(devbuf));
+	}
+	while (bytes < 0 && (errno == EAGAIN || errno == EINTR));
+
+	if (bytes > 0)
+	{
+	  papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_DEBUG, "IPP-USB%d: Returning %d bytes.", iface->number, (int)bytes);
 
+	  if (_papplHTTPMonitorProcessDeviceData(&iface->monitor, devbuf, (size_t)bytes) == HTTP_STATUS_ERROR)
+	  {
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: %s", iface->number, _papplHTTPMonitorGetError(&iface->monitor));
 	    goto error;
 	  }
-	  else if (bytes == 0)
+
+	  if (write(iface->ipp_to_host, devbuf, (size_t)bytes) < 0)
 	  {
-	    // Closed connection
-	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_INFO, "IPP-USB%d: Socket %d closed.", iface->number, iface->ipp_sock);
-	    break;
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Error returning data to host: %s", iface->number, strerror(errno));
+	    goto error;
 	  }
 	}
+	else if (bytes < 0)
+	{
+	  // Close socket...
+	  if (errno == EPIPE || errno == ECONNRESET)
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_INFO, "IPP-USB%d: Socket %d closed prematurely.", iface->number, iface->ipp_sock);
+	  else
+	    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_ERROR, "IPP-USB%d: Unable to read data from socket: %s", iface->number, strerror(errno));
 
-        // For now, always close socket after a completed request...
-        close(iface->ipp_sock);
-        iface->ipp_sock = -1;
+	  goto error;
+	}
+	else if (bytes == 0)
+	{
+	  // Closed connection
+	  papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_INFO, "IPP-USB%d: Socket %d closed.", iface->number, iface->ipp_sock);
+	  break;
+	}
       }
+
+      // For now, always close socket after a completed request...
+      close(iface->ipp_sock);
+      iface->ipp_sock = -1;
     }
   }
 
@@ -1153,4 +1216,108 @@ run_ipp_usb_iface(
 
   return (NULL);
 }
+
+
+//
+// 'splice_data()' - Relay message body data through a pipe with `splice()`.
+//
+// Up to @code IPP_USB_BUFFER@ bytes are moved from "infd" to "outfd" without
+// copying them to user space.  If the kernel cannot splice the input file,
+// splicing is disabled for the interface and `-1` is returned with `errno` set
+// to `ENOTSUP` without consuming any data.  If it cannot splice to the output
+// file, the data already in the pipe is copied with `read()` and `write()`.
+//
+
+static ssize_t				// O - Number of bytes relayed, `0` on EOF, or `-1` on error
+splice_data(_ipp_usb_iface_t *iface,	// I - IPP-USB interface
+            int              infd,	// I - Input file
+            int              outfd,	// I - Output file
+            size_t           bytes)	// I - Maximum number of bytes
+{
+  ssize_t	count,			// Bytes in pipe
+		total,			// Bytes left to write
+		written;		// Bytes written
+  bool		copy = false;		// Copy the pipe data instead of splicing?
+
+
+  if (iface->relay_pipe[0] < 0 && pipe2(iface->relay_pipe, O_CLOEXEC))
+  {
+    iface->use_splice = false;
+    errno             = ENOTSUP;
+    return (-1);
+  }
+
+  if (bytes > IPP_USB_BUFFER)
+    bytes = IPP_USB_BUFFER;
+
+  do
+  {
+    count = splice(infd, NULL, iface->relay_pipe[1], NULL, bytes, SPLICE_F_MOVE);
+  }
+  while (count < 0 && (errno == EAGAIN || errno == EINTR));
+
+  if (count < 0 && (errno == EINVAL || errno == ENOSYS))
+  {
+    papplLogPrinter(iface->printer, PAPPL_LOGLEVEL_DEBUG, "IPP-USB%d: splice() not supported, copying data.", iface->number);
+    iface->use_splice = false;
+    errno             = ENOTSUP;
+    return (-1);
+  }
+  else if (count <= 0)
+  {
+    return (count);
+  }
+
+  for (total = count; total > 0; total -= written)
+  {
+    if (copy)
+    {
+      // Output cannot be spliced, copy what is in the pipe...
+      char	buffer[8192],		// Copy buffer
+		*bufptr;		// Pointer into buffer
+      ssize_t	bytes,			// Bytes read
+		wbytes;			// Bytes written
+
+      do
+      {
+        bytes = read(iface->relay_pipe[0], buffer, (size_t)total < sizeof(buffer) ? (size_t)total : sizeof(buffer));
+      }
+      while (bytes < 0 && (errno == EAGAIN || errno == EINTR));
+
+      if (bytes <= 0)
+        return (-1);
+
+      for (bufptr = buffer, written = bytes; bytes > 0; bufptr += wbytes, bytes -= wbytes)
+      {
+        if ((wbytes = write(outfd, bufptr, (size_t)bytes)) < 0)
+        {
+          if (errno != EAGAIN && errno != EINTR)
+            return (-1);
+
+          wbytes = 0;
+        }
+      }
+    }
+    else if ((written = splice(iface->relay_pipe[0], NULL, outfd, NULL, (size_t)total, SPLICE_F_MOVE)) < 0)
+    {
+      if (errno == EAGAIN || errno == EINTR)
+      {
+        written = 0;
+      }
+      else if (errno == EINVAL)
+      {
+        // Copy the rest of the data and don't splice again...
+        iface->use_splice = false;
+        copy              = true;
+        written           = 0;
+      }
+      else
+      {
+        return (-1);
+      }
+    }
+  }
+
+  return (count);
+}
 #endif // __linux
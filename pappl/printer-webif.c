@@ -1,7 +1,7 @@
 //
 // Printer web interface functions for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -20,11 +20,14 @@
 //
 
 static void	job_cb(pappl_job_t *job, pappl_client_t *client);
-static char	*localize_keyword(const char *attrname, const char *keyword, char *buffer, size_t bufsize);
-static char	*localize_media(pappl_media_col_t *media, bool include_source, char *buffer, size_t bufsize);
+static char	*localize_keyword(pappl_client_t *client, const char *attrname, const char *keyword, char *buffer, size_t bufsize);
+static char	*localize_media(pappl_client_t *client, pappl_media_col_t *media, bool include_source, char *buffer, size_t bufsize);
 static void	media_chooser(pappl_client_t *client, pappl_pr_driver_data_t *driver_data, const char *title, const char *name, pappl_media_col_t *media);
 static char	*time_string(time_t tv, char *buffer, size_t bufsize);
 static void	job_pager(pappl_client_t *client, pappl_printer_t *printer, int job_index, int limit);
+static bool	job_status(pappl_job_t *job, char *buffer, size_t bufsize);
+static ipp_pstate_t printer_status(pappl_printer_t *printer, char *buffer, size_t bufsize);
+static void	put_events_script(pappl_client_t *client, pappl_printer_t *printer, ipp_pstate_t printer_state);
 
 
 //
@@ -457,7 +460,7 @@ _papplPrinterWebDefaults(
 
         if ((value = cupsGetOption(data.vendor[i], num_form, form)) != NULL)
 	  num_vendor = cupsAddOption(data.vendor[i], value, num_vendor, &vendor);
-	else if (ippFindAttribute(printer->driver_attrs, supattr, IPP_TAG_BOOLEAN))
+	else if (_papplPrinterFindDriverAttr(printer, supattr, IPP_TAG_BOOLEAN))
 	  num_vendor = cupsAddOption(data.vendor[i], "false", num_vendor, &vendor);
       }
 
@@ -509,13 +512,13 @@ _papplPrinterWebDefaults(
 
       if (strcmp(keyword, "manual"))
       {
-	papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, !strcmp(keyword, data.media_default.source) ? " selected" : "", localize_media(data.media_ready + i, show_source, text, sizeof(text)));
+	papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, !strcmp(keyword, data.media_default.source) ? " selected" : "", localize_media(client, data.media_ready + i, show_source, text, sizeof(text)));
       }
     }
     papplClientHTMLPuts(client, "</select>");
   }
   else
-    papplClientHTMLEscape(client, localize_media(data.media_ready, false, text, sizeof(text)), 0);
+    papplClientHTMLEscape(client, localize_media(client, data.media_ready, false, text, sizeof(text)), 0);
 
   papplClientHTMLPrintf(client, " <a class=\"btn\" href=\"%s/media\">Configure Media</a></td></tr>\n", printer->uriname);
 
@@ -540,7 +543,7 @@ _papplPrinterWebDefaults(
       if ((data.color_supported & (pappl_color_mode_t)i) && i != PAPPL_COLOR_MODE_AUTO_MONOCHROME)
       {
 	keyword = _papplColorModeString((pappl_color_mode_t)i);
-	papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"print-color-mode\" value=\"%s\"%s> %s</label> ", keyword, (pappl_color_mode_t)i == data.color_default ? " checked" : "", localize_keyword("print-color-mode", keyword, text, sizeof(text)));
+	papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"print-color-mode\" value=\"%s\"%s> %s</label> ", keyword, (pappl_color_mode_t)i == data.color_default ? " checked" : "", localize_keyword(client, "print-color-mode", keyword, text, sizeof(text)));
       }
     }
   }
@@ -555,7 +558,7 @@ _papplPrinterWebDefaults(
       if (data.sides_supported & (pappl_sides_t)i)
       {
 	keyword = _papplSidesString((pappl_sides_t)i);
-	papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"sides\" value=\"%s\"%s> %s</label> ", keyword, (pappl_sides_t)i == data.sides_default ? " checked" : "", localize_keyword("sides", keyword, text, sizeof(text)));
+	papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"sides\" value=\"%s\"%s> %s</label> ", keyword, (pappl_sides_t)i == data.sides_default ? " checked" : "", localize_keyword(client, "sides", keyword, text, sizeof(text)));
       }
     }
     papplClientHTMLPuts(client, "</td></tr>\n");
@@ -569,12 +572,12 @@ _papplPrinterWebDefaults(
     {
       papplClientHTMLPuts(client, "<select name=\"output-bin\">");
       for (i = 0; i < data.num_bin; i ++)
-	papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", data.bin[i], i == data.bin_default ? " selected" : "", localize_keyword("output-bin", data.bin[i], text, sizeof(text)));
+	papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", data.bin[i], i == data.bin_default ? " selected" : "", localize_keyword(client, "output-bin", data.bin[i], text, sizeof(text)));
       papplClientHTMLPuts(client, "</select>");
     }
     else
     {
-      papplClientHTMLPrintf(client, "%s", localize_keyword("output-bin", data.bin[data.bin_default], text, sizeof(text)));
+      papplClientHTMLPrintf(client, "%s", localize_keyword(client, "output-bin", data.bin[data.bin_default], text, sizeof(text)));
     }
     papplClientHTMLPuts(client, "</td></tr>\n");
   }
@@ -584,7 +587,7 @@ _papplPrinterWebDefaults(
   for (i = IPP_QUALITY_DRAFT; i <= IPP_QUALITY_HIGH; i ++)
   {
     keyword = ippEnumString("print-quality", i);
-    papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"print-quality\" value=\"%s\"%s> %s</label> ", keyword, (ipp_quality_t)i == data.quality_default ? " checked" : "", localize_keyword("print-quality", keyword, text, sizeof(text)));
+    papplClientHTMLPrintf(client, "<label><input type=\"radio\" name=\"print-quality\" value=\"%s\"%s> %s</label> ", keyword, (ipp_quality_t)i == data.quality_default ? " checked" : "", localize_keyword(client, "print-quality", keyword, text, sizeof(text)));
   }
   papplClientHTMLPuts(client, "</select></td></tr>\n");
 
@@ -619,7 +622,7 @@ _papplPrinterWebDefaults(
   for (i = PAPPL_CONTENT_AUTO; i <= PAPPL_CONTENT_TEXT_AND_GRAPHIC; i *= 2)
   {
     keyword = _papplContentString((pappl_content_t)i);
-    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, (pappl_content_t)i == data.content_default ? " selected" : "", localize_keyword("print-content-optimize", keyword, text, sizeof(text)));
+    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, (pappl_content_t)i == data.content_default ? " selected" : "", localize_keyword(client, "print-content-optimize", keyword, text, sizeof(text)));
   }
   papplClientHTMLPuts(client, "</select></td></tr>\n");
 
@@ -628,7 +631,7 @@ _papplPrinterWebDefaults(
   for (i = PAPPL_SCALING_AUTO; i <= PAPPL_SCALING_NONE; i *= 2)
   {
     keyword = _papplScalingString((pappl_scaling_t)i);
-    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, (pappl_scaling_t)i == data.scaling_default ? " selected" : "", localize_keyword("print-scaling", keyword, text, sizeof(text)));
+    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", keyword, (pappl_scaling_t)i == data.scaling_default ? " selected" : "", localize_keyword(client, "print-scaling", keyword, text, sizeof(text)));
   }
   papplClientHTMLPuts(client, "</select></td></tr>\n");
 
@@ -672,12 +675,12 @@ _papplPrinterWebDefaults(
     snprintf(defname, sizeof(defname), "%s-default", data.vendor[i]);
     snprintf(supname, sizeof(defname), "%s-supported", data.vendor[i]);
 
-    if ((attr = ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO)) != NULL)
+    if ((attr = _papplPrinterFindDriverAttr(printer, defname, IPP_TAG_ZERO)) != NULL)
       ippAttributeString(attr, defvalue, sizeof(defvalue));
     else
       defvalue[0] = '\0';
 
-    if ((attr = ippFindAttribute(printer->driver_attrs, supname, IPP_TAG_ZERO)) != NULL)
+    if ((attr = _papplPrinterFindDriverAttr(printer, supname, IPP_TAG_ZERO)) != NULL)
     {
       count = ippGetCount(attr);
 
@@ -769,7 +772,7 @@ _papplPrinterWebDelete(
     {
       status = "Invalid form submission.";
     }
-    else if (printer->processing_job)
+    else if (printer->num_processing_jobs > 0)
     {
       // Printer is processing a job...
       status = "Printer is currently active.";
@@ -802,6 +805,236 @@ _papplPrinterWebDelete(
 }
 
 
+//
+// '_papplPrinterWebEvents()' - Send a stream of printer and job updates.
+//
+// This resource sends "text/event-stream" updates to the printer web pages
+// using a private subscription, so the pages do not need to reload to show
+// job and printer state changes.  Events that arrive together are coalesced
+// into a single update for each job.  The number of streams for each printer
+// is limited to `_PAPPL_MAX_WEB_EVENTS`.
+//
+
+void
+_papplPrinterWebEvents(
+    pappl_client_t  *client,		// I - Client
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_subscription_t	*sub;		// Subscription
+  int			sub_id,		// Subscription ID
+			seq = 1,	// Next sequence number
+			i,		// Looping var
+			num_jobs;	// Number of updated jobs
+  int			job_ids[_PAPPL_MAX_EVENTS];
+					// Updated jobs
+  bool			job_created[_PAPPL_MAX_EVENTS],
+					// Was the job created?
+			printer_changed,// Did the printer change?
+			reload;		// Reload the page?
+  _pappl_notify_t	*notify;	// Current event notification
+  struct timespec	timeout;	// Timeout for waiting
+  pappl_job_t		*job;		// Current job
+  char			buffer[8192],	// Event data
+			status[1024];	// Status text
+  ipp_pstate_t		printer_state;	// Printer state
+
+
+  if (!papplClientHTMLAuthorize(client))
+    return;
+
+  // Limit the number of event streams for the printer...
+  pthread_rwlock_wrlock(&printer->rwlock);
+
+  if (printer->num_web_events >= _PAPPL_MAX_WEB_EVENTS)
+  {
+    pthread_rwlock_unlock(&printer->rwlock);
+    papplClientRespond(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    return;
+  }
+
+  printer->num_web_events ++;
+
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterRetain(printer);
+
+  if ((sub = _papplSubscriptionCreate(system, printer, NULL, PAPPL_EVENT_JOB_COMPLETED | PAPPL_EVENT_JOB_CREATED | PAPPL_EVENT_JOB_PROGRESS | PAPPL_EVENT_JOB_STATE_CHANGED | PAPPL_EVENT_PRINTER_STATE_CHANGED, client->username[0] ? client->username : "guest", NULL, NULL, 0, 2 * _PAPPL_NOTIFY_INTERVAL)) == NULL)
+  {
+    papplClientRespond(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    goto unavailable;
+  }
+
+  sub_id = sub->subscription_id;
+
+  if (!_papplClientLoopBeginWait(client))
+  {
+    pthread_mutex_lock(&system->subscription_mutex);
+    _papplSubscriptionDeleteNoLock(system, sub);
+    pthread_mutex_unlock(&system->subscription_mutex);
+
+    papplClientRespond(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    goto unavailable;
+  }
+
+  if (!papplClientRespond(client, HTTP_STATUS_OK, NULL, "text/event-stream", 0, 0))
+    goto done;
+
+  strlcpy(buffer, "retry: 5000\n\n", sizeof(buffer));
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  while (!system->shutdown_time && !printer->is_deleted)
+  {
+    // Send any pending update and wait for the next one...
+    pthread_mutex_unlock(&system->subscription_mutex);
+
+    if (buffer[0])
+    {
+      if (httpWrite2(client->http, buffer, strlen(buffer)) < 0 || httpFlushWrite(client->http) < 0)
+      {
+        pthread_mutex_lock(&system->subscription_mutex);
+        break;
+      }
+    }
+
+    pthread_mutex_lock(&system->subscription_mutex);
+
+    if ((sub = _papplSubscriptionFindNoLock(system, sub_id)) == NULL)
+      break;
+
+    // Keep the subscription from expiring while the stream is open...
+    sub->expire = time(NULL) + sub->lease;
+
+    if (seq > sub->last_sequence)
+    {
+      timeout.tv_sec  = time(NULL) + _PAPPL_NOTIFY_INTERVAL;
+      timeout.tv_nsec = 0;
+
+      if (pthread_cond_timedwait(&system->subscription_cond, &system->subscription_mutex, &timeout) == ETIMEDOUT)
+      {
+        // Send a comment so that idle connections are noticed...
+	strlcpy(buffer, ": keep-alive\n\n", sizeof(buffer));
+      }
+      else
+        buffer[0] = '\0';
+
+      if ((sub = _papplSubscriptionFindNoLock(system, sub_id)) == NULL)
+        break;
+
+      if (seq > sub->last_sequence)
+        continue;
+    }
+
+    // Collect the jobs and printer changes from the new events...
+    num_jobs        = 0;
+    printer_changed = false;
+    reload          = seq < sub->first_sequence;
+
+    if (reload)
+      seq = sub->first_sequence;
+
+    for (; seq <= sub->last_sequence; seq ++)
+    {
+      notify = sub->events[seq % _PAPPL_MAX_EVENTS];
+
+      if (notify->event & PAPPL_EVENT_PRINTER_STATE_CHANGED)
+        printer_changed = true;
+
+      if (notify->event & (PAPPL_EVENT_JOB_COMPLETED | PAPPL_EVENT_JOB_CREATED | PAPPL_EVENT_JOB_PROGRESS | PAPPL_EVENT_JOB_STATE_CHANGED))
+      {
+        int job_id = ippGetInteger(ippFindAttribute(notify->attrs, "notify-job-id", IPP_TAG_INTEGER), 0);
+					// Job ID for event
+
+        for (i = 0; i < num_jobs; i ++)
+        {
+          if (job_ids[i] == job_id)
+            break;
+	}
+
+        if (i >= num_jobs)
+        {
+          job_ids[num_jobs]     = job_id;
+          job_created[num_jobs] = false;
+          num_jobs ++;
+	}
+
+        if (notify->event & PAPPL_EVENT_JOB_CREATED)
+          job_created[i] = true;
+      }
+    }
+
+    pthread_mutex_unlock(&system->subscription_mutex);
+
+    // Format the update using the current job and printer state...
+    if (reload)
+    {
+      strlcpy(buffer, "event: reload\ndata:\n\n", sizeof(buffer));
+    }
+    else
+    {
+      size_t bufused = 0;		// Bytes used in buffer
+
+      buffer[0] = '\0';
+
+      for (i = 0; i < num_jobs && bufused < (sizeof(buffer) - 256); i ++)
+      {
+	if (job_created[i])
+	{
+	  snprintf(buffer + bufused, sizeof(buffer) - bufused, "event: job\ndata: {\"id\":%d,\"created\":true}\n\n", job_ids[i]);
+	}
+	else if ((job = papplPrinterFindJob(printer, job_ids[i])) != NULL)
+	{
+	  bool show_cancel = job_status(job, status, sizeof(status));
+					// Can the job be canceled?
+
+	  snprintf(buffer + bufused, sizeof(buffer) - bufused, "event: job\ndata: {\"id\":%d,\"pages\":%d,\"status\":\"%s\",\"cancel\":%s}\n\n", job_ids[i], papplJobGetImpressionsCompleted(job), status, show_cancel ? "true" : "false");
+	}
+
+	bufused += strlen(buffer + bufused);
+      }
+
+      if (i < num_jobs)
+      {
+        // Too many updates, have the page reload itself...
+        strlcpy(buffer, "event: reload\ndata:\n\n", sizeof(buffer));
+      }
+      else if (printer_changed)
+      {
+        printer_state = printer_status(printer, status, sizeof(status));
+
+        snprintf(buffer + bufused, sizeof(buffer) - bufused, "event: printer\ndata: {\"state\":\"%s\",\"status\":\"%s\"}\n\n", ippEnumString("printer-state", (int)printer_state), status);
+      }
+    }
+
+    pthread_mutex_lock(&system->subscription_mutex);
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  httpWrite2(client->http, "", 0);
+
+  done:
+
+  // Remove the subscription...
+  pthread_mutex_lock(&system->subscription_mutex);
+  if ((sub = _papplSubscriptionFindNoLock(system, sub_id)) != NULL)
+    _papplSubscriptionDeleteNoLock(system, sub);
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  _papplClientLoopEndWait(client);
+
+  unavailable:
+
+  pthread_rwlock_wrlock(&printer->rwlock);
+  printer->num_web_events --;
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  _papplPrinterRelease(printer);
+}
+
+
 //
 // '_papplPrinterWebHome()' - Show the printer home page.
 //
@@ -885,10 +1118,13 @@ _papplPrinterWebHome(
         else
         {
           // Submit the job for processing...
-          _papplJobSubmitFile(job, filename);
-
-          status        = "Test page printed.";
-          printer_state = IPP_PSTATE_PROCESSING;
+          if (_papplJobSubmitFile(job, filename, NULL, true))
+          {
+            status        = "Test page printed.";
+            printer_state = IPP_PSTATE_PROCESSING;
+          }
+          else
+            status = "Unable to print test page.";
         }
       }
       else
@@ -904,7 +1140,7 @@ _papplPrinterWebHome(
   }
 
   // Show status...
-  papplClientHTMLPrinterHeader(client, printer, NULL, printer_state == IPP_PSTATE_PROCESSING ? 10 : 0, NULL, NULL);
+  papplClientHTMLPrinterHeader(client, printer, NULL, 0, NULL, NULL);
 
   papplClientHTMLPuts(client,
                       "      <div class=\"row\">\n"
@@ -932,7 +1168,7 @@ _papplPrinterWebHome(
 
   if (papplPrinterGetNumberOfJobs(printer) > 0)
   {
-    if (cupsArrayCount(printer->active_jobs) > 0)
+    if (printer->active_jobs.count > 0)
       papplClientHTMLPrintf(client, " <a class=\"btn\" href=\"https://%s:%d%s/cancelall\">Cancel All Jobs</a></h1>\n", client->host_field, client->host_port, printer->uriname);
     else
       papplClientHTMLPuts(client, "</h1>\n");
@@ -963,6 +1199,8 @@ _papplPrinterWebHome(
     papplClientHTMLPuts(client, "        <p>No jobs in history.</p>\n");
   }
 
+  put_events_script(client, printer, printer_state);
+
   papplClientHTMLPrinterFooter(client);
 }
 
@@ -976,40 +1214,12 @@ _papplPrinterWebIteratorCallback(
     pappl_printer_t *printer,		// I - Printer
     pappl_client_t  *client)		// I - Client
 {
-  int			i;		// Looping var
-  pappl_preason_t	reason,		// Current reason
-			printer_reasons;// Printer state reasons
   ipp_pstate_t		printer_state;	// Printer state
-  int			printer_jobs;	// Number of queued jobs
-  char			uri[256];	// Form URI
-  static const char * const states[] =	// State strings
-  {
-    "Idle",
-    "Printing",
-    "Stopped"
-  };
-  static const char * const reasons[] =	// Reason strings
-  {
-    "Other",
-    "Cover Open",
-    "Tray Missing",
-    "Out of Ink",
-    "Low Ink",
-    "Waste Tank Almost Full",
-    "Waste Tank Full",
-    "Media Empty",
-    "Media Jam",
-    "Media Low",
-    "Media Needed",
-    "Too Many Jobs",
-    "Out of Toner",
-    "Low Toner"
-  };
+  char			status[1024],	// Status text
+			uri[256];	// Form URI
 
 
-  printer_jobs    = papplPrinterGetNumberOfActiveJobs(printer);
-  printer_state   = papplPrinterGetState(printer);
-  printer_reasons = papplPrinterGetReasons(printer);
+  printer_state = printer_status(printer, status, sizeof(status));
 
   snprintf(uri, sizeof(uri), "%s/", printer->uriname);
 
@@ -1020,12 +1230,7 @@ _papplPrinterWebIteratorCallback(
     papplClientHTMLPuts(client, "          <h1 class=\"title\">Status</h1>\n");
 
   papplClientHTMLPrintf(client,
-			"          <p><img class=\"%s\" src=\"%s/icon-md.png\">%s, %d %s", ippEnumString("printer-state", (int)printer_state), printer->uriname, states[printer_state - IPP_PSTATE_IDLE], printer_jobs, printer_jobs == 1 ? "job" : "jobs");
-  for (i = 0, reason = PAPPL_PREASON_OTHER; reason <= PAPPL_PREASON_TONER_LOW; i ++, reason *= 2)
-  {
-    if (printer_reasons & reason)
-      papplClientHTMLPrintf(client, ", %s", reasons[i]);
-  }
+			"          <p><img id=\"printer-%d-icon\" class=\"%s\" src=\"%s/icon-md.png\"><span id=\"printer-%d-status\">%s</span>", printer->printer_id, ippEnumString("printer-state", (int)printer_state), printer->uriname, printer->printer_id, status);
 
   if (strcmp(printer->name, printer->driver_data.make_and_model))
     papplClientHTMLPrintf(client, ".<br>%s</p>\n", printer->driver_data.make_and_model);
@@ -1088,17 +1293,17 @@ _papplPrinterWebJobs(
     cupsFreeOptions(num_form, form);
   }
 
-  if (cupsArrayCount(printer->active_jobs) > 0)
+  if (printer->active_jobs.count > 0)
   {
     char	url[1024];		// URL for Cancel All Jobs
 
     httpAssembleURIf(HTTP_URI_CODING_ALL, url, sizeof(url), "https", NULL, client->host_field, client->host_port, "%s/cancelall", printer->uriname);
 
-    papplClientHTMLPrinterHeader(client, printer, "Jobs", printer_state == IPP_PSTATE_PROCESSING ? 10 : 0, "Cancel All Jobs", url);
+    papplClientHTMLPrinterHeader(client, printer, "Jobs", 0, "Cancel All Jobs", url);
   }
   else
   {
-    papplClientHTMLPrinterHeader(client, printer, "Jobs", printer_state == IPP_PSTATE_PROCESSING ? 10 : 0, NULL, NULL);
+    papplClientHTMLPrinterHeader(client, printer, "Jobs", 0, NULL, NULL);
   }
 
   if (papplPrinterGetNumberOfJobs(printer) > 0)
@@ -1123,6 +1328,8 @@ _papplPrinterWebJobs(
   else
     papplClientHTMLPuts(client, "        <p>No jobs in history.</p>\n");
 
+  put_events_script(client, printer, printer_state);
+
   papplClientHTMLPrinterFooter(client);
 }
 
@@ -1259,7 +1466,7 @@ _papplPrinterWebMedia(
       continue;
 
     snprintf(name, sizeof(name), "ready%d", i);
-    media_chooser(client, &data, localize_keyword("media-source", data.source[i], text, sizeof(text)), name, data.media_ready + i);
+    media_chooser(client, &data, localize_keyword(client, "media-source", data.source[i], text, sizeof(text)), name, data.media_ready + i);
   }
 
   papplClientHTMLPuts(client,
@@ -1351,46 +1558,13 @@ static void
 job_cb(pappl_job_t    *job,		// I - Job
        pappl_client_t *client)		// I - Client
 {
-  bool	show_cancel = false;		// Show the "cancel" button?
-  char	when[256],			// When job queued/started/finished
-      	hhmmss[64];			// Time HH:MM:SS
+  bool	show_cancel;			// Show the "cancel" button?
+  char	when[256];			// When job queued/started/finished
 
 
-  switch (papplJobGetState(job))
-  {
-    case IPP_JSTATE_PENDING :
-    case IPP_JSTATE_HELD :
-	show_cancel = true;
-	snprintf(when, sizeof(when), "Queued at %s", time_string(papplJobGetTimeCreated(job), hhmmss, sizeof(hhmmss)));
-	break;
+  show_cancel = job_status(job, when, sizeof(when));
 
-    case IPP_JSTATE_PROCESSING :
-    case IPP_JSTATE_STOPPED :
-	if (papplJobIsCanceled(job))
-	{
-	  strlcpy(when, "Canceling", sizeof(when));
-	}
-	else
-	{
-	  show_cancel = true;
-	  snprintf(when, sizeof(when), "Started at %s", time_string(papplJobGetTimeProcessed(job), hhmmss, sizeof(hhmmss)));
-	}
-	break;
-
-    case IPP_JSTATE_ABORTED :
-	snprintf(when, sizeof(when), "Aborted at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
-	break;
-
-    case IPP_JSTATE_CANCELED :
-	snprintf(when, sizeof(when), "Canceled at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
-	break;
-
-    case IPP_JSTATE_COMPLETED :
-	snprintf(when, sizeof(when), "Completed at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
-	break;
-  }
-
-  papplClientHTMLPrintf(client, "              <tr><td>%d</td><td>%s</td><td>%s</td><td>%d</td><td>%s</td>", papplJobGetID(job), papplJobGetName(job), papplJobGetUsername(job), papplJobGetImpressionsCompleted(job), when);
+  papplClientHTMLPrintf(client, "              <tr id=\"job-%d\"><td>%d</td><td>%s</td><td>%s</td><td>%d</td><td>%s</td>", papplJobGetID(job), papplJobGetID(job), papplJobGetName(job), papplJobGetUsername(job), papplJobGetImpressionsCompleted(job), when);
 
   if (show_cancel)
     papplClientHTMLPrintf(client, "          <td><a class=\"btn\" href=\"%s/cancel?job-id=%d\">Cancel Job</a></td></tr>\n", job->printer->uriname, papplJobGetID(job));
@@ -1444,92 +1618,91 @@ job_pager(pappl_client_t  *client,	// I - Client
 }
 
 
+//
+// 'job_status()' - Get the status text for a job.
+//
+
+static bool				// O - `true` if the job can be canceled, `false` otherwise
+job_status(pappl_job_t *job,		// I - Job
+           char        *buffer,		// I - Status buffer
+           size_t      bufsize)		// I - Size of status buffer
+{
+  bool	show_cancel = false;		// Show the "cancel" button?
+  char	hhmmss[64];			// Time HH:MM:SS
+
+
+  switch (papplJobGetState(job))
+  {
+    case IPP_JSTATE_PENDING :
+    case IPP_JSTATE_HELD :
+	show_cancel = true;
+	snprintf(buffer, bufsize, "Queued at %s", time_string(papplJobGetTimeCreated(job), hhmmss, sizeof(hhmmss)));
+	break;
+
+    case IPP_JSTATE_PROCESSING :
+    case IPP_JSTATE_STOPPED :
+	if (papplJobIsCanceled(job))
+	{
+	  strlcpy(buffer, "Canceling", bufsize);
+	}
+	else
+	{
+	  show_cancel = true;
+	  snprintf(buffer, bufsize, "Started at %s", time_string(papplJobGetTimeProcessed(job), hhmmss, sizeof(hhmmss)));
+	}
+	break;
+
+    case IPP_JSTATE_ABORTED :
+	snprintf(buffer, bufsize, "Aborted at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
+	break;
+
+    case IPP_JSTATE_CANCELED :
+	snprintf(buffer, bufsize, "Canceled at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
+	break;
+
+    case IPP_JSTATE_COMPLETED :
+	snprintf(buffer, bufsize, "Completed at %s", time_string(papplJobGetTimeCompleted(job), hhmmss, sizeof(hhmmss)));
+	break;
+  }
+
+  return (show_cancel);
+}
+
+
 //
 // 'localize_keyword()' - Localize a media keyword...
 //
+// Keywords are looked up as "attrname.keyword" in the client's language and
+// PAPPL's built-in strings.  Otherwise the text is generated from the keyword.
+//
 
 static char *				// O - Localized string
 localize_keyword(
-    const char *attrname,		// I - Attribute name
-    const char *keyword,		// I - Keyword string
-    char       *buffer,			// I - String buffer
-    size_t     bufsize)			// I - String buffer size
+    pappl_client_t *client,		// I - Client
+    const char     *attrname,		// I - Attribute name
+    const char     *keyword,		// I - Keyword string
+    char           *buffer,		// I - String buffer
+    size_t         bufsize)		// I - String buffer size
 {
-  char	*ptr;				// Pointer into string
+  char		key[256],		// Localization key
+		*ptr;			// Pointer into string
+  const char	*text;			// Localized text
+  pwg_media_t	*pwg;			// PWG media size info
 
 
-  // TODO: Do real localization of keywords (Issue #58)
-  if (!strcmp(keyword, "bi-level"))
-  {
-    strlcpy(buffer, "B&W (no shading)", bufsize);
-  }
-  else if (!strcmp(keyword, "monochrome"))
-  {
-    strlcpy(buffer, "B&W", bufsize);
-  }
-  else if (!strcmp(keyword, "main-roll"))
-  {
-    strlcpy(buffer, "Main", bufsize);
-  }
-  else if (!strcmp(keyword, "alternate-roll"))
-  {
-    strlcpy(buffer, "Alternate", bufsize);
-  }
-  else if (!strcmp(keyword, "labels"))
-  {
-    strlcpy(buffer, "Cut Labels", bufsize);
-  }
-  else if (!strcmp(keyword, "labels-continuous"))
-  {
-    strlcpy(buffer, "Continuous Labels", bufsize);
-  }
-  else if (!strcmp(attrname, "media-type") && !strcmp(keyword, "continuous"))
-  {
-    strlcpy(buffer, "Continuous Paper", bufsize);
-  }
-  else if (!strncmp(keyword, "photographic", 12))
-  {
-    if (keyword[12] == '-')
-      snprintf(buffer, bufsize, "%c%s Photo Paper", toupper(keyword[13]), keyword + 14);
-    else
-      strlcpy(buffer, "Photo Paper", bufsize);
-  }
-  else if (!strcmp(keyword, "stationery"))
-  {
-    strlcpy(buffer, "Plain Paper", bufsize);
-  }
-  else if (!strcmp(keyword, "stationery-letterhead"))
-  {
-    strlcpy(buffer, "Letterhead", bufsize);
-  }
-  else if (!strcmp(keyword, "one-sided"))
-  {
-    strlcpy(buffer, "Off", bufsize);
-  }
-  else if (!strcmp(keyword, "two-sided-long-edge"))
+  snprintf(key, sizeof(key), "%s.%s", attrname, keyword);
+
+  if ((text = papplClientGetLocString(client, key)) != key)
   {
-    strlcpy(buffer, "On (Portrait)", bufsize);
+    strlcpy(buffer, text, bufsize);
   }
-  else if (!strcmp(keyword, "two-sided-short-edge"))
+  else if (!strcmp(attrname, "media-type") && !strncmp(keyword, "photographic-", 13) && keyword[13])
   {
-    strlcpy(buffer, "On (Landscape)", bufsize);
+    snprintf(buffer, bufsize, "%c%s Photo Paper", toupper(keyword[13]), keyword + 14);
   }
-  else if (!strcmp(attrname, "media"))
+  else if (!strcmp(attrname, "media") && (pwg = pwgMediaForPWG(keyword)) != NULL)
   {
-    pwg_media_t *pwg = pwgMediaForPWG(keyword);
-					// PWG media size info
-
-    if (!strcmp(pwg->ppd, "Letter"))
-      strlcpy(buffer, "US Letter", bufsize);
-    else if (!strcmp(pwg->ppd, "Legal"))
-      strlcpy(buffer, "US Legal", bufsize);
-    else if (!strcmp(pwg->ppd, "Env10"))
-      strlcpy(buffer, "#10 Envelope", bufsize);
-    else if (!strcmp(pwg->ppd, "A4") || !strcmp(pwg->ppd, "A5") || !strcmp(pwg->ppd, "A6"))
-      strlcpy(buffer, pwg->ppd, bufsize);
-    else if (!strcmp(pwg->ppd, "EnvDL"))
-      strlcpy(buffer, "DL Envelope", bufsize);
-    else if ((pwg->width % 100) == 0 && (pwg->width % 2540) != 0)
+    if ((pwg->width % 100) == 0 && (pwg->width % 2540) != 0)
       snprintf(buffer, bufsize, "%d x %dmm", pwg->width / 100, pwg->length / 100);
     else
       snprintf(buffer, bufsize, "%g x %g\"", pwg->width / 2540.0, pwg->length / 2540.0);
@@ -1558,6 +1731,7 @@ localize_keyword(
 
 static char *				// O - Localized description of the media
 localize_media(
+    pappl_client_t    *client,		// I - Client
     pappl_media_col_t *media,		// I - Media info
     bool              include_source,	// I - Include the media source?
     char              *buffer,		// I - String buffer
@@ -1572,12 +1746,12 @@ localize_media(
   if (!media->size_name[0])
     strlcpy(size, "Unknown", sizeof(size));
   else
-    localize_keyword("media", media->size_name, size, sizeof(size));
+    localize_keyword(client, "media", media->size_name, size, sizeof(size));
 
   if (!media->type[0])
     strlcpy(type, "Unknown", sizeof(type));
   else
-    localize_keyword("media-type", media->type, type, sizeof(type));
+    localize_keyword(client, "media-type", media->type, type, sizeof(type));
 
   if (!media->left_margin && !media->right_margin && !media->top_margin && !media->bottom_margin)
     borderless = ", Borderless";
@@ -1585,7 +1759,7 @@ localize_media(
     borderless = "";
 
   if (include_source)
-    snprintf(buffer, bufsize, "%s (%s%s) from %s", size, type, borderless, localize_keyword("media-source", media->source, source, sizeof(source)));
+    snprintf(buffer, bufsize, "%s (%s%s) from %s", size, type, borderless, localize_keyword(client, "media-source", media->source, source, sizeof(source)));
   else
     snprintf(buffer, bufsize, "%s (%s%s)", size, type, borderless);
 
@@ -1649,7 +1823,7 @@ media_chooser(
     if (!strcmp(driver_data->media[i], media->size_name))
       sel_index = cur_index;
 
-    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", driver_data->media[i], sel_index == cur_index ? " selected" : "", localize_keyword("media", driver_data->media[i], text, sizeof(text)));
+    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", driver_data->media[i], sel_index == cur_index ? " selected" : "", localize_keyword(client, "media", driver_data->media[i], text, sizeof(text)));
     cur_index ++;
   }
   if (min_size && max_size)
@@ -1730,7 +1904,7 @@ media_chooser(
       if (!(driver_data->tracking_supported & i))
 	continue;
 
-      papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", val, (pappl_media_tracking_t)i == media->tracking ? " selected" : "", localize_keyword("media-tracking", val, text, sizeof(text)));
+      papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", val, (pappl_media_tracking_t)i == media->tracking ? " selected" : "", localize_keyword(client, "media-tracking", val, text, sizeof(text)));
     }
     papplClientHTMLPuts(client, "</select>\n");
   }
@@ -1739,12 +1913,119 @@ media_chooser(
   papplClientHTMLPrintf(client, "                <select name=\"%s-type\">", name);
   for (i = 0; i < driver_data->num_type; i ++)
   {
-    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", driver_data->type[i], !strcmp(driver_data->type[i], media->type) ? " selected" : "", localize_keyword("media-type", driver_data->type[i], text, sizeof(text)));
+    papplClientHTMLPrintf(client, "<option value=\"%s\"%s>%s</option>", driver_data->type[i], !strcmp(driver_data->type[i], media->type) ? " selected" : "", localize_keyword(client, "media-type", driver_data->type[i], text, sizeof(text)));
   }
   papplClientHTMLPrintf(client, "</select></td></tr>\n");
 }
 
 
+//
+// 'printer_status()' - Get the status text for a printer.
+//
+
+static ipp_pstate_t			// O - Printer state
+printer_status(
+    pappl_printer_t *printer,		// I - Printer
+    char            *buffer,		// I - Status buffer
+    size_t          bufsize)		// I - Size of status buffer
+{
+  int			i;		// Looping var
+  pappl_preason_t	reason,		// Current reason
+			printer_reasons;// Printer state reasons
+  ipp_pstate_t		printer_state;	// Printer state
+  int			printer_jobs;	// Number of queued jobs
+  size_t		bufused;	// Bytes used in buffer
+  static const char * const states[] =	// State strings
+  {
+    "Idle",
+    "Printing",
+    "Stopped"
+  };
+  static const char * const reasons[] =	// Reason strings
+  {
+    "Other",
+    "Cover Open",
+    "Tray Missing",
+    "Out of Ink",
+    "Low Ink",
+    "Waste Tank Almost Full",
+    "Waste Tank Full",
+    "Media Empty",
+    "Media Jam",
+    "Media Low",
+    "Media Needed",
+    "Too Many Jobs",
+    "Out of Toner",
+    "Low Toner"
+  };
+
+
+  printer_jobs    = papplPrinterGetNumberOfActiveJobs(printer);
+  printer_state   = papplPrinterGetState(printer);
+  printer_reasons = papplPrinterGetReasons(printer);
+
+  snprintf(buffer, bufsize, "%s, %d %s", states[printer_state - IPP_PSTATE_IDLE], printer_jobs, printer_jobs == 1 ? "job" : "jobs");
+
+  for (i = 0, reason = PAPPL_PREASON_OTHER; reason <= PAPPL_PREASON_TONER_LOW; i ++, reason *= 2)
+  {
+    if ((printer_reasons & reason) && (bufused = strlen(buffer)) < bufsize)
+      snprintf(buffer + bufused, bufsize - bufused, ", %s", reasons[i]);
+  }
+
+  return (printer_state);
+}
+
+
+//
+// 'put_events_script()' - Show the script that updates a page from the event stream.
+//
+// Job rows and the printer status are updated in place as events arrive.  The
+// page is only reloaded when a new job is queued or events were missed.
+// Browsers without EventSource support fall back to reloading the page every
+// 10 seconds while the printer is busy.
+//
+
+static void
+put_events_script(
+    pappl_client_t  *client,		// I - Client
+    pappl_printer_t *printer,		// I - Printer
+    ipp_pstate_t    printer_state)	// I - Printer state
+{
+  papplClientHTMLPrintf(client,
+			"          <script>\n"
+			"if (window.EventSource) {\n"
+			"  let events = new EventSource('%s/events');\n"
+			"  events.addEventListener('job', function(e) {\n"
+			"    let job = JSON.parse(e.data);\n"
+			"    let row = document.getElementById('job-' + job.id);\n"
+			"    if (job.created) {\n"
+			"      location.reload();\n"
+			"    } else if (row) {\n"
+			"      row.cells[3].textContent = job.pages;\n"
+			"      row.cells[4].textContent = job.status;\n"
+			"      if (!job.cancel)\n"
+			"        row.cells[5].textContent = '';\n"
+			"    }\n"
+			"  });\n"
+			"  events.addEventListener('printer', function(e) {\n"
+			"    let printer = JSON.parse(e.data);\n"
+			"    let icon = document.getElementById('printer-%d-icon');\n"
+			"    let status = document.getElementById('printer-%d-status');\n"
+			"    if (icon)\n"
+			"      icon.className = printer.state;\n"
+			"    if (status)\n"
+			"      status.textContent = printer.status;\n"
+			"  });\n"
+			"  events.addEventListener('reload', function(e) {\n"
+			"    location.reload();\n"
+			"  });\n"
+			"} else if (%s) {\n"
+			"  setTimeout(function() { location.reload(); }, 10000);\n"
+			"}\n"
+			"</script>\n", printer->uriname, printer->printer_id, printer->printer_id, printer_state == IPP_PSTATE_PROCESSING ? "true" : "false");
+}
+
+
 //
 // 'time_string()' - Return the local time in hours, minutes, and seconds.
 //
@@ -19,9 +19,7 @@
 // Local functions...
 //
 
-static int	compare_active_jobs(pappl_job_t *a, pappl_job_t *b);
-static int	compare_all_jobs(pappl_job_t *a, pappl_job_t *b);
-static int	compare_completed_jobs(pappl_job_t *a, pappl_job_t *b);
+static void	remove_resources(pappl_printer_t *printer);
 
 
 //
@@ -36,16 +34,17 @@ void
 papplPrinterCancelAllJobs(
     pappl_printer_t *printer)		// I - Printer
 {
-  pappl_job_t	*job;			// Job information
+  pappl_job_t	*job,			// Job information
+		*next;			// Next job
 
 
-  // Loop through all jobs and cancel them.
-  //
-  // Since we have a writer lock, it is safe to use cupsArrayFirst/Last...
+  // Loop through all jobs and cancel them...
   pthread_rwlock_wrlock(&printer->rwlock);
 
-  for (job = (pappl_job_t *)cupsArrayFirst(printer->active_jobs); job; job = (pappl_job_t *)cupsArrayNext(printer->active_jobs))
+  for (job = printer->active_jobs.first; job; job = next)
   {
+    next = job->next;
+
     // Cancel this job...
     if (job->state == IPP_JSTATE_PROCESSING || (job->state == IPP_JSTATE_HELD && job->fd >= 0))
     {
@@ -53,20 +52,21 @@ papplPrinterCancelAllJobs(
     }
     else
     {
-      job->state     = IPP_JSTATE_CANCELED;
-      job->completed = time(NULL);
+      _PAPPL_JOB_SET_COMPLETED(job, IPP_JSTATE_CANCELED);
 
       _papplJobRemoveFile(job);
 
-      cupsArrayRemove(printer->active_jobs, job);
-      cupsArrayAdd(printer->completed_jobs, job);
+      _papplPrinterCompleteJobNoLock(printer, job);
     }
   }
 
   pthread_rwlock_unlock(&printer->rwlock);
 
   if (!printer->system->clean_time)
+  {
     printer->system->clean_time = time(NULL) + 60;
+    _papplSystemWakeup(printer->system);
+  }
 }
 
 
@@ -141,7 +141,24 @@ papplPrinterCreate(
     IPP_OP_SET_PRINTER_ATTRIBUTES,
     IPP_OP_CANCEL_MY_JOBS,
     IPP_OP_CLOSE_JOB,
-    IPP_OP_IDENTIFY_PRINTER
+    IPP_OP_IDENTIFY_PRINTER,
+    IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS,
+    IPP_OP_CREATE_JOB_SUBSCRIPTIONS,
+    IPP_OP_GET_SUBSCRIPTION_ATTRIBUTES,
+    IPP_OP_GET_SUBSCRIPTIONS,
+    IPP_OP_RENEW_SUBSCRIPTION,
+    IPP_OP_CANCEL_SUBSCRIPTION,
+    IPP_OP_GET_NOTIFICATIONS
+  };
+  static const char * const notify_events[] =
+  {					// notify-events-supported values
+    "job-completed",
+    "job-created",
+    "job-progress",
+    "job-state-changed",
+    "printer-config-changed",
+    "printer-state-changed",
+    "printer-stopped"
   };
   static const char * const charset[] =	// charset-supported values
   {
@@ -306,30 +323,42 @@ papplPrinterCreate(
 
   // Initialize printer structure and attributes...
   pthread_rwlock_init(&printer->rwlock, NULL);
-
-  printer->system             = system;
-  printer->name               = strdup(printer_name);
-  printer->dns_sd_name        = strdup(printer_name);
-  printer->resource           = strdup(resource);
-  printer->resourcelen        = strlen(resource);
-  printer->uriname            = printer->resource + 10; // Skip "/ipp/print" in resource
-  printer->device_id          = device_id ? strdup(device_id) : NULL;
-  printer->device_uri         = strdup(device_uri);
-  printer->driver_name        = strdup(driver_name);
-  printer->attrs              = ippNew();
-  printer->start_time         = time(NULL);
-  printer->config_time        = printer->start_time;
-  printer->state              = IPP_PSTATE_IDLE;
-  printer->state_reasons      = PAPPL_PREASON_NONE;
-  printer->state_time         = printer->start_time;
-  printer->all_jobs           = cupsArrayNew3((cups_array_func_t)compare_all_jobs, NULL, NULL, 0, NULL, (cups_afree_func_t)_papplJobDelete);
-  printer->active_jobs        = cupsArrayNew((cups_array_func_t)compare_active_jobs, NULL);
-  printer->completed_jobs     = cupsArrayNew((cups_array_func_t)compare_completed_jobs, NULL);
-  printer->next_job_id        = 1;
-  printer->max_active_jobs    = (system->options & PAPPL_SOPTIONS_MULTI_QUEUE) ? 0 : 1;
-  printer->max_completed_jobs = 100;
-  printer->usb_vendor_id      = 0x1209;	// See <pid.codes>
-  printer->usb_product_id     = 0x8011;
+  pthread_rwlock_init(&printer->attrs_rwlock, NULL);
+  pthread_mutex_init(&printer->driver_mutex, NULL);
+  pthread_mutex_init(&printer->threads_mutex, NULL);
+  pthread_cond_init(&printer->threads_cond, NULL);
+  pthread_mutex_init(&printer->spool_mutex, NULL);
+  pthread_cond_init(&printer->spool_cond, NULL);
+
+  printer->system              = system;
+  printer->loglevel            = PAPPL_LOGLEVEL_UNSPEC;
+  printer->name                = strdup(printer_name);
+  printer->dns_sd_name         = strdup(printer_name);
+  printer->resource            = strdup(resource);
+  printer->resourcelen         = strlen(resource);
+  printer->uriname             = printer->resource + 10; // Skip "/ipp/print" in resource
+  printer->device_id           = device_id ? strdup(device_id) : NULL;
+  printer->device_uri          = strdup(device_uri);
+  printer->driver_name         = strdup(driver_name);
+  printer->attrs               = ippNew();
+  printer->start_time          = time(NULL);
+  printer->config_time         = printer->start_time;
+  printer->state               = IPP_PSTATE_IDLE;
+  printer->state_reasons       = PAPPL_PREASON_NONE;
+  printer->state_time          = printer->start_time;
+  printer->next_job_id         = 1;
+  printer->max_active_jobs     = (system->options & PAPPL_SOPTIONS_MULTI_QUEUE) ? 0 : 1;
+  printer->max_completed_jobs  = 100;
+  printer->max_processing_jobs = 1;
+  printer->scheduler           = PAPPL_SCHEDULER_PRIORITY;
+  printer->sched_aging         = _PAPPL_SCHED_AGING;
+  printer->status_interval     = _PAPPL_STATUS_INTERVAL;
+  printer->status_delay        = _PAPPL_STATUS_INTERVAL;
+  printer->usb_vendor_id       = 0x1209;	// See <pid.codes>
+  printer->usb_product_id      = 0x8011;
+  printer->refcount            = 1;	// Reference held by the system
+  printer->wakefds[0]          = -1;
+  printer->wakefds[1]          = -1;
 
   if (!printer->name || !printer->dns_sd_name || !printer->resource || (device_id && !printer->device_id) || !printer->device_uri || !printer->driver_name || !printer->attrs)
   {
@@ -390,7 +419,9 @@ papplPrinterCreate(
 		*mdl,			// Model name
 		cmd[128],		// Command (format) list
 		*ptr;			// Pointer into string
-    ipp_attribute_t *formats;		// "document-format-supported" attribute
+    ipp_attribute_t *attr;		// "document-format-supported" attribute
+    const char	*formats[100],		// Supported formats
+		*preferred;		// Preferred format (unused)
     int		i,			// Looping var
 		count;			// Number of values
 
@@ -401,12 +432,21 @@ papplPrinterCreate(
     else
       mdl = mfg;			// No separator, so assume the make and model are the same
 
-    formats = ippFindAttribute(printer->driver_attrs, "document-format-supported", IPP_TAG_MIMETYPE);
-    count   = ippGetCount(formats);
+    // Get the formats from the driver data rather than the driver attributes,
+    // which are created when they are first needed...
+    if ((attr = ippFindAttribute(printer->driver_extra, "document-format-supported", IPP_TAG_MIMETYPE)) != NULL)
+    {
+      for (i = 0, count = ippGetCount(attr); i < count && i < (int)(sizeof(formats) / sizeof(formats[0])); i ++)
+        formats[i] = ippGetString(attr, i, NULL);
+
+      count = i;
+    }
+    else
+      count = _papplPrinterGetDriverFormats(system, &driver_data, (int)(sizeof(formats) / sizeof(formats[0])), formats, &preferred);
+
     for (i = 0, ptr = cmd; i < count; i ++)
     {
-      const char *format = ippGetString(formats, i, NULL);
-					// Current MIME media type
+      const char *format = formats[i];	// Current MIME media type
 
       if (!strcmp(format, "application/pdf"))
         format = "PDF";
@@ -478,7 +518,7 @@ papplPrinterCreate(
   ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-default", 50);
 
   // job-priority-supported
-  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-supported", 1);
+  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-supported", 100);
 
   // job-sheets-default
   ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_NAME), "job-sheets-default", NULL, "none");
@@ -515,10 +555,10 @@ papplPrinterCreate(
   ippAddStrings(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-document-handling-supported", sizeof(multiple_document_handling) / sizeof(multiple_document_handling[0]), NULL, multiple_document_handling);
 
   // multiple-document-jobs-supported
-  ippAddBoolean(printer->attrs, IPP_TAG_PRINTER, "multiple-document-jobs-supported", 0);
+  ippAddBoolean(printer->attrs, IPP_TAG_PRINTER, "multiple-document-jobs-supported", 1);
 
   // multiple-operation-time-out
-  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "multiple-operation-time-out", 60);
+  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "multiple-operation-time-out", _PAPPL_DOC_TIMEOUT);
 
   // multiple-operation-time-out-action
   ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "multiple-operation-time-out-action", NULL, "abort-job");
@@ -526,6 +566,24 @@ papplPrinterCreate(
   // natural-language-configured
   ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_LANGUAGE), "natural-language-configured", NULL, "en");
 
+  // notify-events-default
+  ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-events-default", NULL, "job-completed");
+
+  // notify-events-supported
+  ippAddStrings(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-events-supported", (int)(sizeof(notify_events) / sizeof(notify_events[0])), NULL, notify_events);
+
+  // notify-lease-duration-default
+  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "notify-lease-duration-default", _PAPPL_LEASE_DEFAULT);
+
+  // notify-lease-duration-supported
+  ippAddRange(printer->attrs, IPP_TAG_PRINTER, "notify-lease-duration-supported", 0, _PAPPL_LEASE_MAX);
+
+  // notify-max-events-supported
+  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "notify-max-events-supported", _PAPPL_MAX_EVENTS);
+
+  // notify-pull-method-supported
+  ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-pull-method-supported", NULL, "ippget");
+
   // operations-supported
   ippAddIntegers(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_ENUM, "operations-supported", (int)(sizeof(operations) / sizeof(operations[0])), operations);
 
@@ -669,6 +727,9 @@ papplPrinterCreate(
     snprintf(path, sizeof(path), "%s/config", printer->uriname);
     papplSystemAddResourceCallback(system, path, "text/html", (pappl_resource_cb_t)_papplPrinterWebConfig, printer);
 
+    snprintf(path, sizeof(path), "%s/events", printer->uriname);
+    papplSystemAddResourceCallback(system, path, "text/event-stream", (pappl_resource_cb_t)_papplPrinterWebEvents, printer);
+
     snprintf(path, sizeof(path), "%s/jobs", printer->uriname);
     papplSystemAddResourceCallback(system, path, "text/html", (pappl_resource_cb_t)_papplPrinterWebJobs, printer);
 
@@ -698,25 +759,31 @@ papplPrinterCreate(
 //
 // '_papplPrinterDelete()' - Free memory associated with a printer.
 //
+// This function stops the printer's USB/raw threads and removes its DNS-SD
+// registrations.  The remaining memory is freed once any other threads that
+// retained the printer release it.
+//
+// The printer's resources are removed by @link papplPrinterDelete@ after it
+// releases the printers lock, since this function is called by the printers
+// array with that lock held.
+//
 
 void
 _papplPrinterDelete(
     pappl_printer_t *printer)		// I - Printer
 {
   int			i;		// Looping var
-  _pappl_resource_t	*r;		// Current resource
-  char			prefix[1024];	// Prefix for printer resources
-  size_t		prefixlen;	// Length of prefix
 
 
-  // Let USB/raw printing threads know to exit
+  // Let USB/raw printing threads know to exit and wait for them to finish...
   printer->is_deleted = true;
 
+  _papplPrinterWakeup(printer);
+
+  pthread_mutex_lock(&printer->threads_mutex);
   while (printer->raw_active || printer->usb_active)
-  {
-    // Wait for threads to finish
-    usleep(100000);
-  }
+    pthread_cond_wait(&printer->threads_cond, &printer->threads_mutex);
+  pthread_mutex_unlock(&printer->threads_mutex);
 
   // Close raw listener sockets...
   for (i = 0; i < printer->num_raw_listeners; i ++)
@@ -734,31 +801,91 @@ _papplPrinterDelete(
   // Remove DNS-SD registrations...
   _papplPrinterUnregisterDNSSDNoLock(printer);
 
-  // Remove printer-specific resources...
-  snprintf(prefix, sizeof(prefix), "%s/", printer->uriname);
-  prefixlen = strlen(prefix);
+  _papplPrinterRelease(printer);
+}
+
+
+//
+// 'papplPrinterDelete()' - Delete a printer.
+//
+// This function deletes a printer from a system, freeing all memory and
+// canceling all jobs as needed.
+//
+
+void
+papplPrinterDelete(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_system_t *system = printer->system;
+					// System
 
-  // Note: System writer lock is already held when calling cupsArrayRemove
-  // for the system's printer object, so we don't need a separate lock here
-  // and can safely use cupsArrayFirst/Next...
-  for (r = (_pappl_resource_t *)cupsArrayFirst(printer->system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(printer->system->resources))
-  {
-    if (r->cbdata == printer || !strncmp(r->path, prefix, prefixlen))
-      cupsArrayRemove(printer->system->resources, r);
-  }
+
+  // Remove the printer from the system object, keeping a reference so that
+  // its resources can be removed without holding the printers lock...
+  _papplPrinterRetain(printer);
+
+  pthread_rwlock_wrlock(&system->printers_rwlock);
+  _papplSystemRemovePrinterIndexNoLock(system, printer);
+  cupsArrayRemove(system->printers, printer);
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
+  remove_resources(printer);
+  _papplPrinterRelease(printer);
+
+  _papplSystemConfigChanged(system);
+}
+
+
+//
+// '_papplPrinterRelease()' - Release a reference to a printer.
+//
+// The printer (and its jobs) are freed when the last reference is released.
+//
+
+void
+_papplPrinterRelease(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t		*job,		// Current job
+			*next;		// Next job
+  _pappl_dplane_t	*dplane,	// Current dither plane
+			*dnext;		// Next dither plane
+
+
+  if (!printer || _PAPPL_ATOMIC_ADD(&printer->refcount, -1) > 1)
+    return;
 
   // If applicable, call the delete function...
   if (printer->driver_data.delete_cb)
     (printer->driver_data.delete_cb)(printer, &printer->driver_data);
 
+  // Close any idle device connection...
+  if (printer->device)
+    papplDeviceClose(printer->device);
+
   // Delete jobs...
-  cupsArrayDelete(printer->active_jobs);
-  cupsArrayDelete(printer->completed_jobs);
-  cupsArrayDelete(printer->all_jobs);
+  for (job = printer->all_jobs.first; job; job = next)
+  {
+    next = job->all_next;
+    _papplJobDelete(job);
+  }
+
+  free(printer->job_hash);
+  free(printer->pending);
+
+  for (dplane = printer->dplanes; dplane; dplane = dnext)
+  {
+    dnext = dplane->next;
+    _papplDitherPlaneRelease(dplane);
+  }
+
+  cupsArrayDelete(printer->user_jobs);
 
   // Free memory...
   free(printer->name);
   free(printer->dns_sd_name);
+  free(printer->dns_sd_key);
+  free(printer->dns_sd_txt);
   free(printer->location);
   free(printer->geo_location);
   free(printer->organization);
@@ -769,70 +896,76 @@ _papplPrinterDelete(
   free(printer->driver_name);
   free(printer->usb_storage);
 
-  ippDelete(printer->driver_attrs);
+  _papplPrinterReleaseDriverAttrs(printer);
+  free(printer->options);
   ippDelete(printer->attrs);
 
+  cupsArrayDelete(printer->attrs_cache);
   cupsArrayDelete(printer->links);
+  cupsArrayDelete(printer->spool_jobs);
+
+  if (printer->wakefds[0] >= 0)
+    close(printer->wakefds[0]);
+  if (printer->wakefds[1] >= 0)
+    close(printer->wakefds[1]);
+
+  pthread_rwlock_destroy(&printer->attrs_rwlock);
+  pthread_mutex_destroy(&printer->driver_mutex);
+  pthread_mutex_destroy(&printer->threads_mutex);
+  pthread_cond_destroy(&printer->threads_cond);
+  pthread_mutex_destroy(&printer->spool_mutex);
+  pthread_cond_destroy(&printer->spool_cond);
 
   free(printer);
 }
 
 
 //
-// 'papplPrinterDelete()' - Delete a printer.
+// '_papplPrinterRetain()' - Retain a reference to a printer.
 //
-// This function deletes a printer from a system, freeing all memory and
-// canceling all jobs as needed.
+// The caller must hold the printers lock or another reference to the printer.
+// Retained printers remain valid after they are deleted from the system and
+// must be released with @link _papplPrinterRelease@.
 //
 
-void
-papplPrinterDelete(
+pappl_printer_t *			// O - Printer
+_papplPrinterRetain(
     pappl_printer_t *printer)		// I - Printer
 {
-  pappl_system_t *system = printer->system;
-					// System
-
+  if (printer)
+    _PAPPL_ATOMIC_ADD(&printer->refcount, 1);
 
-  // Remove the printer from the system object...
-  pthread_rwlock_wrlock(&system->rwlock);
-  cupsArrayRemove(system->printers, printer);
-  pthread_rwlock_unlock(&system->rwlock);
-
-  _papplSystemConfigChanged(system);
+  return (printer);
 }
 
 
 //
-// 'compare_active_jobs()' - Compare two active jobs.
+// 'remove_resources()' - Remove a printer's resources.
 //
 
-static int				// O - Result of comparison
-compare_active_jobs(pappl_job_t *a,	// I - First job
-                    pappl_job_t *b)	// I - Second job
+static void
+remove_resources(
+    pappl_printer_t *printer)		// I - Printer
 {
-  return (b->job_id - a->job_id);
-}
+  _pappl_resource_t	*r;		// Current resource
+  char			prefix[1024];	// Prefix for printer resources
+  size_t		prefixlen;	// Length of prefix
 
 
-//
-// 'compare_jobs()' - Compare two jobs.
-//
+  snprintf(prefix, sizeof(prefix), "%s/", printer->uriname);
+  prefixlen = strlen(prefix);
 
-static int				// O - Result of comparison
-compare_all_jobs(pappl_job_t *a,	// I - First job
-                 pappl_job_t *b)	// I - Second job
-{
-  return (b->job_id - a->job_id);
-}
+  // Note: The resource writer lock keeps other threads from enumerating the
+  // resources array, so we can safely use cupsArrayFirst/Next...
+  pthread_rwlock_wrlock(&printer->system->resource_rwlock);
 
+  for (r = (_pappl_resource_t *)cupsArrayFirst(printer->system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(printer->system->resources))
+  {
+    if (r->cbdata == printer || !strncmp(r->path, prefix, prefixlen))
+      _papplSystemRemoveResourceNoLock(printer->system, r);
+  }
 
-//
-// 'compare_completed_jobs()' - Compare two completed jobs.
-//
+  _papplSystemUpdateResourcesNoLock(printer->system);
 
-static int				// O - Result of comparison
-compare_completed_jobs(pappl_job_t *a,	// I - First job
-                       pappl_job_t *b)	// I - Second job
-{
-  return (b->job_id - a->job_id);
+  pthread_rwlock_unlock(&printer->system->resource_rwlock);
 }
@@ -16,6 +16,7 @@
 //
 
 #  include "base.h"
+#  include "log.h"
 
 
 //
@@ -187,6 +188,13 @@ enum pappl_scaling_e			// IPP "print-scaling" bit values
 };
 typedef unsigned pappl_scaling_t;	// Bitfield for IPP "print-scaling" values
 
+typedef enum pappl_scheduler_e		// Job scheduling policies
+{
+  PAPPL_SCHEDULER_FIFO,				// First-in, first-out
+  PAPPL_SCHEDULER_PRIORITY,			// "job-priority" with aging (default)
+  PAPPL_SCHEDULER_PRIORITY_SJF			// "job-priority" with aging, preferring shorter jobs
+} pappl_scheduler_t;
+
 enum pappl_sides_e			// IPP "sides" bit values
 {
   PAPPL_SIDES_ONE_SIDED = 0x01,			// 'one-sided'
@@ -266,6 +274,9 @@ typedef void (*pappl_default_cb_t)(ipp_attribute_t *attr, void *data);
 typedef void (*pappl_job_cb_t)(pappl_job_t *job, void *data);
 					// papplIterateXxxJobs callback function
 
+typedef double (*pappl_job_score_cb_t)(pappl_job_t *job, void *data);
+					// Job scheduling score callback
+
 typedef void (*pappl_pr_delete_cb_t)(pappl_printer_t *printer, pappl_pr_driver_data_t *data);
 					// Printer deletion callback
 typedef void (*pappl_pr_identify_cb_t)(pappl_printer_t *printer, pappl_identify_actions_t actions, const char *message);
@@ -282,6 +293,8 @@ typedef bool (*pappl_pr_rstartpage_cb_t)(pappl_job_t *job, pappl_pr_options_t *o
 					// Start a raster page callback
 typedef bool (*pappl_pr_rwriteline_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *line);
 					// Write a line of raster graphics callback
+typedef bool (*pappl_pr_rwritelines_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned num_lines, const unsigned char *lines);
+					// Write a band of raster graphics callback
 typedef bool (*pappl_pr_status_cb_t)(pappl_printer_t *printer);
 					// Update printer status callback
 typedef const char *(*pappl_pr_testpage_cb_t)(pappl_printer_t *printer, char *buffer, size_t bufsize);
@@ -433,6 +446,13 @@ struct pappl_pr_driver_data_s		// Printer driver data
   int			num_vendor;		// Number of vendor attributes
   const char		*vendor[PAPPL_MAX_VENDOR];
 						// Vendor attribute names
+  pappl_pr_rwritelines_cb_t rwritelines_cb;	// Write raster band callback, if any
+  bool			raw_streaming;		// Send socket print data directly to the device when idle?
+  bool			output_thread;		// Send job output to the device from a dedicated thread?
+  int			output_policy;		// Output thread scheduling policy (`SCHED_FIFO`, `SCHED_RR`, or `0` for default)
+  int			output_priority;	// Output thread scheduling priority
+  unsigned		output_cpus;		// Output thread CPU affinity mask or `0` for any
+  size_t		output_queue;		// Output queue size in bytes or `0` for default
 };
 
 
@@ -454,6 +474,7 @@ extern pappl_job_t	*papplPrinterFindJob(pappl_printer_t *printer, int job_id) _P
 
 extern pappl_contact_t	*papplPrinterGetContact(pappl_printer_t *printer, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetDeviceID(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern int		papplPrinterGetDeviceIdleTime(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetDeviceURI(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetDNSSDName(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern ipp_t		*papplPrinterGetDriverAttributes(pappl_printer_t *printer) _PAPPL_PUBLIC;
@@ -463,8 +484,10 @@ extern char		*papplPrinterGetGeoLocation(pappl_printer_t *printer, char *buffer,
 extern int		papplPrinterGetID(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetImpressionsCompleted(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetLocation(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern pappl_loglevel_t	papplPrinterGetLogLevel(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetMaxActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetMaxCompletedJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern int		papplPrinterGetMaxProcessingJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetName(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetNextJobID(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetNumberOfActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
@@ -475,7 +498,9 @@ extern char		*papplPrinterGetOrganizationalUnit(pappl_printer_t *printer, char *
 extern char		*papplPrinterGetPath(pappl_printer_t *printer, const char *subpath, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetPrintGroup(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern pappl_preason_t	papplPrinterGetReasons(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern pappl_scheduler_t	papplPrinterGetScheduler(pappl_printer_t *printer, int *aging_time) _PAPPL_PUBLIC;
 extern ipp_pstate_t	papplPrinterGetState(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern int		papplPrinterGetStatusInterval(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetSupplies(pappl_printer_t *printer, int max_supplies, pappl_supply_t *supplies) _PAPPL_PUBLIC;
 extern pappl_system_t	*papplPrinterGetSystem(pappl_printer_t *printer) _PAPPL_PUBLIC;
 
@@ -490,20 +515,26 @@ extern void		papplPrinterPause(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern void		papplPrinterRemoveLink(pappl_printer_t *printer, const char *label) _PAPPL_PUBLIC;
 extern void		papplPrinterResume(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern void		papplPrinterSetContact(pappl_printer_t *printer, pappl_contact_t *contact) _PAPPL_PUBLIC;
+extern void		papplPrinterSetDeviceIdleTime(pappl_printer_t *printer, int idle_time) _PAPPL_PUBLIC;
 extern void		papplPrinterSetDNSSDName(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetDriverData(pappl_printer_t *printer, pappl_pr_driver_data_t *data, ipp_t *attrs) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetDriverDefaults(pappl_printer_t *printer, pappl_pr_driver_data_t *data, int num_vendor, cups_option_t *vendor) _PAPPL_PUBLIC;
 extern void		papplPrinterSetGeoLocation(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetImpressionsCompleted(pappl_printer_t *printer, int add) _PAPPL_PUBLIC;
 extern void		papplPrinterSetLocation(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
+extern void		papplPrinterSetLogLevel(pappl_printer_t *printer, pappl_loglevel_t loglevel) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxActiveJobs(pappl_printer_t *printer, int max_active_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxCompletedJobs(pappl_printer_t *printer, int max_completed_jobs) _PAPPL_PUBLIC;
+extern void		papplPrinterSetMaxProcessingJobs(pappl_printer_t *printer, int max_processing_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetNextJobID(pappl_printer_t *printer, int next_job_id) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganization(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganizationalUnit(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetPrintGroup(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetReadyMedia(pappl_printer_t *printer, int num_ready, pappl_media_col_t *ready) _PAPPL_PUBLIC;
 extern void		papplPrinterSetReasons(pappl_printer_t *printer, pappl_preason_t add, pappl_preason_t remove) _PAPPL_PUBLIC;
+extern void		papplPrinterSetScheduler(pappl_printer_t *printer, pappl_scheduler_t scheduler, int aging_time) _PAPPL_PUBLIC;
+extern void		papplPrinterSetSchedulerCallback(pappl_printer_t *printer, pappl_job_score_cb_t cb, void *data) _PAPPL_PUBLIC;
+extern void		papplPrinterSetStatusInterval(pappl_printer_t *printer, int interval) _PAPPL_PUBLIC;
 extern void		papplPrinterSetSupplies(pappl_printer_t *printer, int num_supplies, pappl_supply_t *supplies) _PAPPL_PUBLIC;
 extern void		papplPrinterSetUSB(pappl_printer_t *printer, unsigned vendor_id, unsigned product_id, pappl_uoptions_t options, const char *storagefile) _PAPPL_PUBLIC;
 
@@ -1,7 +1,7 @@
 //
 // System resource implementation for the Printer Application Framework
 //
-// Copyright © 2019-2020 by Michael R Sweet.
+// Copyright © 2019-2021 by Michael R Sweet.
 // Copyright © 2010-2019 by Apple Inc.
 //
 // Licensed under Apache License v2.0.  See the file "LICENSE" for more
@@ -16,14 +16,43 @@
 #include <cups/dir.h>
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_RESOURCE_COMPRESS_MIN	1024
+					// Minimum size of compressed resources
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_rentry_s		// Resource hash table entry
+{
+  unsigned		hash;			// Hash of path
+  size_t		pathlen;		// Length of path
+  _pappl_resource_t	*resource;		// Resource
+} _pappl_rentry_t;
+
+struct _pappl_rtable_s			// Resource hash table
+{
+  _pappl_rtable_t	*prev;			// Previous (retired) table
+  size_t		mask;			// Bucket mask (size - 1)
+  _pappl_rentry_t	*entries;		// Entries
+};
+
+
 //
 // Local functions...
 //
 
 static void		add_resource(pappl_system_t *system, _pappl_resource_t *r);
+static void		add_rentry(_pappl_rtable_t *table, _pappl_resource_t *r, size_t pathlen);
 static int		compare_resources(_pappl_resource_t *a, _pappl_resource_t *b);
 static _pappl_resource_t *copy_resource(_pappl_resource_t *r);
 static void		free_resource(_pappl_resource_t *r);
+static unsigned		hash_path(const char *path, size_t pathlen);
 
 
 //
@@ -217,6 +246,8 @@ papplSystemAddResourceFile(
   r.length        = (size_t)fileinfo.st_size;
 
   add_resource(system, &r);
+
+  _papplLocInvalidate(system, path);
 }
 
 
@@ -292,6 +323,8 @@ papplSystemAddStringsData(
   r.length        = strlen(data);
 
   add_resource(system, &r);
+
+  _papplLocInvalidate(system, path);
 }
 
 
@@ -335,37 +368,86 @@ papplSystemAddStringsFile(
 }
 
 
+//
+// '_papplSystemDeleteResources()' - Free all resources for a system.
+//
+
+void
+_papplSystemDeleteResources(
+    pappl_system_t *system)		// I - System object
+{
+  _pappl_resource_t	*r;		// Current resource
+  _pappl_rtable_t	*table,		// Current table
+			*prev;		// Previous table
+
+
+  for (r = (_pappl_resource_t *)cupsArrayFirst(system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(system->resources))
+    free_resource(r);
+
+  cupsArrayDelete(system->resources);
+  cupsArrayDelete(system->retired_resources);
+
+  for (table = system->resource_table; table; table = prev)
+  {
+    prev = table->prev;
+
+    free(table->entries);
+    free(table);
+  }
+
+  system->resources         = NULL;
+  system->retired_resources = NULL;
+  system->resource_table    = NULL;
+}
+
+
 //
 // '_papplSystemFindResource()' - Find a resource at a path.
 //
+// Lookups use the current hash table without locking, counting themselves so
+// that retired tables can be freed once no lookups are using them.  Paths are
+// also matched against resources with a trailing slash, so "/foo" finds
+// "/foo/".
+//
 
 _pappl_resource_t *			// O - Resource object
 _papplSystemFindResource(
     pappl_system_t *system,		// I - System object
     const char     *path)		// I - Resource path
 {
-  _pappl_resource_t	key,		// Search key
-			*match;		// Matching resource, if any
-  char			altpath[1024];	// Alternate path
+  _pappl_rtable_t	*table;		// Current hash table
+  _pappl_rentry_t	*entry;		// Current entry
+  _pappl_resource_t	*r = NULL;	// Matching resource
+  size_t		pathlen,	// Length of path
+			bucket;		// Current bucket
+  unsigned		hash;		// Hash of path
 
 
-  if (!system || !system->resources || !path)
+  if (!system || !path)
     return (NULL);
 
-  key.path = (char *)path;
+  pathlen = strlen(path);
+  hash    = hash_path(path, pathlen);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  // Count this lookup before loading the table pointer, otherwise the table
+  // could be freed while it is being searched...
+  _PAPPL_ATOMIC_ADD(&system->resource_lookups, 1);
 
-  if ((match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key)) == NULL)
+  if ((table = (_pappl_rtable_t *)_PAPPL_ATOMIC_GETPTR(&system->resource_table)) != NULL)
   {
-    snprintf(altpath, sizeof(altpath), "%s/", path);
-    key.path = altpath;
-    match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key);
+    for (bucket = hash & table->mask; (entry = table->entries + bucket)->resource; bucket = (bucket + 1) & table->mask)
+    {
+      if (entry->hash == hash && entry->pathlen == pathlen && !memcmp(entry->resource->path, path, pathlen))
+      {
+        r = entry->resource;
+        break;
+      }
+    }
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  _PAPPL_ATOMIC_ADD(&system->resource_lookups, -1);
 
-  return (match);
+  return (r);
 }
 
 
@@ -382,6 +464,8 @@ papplSystemRemoveResource(
 {
   _pappl_resource_t	key,		// Search key
 			*match;		// Matching resource, if any
+  bool			is_strings = false;
+					// Removed a strings resource?
 
 
   if (!system || !system->resources || !path)
@@ -389,15 +473,134 @@ papplSystemRemoveResource(
 
   key.path = (char *)path;
 
-  pthread_rwlock_wrlock(&system->rwlock);
+  pthread_rwlock_wrlock(&system->resource_rwlock);
 
   if ((match = (_pappl_resource_t *)cupsArrayFind(system->resources, &key)) != NULL)
   {
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Removing resource for '%s'.", path);
-    cupsArrayRemove(system->resources, match);
+    is_strings = match->language != NULL;
+    _papplSystemRemoveResourceNoLock(system, match);
+    _papplSystemUpdateResourcesNoLock(system);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->resource_rwlock);
+
+  // Localizations lock the resources, so update them after unlocking...
+  if (is_strings)
+    _papplLocInvalidate(system, path);
+}
+
+
+//
+// '_papplSystemRemoveResourceNoLock()' - Remove a resource from the system.
+//
+// The resource writer lock must be held.  The resource is not freed until the
+// system is deleted since other threads may still be using it, and the hash
+// table must be updated using @link _papplSystemUpdateResourcesNoLock@.
+//
+
+void
+_papplSystemRemoveResourceNoLock(
+    pappl_system_t    *system,		// I - System object
+    _pappl_resource_t *r)		// I - Resource
+{
+  if (!system->retired_resources)
+    system->retired_resources = cupsArrayNew3(NULL, NULL, NULL, 0, NULL, (cups_afree_func_t)free_resource);
+
+  cupsArrayRemove(system->resources, r);
+  cupsArrayAdd(system->retired_resources, r);
+}
+
+
+//
+// '_papplSystemUpdateResourcesNoLock()' - Update the resource hash table.
+//
+// The resource writer lock must be held.  A new table is built from the
+// resources array and then published for lookups.  Old tables are kept until
+// an update finds that no lookups are running, since a lookup that started
+// before the new table was published may still be using them.
+//
+
+void
+_papplSystemUpdateResourcesNoLock(
+    pappl_system_t *system)		// I - System object
+{
+  _pappl_rtable_t	*table,		// New hash table
+			*prev;		// Retired table
+  _pappl_resource_t	*r;		// Current resource
+  size_t		size,		// Number of buckets
+			pathlen;	// Length of path
+
+
+  // Size the table for the resources and their alternate paths at no more than
+  // 50% load...
+  for (size = 64; size < (size_t)(4 * cupsArrayCount(system->resources)); size *= 2);
+
+  if ((table = calloc(1, sizeof(_pappl_rtable_t))) == NULL || (table->entries = calloc(size, sizeof(_pappl_rentry_t))) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for resource table: %s", strerror(errno));
+    free(table);
+    return;
+  }
+
+  table->mask = size - 1;
+  table->prev = system->resource_table;
+
+  // Add resources at their paths, then at their paths without any trailing
+  // slash unless there is a resource with that path...
+  for (r = (_pappl_resource_t *)cupsArrayFirst(system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(system->resources))
+    add_rentry(table, r, strlen(r->path));
+
+  for (r = (_pappl_resource_t *)cupsArrayFirst(system->resources); r; r = (_pappl_resource_t *)cupsArrayNext(system->resources))
+  {
+    if ((pathlen = strlen(r->path)) > 1 && r->path[pathlen - 1] == '/')
+      add_rentry(table, r, pathlen - 1);
+  }
+
+  _PAPPL_ATOMIC_SETPTR(&system->resource_table, table);
+
+  // Lookups that start after this point use the new table, so the retired
+  // tables can be freed if no lookups are running right now...
+  if (_PAPPL_ATOMIC_GET(&system->resource_lookups) == 0)
+  {
+    while ((prev = table->prev) != NULL)
+    {
+      table->prev = prev->prev;
+
+      free(prev->entries);
+      free(prev);
+    }
+  }
+}
+
+
+//
+// 'add_rentry()' - Add a resource to a hash table.
+//
+// Existing entries with the same path are kept.
+//
+
+static void
+add_rentry(_pappl_rtable_t   *table,	// I - Hash table
+           _pappl_resource_t *r,	// I - Resource
+           size_t            pathlen)	// I - Length of path to use
+{
+  _pappl_rentry_t	*entry;		// Current entry
+  size_t		bucket;		// Current bucket
+  unsigned		hash;		// Hash of path
+
+
+  hash = hash_path(r->path, pathlen);
+
+  for (bucket = hash & table->mask; (entry = table->entries + bucket)->resource; bucket = (bucket + 1) & table->mask)
+  {
+    if (entry->hash == hash && entry->pathlen == pathlen && !memcmp(entry->resource->path, r->path, pathlen))
+      return;
+  }
+
+  entry->hash     = hash;
+  entry->pathlen  = pathlen;
+  entry->resource = r;
 }
 
 
@@ -409,19 +612,25 @@ static void
 add_resource(pappl_system_t    *system,	// I - System object
              _pappl_resource_t *r)	// I - Resource
 {
-  pthread_rwlock_wrlock(&system->rwlock);
+  pthread_rwlock_wrlock(&system->resource_rwlock);
 
   if (!cupsArrayFind(system->resources, r))
   {
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Adding resource for '%s'.", r->path);
 
+    // Decide once whether the content is worth compressing - text formats
+    // shrink 3-5x, while PNG and other image formats are already compressed...
+    r->compress = !r->cb && r->length >= _PAPPL_RESOURCE_COMPRESS_MIN && (!strncmp(r->format, "text/", 5) || !strcmp(r->format, "application/javascript") || !strcmp(r->format, "application/json") || !strcmp(r->format, "image/svg+xml"));
+
     if (!system->resources)
-      system->resources = cupsArrayNew3((cups_array_func_t)compare_resources, NULL, NULL, 0, (cups_acopy_func_t)copy_resource, (cups_afree_func_t)free_resource);
+      system->resources = cupsArrayNew3((cups_array_func_t)compare_resources, NULL, NULL, 0, (cups_acopy_func_t)copy_resource, NULL);
 
     cupsArrayAdd(system->resources, r);
+
+    _papplSystemUpdateResourcesNoLock(system);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->resource_rwlock);
 }
 
 
@@ -454,6 +663,7 @@ copy_resource(_pappl_resource_t *r)	// I - Resource to copy
     newr->last_modified = r->last_modified;
     newr->data          = r->data;
     newr->length        = r->length;
+    newr->compress      = r->compress;
     newr->cb            = r->cb;
     newr->cbdata        = r->cbdata;
 
@@ -487,3 +697,25 @@ free_resource(_pappl_resource_t *r)	// I - Resource
 
   free(r);
 }
+
+
+//
+// 'hash_path()' - Compute the FNV-1a hash of a resource path.
+//
+
+static unsigned				// O - Hash value
+hash_path(const char *path,		// I - Path
+          size_t     pathlen)		// I - Length of path
+{
+  unsigned	hash = 2166136261U;	// Hash value
+
+
+  while (pathlen > 0)
+  {
+    hash ^= (unsigned char)*path++;
+    hash *= 16777619U;
+    pathlen --;
+  }
+
+  return (hash);
+}
@@ -26,11 +26,15 @@
 
 #define _PAPPL_SNMP_COMMUNITY	"public"// SNMP default community name
 #define _PAPPL_SNMP_PORT	161	// SNMP well-known port
+#define _PAPPL_SNMP_MAX_BATCH	32	// Maximum number of packets read at once
 #define _PAPPL_SNMP_MAX_COMMUNITY 512	// Maximum size of community name
 #define _PAPPL_SNMP_MAX_OID	128	// Maximum number of OID numbers
 #define _PAPPL_SNMP_MAX_PACKET	1472	// Maximum size of SNMP packet
+#define _PAPPL_SNMP_MAX_REPETITIONS 10	// GetBulkRequest-PDU max-repetitions value
 #define _PAPPL_SNMP_MAX_STRING	1024	// Maximum size of string
+#define _PAPPL_SNMP_MAX_WALKS	16	// Maximum number of simultaneous walks
 #define _PAPPL_SNMP_VERSION_1	0	// SNMPv1
+#define _PAPPL_SNMP_VERSION_2C	1	// SNMPv2c
 
 
 //
@@ -51,9 +55,13 @@ enum _pappl_asn1_e			// ASN1 request/object types
   _PAPPL_ASN1_COUNTER = 0x41,			// 32-bit unsigned aka Counter32
   _PAPPL_ASN1_GAUGE = 0x42,			// 32-bit unsigned aka Gauge32
   _PAPPL_ASN1_TIMETICKS = 0x43,			// 32-bit unsigned aka Timeticks32
+  _PAPPL_ASN1_NO_SUCH_OBJECT = 0x80,		// noSuchObject exception (SNMPv2c)
+  _PAPPL_ASN1_NO_SUCH_INSTANCE = 0x81,		// noSuchInstance exception (SNMPv2c)
+  _PAPPL_ASN1_END_OF_MIB_VIEW = 0x82,		// endOfMibView exception (SNMPv2c)
   _PAPPL_ASN1_GET_REQUEST = 0xa0,		// GetRequest-PDU
   _PAPPL_ASN1_GET_NEXT_REQUEST = 0xa1,		// GetNextRequest-PDU
-  _PAPPL_ASN1_GET_RESPONSE = 0xa2		// GetResponse-PDU
+  _PAPPL_ASN1_GET_RESPONSE = 0xa2,		// GetResponse-PDU
+  _PAPPL_ASN1_GET_BULK_REQUEST = 0xa5		// GetBulkRequest-PDU (SNMPv2c)
 };
 typedef enum _pappl_asn1_e _pappl_asn1_t;// ASN1 request/object types
 
@@ -92,6 +100,16 @@ typedef struct _pappl_snmp_s		// SNMP data packet
   union _pappl_snmp_value_u object_value;	// object-value value
 } _pappl_snmp_t;
 
+typedef struct _pappl_snmp_arena_s	// Reusable buffers for received packets
+{
+  int		num_packets;			// Number of packets received
+  size_t	lengths[_PAPPL_SNMP_MAX_BATCH];	// Length of each packet
+  http_addr_t	addresses[_PAPPL_SNMP_MAX_BATCH];
+						// Source address of each packet
+  unsigned char	packets[_PAPPL_SNMP_MAX_BATCH][_PAPPL_SNMP_MAX_PACKET];
+						// Packet data
+} _pappl_snmp_arena_t;
+
 typedef void (*_pappl_snmp_cb_t)(_pappl_snmp_t *packet, void *data);
 					// SNMP callback
 
@@ -102,12 +120,18 @@ typedef void (*_pappl_snmp_cb_t)(_pappl_snmp_t *packet, void *data);
 
 extern void		_papplSNMPClose(int fd) _PAPPL_PRIVATE;
 extern int		*_papplSNMPCopyOID(int *dst, const int *src, int dstsize) _PAPPL_PRIVATE;
+extern int		_papplSNMPDecode(unsigned char *buffer, size_t len, _pappl_snmp_t *packet, unsigned char **varbinds) _PAPPL_PRIVATE;
+extern _pappl_snmp_t	*_papplSNMPDecodeArena(_pappl_snmp_arena_t *arena, int n, _pappl_snmp_t *packet) _PAPPL_PRIVATE;
+extern int		_papplSNMPDecodeVarbind(unsigned char **bufptr, unsigned char *bufend, _pappl_snmp_t *packet) _PAPPL_PRIVATE;
+extern int		_papplSNMPEncode(_pappl_snmp_t *packet, unsigned char *buffer, size_t bufsize) _PAPPL_PRIVATE;
 extern int		_papplSNMPIsOID(_pappl_snmp_t *packet, const int *oid) _PAPPL_PRIVATE;
 extern int		_papplSNMPIsOIDPrefixed(_pappl_snmp_t *packet, const int *prefix) _PAPPL_PRIVATE;
 extern char		*_papplSNMPOIDToString(const int *src, char *dst, size_t dstsize) _PAPPL_PRIVATE;
 extern int		_papplSNMPOpen(int family) _PAPPL_PRIVATE;
 extern _pappl_snmp_t	*_papplSNMPRead(int fd, _pappl_snmp_t *packet, double timeout) _PAPPL_PRIVATE;
+extern int		_papplSNMPReadArena(int fd, _pappl_snmp_arena_t *arena, double timeout) _PAPPL_PRIVATE;
 extern int		_papplSNMPWalk(int fd, http_addr_t *address, int version, const char *community, const int *prefix, double timeout, _pappl_snmp_cb_t cb, void *data) _PAPPL_PRIVATE;
+extern int		_papplSNMPWalkMultiple(int fd, http_addr_t *address, int version, const char *community, int num_prefixes, const int * const *prefixes, double timeout, _pappl_snmp_cb_t cb, void *data) _PAPPL_PRIVATE;
 extern int		_papplSNMPWrite(int fd, http_addr_t *address, int version, const char *community, _pappl_asn1_t request_type, const unsigned request_id, const int *oid) _PAPPL_PRIVATE;
 
 #endif // !_PAPPL_SNMP_PRIVATE_H_
@@ -13,9 +13,24 @@
 // Include necessary headers.
 //
 
+#ifdef __linux
+#  define _GNU_SOURCE			// For recvmmsg()
+#endif // __linux
 #include "snmp-private.h"
 
 
+//
+// Local types...
+//
+
+typedef struct _pappl_snmp_walk_s	// State of a single walk
+{
+  const int	*prefix;			// OID prefix
+  int		lastoid[_PAPPL_SNMP_MAX_OID];	// Last OID we got
+  unsigned	request_id;			// Outstanding request ID or 0 for none
+} _pappl_snmp_walk_t;
+
+
 //
 // Macros...
 //
@@ -28,7 +43,8 @@
 // Local functions...
 //
 
-static int		asn1_decode_snmp(unsigned char *buffer, size_t len, _pappl_snmp_t *packet);
+static int		asn1_decode_snmp(unsigned char *buffer, size_t len, _pappl_snmp_t *packet, unsigned char **varbinds);
+static int		asn1_decode_varbind(unsigned char **bufptr, unsigned char *bufend, _pappl_snmp_t *packet);
 static int		asn1_encode_snmp(unsigned char *buffer, size_t len, _pappl_snmp_t *packet);
 static int		asn1_get_integer(unsigned char **buffer, unsigned char *bufend, unsigned length);
 static int		asn1_get_oid(unsigned char **buffer, unsigned char *bufend, unsigned length, int *oid, int oidsize);
@@ -44,6 +60,9 @@ static unsigned		asn1_size_integer(int integer);
 static unsigned		asn1_size_length(unsigned length);
 static unsigned		asn1_size_oid(const int *oid);
 static unsigned		asn1_size_packed(int integer);
+static bool		snmp_poll(int fd, double timeout);
+static ssize_t		snmp_read_packet(int fd, unsigned char *buffer, size_t bufsize, http_addr_t *address, double timeout);
+static int		snmp_write_packet(int fd, http_addr_t *address, int version, const char *community, _pappl_asn1_t request_type, unsigned request_id, int max_repetitions, const int *oid);
 
 
 //
@@ -80,6 +99,96 @@ _papplSNMPCopyOID(int       *dst,	// I - Destination OID
 }
 
 
+//
+// '_papplSNMPDecode()' - Decode a SNMP packet.
+//
+// The first variable binding is decoded into the packet.  If "varbinds" is
+// not `NULL`, it is set to the next variable binding for
+// @code _papplSNMPDecodeVarbind@, or `NULL` if the packet has no variable
+// bindings.
+//
+
+int					// O - 0 on success, -1 on error
+_papplSNMPDecode(
+    unsigned char *buffer,		// I - Buffer
+    size_t        len,			// I - Size of buffer
+    _pappl_snmp_t *packet,		// I - SNMP packet
+    unsigned char **varbinds)		// O - Next variable binding or `NULL`
+{
+  if (!buffer || !packet)
+    return (-1);
+
+  return (asn1_decode_snmp(buffer, len, packet, varbinds));
+}
+
+
+//
+// '_papplSNMPDecodeArena()' - Decode a packet in a packet arena.
+//
+// The packet is decoded directly from the buffer it was received into, so
+// the same arena and packet can be reused for each batch of responses.
+//
+
+_pappl_snmp_t *				// O - SNMP packet or @code NULL@ if none
+_papplSNMPDecodeArena(
+    _pappl_snmp_arena_t *arena,		// I - Packet arena
+    int                 n,		// I - Packet number (0-based)
+    _pappl_snmp_t       *packet)	// I - SNMP packet buffer
+{
+  // Range check input...
+  if (!arena || n < 0 || n >= arena->num_packets || !packet)
+    return (NULL);
+
+  if (!asn1_decode_snmp(arena->packets[n], arena->lengths[n], packet, NULL) && packet->request_type != _PAPPL_ASN1_GET_RESPONSE)
+    snmp_set_error(packet, _("Packet does not contain a Get-Response-PDU"));
+
+  packet->address = arena->addresses[n];
+
+  return (packet);
+}
+
+
+//
+// '_papplSNMPDecodeVarbind()' - Decode the next variable binding in a SNMP
+//                               packet.
+//
+// On return "bufptr" points to the next variable binding, even if the value
+// could not be decoded.
+//
+
+int					// O  - 0 on success, -1 on error
+_papplSNMPDecodeVarbind(
+    unsigned char **bufptr,		// IO - Pointer into buffer
+    unsigned char *bufend,		// I  - End of buffer
+    _pappl_snmp_t *packet)		// I  - SNMP packet
+{
+  if (!bufptr || !*bufptr || !bufend || !packet)
+    return (-1);
+
+  return (asn1_decode_varbind(bufptr, bufend, packet));
+}
+
+
+//
+// '_papplSNMPEncode()' - Encode a SNMP packet.
+//
+// For a GetBulkRequest-PDU the "error_status" and "error_index" members hold
+// the non-repeaters and max-repetitions values.
+//
+
+int					// O - Length on success, -1 on error
+_papplSNMPEncode(
+    _pappl_snmp_t *packet,		// I - SNMP packet
+    unsigned char *buffer,		// I - Buffer
+    size_t        bufsize)		// I - Size of buffer
+{
+  if (!packet || !buffer)
+    return (-1);
+
+  return (asn1_encode_snmp(buffer, bufsize, packet));
+}
+
+
 //
 // '_papplSNMPIsOID()' - Test whether a SNMP response contains the specified OID.
 //
@@ -210,7 +319,6 @@ _papplSNMPRead(int           fd,	// I - SNMP socket file descriptor
   unsigned char	buffer[_PAPPL_SNMP_MAX_PACKET];
 					// Data packet
   ssize_t	bytes;			// Number of bytes received
-  socklen_t	addrlen;		// Source address length
   http_addr_t	address;		// Source address
 
 
@@ -218,32 +326,13 @@ _papplSNMPRead(int           fd,	// I - SNMP socket file descriptor
   if (fd < 0 || !packet)
     return (NULL);
 
-  // Optionally wait for a response...
-  if (timeout >= 0.0)
-  {
-    int			ready;		// Data ready on socket?
-    struct pollfd	pfd;		// Polled file descriptor
-
-    pfd.fd     = fd;
-    pfd.events = POLLIN;
-
-    while ((ready = poll(&pfd, 1, (int)(timeout * 1000.0))) < 0 &&
-           (errno == EINTR || errno == EAGAIN))
-      ;					// Wait for poll to complete...
-
-    // If we don't have any data ready, return right away...
-    if (ready <= 0)
-      return (NULL);
-  }
-
   // Read the response data...
-  addrlen = sizeof(address);
-
-  if ((bytes = recvfrom(fd, buffer, sizeof(buffer), 0, (void *)&address, &addrlen)) < 0)
+  if ((bytes = snmp_read_packet(fd, buffer, sizeof(buffer), &address, timeout)) < 0)
     return (NULL);
 
   // Look for the response status code in the SNMP message header...
-  asn1_decode_snmp(buffer, (size_t)bytes, packet);
+  if (!asn1_decode_snmp(buffer, (size_t)bytes, packet, NULL) && packet->request_type != _PAPPL_ASN1_GET_RESPONSE)
+    snmp_set_error(packet, _("Packet does not contain a Get-Response-PDU"));
 
   memcpy(&(packet->address), &address, sizeof(packet->address));
 
@@ -252,16 +341,105 @@ _papplSNMPRead(int           fd,	// I - SNMP socket file descriptor
 }
 
 
+//
+// '_papplSNMPReadArena()' - Read all pending SNMP responses into a packet
+//                           arena.
+//
+// This function waits for the first response and then reads up to
+// `_PAPPL_SNMP_MAX_BATCH` responses that are already queued on the socket,
+// using a single `recvmmsg` call where available.  Use
+// @code _papplSNMPDecodeArena@ to decode each response.
+//
+// If "timeout" is negative, @code _papplSNMPReadArena@ will wait for a
+// response indefinitely.
+//
+
+int					// O - Number of responses or -1 on error
+_papplSNMPReadArena(
+    int                 fd,		// I - SNMP socket file descriptor
+    _pappl_snmp_arena_t *arena,		// I - Packet arena
+    double              timeout)	// I - Timeout in seconds
+{
+#ifdef __linux
+  int		i,			// Looping var
+		count;			// Number of packets
+  struct mmsghdr msgs[_PAPPL_SNMP_MAX_BATCH];
+					// Messages
+  struct iovec	iovs[_PAPPL_SNMP_MAX_BATCH];
+					// Message buffers
+#else
+  ssize_t	bytes;			// Bytes received
+  socklen_t	addrlen;		// Source address length
+#endif // __linux
+
+
+  // Range check input...
+  if (fd < 0 || !arena)
+    return (-1);
+
+  arena->num_packets = 0;
+
+  if (!snmp_poll(fd, timeout))
+    return (0);
+
+#ifdef __linux
+  // Read as many packets as are available with one system call...
+  memset(msgs, 0, sizeof(msgs));
+
+  for (i = 0; i < _PAPPL_SNMP_MAX_BATCH; i ++)
+  {
+    iovs[i].iov_base            = arena->packets[i];
+    iovs[i].iov_len             = sizeof(arena->packets[i]);
+    msgs[i].msg_hdr.msg_name    = arena->addresses + i;
+    msgs[i].msg_hdr.msg_namelen = sizeof(arena->addresses[i]);
+    msgs[i].msg_hdr.msg_iov     = iovs + i;
+    msgs[i].msg_hdr.msg_iovlen  = 1;
+  }
+
+  while ((count = recvmmsg(fd, msgs, _PAPPL_SNMP_MAX_BATCH, MSG_DONTWAIT, NULL)) < 0 && errno == EINTR)
+    ;					// Retry if interrupted...
+
+  if (count < 0)
+    return (errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1);
+
+  for (i = 0; i < count; i ++)
+    arena->lengths[i] = msgs[i].msg_len;
+
+  arena->num_packets = count;
+
+#else
+  // Read packets one at a time until there are no more...
+  do
+  {
+    addrlen = sizeof(arena->addresses[0]);
+
+    if ((bytes = recvfrom(fd, arena->packets[arena->num_packets], sizeof(arena->packets[0]), 0, (void *)(arena->addresses + arena->num_packets), &addrlen)) < 0)
+      return (arena->num_packets > 0 ? arena->num_packets : -1);
+
+    arena->lengths[arena->num_packets ++] = (size_t)bytes;
+  }
+  while (arena->num_packets < _PAPPL_SNMP_MAX_BATCH && snmp_poll(fd, 0.0));
+#endif // __linux
+
+  return (arena->num_packets);
+}
+
+
 //
 // '_papplSNMPWalk()' - Enumerate a group of OIDs.
 //
 // This function queries all of the OIDs with the specified OID prefix,
 // calling the "cb" function for every response that is received.
 //
+// For SNMPv2c each request is a GetBulkRequest-PDU that returns up to
+// `_PAPPL_SNMP_MAX_REPETITIONS` values, while SNMPv1 uses a
+// GetNextRequest-PDU for each value.
+//
 // The array pointed to by "prefix" is terminated by the value -1.
 //
 // If "timeout" is negative, @code _papplSNMPWalk@ will wait for a response
-// indefinitely.
+// indefinitely.  If the walk times out after some values were received, the
+// number of values found so far is returned.
 //
 
 int					// O - Number of OIDs found or -1 on error
@@ -275,43 +453,172 @@ _papplSNMPWalk(
     _pappl_snmp_cb_t cb,		// I - Function to call for each response
     void             *data)		// I - User data pointer that is passed to the callback function
 {
-  int		count = 0;		// Number of OIDs found
-  unsigned	request_id = 0;		// Current request ID
+  return (_papplSNMPWalkMultiple(fd, address, version, community, 1, &prefix, timeout, cb, data));
+}
+
+
+//
+// '_papplSNMPWalkMultiple()' - Enumerate several groups of OIDs at once.
+//
+// This function queries all of the OIDs with each of the specified OID
+// prefixes, calling the "cb" function for every value that is received.
+// A request for each prefix is kept outstanding at the same time and the
+// responses are matched to their walk by request-id, so walking the columns
+// of a table takes as many round trips as the longest column rather than
+// the sum of all of them.
+//
+// For SNMPv2c each request is a GetBulkRequest-PDU that returns up to
+// `_PAPPL_SNMP_MAX_REPETITIONS` values, while SNMPv1 uses a
+// GetNextRequest-PDU for each value.  Values from different prefixes may be
+// interleaved, but the values for each prefix are reported in order.
+//
+// Each array pointed to by "prefixes" is terminated by the value -1.
+//
+// If "timeout" is negative, @code _papplSNMPWalkMultiple@ will wait for a
+// response indefinitely.  If a walk times out or fails after some values were
+// received, the number of values found so far is returned.
+//
+
+int					// O - Number of OIDs found or -1 on error
+_papplSNMPWalkMultiple(
+    int              fd,		// I - SNMP socket
+    http_addr_t      *address,		// I - Address to query
+    int              version,		// I - SNMP version
+    const char       *community,	// I - Community name
+    int              num_prefixes,	// I - Number of OID prefixes
+    const int * const *prefixes,	// I - OID prefixes
+    double           timeout,		// I - Timeout for each response in seconds
+    _pappl_snmp_cb_t cb,		// I - Function to call for each response
+    void             *data)		// I - User data pointer that is passed to the callback function
+{
+  int		i,			// Looping var
+		count = 0,		// Number of OIDs found
+		num_values,		// Number of values in current response
+		outstanding = 0;	// Number of outstanding requests
+  bool		failed = false;		// Did a walk fail?
+  unsigned	request_id = 0;		// Last request ID
+  _pappl_snmp_walk_t walks[_PAPPL_SNMP_MAX_WALKS],
+			*walk;		// Current walk
   _pappl_snmp_t	packet;			// Current response packet
-  int		lastoid[_PAPPL_SNMP_MAX_OID];
-					// Last OID we got
+  unsigned char	buffer[_PAPPL_SNMP_MAX_PACKET],
+					// Response buffer
+		*bufptr,		// Pointer to next value
+		*bufend;		// End of response
+  ssize_t	bytes;			// Bytes received
+  http_addr_t	from;			// Source address
 
 
   // Range check input...
-  if (fd < 0 || !address || version != _PAPPL_SNMP_VERSION_1 || !community || !prefix || !cb)
+  if (fd < 0 || !address || (version != _PAPPL_SNMP_VERSION_1 && version != _PAPPL_SNMP_VERSION_2C) || !community || num_prefixes < 1 || num_prefixes > _PAPPL_SNMP_MAX_WALKS || !prefixes || !cb)
     return (-1);
 
-  // Copy the OID prefix and then loop until we have no more OIDs...
-  _papplSNMPCopyOID(packet.object_name, prefix, _PAPPL_SNMP_MAX_OID);
-  lastoid[0] = -1;
+  for (i = 0; i < num_prefixes; i ++)
+  {
+    if (!prefixes[i])
+      return (-1);
+  }
 
-  for (;;)
+  // Send the first request for each prefix...
+  for (i = 0, walk = walks; i < num_prefixes; i ++, walk ++)
   {
-    request_id ++;
+    walk->prefix     = prefixes[i];
+    walk->lastoid[0] = -1;
+    walk->request_id = ++ request_id;
 
-    if (!_papplSNMPWrite(fd, address, version, community, _PAPPL_ASN1_GET_NEXT_REQUEST, request_id, packet.object_name))
-      return (-1);
+    if (!snmp_write_packet(fd, address, version, community, version == _PAPPL_SNMP_VERSION_1 ? _PAPPL_ASN1_GET_NEXT_REQUEST : _PAPPL_ASN1_GET_BULK_REQUEST, walk->request_id, _PAPPL_SNMP_MAX_REPETITIONS, walk->prefix))
+    {
+      walk->request_id = 0;
+      failed           = true;
+    }
+    else
+      outstanding ++;
+  }
 
-    if (!_papplSNMPRead(fd, &packet, timeout))
-      return (-1);
+  while (outstanding > 0)
+  {
+    if ((bytes = snmp_read_packet(fd, buffer, sizeof(buffer), &from, timeout)) < 0)
+    {
+      failed = true;
+      break;
+    }
+
+    // Match the response to its walk, ignoring late or duplicate responses
+    // and responses from other hosts...
+    asn1_decode_snmp(buffer, (size_t)bytes, &packet, &bufptr);
+
+    if (!packet.request_id || packet.request_type != _PAPPL_ASN1_GET_RESPONSE || !httpAddrEqual(&from, address))
+      continue;
+
+    for (i = 0, walk = walks; i < num_prefixes; i ++, walk ++)
+    {
+      if (walk->request_id && walk->request_id == packet.request_id)
+        break;
+    }
+
+    if (i >= num_prefixes)
+      continue;
+
+    packet.address   = from;
+    walk->request_id = 0;
+    outstanding --;
+
+    if (packet.error_status || !bufptr)
+    {
+      failed = true;
+      continue;
+    }
+
+    // Report the values in the response...
+    bufend     = buffer + bytes;
+    num_values = 0;
+
+    for (;;)
+    {
+      if (packet.error)
+      {
+        // A response too large for our buffer is truncated, so continue from
+        // the last complete value if there was one...
+        if (!num_values)
+          failed = true;
+        break;
+      }
+
+      if (packet.object_type == _PAPPL_ASN1_END_OF_MIB_VIEW || packet.object_type == _PAPPL_ASN1_NO_SUCH_OBJECT || packet.object_type == _PAPPL_ASN1_NO_SUCH_INSTANCE || !_papplSNMPIsOIDPrefixed(&packet, walk->prefix) || _papplSNMPIsOID(&packet, walk->lastoid))
+      {
+        // This walk is done...
+        num_values = 0;
+        break;
+      }
+
+      _papplSNMPCopyOID(walk->lastoid, packet.object_name, _PAPPL_SNMP_MAX_OID);
+
+      count ++;
+      num_values ++;
 
-    if (!_papplSNMPIsOIDPrefixed(&packet, prefix) || _papplSNMPIsOID(&packet, lastoid))
-      return (count);
+      (*cb)(&packet, data);
 
-    if (packet.error || packet.error_status)
-      return (count > 0 ? count : -1);
+      if (bufptr >= bufend)
+        break;
 
-    _papplSNMPCopyOID(lastoid, packet.object_name, _PAPPL_SNMP_MAX_OID);
+      asn1_decode_varbind(&bufptr, bufend, &packet);
+    }
 
-    count ++;
+    // Continue the walk from the last value...
+    if (num_values > 0)
+    {
+      walk->request_id = ++ request_id;
 
-    (*cb)(&packet, data);
+      if (!snmp_write_packet(fd, address, version, community, version == _PAPPL_SNMP_VERSION_1 ? _PAPPL_ASN1_GET_NEXT_REQUEST : _PAPPL_ASN1_GET_BULK_REQUEST, walk->request_id, _PAPPL_SNMP_MAX_REPETITIONS, walk->lastoid))
+      {
+        walk->request_id = 0;
+        failed           = true;
+      }
+      else
+        outstanding ++;
+    }
   }
+
+  return (count > 0 || !failed ? count : -1);
 }
 
 
@@ -331,72 +638,52 @@ _papplSNMPWrite(
     const unsigned request_id,		// I - Request ID
     const int      *oid)		// I - OID
 {
-  int		i;			// Looping var
-  _pappl_snmp_t	packet;			// SNMP message packet
-  unsigned char	buffer[_PAPPL_SNMP_MAX_PACKET];
-					// SNMP message buffer
-  ssize_t	bytes;			// Size of message
-  http_addr_t	temp;			// Copy of address
-
-
   // Range check input...
-  if (fd < 0 || !address || version != _PAPPL_SNMP_VERSION_1 || !community || (request_type != _PAPPL_ASN1_GET_REQUEST && request_type != _PAPPL_ASN1_GET_NEXT_REQUEST) || request_id < 1 || !oid)
+  if (fd < 0 || !address || (version != _PAPPL_SNMP_VERSION_1 && version != _PAPPL_SNMP_VERSION_2C) || !community || (request_type != _PAPPL_ASN1_GET_REQUEST && request_type != _PAPPL_ASN1_GET_NEXT_REQUEST) || request_id < 1 || !oid)
     return (0);
 
-  // Create the SNMP message...
-  memset(&packet, 0, sizeof(packet));
-
-  packet.version      = version;
-  packet.request_type = request_type;
-  packet.request_id   = request_id;
-  packet.object_type  = _PAPPL_ASN1_NULL_VALUE;
-
-  strlcpy(packet.community, community, sizeof(packet.community));
-
-  for (i = 0; oid[i] >= 0 && i < (_PAPPL_SNMP_MAX_OID - 1); i ++)
-    packet.object_name[i] = oid[i];
-  packet.object_name[i] = -1;
-
-  if (oid[i] >= 0)
-  {
-    errno = E2BIG;
-    return (0);
-  }
-
-  bytes = asn1_encode_snmp(buffer, sizeof(buffer), &packet);
-
-  if (bytes < 0)
-  {
-    errno = E2BIG;
-    return (0);
-  }
-
-  // Send the message...
-  temp               = *address;
-  temp.ipv4.sin_port = htons(_PAPPL_SNMP_PORT);
-
-  return (sendto(fd, buffer, (size_t)bytes, 0, (void *)&temp, (socklen_t)httpAddrLength(&temp)) == bytes);
+  return (snmp_write_packet(fd, address, version, community, request_type, request_id, 0, oid));
 }
 
 
 //
 // 'asn1_decode_snmp()' - Decode a SNMP packet.
 //
+// GetResponse-PDUs and the GetRequest-PDU, GetNextRequest-PDU, and
+// GetBulkRequest-PDU requests are decoded.  The first variable binding is
+// decoded into the packet.  If "varbinds" is not `NULL`, it is set to the next
+// variable binding in a SNMPv2c GetBulkRequest-PDU response, or `NULL` if the
+// packet has no variable bindings.
+//
 
 static int				// O - 0 on success, -1 on error
 asn1_decode_snmp(
     unsigned char *buffer,		// I - Buffer
     size_t        len,			// I - Size of buffer
-    _pappl_snmp_t *packet)		// I - SNMP packet
+    _pappl_snmp_t *packet,		// I - SNMP packet
+    unsigned char **varbinds)		// O - Next variable binding or `NULL`
 {
   unsigned char	*bufptr,		// Pointer into the data
 		*bufend;		// End of data
   unsigned	length;			// Length of value
 
 
-  // Initialize the decoding...
-  memset(packet, 0, sizeof(_pappl_snmp_t));
-  packet->object_name[0] = -1;
+  // Initialize the decoding, resetting only the fixed fields rather than the
+  // (large) string and OID storage...
+  packet->error                         = NULL;
+  packet->version                       = 0;
+  packet->community[0]                  = '\0';
+  packet->request_type                  = _PAPPL_ASN1_END_OF_CONTENTS;
+  packet->request_id                    = 0;
+  packet->error_status                  = 0;
+  packet->error_index                   = 0;
+  packet->object_name[0]                = -1;
+  packet->object_type                   = _PAPPL_ASN1_END_OF_CONTENTS;
+  packet->object_value.string.num_bytes = 0;
+  packet->object_value.string.bytes[0]  = '\0';
+
+  if (varbinds)
+    *varbinds = NULL;
 
   bufptr = buffer;
   bufend = buffer + len;
@@ -417,7 +704,7 @@ asn1_decode_snmp(
   {
     snmp_set_error(packet, _("Version uses indefinite length"));
   }
-  else if ((packet->version = asn1_get_integer(&bufptr, bufend, length)) != _PAPPL_SNMP_VERSION_1)
+  else if ((packet->version = asn1_get_integer(&bufptr, bufend, length)) != _PAPPL_SNMP_VERSION_1 && packet->version != _PAPPL_SNMP_VERSION_2C)
   {
     snmp_set_error(packet, _("Bad SNMP version number"));
   }
@@ -433,13 +720,13 @@ asn1_decode_snmp(
   {
     asn1_get_string(&bufptr, bufend, length, packet->community, sizeof(packet->community));
 
-    if ((packet->request_type = (_pappl_asn1_t)asn1_get_type(&bufptr, bufend)) != _PAPPL_ASN1_GET_RESPONSE)
+    if ((packet->request_type = (_pappl_asn1_t)asn1_get_type(&bufptr, bufend)) != _PAPPL_ASN1_GET_RESPONSE && packet->request_type != _PAPPL_ASN1_GET_REQUEST && packet->request_type != _PAPPL_ASN1_GET_NEXT_REQUEST && packet->request_type != _PAPPL_ASN1_GET_BULK_REQUEST)
     {
-      snmp_set_error(packet, _("Packet does not contain a Get-Response-PDU"));
+      snmp_set_error(packet, _("Packet does not contain a supported PDU"));
     }
     else if (asn1_get_length(&bufptr, bufend) == 0)
     {
-      snmp_set_error(packet, _("Get-Response-PDU uses indefinite length"));
+      snmp_set_error(packet, _("PDU uses indefinite length"));
     }
     else if (asn1_get_type(&bufptr, bufend) != _PAPPL_ASN1_INTEGER)
     {
@@ -485,76 +772,13 @@ asn1_decode_snmp(
 	  {
 	    snmp_set_error(packet, _("variable-bindings uses indefinite length"));
 	  }
-	  else if (asn1_get_type(&bufptr, bufend) != _PAPPL_ASN1_SEQUENCE)
-	  {
-	    snmp_set_error(packet, _("No VarBind SEQUENCE"));
-	  }
-	  else if (asn1_get_length(&bufptr, bufend) == 0)
+	  else
 	  {
-	    snmp_set_error(packet, _("VarBind uses indefinite length"));
-	  }
-	  else if (asn1_get_type(&bufptr, bufend) != _PAPPL_ASN1_OID)
-	  {
-	    snmp_set_error(packet, _("No name OID"));
+	    asn1_decode_varbind(&bufptr, bufend, packet);
+
+	    if (varbinds)
+	      *varbinds = bufptr;
 	  }
-	  else if ((length = asn1_get_length(&bufptr, bufend)) == 0)
-	  {
-	    snmp_set_error(packet, _("Name OID uses indefinite length"));
-          }
-          else
-	  {
-	    asn1_get_oid(&bufptr, bufend, length, packet->object_name, _PAPPL_SNMP_MAX_OID);
-
-            packet->object_type = (_pappl_asn1_t)asn1_get_type(&bufptr, bufend);
-
-	    if ((length = asn1_get_length(&bufptr, bufend)) == 0 && packet->object_type != _PAPPL_ASN1_NULL_VALUE && packet->object_type != _PAPPL_ASN1_OCTET_STRING)
-	    {
-	      snmp_set_error(packet, _("Value uses indefinite length"));
-	    }
-	    else
-	    {
-	      switch (packet->object_type)
-	      {
-	        case _PAPPL_ASN1_BOOLEAN :
-		    packet->object_value.boolean = asn1_get_integer(&bufptr, bufend, length);
-	            break;
-
-	        case _PAPPL_ASN1_INTEGER :
-		    packet->object_value.integer = asn1_get_integer(&bufptr, bufend, length);
-	            break;
-
-		case _PAPPL_ASN1_NULL_VALUE :
-		    break;
-
-	        case _PAPPL_ASN1_OCTET_STRING :
-	        case _PAPPL_ASN1_BIT_STRING :
-	        case _PAPPL_ASN1_HEX_STRING :
-		    packet->object_value.string.num_bytes = length;
-		    asn1_get_string(&bufptr, bufend, length, (char *)packet->object_value.string.bytes, sizeof(packet->object_value.string.bytes));
-	            break;
-
-	        case _PAPPL_ASN1_OID :
-		    asn1_get_oid(&bufptr, bufend, length, packet->object_value.oid, _PAPPL_SNMP_MAX_OID);
-	            break;
-
-	        case _PAPPL_ASN1_COUNTER :
-		    packet->object_value.counter = asn1_get_integer(&bufptr, bufend, length);
-	            break;
-
-	        case _PAPPL_ASN1_GAUGE :
-		    packet->object_value.gauge = (unsigned)asn1_get_integer(&bufptr, bufend, length);
-	            break;
-
-	        case _PAPPL_ASN1_TIMETICKS :
-		    packet->object_value.timeticks = (unsigned)asn1_get_integer(&bufptr, bufend, length);
-	            break;
-
-                default :
-		    snmp_set_error(packet, _("Unsupported value type"));
-		    break;
-	      }
-	    }
-          }
 	}
       }
     }
@@ -564,6 +788,119 @@ asn1_decode_snmp(
 }
 
 
+//
+// 'asn1_decode_varbind()' - Decode a SNMP variable binding.
+//
+// On return "bufptr" points to the next variable binding, even if the value
+// could not be decoded.
+//
+
+static int				// O  - 0 on success, -1 on error
+asn1_decode_varbind(
+    unsigned char **bufptr,		// IO - Pointer into buffer
+    unsigned char *bufend,		// I  - End of buffer
+    _pappl_snmp_t *packet)		// I  - SNMP packet
+{
+  unsigned char	*varend;		// End of variable binding
+  unsigned	length;			// Length of value
+
+
+  // Initialize the decoding...
+  packet->error          = NULL;
+  packet->object_name[0] = -1;
+  packet->object_type    = _PAPPL_ASN1_NULL_VALUE;
+
+  if (asn1_get_type(bufptr, bufend) != _PAPPL_ASN1_SEQUENCE)
+  {
+    snmp_set_error(packet, _("No VarBind SEQUENCE"));
+    *bufptr = bufend;
+    return (-1);
+  }
+  else if ((length = asn1_get_length(bufptr, bufend)) == 0)
+  {
+    snmp_set_error(packet, _("VarBind uses indefinite length"));
+    *bufptr = bufend;
+    return (-1);
+  }
+
+  if (length > (unsigned)(bufend - *bufptr))
+    varend = bufend;
+  else
+    varend = *bufptr + length;
+
+  if (asn1_get_type(bufptr, varend) != _PAPPL_ASN1_OID)
+  {
+    snmp_set_error(packet, _("No name OID"));
+  }
+  else if ((length = asn1_get_length(bufptr, varend)) == 0)
+  {
+    snmp_set_error(packet, _("Name OID uses indefinite length"));
+  }
+  else
+  {
+    asn1_get_oid(bufptr, varend, length, packet->object_name, _PAPPL_SNMP_MAX_OID);
+
+    packet->object_type = (_pappl_asn1_t)asn1_get_type(bufptr, varend);
+
+    if ((length = asn1_get_length(bufptr, varend)) == 0 && packet->object_type != _PAPPL_ASN1_NULL_VALUE && packet->object_type != _PAPPL_ASN1_OCTET_STRING && packet->object_type != _PAPPL_ASN1_NO_SUCH_OBJECT && packet->object_type != _PAPPL_ASN1_NO_SUCH_INSTANCE && packet->object_type != _PAPPL_ASN1_END_OF_MIB_VIEW)
+    {
+      snmp_set_error(packet, _("Value uses indefinite length"));
+    }
+    else
+    {
+      switch (packet->object_type)
+      {
+	case _PAPPL_ASN1_BOOLEAN :
+	    packet->object_value.boolean = asn1_get_integer(bufptr, varend, length);
+	    break;
+
+	case _PAPPL_ASN1_INTEGER :
+	    packet->object_value.integer = asn1_get_integer(bufptr, varend, length);
+	    break;
+
+	case _PAPPL_ASN1_NULL_VALUE :
+	case _PAPPL_ASN1_NO_SUCH_OBJECT :
+	case _PAPPL_ASN1_NO_SUCH_INSTANCE :
+	case _PAPPL_ASN1_END_OF_MIB_VIEW :
+	    break;
+
+	case _PAPPL_ASN1_OCTET_STRING :
+	case _PAPPL_ASN1_BIT_STRING :
+	case _PAPPL_ASN1_HEX_STRING :
+	    packet->object_value.string.num_bytes = length;
+	    asn1_get_string(bufptr, varend, length, (char *)packet->object_value.string.bytes, sizeof(packet->object_value.string.bytes));
+	    break;
+
+	case _PAPPL_ASN1_OID :
+	    asn1_get_oid(bufptr, varend, length, packet->object_value.oid, _PAPPL_SNMP_MAX_OID);
+	    break;
+
+	case _PAPPL_ASN1_COUNTER :
+	    packet->object_value.counter = asn1_get_integer(bufptr, varend, length);
+	    break;
+
+	case _PAPPL_ASN1_GAUGE :
+	    packet->object_value.gauge = (unsigned)asn1_get_integer(bufptr, varend, length);
+	    break;
+
+	case _PAPPL_ASN1_TIMETICKS :
+	    packet->object_value.timeticks = (unsigned)asn1_get_integer(bufptr, varend, length);
+	    break;
+
+	default :
+	    snmp_set_error(packet, _("Unsupported value type"));
+	    break;
+      }
+    }
+  }
+
+  // Skip to the next variable binding...
+  *bufptr = varend;
+
+  return (packet->error ? -1 : 0);
+}
+
+
 //
 // 'asn1_encode_snmp()' - Encode a SNMP packet.
 //
@@ -648,14 +985,15 @@ asn1_encode_snmp(
   memcpy(bufptr, packet->community, commlen);
   bufptr += commlen;
 
-  *bufptr++ = (unsigned char)packet->request_type;	// Get-Request-PDU/Get-Next-Request-PDU
+  *bufptr++ = (unsigned char)packet->request_type;	// Get-Request-PDU/Get-Next-Request-PDU/GetBulkRequest-PDU
   asn1_set_length(&bufptr, reqlen);
 
   asn1_set_integer(&bufptr, (int)packet->request_id);
 
   asn1_set_integer(&bufptr, packet->error_status);
-
+					// error-status or non-repeaters
   asn1_set_integer(&bufptr, packet->error_index);
+					// error-index or max-repetitions
 
   *bufptr++ = _PAPPL_ASN1_SEQUENCE;	// variable-bindings
   asn1_set_length(&bufptr, listlen);
@@ -1149,3 +1487,129 @@ asn1_size_packed(int integer)		// I - Integer value
   else
     return (1);
 }
+
+
+//
+// 'snmp_poll()' - Wait for a SNMP packet.
+//
+// If "timeout" is negative, this function returns `true` immediately and the
+// following read waits for a packet indefinitely.
+//
+
+static bool				// O - `true` if a packet is available, `false` on timeout
+snmp_poll(int    fd,			// I - SNMP socket file descriptor
+          double timeout)		// I - Timeout in seconds
+{
+  int		ready;			// Data ready on socket?
+  struct pollfd	pfd;			// Polled file descriptor
+
+
+  if (timeout < 0.0)
+    return (true);
+
+  pfd.fd     = fd;
+  pfd.events = POLLIN;
+
+  while ((ready = poll(&pfd, 1, (int)(timeout * 1000.0))) < 0 &&
+         (errno == EINTR || errno == EAGAIN))
+    ;					// Wait for poll to complete...
+
+  return (ready > 0);
+}
+
+
+//
+// 'snmp_read_packet()' - Read a SNMP packet.
+//
+// If "timeout" is negative, this function waits for a packet indefinitely.
+//
+
+static ssize_t				// O - Number of bytes read or -1 on error
+snmp_read_packet(
+    int           fd,			// I - SNMP socket file descriptor
+    unsigned char *buffer,		// I - Packet buffer
+    size_t        bufsize,		// I - Size of packet buffer
+    http_addr_t   *address,		// O - Source address
+    double        timeout)		// I - Timeout in seconds
+{
+  socklen_t	addrlen;		// Source address length
+
+
+  // Optionally wait for a packet...
+  if (!snmp_poll(fd, timeout))
+    return (-1);
+
+  // Read the packet...
+  addrlen = sizeof(http_addr_t);
+
+  return (recvfrom(fd, buffer, bufsize, 0, (void *)address, &addrlen));
+}
+
+
+//
+// 'snmp_write_packet()' - Send a SNMP request packet.
+//
+// The "max_repetitions" value is only used for GetBulkRequest-PDUs.
+//
+
+static int				// O - 1 on success, 0 on error
+snmp_write_packet(
+    int           fd,			// I - SNMP socket
+    http_addr_t   *address,		// I - Address to send to
+    int           version,		// I - SNMP version
+    const char    *community,		// I - Community name
+    _pappl_asn1_t request_type,		// I - Request type
+    unsigned      request_id,		// I - Request ID
+    int           max_repetitions,	// I - Maximum number of values to return
+    const int     *oid)			// I - OID
+{
+  int		i;			// Looping var
+  _pappl_snmp_t	packet;			// SNMP message packet
+  unsigned char	buffer[_PAPPL_SNMP_MAX_PACKET];
+					// SNMP message buffer
+  ssize_t	bytes;			// Size of message
+  http_addr_t	temp;			// Copy of address
+
+
+  // Create the SNMP message...
+  memset(&packet, 0, sizeof(packet));
+
+  packet.version      = version;
+  packet.request_type = request_type;
+  packet.request_id   = request_id;
+  packet.object_type  = _PAPPL_ASN1_NULL_VALUE;
+
+  if (request_type == _PAPPL_ASN1_GET_BULK_REQUEST)
+  {
+    // GetBulkRequest-PDUs use the error-status and error-index fields for the
+    // non-repeaters and max-repetitions values...
+    packet.error_status = 0;
+    packet.error_index  = max_repetitions;
+  }
+
+  strlcpy(packet.community, community, sizeof(packet.community));
+
+  for (i = 0; oid[i] >= 0 && i < (_PAPPL_SNMP_MAX_OID - 1); i ++)
+    packet.object_name[i] = oid[i];
+  packet.object_name[i] = -1;
+
+  if (oid[i] >= 0)
+  {
+    errno = E2BIG;
+    return (0);
+  }
+
+  bytes = asn1_encode_snmp(buffer, sizeof(buffer), &packet);
+
+  if (bytes < 0)
+  {
+    errno = E2BIG;
+    return (0);
+  }
+
+  // Send the message...
+  temp               = *address;
+  temp.ipv4.sin_port = htons(_PAPPL_SNMP_PORT);
+
+  return (sendto(fd, buffer, (size_t)bytes, 0, (void *)&temp, (socklen_t)httpAddrLength(&temp)) == bytes);
+}
@@ -0,0 +1,639 @@
+//
+// Subscription IPP processing for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static void		copy_subscription(pappl_client_t *client, _pappl_subscription_t *sub, _pappl_raset_t *ra);
+static _pappl_subscription_t *find_subscription(pappl_client_t *client, bool owner);
+static const char	*get_username(pappl_client_t *client);
+static char		*make_printer_uri(pappl_client_t *client, char *buffer, size_t bufsize);
+
+
+//
+// '_papplSubscriptionIPPCancel()' - Cancel a subscription.
+//
+
+void
+_papplSubscriptionIPPCancel(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_subscription_t	*sub;		// Subscription
+
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  if ((sub = find_subscription(client, true)) != NULL)
+  {
+    _papplSubscriptionDeleteNoLock(system, sub);
+
+    // Wake up any Get-Notifications requests for this subscription...
+    pthread_cond_broadcast(&system->subscription_cond);
+
+    papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+}
+
+
+//
+// '_papplSubscriptionIPPCreate()' - Create printer or job subscriptions.
+//
+// Only "ippget" (pull) subscriptions are supported.  Each subscription template
+// group in the request gets a corresponding group in the response with either
+// the new "notify-subscription-id" or a "notify-status-code" value.
+//
+
+void
+_papplSubscriptionIPPCreate(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_printer_t	*printer = client->printer;
+					// Printer
+  ipp_attribute_t	*attr;		// Current attribute
+  const char		*name;		// Attribute name
+  bool			is_job = ippGetOperation(client->request) == IPP_OP_CREATE_JOB_SUBSCRIPTIONS;
+					// Create-Job-Subscriptions?
+  int			i,		// Looping var
+			num_subs = 0,	// Number of subscription templates
+			ok_subs = 0;	// Number of subscriptions created
+  const char		*username = get_username(client);
+					// Owner
+  _pappl_subscription_t	*sub;		// New subscription
+
+
+  // Subscription template groups follow the operation attributes...
+  for (attr = ippFirstAttribute(client->request); attr; attr = ippNextAttribute(client->request))
+  {
+    if (ippGetGroupTag(attr) == IPP_TAG_SUBSCRIPTION)
+      break;
+  }
+
+  if (!attr)
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_BAD_REQUEST, "No subscription attributes in request.");
+    return;
+  }
+
+  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+
+  for (; attr; attr = ippNextAttribute(client->request))
+  {
+    pappl_event_t	mask = PAPPL_EVENT_NONE;
+					// "notify-events" bits
+    pappl_job_t		*job = NULL;	// "notify-job-id" job
+    int			job_id = 0,	// "notify-job-id" value
+			lease = _PAPPL_LEASE_DEFAULT,
+					// "notify-lease-duration" value
+			user_data_len = 0;
+					// Length of "notify-user-data" value
+    const void		*user_data = NULL;
+					// "notify-user-data" value
+    const char		*language = NULL,
+					// "notify-natural-language" value
+			*pull_method = NULL;
+					// "notify-pull-method" value
+    ipp_status_t	status = IPP_STATUS_OK;
+					// "notify-status-code" value
+
+    if (ippGetGroupTag(attr) != IPP_TAG_SUBSCRIPTION)
+      continue;
+
+    // Collect the attributes in this subscription template group...
+    for (; attr && ippGetGroupTag(attr) == IPP_TAG_SUBSCRIPTION && (name = ippGetName(attr)) != NULL; attr = ippNextAttribute(client->request))
+    {
+      ipp_tag_t	value_tag = ippGetValueTag(attr);
+					// Value tag
+
+      if (!strcmp(name, "notify-recipient-uri"))
+      {
+        status = IPP_STATUS_ERROR_URI_SCHEME;
+      }
+      else if (!strcmp(name, "notify-pull-method"))
+      {
+        if (value_tag != IPP_TAG_KEYWORD || strcmp(pull_method = ippGetString(attr, 0, NULL), "ippget"))
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+      }
+      else if (!strcmp(name, "notify-events"))
+      {
+        if (value_tag != IPP_TAG_KEYWORD)
+        {
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+          continue;
+        }
+
+        // Unsupported events are ignored...
+        for (i = 0; i < ippGetCount(attr); i ++)
+          mask |= _papplEventValue(ippGetString(attr, i, NULL));
+      }
+      else if (!strcmp(name, "notify-lease-duration"))
+      {
+        if (is_job || value_tag != IPP_TAG_INTEGER || (lease = ippGetInteger(attr, 0)) < 0)
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+      }
+      else if (!strcmp(name, "notify-user-data"))
+      {
+        if (value_tag != IPP_TAG_STRING || (user_data = ippGetOctetString(attr, 0, &user_data_len)) == NULL || user_data_len > 63)
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+      }
+      else if (!strcmp(name, "notify-natural-language"))
+      {
+        if (value_tag == IPP_TAG_LANGUAGE)
+          language = ippGetString(attr, 0, NULL);
+        else
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+      }
+      else if (!strcmp(name, "notify-charset"))
+      {
+        const char *charset = ippGetString(attr, 0, NULL);
+					// "notify-charset" value
+
+        if (value_tag != IPP_TAG_CHARSET || !charset || (strcasecmp(charset, "us-ascii") && strcasecmp(charset, "utf-8")))
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+      }
+      else if (!strcmp(name, "notify-job-id"))
+      {
+        if (!is_job || value_tag != IPP_TAG_INTEGER)
+          status = IPP_STATUS_ERROR_ATTRIBUTES_OR_VALUES;
+        else if ((job = papplPrinterFindJob(printer, job_id = ippGetInteger(attr, 0))) == NULL)
+          status = IPP_STATUS_ERROR_NOT_FOUND;
+        else if (papplJobGetState(job) >= IPP_JSTATE_CANCELED)
+          status = IPP_STATUS_ERROR_NOT_POSSIBLE;
+      }
+    }
+
+    if (status == IPP_STATUS_OK && (!pull_method || (is_job && !job_id)))
+      status = IPP_STATUS_ERROR_BAD_REQUEST;
+
+    if (!mask)
+      mask = PAPPL_EVENT_JOB_COMPLETED;
+
+    // Add a subscription group to the response...
+    if (num_subs > 0)
+      ippAddSeparator(client->response);
+
+    num_subs ++;
+
+    if (status == IPP_STATUS_OK)
+    {
+      if ((sub = _papplSubscriptionCreate(client->system, printer, job, mask, username, language, user_data, user_data_len, lease)) != NULL)
+      {
+        papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Created subscription #%d for %s.", sub->subscription_id, username);
+
+        ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-subscription-id", sub->subscription_id);
+        if (!is_job)
+          ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", sub->lease);
+
+        ok_subs ++;
+      }
+      else
+        status = IPP_STATUS_ERROR_TOO_MANY_SUBSCRIPTIONS;
+    }
+
+    if (status != IPP_STATUS_OK)
+      ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_ENUM, "notify-status-code", (int)status);
+
+    if (!attr)
+      break;
+  }
+
+  if (ok_subs == 0)
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_IGNORED_ALL_SUBSCRIPTIONS, "No subscriptions created.");
+  else if (ok_subs < num_subs)
+    papplClientRespondIPP(client, IPP_STATUS_OK_IGNORED_SUBSCRIPTIONS, NULL);
+}
+
+
+//
+// '_papplSubscriptionIPPGetAttributes()' - Get subscription attributes.
+//
+
+void
+_papplSubscriptionIPPGetAttributes(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_subscription_t	*sub;		// Subscription
+  _pappl_raset_t	*ra;		// Requested attributes
+
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  if ((sub = find_subscription(client, false)) != NULL)
+  {
+    ra = _papplRASetCreate(client->request);
+
+    papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+    copy_subscription(client, sub, ra);
+
+    _papplRASetDelete(ra);
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+}
+
+
+//
+// '_papplSubscriptionIPPGetNotifications()' - Get event notifications.
+//
+// When "notify-wait" is true the request waits up to the "notify-get-interval"
+// for a new event instead of returning an empty response, so monitoring
+// clients do not need to poll.
+//
+
+void
+_papplSubscriptionIPPGetNotifications(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  ipp_attribute_t	*sub_ids,	// "notify-subscription-ids" attribute
+			*seq_nums;	// "notify-sequence-numbers" attribute
+  bool			notify_wait,	// Wait for events?
+			waiting;	// Waiting for events?
+  int			i,		// Looping var
+			count,		// Number of subscriptions
+			seq;		// Current sequence number
+  _pappl_subscription_t	*sub;		// Current subscription
+  _pappl_notify_t	*notify;	// Current event notification
+  bool			have_events = false;
+					// Are there events to send?
+  struct timespec	timeout;	// Timeout for waiting
+  char			printer_uri[1024];
+					// "notify-printer-uri" value
+  int			up_time;	// "printer-up-time" value
+
+
+  if ((sub_ids = ippFindAttribute(client->request, "notify-subscription-ids", IPP_TAG_INTEGER)) == NULL)
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_BAD_REQUEST, "Missing notify-subscription-ids attribute.");
+    return;
+  }
+
+  count       = ippGetCount(sub_ids);
+  seq_nums    = ippFindAttribute(client->request, "notify-sequence-numbers", IPP_TAG_INTEGER);
+  notify_wait = ippGetBoolean(ippFindAttribute(client->request, "notify-wait", IPP_TAG_BOOLEAN), 0);
+
+  if (seq_nums && ippGetCount(seq_nums) != count)
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_BAD_REQUEST, "The notify-subscription-ids and notify-sequence-numbers attributes have different lengths.");
+    return;
+  }
+
+  make_printer_uri(client, printer_uri, sizeof(printer_uri));
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  // Make sure the subscriptions exist and check for pending events...
+  for (i = 0; i < count; i ++)
+  {
+    if ((sub = _papplSubscriptionFindNoLock(system, ippGetInteger(sub_ids, i))) == NULL || sub->printer_id != client->printer->printer_id)
+    {
+      pthread_mutex_unlock(&system->subscription_mutex);
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_FOUND, "notify-subscription-id %d not found.", ippGetInteger(sub_ids, i));
+      return;
+    }
+
+    seq = seq_nums ? ippGetInteger(seq_nums, i) : 1;
+
+    if (sub->last_sequence >= seq && sub->last_sequence >= sub->first_sequence)
+      have_events = true;
+  }
+
+  // Wait for new events as needed, unless too many clients are already
+  // waiting...
+  waiting = notify_wait && !have_events && _papplClientLoopBeginWait(client);
+
+  timeout.tv_sec  = time(NULL) + _PAPPL_NOTIFY_INTERVAL;
+  timeout.tv_nsec = 0;
+
+  while (waiting && !have_events && !system->shutdown_time && time(NULL) < timeout.tv_sec)
+  {
+    if (pthread_cond_timedwait(&system->subscription_cond, &system->subscription_mutex, &timeout) == ETIMEDOUT)
+      break;
+
+    for (i = 0; i < count && !have_events; i ++)
+    {
+      if ((sub = _papplSubscriptionFindNoLock(system, ippGetInteger(sub_ids, i))) == NULL)
+        have_events = true;		// Subscription was canceled or expired
+      else if (sub->last_sequence >= (seq_nums ? ippGetInteger(seq_nums, i) : 1) && sub->last_sequence >= sub->first_sequence)
+        have_events = true;
+    }
+  }
+
+  if (waiting)
+    _papplClientLoopEndWait(client);
+
+  // Send the events...
+  up_time = (int)(time(NULL) - client->printer->start_time);
+
+  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+  ippAddInteger(client->response, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-get-interval", _PAPPL_NOTIFY_INTERVAL);
+  ippAddInteger(client->response, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "printer-up-time", up_time);
+
+  for (i = 0; i < count; i ++)
+  {
+    if ((sub = _papplSubscriptionFindNoLock(system, ippGetInteger(sub_ids, i))) == NULL)
+      continue;
+
+    if ((seq = seq_nums ? ippGetInteger(seq_nums, i) : 1) < sub->first_sequence)
+      seq = sub->first_sequence;
+
+    for (; seq <= sub->last_sequence; seq ++)
+    {
+      pappl_event_t	bit;		// Subscribed event bit
+
+      notify = sub->events[seq % _PAPPL_MAX_EVENTS];
+
+      ippAddSeparator(client->response);
+
+      ippAddString(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_CONST_TAG(IPP_TAG_CHARSET), "notify-charset", NULL, "utf-8");
+      ippAddString(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_LANGUAGE, "notify-natural-language", NULL, sub->language);
+      ippAddInteger(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER, "notify-subscription-id", sub->subscription_id);
+      ippAddInteger(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER, "notify-sequence-number", seq);
+      ippAddString(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_URI, "notify-printer-uri", NULL, printer_uri);
+
+      for (bit = PAPPL_EVENT_JOB_COMPLETED; bit <= PAPPL_EVENT_PRINTER_STOPPED; bit *= 2)
+      {
+        if (notify->event & sub->mask & bit)
+	{
+	  ippAddString(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-subscribed-event", NULL, _papplEventString(bit));
+	  break;
+	}
+      }
+
+      if (sub->user_data_len > 0)
+        ippAddOctetString(client->response, IPP_TAG_EVENT_NOTIFICATION, "notify-user-data", sub->user_data, sub->user_data_len);
+
+      ippAddInteger(client->response, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER, "printer-up-time", up_time);
+
+      _papplCopyAttributes(client->response, notify->attrs, NULL, IPP_TAG_EVENT_NOTIFICATION, 0);
+    }
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+}
+
+
+//
+// '_papplSubscriptionIPPList()' - List subscriptions.
+//
+
+void
+_papplSubscriptionIPPList(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_subscription_t	*sub;		// Current subscription
+  _pappl_raset_t	*ra;		// Requested attributes
+  int			job_id,		// "notify-job-id" value
+			limit,		// "limit" value
+			count = 0;	// Number of subscriptions returned
+  bool			my_subs;	// "my-subscriptions" value
+  const char		*username = get_username(client);
+					// Current user
+
+
+  job_id  = ippGetInteger(ippFindAttribute(client->request, "notify-job-id", IPP_TAG_INTEGER), 0);
+  limit   = ippGetInteger(ippFindAttribute(client->request, "limit", IPP_TAG_INTEGER), 0);
+  my_subs = ippGetBoolean(ippFindAttribute(client->request, "my-subscriptions", IPP_TAG_BOOLEAN), 0);
+  ra      = _papplRASetCreate(client->request);
+
+  papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  for (sub = (_pappl_subscription_t *)cupsArrayFirst(system->subscriptions); sub && (limit <= 0 || count < limit); sub = (_pappl_subscription_t *)cupsArrayNext(system->subscriptions))
+  {
+    if (sub->printer_id != client->printer->printer_id || sub->job_id != job_id || (my_subs && strcmp(username, sub->username)))
+      continue;
+
+    if (count > 0)
+      ippAddSeparator(client->response);
+
+    copy_subscription(client, sub, ra);
+    count ++;
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  _papplRASetDelete(ra);
+}
+
+
+//
+// '_papplSubscriptionIPPRenew()' - Renew a printer subscription.
+//
+
+void
+_papplSubscriptionIPPRenew(
+    pappl_client_t *client)		// I - Client
+{
+  pappl_system_t	*system = client->system;
+					// System
+  _pappl_subscription_t	*sub;		// Subscription
+  ipp_attribute_t	*attr;		// "notify-lease-duration" attribute
+  int			lease;		// "notify-lease-duration" value
+
+
+  if ((attr = ippFindAttribute(client->request, "notify-lease-duration", IPP_TAG_ZERO)) != NULL)
+  {
+    if (ippGetGroupTag(attr) != IPP_TAG_SUBSCRIPTION || ippGetValueTag(attr) != IPP_TAG_INTEGER || ippGetCount(attr) != 1 || (lease = ippGetInteger(attr, 0)) < 0)
+    {
+      papplClientRespondIPPUnsupported(client, attr);
+      return;
+    }
+  }
+  else
+    lease = _PAPPL_LEASE_DEFAULT;
+
+  if (lease == 0 || lease > _PAPPL_LEASE_MAX)
+    lease = _PAPPL_LEASE_MAX;
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  if ((sub = find_subscription(client, true)) != NULL)
+  {
+    if (sub->job_id)
+    {
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_POSSIBLE, "Job subscriptions cannot be renewed.");
+    }
+    else
+    {
+      sub->lease  = lease;
+      sub->expire = time(NULL) + lease;
+
+      papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
+      ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", lease);
+    }
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+}
+
+
+//
+// 'copy_subscription()' - Copy subscription attributes to the response.
+//
+// The subscription mutex must be held.
+//
+
+static void
+copy_subscription(
+    pappl_client_t        *client,	// I - Client
+    _pappl_subscription_t *sub,		// I - Subscription
+    _pappl_raset_t        *ra)		// I - Requested attributes
+{
+  pappl_event_t	bit;			// Current event bit
+  int		num_values = 0;		// Number of "notify-events" values
+  const char	*svalues[32];		// "notify-events" values
+
+
+  if (_papplRASetContains(ra, "notify-events"))
+  {
+    for (bit = PAPPL_EVENT_JOB_COMPLETED; bit <= PAPPL_EVENT_PRINTER_STOPPED; bit *= 2)
+    {
+      if (sub->mask & bit)
+        svalues[num_values ++] = _papplEventString(bit);
+    }
+
+    ippAddStrings(client->response, IPP_TAG_SUBSCRIPTION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-events", num_values, NULL, svalues);
+  }
+
+  if (sub->job_id && _papplRASetContains(ra, "notify-job-id"))
+    ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-job-id", sub->job_id);
+
+  if (!sub->job_id && _papplRASetContains(ra, "notify-lease-duration"))
+    ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", sub->lease);
+
+  if (!sub->job_id && _papplRASetContains(ra, "notify-lease-expiration-time"))
+    ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-expiration-time", (int)(sub->expire - client->printer->start_time));
+
+  if (_papplRASetContains(ra, "notify-natural-language"))
+    ippAddString(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_LANGUAGE, "notify-natural-language", NULL, sub->language);
+
+  if (_papplRASetContains(ra, "notify-printer-up-time"))
+    ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-printer-up-time", (int)(time(NULL) - client->printer->start_time));
+
+  if (_papplRASetContains(ra, "notify-printer-uri"))
+  {
+    char	uri[1024];		// "notify-printer-uri" value
+
+    ippAddString(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_URI, "notify-printer-uri", NULL, make_printer_uri(client, uri, sizeof(uri)));
+  }
+
+  if (_papplRASetContains(ra, "notify-pull-method"))
+    ippAddString(client->response, IPP_TAG_SUBSCRIPTION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "notify-pull-method", NULL, "ippget");
+
+  if (_papplRASetContains(ra, "notify-subscriber-user-name"))
+    ippAddString(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_NAME, "notify-subscriber-user-name", NULL, sub->username);
+
+  if (_papplRASetContains(ra, "notify-subscription-id"))
+    ippAddInteger(client->response, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-subscription-id", sub->subscription_id);
+
+  if (sub->user_data_len > 0 && _papplRASetContains(ra, "notify-user-data"))
+    ippAddOctetString(client->response, IPP_TAG_SUBSCRIPTION, "notify-user-data", sub->user_data, sub->user_data_len);
+}
+
+
+//
+// 'find_subscription()' - Find the subscription for a request.
+//
+// The subscription mutex must be held.  If the subscription cannot be found
+// or, when "owner" is `true`, the client is neither the owner nor an
+// administrator, an error response is set and `NULL` is returned.
+//
+
+static _pappl_subscription_t *		// O - Subscription or `NULL`
+find_subscription(
+    pappl_client_t *client,		// I - Client
+    bool           owner)		// I - Require the owner or an administrator?
+{
+  ipp_attribute_t	*attr;		// "notify-subscription-id" attribute
+  _pappl_subscription_t	*sub;		// Subscription
+  http_status_t		auth_status;	// Authorization status
+
+
+  if ((attr = ippFindAttribute(client->request, "notify-subscription-id", IPP_TAG_ZERO)) == NULL)
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_BAD_REQUEST, "Missing notify-subscription-id attribute.");
+    return (NULL);
+  }
+  else if (ippGetGroupTag(attr) != IPP_TAG_OPERATION || ippGetValueTag(attr) != IPP_TAG_INTEGER || ippGetCount(attr) != 1)
+  {
+    papplClientRespondIPPUnsupported(client, attr);
+    return (NULL);
+  }
+
+  if ((sub = _papplSubscriptionFindNoLock(client->system, ippGetInteger(attr, 0))) == NULL || sub->printer_id != client->printer->printer_id)
+  {
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_FOUND, "notify-subscription-id %d not found.", ippGetInteger(attr, 0));
+    return (NULL);
+  }
+
+  if (owner && strcmp(get_username(client), sub->username) && (auth_status = papplClientIsAuthorized(client)) != HTTP_STATUS_CONTINUE)
+  {
+    papplClientRespond(client, auth_status, NULL, NULL, 0, 0);
+    return (NULL);
+  }
+
+  return (sub);
+}
+
+
+//
+// 'get_username()' - Get the requesting user name.
+//
+
+static const char *			// O - Username
+get_username(pappl_client_t *client)	// I - Client
+{
+  ipp_attribute_t	*attr;		// "requesting-user-name" attribute
+
+
+  if (client->username[0])
+    return (client->username);
+  else if ((attr = ippFindAttribute(client->request, "requesting-user-name", IPP_TAG_NAME)) != NULL)
+    return (ippGetString(attr, 0, NULL));
+  else
+    return ("guest");
+}
+
+
+//
+// 'make_printer_uri()' - Make the "notify-printer-uri" value for a client.
+//
+
+static char *				// O - URI
+make_printer_uri(
+    pappl_client_t *client,		// I - Client
+    char           *buffer,		// I - URI buffer
+    size_t         bufsize)		// I - Size of URI buffer
+{
+  const char	*scheme = (httpAddrLocalhost(httpGetAddress(client->http)) || (client->system->options & PAPPL_SOPTIONS_NO_TLS)) ? "ipp" : "ipps";
+					// URI scheme
+
+
+  httpAssembleURI(HTTP_URI_CODING_ALL, buffer, (int)bufsize, scheme, NULL, client->host_field, client->host_port, client->printer->resource);
+
+  return (buffer);
+}
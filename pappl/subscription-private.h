@@ -0,0 +1,84 @@
+//
+// Private subscription header file for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef _PAPPL_SUBSCRIPTION_PRIVATE_H_
+#  define _PAPPL_SUBSCRIPTION_PRIVATE_H_
+
+//
+// Include necessary headers...
+//
+
+#  include "base-private.h"
+#  include "system.h"
+
+
+//
+// Constants...
+//
+
+#  define _PAPPL_MAX_EVENTS	100	// Maximum events kept for each subscription
+#  define _PAPPL_MAX_SUBSCRIPTIONS 100	// Maximum number of subscriptions
+#  define _PAPPL_NOTIFY_INTERVAL 30	// "notify-get-interval" value and maximum seconds for "notify-wait"
+#  define _PAPPL_LEASE_DEFAULT	3600	// Default "notify-lease-duration" value
+#  define _PAPPL_LEASE_MAX	86400	// Maximum "notify-lease-duration" value
+
+
+//
+// Types and structures...
+//
+
+typedef struct _pappl_notify_s		// Event notification
+{
+  int			refcount;		// Number of subscriptions holding the event
+  pappl_event_t		event;			// Event bits
+  ipp_t			*attrs;			// "event-notification" attributes
+} _pappl_notify_t;
+
+typedef struct _pappl_subscription_s	// Subscription
+{
+  int			subscription_id;	// "notify-subscription-id" value
+  pappl_event_t		mask;			// "notify-events" bits
+  int			printer_id,		// "printer-id" for printer subscriptions
+			job_id;			// "notify-job-id" for job subscriptions
+  char			*username,		// "notify-subscriber-user-name" value
+			*language;		// "notify-natural-language" value
+  unsigned char		user_data[63];		// "notify-user-data" value
+  int			user_data_len;		// Length of "notify-user-data" value
+  int			lease;			// "notify-lease-duration" value
+  time_t		expire;			// Expiration time or `0` for none
+  int			first_sequence,		// Sequence number of oldest event
+			last_sequence;		// Sequence number of newest event
+  _pappl_notify_t	*events[_PAPPL_MAX_EVENTS];
+						// Ring buffer of events
+} _pappl_subscription_t;
+
+
+//
+// Functions...
+//
+
+extern void		_papplSystemAddEventNoLock(pappl_system_t *system, pappl_printer_t *printer, pappl_job_t *job, pappl_event_t event, const char *message, ...) _PAPPL_FORMAT(5,6) _PAPPL_PRIVATE;
+extern time_t		_papplSystemCleanSubscriptions(pappl_system_t *system, bool clean_all) _PAPPL_PRIVATE;
+
+extern const char	*_papplEventString(pappl_event_t value) _PAPPL_PRIVATE;
+extern pappl_event_t	_papplEventValue(const char *value) _PAPPL_PRIVATE;
+
+extern _pappl_subscription_t *_papplSubscriptionCreate(pappl_system_t *system, pappl_printer_t *printer, pappl_job_t *job, pappl_event_t mask, const char *username, const char *language, const void *user_data, int user_data_len, int lease) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionDeleteNoLock(pappl_system_t *system, _pappl_subscription_t *sub) _PAPPL_PRIVATE;
+extern _pappl_subscription_t *_papplSubscriptionFindNoLock(pappl_system_t *system, int subscription_id) _PAPPL_PRIVATE;
+
+extern void		_papplSubscriptionIPPCancel(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionIPPCreate(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionIPPGetAttributes(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionIPPGetNotifications(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionIPPList(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSubscriptionIPPRenew(pappl_client_t *client) _PAPPL_PRIVATE;
+
+
+#endif // !_PAPPL_SUBSCRIPTION_PRIVATE_H_
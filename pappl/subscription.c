@@ -0,0 +1,528 @@
+//
+// Subscription functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local globals...
+//
+
+static const char * const pappl_events[] =
+{
+  "job-completed",
+  "job-created",
+  "job-progress",
+  "job-state-changed",
+  "printer-config-changed",
+  "printer-state-changed",
+  "printer-stopped"
+};
+
+
+//
+// Local functions...
+//
+
+static void	add_eventv(pappl_system_t *system, pappl_printer_t *printer, pappl_job_t *job, pappl_event_t event, const char *message, va_list ap);
+static int	compare_subscriptions(_pappl_subscription_t *a, _pappl_subscription_t *b);
+static _pappl_notify_t *create_notify(pappl_printer_t *printer, pappl_job_t *job, pappl_event_t event, const char *message, va_list ap);
+static void	release_notify(_pappl_notify_t *notify);
+
+
+//
+// '_papplEventString()' - Return the keyword value associated with the IPP "notify-events" bit value.
+//
+
+const char *				// O - IPP "notify-events" keyword value
+_papplEventString(
+    pappl_event_t value)		// I - IPP "notify-events" bit value
+{
+  return (_PAPPL_LOOKUP_STRING(value, pappl_events));
+}
+
+
+//
+// '_papplEventValue()' - Return the bit value associated with the IPP "notify-events" keyword value.
+//
+
+pappl_event_t				// O - IPP "notify-events" bit value
+_papplEventValue(
+    const char *value)			// I - IPP "notify-events" keyword value
+{
+  return ((pappl_event_t)_PAPPL_LOOKUP_VALUE(value, pappl_events));
+}
+
+
+//
+// '_papplSubscriptionCreate()' - Create a subscription.
+//
+// This function creates a printer subscription or, when "job" is not `NULL`, a
+// job subscription that ends shortly after the job completes.  The "lease"
+// argument is the number of seconds before a printer subscription expires and
+// is ignored for job subscriptions.
+//
+// `NULL` is returned if the system already has the maximum number of
+// subscriptions.
+//
+
+_pappl_subscription_t *			// O - Subscription or `NULL` on error
+_papplSubscriptionCreate(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job,		// I - Job or `NULL` for a printer subscription
+    pappl_event_t   mask,		// I - "notify-events" bits
+    const char      *username,		// I - Owner
+    const char      *language,		// I - Language for "notify-text"
+    const void      *user_data,		// I - "notify-user-data" value or `NULL`
+    int             user_data_len,	// I - Length of "notify-user-data" value
+    int             lease)		// I - Lease duration in seconds
+{
+  _pappl_subscription_t	*sub;		// New subscription
+
+
+  if (!system || !printer || !mask || !username || user_data_len < 0 || user_data_len > (int)sizeof(sub->user_data))
+    return (NULL);
+
+  if ((sub = (_pappl_subscription_t *)calloc(1, sizeof(_pappl_subscription_t))) == NULL)
+    return (NULL);
+
+  sub->mask           = mask;
+  sub->printer_id     = printer->printer_id;
+  sub->job_id         = job ? job->job_id : 0;
+  sub->username       = strdup(username);
+  sub->language       = strdup(language ? language : "en");
+  sub->first_sequence = 1;
+
+  if (user_data && user_data_len > 0)
+  {
+    memcpy(sub->user_data, user_data, (size_t)user_data_len);
+    sub->user_data_len = user_data_len;
+  }
+
+  if (!job)
+  {
+    if (lease <= 0 || lease > _PAPPL_LEASE_MAX)
+      lease = _PAPPL_LEASE_MAX;
+
+    sub->lease  = lease;
+    sub->expire = time(NULL) + lease;
+  }
+
+  if (!sub->username || !sub->language)
+    goto error;
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  if (!system->subscriptions)
+    system->subscriptions = cupsArrayNew((cups_array_func_t)compare_subscriptions, NULL);
+
+  if (!system->subscriptions || cupsArrayCount(system->subscriptions) >= _PAPPL_MAX_SUBSCRIPTIONS)
+  {
+    pthread_mutex_unlock(&system->subscription_mutex);
+    goto error;
+  }
+
+  sub->subscription_id = ++ system->last_subscription_id;
+
+  cupsArrayAdd(system->subscriptions, sub);
+
+  if (job)
+  {
+    ipp_jstate_t	state;		// "job-state" value
+    pappl_jreason_t	state_reasons;	// "job-state-reasons" values
+    int			impcompleted;	// "job-impressions-completed" value
+
+    // The job may have completed after the caller checked it, and events are
+    // only added for the subscriptions in the array, so check again now that
+    // the subscription is there.  The status is read without locking the
+    // job...
+    _papplJobGetStatus(job, &state, &state_reasons, &impcompleted);
+
+    if (state >= IPP_JSTATE_CANCELED)
+      sub->expire = time(NULL) + _PAPPL_NOTIFY_INTERVAL;
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  if (sub->expire)
+    _papplSystemWakeup(system);
+
+  return (sub);
+
+  // If we get here something went wrong...
+  error:
+
+  free(sub->username);
+  free(sub->language);
+  free(sub);
+
+  return (NULL);
+}
+
+
+//
+// '_papplSubscriptionDeleteNoLock()' - Delete a subscription.
+//
+// The subscription mutex must be held.
+//
+
+void
+_papplSubscriptionDeleteNoLock(
+    pappl_system_t        *system,	// I - System
+    _pappl_subscription_t *sub)		// I - Subscription
+{
+  int	seq;				// Current sequence number
+
+
+  cupsArrayRemove(system->subscriptions, sub);
+
+  for (seq = sub->first_sequence; seq <= sub->last_sequence; seq ++)
+    release_notify(sub->events[seq % _PAPPL_MAX_EVENTS]);
+
+  free(sub->username);
+  free(sub->language);
+  free(sub);
+}
+
+
+//
+// '_papplSubscriptionFindNoLock()' - Find a subscription by ID.
+//
+// The subscription mutex must be held.
+//
+
+_pappl_subscription_t *			// O - Subscription or `NULL` if not found
+_papplSubscriptionFindNoLock(
+    pappl_system_t *system,		// I - System
+    int            subscription_id)	// I - "notify-subscription-id" value
+{
+  _pappl_subscription_t	key;		// Search key
+
+
+  if (!system->subscriptions)
+    return (NULL);
+
+  key.subscription_id = subscription_id;
+
+  return ((_pappl_subscription_t *)cupsArrayFind(system->subscriptions, &key));
+}
+
+
+//
+// 'papplSystemAddEvent()' - Add an event notification.
+//
+// This function adds an event notification for the specified printer and/or
+// job.  Any subscriptions for the event receive a copy of the printer and job
+// status at the time of the event along with the "message" text, which is
+// returned to clients as the "notify-text" attribute.
+//
+// Printer drivers normally only need to call this function to report events
+// PAPPL does not know about, for example a 'printer-config-changed' event
+// after the ready media has been changed at the printer.  Events are discarded
+// immediately when there are no subscriptions.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemAddEvent(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer,		// I - Printer or `NULL` for none
+    pappl_job_t     *job,		// I - Job or `NULL` for none
+    pappl_event_t   event,		// I - Event bits
+    const char      *message,		// I - printf-style "notify-text" message
+    ...)				// I - Additional arguments as needed
+{
+  va_list	ap;			// Pointer to additional arguments
+
+
+  if (!system || !event || !cupsArrayCount(system->subscriptions))
+    return;
+
+  // Lock the job before the printer, like job processing does...
+  if (job)
+    pthread_rwlock_rdlock(&job->rwlock);
+  if (printer)
+    pthread_rwlock_rdlock(&printer->rwlock);
+
+  va_start(ap, message);
+  add_eventv(system, printer, job, event, message, ap);
+  va_end(ap);
+
+  if (printer)
+    pthread_rwlock_unlock(&printer->rwlock);
+  if (job)
+    pthread_rwlock_unlock(&job->rwlock);
+}
+
+
+//
+// '_papplSystemAddEventNoLock()' - Add an event notification.
+//
+// This function is used when the caller already holds the printer and/or job
+// lock.
+//
+
+void
+_papplSystemAddEventNoLock(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer,		// I - Printer or `NULL` for none
+    pappl_job_t     *job,		// I - Job or `NULL` for none
+    pappl_event_t   event,		// I - Event bits
+    const char      *message,		// I - printf-style "notify-text" message
+    ...)				// I - Additional arguments as needed
+{
+  va_list	ap;			// Pointer to additional arguments
+
+
+  if (!cupsArrayCount(system->subscriptions))
+    return;
+
+  va_start(ap, message);
+  add_eventv(system, printer, job, event, message, ap);
+  va_end(ap);
+}
+
+
+//
+// '_papplSystemCleanSubscriptions()' - Remove expired subscriptions.
+//
+// The expiration time of the next subscription to expire is returned so the
+// system's housekeeping loop can sleep until then.
+//
+
+time_t					// O - Next expiration time or `0` for none
+_papplSystemCleanSubscriptions(
+    pappl_system_t *system,		// I - System
+    bool           clean_all)		// I - Remove all subscriptions?
+{
+  _pappl_subscription_t	*sub;		// Current subscription
+  time_t		curtime = time(NULL),
+					// Current time
+			next = 0;	// Next expiration time
+
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  for (sub = (_pappl_subscription_t *)cupsArrayFirst(system->subscriptions); sub; sub = (_pappl_subscription_t *)cupsArrayNext(system->subscriptions))
+  {
+    if (clean_all || (sub->expire && curtime >= sub->expire))
+      _papplSubscriptionDeleteNoLock(system, sub);
+    else if (sub->expire && (!next || sub->expire < next))
+      next = sub->expire;
+  }
+
+  if (clean_all)
+  {
+    cupsArrayDelete(system->subscriptions);
+    system->subscriptions = NULL;
+  }
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  return (next);
+}
+
+
+//
+// 'add_eventv()' - Add an event notification to each matching subscription.
+//
+// The notification is only created when at least one subscription wants the
+// event, and is shared by all of them.
+//
+
+static void
+add_eventv(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer,		// I - Printer or `NULL` for none
+    pappl_job_t     *job,		// I - Job or `NULL` for none
+    pappl_event_t   event,		// I - Event bits
+    const char      *message,		// I - printf-style "notify-text" message
+    va_list         ap)			// I - Pointer to additional arguments
+{
+  _pappl_subscription_t	*sub;		// Current subscription
+  _pappl_notify_t	*notify = NULL;	// Event notification
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  pthread_mutex_lock(&system->subscription_mutex);
+
+  for (sub = (_pappl_subscription_t *)cupsArrayFirst(system->subscriptions); sub; sub = (_pappl_subscription_t *)cupsArrayNext(system->subscriptions))
+  {
+    // Skip expired subscriptions, even for events they asked for, until the
+    // system removes them...
+    if (sub->expire && sub->expire <= curtime)
+      continue;
+
+    if (!(sub->mask & event))
+      continue;
+
+    if (sub->printer_id && (!printer || printer->printer_id != sub->printer_id))
+      continue;
+
+    if (sub->job_id && (!job || job->job_id != sub->job_id))
+      continue;
+
+    if (!notify && (notify = create_notify(printer, job, event, message, ap)) == NULL)
+      break;
+
+    // Add the event to the ring buffer, dropping the oldest event as needed...
+    if ((sub->last_sequence - sub->first_sequence + 1) >= _PAPPL_MAX_EVENTS)
+    {
+      release_notify(sub->events[sub->first_sequence % _PAPPL_MAX_EVENTS]);
+      sub->first_sequence ++;
+    }
+
+    sub->last_sequence ++;
+    sub->events[sub->last_sequence % _PAPPL_MAX_EVENTS] = notify;
+    notify->refcount ++;
+
+    // Job subscriptions end once the client has had a chance to get the
+    // 'job-completed' event...
+    if (sub->job_id && (event & PAPPL_EVENT_JOB_COMPLETED))
+      sub->expire = curtime + _PAPPL_NOTIFY_INTERVAL;
+  }
+
+  if (notify)
+    pthread_cond_broadcast(&system->subscription_cond);
+
+  pthread_mutex_unlock(&system->subscription_mutex);
+}
+
+
+//
+// 'compare_subscriptions()' - Compare two subscriptions.
+//
+
+static int				// O - Result of comparison
+compare_subscriptions(
+    _pappl_subscription_t *a,		// I - First subscription
+    _pappl_subscription_t *b)		// I - Second subscription
+{
+  return (a->subscription_id - b->subscription_id);
+}
+
+
+//
+// 'create_notify()' - Create an event notification.
+//
+
+static _pappl_notify_t *		// O - Event notification
+create_notify(
+    pappl_printer_t *printer,		// I - Printer or `NULL` for none
+    pappl_job_t     *job,		// I - Job or `NULL` for none
+    pappl_event_t   event,		// I - Event bits
+    const char      *message,		// I - printf-style "notify-text" message
+    va_list         ap)			// I - Pointer to additional arguments
+{
+  _pappl_notify_t	*notify;	// Event notification
+  char			text[1024];	// "notify-text" value
+  int			num_values;	// Number of keyword values
+  const char		*svalues[32];	// Keyword values
+
+
+  if ((notify = (_pappl_notify_t *)calloc(1, sizeof(_pappl_notify_t))) == NULL)
+    return (NULL);
+
+  if ((notify->attrs = ippNew()) == NULL)
+  {
+    free(notify);
+    return (NULL);
+  }
+
+  notify->event = event;
+
+  if (message)
+  {
+    vsnprintf(text, sizeof(text), message, ap);
+  }
+  else
+  {
+    pappl_event_t	bit;		// Current event bit
+
+    // Default to the keyword for the first event...
+    for (bit = PAPPL_EVENT_JOB_COMPLETED; bit <= PAPPL_EVENT_PRINTER_STOPPED && !(event & bit); bit *= 2);
+
+    strlcpy(text, bit <= PAPPL_EVENT_PRINTER_STOPPED ? _papplEventString(bit) : "event", sizeof(text));
+  }
+
+  ippAddString(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_TEXT, "notify-text", NULL, text);
+
+  if (printer)
+  {
+    pappl_preason_t	bit;		// Current reason bit
+
+    ippAddString(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME, "printer-name", NULL, printer->name);
+    ippAddInteger(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM, "printer-state", (int)printer->state);
+
+    for (num_values = 0, bit = PAPPL_PREASON_OTHER; bit <= PAPPL_PREASON_TONER_LOW; bit *= 2)
+    {
+      if (printer->state_reasons & bit)
+        svalues[num_values ++] = _papplPrinterReasonString(bit);
+    }
+
+    if (printer->state == IPP_PSTATE_STOPPED)
+      svalues[num_values ++] = "paused";
+    else if (num_values == 0)
+      svalues[num_values ++] = "none";
+
+    ippAddStrings(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "printer-state-reasons", num_values, NULL, svalues);
+    ippAddBoolean(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, "printer-is-accepting-jobs", !printer->system->shutdown_time);
+  }
+
+  if (job)
+  {
+    ipp_jstate_t	state;		// "job-state" value
+    pappl_jreason_t	state_reasons,	// "job-state-reasons" values
+			bit;		// Current reason bit
+    int			impcompleted;	// "job-impressions-completed" value
+
+    _papplJobGetStatus(job, &state, &state_reasons, &impcompleted);
+
+    ippAddInteger(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER, "notify-job-id", job->job_id);
+    ippAddString(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_NAME, "job-name", NULL, job->name);
+    ippAddInteger(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_ENUM, "job-state", (int)state);
+
+    for (num_values = 0, bit = PAPPL_JREASON_ABORTED_BY_SYSTEM; bit <= PAPPL_JREASON_WARNINGS_DETECTED; bit *= 2)
+    {
+      if (state_reasons & bit)
+        svalues[num_values ++] = _papplJobReasonString(bit);
+    }
+
+    if (num_values == 0)
+      svalues[num_values ++] = "none";
+
+    ippAddStrings(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "job-state-reasons", num_values, NULL, svalues);
+    ippAddInteger(notify->attrs, IPP_TAG_EVENT_NOTIFICATION, IPP_TAG_INTEGER, "job-impressions-completed", impcompleted);
+  }
+
+  return (notify);
+}
+
+
+//
+// 'release_notify()' - Release a reference to an event notification.
+//
+
+static void
+release_notify(
+    _pappl_notify_t *notify)		// I - Event notification
+{
+  if (notify && -- notify->refcount <= 0)
+  {
+    ippDelete(notify->attrs);
+    free(notify);
+  }
+}
@@ -12,6 +12,7 @@
 //
 
 #include "system-private.h"
+#include "printer-private.h"
 #ifdef HAVE_LIBJPEG
 #  include <jpeglib.h>
 #  ifndef JPEG_LIB_VERSION_MAJOR	// Added in JPEGLIB 9
@@ -24,6 +25,15 @@
 #endif // HAVE_LIBPNG
 
 
+//
+// Local constants...
+//
+
+#if defined(__linux) && defined(SO_REUSEPORT)
+#  define _PAPPL_SHARED_LISTENERS 1	// Kernel balances connections between sockets sharing a port
+#endif // __linux && SO_REUSEPORT
+
+
 //
 // Local functions...
 //
@@ -31,6 +41,9 @@
 static bool		add_listeners(pappl_system_t *system, const char *name, int port, int family);
 static int		compare_filters(_pappl_mime_filter_t *a, _pappl_mime_filter_t *b);
 static _pappl_mime_filter_t *copy_filter(_pappl_mime_filter_t *f);
+#ifdef _PAPPL_SHARED_LISTENERS
+static int		listen_shared(http_addr_t *addr, int port);
+#endif // _PAPPL_SHARED_LISTENERS
 
 
 //
@@ -194,19 +207,23 @@ papplSystemAddMIMEFilter(
   if (!system || system->is_running || !srctype || !dsttype || !cb)
     return;
 
-  if (!system->filters)
-    system->filters = cupsArrayNew3((cups_array_func_t)compare_filters, NULL, NULL, 0, (cups_acopy_func_t)copy_filter, (cups_afree_func_t)free);
-
   key.src    = srctype;
   key.dst    = dsttype;
   key.cb     = cb;
   key.cbdata = data;
 
+  pthread_rwlock_wrlock(&system->filter_rwlock);
+
+  if (!system->filters)
+    system->filters = cupsArrayNew3((cups_array_func_t)compare_filters, NULL, NULL, 0, (cups_acopy_func_t)copy_filter, (cups_afree_func_t)free);
+
   if (!cupsArrayFind(system->filters, &key))
   {
     papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Adding '%s' to '%s' filter.", srctype, dsttype);
     cupsArrayAdd(system->filters, &key);
   }
+
+  pthread_rwlock_unlock(&system->filter_rwlock);
 }
 
 
@@ -219,7 +236,7 @@ _papplSystemExportVersions(
     pappl_system_t *system,		// I - System
     ipp_t          *ipp,		// I - IPP message
     ipp_tag_t      group_tag,		// I - Group (`IPP_TAG_PRINTER` or `IPP_TAG_SYSTEM`)
-    cups_array_t   *ra)			// I - Requested attributes or `NULL` for all
+    _pappl_raset_t *ra)			// I - Requested attributes or `NULL` for all
 {
   int		i;			// Looping var
   ipp_attribute_t *attr;		// Attribute
@@ -235,7 +252,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-name"
   snprintf(name, sizeof(name), "%s-firmware-name", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRASetContains(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].name;
@@ -257,7 +274,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-patches"
   snprintf(name, sizeof(name), "%s-firmware-patches", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRASetContains(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].patches;
@@ -279,7 +296,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-string-version"
   snprintf(name, sizeof(name), "%s-firmware-string-version", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRASetContains(ra, name))
   {
     for (i = 0; i < system->num_versions; i ++)
       values[i] = system->versions[i].sversion;
@@ -303,7 +320,7 @@ _papplSystemExportVersions(
 
   // "xxx-firmware-version"
   snprintf(name, sizeof(name), "%s-firmware-version", name_prefix);
-  if (!ra || cupsArrayFind(ra, name))
+  if (_papplRASetContains(ra, name))
   {
     for (i = 0, attr = NULL; i < system->num_versions; i ++)
     {
@@ -358,19 +375,36 @@ _papplSystemFindMIMEFilter(
   if (!system || !srctype || !dsttype)
     return (NULL);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  pthread_rwlock_rdlock(&system->filter_rwlock);
 
   key.src = srctype;
   key.dst = dsttype;
 
   match = (_pappl_mime_filter_t *)cupsArrayFind(system->filters, &key);
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->filter_rwlock);
 
   return (match);
 }
 
 
+//
+// 'papplSystemGetAcceptThreads()' - Get the number of acceptor threads.
+//
+// This function returns the number of threads used to accept new client
+// connections, as set by the @link papplSystemSetAcceptThreads@ function.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Number of acceptor threads
+papplSystemGetAcceptThreads(
+    pappl_system_t *system)		// I - System
+{
+  return (system ? system->accept_threads : 0);
+}
+
+
 //
 // 'papplSystemGetAdminGroup()' - Get the current administrative group, if any.
 //
@@ -408,6 +442,35 @@ papplSystemGetAdminGroup(
 }
 
 
+//
+// 'papplSystemGetAuthCacheTime()' - Get the lifetime of cached credentials.
+//
+// This function returns the number of seconds that successful PAM
+// authentications and the user's group memberships are cached.
+//
+// The default is `60` seconds.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Lifetime in seconds or `0` for no caching
+papplSystemGetAuthCacheTime(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->auth_mutex);
+    ret = system->auth_cache_time;
+    pthread_mutex_unlock(&system->auth_mutex);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetAuthService()' - Get the PAM authorization service, if any.
 //
@@ -680,6 +743,126 @@ papplSystemGetLogLevel(
   return (system ? system->loglevel : PAPPL_LOGLEVEL_UNSPEC);
 }
 
+//
+// 'papplSystemGetMaxClients()' - Get the maximum number of client connections.
+//
+// This function gets the maximum number of simultaneous client connections.
+// When the limit is reached, new connections are rejected with a "503 Service
+// Unavailable" response until an existing connection is closed.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum number of client connections or `0` for no limit
+papplSystemGetMaxClients(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_clients;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxHostClients()' - Get the maximum number of connections per client host.
+//
+// This function gets the maximum number of simultaneous connections from a
+// single client host (address).  Connections over the limit are rejected with
+// a "503 Service Unavailable" response.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum number of connections per host or `0` for no limit
+papplSystemGetMaxHostClients(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_host_clients;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxImageMemory()' - Get the maximum memory used for each image.
+//
+// This function returns the maximum number of bytes used to hold the image
+// data of a JPEG or PNG job that is rotated or printed with multiple copies.
+// Larger images are spooled to a scratch file and read back in bands.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+size_t					// O - Maximum image memory in bytes or `0` for no limit
+papplSystemGetMaxImageMemory(
+    pappl_system_t *system)		// I - System
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_image_memory;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxImageThreads()' - Get the maximum number of threads used to
+//                                     render each image.
+//
+// This function returns the maximum number of threads used to scale and dither
+// a JPEG or PNG image, as set by @link papplSystemSetMaxImageThreads@.
+//
+// The default is `1`, which renders images on the job's thread.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum number of threads
+papplSystemGetMaxImageThreads(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_image_threads;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetMaxLogSize()' - Get the maximum log file size.
 //
@@ -699,6 +882,65 @@ papplSystemGetMaxLogSize(
 }
 
 
+//
+// 'papplSystemGetMaxRequestRate()' - Get the maximum request rate per client host.
+//
+// This function gets the maximum number of HTTP requests per second that are
+// processed for a single client host (address).  Requests over the limit are
+// rejected with a "503 Service Unavailable" response and the connection is
+// closed.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum requests per second or `0` for no limit
+papplSystemGetMaxRequestRate(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_request_rate;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMaxSpoolMemory()' - Get the maximum size of documents spooled
+//                                    in memory.
+//
+// This function returns the largest document that is kept in memory instead of
+// being written to a file in the spool directory.
+//
+// @since PAPPL 1.1@
+//
+
+size_t					// O - Maximum document size in bytes or `0` to always use files
+papplSystemGetMaxSpoolMemory(
+    pappl_system_t *system)		// I - System
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    pthread_rwlock_rdlock(&system->rwlock);
+    ret = system->max_spool_memory;
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetName()' - Get the system name.
 //
@@ -885,6 +1127,35 @@ papplSystemGetPort(
 }
 
 
+//
+// 'papplSystemGetSaveDelay()' - Get the delay before saving the system state.
+//
+// This function returns the number of seconds that configuration changes
+// must settle before the save callback is called.
+//
+// The default is `1` second.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Delay in seconds or `0` to save immediately
+papplSystemGetSaveDelay(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->config_mutex);
+    ret = system->save_delay;
+    pthread_mutex_unlock(&system->config_mutex);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetServerHeader()' - Get the Server: header for HTTP responses.
 //
@@ -959,6 +1230,23 @@ papplSystemGetTLSOnly(
 }
 
 
+//
+// 'papplSystemGetTracing()' - Get whether job tracing is enabled.
+//
+// This function returns whether the system is recording the time spent in each
+// phase of job processing.
+//
+// @since PAPPL 1.1@
+//
+
+bool					// O - `true` if tracing is enabled, `false` otherwise
+papplSystemGetTracing(
+    pappl_system_t *system)		// I - System
+{
+  return (system ? system->tracing : false);
+}
+
+
 //
 // 'papplSystemGetUUID()' - Get the "system-uuid" value.
 //
@@ -1104,20 +1392,40 @@ papplSystemIteratePrinters(
 {
   int			i,		// Looping var
 			count;		// Number of printers
+  pappl_printer_t	**printers;	// Printers to iterate
 
 
   if (!system || !cb)
     return;
 
-  // Loop through the printers.
+  // Retain the printers under the printers lock and then run the callback
+  // without it, so that callbacks can create or delete printers.
   //
   // Note: Cannot use cupsArrayFirst/Last since other threads might be
   // enumerating the printers array.
 
-  pthread_rwlock_rdlock(&system->rwlock);
-  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
-    (cb)((pappl_printer_t *)cupsArrayIndex(system->printers, i), data);
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_rdlock(&system->printers_rwlock);
+
+  if ((count = cupsArrayCount(system->printers)) > 0 && (printers = (pappl_printer_t **)calloc((size_t)count, sizeof(pappl_printer_t *))) != NULL)
+  {
+    for (i = 0; i < count; i ++)
+      printers[i] = _papplPrinterRetain((pappl_printer_t *)cupsArrayIndex(system->printers, i));
+  }
+  else
+  {
+    printers = NULL;
+    count    = 0;
+  }
+
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
+  for (i = 0; i < count; i ++)
+  {
+    (cb)(printers[i], data);
+    _papplPrinterRelease(printers[i]);
+  }
+
+  free(printers);
 }
 
 
@@ -1202,6 +1510,46 @@ papplSystemMatchDriver(
 }
 
 
+//
+// 'papplSystemSetAcceptThreads()' - Set the number of acceptor threads.
+//
+// This function sets the number of threads used to accept new client
+// connections.  Each thread waits on its own share of the listener sockets,
+// while housekeeping such as saving the configuration and cleaning out old
+// jobs runs separately from @link papplSystemRun@.  On Linux, each thread is
+// also given its own socket for every network address so that the kernel
+// spreads bursts of new connections between them - this requires a fixed port
+// number passed to @link papplSystemCreate@.
+//
+// The number of threads must be set before calling
+// @link papplSystemAddListeners@.  The default is `1`.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetAcceptThreads(
+    pappl_system_t *system,		// I - System
+    int            num_threads)		// I - Number of acceptor threads
+{
+  if (!system)
+    return;
+
+  if (system->is_running || system->num_listeners > 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Tried to set the number of acceptor threads after adding listeners.");
+    return;
+  }
+
+  if (num_threads < 1)
+    num_threads = 1;
+  else if (num_threads > _PAPPL_MAX_ACCEPT_THREADS)
+    num_threads = _PAPPL_MAX_ACCEPT_THREADS;
+
+  system->accept_threads = num_threads;
+}
+
+
 //
 // 'papplSystemSetAdminGroup()' - Set the administrative group.
 //
@@ -1240,6 +1588,7 @@ papplSystemSetAdminGroup(
 #endif // !_WIN32
       system->admin_gid = (gid_t)-1;
 
+    _papplSystemClearAuthCache(system);
     _papplSystemConfigChanged(system);
 
     pthread_rwlock_unlock(&system->rwlock);
@@ -1247,6 +1596,35 @@ papplSystemSetAdminGroup(
 }
 
 
+//
+// 'papplSystemSetAuthCacheTime()' - Set the lifetime of cached credentials.
+//
+// This function sets the number of seconds that successful PAM
+// authentications and the user's group memberships are cached.  Only a salted
+// hash of each password is kept in memory.  Set the lifetime to `0` to
+// authenticate every request.  Any cached credentials are discarded.
+//
+// The default is `60` seconds.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetAuthCacheTime(
+    pappl_system_t *system,		// I - System
+    int            seconds)		// I - Lifetime in seconds or `0` for no caching
+{
+  if (system)
+  {
+    _papplSystemClearAuthCache(system);
+
+    pthread_mutex_lock(&system->auth_mutex);
+    system->auth_cache_time = seconds > 0 ? seconds : 0;
+    pthread_mutex_unlock(&system->auth_mutex);
+  }
+}
+
+
 //
 // 'papplSystemSetContact()' - Set the "system-contact" value.
 //
@@ -1552,6 +1930,128 @@ papplSystemSetLogLevel(
   }
 }
 
+//
+// 'papplSystemSetMaxClients()' - Set the maximum number of client connections.
+//
+// This function sets the maximum number of simultaneous client connections.
+// When the limit is reached, new connections are rejected with a "503 Service
+// Unavailable" response until an existing connection is closed.  Set the
+// maximum to `0` to disable the limit.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxClients(
+    pappl_system_t *system,		// I - System
+    int            max_clients)		// I - Maximum number of client connections or `0` for no limit
+{
+  if (system)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_clients = max_clients > 0 ? max_clients : 0;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxHostClients()' - Set the maximum number of connections per client host.
+//
+// This function sets the maximum number of simultaneous connections from a
+// single client host (address), so that one misbehaving client cannot use all
+// of the connections allowed by @link papplSystemSetMaxClients@.  Connections
+// over the limit are rejected with a "503 Service Unavailable" response.  Set
+// the maximum to `0` to disable the limit.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxHostClients(
+    pappl_system_t *system,		// I - System
+    int            max_clients)		// I - Maximum number of connections per host or `0` for no limit
+{
+  if (system)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_host_clients = max_clients > 0 ? max_clients : 0;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxImageMemory()' - Set the maximum memory used for each image.
+//
+// This function sets the maximum number of bytes used to hold the image data
+// of a JPEG or PNG job that is rotated or printed with multiple copies.  Images
+// that are larger than this are spooled to a scratch file in the spool
+// directory and read back in bands, which bounds the memory used by each job
+// at the cost of extra disk I/O.  Set the maximum to `0` to disable the limit.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxImageMemory(
+    pappl_system_t *system,		// I - System
+    size_t         max_memory)		// I - Maximum image memory in bytes or `0` for no limit
+{
+  if (system)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_image_memory = max_memory;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxImageThreads()' - Set the maximum number of threads used to
+//                                     render each image.
+//
+// This function sets the maximum number of threads used to scale and dither a
+// JPEG or PNG image that is held in memory.  When more than one thread is
+// allowed, the page is split into horizontal bands that are rendered in
+// parallel and then passed to the driver's raster callbacks in order from the
+// job's thread, so drivers still see a single sequential writer.  Images that
+// are streamed or spooled to a scratch file are always rendered on the job's
+// thread.
+//
+// The default is `1`, which renders images on the job's thread.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxImageThreads(
+    pappl_system_t *system,		// I - System
+    int            max_threads)		// I - Maximum number of threads
+{
+  if (system && max_threads > 0)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_image_threads = max_threads;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
 //
 // 'papplSystemSetMaxLogSize()' - Set the maximum log file size in bytes.
 //
@@ -1581,6 +2081,72 @@ papplSystemSetMaxLogSize(
 }
 
 
+//
+// 'papplSystemSetMaxRequestRate()' - Set the maximum request rate per client host.
+//
+// This function sets the maximum number of HTTP requests per second that are
+// processed for a single client host (address).  Each host may send a burst of
+// up to one second's worth of requests at a time.  Requests over the limit are
+// rejected with a "503 Service Unavailable" response, before any IPP request
+// data is read, and the connection is closed.  Set the maximum to `0` to
+// disable the limit.
+//
+// The default is `0` for no limit.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxRequestRate(
+    pappl_system_t *system,		// I - System
+    int            max_rate)		// I - Maximum requests per second or `0` for no limit
+{
+  if (system)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_request_rate = max_rate > 0 ? max_rate : 0;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
+//
+// 'papplSystemSetMaxSpoolMemory()' - Set the maximum size of documents spooled
+//                                    in memory.
+//
+// This function sets the largest document that is kept in memory instead of
+// being written to a file in the spool directory, which saves the file system
+// writes for small jobs such as labels.  A document that grows past the limit
+// while it is received is moved to a spool file, as are documents received
+// while the pending jobs already use 16 times the limit.  Memory spooling is
+// only available on Linux.  Set the maximum to `0` to always spool to files.
+//
+// Documents kept in memory are not preserved when the printer application is
+// restarted.
+//
+// The default is `0` to always spool to files.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxSpoolMemory(
+    pappl_system_t *system,		// I - System
+    size_t         max_memory)		// I - Maximum document size in bytes or `0` to always use files
+{
+  if (system)
+  {
+    pthread_rwlock_wrlock(&system->rwlock);
+
+    system->max_spool_memory = max_memory;
+
+    pthread_rwlock_unlock(&system->rwlock);
+  }
+}
+
+
 //
 // 'papplSystemSetMIMECallback()' - Set the MIME typing callback for the system.
 //
@@ -1631,13 +2197,13 @@ papplSystemSetNextPrinterID(
 {
   if (system && !system->is_running)
   {
-    pthread_rwlock_wrlock(&system->rwlock);
+    pthread_rwlock_wrlock(&system->printers_rwlock);
 
     system->next_printer_id = next_printer_id;
 
     _papplSystemConfigChanged(system);
 
-    pthread_rwlock_unlock(&system->rwlock);
+    pthread_rwlock_unlock(&system->printers_rwlock);
   }
 }
 
@@ -1831,6 +2397,73 @@ papplSystemSetSaveCallback(
 }
 
 
+//
+// 'papplSystemSetSaveDelay()' - Set the delay before saving the system state.
+//
+// This function sets the number of seconds that configuration changes must
+// settle before the save callback is called, so that a burst of changes is
+// saved once.  During a steady stream of changes the state is still saved
+// every 10 times the delay.  The save callback is called from a background
+// thread.
+//
+// The default is `1` second.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetSaveDelay(
+    pappl_system_t *system,		// I - System
+    int            seconds)		// I - Delay in seconds or `0` to save immediately
+{
+  if (system)
+  {
+    pthread_mutex_lock(&system->config_mutex);
+    system->save_delay = seconds > 0 ? seconds : 0;
+    pthread_mutex_unlock(&system->config_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetTracing()' - Enable or disable job tracing.
+//
+// This function enables or disables recording of the time spent spooling,
+// queuing, opening the device, filtering, and in the driver callbacks for
+// each job.  When a traced job finishes, a summary of its timings is logged.
+// The most recent spans are available in the Chrome trace event format from
+// the "/trace.json" page when the `PAPPL_SOPTIONS_WEB_METRICS` option is
+// used.
+//
+// Tracing is disabled by default and is not available when PAPPL is compiled
+// with `PAPPL_NO_TRACE` defined.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetTracing(
+    pappl_system_t *system,		// I - System
+    bool           enable)		// I - `true` to enable tracing, `false` to disable
+{
+  if (system)
+  {
+#ifdef PAPPL_NO_TRACE
+    (void)enable;
+#else
+    pthread_mutex_lock(&system->trace_mutex);
+
+    if (enable && !system->traces)
+      system->traces = calloc(_PAPPL_MAX_TRACES, sizeof(_pappl_trace_t));
+
+    system->tracing = enable && system->traces != NULL;
+
+    pthread_mutex_unlock(&system->trace_mutex);
+#endif // PAPPL_NO_TRACE
+  }
+}
+
+
 //
 // 'papplSystemSetUUID()' - Set the system UUID.
 //
@@ -1910,7 +2543,9 @@ papplSystemSetVersions(
 // and "status_cb" functions are used to support getting and setting the IPP
 // "printer-wifi-state", "printer-wifi-ssid", and "printer-wifi-password"
 // attributes, while the "list_cb" function enables changing the Wi-Fi network
-// from the network web interface, if enabled.
+// from the network web interface, if enabled.  The "list_cb" function is
+// called from a background thread and its results are cached - see
+// @link papplSystemSetMaxWiFiScanAge@.
 //
 // Note: The Wi-Fi callbacks can only be set prior to calling
 // @link papplSystemRun@.
@@ -1952,11 +2587,20 @@ add_listeners(
   http_addrlist_t	*addrlist,	// Listen addresses
 			*addr;		// Current address
   char			service[255];	// Service port
+  int			num_shards = 1;	// Number of sockets for each address
 
 
   if (name && (!strcmp(name, "*") || !*name))
     name = NULL;
 
+#ifdef _PAPPL_SHARED_LISTENERS
+  // Give each acceptor thread its own socket for the address so that the
+  // kernel spreads new connections between them.  This is only done for a
+  // fixed port since a shared bind cannot detect a port that is in use...
+  if (system->accept_threads > 1 && system->port && family != AF_LOCAL)
+    num_shards = system->accept_threads;
+#endif // _PAPPL_SHARED_LISTENERS
+
   snprintf(service, sizeof(service), "%d", port);
   if ((addrlist = httpAddrGetList(name, family, service)) == NULL)
   {
@@ -1969,7 +2613,14 @@ add_listeners(
   {
     for (addr = addrlist; addr && system->num_listeners < _PAPPL_MAX_LISTENERS; addr = addr->next)
     {
-      if ((sock = httpAddrListen(&(addrlist->addr), port)) < 0)
+#ifdef _PAPPL_SHARED_LISTENERS
+      if (num_shards > 1)
+        sock = listen_shared(&addr->addr, port);
+      else
+#endif // _PAPPL_SHARED_LISTENERS
+      sock = httpAddrListen(&(addrlist->addr), port);
+
+      if (sock < 0)
       {
 	char	temp[256];		// String address
 
@@ -1978,16 +2629,36 @@ add_listeners(
 	  if (name && *name == '/')
 	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create listener socket for '%s': %s", name, cupsLastErrorString());
 	  else
-	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create listener socket for '%s:%d': %s", httpAddrString(&addr->addr, temp, (int)sizeof(temp)), system->port, cupsLastErrorString());
+	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create listener socket for '%s:%d': %s", httpAddrString(&addr->addr, temp, (int)sizeof(temp)), system->port, num_shards > 1 ? strerror(errno) : cupsLastErrorString());
 	}
       }
       else
       {
         ret = true;
 
+        // Spread listeners that cannot be shared between the acceptor threads
+        // in turn...
+	system->listener_shards[system->num_listeners] = num_shards > 1 ? 0 : system->num_listeners % system->accept_threads;
 	system->listeners[system->num_listeners].fd        = sock;
 	system->listeners[system->num_listeners ++].events = POLLIN;
 
+#ifdef _PAPPL_SHARED_LISTENERS
+	int	shard;			// Current acceptor thread
+
+	for (shard = 1; shard < num_shards && system->num_listeners < _PAPPL_MAX_LISTENERS; shard ++)
+	{
+	  if ((sock = listen_shared(&addr->addr, port)) < 0)
+	  {
+	    papplLog(system, PAPPL_LOGLEVEL_WARN, "Unable to create shared listener socket for '%s:%d': %s", name ? name : "*", port, strerror(errno));
+	    break;
+	  }
+
+	  system->listener_shards[system->num_listeners] = shard;
+	  system->listeners[system->num_listeners].fd        = sock;
+	  system->listeners[system->num_listeners ++].events = POLLIN;
+	}
+#endif // _PAPPL_SHARED_LISTENERS
+
 	if (name && *name == '/')
 	  papplLog(system, PAPPL_LOGLEVEL_INFO, "Listening for connections on '%s'.", name);
 	else
@@ -2035,3 +2706,54 @@ copy_filter(_pappl_mime_filter_t *f)	// I - Filter definition
 
   return (newf);
 }
+
+
+#ifdef _PAPPL_SHARED_LISTENERS
+//
+// 'listen_shared()' - Create a listener socket that shares its port.
+//
+
+static int				// O - Listener socket or `-1` on error
+listen_shared(http_addr_t *addr,	// I - Address
+              int         port)		// I - Port number
+{
+  int		sock,			// Listener socket
+		val = 1;		// Socket option value
+  http_addr_t	temp = *addr;		// Address with port
+
+
+  if ((sock = socket(temp.addr.sa_family, SOCK_STREAM, 0)) < 0)
+    return (-1);
+
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &val, sizeof(val));
+
+  if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &val, sizeof(val)))
+    goto error;
+
+  if (temp.addr.sa_family == AF_INET6)
+  {
+    setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &val, sizeof(val));
+    temp.ipv6.sin6_port = htons((unsigned short)port);
+  }
+  else
+  {
+    temp.ipv4.sin_port = htons((unsigned short)port);
+  }
+
+  if (bind(sock, (struct sockaddr *)&temp, (socklen_t)httpAddrLength(&temp)) || listen(sock, 128))
+    goto error;
+
+  fcntl(sock, F_SETFD, FD_CLOEXEC);
+
+  return (sock);
+
+  // If we get here, something went wrong...
+  error:
+
+  val = errno;
+  close(sock);
+  errno = val;
+
+  return (-1);
+}
+#endif // _PAPPL_SHARED_LISTENERS
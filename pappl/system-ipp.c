@@ -104,8 +104,17 @@ ipp_create_printer(
 		*driver_name;		// Name of driver
   ipp_attribute_t *attr;		// Current attribute
   pappl_printer_t *printer;		// Printer
-  cups_array_t	*ra;			// Requested attributes
+  _pappl_raset_t *ra;			// Requested attributes
   http_status_t	auth_status;		// Authorization status
+  static const char * const printer_attrs[] =
+  {					// Attributes for the new printer
+    "printer-id",
+    "printer-is-accepting-jobs",
+    "printer-state",
+    "printer-state-reasons",
+    "printer-uuid",
+    "printer-xri-supported"
+  };
 
 
   // Verify the connection is authorized...
@@ -230,16 +239,9 @@ ipp_create_printer(
   // Return the printer
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
-  cupsArrayAdd(ra, "printer-id");
-  cupsArrayAdd(ra, "printer-is-accepting-jobs");
-  cupsArrayAdd(ra, "printer-state");
-  cupsArrayAdd(ra, "printer-state-reasons");
-  cupsArrayAdd(ra, "printer-uuid");
-  cupsArrayAdd(ra, "printer-xri-supported");
-
+  ra = _papplRASetCreateNames((int)(sizeof(printer_attrs) / sizeof(printer_attrs[0])), printer_attrs);
   _papplPrinterCopyAttributes(client, printer, ra, NULL);
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -267,7 +269,7 @@ ipp_delete_printer(
     return;
   }
 
-  if (!client->printer->processing_job)
+  if (client->printer->num_processing_jobs == 0)
     papplPrinterDelete(client->printer);
   else
     client->printer->is_deleted = true;
@@ -286,7 +288,7 @@ ipp_get_printers(
 {
   pappl_system_t	*system = client->system;
 					// System
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_raset_t	*ra;		// Requested attributes
   int			i,		// Looping var
 			count,		// Number of printers
 			limit;		// Maximum number to return
@@ -296,12 +298,12 @@ ipp_get_printers(
 
   // Get request attributes...
   limit  = ippGetInteger(ippFindAttribute(client->request, "limit", IPP_TAG_INTEGER), 0);
-  ra     = ippCreateRequestedArray(client->request);
+  ra     = _papplRASetCreate(client->request);
   format = ippGetString(ippFindAttribute(client->request, "document-format", IPP_TAG_MIMETYPE), 0, NULL);
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
-  pthread_rwlock_rdlock(&system->rwlock);
+  pthread_rwlock_rdlock(&system->printers_rwlock);
 
   // Enumerate the printers for the client...
   count = cupsArrayCount(system->printers);
@@ -324,9 +326,9 @@ ipp_get_printers(
     pthread_rwlock_unlock(&printer->rwlock);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -340,7 +342,7 @@ ipp_get_system_attributes(
 {
   pappl_system_t	*system = client->system;
 					// System
-  cups_array_t		*ra;		// Requested attributes array
+  _pappl_raset_t	*ra;		// Requested attributes
   int			i,		// Looping var
 			count;		// Count of values
   pappl_printer_t	*printer;	// Current printer
@@ -351,15 +353,44 @@ ipp_get_system_attributes(
   time_t		state_time = 0;	// system-state-change-[date-]time value
 
 
-  ra = ippCreateRequestedArray(client->request);
+  ra = _papplRASetCreate(client->request);
 
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 
+  pthread_rwlock_rdlock(&system->printers_rwlock);
   pthread_rwlock_rdlock(&system->rwlock);
 
   _papplCopyAttributes(client->response, system->attrs, ra, IPP_TAG_ZERO, IPP_TAG_CUPS_CONST);
 
-  if (!ra || cupsArrayFind(ra, "system-config-change-date-time") || cupsArrayFind(ra, "system-config-change-time"))
+  if (_papplRASetContains(ra, "pappl-job-threads") || _papplRASetContains(ra, "pappl-job-threads-busy") || _papplRASetContains(ra, "pappl-job-threads-max") || _papplRASetContains(ra, "pappl-jobs-waiting"))
+  {
+    // Report job worker thread utilization...
+    int	num_threads,			// Number of job threads
+	busy_threads,			// Number of busy job threads
+	max_threads,			// Maximum number of job threads
+	waiting;			// Number of jobs waiting for a thread
+
+    pthread_mutex_lock(&system->job_mutex);
+    num_threads  = system->num_job_threads;
+    busy_threads = system->busy_job_threads;
+    max_threads  = system->max_job_threads;
+    waiting      = cupsArrayCount(system->job_queue);
+    pthread_mutex_unlock(&system->job_mutex);
+
+    if (_papplRASetContains(ra, "pappl-job-threads"))
+      ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "pappl-job-threads", num_threads);
+
+    if (_papplRASetContains(ra, "pappl-job-threads-busy"))
+      ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "pappl-job-threads-busy", busy_threads);
+
+    if (_papplRASetContains(ra, "pappl-job-threads-max"))
+      ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "pappl-job-threads-max", max_threads);
+
+    if (_papplRASetContains(ra, "pappl-jobs-waiting"))
+      ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "pappl-jobs-waiting", waiting);
+  }
+
+  if (_papplRASetContains(ra, "system-config-change-date-time") || _papplRASetContains(ra, "system-config-change-time"))
   {
     for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
     {
@@ -369,17 +400,21 @@ ipp_get_system_attributes(
         config_time = printer->config_time;
     }
 
-    if (!ra || cupsArrayFind(ra, "system-config-change-date-time"))
+    if (_papplRASetContains(ra, "system-config-change-date-time"))
       ippAddDate(client->response, IPP_TAG_SYSTEM, "system-config-change-date-time", ippTimeToDate(config_time));
 
-    if (!ra || cupsArrayFind(ra, "system-config-change-time"))
+    if (_papplRASetContains(ra, "system-config-change-time"))
       ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-config-change-time", (int)(config_time - system->start_time));
   }
 
-  if (!ra || cupsArrayFind(ra, "system-configured-printers"))
+  if (_papplRASetContains(ra, "system-configured-printers"))
   {
     attr = ippAddCollections(client->response, IPP_TAG_SYSTEM, "system-configured-printers", cupsArrayCount(system->printers), NULL);
 
+    // Printer locks come before the configuration lock, so release it while
+    // the printers are copied...
+    pthread_rwlock_unlock(&system->rwlock);
+
     for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
     {
       printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
@@ -393,6 +428,7 @@ ipp_get_system_attributes(
       ippAddBoolean(col, IPP_TAG_SYSTEM, "printer-is-accepting-jobs", 1);
       ippAddString(col, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "printer-name", NULL, printer->name);
       ippAddString(col, IPP_TAG_SYSTEM, IPP_TAG_KEYWORD, "printer-service-type", NULL, "print");
+      ippAddInteger(col, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "queued-job-count", printer->active_jobs.count);
       _papplPrinterCopyState(client, col, printer, NULL);
       _papplPrinterCopyXRI(client, col, printer);
 
@@ -401,24 +437,26 @@ ipp_get_system_attributes(
       ippSetCollection(client->response, &attr, i, col);
       ippDelete(col);
     }
+
+    pthread_rwlock_rdlock(&system->rwlock);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-contact-col"))
+  if (_papplRASetContains(ra, "system-contact-col"))
   {
     col = _papplContactExport(&system->contact);
     ippAddCollection(client->response, IPP_TAG_SYSTEM, "system-contact-col", col);
     ippDelete(col);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-current-time"))
+  if (_papplRASetContains(ra, "system-current-time"))
     ippAddDate(client->response, IPP_TAG_SYSTEM, "system-current-time", ippTimeToDate(time(NULL)));
 
-  if (!ra || cupsArrayFind(ra, "system-default-printer-id"))
+  if (_papplRASetContains(ra, "system-default-printer-id"))
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-default-printer-id", system->default_printer_id);
 
   _papplSystemExportVersions(system, client->response, IPP_TAG_SYSTEM, ra);
 
-  if (!ra || cupsArrayFind(ra, "system-geo-location"))
+  if (_papplRASetContains(ra, "system-geo-location"))
   {
     if (system->geo_location)
       ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_URI, "system-geo-location", NULL, system->geo_location);
@@ -426,19 +464,19 @@ ipp_get_system_attributes(
       ippAddOutOfBand(client->response, IPP_TAG_SYSTEM, IPP_TAG_UNKNOWN, "system-geo-location");
   }
 
-  if (!ra || cupsArrayFind(ra, "system-location"))
+  if (_papplRASetContains(ra, "system-location"))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-location", NULL, system->location ? system->location : "");
 
-  if (!ra || cupsArrayFind(ra, "system-name"))
+  if (_papplRASetContains(ra, "system-name"))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_NAME, "system-name", NULL, system->name);
 
-  if (!ra || cupsArrayFind(ra, "system-organization"))
+  if (_papplRASetContains(ra, "system-organization"))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-organization", NULL, system->organization ? system->organization : "");
 
-  if (!ra || cupsArrayFind(ra, "system-organizational-unit"))
+  if (_papplRASetContains(ra, "system-organizational-unit"))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_TEXT, "system-organizational-unit", NULL, system->org_unit ? system->org_unit : "");
 
-  if (!ra || cupsArrayFind(ra, "system-state"))
+  if (_papplRASetContains(ra, "system-state"))
   {
     int	state = IPP_PSTATE_IDLE;	// System state
 
@@ -456,7 +494,7 @@ ipp_get_system_attributes(
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_ENUM, "system-state", state);
   }
 
-  if (!ra || cupsArrayFind(ra, "system-state-change-date-time") || cupsArrayFind(ra, "system-state-change-time"))
+  if (_papplRASetContains(ra, "system-state-change-date-time") || _papplRASetContains(ra, "system-state-change-time"))
   {
     for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
     {
@@ -466,14 +504,14 @@ ipp_get_system_attributes(
         state_time = printer->state_time;
     }
 
-    if (!ra || cupsArrayFind(ra, "system-state-change-date-time"))
+    if (_papplRASetContains(ra, "system-state-change-date-time"))
       ippAddDate(client->response, IPP_TAG_SYSTEM, "system-state-change-date-time", ippTimeToDate(state_time));
 
-    if (!ra || cupsArrayFind(ra, "system-state-change-time"))
+    if (_papplRASetContains(ra, "system-state-change-time"))
       ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-state-change-time", (int)(state_time - system->start_time));
   }
 
-  if (!ra || cupsArrayFind(ra, "system-state-reasons"))
+  if (_papplRASetContains(ra, "system-state-reasons"))
   {
     pappl_preason_t	state_reasons = PAPPL_PREASON_NONE;
 
@@ -505,13 +543,13 @@ ipp_get_system_attributes(
     }
   }
 
-  if (!ra || cupsArrayFind(ra, "system-up-time"))
+  if (_papplRASetContains(ra, "system-up-time"))
     ippAddInteger(client->response, IPP_TAG_SYSTEM, IPP_TAG_INTEGER, "system-up-time", (int)(time(NULL) - system->start_time));
 
-  if (system->uuid && (!ra || cupsArrayFind(ra, "system-uuid")))
+  if (system->uuid && (_papplRASetContains(ra, "system-uuid")))
     ippAddString(client->response, IPP_TAG_SYSTEM, IPP_TAG_URI, "system-uuid", NULL, system->uuid);
 
-  if (!ra || cupsArrayFind(ra, "system-xri-supported"))
+  if (_papplRASetContains(ra, "system-xri-supported"))
   {
     char	uri[1024];		// URI value
 
@@ -526,8 +564,9 @@ ipp_get_system_attributes(
   }
 
   pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
-  cupsArrayDelete(ra);
+  _papplRASetDelete(ra);
 }
 
 
@@ -651,6 +690,8 @@ ipp_set_system_attributes(
 
   pthread_rwlock_unlock(&system->rwlock);
 
+  _papplSystemWakeup(system);
+
   papplClientRespondIPP(client, IPP_STATUS_OK, NULL);
 }
 
@@ -12,20 +12,129 @@
 //
 
 #include "pappl-private.h"
+#if !_WIN32
+#  include <sys/mman.h>
+#endif // !_WIN32
+
+
+//
+// Local constants...
+//
+
+#define _PAPPL_JOURNAL_MAGIC	"PAPPL Journal 1\n"
+					// Journal file header
+#define _PAPPL_JOURNAL_HEADER	16	// Length of journal file header
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_jrec_s		// Job journal record
+{
+  uint32_t	length;			// Length of record including strings, multiple of 8
+  int32_t	printer_id,		// "printer-id" value
+		job_id,			// "job-id" value
+		state,			// "job-state" value
+		state_reasons,		// "job-state-reasons" bits
+		impressions,		// "job-impressions" value
+		impcompleted,		// "job-impressions-completed" value
+		reserved;		// Reserved, always 0
+  int64_t	created,		// "time-at-creation" value
+		processing,		// "time-at-processing" value
+		completed;		// "time-at-completed" value
+					// Followed by nul-terminated name, username, format, and filename
+} _pappl_jrec_t;
 
 
 //
 // Local functions...
 //
 
+static void	open_journal(pappl_system_t *system, const char *filename);
 static void	parse_contact(char *value, pappl_contact_t *contact);
 static void	parse_media_col(char *value, pappl_media_col_t *media);
 static char	*read_line(cups_file_t *fp, char *line, size_t linesize, char **value, int *linenum);
+static void	replay_journal(pappl_system_t *system);
+static void	replay_job(pappl_system_t *system, _pappl_jrec_t *rec, const char *name, const char *username, const char *format, const char *filename);
 static void	write_contact(cups_file_t *fp, pappl_contact_t *contact);
 static void	write_media_col(cups_file_t *fp, const char *name, pappl_media_col_t *media);
 static void	write_options(cups_file_t *fp, const char *name, int num_options, cups_option_t *options);
 
 
+//
+// '_papplJobWriteJournal()' - Append a job's current state to the job journal.
+//
+// Each record is a complete snapshot of the job, so replaying a record that is
+// already reflected in the state file is harmless.
+//
+
+bool					// O - `true` if recorded, `false` if no journal or error
+_papplJobWriteJournal(pappl_job_t *job)	// I - Job
+{
+  pappl_system_t	*system = job->system;
+					// System
+  _pappl_jrec_t		*rec;		// Record
+  char			buffer[sizeof(_pappl_jrec_t) + 2048],
+					// Record buffer
+			*bufptr,	// Pointer into buffer
+			*bufend;	// End of buffer
+  const char		*strings[4];	// Strings to record
+  size_t		i,		// Looping var
+			length;		// Length of record
+  bool			ret = false;	// Return value
+
+
+  if (system->journal_fd < 0)
+    return (false);
+
+  memset(buffer, 0, sizeof(buffer));
+
+  rec                = (_pappl_jrec_t *)buffer;
+  rec->printer_id    = job->printer->printer_id;
+  rec->job_id        = job->job_id;
+  rec->state         = (int32_t)job->state;
+  rec->state_reasons = (int32_t)job->state_reasons;
+  rec->impressions   = job->impressions;
+  rec->impcompleted  = job->impcompleted;
+  rec->created       = (int64_t)job->created;
+  rec->processing    = (int64_t)job->processing;
+  rec->completed     = (int64_t)job->completed;
+
+  strings[0] = job->name;
+  strings[1] = job->username;
+  strings[2] = job->format;
+  strings[3] = job->spool_fd >= 0 ? NULL : job->filename;
+
+  for (i = 0, bufptr = buffer + sizeof(_pappl_jrec_t), bufend = buffer + sizeof(buffer); i < (sizeof(strings) / sizeof(strings[0])); i ++)
+  {
+    // Each string is truncated as needed to leave room for the ones after it...
+    strlcpy(bufptr, strings[i] ? strings[i] : "", (size_t)(bufend - bufptr) - 3 + i);
+    bufptr += strlen(bufptr) + 1;
+  }
+
+  length      = ((size_t)(bufptr - buffer) + 7) & ~(size_t)7;
+  rec->length = (uint32_t)length;
+
+  pthread_mutex_lock(&system->journal_mutex);
+
+  if (system->journal_fd >= 0)
+  {
+    if (write(system->journal_fd, buffer, length) == (ssize_t)length)
+    {
+      system->journal_size += length;
+      ret = true;
+    }
+    else
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write job journal '%s': %s", system->journal_file, strerror(errno));
+  }
+
+  pthread_mutex_unlock(&system->journal_mutex);
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemLoadState()' - Load the previous system state.
 //
@@ -33,6 +142,10 @@ static void	write_options(cups_file_t *fp, const char *name, int num_options, cu
 // @link papplSystemSaveState@ function.  The system state contains all of the
 // system object values, the list of printers, and the jobs for each printer.
 //
+// If the system was created with the `PAPPL_SOPTIONS_JOB_JOURNAL` option, the
+// job journal ("filename.journal") is opened and any jobs completed since the
+// state file was last saved are restored from it.
+//
 // When loading a printer definition, if the printer cannot be created (e.g.,
 // because the driver name is no longer valid) then that printer and all of its
 // job history will be lost.  In the case of a bad driver name, a printer
@@ -67,6 +180,10 @@ papplSystemLoadState(
     return (false);
   }
 
+  // Open the job journal as needed...
+  if (system->options & PAPPL_SOPTIONS_JOB_JOURNAL)
+    open_journal(system, filename);
+
   // Open the state file...
   if ((fp = cupsFileOpen(filename, "r")) == NULL)
   {
@@ -175,6 +292,8 @@ papplSystemLoadState(
 	  papplPrinterSetMaxActiveJobs(printer, (int)strtol(value, NULL, 10));
 	else if (!strcasecmp(line, "MaxCompletedJobs") && value)
 	  papplPrinterSetMaxCompletedJobs(printer, (int)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "MaxProcessingJobs") && value)
+	  papplPrinterSetMaxProcessingJobs(printer, (int)strtol(value, NULL, 10));
 	else if (!strcasecmp(line, "NextJobId") && value)
 	  papplPrinterSetNextJobID(printer, (int)strtol(value, NULL, 10));
 	else if (!strcasecmp(line, "ImpressionsCompleted") && value)
@@ -228,6 +347,8 @@ papplSystemLoadState(
           char	defname[128],		// xxx-default name
 	      	supname[128];		// xxx-supported name
 	  ipp_attribute_t *attr;	// Attribute
+	  ipp_t	*extra = printer->driver_extra;
+					// Printer-specific driver attributes
 
           *ptr = '\0';
 
@@ -237,23 +358,26 @@ papplSystemLoadState(
           if (!value)
             value = ptr;
 
-	  ippDeleteAttribute(printer->driver_attrs, ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO));
+          if (!extra)
+            extra = printer->driver_extra = ippNew();
+
+	  ippDeleteAttribute(extra, ippFindAttribute(extra, defname, IPP_TAG_ZERO));
 
-          if ((attr = ippFindAttribute(printer->driver_attrs, supname, IPP_TAG_ZERO)) != NULL)
+          if ((attr = _papplPrinterFindDriverAttr(printer, supname, IPP_TAG_ZERO)) != NULL)
           {
             switch (ippGetValueTag(attr))
             {
               case IPP_TAG_BOOLEAN :
-                  ippAddBoolean(printer->driver_attrs, IPP_TAG_PRINTER, defname, !strcmp(value, "true"));
+                  ippAddBoolean(extra, IPP_TAG_PRINTER, defname, !strcmp(value, "true"));
                   break;
 
               case IPP_TAG_INTEGER :
               case IPP_TAG_RANGE :
-                  ippAddInteger(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, (int)strtol(value, NULL, 10));
+                  ippAddInteger(extra, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, (int)strtol(value, NULL, 10));
                   break;
 
               case IPP_TAG_KEYWORD :
-		  ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
+		  ippAddString(extra, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
                   break;
 
               default :
@@ -262,7 +386,7 @@ papplSystemLoadState(
 	  }
           else
           {
-            ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
+            ippAddString(extra, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
           }
         }
 	else if (!strcasecmp(line, "Job") && value)
@@ -314,7 +438,7 @@ papplSystemLoadState(
 	  if ((job_value = cupsGetOption("imcompleted", num_options, options)) != NULL)
 	    job->impcompleted = (int)strtol(job_value, NULL, 10);
 
-	  // Add the job to printer completed jobs array...
+	  // Load the attributes of active jobs...
 	  if (job->state < IPP_JSTATE_STOPPED)
 	  {
 	    // Load the file attributes from the spool directory...
@@ -336,17 +460,10 @@ papplSystemLoadState(
 	      // If file removed, then set job state to aborted...
 	      job->state = IPP_JSTATE_ABORTED;
 	    }
-	    else
-	    {
-	      // Add the job to printer active jobs array...
-	      cupsArrayAdd(printer->active_jobs, job);
-	    }
-	  }
-	  else
-	  {
-	    // Add job to printer completed jobs...
-	    cupsArrayAdd(printer->completed_jobs, job);
 	  }
+
+	  // Add the job to the printer's active or completed jobs...
+	  _papplPrinterAddJobNoLock(printer, job);
 	}
 	else
 	  papplLog(system, PAPPL_LOGLEVEL_WARN, "Unknown printer directive '%s' on line %d of '%s'.", line, linenum, filename);
@@ -365,6 +482,10 @@ papplSystemLoadState(
 
   cupsFileClose(fp);
 
+  // Restore any jobs recorded in the journal after the state was saved...
+  if (system->journal_fd >= 0)
+    replay_journal(system);
+
   return (true);
 }
 
@@ -381,6 +502,11 @@ papplSystemLoadState(
 // |    (void *)filename);
 // ```
 //
+// The state is written to a temporary file ("filename.tmp") that replaces
+// the state file once it is complete, so an interrupted save never leaves a
+// partial state file behind.  Saving the state also empties the job journal,
+// if any, since the state file then contains all of the journaled jobs.
+//
 
 bool					// O - `true` on success, `false` on failure
 papplSystemSaveState(
@@ -392,16 +518,27 @@ papplSystemSaveState(
   cups_file_t		*fp;		// Output file
   pappl_printer_t	*printer;	// Current printer
   pappl_job_t		*job;		// Current Job
+  char			journal[1024],	// Job journal for this file
+			tempfile[1024],	// Temporary state file
+			directory[1024];// Spool directory
+  size_t		journal_size;	// Size of job journal before saving
+
+
+  pthread_mutex_lock(&system->journal_mutex);
+  journal_size = system->journal_size;
+  pthread_mutex_unlock(&system->journal_mutex);
 
+  snprintf(tempfile, sizeof(tempfile), "%s.tmp", filename);
 
-  if ((fp = cupsFileOpen(filename, "w")) == NULL)
+  if ((fp = cupsFileOpen(tempfile, "w")) == NULL)
   {
-    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", filename, cupsLastErrorString());
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", tempfile, cupsLastErrorString());
     return (false);
   }
 
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Saving system state to '%s'.", filename);
 
+  pthread_rwlock_rdlock(&system->printers_rwlock);
   pthread_rwlock_rdlock(&system->rwlock);
 
   if (system->dns_sd_name)
@@ -424,6 +561,11 @@ papplSystemSaveState(
   cupsFilePrintf(fp, "DefaultPrinterID %d\n", system->default_printer_id);
   cupsFilePrintf(fp, "NextPrinterID %d\n", system->next_printer_id);
   cupsFilePutConf(fp, "UUID", system->uuid);
+  strlcpy(directory, system->directory, sizeof(directory));
+
+  // Release the configuration lock before locking any printers, which must
+  // come first in the lock order...
+  pthread_rwlock_unlock(&system->rwlock);
 
   // Loop through the printers.
   //
@@ -432,7 +574,6 @@ papplSystemSaveState(
 
   for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
   {
-    int			jcount;		// Number of jobs
     int			num_options = 0;// Number of options
     cups_option_t	*options = NULL;// Options
 
@@ -467,6 +608,8 @@ papplSystemSaveState(
       cupsFilePutConf(fp, "PrintGroup", printer->print_group);
     cupsFilePrintf(fp, "MaxActiveJobs %d\n", printer->max_active_jobs);
     cupsFilePrintf(fp, "MaxCompletedJobs %d\n", printer->max_completed_jobs);
+    if (printer->max_processing_jobs > 1)
+      cupsFilePrintf(fp, "MaxProcessingJobs %d\n", printer->max_processing_jobs);
     cupsFilePrintf(fp, "NextJobId %d\n", printer->next_job_id);
     cupsFilePrintf(fp, "ImpressionsCompleted %d\n", printer->impcompleted);
 
@@ -516,18 +659,13 @@ papplSystemSaveState(
 	      	defvalue[1024];		// xxx-default value
 
       snprintf(defname, sizeof(defname), "%s-default", printer->driver_data.vendor[j]);
-      ippAttributeString(ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO), defvalue, sizeof(defvalue));
+      ippAttributeString(_papplPrinterFindDriverAttr(printer, defname, IPP_TAG_ZERO), defvalue, sizeof(defvalue));
 
       cupsFilePutConf(fp, defname, defvalue);
     }
 
-    // Note: Cannot use cupsArrayFirst/Last since other threads might be
-    // enumerating the all_jobs array.
-
-    for (j = 0, jcount = cupsArrayCount(printer->all_jobs); j < jcount; j ++)
+    for (job = printer->all_jobs.first; job; job = job->all_next)
     {
-      job = (pappl_job_t *)cupsArrayIndex(printer->all_jobs, j);
-
       // Add basic job attributes...
       num_options = 0;
       num_options = cupsAddIntegerOption("id", job->job_id, num_options, &options);
@@ -535,7 +673,7 @@ papplSystemSaveState(
       num_options = cupsAddOption("username", job->username, num_options, &options);
       num_options = cupsAddOption("format", job->format, num_options, &options);
 
-      if (job->filename)
+      if (job->filename && job->spool_fd < 0)
         num_options = cupsAddOption("filename", job->filename, num_options, &options);
       if (job->state)
         num_options = cupsAddIntegerOption("state", (int)job->state, num_options, &options);
@@ -560,7 +698,7 @@ papplSystemSaveState(
         // Save job attributes to file in spool directory...
         if (job->state < IPP_JSTATE_STOPPED)
         {
-          if ((attr_fd = papplJobOpenFile(job, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", "w")) < 0)
+          if ((attr_fd = papplJobOpenFile(job, job_attr_filename, sizeof(job_attr_filename), directory, "ipp", "w")) < 0)
           {
             papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create file for job attributes: '%s'.", job_attr_filename);
             continue;
@@ -572,7 +710,7 @@ papplSystemSaveState(
         else
         {
           // If job completed or aborted, remove job-attributes file...
-          papplJobOpenFile(job, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", "x");
+          papplJobOpenFile(job, job_attr_filename, sizeof(job_attr_filename), directory, "ipp", "x");
         }
       }
 
@@ -585,14 +723,103 @@ papplSystemSaveState(
     pthread_rwlock_unlock(&printer->rwlock);
   }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
-  cupsFileClose(fp);
+  if (cupsFileClose(fp))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to save system state file '%s': %s", tempfile, cupsLastErrorString());
+    unlink(tempfile);
+    return (false);
+  }
+
+#if _WIN32
+  // Windows does not replace an existing file...
+  unlink(filename);
+#endif // _WIN32
+
+  if (rename(tempfile, filename))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to replace system state file '%s': %s", filename, strerror(errno));
+    unlink(tempfile);
+    return (false);
+  }
+
+  // Empty the job journal unless jobs were recorded while we were saving...
+  snprintf(journal, sizeof(journal), "%s.journal", filename);
+
+  pthread_mutex_lock(&system->journal_mutex);
+
+  if (system->journal_fd >= 0 && system->journal_size == journal_size && journal_size > _PAPPL_JOURNAL_HEADER && !strcmp(system->journal_file, journal))
+  {
+    if (ftruncate(system->journal_fd, _PAPPL_JOURNAL_HEADER))
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to empty job journal '%s': %s", system->journal_file, strerror(errno));
+    else
+      system->journal_size = _PAPPL_JOURNAL_HEADER;
+  }
+
+  pthread_mutex_unlock(&system->journal_mutex);
 
   return (true);
 }
 
 
+//
+// 'open_journal()' - Open the job journal for a state file.
+//
+
+static void
+open_journal(pappl_system_t *system,	// I - System
+             const char     *filename)	// I - State file
+{
+  char		journal[1024],		// Journal filename
+		header[_PAPPL_JOURNAL_HEADER];
+					// Journal file header
+  struct stat	fileinfo;		// Journal file information
+
+
+  snprintf(journal, sizeof(journal), "%s.journal", filename);
+
+  pthread_mutex_lock(&system->journal_mutex);
+
+  if (system->journal_fd >= 0)
+    close(system->journal_fd);
+
+  free(system->journal_file);
+  system->journal_file = strdup(journal);
+  system->journal_size = 0;
+
+  if ((system->journal_fd = open(journal, O_RDWR | O_CREAT | O_APPEND | O_BINARY, 0600)) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open job journal '%s': %s", journal, strerror(errno));
+  }
+  else if (fstat(system->journal_fd, &fileinfo))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to get information about job journal '%s': %s", journal, strerror(errno));
+    close(system->journal_fd);
+    system->journal_fd = -1;
+  }
+  else if (fileinfo.st_size < _PAPPL_JOURNAL_HEADER || read(system->journal_fd, header, sizeof(header)) != sizeof(header) || memcmp(header, _PAPPL_JOURNAL_MAGIC, sizeof(header)))
+  {
+    // New or unrecognized journal, start over...
+    if (fileinfo.st_size > 0)
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Ignoring bad job journal '%s'.", journal);
+
+    if (ftruncate(system->journal_fd, 0) || write(system->journal_fd, _PAPPL_JOURNAL_MAGIC, _PAPPL_JOURNAL_HEADER) != _PAPPL_JOURNAL_HEADER)
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to initialize job journal '%s': %s", journal, strerror(errno));
+      close(system->journal_fd);
+      system->journal_fd = -1;
+    }
+    else
+      system->journal_size = _PAPPL_JOURNAL_HEADER;
+  }
+  else
+    system->journal_size = (size_t)fileinfo.st_size;
+
+  pthread_mutex_unlock(&system->journal_mutex);
+}
+
+
 //
 // 'parse_contact()' - Parse a contact value.
 //
@@ -714,6 +941,162 @@ read_line(cups_file_t *fp,		// I  - File
 }
 
 
+//
+// 'replay_journal()' - Restore jobs from the job journal.
+//
+
+static void
+replay_journal(pappl_system_t *system)	// I - System
+{
+  char		*data,			// Journal data
+		*dataptr,		// Pointer into data
+		*dataend,		// End of data
+		*strings[4],		// Strings in record
+		*strptr;		// Pointer into strings
+  _pappl_jrec_t	rec;			// Current record
+  size_t	i,			// Looping var
+		count = 0;		// Number of records
+  int		journal_fd;		// Journal file descriptor
+
+
+  if (system->journal_size <= _PAPPL_JOURNAL_HEADER)
+    return;
+
+  // Map the journal into memory...
+#if _WIN32
+  if ((data = malloc(system->journal_size)) == NULL)
+    return;
+
+  if (lseek(system->journal_fd, 0, SEEK_SET) != 0 || read(system->journal_fd, data, (unsigned)system->journal_size) != (int)system->journal_size)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to read job journal '%s': %s", system->journal_file, strerror(errno));
+    free(data);
+    return;
+  }
+
+#else
+  if ((data = mmap(NULL, system->journal_size, PROT_READ, MAP_PRIVATE, system->journal_fd, 0)) == MAP_FAILED)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to map job journal '%s': %s", system->journal_file, strerror(errno));
+    return;
+  }
+#endif // _WIN32
+
+  // Then replay each record, stopping at the first incomplete one.  The
+  // journal is detached while replaying so that the restored jobs are not
+  // recorded a second time...
+  journal_fd         = system->journal_fd;
+  system->journal_fd = -1;
+
+  for (dataptr = data + _PAPPL_JOURNAL_HEADER, dataend = data + system->journal_size; (size_t)(dataend - dataptr) >= sizeof(rec); dataptr += rec.length)
+  {
+    memcpy(&rec, dataptr, sizeof(rec));
+
+    if (rec.length < sizeof(rec) || rec.length > (size_t)(dataend - dataptr) || (rec.length & 7))
+      break;
+
+    for (i = 0, strptr = dataptr + sizeof(rec); i < (sizeof(strings) / sizeof(strings[0])); i ++)
+    {
+      strings[i] = strptr;
+
+      if ((strptr = memchr(strptr, 0, (size_t)(dataptr + rec.length - strptr))) == NULL)
+        break;
+
+      strptr ++;
+    }
+
+    if (i < (sizeof(strings) / sizeof(strings[0])))
+      break;
+
+    replay_job(system, &rec, strings[0], strings[1], strings[2], strings[3]);
+    count ++;
+  }
+
+  system->journal_fd = journal_fd;
+
+  if (dataptr < dataend)
+    papplLog(system, PAPPL_LOGLEVEL_WARN, "Ignoring %u bytes of incomplete data at the end of job journal '%s'.", (unsigned)(dataend - dataptr), system->journal_file);
+
+  papplLog(system, PAPPL_LOGLEVEL_INFO, "Replayed %u records from job journal '%s'.", (unsigned)count, system->journal_file);
+
+#if _WIN32
+  free(data);
+#else
+  munmap(data, system->journal_size);
+#endif // _WIN32
+}
+
+
+//
+// 'replay_job()' - Restore a job from a journal record.
+//
+
+static void
+replay_job(
+    pappl_system_t *system,		// I - System
+    _pappl_jrec_t  *rec,		// I - Journal record
+    const char     *name,		// I - "job-name" value
+    const char     *username,		// I - "job-originating-user-name" value
+    const char     *format,		// I - "document-format" value
+    const char     *filename)		// I - Print file, if any
+{
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		*job;		// Job
+  ipp_attribute_t	*attr;		// Job attribute
+  bool			created = false;// Did we create the job?
+
+
+  // Only jobs that have reached a terminating state are journaled...
+  if (rec->state < IPP_JSTATE_CANCELED || rec->state > IPP_JSTATE_COMPLETED)
+    return;
+
+  if ((printer = papplSystemFindPrinter(system, NULL, rec->printer_id, NULL)) == NULL)
+    return;
+
+  if ((job = papplPrinterFindJob(printer, rec->job_id)) == NULL)
+  {
+    // Job was created after the state was saved...
+    if ((job = _papplJobCreate(printer, rec->job_id, username, format, name, NULL)) == NULL)
+      return;
+
+    // The strings are only valid until the journal is unmapped...
+    if ((attr = ippFindAttribute(job->attrs, "job-name", IPP_TAG_NAME)) != NULL)
+      job->name = ippGetString(attr, 0, NULL);
+    if ((attr = ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_MIMETYPE, "document-format-supplied", NULL, format)) != NULL)
+      job->format = ippGetString(attr, 0, NULL);
+    if (*filename)
+      job->filename = strdup(filename);
+
+    if (rec->job_id >= printer->next_job_id)
+      printer->next_job_id = rec->job_id + 1;
+
+    created = true;
+  }
+  else if (job->state >= IPP_JSTATE_CANCELED)
+  {
+    // Already completed in the state file...
+    return;
+  }
+
+  _PAPPL_JOB_STATUS_BEGIN(job);
+  job->state         = (ipp_jstate_t)rec->state;
+  job->state_reasons = (pappl_jreason_t)rec->state_reasons;
+  job->created       = (time_t)rec->created;
+  job->processing    = (time_t)rec->processing;
+  job->completed     = (time_t)rec->completed;
+  job->impressions   = rec->impressions;
+  job->impcompleted  = rec->impcompleted;
+  _PAPPL_JOB_STATUS_END(job);
+
+  if (created)
+    _papplPrinterAddJobNoLock(printer, job);
+  else
+    _papplPrinterCompleteJobNoLock(printer, job);
+
+  printer->impcompleted += job->impcompleted;
+}
+
+
 //
 // 'write_contact()' - Write an "xxx-contact" value.
 //
@@ -0,0 +1,580 @@
+//
+// System metrics and tracing functions for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+#include "device-private.h"
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_pmetrics_s	// Snapshot of printer metrics
+{
+  char			name[512];		// Quoted printer name
+  int			jobs[IPP_JSTATE_COMPLETED - IPP_JSTATE_PENDING + 1];
+						// Number of jobs in each state
+  size_t		job_counts[3],		// Number of finished jobs
+			job_secs[3];		// Seconds spent on finished jobs
+  pappl_devmetrics_t	device;			// Device metrics
+  pappl_devtimings_t	timings;		// Device timing metrics
+} _pappl_pmetrics_t;
+
+
+//
+// Local globals...
+//
+
+static const size_t ipp_buckets[_PAPPL_METRICS_BUCKETS] =
+{					// Upper bounds of latency buckets in microseconds
+  1000,
+  2500,
+  5000,
+  10000,
+  25000,
+  50000,
+  100000,
+  250000,
+  500000,
+  1000000,
+  2500000,
+  5000000,
+  10000000
+};
+static const char * const trace_names[_PAPPL_JTRACE_MAX] =
+{					// Names of traced job phases
+  "spool",
+  "queue",
+  "open",
+  "filter",
+  "startpage",
+  "writeline",
+  "writelines",
+  "endpage",
+  "finish"
+};
+
+
+//
+// Local functions...
+//
+
+static void	metrics_add(_pappl_ipp_metrics_t *metrics, size_t usecs);
+static char	*metrics_label(const char *value, char *buffer, size_t bufsize);
+static void	metrics_histogram(pappl_client_t *client, const char *name, const char *type, const size_t *hist, unsigned long long nsecs);
+static bool	metrics_printf(pappl_client_t *client, const char *format, ...) _PAPPL_FORMAT(2,3);
+static void	metrics_printer(pappl_printer_t *printer, _pappl_pmetrics_t *pm);
+
+
+//
+// '_papplJobAddTrace()' - Finish a traced span for a job.
+//
+// The span duration is added to the job's totals for the phase.  All phases
+// except the per-line write line callbacks, which are called too often to
+// record individually, are also added to the system's trace buffer.  The write
+// lines callback is called once per band and is recorded.
+//
+
+void
+_papplJobAddTrace(
+    pappl_job_t     *job,		// I - Job
+    _pappl_jtrace_t phase,		// I - Job processing phase
+    long long       start)		// I - Start time from @code _papplTraceTime@
+{
+  pappl_system_t	*system = job->system;
+					// System
+  long long		usecs;		// Duration in microseconds
+  _pappl_trace_t	*trace;		// Trace span
+
+
+  usecs = _papplTraceTime() - start;
+
+  job->trace_usecs[phase] += usecs;
+
+  if (phase == _PAPPL_JTRACE_WRITELINE)
+    return;
+
+  pthread_mutex_lock(&system->trace_mutex);
+
+  if (system->traces)
+  {
+    trace = system->traces + system->num_traces % _PAPPL_MAX_TRACES;
+
+    trace->printer_id = job->printer->printer_id;
+    trace->job_id     = job->job_id;
+    trace->phase      = (int)phase;
+    trace->start      = start;
+    trace->usecs      = usecs;
+
+    system->num_traces ++;
+  }
+
+  pthread_mutex_unlock(&system->trace_mutex);
+}
+
+
+//
+// '_papplSystemAddIPPMetrics()' - Record the latency of an IPP request.
+//
+// Operations with codes of @code _PAPPL_METRICS_OPS@ or more, such as the CUPS
+// vendor operations, are counted together.
+//
+
+void
+_papplSystemAddIPPMetrics(
+    pappl_system_t *system,		// I - System
+    ipp_op_t       op,			// I - Operation code
+    size_t         usecs)		// I - Microseconds to process the request
+{
+  metrics_add(system->ipp_metrics + (op > 0 && op < _PAPPL_METRICS_OPS ? op : 0), usecs);
+}
+
+
+//
+// '_papplSystemAddTLSMetrics()' - Record the latency of a TLS handshake.
+//
+// Failed handshakes are counted separately and do not contribute to the
+// latency histogram.
+//
+
+void
+_papplSystemAddTLSMetrics(
+    pappl_system_t *system,		// I - System
+    bool           success,		// I - `true` if the handshake succeeded
+    size_t         usecs)		// I - Microseconds for the handshake
+{
+  if (success)
+    metrics_add(&system->tls_metrics, usecs);
+  else
+    _PAPPL_ATOMIC_ADD(&system->tls_failures, 1);
+}
+
+
+//
+// '_papplSystemWebMetrics()' - Show the system metrics.
+//
+// The metrics are sent using the Prometheus text exposition format and include
+// the client, log, and IPP request metrics for the system followed by the job
+// and device metrics for each printer.  Counters are cumulative since the
+// system was started.
+//
+
+void
+_papplSystemWebMetrics(
+    pappl_client_t *client,		// I - Client
+    pappl_system_t *system)		// I - System
+{
+  http_status_t		code;		// Authorization status
+  int			i,		// Looping var
+			count;		// Number of printers
+  pappl_loglevel_t	level;		// Current log level
+  ipp_op_t		op;		// Current operation
+  const char		*opname;	// Operation name
+  size_t		total;		// Cumulative bucket count
+  int			bucket;		// Current bucket
+  _pappl_pmetrics_t	*pmetrics = NULL,
+					// Printer metrics
+			*pm;		// Current printer metrics
+  ipp_jstate_t		state;		// Current job state
+  static const char * const levels[] =	// Log level names
+  {
+    "debug",
+    "info",
+    "warn",
+    "error",
+    "fatal"
+  };
+
+
+  if ((code = papplClientIsAuthorized(client)) != HTTP_STATUS_CONTINUE)
+  {
+    papplClientRespond(client, code, NULL, NULL, 0, 0);
+    return;
+  }
+
+  if (!papplClientRespond(client, HTTP_STATUS_OK, NULL, "text/plain; version=0.0.4", 0, 0))
+    return;
+
+  // System metrics...
+  metrics_printf(client, "# HELP pappl_uptime_seconds Number of seconds since the system was started.\n# TYPE pappl_uptime_seconds gauge\npappl_uptime_seconds %ld\n", (long)(time(NULL) - system->start_time));
+
+  metrics_printf(client, "# HELP pappl_clients Number of active client connections.\n# TYPE pappl_clients gauge\npappl_clients %d\n", _PAPPL_ATOMIC_GET(&system->num_clients));
+
+  metrics_printf(client, "# HELP pappl_clients_rejected_total Number of client connections and requests rejected by the connection and request rate limits.\n# TYPE pappl_clients_rejected_total counter\npappl_clients_rejected_total %lu\n", (unsigned long)_PAPPL_ATOMIC_GET(&system->num_rejected));
+
+  metrics_printf(client, "# HELP pappl_log_messages_total Number of log messages by level.\n# TYPE pappl_log_messages_total counter\n");
+  for (level = PAPPL_LOGLEVEL_DEBUG; level <= PAPPL_LOGLEVEL_FATAL; level ++)
+    metrics_printf(client, "pappl_log_messages_total{level=\"%s\"} %lu\n", levels[level], (unsigned long)_PAPPL_ATOMIC_GET(&system->log_counts[level]));
+
+  metrics_printf(client, "# HELP pappl_ipp_request_duration_seconds Time to process IPP requests by operation.\n# TYPE pappl_ipp_request_duration_seconds histogram\n");
+  for (op = (ipp_op_t)0; op < _PAPPL_METRICS_OPS; op ++)
+  {
+    _pappl_ipp_metrics_t *metrics = system->ipp_metrics + op;
+					// Metrics for operation
+
+    if (!_PAPPL_ATOMIC_GET(&metrics->count))
+      continue;
+
+    opname = op ? ippOpString(op) : "other";
+
+    for (bucket = 0, total = 0; bucket < _PAPPL_METRICS_BUCKETS; bucket ++)
+    {
+      total += _PAPPL_ATOMIC_GET(&metrics->buckets[bucket]);
+      metrics_printf(client, "pappl_ipp_request_duration_seconds_bucket{operation=\"%s\",le=\"%g\"} %lu\n", opname, ipp_buckets[bucket] * 0.000001, (unsigned long)total);
+    }
+
+    total += _PAPPL_ATOMIC_GET(&metrics->buckets[bucket]);
+    metrics_printf(client, "pappl_ipp_request_duration_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %lu\n", opname, (unsigned long)total);
+    metrics_printf(client, "pappl_ipp_request_duration_seconds_sum{operation=\"%s\"} %.6f\n", opname, _PAPPL_ATOMIC_GET(&metrics->usecs) * 0.000001);
+    metrics_printf(client, "pappl_ipp_request_duration_seconds_count{operation=\"%s\"} %lu\n", opname, (unsigned long)total);
+  }
+
+  if (_PAPPL_ATOMIC_GET(&system->tls_metrics.count))
+  {
+    metrics_printf(client, "# HELP pappl_tls_handshake_duration_seconds Time to complete TLS handshakes.\n# TYPE pappl_tls_handshake_duration_seconds histogram\n");
+    for (bucket = 0, total = 0; bucket < _PAPPL_METRICS_BUCKETS; bucket ++)
+    {
+      total += _PAPPL_ATOMIC_GET(&system->tls_metrics.buckets[bucket]);
+      metrics_printf(client, "pappl_tls_handshake_duration_seconds_bucket{le=\"%g\"} %lu\n", ipp_buckets[bucket] * 0.000001, (unsigned long)total);
+    }
+
+    total += _PAPPL_ATOMIC_GET(&system->tls_metrics.buckets[bucket]);
+    metrics_printf(client, "pappl_tls_handshake_duration_seconds_bucket{le=\"+Inf\"} %lu\n", (unsigned long)total);
+    metrics_printf(client, "pappl_tls_handshake_duration_seconds_sum %.6f\n", _PAPPL_ATOMIC_GET(&system->tls_metrics.usecs) * 0.000001);
+    metrics_printf(client, "pappl_tls_handshake_duration_seconds_count %lu\n", (unsigned long)total);
+  }
+
+  metrics_printf(client, "# HELP pappl_tls_handshake_failures_total Number of failed TLS handshakes.\n# TYPE pappl_tls_handshake_failures_total counter\npappl_tls_handshake_failures_total %lu\n", (unsigned long)_PAPPL_ATOMIC_GET(&system->tls_failures));
+
+  // Printer metrics...
+  pthread_rwlock_rdlock(&system->printers_rwlock);
+  if ((count = cupsArrayCount(system->printers)) > 0 && (pmetrics = calloc((size_t)count, sizeof(_pappl_pmetrics_t))) != NULL)
+  {
+    for (i = 0; i < count; i ++)
+      metrics_printer((pappl_printer_t *)cupsArrayIndex(system->printers, i), pmetrics + i);
+  }
+  else
+    count = 0;
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
+  metrics_printf(client, "# HELP pappl_printer_jobs Number of jobs by state.\n# TYPE pappl_printer_jobs gauge\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    for (state = IPP_JSTATE_PENDING; state <= IPP_JSTATE_COMPLETED; state ++)
+      metrics_printf(client, "pappl_printer_jobs{printer=\"%s\",state=\"%s\"} %d\n", pm->name, ippEnumString("job-state", (int)state), pm->jobs[state - IPP_JSTATE_PENDING]);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_jobs_finished_total Number of finished jobs by state.\n# TYPE pappl_printer_jobs_finished_total counter\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    for (state = IPP_JSTATE_CANCELED; state <= IPP_JSTATE_COMPLETED; state ++)
+      metrics_printf(client, "pappl_printer_jobs_finished_total{printer=\"%s\",state=\"%s\"} %lu\n", pm->name, ippEnumString("job-state", (int)state), (unsigned long)pm->job_counts[state - IPP_JSTATE_CANCELED]);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_job_processing_seconds_total Time spent processing finished jobs by state.\n# TYPE pappl_printer_job_processing_seconds_total counter\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    for (state = IPP_JSTATE_CANCELED; state <= IPP_JSTATE_COMPLETED; state ++)
+      metrics_printf(client, "pappl_printer_job_processing_seconds_total{printer=\"%s\",state=\"%s\"} %lu\n", pm->name, ippEnumString("job-state", (int)state), (unsigned long)pm->job_secs[state - IPP_JSTATE_CANCELED]);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_device_bytes_total Number of bytes read from and written to the device.\n# TYPE pappl_printer_device_bytes_total counter\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    metrics_printf(client, "pappl_printer_device_bytes_total{printer=\"%s\",type=\"read\"} %lu\n", pm->name, (unsigned long)pm->device.read_bytes);
+    metrics_printf(client, "pappl_printer_device_bytes_total{printer=\"%s\",type=\"write\"} %lu\n", pm->name, (unsigned long)pm->device.write_bytes);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_device_requests_total Number of device requests by type.\n# TYPE pappl_printer_device_requests_total counter\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    metrics_printf(client, "pappl_printer_device_requests_total{printer=\"%s\",type=\"read\"} %lu\n", pm->name, (unsigned long)pm->device.read_requests);
+    metrics_printf(client, "pappl_printer_device_requests_total{printer=\"%s\",type=\"status\"} %lu\n", pm->name, (unsigned long)pm->device.status_requests);
+    metrics_printf(client, "pappl_printer_device_requests_total{printer=\"%s\",type=\"write\"} %lu\n", pm->name, (unsigned long)pm->device.write_requests);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_device_seconds_total Time spent in device requests by type.\n# TYPE pappl_printer_device_seconds_total counter\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    metrics_printf(client, "pappl_printer_device_seconds_total{printer=\"%s\",type=\"read\"} %.6f\n", pm->name, pm->timings.read_nsecs * 0.000000001);
+    metrics_printf(client, "pappl_printer_device_seconds_total{printer=\"%s\",type=\"status\"} %.6f\n", pm->name, pm->timings.status_nsecs * 0.000000001);
+    metrics_printf(client, "pappl_printer_device_seconds_total{printer=\"%s\",type=\"write\"} %.6f\n", pm->name, pm->timings.write_nsecs * 0.000000001);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_device_request_duration_seconds Time to process device requests by type.\n# TYPE pappl_printer_device_request_duration_seconds histogram\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+  {
+    metrics_histogram(client, pm->name, "read", pm->timings.read_hist, pm->timings.read_nsecs);
+    metrics_histogram(client, pm->name, "status", pm->timings.status_hist, pm->timings.status_nsecs);
+    metrics_histogram(client, pm->name, "write", pm->timings.write_hist, pm->timings.write_nsecs);
+  }
+
+  metrics_printf(client, "# HELP pappl_printer_device_write_max_seconds Longest device write request.\n# TYPE pappl_printer_device_write_max_seconds gauge\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+    metrics_printf(client, "pappl_printer_device_write_max_seconds{printer=\"%s\"} %.6f\n", pm->name, pm->timings.write_max_nsecs * 0.000000001);
+
+  metrics_printf(client, "# HELP pappl_printer_device_write_stall_seconds Time spent in the current device write request.\n# TYPE pappl_printer_device_write_stall_seconds gauge\n");
+  for (i = 0, pm = pmetrics; i < count; i ++, pm ++)
+    metrics_printf(client, "pappl_printer_device_write_stall_seconds{printer=\"%s\"} %.6f\n", pm->name, pm->timings.write_stall_nsecs * 0.000000001);
+
+  free(pmetrics);
+
+  _papplClientFlushWrite(client);
+  httpWrite2(client->http, "", 0);
+}
+
+
+//
+// '_papplSystemWebTrace()' - Show the recorded trace spans.
+//
+// The spans are sent as a JSON object in the Chrome trace event format, which
+// can be loaded by "chrome://tracing" and Perfetto.  Each printer is shown as
+// a process and each job as a thread.
+//
+
+void
+_papplSystemWebTrace(
+    pappl_client_t *client,		// I - Client
+    pappl_system_t *system)		// I - System
+{
+  http_status_t		code;		// Authorization status
+  _pappl_trace_t	*traces = NULL,	// Copy of trace spans
+			*trace;		// Current trace span
+  size_t		i,		// Looping var
+			first,		// First span in ring buffer
+			count = 0;	// Number of spans
+
+
+  if ((code = papplClientIsAuthorized(client)) != HTTP_STATUS_CONTINUE)
+  {
+    papplClientRespond(client, code, NULL, NULL, 0, 0);
+    return;
+  }
+
+  // Copy the spans, oldest first, so we don't hold the lock while writing...
+  pthread_mutex_lock(&system->trace_mutex);
+  if (system->traces && system->num_traces > 0)
+  {
+    count = system->num_traces < _PAPPL_MAX_TRACES ? system->num_traces : _PAPPL_MAX_TRACES;
+    first = system->num_traces - count;
+
+    if ((traces = calloc(count, sizeof(_pappl_trace_t))) != NULL)
+    {
+      for (i = 0; i < count; i ++)
+        traces[i] = system->traces[(first + i) % _PAPPL_MAX_TRACES];
+    }
+    else
+      count = 0;
+  }
+  pthread_mutex_unlock(&system->trace_mutex);
+
+  if (papplClientRespond(client, HTTP_STATUS_OK, NULL, "application/json", 0, 0))
+  {
+    metrics_printf(client, "{\"traceEvents\":[");
+
+    for (i = 0, trace = traces; i < count; i ++, trace ++)
+      metrics_printf(client, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d}", i ? "," : "", trace_names[trace->phase], trace->start, trace->usecs, trace->printer_id, trace->job_id);
+
+    metrics_printf(client, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    _papplClientFlushWrite(client);
+    httpWrite2(client->http, "", 0);
+  }
+
+  free(traces);
+}
+
+
+//
+// '_papplTraceTime()' - Return the current time for tracing.
+//
+
+long long				// O - Current time in microseconds
+_papplTraceTime(void)
+{
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((long long)curtime.tv_sec * 1000000 + curtime.tv_usec);
+}
+
+
+//
+// 'metrics_add()' - Add a request to a latency histogram.
+//
+
+static void
+metrics_add(
+    _pappl_ipp_metrics_t *metrics,	// I - Latency metrics
+    size_t               usecs)		// I - Microseconds for the request
+{
+  int	i;				// Looping var
+
+
+  for (i = 0; i < _PAPPL_METRICS_BUCKETS; i ++)
+  {
+    if (usecs <= ipp_buckets[i])
+      break;
+  }
+
+  _PAPPL_ATOMIC_ADD(&metrics->buckets[i], 1);
+  _PAPPL_ATOMIC_ADD(&metrics->usecs, usecs);
+  _PAPPL_ATOMIC_ADD(&metrics->count, 1);
+}
+
+
+//
+// 'metrics_label()' - Quote a label value.
+//
+
+static char *				// O - Quoted value
+metrics_label(const char *value,	// I - Label value
+              char       *buffer,	// I - Buffer
+              size_t     bufsize)	// I - Size of buffer
+{
+  char	*bufptr,			// Pointer into buffer
+	*bufend;			// End of buffer
+
+
+  for (bufptr = buffer, bufend = buffer + bufsize - 2; *value && bufptr < bufend; value ++)
+  {
+    if (*value == '\\' || *value == '\"')
+    {
+      *bufptr++ = '\\';
+      *bufptr++ = *value;
+    }
+    else if (*value == '\n')
+    {
+      *bufptr++ = '\\';
+      *bufptr++ = 'n';
+    }
+    else
+      *bufptr++ = *value;
+  }
+
+  *bufptr = '\0';
+
+  return (buffer);
+}
+
+
+//
+// 'metrics_histogram()' - Send a device latency histogram.
+//
+
+static void
+metrics_histogram(
+    pappl_client_t     *client,		// I - Client
+    const char         *name,		// I - Quoted printer name
+    const char         *type,		// I - Request type
+    const size_t       *hist,		// I - Latency histogram
+    unsigned long long nsecs)		// I - Total nanoseconds
+{
+  int		bucket;			// Current bucket
+  size_t	total;			// Cumulative bucket count
+  double	limit;			// Upper bound of bucket in seconds
+
+
+  for (bucket = 0, total = 0, limit = 0.000001; bucket < (PAPPL_DEVTIMINGS_BUCKETS - 1); bucket ++, limit *= 4.0)
+  {
+    total += hist[bucket];
+    metrics_printf(client, "pappl_printer_device_request_duration_seconds_bucket{printer=\"%s\",type=\"%s\",le=\"%g\"} %lu\n", name, type, limit, (unsigned long)total);
+  }
+
+  total += hist[bucket];
+  metrics_printf(client, "pappl_printer_device_request_duration_seconds_bucket{printer=\"%s\",type=\"%s\",le=\"+Inf\"} %lu\n", name, type, (unsigned long)total);
+  metrics_printf(client, "pappl_printer_device_request_duration_seconds_sum{printer=\"%s\",type=\"%s\"} %.6f\n", name, type, nsecs * 0.000000001);
+  metrics_printf(client, "pappl_printer_device_request_duration_seconds_count{printer=\"%s\",type=\"%s\"} %lu\n", name, type, (unsigned long)total);
+}
+
+
+//
+// 'metrics_printf()' - Send formatted metrics text.
+//
+
+static bool				// O - `true` on success, `false` on error
+metrics_printf(pappl_client_t *client,	// I - Client
+               const char     *format,	// I - Printf-style format string
+               ...)			// I - Additional arguments as needed
+{
+  va_list	ap;			// Pointer to arguments
+  char		buffer[1024];		// Output buffer
+  int		bytes;			// Number of bytes
+
+
+  va_start(ap, format);
+  bytes = vsnprintf(buffer, sizeof(buffer), format, ap);
+  va_end(ap);
+
+  if (bytes < 0)
+    return (false);
+  else if ((size_t)bytes >= sizeof(buffer))
+    bytes = (int)sizeof(buffer) - 1;
+
+  return (_papplClientWrite(client, buffer, (size_t)bytes));
+}
+
+
+//
+// 'metrics_printer()' - Copy the current metrics for a printer.
+//
+
+static void
+metrics_printer(
+    pappl_printer_t   *printer,		// I - Printer
+    _pappl_pmetrics_t *pm)		// I - Printer metrics
+{
+  pappl_job_t		*job;		// Current job
+
+
+  metrics_label(printer->name, pm->name, sizeof(pm->name));
+
+  pthread_rwlock_rdlock(&printer->rwlock);
+
+  for (job = printer->all_jobs.first; job; job = job->all_next)
+  {
+    if (job->state >= IPP_JSTATE_PENDING && job->state <= IPP_JSTATE_COMPLETED)
+      pm->jobs[job->state - IPP_JSTATE_PENDING] ++;
+  }
+
+  memcpy(pm->job_counts, printer->job_counts, sizeof(pm->job_counts));
+  memcpy(pm->job_secs, printer->job_secs, sizeof(pm->job_secs));
+
+  // Add the metrics for the current device connection, if any, to the totals
+  // for closed connections...
+  pm->device  = printer->device_metrics;
+  pm->timings = printer->device_timings;
+
+  if (printer->device)
+  {
+    pappl_devmetrics_t	current;	// Metrics for current connection
+    pappl_devtimings_t	timings;	// Timing metrics for current connection
+
+    papplDeviceGetMetrics(printer->device, &current);
+    papplDeviceGetTimings(printer->device, &timings);
+    _papplDeviceAddTimings(&pm->timings, &timings);
+
+    pm->device.read_bytes      += current.read_bytes;
+    pm->device.read_requests   += current.read_requests;
+    pm->device.read_msecs      += current.read_msecs;
+    pm->device.status_requests += current.status_requests;
+    pm->device.status_msecs    += current.status_msecs;
+    pm->device.write_bytes     += current.write_bytes;
+    pm->device.write_requests  += current.write_requests;
+    pm->device.write_msecs     += current.write_msecs;
+  }
+
+  pthread_rwlock_unlock(&printer->rwlock);
+}
@@ -20,6 +20,7 @@
 //
 
 static int	compare_printers(pappl_printer_t *a, pappl_printer_t *b);
+static size_t	hash_string(const char *s, size_t len, bool nocase);
 
 
 //
@@ -32,8 +33,11 @@ _papplSystemAddPrinter(
     pappl_printer_t *printer,		// I - Printer
     int             printer_id)		// I - Printer ID or `0` for new
 {
+  pappl_printer_t	**bucket;	// Hash bucket
+
+
   // Add the printer to the system...
-  pthread_rwlock_wrlock(&system->rwlock);
+  pthread_rwlock_wrlock(&system->printers_rwlock);
 
   if (printer_id)
     printer->printer_id = printer_id;
@@ -45,11 +49,26 @@ _papplSystemAddPrinter(
 
   cupsArrayAdd(system->printers, printer);
 
+  // Index the printer for papplSystemFindPrinter...
+  bucket = system->printer_ids + ((size_t)printer->printer_id & (_PAPPL_PRINTER_HASH_SIZE - 1));
+  printer->id_next = *bucket;
+  *bucket          = printer;
+
+  bucket = system->printer_resources + hash_string(printer->resource, printer->resourcelen, true);
+  printer->resource_next = *bucket;
+  *bucket                = printer;
+
+  bucket = system->printer_uris + hash_string(printer->device_uri, strlen(printer->device_uri), false);
+  printer->uri_next = *bucket;
+  *bucket           = printer;
+
+  pthread_rwlock_wrlock(&system->rwlock);
   if (!system->default_printer_id)
     system->default_printer_id = printer->printer_id;
-
   pthread_rwlock_unlock(&system->rwlock);
 
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
   _papplSystemConfigChanged(system);
 }
 
@@ -69,9 +88,9 @@ papplSystemFindPrinter(
     int            printer_id,		// I - Printer ID or `0`
     const char     *device_uri)		// I - Device URI or `NULL`
 {
-  int			i,		// Current printer index
-			count;		// Printer count
   pappl_printer_t	*printer = NULL;// Matching printer
+  const char		*resptr;	// Pointer into resource
+  size_t		reslen;		// Length of resource prefix
 
 
   // Range check input...
@@ -80,39 +99,59 @@ papplSystemFindPrinter(
 
   papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter(system=%p, resource=\"%s\", printer_id=%d, device_uri=\"%s\")", (void *)system, resource, printer_id, device_uri);
 
-  pthread_rwlock_rdlock(&system->rwlock);
-
   if (resource && (!strcmp(resource, "/") || !strcmp(resource, "/ipp/print") || (!strncmp(resource, "/ipp/print/", 11) && isdigit(resource[11] & 255))))
   {
+    pthread_rwlock_rdlock(&system->rwlock);
     printer_id = system->default_printer_id;
-    resource   = NULL;
+    pthread_rwlock_unlock(&system->rwlock);
 
-    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: Looking for default printer_id=%d", printer_id);
+    resource = NULL;
   }
 
-  // Loop through the printers to find the one we want...
-  //
-  // Note: Cannot use cupsArrayFirst/Last since other threads might be
-  // enumerating the printers array.
+  pthread_rwlock_rdlock(&system->printers_rwlock);
 
-  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
+  // Look up the printer resource using each leading path of the request
+  // resource, since the printer resource may be followed by "/job-id" or
+  // similar...
+  if (resource && *resource)
   {
-    printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
-
-    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: printer '%s' - resource=\"%s\", printer_id=%d, device_uri=\"%s\"", printer->name, printer->resource, printer->printer_id, printer->device_uri);
+    for (resptr = resource + 1; !printer; resptr ++)
+    {
+      if (*resptr && *resptr != '/')
+        continue;
+
+      reslen = (size_t)(resptr - resource);
+
+      for (printer = system->printer_resources[hash_string(resource, reslen, true)]; printer; printer = printer->resource_next)
+      {
+        if (printer->resourcelen == reslen && !strncasecmp(printer->resource, resource, reslen))
+          break;
+      }
+
+      if (!*resptr)
+        break;
+    }
+  }
 
-    if (resource && !strncasecmp(printer->resource, resource, printer->resourcelen) && (!resource[printer->resourcelen] || resource[printer->resourcelen] == '/'))
-      break;
-    else if (printer->printer_id == printer_id)
-      break;
-    else if (device_uri && !strcmp(printer->device_uri, device_uri))
-      break;
+  if (!printer && printer_id > 0)
+  {
+    for (printer = system->printer_ids[(size_t)printer_id & (_PAPPL_PRINTER_HASH_SIZE - 1)]; printer; printer = printer->id_next)
+    {
+      if (printer->printer_id == printer_id)
+        break;
+    }
   }
 
-  if (i >= count)
-    printer = NULL;
+  if (!printer && device_uri)
+  {
+    for (printer = system->printer_uris[hash_string(device_uri, strlen(device_uri), false)]; printer; printer = printer->uri_next)
+    {
+      if (!strcmp(printer->device_uri, device_uri))
+        break;
+    }
+  }
 
-  pthread_rwlock_unlock(&system->rwlock);
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
   papplLog(system, PAPPL_LOGLEVEL_DEBUG, "papplSystemFindPrinter: Returning %p(%s)", printer, printer ? printer->name : "none");
 
@@ -120,6 +159,54 @@ papplSystemFindPrinter(
 }
 
 
+//
+// '_papplSystemRemovePrinterIndexNoLock()' - Remove a printer from the lookup
+//                                            indexes.
+//
+// The caller must hold the printers writer lock.
+//
+
+void
+_papplSystemRemovePrinterIndexNoLock(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_printer_t	**bucket;	// Hash bucket
+
+
+  for (bucket = system->printer_ids + ((size_t)printer->printer_id & (_PAPPL_PRINTER_HASH_SIZE - 1)); *bucket; bucket = &(*bucket)->id_next)
+  {
+    if (*bucket == printer)
+    {
+      *bucket = printer->id_next;
+      break;
+    }
+  }
+
+  for (bucket = system->printer_resources + hash_string(printer->resource, printer->resourcelen, true); *bucket; bucket = &(*bucket)->resource_next)
+  {
+    if (*bucket == printer)
+    {
+      *bucket = printer->resource_next;
+      break;
+    }
+  }
+
+  for (bucket = system->printer_uris + hash_string(printer->device_uri, strlen(printer->device_uri), false); *bucket; bucket = &(*bucket)->uri_next)
+  {
+    if (*bucket == printer)
+    {
+      *bucket = printer->uri_next;
+      break;
+    }
+  }
+
+  printer->id_next       = NULL;
+  printer->resource_next = NULL;
+  printer->uri_next      = NULL;
+}
+
+
 //
 // 'compare_printers()' - Compare two printers.
 //
@@ -130,3 +217,30 @@ compare_printers(pappl_printer_t *a,	// I - First printer
 {
   return (strcmp(a->name, b->name));
 }
+
+
+//
+// 'hash_string()' - Compute the hash bucket for a string.
+//
+// This is the FNV-1a hash, optionally ignoring case for resource paths.
+//
+
+static size_t				// O - Hash bucket
+hash_string(const char *s,		// I - String
+            size_t     len,		// I - Length of string
+            bool       nocase)		// I - Ignore case?
+{
+  unsigned	hash = 2166136261U;	// Hash value
+
+
+  while (len > 0)
+  {
+    hash ^= (unsigned)(nocase ? tolower(*s & 255) : (*s & 255));
+    hash *= 16777619U;
+
+    s ++;
+    len --;
+  }
+
+  return ((size_t)hash & (_PAPPL_PRINTER_HASH_SIZE - 1));
+}
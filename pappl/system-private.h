@@ -23,13 +23,26 @@
 // Constants...
 //
 
+#  define _PAPPL_MAX_ACCEPT_THREADS 8	// Maximum number of acceptor threads
 #  define _PAPPL_MAX_LISTENERS	32	// Maximum number of listener sockets
+#  define _PAPPL_MAX_SPOOL_DOCUMENTS 16	// Maximum number of largest documents spooled in memory at once
+#  define _PAPPL_METRICS_BUCKETS 13	// Number of IPP latency histogram buckets, not counting "+Inf"
+#  define _PAPPL_METRICS_OPS	128	// Number of IPP operation codes with latency metrics
+#  define _PAPPL_MAX_TRACES	4096	// Maximum number of trace spans kept
+#  define _PAPPL_PRINTER_HASH_SIZE 256	// Size of printer hash tables (power of 2)
 
 
 //
 // Types and structures...
 //
 
+typedef struct _pappl_cloop_s _pappl_cloop_t;
+					// Client event loop
+typedef struct _pappl_logring_s _pappl_logring_t;
+					// Asynchronous log writer
+typedef struct _pappl_rtable_s _pappl_rtable_t;
+					// Resource lookup hash table
+
 typedef struct _pappl_mime_filter_s	// MIME filter
 {
   const char		*src,			// Source MIME media type
@@ -47,13 +60,37 @@ typedef struct _pappl_resource_s	// Resource
   time_t		last_modified;		// Last-Modified date/time
   const void		*data;			// Static data
   size_t		length;			// Length of file/data
+  bool			compress;		// Send with gzip/deflate when accepted?
   pappl_resource_cb_t	cb;			// Dynamic callback
   void			*cbdata;		// Callback data
 } _pappl_resource_t;
 
+typedef struct _pappl_ipp_metrics_s	// IPP operation latency metrics
+{
+  size_t		count,			// Number of requests
+			usecs;			// Total microseconds
+  size_t		buckets[_PAPPL_METRICS_BUCKETS + 1];
+						// Requests for each histogram bucket
+} _pappl_ipp_metrics_t;
+
+typedef struct _pappl_trace_s		// Trace span
+{
+  int			printer_id,		// "printer-id" value
+			job_id,			// "job-id" value
+			phase;			// Job processing phase
+  long long		start,			// Start time in microseconds
+			usecs;			// Duration in microseconds
+} _pappl_trace_t;
+
+//
+// Lock ordering: "printers_rwlock", then a printer's "rwlock", then a job's
+// "rwlock", then the system "rwlock" for configuration values.
+// "resource_rwlock" and "filter_rwlock" are only held by themselves.
+//
+
 struct _pappl_system_s			// System data
 {
-  pthread_rwlock_t	rwlock;			// Reader/writer lock
+  pthread_rwlock_t	rwlock;			// Reader/writer lock for configuration values
   pappl_soptions_t	options;		// Server options
   bool			is_running;		// Is the system running?
   time_t		start_time,		// Startup time
@@ -63,6 +100,14 @@ struct _pappl_system_s			// System data
   pthread_mutex_t	config_mutex;		// Mutex for configuration changes
   size_t		config_changes,		// Number of configuration changes
 			save_changes;		// Number of saved changes
+  time_t		change_time;		// Time of first unsaved change
+  int			save_delay;		// Seconds to wait for changes to settle before saving
+  bool			save_active;		// Is the save thread running?
+  pthread_cond_t	save_cond;		// Condition for save thread completion
+  pthread_mutex_t	journal_mutex;		// Mutex for job journal
+  char			*journal_file;		// Job journal filename, if any
+  int			journal_fd;		// Job journal file descriptor
+  size_t		journal_size;		// Size of job journal
   char			*uuid,			// "system-uuid" value
 			*name,			// "system-name" value
 			*dns_sd_name,		// "system-dns-sd-name" value
@@ -83,11 +128,20 @@ struct _pappl_system_s			// System data
   int			logfd;			// Log file descriptor, if any
   pappl_loglevel_t	loglevel;		// Log level
   size_t		logmaxsize;		// Maximum log file size or `0` for none
+  size_t		logsize;		// Number of bytes written to log file
+  _pappl_logring_t	*logring;		// Asynchronous log writer, if any
+  pthread_mutex_t	logtail_mutex;		// Mutex for recent log lines
+  pthread_cond_t	logtail_cond;		// Condition for new log lines
+  char			*logtail;		// Ring buffer of recent log lines, if any
+  size_t		logtail_pos;		// Number of bytes added to recent log lines
   char			*subtypes;		// DNS-SD sub-types, if any
   bool			tls_only;		// Only support TLS?
   char			*auth_service;		// PAM authorization service, if any
   char			*admin_group;		// PAM administrative group, if any
   gid_t			admin_gid;		// PAM administrative group ID
+  pthread_mutex_t	auth_mutex;		// Mutex for authentication cache
+  cups_array_t		*auth_cache;		// Cache of authenticated users
+  int			auth_cache_time;	// Lifetime of cached credentials in seconds or `0` for none
   char			*default_print_group;	// Default PAM printing group, if any
   char			session_key[65];	// Session key
   pthread_rwlock_t	session_rwlock;		// Reader/writer lock for the session key
@@ -95,11 +149,67 @@ struct _pappl_system_s			// System data
   int			num_listeners;		// Number of listener sockets
   struct pollfd		listeners[_PAPPL_MAX_LISTENERS];
 						// Listener sockets
+  int			listener_shards[_PAPPL_MAX_LISTENERS];
+						// Acceptor thread for each listener
+  int			accept_threads;		// Number of acceptor threads
+  int			accept_stop;		// Stop the acceptor threads?
+  int			wakefds[2];		// Wakeup pipe for housekeeping
+  pthread_rwlock_t	resource_rwlock;	// Reader/writer lock for resources and links
   cups_array_t		*links;			// Web navigation links
   cups_array_t		*resources;		// Array of resources
+  _pappl_rtable_t	*resource_table;	// Hash table for resource lookups
+  int			resource_lookups;	// Number of lookups using the hash tables
+  cups_array_t		*retired_resources;	// Resources kept for current lookups
+  pthread_mutex_t	loc_mutex;		// Mutex for localizations
+  cups_array_t		*localizations,		// Loaded localization catalogs
+			*loc_refs;		// Catalogs by requested language
+  pthread_rwlock_t	filter_rwlock;		// Reader/writer lock for filters
   cups_array_t		*filters;		// Array of filters
-  int			next_client;		// Next client number
+  pthread_mutex_t	templates_mutex;	// Mutex for shared driver attributes
+  cups_array_t		*templates;		// Array of shared driver attributes
+  int			next_client,		// Next client number
+			num_clients,		// Number of client connections
+			max_clients,		// Maximum number of client connections or `0` for no limit
+			max_host_clients,	// Maximum number of connections per client host or `0` for no limit
+			max_request_rate;	// Maximum requests per second per client host or `0` for no limit
+  size_t		num_rejected;		// Number of client connections and requests rejected
+  pthread_mutex_t	client_hosts_mutex;	// Mutex for client host tracking
+  cups_array_t		*client_hosts;		// Connection and request counts by client host
+  size_t		max_image_memory;	// Maximum memory for each image or `0` for no limit
+  size_t		max_spool_memory,	// Maximum document size spooled in memory or `0` for none
+			spool_memory;		// Bytes of documents currently spooled in memory
+  int			max_image_threads;	// Maximum threads for rendering each image
+  _pappl_cloop_t	*client_loop;		// Client event loop, if any
+  pthread_rwlock_t	printers_rwlock;	// Reader/writer lock for printers
   cups_array_t		*printers;		// Array of printers
+  pappl_printer_t	*printer_ids[_PAPPL_PRINTER_HASH_SIZE],
+						// Printers by "printer-id"
+			*printer_resources[_PAPPL_PRINTER_HASH_SIZE],
+						// Printers by resource path
+			*printer_uris[_PAPPL_PRINTER_HASH_SIZE];
+						// Printers by device URI
+  pthread_mutex_t	job_mutex;		// Mutex for job worker threads
+  pthread_cond_t	job_cond;		// Condition for job worker threads
+  cups_array_t		*job_queue;		// Jobs waiting for a worker thread
+  int			max_job_threads,	// Maximum number of job worker threads or `0` for no limit
+			num_job_threads,	// Number of job worker threads
+			busy_job_threads;	// Number of busy job worker threads
+  bool			job_threads_stop;	// Stop the job worker threads?
+  bool			clean_active;		// Is the clean jobs thread running?
+  pthread_mutex_t	subscription_mutex;	// Mutex for subscriptions and their events
+  pthread_cond_t	subscription_cond;	// Condition for new events
+  cups_array_t		*subscriptions;		// Array of subscriptions
+  int			last_subscription_id;	// Last "notify-subscription-id" value
+  _pappl_ipp_metrics_t	ipp_metrics[_PAPPL_METRICS_OPS];
+						// IPP latency metrics, other operations use index 0
+  _pappl_ipp_metrics_t	tls_metrics;		// TLS handshake latency metrics
+  size_t		tls_failures;		// Number of failed TLS handshakes
+  size_t		log_counts[PAPPL_LOGLEVEL_FATAL + 1];
+						// Number of log messages for each level
+  bool			tracing;		// Record job trace spans?
+  pthread_mutex_t	trace_mutex;		// Mutex for trace spans
+  _pappl_trace_t	*traces;		// Ring buffer of trace spans
+  size_t		num_traces;		// Number of trace spans recorded
   int			default_printer_id,	// Default printer-id
 			next_printer_id;	// Next printer-id
   char			password_hash[100];	// Access password hash
@@ -132,6 +242,16 @@ struct _pappl_system_s			// System data
   pappl_wifi_list_cb_t	wifi_list_cb;		// Wi-Fi list callback
   pappl_wifi_status_cb_t wifi_status_cb;	// Wi-Fi status callback
   void			*wifi_cbdata;		// Wi-Fi callback data
+  pthread_mutex_t	wifi_mutex;		// Mutex for Wi-Fi scan results
+  pthread_cond_t	wifi_cond;		// Condition for Wi-Fi scan completion
+  int			wifi_max_age;		// Maximum age of Wi-Fi scan results in seconds
+  time_t		wifi_time;		// Time of last Wi-Fi scan
+  int			wifi_num_ssids;		// Number of Wi-Fi networks
+  cups_dest_t		*wifi_ssids;		// Wi-Fi networks from last scan
+  pthread_mutex_t	status_mutex;		// Mutex for printer status thread exits
+  pthread_cond_t	status_cond;		// Condition for printer status thread exits
+  int			num_status_threads;	// Number of running printer status threads
+  bool			wifi_scanning;		// Is a Wi-Fi scan running?
 };
 
 
@@ -139,27 +259,42 @@ struct _pappl_system_s			// System data
 // Functions...
 //
 
+extern void		_papplSystemAddIPPMetrics(pappl_system_t *system, ipp_op_t op, size_t usecs) _PAPPL_PRIVATE;
+extern void		_papplSystemAddTLSMetrics(pappl_system_t *system, bool success, size_t usecs) _PAPPL_PRIVATE;
 extern void		_papplSystemAddPrinter(pappl_system_t *system, pappl_printer_t *printer, int printer_id) _PAPPL_PRIVATE;
 extern void		_papplSystemAddPrinterIcons(pappl_system_t *system, pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplSystemCleanJobs(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemClearAuthCache(pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemConfigChanged(pappl_system_t *system) _PAPPL_PRIVATE;
-extern void		_papplSystemExportVersions(pappl_system_t *system, ipp_t *ipp, ipp_tag_t group_tag, cups_array_t *ra);
+extern int		_papplSystemCopyWiFiList(pappl_system_t *system, cups_dest_t **ssids, bool refresh, bool *scanning) _PAPPL_PRIVATE;
+extern void		_papplSystemDeleteResources(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemExportVersions(pappl_system_t *system, ipp_t *ipp, ipp_tag_t group_tag, _pappl_raset_t *ra);
 extern _pappl_mime_filter_t *_papplSystemFindMIMEFilter(pappl_system_t *system, const char *srctype, const char *dsttype) _PAPPL_PRIVATE;
 extern _pappl_resource_t *_papplSystemFindResource(pappl_system_t *system, const char *path) _PAPPL_PRIVATE;
 extern char		*_papplSystemMakeUUID(pappl_system_t *system, const char *printer_name, int job_id, char *buffer, size_t bufsize) _PAPPL_PRIVATE;
 extern void		_papplSystemProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern bool		_papplSystemRegisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemRemovePrinterIndexNoLock(pappl_system_t *system, pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplSystemRemoveResourceNoLock(pappl_system_t *system, _pappl_resource_t *r) _PAPPL_PRIVATE;
+extern void		_papplSystemStartWiFiScan(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopJobThreads(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemStopWiFiScan(pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemUnregisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemUpdateResourcesNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemWakeup(pappl_system_t *system) _PAPPL_PRIVATE;
 
 extern void		_papplSystemWebAddPrinter(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebConfig(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebConfigFinalize(pappl_system_t *system, int num_form, cups_option_t *form) _PAPPL_PRIVATE;
 extern void		_papplSystemWebHome(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebLogFile(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemWebLogFollow(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebLogs(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemWebMetrics(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebNetwork(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebSecurity(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebSettings(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplSystemWebTrace(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 #  ifdef HAVE_GNUTLS
 extern void		_papplSystemWebTLSInstall(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebTLSNew(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
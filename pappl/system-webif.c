@@ -781,6 +781,99 @@ _papplSystemWebLogFile(
 }
 
 
+//
+// '_papplSystemWebLogFollow()' - Follow the system log.
+//
+// Log lines are sent as server-sent events, starting with the recent lines
+// that are still in memory.  The "level" form variable ("D", "I", "W", "E",
+// or "F") sets the minimum level of the lines that are sent.
+//
+
+void
+_papplSystemWebLogFollow(
+    pappl_client_t *client,		// I - Client
+    pappl_system_t *system)		// I - System
+{
+  int		num_form;		// Number of form variables
+  cups_option_t	*form = NULL;		// Form variables
+  const char	*value;			// Form value
+  const char	*lptr;			// Level character
+  int		minlevel = 0;		// Minimum log level
+  size_t	pos = (size_t)-1,	// Position in log
+		bytes,			// Bytes of log lines
+		bufused;		// Bytes in output buffer
+  char		lines[8192],		// Log lines
+		*line,			// Current line
+		*next,			// Next line
+		buffer[16384];		// Output buffer
+  static const char *levels = "DIWEF";	// Log level characters
+
+
+  if (!papplClientHTMLAuthorize(client))
+    return;
+
+  num_form = papplClientGetForm(client, &form);
+  if ((value = cupsGetOption("level", num_form, form)) != NULL && *value && (lptr = strchr(levels, *value)) != NULL)
+    minlevel = (int)(lptr - levels);
+  cupsFreeOptions(num_form, form);
+
+  if (!_papplClientLoopBeginWait(client))
+  {
+    papplClientRespond(client, HTTP_STATUS_SERVICE_UNAVAILABLE, NULL, NULL, 0, 0);
+    return;
+  }
+
+  if (!papplClientRespond(client, HTTP_STATUS_OK, NULL, "text/event-stream", 0, 0))
+  {
+    _papplClientLoopEndWait(client);
+    return;
+  }
+
+  strlcpy(buffer, "retry: 5000\n\n", sizeof(buffer));
+  bufused = strlen(buffer);
+
+  while (!system->shutdown_time)
+  {
+    if (bufused > 0 && (httpWrite2(client->http, buffer, bufused) < 0 || httpFlushWrite(client->http) < 0))
+      break;
+
+    if ((bytes = _papplLogTailRead(system, &pos, lines, sizeof(lines), _PAPPL_NOTIFY_INTERVAL)) == 0)
+    {
+      // Send a comment so that idle connections are noticed...
+      strlcpy(buffer, ": keep-alive\n\n", sizeof(buffer));
+      bufused = strlen(buffer);
+      continue;
+    }
+
+    // Send the lines at or above the minimum level as a single event...
+    for (line = lines, bufused = 0; *line; line = next)
+    {
+      if ((next = strchr(line, '\n')) != NULL)
+        *next++ = '\0';
+      else
+        next = line + strlen(line);
+
+      // JSON lines start with '{"level":"L",'...
+      if ((lptr = strchr(levels, *line == '{' ? line[10] : *line)) == NULL || (lptr - levels) < minlevel)
+        continue;
+
+      snprintf(buffer + bufused, sizeof(buffer) - bufused, "data: %s\n", line);
+      bufused += strlen(buffer + bufused);
+    }
+
+    if (bufused > 0 && bufused < (sizeof(buffer) - 1))
+    {
+      buffer[bufused ++] = '\n';
+      buffer[bufused]    = '\0';
+    }
+  }
+
+  httpWrite2(client->http, "", 0);
+
+  _papplClientLoopEndWait(client);
+}
+
+
 //
 // '_papplSystemWebLogs()' - Show the system logs
 //
@@ -868,11 +961,34 @@ _papplSystemWebLogs(
   papplClientHTMLPuts(client,
 		      "             </select> <input type=\"submit\" value=\"Change Log Level\"></td></tr>\n"
 		      "              <tr><th>Log File:</label></th><td><a class=\"btn\" href=\"/logfile.txt\">Download Log File</a></td></tr>\n"
+		      "              <tr><th><label for=\"view_level\">Show:</label></th><td><select id=\"view_level\" onchange=\"follow_log();\">\n");
+
+  for (i = PAPPL_LOGLEVEL_DEBUG; i <= PAPPL_LOGLEVEL_FATAL; i ++)
+  {
+    papplClientHTMLPrintf(client, "               <option value=\"%c\"%s>%s</option>\n", "DIWEF"[i - PAPPL_LOGLEVEL_DEBUG], i == loglevel ? " selected" : "", levels[i - PAPPL_LOGLEVEL_DEBUG]);
+  }
+
+  papplClientHTMLPuts(client,
+		      "             </select></td></tr>\n"
 		      "            </tbody>\n"
 		      "          </table>\n"
 		      "        </form>\n"
 		      "        <div class=\"log\" id=\"logdiv\"><pre id=\"log\"></pre></div>\n"
 		      "        <script>\n"
+		      "var log_source = null;\n"
+		      "function follow_log() {\n"
+		      "  var log = document.getElementById('log');\n"
+		      "  var logdiv = document.getElementById('logdiv');\n"
+		      "  if (log_source) log_source.close();\n"
+		      "  log_source = new EventSource('/logs/follow?level=' + document.getElementById('view_level').value);\n"
+		      "  log_source.onopen = function() { log.innerText = ''; };\n"
+		      "  log_source.onmessage = function(e) {\n"
+		      "    var atend = logdiv.scrollTop >= logdiv.scrollHeight - logdiv.clientHeight - 4;\n"
+		      "    log.appendChild(document.createTextNode(e.data + '\\n'));\n"
+		      "    while (log.childNodes.length > 1000) log.removeChild(log.firstChild);\n"
+		      "    if (atend) logdiv.scrollTop = logdiv.scrollHeight - logdiv.clientHeight;\n"
+		      "  };\n"
+		      "}\n"
 		      "var content_length = 0;\n"
 		      "function update_log() {\n"
 		      "  let xhr = new XMLHttpRequest();\n"
@@ -895,7 +1011,7 @@ _papplSystemWebLogs(
 		      "    logdiv.scrollTop = logdiv.scrollHeight - logdiv.clientHeight;\n"
 		      "  }\n"
 		      "}\n"
-		      "update_log();</script>\n");
+		      "if (window.EventSource) follow_log(); else update_log();</script>\n");
 
   system_footer(client);
 }
@@ -1601,6 +1717,7 @@ _papplSystemWebWiFi(
   int		i,			// Looping var
 		num_ssids;		// Number of Wi-Fi networks
   cups_dest_t	*ssids;			// Wi-Fi networks
+  bool		scanning;		// Is a Wi-Fi scan running?
   const char	*status = NULL;		// Status message, if any
 
 
@@ -1649,19 +1766,40 @@ _papplSystemWebWiFi(
 		      "            <tbody>\n"
 		      "              <tr><th><label for=\"ssid\">Network:</label></th><td><select name=\"ssid\"><option value=\"\">Choose</option>");
 
-  num_ssids = (system->wifi_list_cb)(system, system->wifi_cbdata, &ssids);
+  // Show the results of the last scan, starting a new scan in the background
+  // as needed.  Reloads while a scan is running don't start another scan...
+  if (client->options && !strcmp(client->options, "rescan"))
+    _papplSystemStartWiFiScan(system);
+
+  num_ssids = _papplSystemCopyWiFiList(system, &ssids, !client->options || strcmp(client->options, "scanning"), &scanning);
   for (i = 0; i < num_ssids; i ++)
     papplClientHTMLPrintf(client, "<option%s>%s</option>", ssids[i].is_default ? " selected" : "", ssids[i].name);
   cupsFreeDests(num_ssids, ssids);
 
+  if (num_ssids == 0 && scanning)
+    papplClientHTMLPuts(client, "<option disabled>Scanning...</option>");
+
   papplClientHTMLPuts(client,
-                      "</select> <a class=\"btn\" href=\"/network-wifi\">Rescan</a></td></tr>\n"
-                      "              <tr><th><label for=\"psk\">Password:</label></th><td><input type=\"password\" name=\"psk\"></td></tr>\n"
+                      "</select> <a class=\"btn\" href=\"/network-wifi?rescan\">Rescan</a></td></tr>\n"
+                      "              <tr><th><label for=\"psk\">Password:</label></th><td><input type=\"password\" name=\"psk\" id=\"psk\"></td></tr>\n"
                       "              <tr><th></th><td><input type=\"submit\" value=\"Join Wi-Fi Network\"></td></tr>\n"
                       "            </tbody>\n"
                       "          </table>\n"
                       "        </form>\n");
 
+  if (scanning)
+  {
+    // Reload the page once the scan is done, unless a password is being
+    // typed...
+    papplClientHTMLPuts(client,
+                        "        <script>\n"
+                        "window.setTimeout(function() {\n"
+                        "  if (document.getElementById('psk').value == '')\n"
+                        "    window.location.replace('/network-wifi?scanning');\n"
+                        "}, 3000);\n"
+                        "        </script>\n");
+  }
+
   system_footer(client);
 }
 
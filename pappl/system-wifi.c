@@ -0,0 +1,246 @@
+//
+// Wi-Fi scan cache for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static void	*run_wifi_scan(pappl_system_t *system);
+static void	start_wifi_scan(pappl_system_t *system);
+
+
+//
+// '_papplSystemCopyWiFiList()' - Copy the results of the last Wi-Fi scan.
+//
+// This function copies the Wi-Fi networks found by the last scan so that a
+// page can be rendered without waiting for the Wi-Fi interface.  When "refresh"
+// is `true`, a new scan is started in the background if the results are older
+// than the maximum age.  Only one scan runs at a time, so concurrent requests
+// share its results.
+//
+// The "scanning" argument is set to `true` when a scan is running.  Free the
+// networks using `cupsFreeDests`.
+//
+
+int					// O - Number of Wi-Fi networks
+_papplSystemCopyWiFiList(
+    pappl_system_t *system,		// I - System
+    cups_dest_t    **ssids,		// O - Wi-Fi networks
+    bool           refresh,		// I - Start a new scan if results are stale?
+    bool           *scanning)		// O - `true` if a scan is running
+{
+  int		num_ssids = 0;		// Number of Wi-Fi networks
+  cups_dest_t	*src,			// Source network
+		*dst;			// Destination network
+  int		i;			// Looping var
+
+
+  *ssids = NULL;
+
+  pthread_mutex_lock(&system->wifi_mutex);
+
+  if (refresh && (!system->wifi_time || (time(NULL) - system->wifi_time) >= system->wifi_max_age))
+    start_wifi_scan(system);
+
+  // Copy the networks in the order reported by the list callback...
+  if (system->wifi_num_ssids > 0 && (*ssids = calloc((size_t)system->wifi_num_ssids, sizeof(cups_dest_t))) != NULL)
+  {
+    for (src = system->wifi_ssids, dst = *ssids; num_ssids < system->wifi_num_ssids; num_ssids ++, src ++, dst ++)
+    {
+      if ((dst->name = strdup(src->name)) == NULL)
+        break;
+
+      dst->is_default = src->is_default;
+
+      for (i = 0; i < src->num_options; i ++)
+        dst->num_options = cupsAddOption(src->options[i].name, src->options[i].value, dst->num_options, &dst->options);
+    }
+  }
+
+  *scanning = system->wifi_scanning;
+
+  pthread_mutex_unlock(&system->wifi_mutex);
+
+  return (num_ssids);
+}
+
+
+//
+// '_papplSystemStartWiFiScan()' - Start a Wi-Fi scan in the background.
+//
+// This function starts a scan unless one is already running.
+//
+
+void
+_papplSystemStartWiFiScan(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->wifi_mutex);
+  start_wifi_scan(system);
+  pthread_mutex_unlock(&system->wifi_mutex);
+}
+
+
+//
+// '_papplSystemStopWiFiScan()' - Wait for a Wi-Fi scan and free the results.
+//
+
+void
+_papplSystemStopWiFiScan(
+    pappl_system_t *system)		// I - System
+{
+  pthread_mutex_lock(&system->wifi_mutex);
+
+  while (system->wifi_scanning)
+    pthread_cond_wait(&system->wifi_cond, &system->wifi_mutex);
+
+  cupsFreeDests(system->wifi_num_ssids, system->wifi_ssids);
+
+  system->wifi_num_ssids = 0;
+  system->wifi_ssids     = NULL;
+  system->wifi_time      = 0;
+
+  pthread_mutex_unlock(&system->wifi_mutex);
+}
+
+
+//
+// 'papplSystemGetMaxWiFiScanAge()' - Get the maximum age of Wi-Fi scan results.
+//
+// This function returns the number of seconds that the results of a Wi-Fi scan
+// are shown in the web interface before a new scan is started.
+//
+// The default is `60` seconds.
+//
+// @since PAPPL 1.1@
+//
+
+int					// O - Maximum age in seconds
+papplSystemGetMaxWiFiScanAge(
+    pappl_system_t *system)		// I - System
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    pthread_mutex_lock(&system->wifi_mutex);
+    ret = system->wifi_max_age;
+    pthread_mutex_unlock(&system->wifi_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemSetMaxWiFiScanAge()' - Set the maximum age of Wi-Fi scan results.
+//
+// This function sets the number of seconds that the results of a Wi-Fi scan
+// are shown in the web interface before a new scan is started.  Scans are run
+// in the background using the list callback set with
+// @link papplSystemSetWiFiCallbacks@, and the web interface shows the previous
+// results until the new scan completes.  A value of `0` starts a new scan every
+// time the Wi-Fi page is shown.
+//
+// The default is `60` seconds.
+//
+// @since PAPPL 1.1@
+//
+
+void
+papplSystemSetMaxWiFiScanAge(
+    pappl_system_t *system,		// I - System
+    int            max_age)		// I - Maximum age in seconds
+{
+  if (system && max_age >= 0)
+  {
+    pthread_mutex_lock(&system->wifi_mutex);
+    system->wifi_max_age = max_age;
+    pthread_mutex_unlock(&system->wifi_mutex);
+  }
+}
+
+
+//
+// 'run_wifi_scan()' - Scan for Wi-Fi networks.
+//
+
+static void *				// O - Thread exit status
+run_wifi_scan(pappl_system_t *system)	// I - System
+{
+  int		num_ssids,		// Number of Wi-Fi networks
+		old_num_ssids;		// Number of previous networks
+  cups_dest_t	*ssids = NULL,		// Wi-Fi networks
+		*old_ssids;		// Previous networks
+  struct timeval start,			// Start time
+		end;			// End time
+
+
+  gettimeofday(&start, NULL);
+
+  if ((num_ssids = (system->wifi_list_cb)(system, system->wifi_cbdata, &ssids)) < 0)
+    num_ssids = 0;
+
+  gettimeofday(&end, NULL);
+
+  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Found %d Wi-Fi network(s) in %.3f seconds.", num_ssids, end.tv_sec - start.tv_sec + 0.000001 * (end.tv_usec - start.tv_usec));
+
+  // Replace the previous results...
+  pthread_mutex_lock(&system->wifi_mutex);
+
+  old_num_ssids = system->wifi_num_ssids;
+  old_ssids     = system->wifi_ssids;
+
+  system->wifi_num_ssids = num_ssids;
+  system->wifi_ssids     = ssids;
+  system->wifi_time      = time(NULL);
+  system->wifi_scanning  = false;
+
+  pthread_cond_broadcast(&system->wifi_cond);
+  pthread_mutex_unlock(&system->wifi_mutex);
+
+  cupsFreeDests(old_num_ssids, old_ssids);
+
+  return (NULL);
+}
+
+
+//
+// 'start_wifi_scan()' - Start a Wi-Fi scan thread.
+//
+// The caller must hold the Wi-Fi mutex.
+//
+
+static void
+start_wifi_scan(pappl_system_t *system)	// I - System
+{
+  pthread_t	tid;			// Thread ID
+
+
+  if (system->wifi_scanning || !system->wifi_list_cb)
+    return;
+
+  if (pthread_create(&tid, NULL, (void *(*)(void *))run_wifi_scan, system))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create Wi-Fi scan thread: %s", strerror(errno));
+  }
+  else
+  {
+    pthread_detach(tid);
+    system->wifi_scanning = true;
+  }
+}
@@ -23,15 +23,53 @@
 
 static time_t	sigterm_time = 0;	// SIGTERM time?
 static bool	restart_logging = false;// Restart logging?
+static int	wakeup_fd = -1;		// Housekeeping wakeup pipe for signals
+
+
+//
+// Local types...
+//
+
+#define _PAPPL_MAX_STARTUP_THREADS 8	// Maximum number of startup threads
+#define _PAPPL_HOUSEKEEPING_MAX	60	// Maximum seconds between housekeeping runs
+#define _PAPPL_DNSSD_BATCH	16	// Maximum printers re-registered per housekeeping run
+
+typedef struct _pappl_startup_s		// Printer startup work queue
+{
+  pappl_system_t	*system;	// System
+  int			*ids,		// Printer IDs
+			num_ids,	// Number of printer IDs
+			next_id;	// Next printer ID index
+  int			num_threads;	// Number of startup threads
+  pthread_t		threads[_PAPPL_MAX_STARTUP_THREADS];
+					// Startup threads
+} _pappl_startup_t;
+
+typedef struct _pappl_acceptor_s	// Acceptor thread
+{
+  pappl_system_t	*system;	// System
+  int			shard;		// Listener shard
+  pthread_t		thread_id;	// Thread ID
+  bool			running;	// Is the thread running?
+  int			num_fds;	// Number of listener sockets
+  struct pollfd		fds[_PAPPL_MAX_LISTENERS];
+					// Listener sockets
+} _pappl_acceptor_t;
 
 
 //
 // Local functions...
 //
 
+static bool	accept_clients(pappl_system_t *system, int shard, struct pollfd *fds, int num_fds, bool *at_limit);
 static void	make_attributes(pappl_system_t *system);
+static void	*run_acceptor(_pappl_acceptor_t *acceptor);
+static void	*run_printer_startup(_pappl_startup_t *startup);
+static void	*run_save_thread(pappl_system_t *system);
+static void	start_printer(pappl_system_t *system, int printer_id);
 static void	sighup_handler(int sig);
 static void	sigterm_handler(int sig);
+static void	wait_housekeeping(pappl_system_t *system, time_t next);
 
 
 //
@@ -90,10 +128,16 @@ _papplSystemConfigChanged(
   if (system->is_running)
   {
     system->config_time = time(NULL);
+
+    if (system->config_changes == system->save_changes)
+      system->change_time = system->config_time;
+
     system->config_changes ++;
   }
 
   pthread_mutex_unlock(&system->config_mutex);
+
+  _papplSystemWakeup(system);
 }
 
 
@@ -106,9 +150,22 @@ _papplSystemConfigChanged(
 // The "options" argument specifies which options are enabled for the server:
 //
 // - `PAPPL_SOPTIONS_NONE`: No options.
+// - `PAPPL_SOPTIONS_ASYNC_LOG`: Queue log messages in memory and write them
+//   from a background thread so that logging never blocks on file I/O.
 // - `PAPPL_SOPTIONS_DNSSD_HOST`: When resolving DNS-SD service name collisions,
 //   use the DNS-SD hostname instead of a serial number or UUID.
+// - `PAPPL_SOPTIONS_EVENT_LOOP`: Watch idle keep-alive connections from a
+//   single event loop thread (epoll, kqueue, or poll) and process requests
+//   using a bounded pool of worker threads, instead of using a thread per
+//   connection.
+// - `PAPPL_SOPTIONS_LOG_JSON`: Write log messages as JSON objects, one per
+//   line, with separate "level", "time", "printer", "job", "client", and
+//   "message" fields.
 // - `PAPPL_SOPTIONS_WEB_LOG`: Include the log file web page.
+// - `PAPPL_SOPTIONS_WEB_METRICS`: Include the "/metrics" page, which reports
+//   client, IPP, job, and device metrics in the Prometheus text format, and
+//   the "/trace.json" page, which reports the job trace spans recorded while
+//   @link papplSystemSetTracing@ is enabled.
 // - `PAPPL_SOPTIONS_MULTI_QUEUE`: Support multiple printers.
 // - `PAPPL_SOPTIONS_WEB_NETWORK`: Include the network settings web page.
 // - `PAPPL_SOPTIONS_RAW_SOCKET`: Accept jobs via raw sockets starting on port
@@ -173,28 +230,71 @@ papplSystemCreate(
 
   // Initialize values...
   pthread_rwlock_init(&system->rwlock, NULL);
+  pthread_rwlock_init(&system->printers_rwlock, NULL);
+  pthread_rwlock_init(&system->resource_rwlock, NULL);
+  pthread_rwlock_init(&system->filter_rwlock, NULL);
   pthread_rwlock_init(&system->session_rwlock, NULL);
   pthread_mutex_init(&system->config_mutex, NULL);
+  pthread_cond_init(&system->save_cond, NULL);
+  pthread_mutex_init(&system->auth_mutex, NULL);
+  pthread_mutex_init(&system->client_hosts_mutex, NULL);
+  pthread_mutex_init(&system->loc_mutex, NULL);
+  pthread_mutex_init(&system->templates_mutex, NULL);
+  pthread_mutex_init(&system->journal_mutex, NULL);
+  pthread_mutex_init(&system->job_mutex, NULL);
+  pthread_cond_init(&system->job_cond, NULL);
+  pthread_mutex_init(&system->subscription_mutex, NULL);
+  pthread_mutex_init(&system->trace_mutex, NULL);
+  pthread_cond_init(&system->subscription_cond, NULL);
+  pthread_mutex_init(&system->logtail_mutex, NULL);
+  pthread_cond_init(&system->logtail_cond, NULL);
+  pthread_mutex_init(&system->wifi_mutex, NULL);
+  pthread_cond_init(&system->wifi_cond, NULL);
+  pthread_mutex_init(&system->status_mutex, NULL);
+  pthread_cond_init(&system->status_cond, NULL);
+
+  system->options           = options;
+  system->start_time        = time(NULL);
+  system->name              = strdup(name);
+  system->dns_sd_name       = strdup(name);
+  system->port              = port;
+  system->directory         = spooldir ? strdup(spooldir) : NULL;
+  system->logfd             = -1;
+  system->journal_fd        = -1;
+  system->wakefds[0]        = -1;
+  system->wakefds[1]        = -1;
+  system->logfile           = logfile ? strdup(logfile) : NULL;
+  system->loglevel          = loglevel;
+  system->logmaxsize        = 1024 * 1024;
+  system->next_client       = 1;
+  system->next_printer_id   = 1;
+  system->subtypes          = subtypes ? strdup(subtypes) : NULL;
+  system->tls_only          = tls_only;
+  system->admin_gid         = (gid_t)-1;
+  system->auth_cache_time   = 60;
+  system->save_delay        = 1;
+  system->max_image_threads = 1;
+  system->accept_threads    = 1;
+  system->wifi_max_age      = 60;
+  system->auth_service      = auth_service ? strdup(auth_service) : NULL;
+  system->job_queue         = cupsArrayNew(NULL, NULL);
+
+  if (!system->name || !system->dns_sd_name || !system->job_queue || (spooldir && !system->directory) || (logfile && !system->logfile) || (subtypes && !system->subtypes) || (auth_service && !system->auth_service))
+    goto fatal;
 
-  system->options         = options;
-  system->start_time      = time(NULL);
-  system->name            = strdup(name);
-  system->dns_sd_name     = strdup(name);
-  system->port            = port;
-  system->directory       = spooldir ? strdup(spooldir) : NULL;
-  system->logfd           = -1;
-  system->logfile         = logfile ? strdup(logfile) : NULL;
-  system->loglevel        = loglevel;
-  system->logmaxsize      = 1024 * 1024;
-  system->next_client     = 1;
-  system->next_printer_id = 1;
-  system->subtypes        = subtypes ? strdup(subtypes) : NULL;
-  system->tls_only        = tls_only;
-  system->admin_gid       = (gid_t)-1;
-  system->auth_service    = auth_service ? strdup(auth_service) : NULL;
-
-  if (!system->name || !system->dns_sd_name || (spooldir && !system->directory) || (logfile && !system->logfile) || (subtypes && !system->subtypes) || (auth_service && !system->auth_service))
+#if !_WIN32
+  // Create the pipe used to wake up the housekeeping loop...
+  if (pipe(system->wakefds))
+  {
+    system->wakefds[0] = system->wakefds[1] = -1;
     goto fatal;
+  }
+
+  fcntl(system->wakefds[0], F_SETFL, fcntl(system->wakefds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(system->wakefds[1], F_SETFL, fcntl(system->wakefds[1], F_GETFL) | O_NONBLOCK);
+  fcntl(system->wakefds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(system->wakefds[1], F_SETFD, FD_CLOEXEC);
+#endif // !_WIN32
 
   // Make sure the system name and UUID are initialized...
   papplSystemSetHostname(system, NULL);
@@ -280,8 +380,23 @@ papplSystemDelete(
 
   _papplSystemUnregisterDNSSDNoLock(system);
 
+  _papplSystemStopJobThreads(system);
+  _papplSystemStopWiFiScan(system);
+
+  // Wait for any printer status updates, which hold printer references and
+  // wake up the system when they finish...
+  pthread_mutex_lock(&system->status_mutex);
+  while (system->num_status_threads > 0)
+    pthread_cond_wait(&system->status_cond, &system->status_mutex);
+  pthread_mutex_unlock(&system->status_mutex);
+
   cupsArrayDelete(system->printers);
 
+  _papplDNSSDShutdown(system);
+
+  // Stop the log writer once nothing else can log...
+  _papplLogStop(system);
+
   free(system->uuid);
   free(system->name);
   free(system->dns_sd_name);
@@ -295,9 +410,16 @@ papplSystemDelete(
   free(system->admin_group);
   free(system->default_print_group);
 
+  _papplSystemClearAuthCache(system);
+
   if (system->logfd >= 0 && system->logfd != 2)
     close(system->logfd);
 
+  if (system->wakefds[0] >= 0)
+    close(system->wakefds[0]);
+  if (system->wakefds[1] >= 0)
+    close(system->wakefds[1]);
+
   for (i = 0; i < system->num_listeners; i ++)
 #if _WIN32
     closesocket(system->listeners[i].fd);
@@ -306,12 +428,45 @@ papplSystemDelete(
 #endif // _WIN32
 
   cupsArrayDelete(system->filters);
+  cupsArrayDelete(system->templates);
   cupsArrayDelete(system->links);
-  cupsArrayDelete(system->resources);
+  cupsArrayDelete(system->client_hosts);
+  _papplSystemDeleteResources(system);
+  _papplLocDeleteAll(system);
 
   pthread_rwlock_destroy(&system->rwlock);
+  pthread_rwlock_destroy(&system->printers_rwlock);
+  pthread_rwlock_destroy(&system->resource_rwlock);
+  pthread_rwlock_destroy(&system->filter_rwlock);
   pthread_rwlock_destroy(&system->session_rwlock);
   pthread_mutex_destroy(&system->config_mutex);
+  pthread_cond_destroy(&system->save_cond);
+  pthread_mutex_destroy(&system->auth_mutex);
+  pthread_mutex_destroy(&system->client_hosts_mutex);
+  pthread_mutex_destroy(&system->loc_mutex);
+  pthread_mutex_destroy(&system->templates_mutex);
+
+  if (system->journal_fd >= 0)
+    close(system->journal_fd);
+  free(system->journal_file);
+  pthread_mutex_destroy(&system->journal_mutex);
+
+  cupsArrayDelete(system->job_queue);
+  pthread_mutex_destroy(&system->job_mutex);
+  pthread_cond_destroy(&system->job_cond);
+
+  _papplSystemCleanSubscriptions(system, true);
+  pthread_mutex_destroy(&system->subscription_mutex);
+  pthread_cond_destroy(&system->subscription_cond);
+  pthread_mutex_destroy(&system->trace_mutex);
+  free(system->traces);
+  pthread_mutex_destroy(&system->logtail_mutex);
+  pthread_cond_destroy(&system->logtail_cond);
+  free(system->logtail);
+  pthread_mutex_destroy(&system->wifi_mutex);
+  pthread_cond_destroy(&system->wifi_cond);
+  pthread_mutex_destroy(&system->status_mutex);
+  pthread_cond_destroy(&system->status_cond);
 
   free(system);
 }
@@ -368,13 +523,20 @@ void
 papplSystemRun(pappl_system_t *system)	// I - System
 {
   int			i,		// Looping var
-			count;		// Number of listeners that fired
-  pappl_client_t	*client;	// New client
+			count;		// Number of printers
   char			header[HTTP_MAX_VALUE];
 					// Server: header value
   int			dns_sd_host_changes;
 					// Current number of host name changes
   pappl_printer_t	*printer;	// Current printer
+  bool			at_limit = false;
+					// At the connection limit?
+  _pappl_startup_t	startup;	// Printer startup work queue
+  _pappl_acceptor_t	*acceptors;	// Acceptor threads
+  int			num_acceptors = 0;
+					// Number of running acceptor threads
+  time_t		next = 0,	// Time of next housekeeping run
+			timer;		// Time for current timer
 
 
   // Range check...
@@ -404,9 +566,16 @@ papplSystemRun(pappl_system_t *system)	// I - System
   {
     papplSystemAddResourceCallback(system, "/logfile.txt", "text/plain", (pappl_resource_cb_t)_papplSystemWebLogFile, system);
     papplSystemAddResourceCallback(system, "/logs", "text/html", (pappl_resource_cb_t)_papplSystemWebLogs, system);
+    papplSystemAddResourceCallback(system, "/logs/follow", "text/event-stream", (pappl_resource_cb_t)_papplSystemWebLogFollow, system);
     papplSystemAddLink(system, "View Logs", "/logs", PAPPL_LOPTIONS_LOGGING | PAPPL_LOPTIONS_HTTPS_REQUIRED);
   }
 
+  if (system->options & PAPPL_SOPTIONS_WEB_METRICS)
+  {
+    papplSystemAddResourceCallback(system, "/metrics", "text/plain", (pappl_resource_cb_t)_papplSystemWebMetrics, system);
+    papplSystemAddResourceCallback(system, "/trace.json", "application/json", (pappl_resource_cb_t)_papplSystemWebTrace, system);
+  }
+
   if (system->options & PAPPL_SOPTIONS_WEB_INTERFACE)
   {
     if (system->options & PAPPL_SOPTIONS_MULTI_QUEUE)
@@ -422,7 +591,12 @@ papplSystemRun(pappl_system_t *system)	// I - System
       papplSystemAddResourceCallback(system, "/network", "text/html", (pappl_resource_cb_t)_papplSystemWebNetwork, system);
       papplSystemAddLink(system, "Network", "/network", PAPPL_LOPTIONS_OTHER | PAPPL_LOPTIONS_HTTPS_REQUIRED);
       if (system->wifi_join_cb && system->wifi_list_cb && system->wifi_status_cb)
+      {
         papplSystemAddResourceCallback(system, "/network-wifi", "text/html", (pappl_resource_cb_t)_papplSystemWebWiFi, system);
+
+        // Scan for Wi-Fi networks now so the first page view doesn't wait...
+        _papplSystemStartWiFiScan(system);
+      }
     }
     if (system->options & PAPPL_SOPTIONS_WEB_SECURITY)
     {
@@ -446,6 +620,8 @@ papplSystemRun(pappl_system_t *system)	// I - System
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Starting system.");
 
 #if !_WIN32
+  wakeup_fd = system->wakefds[1];
+
   signal(SIGTERM, sigterm_handler);
   signal(SIGINT, sigterm_handler);
   signal(SIGHUP, sighup_handler);
@@ -491,31 +667,33 @@ papplSystemRun(pappl_system_t *system)	// I - System
   if (system->dns_sd_name)
     _papplSystemRegisterDNSSDNoLock(system);
 
-  // Start up printers...
-  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
+  // Start up printers from a small pool of threads so that the driver
+  // attributes needed for DNS-SD are built in parallel while the main loop
+  // starts accepting connections...
+  memset(&startup, 0, sizeof(startup));
+  startup.system = system;
+
+  pthread_rwlock_rdlock(&system->printers_rwlock);
+  if ((count = cupsArrayCount(system->printers)) > 0 && (startup.ids = calloc((size_t)count, sizeof(int))) != NULL)
   {
-    printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
+    for (printer = (pappl_printer_t *)cupsArrayFirst(system->printers); printer; printer = (pappl_printer_t *)cupsArrayNext(system->printers))
+      startup.ids[startup.num_ids ++] = printer->printer_id;
+  }
+  pthread_rwlock_unlock(&system->printers_rwlock);
 
-    // Advertise via DNS-SD as needed...
-    if (printer->dns_sd_name)
-      _papplPrinterRegisterDNSSDNoLock(printer);
+  for (i = 0; i < startup.num_ids && i < _PAPPL_MAX_STARTUP_THREADS; i ++)
+  {
+    if (pthread_create(startup.threads + i, NULL, (void *(*)(void *))run_printer_startup, &startup))
+      break;
 
-    // Start the raw socket listeners as needed...
-    if ((system->options & PAPPL_SOPTIONS_RAW_SOCKET) && printer->num_raw_listeners > 0)
-    {
-      pthread_t	tid;		// Thread ID
+    startup.num_threads ++;
+  }
 
-      if (pthread_create(&tid, NULL, (void *(*)(void *))_papplPrinterRunRaw, printer))
-      {
-	// Unable to create listener thread...
-	papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to create raw listener thread: %s", strerror(errno));
-      }
-      else
-      {
-	// Detach the main thread from the raw thread to prevent hangs...
-	pthread_detach(tid);
-      }
-    }
+  if (i == 0)
+  {
+    // Unable to create any startup threads, start the printers here...
+    for (i = 0; i < startup.num_ids; i ++)
+      start_printer(system, startup.ids[i]);
   }
 
   // Start the USB gadget as needed...
@@ -535,46 +713,97 @@ papplSystemRun(pappl_system_t *system)	// I - System
     }
   }
 
-  // Loop until we are shutdown or have a hard error...
-  for (;;)
+  // Start the log writer thread as needed...
+  if ((system->options & PAPPL_SOPTIONS_ASYNC_LOG) && !_papplLogStart(system))
+    papplLog(system, PAPPL_LOGLEVEL_WARN, "Writing log messages synchronously.");
+
+  // Start the client event loop as needed...
+  if ((system->options & PAPPL_SOPTIONS_EVENT_LOOP) && !_papplClientLoopStart(system))
+    papplLog(system, PAPPL_LOGLEVEL_WARN, "Using a thread for each client connection.");
+
+  // Start the acceptor threads, each polling its shard of the listeners, so
+  // that new connections are not delayed by the housekeeping below...
+  system->accept_stop = 0;
+
+  if ((acceptors = calloc((size_t)system->accept_threads, sizeof(_pappl_acceptor_t))) != NULL)
   {
-    if (restart_logging)
+    for (i = 0; i < system->num_listeners; i ++)
     {
-      restart_logging = false;
-      _papplLogOpen(system);
+      _pappl_acceptor_t *acceptor = acceptors + system->listener_shards[i];
+					// Acceptor for this listener
+
+      acceptor->fds[acceptor->num_fds ++] = system->listeners[i];
     }
 
-    if ((count = poll(system->listeners, (nfds_t)system->num_listeners, 1000)) < 0 && errno != EINTR && errno != EAGAIN)
+    for (i = 0; i < system->accept_threads; i ++)
     {
-      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
-      break;
+      if (acceptors[i].num_fds == 0)
+        continue;
+
+      acceptors[i].system = system;
+      acceptors[i].shard  = i;
+
+      if (pthread_create(&acceptors[i].thread_id, NULL, (void *(*)(void *))run_acceptor, acceptors + i))
+      {
+        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create acceptor thread: %s", strerror(errno));
+        break;
+      }
+
+      acceptors[i].running = true;
+      num_acceptors ++;
     }
 
-    if (count > 0)
+    if (i < system->accept_threads)
     {
-      // Accept client connections as needed...
-      for (i = 0; i < system->num_listeners; i ++)
+      // Stop any acceptor threads and accept connections from this thread...
+      _PAPPL_ATOMIC_SET(&system->accept_stop, 1);
+
+      for (i = 0; i < system->accept_threads; i ++)
       {
-	if (system->listeners[i].revents & POLLIN)
-	{
-	  if ((client = _papplClientCreate(system, (int)system->listeners[i].fd)) != NULL)
-	  {
-	    if (pthread_create(&client->thread_id, NULL, (void *(*)(void *))_papplClientRun, client))
-	    {
-	      // Unable to create client thread...
-	      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create client thread: %s", strerror(errno));
-	      _papplClientDelete(client);
-	    }
-	    else
-	    {
-	      // Detach the main thread from the client thread to prevent hangs...
-	      pthread_detach(client->thread_id);
-	    }
-	  }
-	}
+        if (acceptors[i].running)
+          pthread_join(acceptors[i].thread_id, NULL);
+
+        acceptors[i].running = false;
       }
+
+      num_acceptors       = 0;
+      system->accept_stop = 0;
+    }
+  }
+
+  if (num_acceptors > 0)
+    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Accepting connections using %d thread(s).", num_acceptors);
+
+  // Loop until we are shutdown or have a hard error...
+  for (;;)
+  {
+    if (num_acceptors > 0)
+    {
+      // Sleep until the next timer expires or something wakes us up, stopping
+      // if an acceptor thread failed...
+      if (_PAPPL_ATOMIC_GET(&system->accept_stop))
+        break;
+
+      wait_housekeeping(system, next);
+
+      if (_PAPPL_ATOMIC_GET(&system->accept_stop))
+        break;
+    }
+    else if (!accept_clients(system, 0, system->listeners, system->num_listeners, &at_limit))
+    {
+      break;
+    }
+
+    if (restart_logging)
+    {
+      restart_logging = false;
+      _papplLogOpen(system);
     }
 
+    // Host name changes are not reported to the loop, so check for them at
+    // least every _PAPPL_HOUSEKEEPING_MAX seconds...
+    next = time(NULL) + _PAPPL_HOUSEKEEPING_MAX;
+
     dns_sd_host_changes = _papplDNSSDGetHostChanges();
 
     if (system->dns_sd_any_collision || system->dns_sd_host_changes != dns_sd_host_changes)
@@ -582,40 +811,94 @@ papplSystemRun(pappl_system_t *system)	// I - System
       // Handle name collisions...
       bool		force_dns_sd = system->dns_sd_host_changes != dns_sd_host_changes;
 					// Force re-registration?
+      int		batch = 0;	// Number of printers re-registered
 
       if (force_dns_sd)
         papplSystemSetHostname(system, NULL);
 
+      pthread_rwlock_rdlock(&system->printers_rwlock);
       pthread_rwlock_rdlock(&system->rwlock);
 
       if (system->dns_sd_collision || force_dns_sd)
         _papplSystemRegisterDNSSDNoLock(system);
 
+      system->dns_sd_any_collision = false;
+      system->dns_sd_host_changes  = dns_sd_host_changes;
+
+      // Re-register the printers a batch at a time so that a host name change
+      // with many printers doesn't flood the network...
       for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
       {
 	printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
 
-        if (printer->dns_sd_collision || force_dns_sd)
-          _papplPrinterRegisterDNSSDNoLock(printer);
-      }
+        if (force_dns_sd && printer->dns_sd_name)
+          printer->dns_sd_update = true;
 
-      system->dns_sd_any_collision = false;
-      system->dns_sd_host_changes  = dns_sd_host_changes;
+        if (!printer->dns_sd_collision && !printer->dns_sd_update)
+          continue;
+
+        if (batch >= _PAPPL_DNSSD_BATCH)
+        {
+          // Do the rest on the next run...
+          system->dns_sd_any_collision = true;
+          continue;
+        }
+
+	_papplPrinterRegisterDNSSDNoLock(printer);
+	batch ++;
+      }
 
       pthread_rwlock_unlock(&system->rwlock);
+      pthread_rwlock_unlock(&system->printers_rwlock);
+
+      if (system->dns_sd_any_collision)
+        next = time(NULL) + 1;
     }
 
-    if (system->config_changes > system->save_changes)
+    if (system->config_changes > system->save_changes && !system->save_active)
     {
+      // Save the configuration once changes have settled for the save delay,
+      // or after 10 times the delay during a steady stream of changes...
+      time_t	curtime = time(NULL);	// Current time
+      bool	save = false;		// Save now?
+      pthread_t	tid;			// Save thread ID
+
       pthread_mutex_lock(&system->config_mutex);
 
-      system->save_changes = system->config_changes;
+      if (curtime >= (system->config_time + system->save_delay) || curtime >= (system->change_time + 10 * system->save_delay))
+      {
+        system->save_changes = system->config_changes;
+        save                 = system->save_cb != NULL;
+      }
+      else
+      {
+        // Come back when the changes have settled...
+        if ((timer = system->config_time + system->save_delay) > system->change_time + 10 * system->save_delay)
+          timer = system->change_time + 10 * system->save_delay;
+
+        if (timer < next)
+          next = timer;
+      }
+
+      if (save)
+      {
+        if (pthread_create(&tid, NULL, (void *(*)(void *))run_save_thread, system))
+        {
+          papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create save thread: %s", strerror(errno));
+        }
+        else
+        {
+          pthread_detach(tid);
+          system->save_active = true;
+          save                = false;
+        }
+      }
 
       pthread_mutex_unlock(&system->config_mutex);
 
-      if (system->save_cb)
+      if (save)
       {
-        // Save the configuration...
+        // No save thread, save the configuration here...
 	(system->save_cb)(system, system->save_cbdata);
       }
     }
@@ -633,31 +916,89 @@ papplSystemRun(pappl_system_t *system)	// I - System
         break;				// SIGTERM received
 
       // Otherwise shutdown immediately if there are no more active jobs...
-      pthread_rwlock_rdlock(&system->rwlock);
+      pthread_rwlock_rdlock(&system->printers_rwlock);
       for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
       {
 	printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
 
         pthread_rwlock_rdlock(&printer->rwlock);
-        jcount += cupsArrayCount(printer->active_jobs);
+        jcount += printer->active_jobs.count;
         pthread_rwlock_unlock(&printer->rwlock);
       }
-      pthread_rwlock_unlock(&system->rwlock);
+      pthread_rwlock_unlock(&system->printers_rwlock);
 
       if (jcount == 0)
         break;
+
+      // Completed jobs wake us up, otherwise wait for the forced shutdown...
+      if ((timer = (system->shutdown_time ? system->shutdown_time : sigterm_time) + 61) < next)
+        next = timer;
     }
 
-    // Clean out old jobs...
+    // Clean out old jobs and expired subscriptions...
     if (system->clean_time && time(NULL) >= system->clean_time)
-      papplSystemCleanJobs(system);
+      _papplSystemCleanJobs(system);
+
+    if (system->clean_time && system->clean_time < next)
+      next = system->clean_time;
+
+    if (system->subscriptions && (timer = _papplSystemCleanSubscriptions(system, false)) != 0 && timer < next)
+      next = timer;
+
+    // Close idle device connections that have timed out and refresh the
+    // printer status...
+    pthread_rwlock_rdlock(&system->printers_rwlock);
+    for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
+    {
+      printer = (pappl_printer_t *)cupsArrayIndex(system->printers, i);
+
+      if ((timer = _papplPrinterCloseIdleDevice(printer)) != 0 && timer < next)
+        next = timer;
+
+      if ((timer = _papplPrinterCheckStatus(printer)) != 0 && timer < next)
+        next = timer;
+    }
+    pthread_rwlock_unlock(&system->printers_rwlock);
   }
 
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Shutting down system.");
 
+  // Stop the acceptor threads...
+  _PAPPL_ATOMIC_SET(&system->accept_stop, 1);
+
+  if (acceptors)
+  {
+    for (i = 0; i < system->accept_threads; i ++)
+    {
+      if (acceptors[i].running)
+        pthread_join(acceptors[i].thread_id, NULL);
+    }
+
+    free(acceptors);
+  }
+
+  // Wake up any clients that are waiting for events...
+  pthread_mutex_lock(&system->subscription_mutex);
+  if (!system->shutdown_time)
+    system->shutdown_time = time(NULL);
+  pthread_cond_broadcast(&system->subscription_cond);
+  pthread_mutex_unlock(&system->subscription_mutex);
+
+  pthread_mutex_lock(&system->logtail_mutex);
+  pthread_cond_broadcast(&system->logtail_cond);
+  pthread_mutex_unlock(&system->logtail_mutex);
+
+  _papplClientLoopStop(system);
+
   ippDelete(system->attrs);
   system->attrs = NULL;
 
+  // Wait for printer startup to finish...
+  for (i = 0; i < startup.num_threads; i ++)
+    pthread_join(startup.threads[i], NULL);
+
+  free(startup.ids);
+
   if (system->dns_sd_name)
     _papplSystemUnregisterDNSSDNoLock(system);
 
@@ -670,6 +1011,12 @@ papplSystemRun(pappl_system_t *system)	// I - System
       _papplPrinterUnregisterDNSSDNoLock(printer);
   }
 
+  // Wait for any background save to finish...
+  pthread_mutex_lock(&system->config_mutex);
+  while (system->save_active)
+    pthread_cond_wait(&system->save_cond, &system->config_mutex);
+  pthread_mutex_unlock(&system->config_mutex);
+
   if (system->save_changes < system->config_changes && system->save_cb)
   {
     // Save the configuration...
@@ -678,11 +1025,21 @@ papplSystemRun(pappl_system_t *system)	// I - System
 
   system->is_running = false;
 
+  // Wake up the socket print threads so they see the system has stopped...
+  pthread_rwlock_rdlock(&system->printers_rwlock);
+  for (i = 0, count = cupsArrayCount(system->printers); i < count; i ++)
+    _papplPrinterWakeup((pappl_printer_t *)cupsArrayIndex(system->printers, i));
+  pthread_rwlock_unlock(&system->printers_rwlock);
+
+  wakeup_fd = -1;
+
   if ((system->options & PAPPL_SOPTIONS_USB_PRINTER) && (printer = papplSystemFindPrinter(system, NULL, system->default_printer_id, NULL)) != NULL)
   {
     // Wait for the USB gadget thread(s) to complete...
+    pthread_mutex_lock(&printer->threads_mutex);
     while (printer->usb_active)
-      usleep(100000);
+      pthread_cond_wait(&printer->threads_cond, &printer->threads_mutex);
+    pthread_mutex_unlock(&printer->threads_mutex);
   }
 }
 
@@ -699,7 +1056,108 @@ papplSystemShutdown(
     pappl_system_t *system)		// I - System
 {
   if (system && !system->shutdown_time)
+  {
     system->shutdown_time = time(NULL);
+
+    _papplSystemWakeup(system);
+  }
+}
+
+
+//
+// '_papplSystemWakeup()' - Wake up the system's housekeeping loop.
+//
+// Call this function after changing anything that the housekeeping loop acts
+// on, such as the configuration, clean time, or printer timers, so that it
+// doesn't have to poll for them.
+//
+
+void
+_papplSystemWakeup(
+    pappl_system_t *system)		// I - System
+{
+  if (system->wakefds[1] >= 0 && write(system->wakefds[1], "", 1) < 0 && errno != EAGAIN)
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to wake up housekeeping loop: %s", strerror(errno));
+}
+
+
+//
+// 'accept_clients()' - Wait for and accept new client connections.
+//
+// Only the first shard logs when the connection limit is reached so that the
+// warning is not repeated by every acceptor thread.  Connections over the limit
+// are still accepted so that @code _papplClientCreate@ can reject them with a
+// "503 Service Unavailable" response instead of leaving them in the backlog.
+//
+
+static bool				// O - `true` to continue, `false` on a hard error
+accept_clients(
+    pappl_system_t *system,		// I - System
+    int            shard,		// I - Listener shard
+    struct pollfd  *fds,		// I - Listener sockets
+    int            num_fds,		// I - Number of listener sockets
+    bool           *at_limit)		// IO - At the connection limit?
+{
+  int			i,		// Looping var
+			count;		// Number of listeners that fired
+  pappl_client_t	*client;	// New client
+
+
+  // Note when we reach the connection limit...
+  pthread_rwlock_rdlock(&system->rwlock);
+  if (system->max_clients > 0 && system->num_clients >= system->max_clients)
+  {
+    if (!*at_limit && shard == 0)
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Reached limit of %d client connections.", system->max_clients);
+
+    *at_limit = true;
+  }
+  else
+  {
+    *at_limit = false;
+  }
+  pthread_rwlock_unlock(&system->rwlock);
+
+  for (i = 0; i < num_fds; i ++)
+    fds[i].events = POLLIN;
+
+  if ((count = poll(fds, (nfds_t)num_fds, 1000)) < 0 && errno != EINTR && errno != EAGAIN)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
+    return (false);
+  }
+
+  if (count > 0)
+  {
+    // Accept client connections as needed...
+    for (i = 0; i < num_fds; i ++)
+    {
+      if (fds[i].revents & POLLIN)
+      {
+	if ((client = _papplClientCreate(system, (int)fds[i].fd)) != NULL)
+	{
+	  if (system->client_loop)
+	  {
+	    // Wait for the first request from the event loop...
+	    _papplClientLoopAdd(client);
+	  }
+	  else if (pthread_create(&client->thread_id, NULL, (void *(*)(void *))_papplClientRun, client))
+	  {
+	    // Unable to create client thread...
+	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create client thread: %s", strerror(errno));
+	    _papplClientDelete(client);
+	  }
+	  else
+	  {
+	    // Detach the main thread from the client thread to prevent hangs...
+	    pthread_detach(client->thread_id);
+	  }
+	}
+      }
+    }
+  }
+
+  return (true);
 }
 
 
@@ -785,6 +1243,74 @@ make_attributes(pappl_system_t *system)	// I - System
 }
 
 
+//
+// 'run_acceptor()' - Accept client connections for a shard of the listeners.
+//
+
+static void *				// O - Thread exit status
+run_acceptor(
+    _pappl_acceptor_t *acceptor)	// I - Acceptor thread
+{
+  pappl_system_t	*system = acceptor->system;
+					// System
+  bool			at_limit = false;
+					// At the connection limit?
+
+
+  while (!_PAPPL_ATOMIC_GET(&system->accept_stop))
+  {
+    if (!accept_clients(system, acceptor->shard, acceptor->fds, acceptor->num_fds, &at_limit))
+    {
+      // Hard error, have the main loop shut down...
+      _PAPPL_ATOMIC_SET(&system->accept_stop, 1);
+      _papplSystemWakeup(system);
+      break;
+    }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'run_printer_startup()' - Start printers from the startup work queue.
+//
+
+static void *				// O - Thread exit status
+run_printer_startup(
+    _pappl_startup_t *startup)		// I - Startup work queue
+{
+  int	i;				// Printer ID index
+
+
+  while ((i = _PAPPL_ATOMIC_ADD(&startup->next_id, 1)) < startup->num_ids)
+    start_printer(startup->system, startup->ids[i]);
+
+  return (NULL);
+}
+
+
+//
+// 'run_save_thread()' - Save the system state in the background.
+//
+
+static void *				// O - Thread exit status
+run_save_thread(pappl_system_t *system)	// I - System
+{
+  (system->save_cb)(system, system->save_cbdata);
+
+  pthread_mutex_lock(&system->config_mutex);
+  system->save_active = false;
+  pthread_cond_broadcast(&system->save_cond);
+  pthread_mutex_unlock(&system->config_mutex);
+
+  // Check for changes made while saving...
+  _papplSystemWakeup(system);
+
+  return (NULL);
+}
+
+
 //
 // 'sighup_handler()' - SIGHUP handler
 //
@@ -795,6 +1321,58 @@ sighup_handler(int sig)			// I - Signal (ignored)
   (void)sig;
 
   restart_logging = true;
+
+  // Wake up the housekeeping loop - a full pipe means it is already awake, and
+  // errors can't be logged from a signal handler...
+  if (wakeup_fd >= 0)
+  {
+    int error = errno;			// Saved errno
+
+    if (write(wakeup_fd, "", 1) < 0 && errno != EAGAIN)
+      wakeup_fd = -1;			// Don't use a broken pipe again
+
+    errno = error;
+  }
+}
+
+
+//
+// 'start_printer()' - Advertise a printer and start its raw listeners.
+//
+
+static void
+start_printer(pappl_system_t *system,	// I - System
+              int            printer_id)// I - Printer ID
+{
+  pappl_printer_t	*printer;	// Printer
+
+
+  // The printer may have been deleted since the queue was filled...
+  if ((printer = papplSystemFindPrinter(system, NULL, printer_id, NULL)) == NULL)
+    return;
+
+  // Advertise via DNS-SD as needed, which also builds the driver attributes...
+  pthread_rwlock_wrlock(&printer->rwlock);
+  if (printer->dns_sd_name)
+    _papplPrinterRegisterDNSSDNoLock(printer);
+  pthread_rwlock_unlock(&printer->rwlock);
+
+  // Start the raw socket listeners as needed...
+  if ((system->options & PAPPL_SOPTIONS_RAW_SOCKET) && printer->num_raw_listeners > 0)
+  {
+    pthread_t	tid;			// Thread ID
+
+    if (pthread_create(&tid, NULL, (void *(*)(void *))_papplPrinterRunRaw, printer))
+    {
+      // Unable to create listener thread...
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to create raw listener thread: %s", strerror(errno));
+    }
+    else
+    {
+      // Detach the main thread from the raw thread to prevent hangs...
+      pthread_detach(tid);
+    }
+  }
 }
 
 
@@ -808,4 +1386,53 @@ sigterm_handler(int sig)		// I - Signal (ignored)
   (void)sig;
 
   sigterm_time = time(NULL);
+
+  // Wake up the housekeeping loop - a full pipe means it is already awake, and
+  // errors can't be logged from a signal handler...
+  if (wakeup_fd >= 0)
+  {
+    int error = errno;			// Saved errno
+
+    if (write(wakeup_fd, "", 1) < 0 && errno != EAGAIN)
+      wakeup_fd = -1;			// Don't use a broken pipe again
+
+    errno = error;
+  }
+}
+
+
+//
+// 'wait_housekeeping()' - Wait for the next housekeeping timer or a wakeup.
+//
+
+static void
+wait_housekeeping(
+    pappl_system_t *system,		// I - System
+    time_t         next)		// I - Time of next housekeeping run
+{
+  time_t	curtime = time(NULL);	// Current time
+
+
+  if (next <= curtime)
+    return;
+
+#if _WIN32
+  // No wakeup pipe, check once a second...
+  (void)system;
+
+  Sleep(1000);
+
+#else
+  struct pollfd	pfd;			// Wakeup pipe
+  char		buffer[256];		// Wakeup pipe data
+
+  pfd.fd     = system->wakefds[0];
+  pfd.events = POLLIN;
+
+  if (poll(&pfd, 1, (int)(next - curtime) * 1000) > 0)
+  {
+    // Drain the wakeup pipe...
+    while (read(system->wakefds[0], buffer, sizeof(buffer)) > 0);
+  }
+#endif // _WIN32
 }
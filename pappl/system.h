@@ -39,6 +39,19 @@ typedef struct pappl_pr_driver_s	// Printer driver information
   void		*extension;			// Extension data pointer
 } pappl_pr_driver_t;
 
+enum pappl_event_e			// IPP "notify-events" bit values
+{
+  PAPPL_EVENT_NONE = 0x0000,			// No events
+  PAPPL_EVENT_JOB_COMPLETED = 0x0001,		// 'job-completed'
+  PAPPL_EVENT_JOB_CREATED = 0x0002,		// 'job-created'
+  PAPPL_EVENT_JOB_PROGRESS = 0x0004,		// 'job-progress'
+  PAPPL_EVENT_JOB_STATE_CHANGED = 0x0008,	// 'job-state-changed'
+  PAPPL_EVENT_PRINTER_CONFIG_CHANGED = 0x0010,	// 'printer-config-changed'
+  PAPPL_EVENT_PRINTER_STATE_CHANGED = 0x0020,	// 'printer-state-changed'
+  PAPPL_EVENT_PRINTER_STOPPED = 0x0040		// 'printer-stopped'
+};
+typedef unsigned pappl_event_t;		// Bitfield for IPP "notify-events" values @since PAPPL 1.1@
+
 enum pappl_soptions_e			// System option bits
 {
   PAPPL_SOPTIONS_NONE = 0x0000,			// No options
@@ -52,7 +65,12 @@ enum pappl_soptions_e			// System option bits
   PAPPL_SOPTIONS_WEB_REMOTE = 0x0080,		// Allow remote queue management (vs. localhost only)
   PAPPL_SOPTIONS_WEB_SECURITY = 0x0100,		// Enable the user/password settings page
   PAPPL_SOPTIONS_WEB_TLS = 0x0200,		// Enable the TLS settings page
-  PAPPL_SOPTIONS_NO_TLS = 0x0400		// Disable TLS support @since PAPPL 1.1@
+  PAPPL_SOPTIONS_NO_TLS = 0x0400,		// Disable TLS support @since PAPPL 1.1@
+  PAPPL_SOPTIONS_EVENT_LOOP = 0x0800,		// Use an event loop for idle client connections @since PAPPL 1.1@
+  PAPPL_SOPTIONS_ASYNC_LOG = 0x1000,		// Write log messages from a background thread @since PAPPL 1.1@
+  PAPPL_SOPTIONS_JOB_JOURNAL = 0x2000,		// Record completed jobs in a journal instead of saving the state @since PAPPL 1.1@
+  PAPPL_SOPTIONS_WEB_METRICS = 0x4000,		// Enable the "/metrics" page @since PAPPL 1.1@
+  PAPPL_SOPTIONS_LOG_JSON = 0x8000		// Write log messages as JSON lines @since PAPPL 1.1@
 };
 typedef unsigned pappl_soptions_t;	// Bitfield for system options
 
@@ -116,6 +134,7 @@ typedef pappl_wifi_t *(*pappl_wifi_status_cb_t)(pappl_system_t *system, void *da
 // Functions...
 //
 
+extern void		papplSystemAddEvent(pappl_system_t *system, pappl_printer_t *printer, pappl_job_t *job, pappl_event_t event, const char *message, ...) _PAPPL_FORMAT(5,6) _PAPPL_PUBLIC;
 extern void		papplSystemAddLink(pappl_system_t *system, const char *label, const char *path_or_url, pappl_loptions_t options) _PAPPL_PUBLIC;
 extern bool		papplSystemAddListeners(pappl_system_t *system, const char *name) _PAPPL_PUBLIC;
 extern void		papplSystemAddMIMEFilter(pappl_system_t *system, const char *srctype, const char *dsttype, pappl_mime_filter_cb_t cb, void *data) _PAPPL_PUBLIC;
@@ -129,8 +148,11 @@ extern void		papplSystemAddStringsFile(pappl_system_t *system, const char *path,
 extern void		papplSystemCleanJobs(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_system_t	*papplSystemCreate(pappl_soptions_t options, const char *name, int port, const char *subtypes, const char *spooldir, const char *logfile, pappl_loglevel_t loglevel, const char *auth_service, bool tls_only) _PAPPL_PUBLIC;
 extern void		papplSystemDelete(pappl_system_t *system) _PAPPL_PUBLIC;
+extern pappl_loc_t	*papplSystemFindLoc(pappl_system_t *system, const char *language) _PAPPL_PUBLIC;
 extern pappl_printer_t	*papplSystemFindPrinter(pappl_system_t *system, const char *resource, int printer_id, const char *device_uri) _PAPPL_PUBLIC;
+extern int		papplSystemGetAcceptThreads(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetAdminGroup(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplSystemGetAuthCacheTime(pappl_system_t *system) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetAuthService(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_contact_t	*papplSystemGetContact(pappl_system_t *system, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern int		papplSystemGetDefaultPrinterID(pappl_system_t *system) _PAPPL_PUBLIC;
@@ -141,7 +163,15 @@ extern char		*papplSystemGetGeoLocation(pappl_system_t *system, char *buffer, si
 extern char		*papplSystemGetHostname(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetLocation(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern pappl_loglevel_t	papplSystemGetLogLevel(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxClients(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxHostClients(pappl_system_t *system) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetMaxImageMemory(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxImageThreads(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxJobThreads(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetMaxLogSize(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxRequestRate(pappl_system_t *system) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetMaxSpoolMemory(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetMaxWiFiScanAge(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetName(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplSystemGetNextPrinterID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern pappl_soptions_t	papplSystemGetOptions(pappl_system_t *system) _PAPPL_PUBLIC;
@@ -149,9 +179,11 @@ extern char		*papplSystemGetOrganization(pappl_system_t *system, char *buffer, s
 extern char		*papplSystemGetOrganizationalUnit(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetPassword(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplSystemGetPort(pappl_system_t *system) _PAPPL_PUBLIC;
+extern int		papplSystemGetSaveDelay(pappl_system_t *system) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetServerHeader(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetSessionKey(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern bool		papplSystemGetTLSOnly(pappl_system_t *system) _PAPPL_PUBLIC;
+extern bool		papplSystemGetTracing(pappl_system_t *system) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetUUID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern int		papplSystemGetVersions(pappl_system_t *system, int max_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
 extern char		*papplSystemHashPassword(pappl_system_t *system, const char *salt, const char *password, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
@@ -165,7 +197,9 @@ extern void		papplSystemRemoveResource(pappl_system_t *system, const char *path)
 extern void		papplSystemRun(pappl_system_t *system) _PAPPL_PUBLIC;
 extern bool		papplSystemSaveState(pappl_system_t *system, const char *filename) _PAPPL_PUBLIC;
 
+extern void		papplSystemSetAcceptThreads(pappl_system_t *system, int num_threads) _PAPPL_PUBLIC;
 extern void		papplSystemSetAdminGroup(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
+extern void		papplSystemSetAuthCacheTime(pappl_system_t *system, int seconds) _PAPPL_PUBLIC;
 extern void		papplSystemSetContact(pappl_system_t *system, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern void		papplSystemSetDefaultPrinterID(pappl_system_t *system, int default_printer_id) _PAPPL_PUBLIC;
 extern void		papplSystemSetDefaultPrintGroup(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
@@ -175,7 +209,15 @@ extern void		papplSystemSetGeoLocation(pappl_system_t *system, const char *value
 extern void		papplSystemSetHostname(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetLocation(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetLogLevel(pappl_system_t *system, pappl_loglevel_t loglevel) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxClients(pappl_system_t *system, int max_clients) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxHostClients(pappl_system_t *system, int max_clients) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxImageMemory(pappl_system_t *system, size_t max_memory) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxImageThreads(pappl_system_t *system, int max_threads) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxJobThreads(pappl_system_t *system, int max_threads) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxLogSize(pappl_system_t *system, size_t maxSize) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxRequestRate(pappl_system_t *system, int max_rate) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxSpoolMemory(pappl_system_t *system, size_t max_memory) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxWiFiScanAge(pappl_system_t *system, int max_age) _PAPPL_PUBLIC;
 extern void		papplSystemSetMIMECallback(pappl_system_t *system, pappl_mime_cb_t cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetNextPrinterID(pappl_system_t *system, int next_printer_id) _PAPPL_PUBLIC;
 extern void		papplSystemSetOperationCallback(pappl_system_t *system, pappl_ipp_op_cb_t cb, void *data) _PAPPL_PUBLIC;
@@ -184,6 +226,8 @@ extern void		papplSystemSetOrganizationalUnit(pappl_system_t *system, const char
 extern void		papplSystemSetPassword(pappl_system_t *system, const char *hash) _PAPPL_PUBLIC;
 extern void		papplSystemSetPrinterDrivers(pappl_system_t *system, int num_drivers, pappl_pr_driver_t *drivers, pappl_pr_autoadd_cb_t autoadd_cb, pappl_pr_create_cb_t create_cb, pappl_pr_driver_cb_t driver_cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetSaveCallback(pappl_system_t *system, pappl_save_cb_t cb, void *data) _PAPPL_PUBLIC;
+extern void		papplSystemSetSaveDelay(pappl_system_t *system, int seconds) _PAPPL_PUBLIC;
+extern void		papplSystemSetTracing(pappl_system_t *system, bool enable) _PAPPL_PUBLIC;
 extern void		papplSystemSetUUID(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetVersions(pappl_system_t *system, int num_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
 extern void		papplSystemSetWiFiCallbacks(pappl_system_t *system, pappl_wifi_join_cb_t join_cb, pappl_wifi_list_cb_t list_cb, pappl_wifi_status_cb_t status_cb, void *data) _PAPPL_PUBLIC;
@@ -17,11 +17,45 @@
 #endif // HAVE_SYS_RANDOM_H
 
 
+//
+// Local types...
+//
+
+#define _PAPPL_ANAME_HASH_SIZE	512	// Size of attribute name hash (power of 2)
+#define _PAPPL_MAX_RASET_CACHE	32	// Maximum number of cached sets
+
+typedef struct _pappl_aname_s		// Interned attribute name
+{
+  struct _pappl_aname_s	*next;		// Next name in hash bucket
+  int			id;		// Bit number
+  char			name[1];	// Name string
+} _pappl_aname_t;
+
+
+//
+// Local globals...
+//
+
+static _pappl_aname_t	*aname_hash[_PAPPL_ANAME_HASH_SIZE];
+					// Interned attribute names
+static int		aname_count = 0;// Number of interned names
+static pthread_mutex_t	aname_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for interning names
+static cups_array_t	*raset_cache = NULL;
+					// Cache of compiled sets
+static pthread_mutex_t	raset_mutex = PTHREAD_MUTEX_INITIALIZER;
+					// Mutex for set cache
+
+
 //
 // Local functions...
 //
 
+static int	compare_rasets(_pappl_raset_t *a, _pappl_raset_t *b);
 static int	filter_cb(_pappl_ipp_filter_t *filter, ipp_t *dst, ipp_attribute_t *attr);
+static _pappl_raset_t *find_raset(const char *key);
+static int	intern_name(const char *name, bool add);
+static _pappl_raset_t *make_raset(cups_array_t *ra, const char *key);
 
 
 //
@@ -60,7 +94,7 @@ void
 _papplCopyAttributes(
     ipp_t        *to,			// I - Destination request
     ipp_t        *from,			// I - Source request
-    cups_array_t *ra,			// I - Requested attributes
+    _pappl_raset_t *ra,			// I - Requested attributes
     ipp_tag_t    group_tag,		// I - Group to copy
     int          quickcopy)		// I - Do a quick copy?
 {
@@ -158,6 +192,173 @@ _papplGetTempDir(void)
 }
 
 
+//
+// '_papplRASetContains()' - Determine whether an attribute was requested.
+//
+// A `NULL` set means all attributes were requested.
+//
+
+bool					// O - `true` if requested, `false` otherwise
+_papplRASetContains(
+    _pappl_raset_t *ra,			// I - Requested attributes
+    const char     *name)		// I - Attribute name
+{
+  int	id;				// Interned name
+
+
+  if (!ra)
+    return (true);
+
+  if ((id = intern_name(name, false)) >= 0 && (ra->bits[id / 8] & (1 << (id & 7))))
+    return (true);
+
+  // Names that did not fit in the intern table are looked up the slow way...
+  return (ra->overflow && cupsArrayFind(ra->ra, (void *)name) != NULL);
+}
+
+
+//
+// '_papplRASetCreate()' - Create a requested attributes set for a request.
+//
+// This function returns `NULL` when all attributes are requested.  Sets for
+// the same "requested-attributes" values are cached and shared, so use
+// @link _papplRASetDelete@ to free the set when you are done.
+//
+
+_pappl_raset_t *			// O - Requested attributes or `NULL` for all
+_papplRASetCreate(ipp_t *request)	// I - IPP request
+{
+  _pappl_raset_t	*set;		// Requested attributes
+  cups_array_t		*ra;		// Requested attributes array
+  ipp_attribute_t	*requested;	// "requested-attributes" attribute
+  int			i,		// Looping var
+			count;		// Number of values
+  char			key[1024],	// Cache key
+			*keyptr;	// Pointer into key
+  const char		*value;		// Current value
+  size_t		valuelen;	// Length of value
+
+
+  // Build the cache key from the operation and requested values, which is
+  // what ippCreateRequestedArray uses...
+  snprintf(key, sizeof(key), "%04x", ippGetOperation(request));
+  keyptr = key + strlen(key);
+
+  requested = ippFindAttribute(request, "requested-attributes", IPP_TAG_KEYWORD);
+
+  for (i = 0, count = ippGetCount(requested); i < count && keyptr; i ++)
+  {
+    value    = ippGetString(requested, i, NULL);
+    valuelen = strlen(value);
+
+    if (valuelen < (sizeof(key) - (size_t)(keyptr - key) - 1))
+    {
+      *keyptr++ = ',';
+      memcpy(keyptr, value, valuelen + 1);
+      keyptr += valuelen;
+    }
+    else
+    {
+      // Too long to cache...
+      keyptr = NULL;
+    }
+  }
+
+  if (keyptr && (set = find_raset(key)) != NULL)
+    return (set);
+
+  if ((ra = ippCreateRequestedArray(request)) == NULL)
+    return (NULL);
+
+  set = make_raset(ra, keyptr ? key : NULL);
+
+  cupsArrayDelete(ra);
+
+  return (set);
+}
+
+
+//
+// '_papplRASetCreateNames()' - Create a requested attributes set from a list
+//                              of names.
+//
+
+_pappl_raset_t *			// O - Requested attributes
+_papplRASetCreateNames(
+    int               num_names,	// I - Number of names
+    const char *const *names)		// I - Names
+{
+  _pappl_raset_t	*set;		// Requested attributes
+  cups_array_t		*ra;		// Requested attributes array
+  int			i;		// Looping var
+  char			key[1024],	// Cache key
+			*keyptr;	// Pointer into key
+  size_t		namelen;	// Length of name
+
+
+  strlcpy(key, "names", sizeof(key));
+
+  for (i = 0, keyptr = key + strlen(key); i < num_names && keyptr; i ++)
+  {
+    namelen = strlen(names[i]);
+
+    if (namelen < (sizeof(key) - (size_t)(keyptr - key) - 1))
+    {
+      *keyptr++ = ',';
+      memcpy(keyptr, names[i], namelen + 1);
+      keyptr += namelen;
+    }
+    else
+    {
+      // Too long to cache...
+      keyptr = NULL;
+    }
+  }
+
+  if (keyptr && (set = find_raset(key)) != NULL)
+    return (set);
+
+  ra = cupsArrayNew((cups_array_func_t)strcmp, NULL);
+
+  for (i = 0; i < num_names; i ++)
+    cupsArrayAdd(ra, (void *)names[i]);
+
+  set = make_raset(ra, keyptr ? key : NULL);
+
+  cupsArrayDelete(ra);
+
+  return (set);
+}
+
+
+//
+// '_papplRASetDelete()' - Free a requested attributes set.
+//
+
+void
+_papplRASetDelete(_pappl_raset_t *ra)	// I - Requested attributes
+{
+  if (ra && !ra->cached)
+  {
+    cupsArrayDelete(ra->ra);
+    free(ra->key);
+    free(ra);
+  }
+}
+
+
+//
+// 'compare_rasets()' - Compare the keys of two requested attributes sets.
+//
+
+static int				// O - Result of comparison
+compare_rasets(_pappl_raset_t *a,	// I - First set
+               _pappl_raset_t *b)	// I - Second set
+{
+  return (strcmp(a->key, b->key));
+}
+
+
 //
 // 'filter_cb()' - Filter printer attributes based on the requested array.
 //
@@ -175,8 +376,143 @@ filter_cb(_pappl_ipp_filter_t *filter,	// I - Filter parameters
   ipp_tag_t group = ippGetGroupTag(attr);
   const char *name = ippGetName(attr);
 
-  if ((filter->group_tag != IPP_TAG_ZERO && group != filter->group_tag && group != IPP_TAG_ZERO) || !name || (!strcmp(name, "media-col-database") && !cupsArrayFind(filter->ra, (void *)name)))
+  if ((filter->group_tag != IPP_TAG_ZERO && group != filter->group_tag && group != IPP_TAG_ZERO) || !name || (!strcmp(name, "media-col-database") && (!filter->ra || !_papplRASetContains(filter->ra, name))))
     return (0);
 
-  return (!filter->ra || cupsArrayFind(filter->ra, (void *)name) != NULL);
+  return (_papplRASetContains(filter->ra, name));
+}
+
+
+//
+// 'find_raset()' - Find a cached requested attributes set.
+//
+
+static _pappl_raset_t *			// O - Cached set or `NULL` if none
+find_raset(const char *key)		// I - Cache key
+{
+  _pappl_raset_t	skey,		// Search key
+			*set;		// Matching set
+
+
+  skey.key = (char *)key;
+
+  pthread_mutex_lock(&raset_mutex);
+  set = (_pappl_raset_t *)cupsArrayFind(raset_cache, &skey);
+  pthread_mutex_unlock(&raset_mutex);
+
+  return (set);
+}
+
+
+//
+// 'intern_name()' - Get the bit number for an attribute name.
+//
+// Lookups do not lock since names are never removed and new names are
+// published atomically at the head of their hash bucket.
+//
+
+static int				// O - Bit number or `-1` if none
+intern_name(const char *name,		// I - Attribute name
+            bool       add)		// I - Add the name if it is new?
+{
+  unsigned		hash = 2166136261U;
+					// FNV-1a hash of name
+  const char		*ptr;		// Pointer into name
+  _pappl_aname_t	*an;		// Current name
+  size_t		namelen;	// Length of name
+
+
+  for (ptr = name; *ptr; ptr ++)
+  {
+    hash ^= (unsigned char)*ptr;
+    hash *= 16777619U;
+  }
+
+  hash &= _PAPPL_ANAME_HASH_SIZE - 1;
+
+  for (an = (_pappl_aname_t *)_PAPPL_ATOMIC_GETPTR(aname_hash + hash); an; an = an->next)
+  {
+    if (!strcmp(an->name, name))
+      return (an->id);
+  }
+
+  if (!add)
+    return (-1);
+
+  pthread_mutex_lock(&aname_mutex);
+
+  // Look again now that we hold the lock...
+  for (an = aname_hash[hash]; an; an = an->next)
+  {
+    if (!strcmp(an->name, name))
+      break;
+  }
+
+  if (!an)
+  {
+    namelen = (size_t)(ptr - name);
+
+    if (aname_count < _PAPPL_MAX_ATTR_NAMES && (an = malloc(sizeof(_pappl_aname_t) + namelen)) != NULL)
+    {
+      an->id   = aname_count ++;
+      an->next = aname_hash[hash];
+      memcpy(an->name, name, namelen + 1);
+
+      _PAPPL_ATOMIC_SETPTR(aname_hash + hash, an);
+    }
+  }
+
+  pthread_mutex_unlock(&aname_mutex);
+
+  return (an ? an->id : -1);
+}
+
+
+//
+// 'make_raset()' - Compile a requested attributes array.
+//
+// When a key is supplied, the new set is added to the cache if there is room.
+//
+
+static _pappl_raset_t *			// O - Requested attributes
+make_raset(cups_array_t *ra,		// I - Requested attributes array
+           const char   *key)		// I - Cache key or `NULL` for none
+{
+  _pappl_raset_t	*set;		// Requested attributes
+  const char		*name;		// Current name
+  int			id;		// Bit number
+
+
+  if ((set = calloc(1, sizeof(_pappl_raset_t))) == NULL)
+    return (NULL);
+
+  set->ra = cupsArrayNew3((cups_array_func_t)strcmp, NULL, NULL, 0, (cups_acopy_func_t)strdup, (cups_afree_func_t)free);
+
+  for (name = (const char *)cupsArrayFirst(ra); name; name = (const char *)cupsArrayNext(ra))
+  {
+    cupsArrayAdd(set->ra, (void *)name);
+
+    if ((id = intern_name(name, true)) >= 0)
+      set->bits[id / 8] |= (unsigned char)(1 << (id & 7));
+    else
+      set->overflow = true;
+  }
+
+  if (key && (set->key = strdup(key)) != NULL)
+  {
+    pthread_mutex_lock(&raset_mutex);
+
+    if (!raset_cache)
+      raset_cache = cupsArrayNew((cups_array_func_t)compare_rasets, NULL);
+
+    if (cupsArrayCount(raset_cache) < _PAPPL_MAX_RASET_CACHE && !cupsArrayFind(raset_cache, set))
+    {
+      set->cached = true;
+      cupsArrayAdd(raset_cache, set);
+    }
+
+    pthread_mutex_unlock(&raset_mutex);
+  }
+
+  return (set);
 }
@@ -35,6 +35,7 @@ struct _pthread_s
 // Local functions...
 //
 
+static BOOL CALLBACK pthread_once_wrapper(PINIT_ONCE o, PVOID func, PVOID *context);
 static DWORD	pthread_tls(void);
 static int	pthread_wrapper(pthread_t t);
 
@@ -55,6 +56,125 @@ pthread_cancel(pthread_t t)		// I - Thread ID
 }
 
 
+//
+// 'pthread_cond_broadcast()' - Wake up all threads waiting on a condition.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_broadcast(
+    pthread_cond_t *c)			// I - Condition variable
+{
+  if (!c)
+    return (EINVAL);
+
+  WakeAllConditionVariable(c);
+
+  return (0);
+}
+
+
+//
+// 'pthread_cond_destroy()' - Free memory used by a condition variable.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_destroy(
+    pthread_cond_t *c)			// I - Condition variable
+{
+  if (!c)
+    return (EINVAL);
+
+  // Nothing to do...
+
+  return (0);
+}
+
+
+//
+// 'pthread_cond_init()' - Initialize a condition variable.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_init(
+    pthread_cond_t *c,			// I - Condition variable
+    const void     *attr)		// I - Condition attributes (not used)
+{
+  if (!c)
+    return (EINVAL);
+
+  (void)attr;
+
+  InitializeConditionVariable(c);
+
+  return (0);
+}
+
+
+//
+// 'pthread_cond_signal()' - Wake up a single thread waiting on a condition.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_signal(
+    pthread_cond_t *c)			// I - Condition variable
+{
+  if (!c)
+    return (EINVAL);
+
+  WakeConditionVariable(c);
+
+  return (0);
+}
+
+
+//
+// 'pthread_cond_timedwait()' - Wait on a condition with a timeout.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_timedwait(
+    pthread_cond_t        *c,		// I - Condition variable
+    pthread_mutex_t       *m,		// I - Mutual exclusion lock
+    const struct timespec *abstime)	// I - Absolute timeout
+{
+  struct timeval	curtime;	// Current time
+  long			msecs;		// Milliseconds to wait
+
+
+  if (!c || !m || !abstime)
+    return (EINVAL);
+
+  gettimeofday(&curtime, NULL);
+
+  msecs = (long)(abstime->tv_sec - curtime.tv_sec) * 1000 + (abstime->tv_nsec / 1000000 - curtime.tv_usec / 1000);
+  if (msecs < 0)
+    msecs = 0;
+
+  if (!SleepConditionVariableCS(c, m, (DWORD)msecs))
+    return (GetLastError() == ERROR_TIMEOUT ? ETIMEDOUT : EINVAL);
+
+  return (0);
+}
+
+
+//
+// 'pthread_cond_wait()' - Wait on a condition.
+//
+
+int					// O - 0 on success or errno on error
+pthread_cond_wait(
+    pthread_cond_t  *c,			// I - Condition variable
+    pthread_mutex_t *m)			// I - Mutual exclusion lock
+{
+  if (!c || !m)
+    return (EINVAL);
+
+  SleepConditionVariableCS(c, m, INFINITE);
+
+  return (0);
+}
+
+
 //
 // 'pthread_create()' - Create a new child thread.
 //
@@ -206,6 +326,24 @@ pthread_mutex_unlock(pthread_mutex_t *m)// I - Mutual exclusion lock
 }
 
 
+//
+// 'pthread_once()' - Run a function once.
+//
+
+int					// O - 0 on success or errno on error
+pthread_once(pthread_once_t *o,		// I - One-time initialization control
+             void           (*func)(void))
+					// I - Function to run
+{
+  if (!o || !func)
+    return (EINVAL);
+
+  InitOnceExecuteOnce(o, pthread_once_wrapper, (PVOID)func, NULL);
+
+  return (0);
+}
+
+
 //
 // 'pthread_rwlock_destroy()' - Free all memory used by a reader/writer lock.
 //
@@ -350,6 +488,25 @@ pthread_testcancel(void)
 }
 
 
+//
+// 'pthread_once_wrapper()' - Call the function for pthread_once.
+//
+
+static BOOL CALLBACK			// O - `TRUE` to continue
+pthread_once_wrapper(
+    PINIT_ONCE o,			// I - One-time initialization control
+    PVOID      func,			// I - Function to run
+    PVOID      *context)		// O - Context (not used)
+{
+  (void)o;
+  (void)context;
+
+  ((void (*)(void))func)();
+
+  return (TRUE);
+}
+
+
 //
 // 'pthread_tls()' - Get the thread local storage key.
 //
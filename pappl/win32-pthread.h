@@ -24,6 +24,14 @@
 
 #  define PTHREAD_MUTEX_INITIALIZER	{ (void*)-1, -1, 0, 0, 0, 0 }
 #  define PTHREAD_RWLOCK_INITIALIZER	{ 0 }
+#  define PTHREAD_ONCE_INIT		INIT_ONCE_STATIC_INIT
+
+
+//
+// Macros...
+//
+
+#  define pthread_equal(a,b)		((a) == (b))
 
 
 //
@@ -34,6 +42,9 @@ typedef struct _pthread_s *pthread_t;	// Thread identifier
 typedef CRITICAL_SECTION pthread_mutex_t;
 					// Mutual exclusion lock
 typedef SRWLOCK pthread_rwlock_t;	// Reader/writer lock
+typedef CONDITION_VARIABLE pthread_cond_t;
+					// Condition variable
+typedef INIT_ONCE pthread_once_t;	// One-time initialization
 
 
 //
@@ -41,10 +52,18 @@ typedef SRWLOCK pthread_rwlock_t;	// Reader/writer lock
 //
 
 extern int	pthread_cancel(pthread_t t);
+extern int	pthread_cond_broadcast(pthread_cond_t *c);
+extern int	pthread_cond_destroy(pthread_cond_t *c);
+extern int	pthread_cond_init(pthread_cond_t *c, const void *attr);
+extern int	pthread_cond_signal(pthread_cond_t *c);
+extern int	pthread_cond_timedwait(pthread_cond_t *c, pthread_mutex_t *m, const struct timespec *abstime);
+extern int	pthread_cond_wait(pthread_cond_t *c, pthread_mutex_t *m);
 extern int	pthread_create(pthread_t *t, const void *attr, void *(*func)(void *), void *arg);
 extern int	pthread_detach(pthread_t t);
 extern int	pthread_join(pthread_t t, void **value);
 
+extern int	pthread_once(pthread_once_t *o, void (*func)(void));
+
 extern int	pthread_mutex_destroy(pthread_mutex_t *m);
 extern int	pthread_mutex_init(pthread_mutex_t *m, const void *attr);
 extern int	pthread_mutex_lock(pthread_mutex_t *m);
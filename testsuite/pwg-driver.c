@@ -86,6 +86,7 @@ static bool	pwg_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_de
 static bool	pwg_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pwg_rstartpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 static bool	pwg_rwriteline(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *line);
+static bool	pwg_rwritelines(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned num_lines, const unsigned char *lines);
 static bool	pwg_status(pappl_printer_t *printer);
 static const char *pwg_testpage(pappl_printer_t *printer, char *buffer, size_t bufsize);
 
@@ -190,6 +191,7 @@ pwg_callback(
   driver_data->rstartjob_cb       = pwg_rstartjob;
   driver_data->rstartpage_cb      = pwg_rstartpage;
   driver_data->rwriteline_cb      = pwg_rwriteline;
+  driver_data->rwritelines_cb     = pwg_rwritelines;
   driver_data->status_cb          = pwg_status;
   driver_data->testpage_cb        = pwg_testpage;
   driver_data->format             = "image/pwg-raster";
@@ -774,6 +776,30 @@ pwg_rwriteline(
 }
 
 
+//
+// 'pwg_rwritelines()' - Write a band of raster lines.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pwg_rwritelines(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Job options
+    pappl_device_t      *device,	// I - Print device (unused)
+    unsigned            y,		// I - First line number
+    unsigned            num_lines,	// I - Number of lines
+    const unsigned char *lines)		// I - Lines
+{
+  // The colorant usage is tracked a line at a time...
+  for (; num_lines > 0; num_lines --, y ++, lines += options->header.cupsBytesPerLine)
+  {
+    if (!pwg_rwriteline(job, options, device, y, lines))
+      return (false);
+  }
+
+  return (true);
+}
+
+
 //
 // 'pwg_status()' - Get current printer status.
 //
@@ -0,0 +1,864 @@
+//
+// Microbenchmarks for the Printer Application Framework
+//
+// Copyright © 2021 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   testbench [OPTIONS] [BENCHMARK ...]
+//
+// Options:
+//
+//   --help               Show help
+//   -n REPETITIONS       Set the number of timed repetitions (default 100)
+//   -o CSV-FILE          Write results to a CSV file
+//   -w WARMUP            Set the number of warmup repetitions (default 10)
+//
+// Benchmarks are selected by name or name prefix, for example "image" runs all
+// of the image filter benchmarks.  All benchmarks are run by default.
+//
+// Each benchmark uses fixed input data and is run for a number of untimed
+// warmup repetitions followed by the timed repetitions.  The minimum, median,
+// 90th and 99th percentile, and maximum time per operation are reported along
+// with the median throughput.  Percentiles are only reported when there are
+// enough repetitions for them to differ from the maximum - 10 for the 90th
+// and 100 for the 99th.
+//
+
+//
+// Include necessary headers...
+//
+
+#include <pappl/pappl-private.h>
+#include <pappl/httpmon-private.h>
+#include <pappl/snmp-private.h>
+#include "testpappl.h"
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_BENCH_DEVICE_CHUNK 4096	// Bytes per chunk in device data
+#define _PAPPL_BENCH_DITHER_LINES 256	// Lines per dither repetition
+#define _PAPPL_BENCH_DITHER_WIDTH 2550	// Pixels per dither line (8.5" at 300dpi)
+#define _PAPPL_BENCH_HOST_BYTES	1048576	// Bytes of host (POST) data
+#define _PAPPL_BENCH_HTML_BYTES	4096	// Bytes of text to escape
+#define _PAPPL_BENCH_HTML_CALLS	64	// Escape calls per repetition
+#define _PAPPL_BENCH_HTTP_WRITE	16384	// Bytes per HTTP monitor call
+#define _PAPPL_BENCH_IMAGE_HEIGHT 480	// Height of test image
+#define _PAPPL_BENCH_IMAGE_WIDTH 640	// Width of test image
+#define _PAPPL_BENCH_IPP_COPIES	100	// Attribute copies per repetition
+#define _PAPPL_BENCH_LOG_MESSAGES 1000	// Log messages per repetition
+#define _PAPPL_BENCH_SNMP_DECODES 1000	// SNMP decodes per repetition
+#define _PAPPL_BENCH_SNMP_WRITES 256	// SNMP writes per repetition
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_bench_s		// Benchmark data
+{
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		*job;		// Job for image benchmarks
+  pappl_device_t	*device;	// Device for image benchmarks
+  ipp_orient_t		orient;		// Orientation for image benchmarks
+  unsigned char		*image;		// Image pixels
+  char			*host_data,	// HTTP host data
+			*device_data;	// HTTP device data
+  size_t		host_size,	// Size of host data
+			device_size;	// Size of device data
+  int			snmp_fd;	// SNMP socket
+  http_addr_t		snmp_addr;	// Loopback address for SNMP requests
+  _pappl_snmp_arena_t	*arena;		// SNMP packet arena
+  _pappl_snmp_t		*packet;	// SNMP packet
+  pappl_client_t	*client;	// Client for HTML output
+  char			*html;		// Text to escape
+  _pappl_dplane_t	*dplane;	// Dither thresholds
+  unsigned char		*pixels,	// Dither input pixels
+			*line;		// Dither output line
+  bool			invert;		// Invert pixels when dithering?
+  ipp_t			*attrs;		// Attributes to copy
+  _pappl_raset_t	*ra;		// Requested attributes or `NULL` for all
+} _pappl_bench_t;
+
+typedef bool (*_pappl_bench_cb_t)(_pappl_bench_t *b);
+					// Benchmark repetition callback
+
+
+//
+// Local globals...
+//
+
+static cups_file_t	*csv = NULL;	// CSV results file
+static cups_array_t	*names = NULL;	// Benchmark names
+static int		num_reps = 100,	// Number of timed repetitions
+			num_warmup = 10;// Number of warmup repetitions
+
+
+//
+// Fixed SNMPv1 GetResponse-PDU for hrDeviceDescr.1...
+//
+
+static const unsigned char snmp_response[] =
+{
+  0x30, 0x55, 0x02, 0x01, 0x00, 0x04, 0x06, 0x70, 0x75, 0x62, 0x6c, 0x69,
+  0x63, 0xa2, 0x48, 0x02, 0x02, 0x12, 0x34, 0x02, 0x01, 0x00, 0x02, 0x01,
+  0x00, 0x30, 0x3c, 0x30, 0x3a, 0x06, 0x0b, 0x2b, 0x06, 0x01, 0x02, 0x01,
+  0x19, 0x03, 0x02, 0x01, 0x03, 0x01, 0x04, 0x2b, 0x45, 0x78, 0x61, 0x6d,
+  0x70, 0x6c, 0x65, 0x20, 0x4f, 0x66, 0x66, 0x69, 0x63, 0x65, 0x20, 0x50,
+  0x72, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x20, 0x31, 0x32, 0x33, 0x34, 0x2c,
+  0x20, 0x46, 0x69, 0x72, 0x6d, 0x77, 0x61, 0x72, 0x65, 0x20, 0x31, 0x2e,
+  0x32, 0x2e, 0x33
+};
+
+
+//
+// Local functions...
+//
+
+static bool	bench_copy(_pappl_bench_t *b);
+static bool	bench_dither(_pappl_bench_t *b);
+static bool	bench_html(_pappl_bench_t *b);
+static bool	bench_httpmon(_pappl_bench_t *b);
+static bool	bench_image(_pappl_bench_t *b);
+static bool	bench_log(_pappl_bench_t *b);
+static bool	bench_snmp_decode(_pappl_bench_t *b);
+static bool	bench_snmp_encode(_pappl_bench_t *b);
+static double	bench_time(void);
+static int	compare_doubles(double *a, double *b);
+static void	format_percentile(const double *times, int reps, int pct, char *buffer, size_t bufsize);
+static bool	make_data(_pappl_bench_t *b);
+static void	run_bench(_pappl_bench_t *b, const char *name, _pappl_bench_cb_t cb, int reps, unsigned ops, size_t bytes);
+static int	usage(int status);
+
+
+//
+// 'main()' - Run the microbenchmarks.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int			i;		// Looping var
+  const char		*csvfile = NULL;// CSV results file
+  _pappl_bench_t	b;		// Benchmark data
+  static const char * const ra_names[] =
+  {					// Attributes requested by a typical client
+    "color-supported",
+    "document-format-supported",
+    "media-col-default",
+    "media-supported",
+    "printer-is-accepting-jobs",
+    "printer-make-and-model",
+    "printer-resolution-supported",
+    "printer-state",
+    "printer-state-reasons",
+    "sides-supported"
+  };
+  static const ipp_orient_t orients[] =	// Image orientations
+  {
+    IPP_ORIENT_PORTRAIT,
+    IPP_ORIENT_LANDSCAPE,
+    IPP_ORIENT_REVERSE_LANDSCAPE,
+    IPP_ORIENT_REVERSE_PORTRAIT
+  };
+  static const char * const orient_names[] =
+  {					// Image benchmark names
+    "image-portrait",
+    "image-landscape",
+    "image-reverse-landscape",
+    "image-reverse-portrait"
+  };
+
+
+  // Parse command-line...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(0));
+    }
+    else if (!strcmp(argv[i], "-n"))
+    {
+      i ++;
+      if (i >= argc || (num_reps = atoi(argv[i])) < 1)
+      {
+        puts("testbench: Expected number of repetitions after '-n'.");
+        return (usage(1));
+      }
+    }
+    else if (!strcmp(argv[i], "-o"))
+    {
+      if ((i + 1) >= argc)
+      {
+        puts("testbench: Expected CSV filename after '-o'.");
+        return (usage(1));
+      }
+
+      csvfile = argv[++ i];
+    }
+    else if (!strcmp(argv[i], "-w"))
+    {
+      i ++;
+      if (i >= argc || (num_warmup = atoi(argv[i])) < 0)
+      {
+        puts("testbench: Expected number of warmup repetitions after '-w'.");
+        return (usage(1));
+      }
+    }
+    else if (argv[i][0] == '-')
+    {
+      printf("testbench: Unknown option '%s'.\n", argv[i]);
+      return (usage(1));
+    }
+    else
+    {
+      // Benchmark name or prefix...
+      if (!names)
+        names = cupsArrayNew(NULL, NULL);
+
+      cupsArrayAdd(names, argv[i]);
+    }
+  }
+
+  if (csvfile && (csv = cupsFileOpen(csvfile, "w")) == NULL)
+  {
+    printf("testbench: Unable to create '%s': %s\n", csvfile, strerror(errno));
+    return (1);
+  }
+
+  if (csv)
+    cupsFilePuts(csv, "name,ops,min,p50,p90,p99,max,units,throughput,throughput-units\n");
+
+  // Create the system, printer, and fixed input data.  Log messages go to a
+  // regular file, which is rotated as usual...
+  memset(&b, 0, sizeof(b));
+
+  if ((b.system = papplSystemCreate(PAPPL_SOPTIONS_NONE, "testbench", 0, NULL, NULL, "testbench.log", PAPPL_LOGLEVEL_DEBUG, NULL, false)) == NULL)
+  {
+    puts("testbench: Unable to create system.");
+    return (1);
+  }
+
+  papplSystemSetPrinterDrivers(b.system, (int)(sizeof(pwg_drivers) / sizeof(pwg_drivers[0])), pwg_drivers, pwg_autoadd, /* create_cb */NULL, pwg_callback, "testbench");
+
+  if ((b.printer = papplPrinterCreate(b.system, /* printer_id */0, "Bench Printer", "pwg_common-300dpi-black_1", "MFG:PWG;MDL:Bench Printer;", "file:///dev/null")) == NULL)
+  {
+    puts("testbench: Unable to create printer.");
+    return (1);
+  }
+
+  if (!make_data(&b))
+    return (1);
+
+  printf("%-24s %8s %10s %10s %10s %10s %10s  %s\n", "Benchmark", "Ops", "Min", "P50", "P90", "P99", "Max", "Throughput");
+
+  // HTTP monitor...
+  run_bench(&b, "httpmon", bench_httpmon, num_reps, 1, b.host_size + b.device_size);
+
+  // SNMP ASN.1 encoding (including the loopback send) and decoding...
+  run_bench(&b, "snmp-encode", bench_snmp_encode, num_reps, _PAPPL_BENCH_SNMP_WRITES, 0);
+  run_bench(&b, "snmp-decode", bench_snmp_decode, num_reps, _PAPPL_BENCH_SNMP_DECODES, _PAPPL_BENCH_SNMP_DECODES * sizeof(snmp_response));
+
+  // Log message formatting...
+  run_bench(&b, "log", bench_log, num_reps, _PAPPL_BENCH_LOG_MESSAGES, 0);
+
+  // HTML escaping...
+  run_bench(&b, "html-escape", bench_html, num_reps, _PAPPL_BENCH_HTML_CALLS, _PAPPL_BENCH_HTML_CALLS * _PAPPL_BENCH_HTML_BYTES);
+
+  // Dithering of black and grayscale lines...
+  b.invert = false;
+  run_bench(&b, "dither-black", bench_dither, num_reps, _PAPPL_BENCH_DITHER_LINES, _PAPPL_BENCH_DITHER_LINES * _PAPPL_BENCH_DITHER_WIDTH);
+
+  b.invert = true;
+  run_bench(&b, "dither-gray", bench_dither, num_reps, _PAPPL_BENCH_DITHER_LINES, _PAPPL_BENCH_DITHER_LINES * _PAPPL_BENCH_DITHER_WIDTH);
+
+  // Image scaling and rotation, one page per repetition...
+  for (i = 0; i < (int)(sizeof(orients) / sizeof(orients[0])); i ++)
+  {
+    b.orient = orients[i];
+    run_bench(&b, orient_names[i], bench_image, num_reps > 10 ? num_reps / 10 : 1, 1, 3 * _PAPPL_BENCH_IMAGE_WIDTH * _PAPPL_BENCH_IMAGE_HEIGHT);
+  }
+
+  // IPP attribute filtering...
+  b.ra = NULL;
+  run_bench(&b, "copy-attrs-all", bench_copy, num_reps, _PAPPL_BENCH_IPP_COPIES, 0);
+
+  b.ra = _papplRASetCreateNames((int)(sizeof(ra_names) / sizeof(ra_names[0])), ra_names);
+  run_bench(&b, "copy-attrs-filtered", bench_copy, num_reps, _PAPPL_BENCH_IPP_COPIES, 0);
+  _papplRASetDelete(b.ra);
+
+  // Clean up...
+  if (csv)
+    cupsFileClose(csv);
+
+  cupsArrayDelete(names);
+
+  papplDeviceClose(b.device);
+  _papplDitherPlaneRelease(b.dplane);
+  _papplSNMPClose(b.snmp_fd);
+  free(b.arena);
+  free(b.packet);
+  free(b.client);
+  free(b.device_data);
+  free(b.host_data);
+  free(b.html);
+  free(b.image);
+  free(b.line);
+  free(b.pixels);
+  ippDelete(b.attrs);
+
+  papplSystemDelete(b.system);
+
+  return (0);
+}
+
+
+//
+// 'bench_copy()' - Copy the printer attributes.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_copy(_pappl_bench_t *b)		// I - Benchmark data
+{
+  int	i;				// Looping var
+  ipp_t	*to;				// Destination message
+
+
+  for (i = 0; i < _PAPPL_BENCH_IPP_COPIES; i ++)
+  {
+    if ((to = ippNew()) == NULL)
+      return (false);
+
+    _papplCopyAttributes(to, b->attrs, b->ra, IPP_TAG_ZERO, 1);
+    ippDelete(to);
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_dither()' - Dither lines of 8-bit pixels.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_dither(_pappl_bench_t *b)		// I - Benchmark data
+{
+  unsigned	y;			// Current line
+
+
+  for (y = 0; y < _PAPPL_BENCH_DITHER_LINES; y ++)
+    _papplDitherLine(b->line, 0, _PAPPL_BENCH_DITHER_WIDTH, b->pixels + (y & 15) * _PAPPL_BENCH_DITHER_WIDTH, _PAPPL_DPLANE_ROW(b->dplane, y), b->invert);
+
+  return (true);
+}
+
+
+//
+// 'bench_html()' - Escape text for HTML output.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_html(_pappl_bench_t *b)		// I - Benchmark data
+{
+  int	i;				// Looping var
+
+
+  // Discard the buffered output after each call so nothing is written to
+  // the (nonexistent) connection...
+  for (i = 0; i < _PAPPL_BENCH_HTML_CALLS; i ++)
+  {
+    papplClientHTMLEscape(b->client, b->html, _PAPPL_BENCH_HTML_BYTES);
+    b->client->wused = 0;
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_httpmon()' - Monitor a POST request and chunked GET response.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_httpmon(_pappl_bench_t *b)	// I - Benchmark data
+{
+  _pappl_http_monitor_t	hm;		// HTTP monitor
+  const char		*data = b->host_data,
+					// Host data
+			*response = b->device_data,
+					// Device data
+			*resend = b->device_data + b->device_size;
+					// End of device data
+  size_t		datasize = b->host_size,
+					// Bytes of host data left
+			bytes,		// Bytes to send
+			remaining,	// Bytes not processed
+			length;		// Length of response
+  http_status_t		status = HTTP_STATUS_CONTINUE;
+					// HTTP status
+
+
+  _papplHTTPMonitorInit(&hm);
+
+  // The host data is a POST request followed by a GET request, and the device
+  // data holds the nul-terminated responses to each...
+  while (status != HTTP_STATUS_ERROR && (datasize > 0 || hm.host.used > 0))
+  {
+    bytes     = datasize > _PAPPL_BENCH_HTTP_WRITE ? _PAPPL_BENCH_HTTP_WRITE : datasize;
+    remaining = bytes;
+    status    = _papplHTTPMonitorProcessHostData(&hm, &data, &remaining);
+    datasize  -= bytes - remaining;
+
+    if (status == HTTP_STATUS_ERROR || hm.phase != _PAPPL_HTTP_PHASE_SERVER_HEADERS)
+      continue;
+
+    // Send the response to this request...
+    if (response >= resend)
+    {
+      hm.error = "No response for request.";
+      status   = HTTP_STATUS_ERROR;
+      break;
+    }
+
+    for (length = strlen(response); length > 0 && status != HTTP_STATUS_ERROR; response += bytes, length -= bytes)
+    {
+      bytes  = length > _PAPPL_BENCH_HTTP_WRITE ? _PAPPL_BENCH_HTTP_WRITE : length;
+      status = _papplHTTPMonitorProcessDeviceData(&hm, response, bytes);
+    }
+
+    response ++;
+  }
+
+  if (status != HTTP_STATUS_ERROR && _papplHTTPMonitorGetState(&hm) != HTTP_STATE_WAITING)
+    hm.error = "Not in the HTTP_WAITING state.";
+  else if (status != HTTP_STATUS_ERROR)
+    return (true);
+
+  printf("FAIL (%s)\n", _papplHTTPMonitorGetError(&hm));
+  return (false);
+}
+
+
+//
+// 'bench_image()' - Print an image.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_image(_pappl_bench_t *b)		// I - Benchmark data
+{
+  bool			ret;		// Return value
+  pappl_pr_options_t	*options;	// Print options
+
+
+  // The image filter updates the options, so create them for every page...
+  if ((options = papplJobCreatePrintOptions(b->job, 1, true)) == NULL)
+    return (false);
+
+  options->orientation_requested = b->orient;
+  options->print_scaling         = PAPPL_SCALING_FIT;
+
+  ret = papplJobFilterImage(b->job, b->device, options, b->image, _PAPPL_BENCH_IMAGE_WIDTH, _PAPPL_BENCH_IMAGE_HEIGHT, 3, 0, true);
+
+  papplJobDeletePrintOptions(options);
+
+  return (ret);
+}
+
+
+//
+// 'bench_log()' - Format and write log messages.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_log(_pappl_bench_t *b)		// I - Benchmark data
+{
+  int	i;				// Looping var
+
+
+  for (i = 0; i < _PAPPL_BENCH_LOG_MESSAGES; i += 2)
+  {
+    papplLog(b->system, PAPPL_LOGLEVEL_INFO, "Accepted connection %d from '%s' on port %d.", i, "192.168.0.100", 8000 + (i & 255));
+    papplLogPrinter(b->printer, PAPPL_LOGLEVEL_INFO, "Printed page %d of %d (%s, %.1f%% complete).", i, _PAPPL_BENCH_LOG_MESSAGES, "na_letter_8.5x11in", 100.0 * i / _PAPPL_BENCH_LOG_MESSAGES);
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_snmp_decode()' - Decode the fixed SNMP response.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_snmp_decode(_pappl_bench_t *b)	// I - Benchmark data
+{
+  int	i;				// Looping var
+
+
+  for (i = 0; i < _PAPPL_BENCH_SNMP_DECODES; i ++)
+  {
+    if (!_papplSNMPDecodeArena(b->arena, 0, b->packet) || b->packet->error)
+    {
+      printf("FAIL (%s)\n", b->packet->error ? b->packet->error : "Unable to decode");
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_snmp_encode()' - Encode and send SNMP requests over the loopback
+//                         interface.
+//
+// Nothing listens for the requests, so this measures the encoding and the
+// cost of a loopback send.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_snmp_encode(_pappl_bench_t *b)	// I - Benchmark data
+{
+  int		i;			// Looping var
+  static const int oid[] = { 1, 3, 6, 1, 2, 1, 25, 3, 2, 1, 3, 1, -1 };
+					// hrDeviceDescr.1
+
+
+  for (i = 0; i < _PAPPL_BENCH_SNMP_WRITES; i ++)
+  {
+    if (!_papplSNMPWrite(b->snmp_fd, &b->snmp_addr, _PAPPL_SNMP_VERSION_1, _PAPPL_SNMP_COMMUNITY, _PAPPL_ASN1_GET_REQUEST, (unsigned)i + 1, oid))
+    {
+      printf("FAIL (%s)\n", strerror(errno));
+      return (false);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'bench_time()' - Get the current time in seconds.
+//
+
+static double				// O - Current time in seconds
+bench_time(void)
+{
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((double)curtime.tv_sec + 0.000001 * curtime.tv_usec);
+}
+
+
+//
+// 'compare_doubles()' - Compare two double values for sorting.
+//
+
+static int				// O - Result of comparison
+compare_doubles(double *a,		// I - First value
+                double *b)		// I - Second value
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'format_percentile()' - Format a percentile of the sorted repetition times.
+//
+// The nearest-rank percentile is used, and an empty string is returned when
+// there are too few repetitions for the percentile to mean anything.
+//
+
+static void
+format_percentile(const double *times,	// I - Sorted times
+                  int          reps,	// I - Number of times
+                  int          pct,	// I - Percentile (1-99)
+                  char         *buffer,	// I - String buffer
+                  size_t       bufsize)	// I - Size of string buffer
+{
+  if (reps * (100 - pct) >= 100)
+    snprintf(buffer, bufsize, "%.3f", times[(reps * pct + 99) / 100 - 1]);
+  else
+    *buffer = '\0';
+}
+
+
+//
+// 'make_data()' - Create the fixed input data for the benchmarks.
+//
+
+static bool				// O - `true` on success, `false` on failure
+make_data(_pappl_bench_t *b)		// I - Benchmark data
+{
+  int		i;			// Looping var
+  char		*ptr;			// Pointer into data
+  unsigned	x, y;			// Current pixel
+  static const char * const words[] =	// Words for HTML text
+  {
+    "Printer", "Ready", "&", "Idle", "media-ready", "<b>", "\"Letter\"",
+    "Tray 1", "toner-low", "Processing", "job", "Office Printer"
+  };
+
+
+  // HTTP monitor data: a 1MB POST request and a GET request with a 1MB
+  // chunked response...
+  b->host_size = _PAPPL_BENCH_HOST_BYTES + 1024;
+
+  if ((b->host_data = malloc(b->host_size)) == NULL)
+    return (false);
+
+  ptr = b->host_data;
+  ptr += snprintf(ptr, 1024, "POST /ipp/print HTTP/1.1\r\nHost: localhost:60000\r\nContent-Type: application/ipp\r\nContent-Length: %d\r\n\r\n", _PAPPL_BENCH_HOST_BYTES);
+
+  for (i = 0; i < _PAPPL_BENCH_HOST_BYTES; i ++)
+    *ptr++ = (char)(i * 7);
+
+  ptr += snprintf(ptr, 512, "GET /index.html HTTP/1.1\r\nHost: localhost:60000\r\n\r\n");
+
+  b->host_size = (size_t)(ptr - b->host_data);
+
+  b->device_size = _PAPPL_BENCH_HOST_BYTES + (_PAPPL_BENCH_HOST_BYTES / _PAPPL_BENCH_DEVICE_CHUNK) * 16 + 1024;
+
+  if ((b->device_data = malloc(b->device_size)) == NULL)
+    return (false);
+
+  ptr = b->device_data;
+  ptr += snprintf(ptr, 256, "HTTP/1.1 200 OK\r\nContent-Type: application/ipp\r\nContent-Length: 13\r\n\r\nHello, World!");
+  *ptr++ = '\0';
+  ptr += snprintf(ptr, 256, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nTransfer-Encoding: chunked\r\n\r\n");
+
+  for (i = 0; i < _PAPPL_BENCH_HOST_BYTES; i += _PAPPL_BENCH_DEVICE_CHUNK)
+  {
+    ptr += snprintf(ptr, 16, "%x\r\n", _PAPPL_BENCH_DEVICE_CHUNK);
+    memset(ptr, 'a' + (i / _PAPPL_BENCH_DEVICE_CHUNK) % 26, _PAPPL_BENCH_DEVICE_CHUNK);
+    ptr += _PAPPL_BENCH_DEVICE_CHUNK;
+    *ptr++ = '\r';
+    *ptr++ = '\n';
+  }
+
+  ptr += snprintf(ptr, 16, "0\r\n\r\n");
+
+  b->device_size = (size_t)(ptr - b->device_data);
+
+  // SNMP socket and the packet arena holding the fixed response...
+  b->arena  = calloc(1, sizeof(_pappl_snmp_arena_t));
+  b->packet = calloc(1, sizeof(_pappl_snmp_t));
+
+  if (!b->arena || !b->packet)
+    return (false);
+
+  b->snmp_addr.ipv4.sin_family      = AF_INET;
+  b->snmp_addr.ipv4.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if ((b->snmp_fd = _papplSNMPOpen(AF_INET)) < 0)
+  {
+    printf("testbench: Unable to create SNMP socket: %s\n", strerror(errno));
+    return (false);
+  }
+
+  b->arena->num_packets = 1;
+  b->arena->lengths[0]  = sizeof(snmp_response);
+  memcpy(b->arena->packets[0], snmp_response, sizeof(snmp_response));
+
+  // Client and text for HTML escaping...
+  if ((b->client = calloc(1, sizeof(pappl_client_t))) == NULL || (b->html = malloc(_PAPPL_BENCH_HTML_BYTES + 1)) == NULL)
+    return (false);
+
+  b->client->system = b->system;
+
+  for (ptr = b->html, i = 0; (ptr - b->html) < _PAPPL_BENCH_HTML_BYTES; i ++)
+  {
+    const char *word = words[(i * 5) % (int)(sizeof(words) / sizeof(words[0]))];
+					// Current word
+
+    while (*word && (ptr - b->html) < _PAPPL_BENCH_HTML_BYTES)
+      *ptr++ = *word++;
+
+    if ((ptr - b->html) < _PAPPL_BENCH_HTML_BYTES)
+      *ptr++ = ' ';
+  }
+
+  *ptr = '\0';
+
+  // Dither thresholds and 16 lines of pixels...
+  b->pixels = malloc(16 * _PAPPL_BENCH_DITHER_WIDTH);
+  b->line   = malloc((_PAPPL_BENCH_DITHER_WIDTH + 7) / 8);
+  b->dplane = _papplPrinterGetDitherPlane(b->printer, b->printer->driver_data.gdither, _PAPPL_BENCH_DITHER_WIDTH);
+
+  if (!b->pixels || !b->line || !b->dplane)
+    return (false);
+
+  for (y = 0; y < 16; y ++)
+  {
+    for (x = 0; x < _PAPPL_BENCH_DITHER_WIDTH; x ++)
+      b->pixels[y * _PAPPL_BENCH_DITHER_WIDTH + x] = (unsigned char)((x * 255 / _PAPPL_BENCH_DITHER_WIDTH + y * 16) & 255);
+  }
+
+  // Image, job, and device for the image filter...
+  if ((b->image = malloc(3 * _PAPPL_BENCH_IMAGE_WIDTH * _PAPPL_BENCH_IMAGE_HEIGHT)) == NULL)
+    return (false);
+
+  for (y = 0, ptr = (char *)b->image; y < _PAPPL_BENCH_IMAGE_HEIGHT; y ++)
+  {
+    for (x = 0; x < _PAPPL_BENCH_IMAGE_WIDTH; x ++)
+    {
+      *ptr++ = (char)(x * 255 / _PAPPL_BENCH_IMAGE_WIDTH);
+      *ptr++ = (char)(y * 255 / _PAPPL_BENCH_IMAGE_HEIGHT);
+      *ptr++ = (char)((x + y) & 255);
+    }
+  }
+
+  if ((b->job = _papplJobCreate(b->printer, 0, "bench", "image/png", "bench", NULL)) == NULL)
+  {
+    puts("testbench: Unable to create job.");
+    return (false);
+  }
+
+  if ((b->device = papplDeviceOpen("file:///dev/null", "bench", NULL, NULL)) == NULL)
+  {
+    puts("testbench: Unable to open device.");
+    return (false);
+  }
+
+  // Printer attributes for copying...
+  if ((b->attrs = ippNew()) == NULL)
+    return (false);
+
+  ippCopyAttributes(b->attrs, b->printer->attrs, 0, NULL, NULL);
+  _papplPrinterCopyDriverAttrs(b->printer, b->attrs, NULL, 0);
+
+  return (true);
+}
+
+
+//
+// 'run_bench()' - Run a benchmark.
+//
+
+static void
+run_bench(_pappl_bench_t    *b,		// I - Benchmark data
+          const char        *name,	// I - Benchmark name
+          _pappl_bench_cb_t cb,		// I - Repetition callback
+          int               reps,	// I - Number of timed repetitions
+          unsigned          ops,	// I - Operations per repetition
+          size_t            bytes)	// I - Bytes per repetition or `0`
+{
+  int		i;			// Looping var
+  double	*times,			// Time per operation for each repetition
+		start,			// Start time
+		p50,			// Median time
+		rate;			// Median throughput
+  const char	*units;			// Throughput units
+  char		p90[32],		// 90th percentile or empty string
+		p99[32];		// 99th percentile or empty string
+
+
+  // See if this benchmark was selected...
+  if (names)
+  {
+    const char	*prefix;		// Current name or prefix
+
+    for (prefix = (const char *)cupsArrayFirst(names); prefix; prefix = (const char *)cupsArrayNext(names))
+    {
+      if (!strncmp(name, prefix, strlen(prefix)))
+        break;
+    }
+
+    if (!prefix)
+      return;
+  }
+
+  printf("%-24s ", name);
+  fflush(stdout);
+
+  if ((times = calloc((size_t)reps, sizeof(double))) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    return;
+  }
+
+  // Warm up caches and branch predictors...
+  for (i = 0; i < num_warmup; i ++)
+  {
+    if (!(cb)(b))
+      goto done;
+  }
+
+  // Time each repetition...
+  for (i = 0; i < reps; i ++)
+  {
+    start = bench_time();
+
+    if (!(cb)(b))
+      goto done;
+
+    times[i] = 1000000.0 * (bench_time() - start) / ops;
+  }
+
+  qsort(times, (size_t)reps, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+
+  if ((p50 = times[reps / 2]) <= 0.0)
+    p50 = 0.000001;
+
+  if (bytes > 0)
+  {
+    rate  = (double)bytes / ops / p50;
+    units = "MB/sec";
+  }
+  else
+  {
+    rate  = 1.0 / p50;
+    units = "Mops/sec";
+  }
+
+  format_percentile(times, reps, 90, p90, sizeof(p90));
+  format_percentile(times, reps, 99, p99, sizeof(p99));
+
+  printf("%8u %8.3fus %8.3fus %8s%s %8s%s %8.3fus  %.1f%s\n", ops, times[0], p50, p90[0] ? p90 : "-", p90[0] ? "us" : "  ", p99[0] ? p99 : "-", p99[0] ? "us" : "  ", times[reps - 1], rate, units);
+
+  if (csv)
+    cupsFilePrintf(csv, "%s,%u,%.3f,%.3f,%s,%s,%.3f,us,%.3f,%s\n", name, ops, times[0], p50, p90, p99, times[reps - 1], rate, units);
+
+  done:
+
+  free(times);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(int status)			// I - Exit status
+{
+  puts("Usage: testbench [OPTIONS] [BENCHMARK ...]");
+  puts("Options:");
+  puts("  --help               Show help");
+  puts("  -n REPETITIONS       Set the number of timed repetitions (default 100)");
+  puts("  -o CSV-FILE          Write results to a CSV file");
+  puts("  -w WARMUP            Set the number of warmup repetitions (default 10)");
+  puts("Benchmarks:");
+  puts("  httpmon, snmp-encode, snmp-decode, log, html-escape, dither-black,");
+  puts("  dither-gray, image-portrait, image-landscape, image-reverse-landscape,");
+  puts("  image-reverse-portrait, copy-attrs-all, copy-attrs-filtered");
+
+  return (status);
+}
@@ -12,6 +12,10 @@
 //
 // Options:
 //
+//   --async-log          Write log messages from a background thread
+//   --bench              Run the benchmarks
+//   --bench-clients NUM  Set the number of benchmark clients (default 4)
+//   --event-loop         Use the client event loop
 //   --help               Show help
 //   --list[-TYPE]        List devices (dns-sd, local, network, usb)
 //   --no-tls             Don't support TLS
@@ -36,13 +40,15 @@
 //   jpeg                 JPEG image tests
 //   png                  PNG image tests
 //   pwg-raster           PWG Raster tests
+//   bench                Benchmarks (not included in "all")
 //
 
 //
 // Include necessary headers...
 //
 
-#include <pappl/base-private.h>
+#include <pappl/pappl-private.h>
+#include <pappl/snmp-private.h>
 #include <cups/dir.h>
 #include "testpappl.h"
 #include <stdlib.h>
@@ -113,11 +119,21 @@ static inline unsigned testrand(void)
 #endif // _WIN32
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_BENCH_JOBS	20	// Number of jobs for latency benchmark
+#define _PAPPL_BENCH_SECONDS	5	// Seconds for each request benchmark
+#define _PAPPL_MAX_BENCH_CLIENTS 64	// Maximum number of benchmark clients
+
+
 //
 // Local globals...
 //
 
 static bool	  all_tests_done = false;
+static int	  bench_clients = 4;	// Number of benchmark clients
 
 
 //
@@ -132,6 +148,23 @@ typedef struct _pappl_testdata_s	// Test data
   bool			waitsystem;	// Wait for system to start?
 } _pappl_testdata_t;
 
+typedef struct _pappl_benchclient_s	// Benchmark client data
+{
+  pappl_system_t	*system;	// System
+  ipp_op_t		op;		// Operation to send
+  double		end_time;	// Time to stop sending requests
+  int			requests,	// Number of successful requests
+			errors;		// Number of failed requests
+} _pappl_benchclient_t;
+
+typedef struct _pappl_testimage_s	// Image row callback data
+{
+  const unsigned char	*pixels;	// Image pixels
+  size_t		rowsize;	// Bytes per line
+  int			y,		// Next line
+			height;		// Number of lines
+} _pappl_testimage_t;
+
 typedef struct _pappl_testprinter_s	// Printer test data
 {
   bool			pass;		// Pass/fail
@@ -143,15 +176,29 @@ typedef struct _pappl_testprinter_s	// Printer test data
 // Local functions...
 //
 
+static void	*bench_client(_pappl_benchclient_t *bc);
+static bool	bench_compress(cups_file_t *csv);
+static bool	bench_files(http_t *http, const char *uri, cups_file_t *csv, const char *name, const char *format, int num_files, const char * const *files);
+static bool	bench_print_job(http_t *http, const char *uri, const char *filename, const char *format, double *elapsed);
+static double	bench_time(void);
+static int	compare_doubles(double *a, double *b);
+static bool	compare_files(const char *a, const char *b);
+static size_t	compress_naive(pappl_devcomp_t comp, const unsigned char *line, const unsigned char *prev, size_t bytes, unsigned char *buffer);
 static http_t	*connect_to_printer(pappl_system_t *system, char *uri, size_t urisize);
+static size_t	convert_pixel(const cups_page_header2_t *in, const cups_page_header2_t *out, const unsigned char *line, unsigned x, unsigned char *pixel);
+static bool	decompress_line(pappl_devcomp_t comp, const unsigned char *data, size_t datalen, unsigned char *line, size_t bytes);
 static void	device_error_cb(const char *message, void *err_data);
 static bool	device_list_cb(const char *device_info, const char *device_uri, const char *device_id, void *data);
 static int	do_ps_query(const char *device_uri);
+static bool	filter_image_file(pappl_job_t *job, const char *filename, ipp_orient_t orient, int copies, const unsigned char *pixels, int width, int height, bool rows);
+static bool	image_row_cb(_pappl_testimage_t *image, unsigned char *row);
+static void	make_lines(unsigned char *lines, unsigned num_lines, size_t bytes);
 static const char *make_raster_file(ipp_t *response, bool grayscale, char *tempname, size_t tempsize);
 static void	*run_tests(_pappl_testdata_t *testdata);
 static bool	test_api(pappl_system_t *system);
 static bool	test_api_printer(pappl_printer_t *printer);
 static bool	test_api_printer_cb(pappl_printer_t *printer, _pappl_testprinter_t *tp);
+static bool	test_bench(pappl_system_t *system);
 static bool	test_client(pappl_system_t *system);
 #if defined(HAVE_LIBJPEG) || defined(HAVE_LIBPNG)
 static bool	test_image_files(pappl_system_t *system, const char *prompt, const char *format, int num_files, const char * const *files);
@@ -190,7 +237,7 @@ main(int  argc,				// I - Number of command-line arguments
 					// Output directory name
 			device_uri[1024];
 					// Device URI for printers
-  pappl_soptions_t	soptions = PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_WEB_INTERFACE | PAPPL_SOPTIONS_WEB_LOG | PAPPL_SOPTIONS_WEB_NETWORK | PAPPL_SOPTIONS_WEB_SECURITY | PAPPL_SOPTIONS_WEB_TLS | PAPPL_SOPTIONS_RAW_SOCKET;
+  pappl_soptions_t	soptions = PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_WEB_INTERFACE | PAPPL_SOPTIONS_WEB_LOG | PAPPL_SOPTIONS_WEB_NETWORK | PAPPL_SOPTIONS_WEB_SECURITY | PAPPL_SOPTIONS_WEB_TLS | PAPPL_SOPTIONS_WEB_METRICS | PAPPL_SOPTIONS_RAW_SOCKET;
 					// System options
   pappl_system_t	*system;	// System
   pappl_printer_t	*printer;	// Printer
@@ -220,7 +267,29 @@ main(int  argc,				// I - Number of command-line arguments
 
   for (i = 1; i < argc; i ++)
   {
-    if (!strcmp(argv[i], "--help"))
+    if (!strcmp(argv[i], "--async-log"))
+    {
+      soptions |= PAPPL_SOPTIONS_ASYNC_LOG;
+    }
+    else if (!strcmp(argv[i], "--bench"))
+    {
+      cupsArrayAdd(testdata.names, "bench");
+    }
+    else if (!strcmp(argv[i], "--bench-clients"))
+    {
+      i ++;
+      if (i >= argc || atoi(argv[i]) <= 0 || atoi(argv[i]) > _PAPPL_MAX_BENCH_CLIENTS)
+      {
+        printf("testpappl: Expected number of clients (1 to %d) after '--bench-clients'.\n", _PAPPL_MAX_BENCH_CLIENTS);
+        return (usage(1));
+      }
+      bench_clients = atoi(argv[i]);
+    }
+    else if (!strcmp(argv[i], "--event-loop"))
+    {
+      soptions |= PAPPL_SOPTIONS_EVENT_LOOP;
+    }
+    else if (!strcmp(argv[i], "--help"))
     {
       return (usage(0));
     }
@@ -423,6 +492,7 @@ main(int  argc,				// I - Number of command-line arguments
 
   // Initialize the system and any printers...
   system = papplSystemCreate(soptions, name ? name : "Test System", port, "_print,_universal", spool, log, level, auth, tls_only);
+  papplSystemSetAcceptThreads(system, 2);
   papplSystemAddListeners(system, NULL);
   papplSystemSetPrinterDrivers(system, (int)(sizeof(pwg_drivers) / sizeof(pwg_drivers[0])), pwg_drivers, pwg_autoadd, /* create_cb */NULL, pwg_callback, "testpappl");
   papplSystemSetWiFiCallbacks(system, test_wifi_join_cb, test_wifi_list_cb, test_wifi_status_cb, (void *)"testpappl");
@@ -531,210 +601,1016 @@ main(int  argc,				// I - Number of command-line arguments
 
 
 //
-// 'connect_to_printer()' - Connect to the system and return the printer URI.
+// 'bench_client()' - Send IPP requests from a benchmark client thread.
 //
 
-static http_t *				// O - HTTP connection
-connect_to_printer(
-    pappl_system_t *system,		// I - System
-    char           *uri,		// I - URI buffer
-    size_t         urisize)		// I - Size of URI buffer
+static void *				// O - Thread exit status
+bench_client(_pappl_benchclient_t *bc)	// I - Benchmark client data
 {
-  httpAssembleURI(HTTP_URI_CODING_ALL, uri, (int)urisize, "ipp", NULL, "localhost", papplSystemGetPort(system), "/ipp/print");
+  http_t	*http;			// HTTP connection
+  char		uri[1024];		// "printer-uri" value
+  ipp_t		*request;		// IPP request
 
-  return (httpConnect2("localhost", papplSystemGetPort(system), NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, 1, 30000, NULL));
-}
 
+  if ((http = connect_to_printer(bc->system, uri, sizeof(uri))) == NULL)
+  {
+    bc->errors ++;
+    return (NULL);
+  }
 
-//
-// 'device_error_cb()' - Show a device error message.
-//
+  while (bench_time() < bc->end_time)
+  {
+    request = ippNewRequest(bc->op);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    if (bc->op == IPP_OP_GET_JOBS)
+      ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "which-jobs", NULL, "all");
 
-static void
-device_error_cb(const char *message,	// I - Error message
-                void       *err_data)	// I - Callback data (unused)
-{
-  (void)err_data;
+    ippDelete(cupsDoRequest(http, request, "/ipp/print"));
 
-  printf("testpappl: %s\n", message);
+    if (cupsLastError() >= IPP_STATUS_ERROR_BAD_REQUEST)
+      bc->errors ++;
+    else
+      bc->requests ++;
+  }
+
+  httpClose(http);
+
+  return (NULL);
 }
 
 
 //
-// 'device_list_cb()' - List a device.
+// 'bench_compress()' - Benchmark the line compression functions.
+//
+// Each method is compared against a simple byte-at-a-time encoder over the
+// same set of lines, and the compressed lines are checked by decompressing
+// them.
 //
 
-static bool				// O - `true` to stop, `false` to continue
-device_list_cb(const char *device_info,	// I - Device description
-               const char *device_uri,	// I - Device URI
-               const char *device_id,	// I - IEEE-1284 device ID
-               void       *data)	// I - Callback data (unused)
+static bool				// O - `true` on success, `false` on failure
+bench_compress(cups_file_t *csv)	// I - CSV results file
 {
-  (void)data;
+  bool		ret = false;		// Return value
+  unsigned char	*lines = NULL,		// Test lines
+		*buffer = NULL,		// Compressed line
+		*line = NULL;		// Decompressed line
+  int		i,			// Looping var
+		pass;			// Current pass (0 = naive, 1 = library)
+  unsigned	y,			// Current line
+		reps;			// Current repetition
+  size_t	count,			// Bytes in compressed line
+		total;			// Total compressed bytes
+  double	start,			// Start time
+		rate[2];		// Throughput in MB/sec
+  static const size_t bytes = 1024;	// Bytes per line
+  static const unsigned num_lines = 256,// Number of lines
+		num_reps = 100;		// Number of repetitions
+  static const pappl_devcomp_t comps[] =// Compression methods
+  {
+    PAPPL_DEVCOMP_PACKBITS,
+    PAPPL_DEVCOMP_DELTAROW,
+    PAPPL_DEVCOMP_ZPL
+  };
+  static const char * const names[] =	// Compression names
+  {
+    "packbits",
+    "deltarow",
+    "zpl"
+  };
 
-  printf("%s\n    %s\n    %s\n", device_info, device_uri, device_id);
 
-  return (false);
+  lines  = malloc(num_lines * bytes);
+  buffer = malloc(PAPPL_DEVCOMP_BUFSIZE(bytes));
+  line   = malloc(bytes);
+
+  if (!lines || !buffer || !line)
+  {
+    puts("FAIL (unable to allocate memory)");
+    goto done;
+  }
+
+  make_lines(lines, num_lines, bytes);
+
+  for (i = 0; i < (int)(sizeof(comps) / sizeof(comps[0])); i ++)
+  {
+    printf("\nbench: %s ", names[i]);
+    fflush(stdout);
+
+    for (pass = 0; pass < 2; pass ++)
+    {
+      start = bench_time();
+
+      for (reps = 0, total = 0; reps < num_reps; reps ++)
+      {
+	for (y = 0; y < num_lines; y ++)
+	{
+	  if (pass)
+	    count = papplDeviceCompressLine(comps[i], lines + y * bytes, y ? lines + (y - 1) * bytes : NULL, bytes, buffer);
+	  else
+	    count = compress_naive(comps[i], lines + y * bytes, y ? lines + (y - 1) * bytes : NULL, bytes, buffer);
+
+	  if (reps == 0 && comps[i] != PAPPL_DEVCOMP_ZPL)
+	  {
+	    // Check the compressed line...
+	    if (y && comps[i] == PAPPL_DEVCOMP_DELTAROW)
+	      memcpy(line, lines + (y - 1) * bytes, bytes);
+	    else
+	      memset(line, 0, bytes);
+
+	    if (!decompress_line(comps[i], buffer, count, line, bytes) || memcmp(line, lines + y * bytes, bytes))
+	    {
+	      printf("FAIL (%s line %u does not match)\n", pass ? "library" : "naive", y);
+	      goto done;
+	    }
+	  }
+
+	  total += count;
+	}
+      }
+
+      rate[pass] = (double)num_reps * num_lines * bytes / (bench_time() - start) / 1048576.0;
+
+      printf("%s=%.1fMB/sec (%.1f%%) ", pass ? "library" : "naive", rate[pass], 100.0 * total / ((double)num_reps * num_lines * bytes));
+    }
+
+    printf("speedup=%.2fx", rate[1] / rate[0]);
+
+    cupsFilePrintf(csv, "compress-%s-naive,%.1f,MB/sec\n", names[i], rate[0]);
+    cupsFilePrintf(csv, "compress-%s,%.1f,MB/sec\n", names[i], rate[1]);
+  }
+
+  ret = true;
+
+  done:
+
+  free(lines);
+  free(buffer);
+  free(line);
+
+  return (ret);
 }
 
 
 //
-// 'do_ps_query()' - Try doing a simple PostScript device query.
+// 'bench_files()' - Benchmark printing of image files.
 //
 
-static int				// O - Exit status
-do_ps_query(const char *device_uri)	// I - Device URI
+static bool				// O - `true` on success, `false` on failure
+bench_files(http_t            *http,	// I - HTTP connection
+            const char        *uri,	// I - "printer-uri" value
+            cups_file_t       *csv,	// I - CSV results file
+            const char        *name,	// I - Benchmark name
+            const char        *format,	// I - MIME media type of files
+            int               num_files,// I - Number of files
+            const char * const *files)	// I - Files
 {
-  pappl_device_t	*device;	// Connection to device
-  char			buffer[8192];	// Read buffer
-  ssize_t		bytes;		// Bytes read
-
+  int		i;			// Looping var
+  struct stat	fileinfo;		// File information
+  double	elapsed,		// Time for current job
+		total = 0.0;		// Total time for all jobs
+  off_t		bytes = 0;		// Total file size
 
-  if ((device = papplDeviceOpen(device_uri, "ps-query", device_error_cb, NULL)) == NULL)
-    return (1);
 
-  papplDevicePuts(device, "\033%-12345X%!\nproduct print\n");
-  papplDeviceFlush(device);
+  printf("\nbench: %s ", name);
+  fflush(stdout);
 
-  if ((bytes = papplDeviceRead(device, buffer, sizeof(buffer) - 1)) > 0)
-  {
-    buffer[bytes] = '\0';
-    puts(buffer);
-  }
-  else
+  for (i = 0; i < num_files; i ++)
   {
-    puts("<<no response>>");
+    if (stat(files[i], &fileinfo))
+    {
+      printf("FAIL (%s: %s)\n", files[i], strerror(errno));
+      return (false);
+    }
+
+    if (!bench_print_job(http, uri, files[i], format, &elapsed))
+      return (false);
+
+    bytes += fileinfo.st_size;
+    total += elapsed;
   }
 
-  papplDeviceClose(device);
-  return (0);
+  printf("%.2f jobs/sec, %.2f MB/sec", num_files / total, bytes / total / 1048576.0);
+
+  cupsFilePrintf(csv, "%s-jobs-per-second,%.3f,jobs/sec\n", name, num_files / total);
+  cupsFilePrintf(csv, "%s-bytes-per-second,%.0f,bytes/sec\n", name, bytes / total);
+
+  return (true);
 }
 
 
 //
-// 'make_raster_file()' - Create a temporary PWG raster file.
-//
-// Note: Adapted from CUPS "testclient.c"...
+// 'bench_print_job()' - Print a file and wait for the job to complete.
 //
 
-static const char *                     // O - Print filename
-make_raster_file(ipp_t      *response,  // I - Printer attributes
-                 bool       grayscale,  // I - Force grayscale?
-                 char       *tempname,  // I - Temporary filename buffer
-                 size_t     tempsize)   // I - Size of temp file buffer
+static bool				// O - `true` on success, `false` on failure
+bench_print_job(http_t     *http,	// I - HTTP connection
+                const char *uri,	// I - "printer-uri" value
+                const char *filename,	// I - File to print
+                const char *format,	// I - MIME media type of file
+                double     *elapsed)	// O - Seconds from submission to completion
 {
-  int                   i,              // Looping var
-                        count;          // Number of values
-  ipp_attribute_t       *attr;          // Printer attribute
-  const char            *type = NULL;   // Raster type (colorspace + bits)
-  pwg_media_t           *media = NULL;  // Media size
-  int                   xdpi = 0,       // Horizontal resolution
-                        ydpi = 0;       // Vertical resolution
-  int                   fd;             // Temporary file
-  cups_raster_t         *ras;           // Raster stream
-  cups_page_header2_t   header;         // Page header
-  unsigned char         *line,          // Line of raster data
-                        *lineptr;       // Pointer into line
-  unsigned              y,              // Current position on page
-                        xcount, ycount, // Current count for X and Y
-                        xrep, yrep,     // Repeat count for X and Y
-                        xoff, yoff,     // Offsets for X and Y
-                        yend;           // End Y value
-  int                   temprow,        // Row in template
-                        tempcolor;      // Template color
-  const char            *template;      // Pointer into template
-  const unsigned char   *color;         // Current color
-  static const unsigned char colors[][3] =
-  {                                     // Colors for test
-    { 191, 191, 191 },
-    { 127, 127, 127 },
-    {  63,  63,  63 },
-    {   0,   0,   0 },
-    { 255,   0,   0 },
-    { 255, 127,   0 },
-    { 255, 255,   0 },
-    { 127, 255,   0 },
-    {   0, 255,   0 },
-    {   0, 255, 127 },
-    {   0, 255, 255 },
-    {   0, 127, 255 },
-    {   0,   0, 255 },
-    { 127,   0, 255 },
-    { 255,   0, 255 }
-  };
-  static const char * const templates[] =
-  {                                     // Raster template
-    "PPPP     A    PPPP   PPPP   L      TTTTT  EEEEE   SSS   TTTTT          000     1     222    333      4   55555   66    77777   888    999   ",
-    "P   P   A A   P   P  P   P  L        T    E      S   S    T           0   0   11    2   2  3   3  4  4   5      6          7  8   8  9   9  ",
-    "P   P  A   A  P   P  P   P  L        T    E      S        T           0   0    1        2      3  4  4   5      6         7   8   8  9   9  ",
-    "PPPP   AAAAA  PPPP   PPPP   L        T    EEEE    SSS     T           0 0 0    1      22    333   44444   555   6666      7    888    9999  ",
-    "P      A   A  P      P      L        T    E          S    T           0   0    1     2         3     4       5  6   6    7    8   8      9  ",
-    "P      A   A  P      P      L        T    E      S   S    T           0   0    1    2      3   3     4   5   5  6   6    7    8   8      9  ",
-    "P      A   A  P      P      LLLLL    T    EEEEE   SSS     T            000    111   22222   333      4    555    666     7     888     99   ",
-    "                                                                                                                                            "
-  };
+  double	start = bench_time();	// Start time
+  ipp_t		*request,		// IPP request
+		*response;		// IPP response
+  int		job_id;			// "job-id" value
+  ipp_jstate_t	job_state;		// "job-state" value
 
 
-  // Figure out the the media, resolution, and color mode...
-  if ((attr = ippFindAttribute(response, "media-ready", IPP_TAG_KEYWORD)) != NULL)
-  {
-    // Use ready media...
-    if (ippContainsString(attr, "na_letter_8.5x11in"))
-      media = pwgMediaForPWG("na_letter_8.5x11in");
-    else if (ippContainsString(attr, "iso_a4_210x297mm"))
-      media = pwgMediaForPWG("iso_a4_210x297mm");
-    else
-      media = pwgMediaForPWG(ippGetString(attr, 0, NULL));
-  }
-  else if ((attr = ippFindAttribute(response, "media-default", IPP_TAG_KEYWORD)) != NULL)
-  {
-    // Use default media...
-    media = pwgMediaForPWG(ippGetString(attr, 0, NULL));
-  }
-  else
+  request = ippNewRequest(IPP_OP_PRINT_JOB);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_MIMETYPE, "document-format", NULL, format);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "job-name", NULL, "bench");
+
+  response = cupsDoFileRequest(http, request, "/ipp/print", filename);
+
+  if (cupsLastError() >= IPP_STATUS_ERROR_BAD_REQUEST)
   {
-    puts("FAIL (No default or ready media reported by printer)");
-    return (NULL);
+    printf("FAIL (Unable to print %s: %s)\n", filename, cupsLastErrorString());
+    ippDelete(response);
+    return (false);
   }
 
-  if ((attr = ippFindAttribute(response, "pwg-raster-document-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
+  job_id = ippGetInteger(ippFindAttribute(response, "job-id", IPP_TAG_INTEGER), 0);
+
+  ippDelete(response);
+
+  // Poll job status until completed, often enough to resolve the latency to a
+  // millisecond...
+  do
   {
-    for (i = 0, count = ippGetCount(attr); i < count; i ++)
-    {
-      int tempxdpi, tempydpi;
-      ipp_res_t tempunits;
+    usleep(1000);
 
-      tempxdpi = ippGetResolution(attr, 0, &tempydpi, &tempunits);
+    request = ippNewRequest(IPP_OP_GET_JOB_ATTRIBUTES);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", job_id);
+    ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", NULL, "job-state");
 
-      if (i == 0 || tempxdpi < xdpi || tempydpi < ydpi)
-      {
-        xdpi = tempxdpi;
-        ydpi = tempydpi;
-      }
-    }
+    response = cupsDoRequest(http, request, "/ipp/print");
 
-    if ((attr = ippFindAttribute(response, "pwg-raster-document-type-supported", IPP_TAG_KEYWORD)) != NULL)
+    if (cupsLastError() >= IPP_STATUS_ERROR_BAD_REQUEST)
     {
-      if (!grayscale && ippContainsString(attr, "srgb_8"))
-        type = "srgb_8";
-      else if (ippContainsString(attr, "sgray_8"))
-        type = "sgray_8";
+      printf("FAIL (Unable to get job state for job %d: %s)\n", job_id, cupsLastErrorString());
+      ippDelete(response);
+      return (false);
     }
-  }
 
-  if (xdpi < 72 || ydpi < 72)
-  {
-    puts("FAIL (No supported raster resolutions)");
-    return (NULL);
+    job_state = (ipp_jstate_t)ippGetInteger(ippFindAttribute(response, "job-state", IPP_TAG_ENUM), 0);
+
+    ippDelete(response);
   }
+  while (job_state < IPP_JSTATE_CANCELED);
 
-  if (!type)
+  if (job_state != IPP_JSTATE_COMPLETED)
   {
-    puts("FAIL (No supported color spaces or bit depths)");
-    return (NULL);
+    printf("FAIL (Job %d for %s was not completed)\n", job_id, filename);
+    return (false);
   }
 
-  // Make the raster context and details...
+  *elapsed = bench_time() - start;
+
+  return (true);
+}
+
+
+//
+// 'bench_time()' - Get the current time in seconds.
+//
+
+static double				// O - Current time in seconds
+bench_time(void)
+{
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((double)curtime.tv_sec + 0.000001 * curtime.tv_usec);
+}
+
+
+//
+// 'compare_doubles()' - Compare two double values for sorting.
+//
+
+static int				// O - Result of comparison
+compare_doubles(double *a,		// I - First value
+                double *b)		// I - Second value
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'compare_files()' - Compare the contents of two files.
+//
+
+static bool				// O - `true` if the files are the same, `false` otherwise
+compare_files(const char *a,		// I - First file
+              const char *b)		// I - Second file
+{
+  bool		ret = true;		// Return value
+  cups_file_t	*fpa,			// First file
+		*fpb;			// Second file
+  char		bufa[8192],		// Buffer for first file
+		bufb[8192];		// Buffer for second file
+  ssize_t	na,			// Bytes read from first file
+		nb;			// Bytes read from second file
+
+
+  if ((fpa = cupsFileOpen(a, "r")) == NULL)
+    return (false);
+
+  if ((fpb = cupsFileOpen(b, "r")) == NULL)
+  {
+    cupsFileClose(fpa);
+    return (false);
+  }
+
+  do
+  {
+    na = cupsFileRead(fpa, bufa, sizeof(bufa));
+    nb = cupsFileRead(fpb, bufb, sizeof(bufb));
+
+    if (na != nb || (na > 0 && memcmp(bufa, bufb, (size_t)na)))
+      ret = false;
+  }
+  while (ret && na > 0);
+
+  cupsFileClose(fpa);
+  cupsFileClose(fpb);
+
+  return (ret);
+}
+
+
+//
+// 'compress_naive()' - Compress a line one byte at a time.
+//
+// These are the loops drivers typically use and give a baseline for the
+// library functions.
+//
+
+static size_t				// O - Number of bytes in compressed line
+compress_naive(
+    pappl_devcomp_t     comp,		// I - Compression method
+    const unsigned char *line,		// I - Line to compress
+    const unsigned char *prev,		// I - Previous line or `NULL`
+    size_t              bytes,		// I - Number of bytes in line
+    unsigned char       *buffer)	// I - Output buffer
+{
+  unsigned char	*bufptr = buffer;	// Pointer into buffer
+  size_t	i,			// Current byte
+		start,			// Start of run
+		count,			// Bytes in run
+		last,			// End of last replacement
+		offset;			// Offset from last replacement
+
+
+  switch (comp)
+  {
+    case PAPPL_DEVCOMP_PACKBITS :
+        for (i = 0; i < bytes; i += count)
+        {
+          if ((i + 1) < bytes && line[i] == line[i + 1])
+          {
+            for (count = 2; count < 128 && (i + count) < bytes && line[i + count] == line[i]; count ++);
+
+            *bufptr++ = (unsigned char)(257 - count);
+            *bufptr++ = line[i];
+          }
+          else
+          {
+            for (count = 1; count < 128 && (i + count) < bytes && ((i + count + 2) >= bytes || line[i + count] != line[i + count + 1] || line[i + count] != line[i + count + 2]); count ++);
+
+            *bufptr++ = (unsigned char)(count - 1);
+            memcpy(bufptr, line + i, count);
+            bufptr += count;
+          }
+        }
+        break;
+
+    case PAPPL_DEVCOMP_DELTAROW :
+        for (i = 0, last = 0; i < bytes;)
+        {
+          if (line[i] == (prev ? prev[i] : 0))
+          {
+            i ++;
+            continue;
+          }
+
+          for (start = i, count = 0; count < 8 && i < bytes && line[i] != (prev ? prev[i] : 0); count ++, i ++);
+
+          if ((offset = start - last) < 31)
+            *bufptr++ = (unsigned char)(((count - 1) << 5) | offset);
+          else
+          {
+            *bufptr++ = (unsigned char)(((count - 1) << 5) | 31);
+
+            for (offset -= 31; offset >= 255; offset -= 255)
+              *bufptr++ = 255;
+
+            *bufptr++ = (unsigned char)offset;
+          }
+
+          memcpy(bufptr, line + start, count);
+          bufptr += count;
+          last   = i;
+        }
+        break;
+
+    case PAPPL_DEVCOMP_ZPL :
+        {
+          static const char hex[] = "0123456789ABCDEF";
+					// Hex digits
+          int digit;			// Current digit
+
+          // Repeat the previous line or encode runs of hex digits...
+          if (prev && !memcmp(line, prev, bytes))
+          {
+            *bufptr++ = ':';
+            break;
+          }
+
+	  for (i = 0; i < 2 * bytes; i += count)
+	  {
+	    digit = (i & 1) ? line[i / 2] & 15 : line[i / 2] >> 4;
+
+	    for (count = 1; (i + count) < 2 * bytes && (((i + count) & 1) ? line[(i + count) / 2] & 15 : line[(i + count) / 2] >> 4) == digit; count ++);
+
+	    if (digit == 0 && (i + count) == 2 * bytes)
+	    {
+	      *bufptr++ = ',';
+	      break;
+	    }
+
+	    if (count > 2)
+	    {
+	      for (start = count; start >= 400; start -= 400)
+	        *bufptr++ = 'z';
+	      if (start >= 20)
+	        *bufptr++ = (unsigned char)('f' + start / 20);
+	      if (start % 20)
+	        *bufptr++ = (unsigned char)('F' + start % 20);
+	    }
+	    else if (count == 2)
+	      *bufptr++ = (unsigned char)hex[digit];
+
+	    *bufptr++ = (unsigned char)hex[digit];
+	  }
+        }
+        break;
+
+    default :
+        memcpy(buffer, line, bytes);
+        bufptr += bytes;
+        break;
+  }
+
+  return ((size_t)(bufptr - buffer));
+}
+
+
+//
+// 'connect_to_printer()' - Connect to the system and return the printer URI.
+//
+
+static http_t *				// O - HTTP connection
+connect_to_printer(
+    pappl_system_t *system,		// I - System
+    char           *uri,		// I - URI buffer
+    size_t         urisize)		// I - Size of URI buffer
+{
+  httpAssembleURI(HTTP_URI_CODING_ALL, uri, (int)urisize, "ipp", NULL, "localhost", papplSystemGetPort(system), "/ipp/print");
+
+  return (httpConnect2("localhost", papplSystemGetPort(system), NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, 1, 30000, NULL));
+}
+
+
+//
+// 'convert_pixel()' - Convert one pixel the slow way for _papplConvertLine.
+//
+
+static size_t				// O - Number of bytes in converted pixel
+convert_pixel(
+    const cups_page_header2_t *in,	// I - Input page header
+    const cups_page_header2_t *out,	// I - Output page header
+    const unsigned char       *line,	// I - Input line
+    unsigned                  x,	// I - Column
+    unsigned char             *pixel)	// O - Converted pixel
+{
+  unsigned	c,			// Current color
+		channels;		// Number of colors
+  unsigned char	v[4];			// Color values
+  cups_cspace_t	cspace,			// Current color space
+		out_cspace;		// Output color space
+
+
+  // Get 8-bit color values...
+  channels = in->cupsBitsPerPixel / in->cupsBitsPerColor;
+
+  for (c = 0; c < channels; c ++)
+  {
+    if (in->cupsBitsPerColor == 16)
+      v[c] = (unsigned char)(((const unsigned short *)line)[x * channels + c] >> 8);
+    else if (in->cupsBitsPerColor == 8)
+      v[c] = line[x * channels + c];
+    else
+      v[c] = (line[x / 8] & (128 >> (x & 7))) ? 255 : 0;
+  }
+
+  // Map the color spaces to gray, black, RGB, and CMYK...
+  cspace     = in->cupsColorSpace == CUPS_CSPACE_SW ? CUPS_CSPACE_W : in->cupsColorSpace == CUPS_CSPACE_SRGB || in->cupsColorSpace == CUPS_CSPACE_ADOBERGB ? CUPS_CSPACE_RGB : in->cupsColorSpace;
+  out_cspace = out->cupsBitsPerColor == 1 ? CUPS_CSPACE_K : out->cupsColorSpace == CUPS_CSPACE_SW ? CUPS_CSPACE_W : out->cupsColorSpace == CUPS_CSPACE_SRGB || out->cupsColorSpace == CUPS_CSPACE_ADOBERGB ? CUPS_CSPACE_RGB : out->cupsColorSpace;
+
+  if (cspace == CUPS_CSPACE_CMYK)
+  {
+    for (c = 0; c < 3; c ++)
+      v[c] = (255 - v[c]) > v[3] ? (unsigned char)(255 - v[c] - v[3]) : 0;
+
+    cspace = CUPS_CSPACE_RGB;
+  }
+
+  if (cspace == CUPS_CSPACE_RGB && out_cspace != CUPS_CSPACE_RGB)
+  {
+    v[0]   = (unsigned char)((77 * v[0] + 150 * v[1] + 29 * v[2] + 128) >> 8);
+    cspace = CUPS_CSPACE_W;
+  }
+
+  if ((cspace == CUPS_CSPACE_W && out_cspace == CUPS_CSPACE_K) || (cspace == CUPS_CSPACE_K && out_cspace != CUPS_CSPACE_K))
+  {
+    v[0]   = (unsigned char)(255 - v[0]);
+    cspace = cspace == CUPS_CSPACE_W ? CUPS_CSPACE_K : CUPS_CSPACE_W;
+  }
+
+  if (cspace == CUPS_CSPACE_W && out_cspace == CUPS_CSPACE_RGB)
+  {
+    v[1]   = v[2] = v[0];
+    cspace = CUPS_CSPACE_RGB;
+  }
+
+  channels = cspace == CUPS_CSPACE_RGB ? 3 : 1;
+  memcpy(pixel, v, channels);
+
+  return (channels);
+}
+
+
+//
+// 'decompress_line()' - Decompress a PackBits, delta row, or ZPL line.
+//
+// For delta row and ZPL data, "line" must contain the previous line.
+//
+
+static bool				// O - `true` on success, `false` on error
+decompress_line(
+    pappl_devcomp_t     comp,		// I - Compression method
+    const unsigned char *data,		// I - Compressed data
+    size_t              datalen,	// I - Length of compressed data
+    unsigned char       *line,		// I - Line buffer
+    size_t              bytes)		// I - Number of bytes in line
+{
+  const unsigned char	*end = data + datalen;
+					// End of data
+  size_t		i = 0,		// Current byte
+			count,		// Number of bytes
+			offset;		// Offset for delta row
+
+
+  if (comp == PAPPL_DEVCOMP_ZPL)
+  {
+    // ZPL compressed ASCII hex: "G" to "Y" and "g" to "z" add to the repeat
+    // count of the following hex digit, "," fills the rest of the line with
+    // zeros, and ":" repeats the previous line.  "i" counts hex digits...
+    if (datalen == 1 && *data == ':')
+      return (true);
+
+    memset(line, 0, bytes);
+
+    for (count = 0; data < end; data ++)
+    {
+      if (*data >= 'G' && *data <= 'Y')
+      {
+        count += (size_t)(*data - 'F');
+      }
+      else if (*data >= 'g' && *data <= 'z')
+      {
+        count += 20 * (size_t)(*data - 'f');
+      }
+      else if (*data == ',')
+      {
+        return ((data + 1) == end && count == 0 && !(i & 1));
+      }
+      else if (isxdigit(*data))
+      {
+        unsigned char digit = (unsigned char)(isdigit(*data) ? *data - '0' : *data - 'A' + 10);
+					// Value of digit
+
+        if (!isupper(*data) && !isdigit(*data))
+          return (false);
+
+        if (count == 0)
+          count = 1;
+
+        if ((i + count) > 2 * bytes)
+          return (false);
+
+        for (; count > 0; count --, i ++)
+        {
+          if (i & 1)
+            line[i / 2] |= digit;
+          else
+            line[i / 2] = (unsigned char)(digit << 4);
+        }
+      }
+      else
+        return (false);
+    }
+
+    return (count == 0 && i == 2 * bytes);
+  }
+
+  while (data < end)
+  {
+    if (comp == PAPPL_DEVCOMP_PACKBITS)
+    {
+      if (*data < 128)
+      {
+        count = (size_t)*data++ + 1;
+
+        if ((i + count) > bytes || (data + count) > end)
+          return (false);
+
+	memcpy(line + i, data, count);
+	data += count;
+      }
+      else
+      {
+        count = 257 - (size_t)*data++;
+
+        if ((i + count) > bytes || data >= end)
+          return (false);
+
+        memset(line + i, *data++, count);
+      }
+    }
+    else
+    {
+      count  = (size_t)(*data >> 5) + 1;
+      offset = *data++ & 31;
+
+      if (offset == 31)
+      {
+        do
+        {
+          if (data >= end)
+            return (false);
+
+          offset += *data;
+        }
+        while (*data++ == 255);
+      }
+
+      i += offset;
+
+      if ((i + count) > bytes || (data + count) > end)
+        return (false);
+
+      memcpy(line + i, data, count);
+      data += count;
+    }
+
+    i += count;
+  }
+
+  return (comp != PAPPL_DEVCOMP_PACKBITS || i == bytes);
+}
+
+
+//
+// 'device_error_cb()' - Show a device error message.
+//
+
+static void
+device_error_cb(const char *message,	// I - Error message
+                void       *err_data)	// I - Callback data (unused)
+{
+  (void)err_data;
+
+  printf("testpappl: %s\n", message);
+}
+
+
+//
+// 'device_list_cb()' - List a device.
+//
+
+static bool				// O - `true` to stop, `false` to continue
+device_list_cb(const char *device_info,	// I - Device description
+               const char *device_uri,	// I - Device URI
+               const char *device_id,	// I - IEEE-1284 device ID
+               void       *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  printf("%s\n    %s\n    %s\n", device_info, device_uri, device_id);
+
+  return (false);
+}
+
+
+//
+// 'do_ps_query()' - Try doing a simple PostScript device query.
+//
+
+static int				// O - Exit status
+do_ps_query(const char *device_uri)	// I - Device URI
+{
+  pappl_device_t	*device;	// Connection to device
+  char			buffer[8192];	// Read buffer
+  ssize_t		bytes;		// Bytes read
+
+
+  if ((device = papplDeviceOpen(device_uri, "ps-query", device_error_cb, NULL)) == NULL)
+    return (1);
+
+  papplDevicePuts(device, "\033%-12345X%!\nproduct print\n");
+  papplDeviceFlush(device);
+
+  if ((bytes = papplDeviceRead(device, buffer, sizeof(buffer) - 1)) > 0)
+  {
+    buffer[bytes] = '\0';
+    puts(buffer);
+  }
+  else
+  {
+    puts("<<no response>>");
+  }
+
+  papplDeviceClose(device);
+  return (0);
+}
+
+
+//
+// 'filter_image_file()' - Print an image to a file.
+//
+// The image is printed with @code papplJobFilterImage@ when "rows" is `false`
+// or read a line at a time with @code papplJobFilterImageRows@ when "rows" is
+// `true`.
+//
+
+static bool				// O - `true` on success, `false` on failure
+filter_image_file(
+    pappl_job_t         *job,		// I - Job
+    const char          *filename,	// I - Output file
+    ipp_orient_t        orient,		// I - "orientation-requested" value
+    int                 copies,		// I - Number of copies
+    const unsigned char *pixels,	// I - sRGB image
+    int                 width,		// I - Width of image
+    int                 height,		// I - Height of image
+    bool                rows)		// I - Read the image a line at a time?
+{
+  bool			ret;		// Return value
+  char			uri[1024];	// Device URI
+  pappl_device_t	*device;	// Output device
+  pappl_pr_options_t	*options;	// Print options
+  _pappl_testimage_t	image;		// Row callback data
+
+
+  // The file device appends to existing files...
+  unlink(filename);
+  httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), "file", NULL, NULL, 0, filename);
+
+  if ((device = papplDeviceOpen(uri, "image", device_error_cb, NULL)) == NULL)
+    return (false);
+
+  // The image filter updates the options, so create them for every image...
+  if ((options = papplJobCreatePrintOptions(job, 1, true)) == NULL)
+  {
+    papplDeviceClose(device);
+    return (false);
+  }
+
+  options->copies                = copies;
+  options->orientation_requested = orient;
+  options->print_scaling         = PAPPL_SCALING_FIT;
+
+  if (rows)
+  {
+    image.pixels  = pixels;
+    image.rowsize = 3 * (size_t)width;
+    image.y       = 0;
+    image.height  = height;
+
+    ret = papplJobFilterImageRows(job, device, options, (pappl_image_row_cb_t)image_row_cb, &image, width, height, 3, 0, true);
+  }
+  else
+  {
+    ret = papplJobFilterImage(job, device, options, pixels, width, height, 3, 0, true);
+  }
+
+  papplJobDeletePrintOptions(options);
+  papplDeviceClose(device);
+
+  return (ret);
+}
+
+
+//
+// 'image_row_cb()' - Copy the next line of a test image.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_row_cb(_pappl_testimage_t *image,	// I - Row callback data
+             unsigned char      *row)	// I - Line buffer
+{
+  if (image->y >= image->height)
+    return (false);
+
+  memcpy(row, image->pixels + (size_t)image->y * image->rowsize, image->rowsize);
+  image->y ++;
+
+  return (true);
+}
+
+
+//
+// 'make_lines()' - Make lines of bitmap data for testing compression.
+//
+// The lines look like a label or text page: a blank margin, repeated lines,
+// solid bars, and pseudo-random glyphs.
+//
+
+static void
+make_lines(unsigned char *lines,	// I - Line buffer
+           unsigned      num_lines,	// I - Number of lines
+           size_t        bytes)		// I - Bytes per line
+{
+  unsigned	y;			// Current line
+  size_t	x;			// Current byte
+  unsigned	seed = 1;		// Pseudo-random number seed
+  unsigned char	*line;			// Current line
+
+
+  for (y = 0, line = lines; y < num_lines; y ++, line += bytes)
+  {
+    memset(line, 0, bytes);
+
+    if ((y & 31) < 4)
+      continue;				// Blank lines between rows
+
+    if ((y & 7) == 5 && y > 0)
+    {
+      memcpy(line, line - bytes, bytes);// Repeated line
+      continue;
+    }
+
+    for (x = bytes / 16; x < (bytes - bytes / 16); x ++)
+    {
+      if ((y & 31) == 4)
+        line[x] = 0xff;			// Solid bar
+      else if ((x & 15) < 10)
+      {
+        seed    = seed * 1103515245 + 12345;
+        line[x] = (unsigned char)(seed >> 16);
+      }
+    }
+  }
+}
+
+
+//
+// 'make_raster_file()' - Create a temporary PWG raster file.
+//
+// Note: Adapted from CUPS "testclient.c"...
+//
+
+static const char *                     // O - Print filename
+make_raster_file(ipp_t      *response,  // I - Printer attributes
+                 bool       grayscale,  // I - Force grayscale?
+                 char       *tempname,  // I - Temporary filename buffer
+                 size_t     tempsize)   // I - Size of temp file buffer
+{
+  int                   i,              // Looping var
+                        count;          // Number of values
+  ipp_attribute_t       *attr;          // Printer attribute
+  const char            *type = NULL;   // Raster type (colorspace + bits)
+  pwg_media_t           *media = NULL;  // Media size
+  int                   xdpi = 0,       // Horizontal resolution
+                        ydpi = 0;       // Vertical resolution
+  int                   fd;             // Temporary file
+  cups_raster_t         *ras;           // Raster stream
+  cups_page_header2_t   header;         // Page header
+  unsigned char         *line,          // Line of raster data
+                        *lineptr;       // Pointer into line
+  unsigned              y,              // Current position on page
+                        xcount, ycount, // Current count for X and Y
+                        xrep, yrep,     // Repeat count for X and Y
+                        xoff, yoff,     // Offsets for X and Y
+                        yend;           // End Y value
+  int                   temprow,        // Row in template
+                        tempcolor;      // Template color
+  const char            *template;      // Pointer into template
+  const unsigned char   *color;         // Current color
+  static const unsigned char colors[][3] =
+  {                                     // Colors for test
+    { 191, 191, 191 },
+    { 127, 127, 127 },
+    {  63,  63,  63 },
+    {   0,   0,   0 },
+    { 255,   0,   0 },
+    { 255, 127,   0 },
+    { 255, 255,   0 },
+    { 127, 255,   0 },
+    {   0, 255,   0 },
+    {   0, 255, 127 },
+    {   0, 255, 255 },
+    {   0, 127, 255 },
+    {   0,   0, 255 },
+    { 127,   0, 255 },
+    { 255,   0, 255 }
+  };
+  static const char * const templates[] =
+  {                                     // Raster template
+    "PPPP     A    PPPP   PPPP   L      TTTTT  EEEEE   SSS   TTTTT          000     1     222    333      4   55555   66    77777   888    999   ",
+    "P   P   A A   P   P  P   P  L        T    E      S   S    T           0   0   11    2   2  3   3  4  4   5      6          7  8   8  9   9  ",
+    "P   P  A   A  P   P  P   P  L        T    E      S        T           0   0    1        2      3  4  4   5      6         7   8   8  9   9  ",
+    "PPPP   AAAAA  PPPP   PPPP   L        T    EEEE    SSS     T           0 0 0    1      22    333   44444   555   6666      7    888    9999  ",
+    "P      A   A  P      P      L        T    E          S    T           0   0    1     2         3     4       5  6   6    7    8   8      9  ",
+    "P      A   A  P      P      L        T    E      S   S    T           0   0    1    2      3   3     4   5   5  6   6    7    8   8      9  ",
+    "P      A   A  P      P      LLLLL    T    EEEEE   SSS     T            000    111   22222   333      4    555    666     7     888     99   ",
+    "                                                                                                                                            "
+  };
+
+
+  // Figure out the the media, resolution, and color mode...
+  if ((attr = ippFindAttribute(response, "media-ready", IPP_TAG_KEYWORD)) != NULL)
+  {
+    // Use ready media...
+    if (ippContainsString(attr, "na_letter_8.5x11in"))
+      media = pwgMediaForPWG("na_letter_8.5x11in");
+    else if (ippContainsString(attr, "iso_a4_210x297mm"))
+      media = pwgMediaForPWG("iso_a4_210x297mm");
+    else
+      media = pwgMediaForPWG(ippGetString(attr, 0, NULL));
+  }
+  else if ((attr = ippFindAttribute(response, "media-default", IPP_TAG_KEYWORD)) != NULL)
+  {
+    // Use default media...
+    media = pwgMediaForPWG(ippGetString(attr, 0, NULL));
+  }
+  else
+  {
+    puts("FAIL (No default or ready media reported by printer)");
+    return (NULL);
+  }
+
+  if ((attr = ippFindAttribute(response, "pwg-raster-document-resolution-supported", IPP_TAG_RESOLUTION)) != NULL)
+  {
+    for (i = 0, count = ippGetCount(attr); i < count; i ++)
+    {
+      int tempxdpi, tempydpi;
+      ipp_res_t tempunits;
+
+      tempxdpi = ippGetResolution(attr, 0, &tempydpi, &tempunits);
+
+      if (i == 0 || tempxdpi < xdpi || tempydpi < ydpi)
+      {
+        xdpi = tempxdpi;
+        ydpi = tempydpi;
+      }
+    }
+
+    if ((attr = ippFindAttribute(response, "pwg-raster-document-type-supported", IPP_TAG_KEYWORD)) != NULL)
+    {
+      if (!grayscale && ippContainsString(attr, "srgb_8"))
+        type = "srgb_8";
+      else if (ippContainsString(attr, "sgray_8"))
+        type = "sgray_8";
+    }
+  }
+
+  if (xdpi < 72 || ydpi < 72)
+  {
+    puts("FAIL (No supported raster resolutions)");
+    return (NULL);
+  }
+
+  if (!type)
+  {
+    puts("FAIL (No supported color spaces or bit depths)");
+    return (NULL);
+  }
+
+  // Make the raster context and details...
   if (!cupsRasterInitPWGHeader(&header, media, type, xdpi, ydpi, "one-sided", NULL))
   {
     printf("FAIL (Unable to initialize raster context: %s)\n", cupsRasterErrorString());
@@ -910,6 +1786,13 @@ run_tests(_pappl_testdata_t *testdata)	// I - Testing data
       else
         puts("PASS");
     }
+    else if (!strcmp(name, "bench"))
+    {
+      if (!test_bench(testdata->system))
+        ret = (void *)1;
+      else
+        puts("PASS");
+    }
     else if (!strcmp(name, "client"))
     {
       if (!test_client(testdata->system))
@@ -1072,6 +1955,29 @@ test_api(pappl_system_t *system)	// I - System
   else
     puts("PASS");
 
+  // papplSystemGet/SetAuthCacheTime
+  fputs("api: papplSystemGetAuthCacheTime: ", stdout);
+  if ((get_int = papplSystemGetAuthCacheTime(system)) != 60)
+  {
+    printf("FAIL (got %d, expected 60)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_int = 0; set_int <= 60; set_int += 30)
+  {
+    printf("api: papplSystemSetAuthCacheTime(%d): ", set_int);
+    papplSystemSetAuthCacheTime(system, set_int);
+    if ((get_int = papplSystemGetAuthCacheTime(system)) != set_int)
+    {
+      printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
   // papplSystemGet/SetContact
   fputs("api: papplSystemGetContact: ", stdout);
   if (!papplSystemGetContact(system, &get_contact))
@@ -1453,6 +2359,122 @@ test_api(pappl_system_t *system)	// I - System
       puts("PASS");
   }
 
+  // papplSystemGet/SetAcceptThreads
+  fputs("api: papplSystemGetAcceptThreads: ", stdout);
+  if ((get_int = papplSystemGetAcceptThreads(system)) != 2)
+  {
+    printf("FAIL (got %d, expected 2)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  fputs("api: papplSystemSetAcceptThreads(4): ", stdout);
+  papplSystemSetAcceptThreads(system, 4);
+  if ((get_int = papplSystemGetAcceptThreads(system)) != 2)
+  {
+    printf("FAIL (got %d, expected 2 while running)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  // papplSystemGet/SetMaxClients
+  fputs("api: papplSystemGetMaxClients: ", stdout);
+  if ((get_int = papplSystemGetMaxClients(system)) != 0)
+  {
+    printf("FAIL (got %d, expected 0)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_int = 100; set_int >= 0; set_int -= 50)
+  {
+    printf("api: papplSystemSetMaxClients(%d): ", set_int);
+    papplSystemSetMaxClients(system, set_int);
+    if ((get_int = papplSystemGetMaxClients(system)) != set_int)
+    {
+      printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  // papplSystemGet/SetMaxImageMemory
+  fputs("api: papplSystemGetMaxImageMemory: ", stdout);
+  if ((get_size = papplSystemGetMaxImageMemory(system)) != 0)
+  {
+    printf("FAIL (got %ld, expected 0)\n", (long)get_size);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_size = 16 * 1024 * 1024; set_size > 0; set_size -= 8 * 1024 * 1024)
+  {
+    printf("api: papplSystemSetMaxImageMemory(%ld): ", (long)set_size);
+    papplSystemSetMaxImageMemory(system, set_size);
+    if ((get_size = papplSystemGetMaxImageMemory(system)) != set_size)
+    {
+      printf("FAIL (got %ld, expected %ld)\n", (long)get_size, (long)set_size);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  papplSystemSetMaxImageMemory(system, 0);
+
+  // papplSystemGet/SetMaxImageThreads
+  fputs("api: papplSystemGetMaxImageThreads: ", stdout);
+  if ((get_int = papplSystemGetMaxImageThreads(system)) != 1)
+  {
+    printf("FAIL (got %d, expected 1)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_int = 4; set_int > 0; set_int -= 2)
+  {
+    printf("api: papplSystemSetMaxImageThreads(%d): ", set_int);
+    papplSystemSetMaxImageThreads(system, set_int);
+    if ((get_int = papplSystemGetMaxImageThreads(system)) != set_int)
+    {
+      printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  papplSystemSetMaxImageThreads(system, 1);
+
+  // papplSystemGet/SetMaxJobThreads
+  fputs("api: papplSystemGetMaxJobThreads: ", stdout);
+  if ((get_int = papplSystemGetMaxJobThreads(system)) != 0)
+  {
+    printf("FAIL (got %d, expected 0)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_int = 4; set_int >= 0; set_int -= 2)
+  {
+    printf("api: papplSystemSetMaxJobThreads(%d): ", set_int);
+    papplSystemSetMaxJobThreads(system, set_int);
+    if ((get_int = papplSystemGetMaxJobThreads(system)) != set_int)
+    {
+      printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
   // papplSystemGet/SetMaxLogSize
   fputs("api: papplSystemGetMaxLogSize: ", stdout);
   if ((get_size = papplSystemGetMaxLogSize(system)) != (size_t)(1024 * 1024))
@@ -1556,30 +2578,74 @@ test_api(pappl_system_t *system)	// I - System
   else
     puts("PASS");
 
-  for (i = 0; i < 10; i ++)
+  for (i = 0; i < 10; i ++)
+  {
+    snprintf(set_str, sizeof(set_str), "%c Team", i + 'A');
+    printf("api: papplSystemGet/SetOrganizationalUnit('%s'): ", set_str);
+    papplSystemSetOrganizationalUnit(system, set_str);
+    if (!papplSystemGetOrganizationalUnit(system, get_str, sizeof(get_str)))
+    {
+      printf("FAIL (got NULL, expected '%s')\n", set_str);
+      pass = false;
+    }
+    else if (strcmp(get_str, set_str))
+    {
+      printf("FAIL (got '%s', expected '%s')\n", get_str, set_str);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  fputs("api: papplSystemGet/SetOrganizationalUnit(NULL): ", stdout);
+  papplSystemSetOrganizationalUnit(system, NULL);
+  if (papplSystemGetOrganizationalUnit(system, get_str, sizeof(get_str)))
+  {
+    printf("FAIL (got '%s', expected NULL)\n", get_str);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  // papplSystemGet/SetSaveDelay
+  fputs("api: papplSystemGetSaveDelay: ", stdout);
+  if ((get_int = papplSystemGetSaveDelay(system)) != 1)
+  {
+    printf("FAIL (got %d, expected 1)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_int = 5; set_int >= 0; set_int -= 4)
   {
-    snprintf(set_str, sizeof(set_str), "%c Team", i + 'A');
-    printf("api: papplSystemGet/SetOrganizationalUnit('%s'): ", set_str);
-    papplSystemSetOrganizationalUnit(system, set_str);
-    if (!papplSystemGetOrganizationalUnit(system, get_str, sizeof(get_str)))
-    {
-      printf("FAIL (got NULL, expected '%s')\n", set_str);
-      pass = false;
-    }
-    else if (strcmp(get_str, set_str))
+    printf("api: papplSystemSetSaveDelay(%d): ", set_int);
+    papplSystemSetSaveDelay(system, set_int);
+    if ((get_int = papplSystemGetSaveDelay(system)) != set_int)
     {
-      printf("FAIL (got '%s', expected '%s')\n", get_str, set_str);
+      printf("FAIL (got %d, expected %d)\n", get_int, set_int);
       pass = false;
     }
     else
       puts("PASS");
   }
 
-  fputs("api: papplSystemGet/SetOrganizationalUnit(NULL): ", stdout);
-  papplSystemSetOrganizationalUnit(system, NULL);
-  if (papplSystemGetOrganizationalUnit(system, get_str, sizeof(get_str)))
+  // papplSystemGet/SetTracing
+  fputs("api: papplSystemGetTracing: ", stdout);
+  if (papplSystemGetTracing(system))
   {
-    printf("FAIL (got '%s', expected NULL)\n", get_str);
+    puts("FAIL (got true, expected false)");
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  // Leave tracing enabled so the job tests exercise the trace hooks...
+  fputs("api: papplSystemSetTracing(true): ", stdout);
+  papplSystemSetTracing(system, true);
+  if (!papplSystemGetTracing(system))
+  {
+    puts("FAIL (got false, expected true)");
     pass = false;
   }
   else
@@ -1792,6 +2858,623 @@ test_api(pappl_system_t *system)	// I - System
     }
   }
 
+  // papplDeviceCompressLine
+  fputs("api: papplDeviceCompressLine: ", stdout);
+  {
+    unsigned char	lines[64][256],	// Test lines
+			buffer[PAPPL_DEVCOMP_BUFSIZE(256)],
+					// Compressed line
+			line[256];	// Decompressed line
+    size_t		count;		// Bytes in compressed line
+
+    make_lines(lines[0], 64, sizeof(lines[0]));
+
+    for (i = 0; i < 64; i ++)
+    {
+      count = papplDeviceCompressLine(PAPPL_DEVCOMP_PACKBITS, lines[i], NULL, sizeof(lines[i]), buffer);
+      memset(line, 0, sizeof(line));
+
+      if (!decompress_line(PAPPL_DEVCOMP_PACKBITS, buffer, count, line, sizeof(line)) || memcmp(line, lines[i], sizeof(line)))
+      {
+        printf("FAIL (PackBits line %d does not match)\n", i);
+        pass = false;
+        break;
+      }
+
+      count = papplDeviceCompressLine(PAPPL_DEVCOMP_DELTAROW, lines[i], i ? lines[i - 1] : NULL, sizeof(lines[i]), buffer);
+
+      if (i)
+        memcpy(line, lines[i - 1], sizeof(line));
+      else
+        memset(line, 0, sizeof(line));
+
+      if (!decompress_line(PAPPL_DEVCOMP_DELTAROW, buffer, count, line, sizeof(line)) || memcmp(line, lines[i], sizeof(line)))
+      {
+        printf("FAIL (delta row line %d does not match)\n", i);
+        pass = false;
+        break;
+      }
+
+      count = papplDeviceCompressLine(PAPPL_DEVCOMP_ZPL, lines[i], i ? lines[i - 1] : NULL, sizeof(lines[i]), buffer);
+
+      if (i)
+        memcpy(line, lines[i - 1], sizeof(line));
+      else
+        memset(line, 0, sizeof(line));
+
+      if (!decompress_line(PAPPL_DEVCOMP_ZPL, buffer, count, line, sizeof(line)) || memcmp(line, lines[i], sizeof(line)))
+      {
+        printf("FAIL (ZPL line %d does not match)\n", i);
+        pass = false;
+        break;
+      }
+    }
+
+    if (i >= 64)
+    {
+      memset(line, 0, sizeof(line));
+
+      if ((count = papplDeviceCompressLine(PAPPL_DEVCOMP_ZPL, line, NULL, sizeof(line), buffer)) != 1 || buffer[0] != ',')
+      {
+        puts("FAIL (blank ZPL line not ',')");
+        pass = false;
+      }
+      else if ((count = papplDeviceCompressLine(PAPPL_DEVCOMP_ZPL, lines[5], lines[5], sizeof(lines[5]), buffer)) != 1 || buffer[0] != ':')
+      {
+        puts("FAIL (repeated ZPL line not ':')");
+        pass = false;
+      }
+      else if (!papplDeviceIsBlankLine(line, sizeof(line), 0) || papplDeviceIsBlankLine(lines[4], sizeof(lines[4]), 0))
+      {
+        puts("FAIL (papplDeviceIsBlankLine)");
+        pass = false;
+      }
+      else
+        puts("PASS");
+    }
+  }
+
+  // _papplConvertLine
+  fputs("api: _papplConvertLine: ", stdout);
+  {
+    _pappl_convert_t	conv;		// Conversion
+    cups_page_header2_t	in,		// Input page header
+			out;		// Output page header
+    int			k;		// Looping var
+    unsigned		width,		// Width of line
+			x;		// Current column
+    size_t		bpp;		// Bytes per converted pixel
+    unsigned short	src[67 * 4];	// Input line (aligned for 16-bit values)
+    unsigned char	dst[67 * _PAPPL_CONVERT_BPP],
+					// Converted line
+			pixel[4];	// Expected pixel
+    bool		convert_pass = true;
+					// Pass/fail for the conversions
+    static const cups_cspace_t cspaces[] =
+    {					// Input and output color spaces
+      CUPS_CSPACE_W,
+      CUPS_CSPACE_SW,
+      CUPS_CSPACE_K,
+      CUPS_CSPACE_RGB,
+      CUPS_CSPACE_SRGB,
+      CUPS_CSPACE_CMYK
+    };
+    static const unsigned bits[] = { 1, 8, 16 };
+					// Input and output bits per color
+
+
+    // Try every input and output format, using widths that include partial
+    // SIMD blocks...
+    for (i = 0; i < (int)(sizeof(cspaces) / sizeof(cspaces[0])) && convert_pass; i ++)
+    {
+      for (j = 0; j < (int)(sizeof(bits) / sizeof(bits[0])) && convert_pass; j ++)
+      {
+        memset(&in, 0, sizeof(in));
+        in.cupsColorSpace   = cspaces[i];
+        in.cupsBitsPerColor = bits[j];
+        in.cupsBitsPerPixel = bits[j] * (cspaces[i] == CUPS_CSPACE_CMYK ? 4 : cspaces[i] == CUPS_CSPACE_RGB || cspaces[i] == CUPS_CSPACE_SRGB ? 3 : 1);
+
+        for (k = 0; k < (int)(sizeof(cspaces) / sizeof(cspaces[0])) * 2 && convert_pass; k ++)
+        {
+          memset(&out, 0, sizeof(out));
+          out.cupsColorSpace   = cspaces[k / 2];
+          out.cupsBitsPerColor = (k & 1) ? 1 : 8;
+          out.cupsBitsPerPixel = out.cupsBitsPerColor * (cspaces[k / 2] == CUPS_CSPACE_CMYK ? 4 : cspaces[k / 2] == CUPS_CSPACE_RGB || cspaces[k / 2] == CUPS_CSPACE_SRGB ? 3 : 1);
+
+          if (!_papplConvertInit(&conv, &in, &out))
+          {
+            // Only CMYK output, 1-bit color output, and 1-bit color input
+            // are unsupported...
+            if (out.cupsColorSpace != CUPS_CSPACE_CMYK && !(out.cupsBitsPerColor == 1 && out.cupsBitsPerPixel > 1) && !(in.cupsBitsPerColor == 1 && in.cupsBitsPerPixel > 1))
+            {
+              printf("FAIL (%u-bit cspace %d to %u-bit cspace %d not supported)\n", in.cupsBitsPerColor, in.cupsColorSpace, out.cupsBitsPerColor, out.cupsColorSpace);
+              convert_pass = false;
+            }
+            continue;
+          }
+          else if (out.cupsColorSpace == CUPS_CSPACE_CMYK)
+          {
+            printf("FAIL (%u-bit cspace %d to CMYK supported)\n", in.cupsBitsPerColor, in.cupsColorSpace);
+            convert_pass = false;
+            continue;
+          }
+
+          for (width = 1; width <= 67 && convert_pass; width ++)
+          {
+            for (x = 0; x < (unsigned)(sizeof(src) / sizeof(src[0])); x ++)
+              src[x] = (unsigned short)TESTRAND;
+
+            _papplConvertLine(&conv, dst, (unsigned char *)src, width);
+
+            for (x = 0; x < width; x ++)
+            {
+              bpp = convert_pixel(&in, &out, (unsigned char *)src, x, pixel);
+
+              if (memcmp(dst + x * bpp, pixel, bpp))
+              {
+                printf("FAIL (%u-bit cspace %d to %u-bit cspace %d, width %u, pixel %u does not match)\n", in.cupsBitsPerColor, in.cupsColorSpace, out.cupsBitsPerColor, out.cupsColorSpace, width, x);
+                convert_pass = false;
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    if (convert_pass)
+      puts("PASS");
+    else
+      pass = false;
+  }
+
+  // _papplSNMPEncode/Decode
+  fputs("api: _papplSNMPEncode(GetBulkRequest): ", stdout);
+  {
+    _pappl_snmp_t	request,	// Encoded request
+			decoded;	// Decoded request
+    unsigned char	buffer[_PAPPL_SNMP_MAX_PACKET],
+					// Encoded packet
+			*bufptr;	// Next variable binding
+    int			bytes;		// Length of packet
+    static const int	prefix[] = { 1,3,6,1,2,1,43,11,1,1,9,-1 };
+					// prtMarkerSuppliesLevel
+
+
+    memset(&request, 0, sizeof(request));
+    request.version      = _PAPPL_SNMP_VERSION_2C;
+    request.request_type = _PAPPL_ASN1_GET_BULK_REQUEST;
+    request.request_id   = 42;
+    request.error_status = 0;
+    request.error_index  = _PAPPL_SNMP_MAX_REPETITIONS;
+    request.object_type  = _PAPPL_ASN1_NULL_VALUE;
+    strlcpy(request.community, _PAPPL_SNMP_COMMUNITY, sizeof(request.community));
+    _papplSNMPCopyOID(request.object_name, prefix, _PAPPL_SNMP_MAX_OID);
+
+    if ((bytes = _papplSNMPEncode(&request, buffer, sizeof(buffer))) <= 0)
+    {
+      printf("FAIL (%s)\n", request.error ? request.error : "unable to encode");
+      pass = false;
+    }
+    else if (_papplSNMPDecode(buffer, (size_t)bytes, &decoded, &bufptr))
+    {
+      printf("FAIL (%s)\n", decoded.error);
+      pass = false;
+    }
+    else if (decoded.version != _PAPPL_SNMP_VERSION_2C || strcmp(decoded.community, _PAPPL_SNMP_COMMUNITY) || decoded.request_type != _PAPPL_ASN1_GET_BULK_REQUEST || decoded.request_id != 42 || decoded.error_status != 0 || decoded.error_index != _PAPPL_SNMP_MAX_REPETITIONS)
+    {
+      printf("FAIL (got version=%d, community=\"%s\", request-type=0x%02x, request-id=%u, non-repeaters=%d, max-repetitions=%d)\n", decoded.version, decoded.community, decoded.request_type, decoded.request_id, decoded.error_status, decoded.error_index);
+      pass = false;
+    }
+    else if (!_papplSNMPIsOID(&decoded, prefix) || decoded.object_type != _PAPPL_ASN1_NULL_VALUE || bufptr != buffer + bytes)
+    {
+      puts("FAIL (bad variable binding)");
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  fputs("api: _papplSNMPDecode(GetResponse): ", stdout);
+  {
+    _pappl_snmp_t	response;	// Decoded response
+    unsigned char	*bufptr;	// Next variable binding
+    static unsigned char buffer[] =	// SNMPv2c response with two values
+    {
+      0x30, 0x37,			// SEQUENCE
+      0x02, 0x01, 0x01,			// version (SNMPv2c)
+      0x04, 0x06, 'p', 'u', 'b', 'l', 'i', 'c',
+					// community
+      0xa2, 0x2a,			// GetResponse-PDU
+      0x02, 0x01, 0x07,			// request-id
+      0x02, 0x01, 0x00,			// error-status
+      0x02, 0x01, 0x00,			// error-index
+      0x30, 0x1f,			// variable-bindings
+      0x30, 0x0f,			// VarBind
+      0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01, 0x01, 0x05, 0x00,
+					// sysName.0
+      0x04, 0x03, 'a', 'b', 'c',	// OCTET STRING
+      0x30, 0x0c,			// VarBind
+      0x06, 0x08, 0x2b, 0x06, 0x01, 0x02, 0x01, 0x01, 0x06, 0x00,
+					// sysLocation.0
+      0x82, 0x00			// endOfMibView
+    };
+    static const int	sysName[] = { 1,3,6,1,2,1,1,5,0,-1 };
+    static const int	sysLocation[] = { 1,3,6,1,2,1,1,6,0,-1 };
+
+
+    if (_papplSNMPDecode(buffer, sizeof(buffer), &response, &bufptr))
+    {
+      printf("FAIL (%s)\n", response.error);
+      pass = false;
+    }
+    else if (response.request_type != _PAPPL_ASN1_GET_RESPONSE || response.request_id != 7 || !_papplSNMPIsOID(&response, sysName) || response.object_type != _PAPPL_ASN1_OCTET_STRING || response.object_value.string.num_bytes != 3 || memcmp(response.object_value.string.bytes, "abc", 3))
+    {
+      puts("FAIL (bad first variable binding)");
+      pass = false;
+    }
+    else if (!bufptr || _papplSNMPDecodeVarbind(&bufptr, buffer + sizeof(buffer), &response))
+    {
+      printf("FAIL (%s)\n", response.error ? response.error : "no second variable binding");
+      pass = false;
+    }
+    else if (!_papplSNMPIsOID(&response, sysLocation) || response.object_type != _PAPPL_ASN1_END_OF_MIB_VIEW || bufptr != buffer + sizeof(buffer))
+    {
+      puts("FAIL (bad endOfMibView variable binding)");
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
+  // papplJobFilterImageRows
+  {
+    pappl_printer_t	*iprinter;	// Image test printer
+    pappl_job_t		*job;		// Image test job
+    unsigned char	*image,		// Test image
+			*ptr;		// Pointer into image
+    int			x, y,		// Looping vars
+			copies;		// Number of copies
+    int			memfd,		// Temporary file for in-memory output
+			rowfd;		// Temporary file for streamed output
+    char		memname[1024],	// In-memory output file
+			rowname[1024];	// Streamed output file
+    struct stat		meminfo;	// In-memory output file information
+    static const ipp_orient_t orients[] =
+    {					// "orientation-requested" values
+      IPP_ORIENT_PORTRAIT,
+      IPP_ORIENT_LANDSCAPE,
+      IPP_ORIENT_REVERSE_LANDSCAPE,
+      IPP_ORIENT_REVERSE_PORTRAIT
+    };
+
+
+    // Print a small gradient image with and without a memory limit that
+    // forces the image to be spooled and read back in bands...
+    fputs("api: papplJobFilterImageRows: ", stdout);
+
+    memfd = cupsTempFd(memname, sizeof(memname));
+    rowfd = cupsTempFd(rowname, sizeof(rowname));
+
+    if (memfd < 0 || rowfd < 0)
+    {
+      printf("FAIL (unable to create temporary files: %s)\n", strerror(errno));
+      pass = false;
+    }
+    else if ((image = malloc(3 * 256 * 192)) == NULL)
+    {
+      printf("FAIL (unable to allocate image: %s)\n", strerror(errno));
+      pass = false;
+    }
+    else
+    {
+      for (y = 0, ptr = image; y < 192; y ++)
+      {
+        for (x = 0; x < 256; x ++)
+        {
+          *ptr++ = (unsigned char)x;
+          *ptr++ = (unsigned char)(y * 255 / 191);
+          *ptr++ = (unsigned char)((x + y) & 255);
+        }
+      }
+
+      if ((iprinter = papplPrinterCreate(system, 0, "Image Test", "pwg_common-300dpi-srgb_8", "MFG:PWG;MDL:Office Printer;CMD:PWGRaster;", "file:///dev/null")) == NULL)
+      {
+        puts("FAIL (unable to create printer)");
+        pass = false;
+      }
+      else if ((job = _papplJobCreate(iprinter, 0, "test", "image/png", "image", NULL)) == NULL)
+      {
+        puts("FAIL (unable to create job)");
+        pass = false;
+      }
+      else
+      {
+        puts("PASS");
+
+        for (i = 0; i < (int)(sizeof(orients) / sizeof(orients[0])); i ++)
+        {
+          for (copies = 1; copies <= 2; copies ++)
+          {
+            printf("api: papplJobFilterImageRows(%s, copies=%d): ", ippEnumString("orientation-requested", (int)orients[i]), copies);
+
+            papplSystemSetMaxImageMemory(system, 0);
+
+            if (!filter_image_file(job, memname, orients[i], copies, image, 256, 192, false))
+            {
+              puts("FAIL (papplJobFilterImage failed)");
+              pass = false;
+              continue;
+            }
+
+            papplSystemSetMaxImageMemory(system, 4096);
+
+            if (!filter_image_file(job, rowname, orients[i], copies, image, 256, 192, true))
+            {
+              puts("FAIL (papplJobFilterImageRows failed)");
+              pass = false;
+            }
+            else if (stat(memname, &meminfo) || meminfo.st_size == 0)
+            {
+              puts("FAIL (no output)");
+              pass = false;
+            }
+            else if (!compare_files(memname, rowname))
+            {
+              puts("FAIL (output differs from papplJobFilterImage)");
+              pass = false;
+            }
+            else
+              puts("PASS");
+          }
+        }
+
+        papplSystemSetMaxImageMemory(system, 0);
+      }
+
+      if (iprinter)
+        papplPrinterDelete(iprinter);
+
+      free(image);
+    }
+
+    if (memfd >= 0)
+    {
+      close(memfd);
+      unlink(memname);
+    }
+
+    if (rowfd >= 0)
+    {
+      close(rowfd);
+      unlink(rowname);
+    }
+  }
+
+  // papplDeviceGetTimings
+  fputs("api: papplDeviceGetTimings: ", stdout);
+  {
+    pappl_device_t	*device;	// Device
+    pappl_devmetrics_t	metrics;	// Device metrics
+    pappl_devtimings_t	timings;	// Device timing metrics
+    size_t		reads,		// Number of timed reads
+			writes;		// Number of timed writes
+    char		buffer[8192];	// Write buffer
+
+
+    memset(buffer, 'x', sizeof(buffer));
+    memset(&timings, 1, sizeof(timings));
+
+    if (papplDeviceGetTimings(NULL, &timings) != &timings || timings.write_nsecs || timings.write_hist[0])
+    {
+      puts("FAIL (timings not cleared for NULL device)");
+      pass = false;
+    }
+    else if ((device = papplDeviceOpen("file:///dev/null", "timings", device_error_cb, NULL)) == NULL)
+    {
+      puts("FAIL (unable to open file:///dev/null)");
+      pass = false;
+    }
+    else
+    {
+      // Write a mix of buffered and direct writes...
+      for (i = 0; i < 10; i ++)
+      {
+        papplDeviceWrite(device, buffer, (size_t)(i + 1) * 100);
+        papplDeviceWrite(device, buffer, sizeof(buffer));
+      }
+
+      papplDeviceFlush(device);
+
+      papplDeviceGetMetrics(device, &metrics);
+      papplDeviceGetTimings(device, &timings);
+
+      for (j = 0, reads = 0, writes = 0; j < PAPPL_DEVTIMINGS_BUCKETS; j ++)
+      {
+        reads  += timings.read_hist[j];
+        writes += timings.write_hist[j];
+      }
+
+      if (!metrics.write_requests || writes != metrics.write_requests)
+      {
+        printf("FAIL (got %lu timed writes, expected %lu)\n", (unsigned long)writes, (unsigned long)metrics.write_requests);
+        pass = false;
+      }
+      else if (reads != metrics.read_requests)
+      {
+        printf("FAIL (got %lu timed reads, expected %lu)\n", (unsigned long)reads, (unsigned long)metrics.read_requests);
+        pass = false;
+      }
+      else if (timings.write_max_nsecs > timings.write_nsecs)
+      {
+        printf("FAIL (longest write %llu nsecs more than total %llu nsecs)\n", timings.write_max_nsecs, timings.write_nsecs);
+        pass = false;
+      }
+      else if (timings.write_stall_nsecs)
+      {
+        printf("FAIL (got write stall of %llu nsecs with no write in progress)\n", timings.write_stall_nsecs);
+        pass = false;
+      }
+      else
+        puts("PASS");
+
+      papplDeviceClose(device);
+    }
+  }
+
+  // papplClientHTMLPrintf
+  fputs("api: papplClientHTMLPrintf: ", stdout);
+  {
+    pappl_client_t	*client;	// Client for HTML output
+    static const char * const expected[] =
+    {					// Expected output
+      "12345678910",
+      "&lt;a>&amp;&quot;b&quot; 42    7 ff 3.1 100%",
+      "x: 1  2   3"
+    };
+
+
+    if ((client = (pappl_client_t *)calloc(1, sizeof(pappl_client_t))) == NULL)
+    {
+      puts("FAIL (unable to allocate client)");
+      pass = false;
+    }
+    else
+    {
+      client->system = system;
+
+      for (j = 0; j < (int)(sizeof(expected) / sizeof(expected[0])); j ++)
+      {
+        client->wused = 0;
+
+        // Use a fields-only format, a mix of flags/widths/precisions, and
+        // "*" widths...
+        if (j == 0)
+          papplClientHTMLPrintf(client, "%d%d%d%d%d%d%d%d%d%d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+        else if (j == 1)
+          papplClientHTMLPrintf(client, "%s%c%s %-5d%2d %x %.1f %d%%", "<a>", '&', "\"b\"", 42, 7, 255, 3.14159, 100);
+        else
+          papplClientHTMLPrintf(client, "x: %d%*d%*d", 1, 3, 2, 4, 3);
+
+        if (client->wused != strlen(expected[j]) || memcmp(client->wbuffer, expected[j], client->wused))
+        {
+          printf("FAIL (got '%.*s', expected '%s')\n", (int)client->wused, client->wbuffer, expected[j]);
+          pass = false;
+          break;
+        }
+      }
+
+      if (j >= (int)(sizeof(expected) / sizeof(expected[0])))
+        puts("PASS");
+
+      free(client);
+    }
+  }
+
+  // papplSystemFindLoc/papplClientGetLoc
+  fputs("api: papplSystemFindLoc: ", stdout);
+  {
+    pappl_loc_t		*loc,		// Localization catalog
+			*newloc;	// Replacement catalog
+    pappl_client_t	*client;	// Client for Accept-Language
+
+
+    papplSystemAddStringsData(system, "/testpappl-fr.strings", "fr", "/* Comment */\n\"a\" = \"A-fr\";\n// Comment\n\"media.na_letter_8.5x11in\" = \"Lettre US\";\n\"esc\" = \"x\\\"y\\n\";\n\"bad\" \"no equals\";\n");
+
+    if ((loc = papplSystemFindLoc(system, "fr-CA")) == NULL)
+    {
+      puts("FAIL (no catalog for 'fr-CA')");
+      pass = false;
+    }
+    else if (strcmp(papplLocGetLanguage(loc), "fr"))
+    {
+      printf("FAIL (got language '%s', expected 'fr')\n", papplLocGetLanguage(loc));
+      pass = false;
+    }
+    else if (papplSystemFindLoc(system, "de") != NULL)
+    {
+      puts("FAIL (got catalog for 'de')");
+      pass = false;
+    }
+    else if (strcmp(papplLocGetString(loc, "a"), "A-fr") || strcmp(papplLocGetString(loc, "media.na_letter_8.5x11in"), "Lettre US") || strcmp(papplLocGetString(loc, "esc"), "x\"y\n"))
+    {
+      printf("FAIL (got '%s', '%s', and '%s')\n", papplLocGetString(loc, "a"), papplLocGetString(loc, "media.na_letter_8.5x11in"), papplLocGetString(loc, "esc"));
+      pass = false;
+    }
+    else if (strcmp(papplLocGetString(loc, "bad"), "bad") || strcmp(papplLocGetString(loc, "no-such-key"), "no-such-key"))
+    {
+      printf("FAIL (got '%s' and '%s' for missing keys)\n", papplLocGetString(loc, "bad"), papplLocGetString(loc, "no-such-key"));
+      pass = false;
+    }
+    else if (strcmp(papplLocGetString(loc, "media.iso_a4_210x297mm"), "A4") || strcmp(papplLocGetString(NULL, "media.na_letter_8.5x11in"), "US Letter"))
+    {
+      printf("FAIL (got '%s' and '%s' for built-in strings)\n", papplLocGetString(loc, "media.iso_a4_210x297mm"), papplLocGetString(NULL, "media.na_letter_8.5x11in"));
+      pass = false;
+    }
+    else if ((client = (pappl_client_t *)calloc(1, sizeof(pappl_client_t))) == NULL)
+    {
+      puts("FAIL (unable to allocate client)");
+      pass = false;
+    }
+    else
+    {
+      // Use the first Accept-Language entry we have strings for, then make
+      // sure replacing the strings doesn't free the catalog in use...
+      client->system = system;
+
+      if ((client->http = httpConnect2("localhost", papplSystemGetPort(system), NULL, AF_UNSPEC, HTTP_ENCRYPTION_IF_REQUESTED, 1, 30000, NULL)) == NULL)
+      {
+        printf("FAIL (unable to connect: %s)\n", cupsLastErrorString());
+        pass = false;
+      }
+      else
+      {
+        httpSetField(client->http, HTTP_FIELD_ACCEPT_LANGUAGE, "de-DE;q=0.9, fr-CA;q=0.8, en");
+
+        if (papplClientGetLoc(client) != loc)
+        {
+          puts("FAIL (wrong catalog for Accept-Language)");
+          pass = false;
+        }
+        else
+        {
+          papplSystemRemoveResource(system, "/testpappl-fr.strings");
+          papplSystemAddStringsData(system, "/testpappl-fr.strings", "fr", "\"a\" = \"A-fr-2\";\n");
+
+          if (strcmp(papplLocGetString(client->loc, "a"), "A-fr"))
+          {
+            printf("FAIL (got '%s' from catalog in use, expected 'A-fr')\n", papplLocGetString(client->loc, "a"));
+            pass = false;
+          }
+          else if ((newloc = papplSystemFindLoc(system, "fr")) == NULL || newloc == loc || strcmp(papplLocGetString(newloc, "a"), "A-fr-2"))
+          {
+            puts("FAIL (strings not replaced)");
+            pass = false;
+          }
+          else
+          {
+            papplSystemRemoveResource(system, "/testpappl-fr.strings");
+
+            if (papplSystemFindLoc(system, "fr") != NULL)
+            {
+              puts("FAIL (strings not removed)");
+              pass = false;
+            }
+            else
+              puts("PASS");
+          }
+        }
+
+        _papplLocRelease(system, client->loc);
+        httpClose(client->http);
+      }
+
+      free(client);
+    }
+
+    papplSystemRemoveResource(system, "/testpappl-fr.strings");
+  }
+
   // papplSystemIteratePrinters
   fputs("api: papplSystemIteratePrinters: ", stdout);
 
@@ -1834,6 +3517,8 @@ test_api_printer(
 			set_contact;	// Contact for "set" call
   int			get_int,	// Integer for "get" call
 			set_int;	// Integer for "set" call
+  pappl_loglevel_t	get_loglevel,	// Log level for "get" call
+			set_loglevel;	// Log level for "set" call
   char			get_str[1024],	// Temporary string for "get" call
 			set_str[1024];	// Temporary string for "set" call
   static const char * const set_locations[10][2] =
@@ -1950,6 +3635,29 @@ test_api_printer(
   else
     puts("PASS");
 
+  // papplPrinterGet/SetLogLevel
+  fputs("api: papplPrinterGetLogLevel: ", stdout);
+  if ((get_loglevel = papplPrinterGetLogLevel(printer)) != PAPPL_LOGLEVEL_UNSPEC)
+  {
+    printf("FAIL (got %d, expected PAPPL_LOGLEVEL_UNSPEC)\n", get_loglevel);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  for (set_loglevel = PAPPL_LOGLEVEL_FATAL; set_loglevel >= PAPPL_LOGLEVEL_UNSPEC; set_loglevel --)
+  {
+    printf("api: papplPrinterSetLogLevel(%d): ", set_loglevel);
+    papplPrinterSetLogLevel(printer, set_loglevel);
+    if ((get_loglevel = papplPrinterGetLogLevel(printer)) != set_loglevel)
+    {
+      printf("FAIL (got %d, expected %d)\n", get_loglevel, set_loglevel);
+      pass = false;
+    }
+    else
+      puts("PASS");
+  }
+
   // papplPrinterGet/SetDNSSDName
   fputs("api: papplPrinterGetDNSSDName: ", stdout);
   if (!papplPrinterGetDNSSDName(printer, get_str, sizeof(get_str)))
@@ -2090,6 +3798,52 @@ test_api_printer(
   else
     puts("PASS");
 
+  // papplPrinterGet/SetDeviceIdleTime
+  fputs("api: papplPrinterGetDeviceIdleTime: ", stdout);
+  if ((get_int = papplPrinterGetDeviceIdleTime(printer)) != 0)
+  {
+    printf("FAIL (got %d, expected 0)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  set_int = (TESTRAND % 300) + 1;
+  printf("api: papplPrinterSetDeviceIdleTime(%d): ", set_int);
+  papplPrinterSetDeviceIdleTime(printer, set_int);
+  if ((get_int = papplPrinterGetDeviceIdleTime(printer)) != set_int)
+  {
+    printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  papplPrinterSetDeviceIdleTime(printer, 0);
+
+  // papplPrinterGet/SetStatusInterval
+  fputs("api: papplPrinterGetStatusInterval: ", stdout);
+  if ((get_int = papplPrinterGetStatusInterval(printer)) != 2)
+  {
+    printf("FAIL (got %d, expected 2)\n", get_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  set_int = (TESTRAND % 30) + 1;
+  printf("api: papplPrinterSetStatusInterval(%d): ", set_int);
+  papplPrinterSetStatusInterval(printer, set_int);
+  if ((get_int = papplPrinterGetStatusInterval(printer)) != set_int)
+  {
+    printf("FAIL (got %d, expected %d)\n", get_int, set_int);
+    pass = false;
+  }
+  else
+    puts("PASS");
+
+  papplPrinterSetStatusInterval(printer, 2);
+
   // papplPrinterGet/SetNextJobID
   fputs("api: papplPrinterGetNextJobID: ", stdout);
   if ((get_int = papplPrinterGetNextJobID(printer)) != 1)
@@ -2226,6 +3980,200 @@ test_api_printer_cb(
 }
 
 
+//
+// 'test_bench()' - Run benchmarks.
+//
+// Results are written to "testpappl-bench.csv" for regression tracking.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_bench(pappl_system_t *system)	// I - System
+{
+  bool		ret = false;		// Return value
+  http_t	*http = NULL;		// HTTP connection
+  cups_file_t	*csv;			// CSV results file
+  char		uri[1024],		// "printer-uri" value
+		filename[1024] = "";	// Print file
+  ipp_t		*request,		// IPP request
+		*supported = NULL;	// Supported attributes
+  int		i, j;			// Looping vars
+  int		fd;			// Raster file descriptor
+  cups_raster_t	*ras;			// Raster stream
+  cups_page_header2_t header;		// Raster page header
+  unsigned	lines = 0;		// Lines per raster job
+  int		requests,		// Total requests
+		errors;			// Total errors
+  double	latency[_PAPPL_BENCH_JOBS],
+					// Print-Job latencies
+		total;			// Total latency
+  pthread_t	tids[_PAPPL_MAX_BENCH_CLIENTS];
+					// Client threads
+  _pappl_benchclient_t clients[_PAPPL_MAX_BENCH_CLIENTS];
+					// Client data
+  static const ipp_op_t ops[] =		// Request benchmarks
+  {
+    IPP_OP_GET_PRINTER_ATTRIBUTES,
+    IPP_OP_GET_JOBS
+  };
+#ifdef HAVE_LIBJPEG
+  static const char * const jpeg_files[] =
+  {					// JPEG files to benchmark
+    "portrait-color.jpg",
+    "landscape-color.jpg"
+  };
+#endif // HAVE_LIBJPEG
+#ifdef HAVE_LIBPNG
+  static const char * const png_files[] =
+  {					// PNG files to benchmark
+    "portrait-color.png",
+    "landscape-color.png"
+  };
+#endif // HAVE_LIBPNG
+
+
+  if ((csv = cupsFileOpen("testpappl-bench.csv", "w")) == NULL)
+  {
+    printf("FAIL (Unable to create testpappl-bench.csv: %s)\n", strerror(errno));
+    return (false);
+  }
+
+  cupsFilePuts(csv, "metric,value,units\n");
+  cupsFilePrintf(csv, "clients,%d,clients\n", bench_clients);
+
+  // Measure the request rate with N concurrent clients...
+  for (i = 0; i < (int)(sizeof(ops) / sizeof(ops[0])); i ++)
+  {
+    printf("%s%s (%d clients) ", i ? "\nbench: " : "", ippOpString(ops[i]), bench_clients);
+    fflush(stdout);
+
+    for (j = 0, errors = 0; j < bench_clients; j ++)
+    {
+      clients[j].system   = system;
+      clients[j].op       = ops[i];
+      clients[j].end_time = bench_time() + _PAPPL_BENCH_SECONDS;
+      clients[j].requests = 0;
+      clients[j].errors   = 0;
+
+      if (pthread_create(tids + j, NULL, (void *(*)(void *))bench_client, clients + j))
+      {
+        errors ++;
+        break;
+      }
+    }
+
+    for (requests = 0; j > 0; j --)
+    {
+      pthread_join(tids[j - 1], NULL);
+
+      requests += clients[j - 1].requests;
+      errors   += clients[j - 1].errors;
+    }
+
+    if (errors)
+    {
+      printf("FAIL (%d errors)\n", errors);
+      goto done;
+    }
+
+    printf("%.1f requests/sec", (double)requests / _PAPPL_BENCH_SECONDS);
+
+    cupsFilePrintf(csv, "%s-requests-per-second,%.1f,requests/sec\n", ippOpString(ops[i]), (double)requests / _PAPPL_BENCH_SECONDS);
+  }
+
+  // Measure Print-Job latency for PWG raster through the driver...
+  if ((http = connect_to_printer(system, uri, sizeof(uri))) == NULL)
+  {
+    printf("FAIL (Unable to connect: %s)\n", cupsLastErrorString());
+    goto done;
+  }
+
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+
+  supported = cupsDoRequest(http, request, "/ipp/print");
+
+  if (cupsLastError() != IPP_STATUS_OK)
+  {
+    printf("FAIL (%s)\n", cupsLastErrorString());
+    goto done;
+  }
+
+  if (!make_raster_file(supported, false, filename, sizeof(filename)))
+    goto done;
+
+  // make_raster_file creates a single page...
+  if ((fd = open(filename, O_RDONLY)) >= 0)
+  {
+    if ((ras = cupsRasterOpen(fd, CUPS_RASTER_READ)) != NULL)
+    {
+      if (cupsRasterReadHeader2(ras, &header))
+        lines = header.cupsHeight;
+
+      cupsRasterClose(ras);
+    }
+
+    close(fd);
+  }
+
+  printf("\nbench: Print-Job (%d jobs) ", _PAPPL_BENCH_JOBS);
+  fflush(stdout);
+
+  for (i = 0, total = 0.0; i < _PAPPL_BENCH_JOBS; i ++)
+  {
+    if (!bench_print_job(http, uri, filename, "image/pwg-raster", latency + i))
+      goto done;
+
+    total += latency[i];
+  }
+
+  qsort(latency, _PAPPL_BENCH_JOBS, sizeof(double), (int (*)(const void *, const void *))compare_doubles);
+
+  // There aren't enough jobs for a 99th percentile, so report the maximum...
+  printf("p50=%.3fs p90=%.3fs max=%.3fs", latency[(_PAPPL_BENCH_JOBS - 1) / 2], latency[_PAPPL_BENCH_JOBS * 9 / 10 - 1], latency[_PAPPL_BENCH_JOBS - 1]);
+
+  cupsFilePrintf(csv, "Print-Job-latency-p50,%.4f,seconds\n", latency[(_PAPPL_BENCH_JOBS - 1) / 2]);
+  cupsFilePrintf(csv, "Print-Job-latency-p90,%.4f,seconds\n", latency[_PAPPL_BENCH_JOBS * 9 / 10 - 1]);
+  cupsFilePrintf(csv, "Print-Job-latency-max,%.4f,seconds\n", latency[_PAPPL_BENCH_JOBS - 1]);
+
+  // The raster line rate includes the (small) job submission overhead...
+  printf("\nbench: pwg-raster %.0f lines/sec", lines * _PAPPL_BENCH_JOBS / total);
+
+  cupsFilePrintf(csv, "pwg-raster-lines-per-second,%.0f,lines/sec\n", lines * _PAPPL_BENCH_JOBS / total);
+
+  // Measure the image filter throughput...
+#ifdef HAVE_LIBJPEG
+  if (!bench_files(http, uri, csv, "jpeg", "image/jpeg", (int)(sizeof(jpeg_files) / sizeof(jpeg_files[0])), jpeg_files))
+    goto done;
+#endif // HAVE_LIBJPEG
+
+#ifdef HAVE_LIBPNG
+  if (!bench_files(http, uri, csv, "png", "image/png", (int)(sizeof(png_files) / sizeof(png_files[0])), png_files))
+    goto done;
+#endif // HAVE_LIBPNG
+
+  // Measure the line compression throughput...
+  if (!bench_compress(csv))
+    goto done;
+
+  putchar(' ');
+
+  // If we get this far, all of the benchmarks ran...
+  ret = true;
+
+  done:
+
+  if (filename[0])
+    unlink(filename);
+
+  cupsFileClose(csv);
+  httpClose(http);
+  ippDelete(supported);
+
+  return (ret);
+}
+
+
 //
 // 'test_client()' - Run simulated client tests.
 //
@@ -2236,8 +4184,15 @@ test_client(pappl_system_t *system)	// I - System
   http_t	*http;			// HTTP connection
   char		uri[1024];		// "printer-uri" value
   ipp_t		*request,		// Request
-		*response;		// Response
+		*response,		// Response
+		*col;			// "media-col" filter
   int		i;			// Looping var
+  ipp_attribute_t *attr;		// "media-col-database" attribute
+  http_status_t	status;			// HTTP status
+  char		buffer[8192],		// Response buffer
+		*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  ssize_t	bytes;			// Bytes read
   static const char * const pattrs[] =	// Printer attributes
   {
     "printer-contact-col",
@@ -2399,8 +4354,138 @@ test_client(pappl_system_t *system)	// I - System
     ippDelete(response);
   }
 
+  // Test Get-Printer-Attributes with a "media-col-database" filter
+  fputs("\nclient: Get-Printer-Attributes(media-col-database) ", stdout);
+
+  request = ippNewRequest(IPP_OP_GET_PRINTER_ATTRIBUTES);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/ipp/print");
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+  ippAddString(request, IPP_TAG_OPERATION, IPP_CONST_TAG(IPP_TAG_KEYWORD), "requested-attributes", NULL, "media-col-database");
+  col = ippNew();
+  ippAddString(col, IPP_TAG_ZERO, IPP_CONST_TAG(IPP_TAG_KEYWORD), "media-size-name", NULL, "na_letter_8.5x11in");
+  ippAddCollection(request, IPP_TAG_OPERATION, "media-col", col);
+  ippDelete(col);
+
+  response = cupsDoRequest(http, request, "/ipp/print");
+
+  if (cupsLastError() != IPP_STATUS_OK)
+  {
+    printf("FAIL (%s)\n", cupsLastErrorString());
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+  else if ((attr = ippFindAttribute(response, "media-col-database", IPP_TAG_BEGIN_COLLECTION)) == NULL)
+  {
+    puts("FAIL (Missing 'media-col-database' attribute in response)");
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+  else
+  {
+    for (i = 0; i < ippGetCount(attr); i ++)
+    {
+      if (!ippContainsString(ippFindAttribute(ippGetCollection(attr, i), "media-size-name", IPP_TAG_ZERO), "na_letter_8.5x11in"))
+      {
+	printf("FAIL (Unfiltered 'media-col-database' value %d in response)\n", i + 1);
+	httpClose(http);
+	ippDelete(response);
+	return (false);
+      }
+    }
+
+    ippDelete(response);
+  }
+
+  // Test Create-Printer-Subscriptions and Get-Notifications on /ipp/print
+  fputs("\nclient: Create-Printer-Subscriptions ", stdout);
+
+  request = ippNewRequest(IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/ipp/print");
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+  ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-pull-method", NULL, "ippget");
+  ippAddString(request, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-events", NULL, "printer-config-changed");
+
+  response = cupsDoRequest(http, request, "/ipp/print");
+
+  if (cupsLastError() != IPP_STATUS_OK)
+  {
+    printf("FAIL (%s)\n", cupsLastErrorString());
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+  else if ((i = ippGetInteger(ippFindAttribute(response, "notify-subscription-id", IPP_TAG_INTEGER), 0)) <= 0)
+  {
+    puts("FAIL (Missing required 'notify-subscription-id' attribute in response)");
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+
+  ippDelete(response);
+
+  fputs("\nclient: Get-Notifications ", stdout);
+
+  request = ippNewRequest(IPP_OP_GET_NOTIFICATIONS);
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/ipp/print");
+  ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+  ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", i);
+
+  response = cupsDoRequest(http, request, "/ipp/print");
+
+  if (cupsLastError() != IPP_STATUS_OK)
+  {
+    printf("FAIL (%s)\n", cupsLastErrorString());
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+  else if (!ippFindAttribute(response, "notify-get-interval", IPP_TAG_INTEGER))
+  {
+    puts("FAIL (Missing required 'notify-get-interval' attribute in response)");
+    httpClose(http);
+    ippDelete(response);
+    return (false);
+  }
+
+  ippDelete(response);
+
+  // Test the /metrics page
+  fputs("\nclient: GET /metrics ", stdout);
+
+  httpClearFields(http);
+
+  if (httpGet(http, "/metrics"))
+  {
+    printf("FAIL (Unable to send GET request: %s)\n", cupsLastErrorString());
+    httpClose(http);
+    return (false);
+  }
+
+  while ((status = httpUpdate(http)) == HTTP_STATUS_CONTINUE);
+
+  if (status != HTTP_STATUS_OK)
+  {
+    printf("FAIL (%s)\n", httpStatus(status));
+    httpFlush(http);
+    httpClose(http);
+    return (false);
+  }
+
+  for (bufptr = buffer, bufend = buffer + sizeof(buffer) - 1; bufptr < bufend && (bytes = httpRead2(http, bufptr, (size_t)(bufend - bufptr))) > 0; bufptr += bytes);
+  *bufptr = '\0';
+
+  httpFlush(http);
   httpClose(http);
 
+  if (!strstr(buffer, "\npappl_clients "))
+  {
+    puts("FAIL (Missing 'pappl_clients' metric in response)");
+    return (false);
+  }
+
   return (true);
 }
 
@@ -2991,6 +5076,10 @@ usage(int status)			// I - Exit status
 {
   puts("Usage: testpappl [OPTIONS] [\"SERVER NAME\"]");
   puts("Options:");
+  puts("  --async-log            Write log messages from a background thread");
+  puts("  --bench                Run the benchmarks");
+  puts("  --bench-clients NUM    Set the number of benchmark clients (default 4)");
+  puts("  --event-loop           Use the client event loop");
   puts("  --help                 Show help");
   puts("  --list                 List devices");
   puts("  --list-TYPE            Lists devices of TYPE (dns-sd, local, network, usb)");
@@ -3016,6 +5105,7 @@ usage(int status)			// I - Exit status
   puts("  jpeg                 JPEG image tests");
   puts("  png                  PNG image tests");
   puts("  pwg-raster           PWG Raster tests");
+  puts("  bench                Benchmarks (not included in \"all\")");
 
   return (status);
 }